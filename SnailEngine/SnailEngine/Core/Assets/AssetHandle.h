@@ -0,0 +1,35 @@
+#pragma once
+#include <type_traits>
+
+#include "Core/DataStructures/SlotMap.h"
+
+namespace Snail
+{
+class Texture2D;
+class BaseMesh;
+
+// Typed handle into a GenericAssetManager.
+// The type is only a compile-time tag, it is checked once when the handle is created from an asset name.
+template <class T>
+struct AssetHandle : SlotHandle
+{
+    using AssetType = T;
+
+    constexpr AssetHandle() = default;
+    constexpr explicit AssetHandle(const SlotHandle handle)
+        : SlotHandle{handle}
+    {}
+    constexpr AssetHandle(const uint32_t index, const uint32_t generation)
+        : SlotHandle{index, generation}
+    {}
+    // A handle to a derived asset is a handle to its base, e.g. a MeshHandle from the handle of a CubeMesh
+    template <class U> requires std::is_base_of_v<T, U>
+    constexpr AssetHandle(const AssetHandle<U> handle)
+        : SlotHandle{handle}
+    {}
+};
+
+using TextureHandle = AssetHandle<Texture2D>;
+using MeshHandle = AssetHandle<BaseMesh>;
+
+}
@@ -0,0 +1,307 @@
+#include "stdafx.h"
+#include "AssetHotReload.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "Core/WindowsEngine.h"
+#include "Core/Memory/MemoryTracker.h"
+
+namespace Snail
+{
+
+size_t AssetKeyHash::operator()(const AssetKey& key) const noexcept
+{
+    return std::hash<std::string>{}(key.name) * 31 + static_cast<size_t>(key.kind);
+}
+
+void AssetDependencyGraph::Add(const std::filesystem::path& file, const AssetKey& key)
+{
+    std::vector<AssetKey>& dependents = fileDependents[FileWatcher::NormalizePath(file)];
+    if (std::ranges::find(dependents, key) == dependents.end())
+        dependents.push_back(key);
+}
+
+void AssetDependencyGraph::AddDirectory(const std::filesystem::path& directory, const AssetKey& key)
+{
+    std::string prefix = FileWatcher::NormalizePath(directory);
+    if (!prefix.ends_with('/'))
+        prefix += '/';
+    directoryDependents.emplace_back(std::move(prefix), key);
+}
+
+void AssetDependencyGraph::Clear()
+{
+    fileDependents.clear();
+    directoryDependents.clear();
+}
+
+std::vector<AssetKey> AssetDependencyGraph::GetDependents(const std::span<const std::string> files) const
+{
+    std::vector<AssetKey> dependents;
+    const auto addDependent = [&dependents](const AssetKey& key)
+    {
+        if (std::ranges::find(dependents, key) == dependents.end())
+            dependents.push_back(key);
+    };
+
+    for (const std::string& file : files)
+    {
+        if (const auto it = fileDependents.find(file); it != fileDependents.end())
+            std::ranges::for_each(it->second, addDependent);
+
+        for (const auto& [directory, key] : directoryDependents)
+        {
+            if (file.starts_with(directory))
+                addDependent(key);
+        }
+    }
+    return dependents;
+}
+
+void AssetHotReload::Init()
+{
+    watcher->Watch(RESOURCES_DIRECTORY);
+    watcher->Watch(SHADERS_DIRECTORY);
+}
+
+void AssetHotReload::Update(const float dt)
+{
+    static ThreadPool& jobPool = WindowsEngine::GetModule<ThreadPool>();
+
+    if (!isEnabled)
+        return;
+
+    ApplyFinishedReloads();
+
+    if (scanJob && scanJob->isDone)
+    {
+        ++stats.scans;
+        stats.lastScanMs = scanJob->durationMs;
+        stats.watchedFiles = scanJob->fileCount;
+        const std::vector<std::string> changedFiles = std::move(scanJob->changedFiles);
+        scanJob.reset();
+
+        if (!changedFiles.empty())
+        {
+            stats.changedFiles += changedFiles.size();
+
+            // The cached assets change with every scene, the graph is only worth building when files changed
+            BuildGraph();
+            for (const AssetKey& key : graph.GetDependents(changedFiles))
+                StartReload(key);
+        }
+    }
+
+    timeSinceScan += dt;
+    if (!scanJob && timeSinceScan >= SCAN_INTERVAL)
+    {
+        timeSinceScan = 0;
+        scanJob = std::make_shared<ScanJob>();
+        jobPool.AddTask([job = scanJob, fileWatcher = watcher]
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            job->changedFiles = fileWatcher->Scan();
+            job->fileCount = fileWatcher->GetFileCount();
+            job->durationMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            job->isDone = true;
+        });
+    }
+}
+
+void AssetHotReload::BuildGraph()
+{
+    static TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
+    static MeshManager& meshManager = WindowsEngine::GetModule<MeshManager>();
+    static PhysicsModule& physicsModule = WindowsEngine::GetModule<PhysicsModule>();
+
+    graph.Clear();
+
+    // Texture names are their files, the generated ones never change on disk
+    for (std::string& name : textureManager.GetAssetNames())
+        graph.Add(name, {AssetKind::TEXTURE, std::move(name)});
+
+    for (const auto& [meshName, files] : meshManager.GetImportFiles())
+    {
+        for (const std::string& file : files)
+            graph.Add(file, {AssetKind::MESH, meshName});
+    }
+
+    for (const std::string& directory : physicsModule.vehicles.GetModelDirectories())
+    {
+        graph.Add(std::filesystem::path{directory} / DefaultVehicleBaseParamsFile, {AssetKind::VEHICLE_MODEL, directory});
+        graph.Add(std::filesystem::path{directory} / DefaultVehicleEngineDriveParams, {AssetKind::VEHICLE_MODEL, directory});
+    }
+
+    graph.AddDirectory(SHADERS_DIRECTORY, {AssetKind::SHADERS, {}});
+}
+
+void AssetHotReload::StartReload(const AssetKey& key)
+{
+    static ThreadPool& jobPool = WindowsEngine::GetModule<ThreadPool>();
+
+    // Its files are read again once the import in flight is swapped in
+    if (std::ranges::any_of(reloadJobs, [&key](const auto& job) { return job->key == key; }))
+    {
+        staleKeys.insert(key);
+        return;
+    }
+
+    auto job = std::make_shared<ReloadJob>();
+    job->key = key;
+    reloadJobs.push_back(job);
+
+    // Compiling needs the immediate context, nothing to prepare on a worker
+    if (key.kind == AssetKind::SHADERS)
+    {
+        job->apply = []
+        {
+            WindowsEngine::GetModule<RendererModule>().ReloadShaders();
+            return true;
+        };
+        job->isDone = true;
+        return;
+    }
+
+    jobPool.AddTask([job]
+    {
+        MemoryTagScope tag{MemoryTag::ASSETS};
+        try
+        {
+            job->apply = PrepareReload(job->key);
+        }
+        catch (const std::exception& e)
+        {
+            LOGF(Logger::WARN, "Could not reload {}: {}", GetDescription(job->key), e.what());
+            job->apply = [] { return false; };
+        }
+        job->isDone = true;
+    });
+}
+
+std::function<bool()> AssetHotReload::PrepareReload(const AssetKey& key)
+{
+    static TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
+    static MeshManager& meshManager = WindowsEngine::GetModule<MeshManager>();
+    static PhysicsModule& physicsModule = WindowsEngine::GetModule<PhysicsModule>();
+
+    switch (key.kind)
+    {
+    case AssetKind::TEXTURE:
+        return textureManager.PrepareReload(key.name);
+    case AssetKind::MESH:
+        return meshManager.PrepareReload(key.name);
+    case AssetKind::VEHICLE_MODEL:
+    {
+        std::shared_ptr<const VehicleModel> model = physicsModule.vehicles.ParseModel(key.name);
+        if (!model)
+            return [] { return false; };
+
+        return [model, directory = key.name]
+        {
+            PhysxWriteLock lock;
+            return physicsModule.vehicles.ReplaceModel(directory, *model);
+        };
+    }
+    case AssetKind::SHADERS:
+        break;
+    }
+    return {};
+}
+
+void AssetHotReload::ApplyFinishedReloads()
+{
+    static RendererModule& renderer = WindowsEngine::GetModule<RendererModule>();
+
+    bool hasFlushed = false;
+    std::erase_if(reloadJobs, [this, &hasFlushed](const std::shared_ptr<ReloadJob>& job)
+    {
+        if (!job->isDone)
+            return false;
+
+        // Evicted or replaced by a scene meanwhile
+        if (!job->apply)
+            return true;
+
+        // The view being prepared can point at the buffers and occluders being swapped
+        if (!hasFlushed)
+        {
+            renderer.FlushRenderPrep();
+            hasFlushed = true;
+        }
+
+        bool isReloaded = false;
+        try
+        {
+            isReloaded = job->apply();
+        }
+        catch (const std::exception& e)
+        {
+            LOGF(Logger::WARN, "Could not reload {}: {}", GetDescription(job->key), e.what());
+        }
+
+        const std::string description = GetDescription(job->key);
+        if (isReloaded)
+        {
+            ++stats.reloads;
+            LOGF("Reloaded {}", description);
+        }
+        else
+        {
+            ++stats.failures;
+            LOGF(Logger::WARN, "Kept the previous version of {}", description);
+        }
+
+        recentReloads.push_front(std::format("{} {}", isReloaded ? "Reloaded" : "Failed", description));
+        if (recentReloads.size() > RECENT_RELOAD_COUNT)
+            recentReloads.pop_back();
+        return true;
+    });
+
+    for (auto it = staleKeys.begin(); it != staleKeys.end();)
+    {
+        if (std::ranges::none_of(reloadJobs, [&it](const auto& job) { return job->key == *it; }))
+        {
+            StartReload(*it);
+            it = staleKeys.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+std::string AssetHotReload::GetDescription(const AssetKey& key)
+{
+    switch (key.kind)
+    {
+    case AssetKind::TEXTURE:
+        return std::format("texture \"{}\"", key.name);
+    case AssetKind::MESH:
+        return std::format("mesh \"{}\"", key.name);
+    case AssetKind::VEHICLE_MODEL:
+        return std::format("vehicle model \"{}\"", key.name);
+    case AssetKind::SHADERS:
+        break;
+    }
+    return "shaders";
+}
+
+void AssetHotReload::RenderImGui()
+{
+#ifdef _IMGUI_
+    if (ImGui::CollapsingHeader("Asset Hot Reload"))
+    {
+        ImGui::Checkbox("Reload changed assets", &isEnabled);
+        ImGui::Text("Watched files: %zu, last scan: %.2f ms", stats.watchedFiles, stats.lastScanMs);
+        ImGui::Text("Scans: %llu, changed files: %llu", stats.scans, stats.changedFiles);
+        ImGui::Text("Reloads: %llu, failures: %llu, in flight: %zu", stats.reloads, stats.failures, reloadJobs.size());
+
+        for (const std::string& reload : recentReloads)
+            ImGui::BulletText("%s", reload.c_str());
+    }
+#endif
+}
+
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "FileWatcher.h"
+
+namespace Snail
+{
+
+enum class AssetKind : uint8_t
+{
+    TEXTURE,
+    MESH,
+    VEHICLE_MODEL,
+    // Every shader at once, their includes make a per file mapping guesswork
+    SHADERS,
+};
+
+struct AssetKey
+{
+    AssetKind kind = AssetKind::TEXTURE;
+    // Name of the asset for its manager, empty for the shaders
+    std::string name;
+
+    bool operator==(const AssetKey&) const = default;
+};
+
+struct AssetKeyHash
+{
+    size_t operator()(const AssetKey& key) const noexcept;
+};
+
+// Which assets are built from which files, the paths are normalized by FileWatcher::NormalizePath
+class AssetDependencyGraph
+{
+    std::unordered_map<std::string, std::vector<AssetKey>> fileDependents;
+    // Directory with a trailing separator
+    std::vector<std::pair<std::string, AssetKey>> directoryDependents;
+
+public:
+    void Add(const std::filesystem::path& file, const AssetKey& key);
+    // Every file under the directory, recursively
+    void AddDirectory(const std::filesystem::path& directory, const AssetKey& key);
+    void Clear();
+
+    // Assets built from any of the files, each once, in the order of the files
+    std::vector<AssetKey> GetDependents(std::span<const std::string> files) const;
+    size_t GetFileCount() const noexcept { return fileDependents.size(); }
+};
+
+// Reloads the assets whose files changed while the game runs, without loading the scene again. The resource and
+// shader directories are scanned on the job system, the changed files are mapped to the textures, meshes and vehicle
+// models built from them, and only those are imported again, on the job system too. The new content is then swapped
+// into the cached assets on the main thread, so every pointer and handle to them stays valid.
+class AssetHotReload
+{
+public:
+    static constexpr const char* RESOURCES_DIRECTORY = "Resources";
+    static constexpr const char* SHADERS_DIRECTORY = "SnailEngine/Shaders";
+    static constexpr float SCAN_INTERVAL = 0.5f;
+    static constexpr size_t RECENT_RELOAD_COUNT = 8;
+
+    struct Stats
+    {
+        uint64_t scans = 0;
+        uint64_t changedFiles = 0;
+        uint64_t reloads = 0;
+        uint64_t failures = 0;
+        size_t watchedFiles = 0;
+        float lastScanMs = 0;
+    };
+
+private:
+    struct ScanJob
+    {
+        std::vector<std::string> changedFiles;
+        size_t fileCount = 0;
+        float durationMs = 0;
+        // Set last by the worker
+        std::atomic<bool> isDone = false;
+    };
+
+    struct ReloadJob
+    {
+        AssetKey key;
+        // Built by the worker and run on the main thread, returns whether the asset was swapped.
+        // Empty when the asset can't be reloaded anymore.
+        std::function<bool()> apply;
+        std::atomic<bool> isDone = false;
+    };
+
+    // Shared with the scan in flight, which outlives the module on exit
+    std::shared_ptr<FileWatcher> watcher = std::make_shared<FileWatcher>();
+    std::shared_ptr<ScanJob> scanJob;
+    std::vector<std::shared_ptr<ReloadJob>> reloadJobs;
+    // Changed again while being reloaded, reloaded once more after that
+    std::unordered_set<AssetKey, AssetKeyHash> staleKeys;
+
+    AssetDependencyGraph graph;
+    float timeSinceScan = 0;
+    Stats stats;
+    std::deque<std::string> recentReloads;
+
+#ifdef _IMGUI_
+    bool isEnabled = true;
+#else
+    // Shipped builds don't have their files edited
+    bool isEnabled = false;
+#endif
+
+    void BuildGraph();
+    void StartReload(const AssetKey& key);
+    void ApplyFinishedReloads();
+
+    static std::function<bool()> PrepareReload(const AssetKey& key);
+    static std::string GetDescription(const AssetKey& key);
+
+public:
+    void Init();
+    // On the main thread, not while a scene is loading
+    void Update(float dt);
+
+    bool IsEnabled() const noexcept { return isEnabled; }
+    const Stats& GetStats() const noexcept { return stats; }
+
+    void RenderImGui();
+};
+
+}
@@ -0,0 +1,69 @@
+#include "stdafx.h"
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <cctype>
+#include <unordered_set>
+
+namespace Snail
+{
+
+void FileWatcher::Watch(const std::filesystem::path& root)
+{
+    roots.push_back(root);
+}
+
+std::vector<std::string> FileWatcher::Scan()
+{
+    std::vector<std::string> changedFiles;
+    std::unordered_set<std::string> seen;
+    seen.reserve(stamps.size());
+
+    for (const std::filesystem::path& root : roots)
+    {
+        std::error_code error;
+        if (!std::filesystem::is_directory(root, error))
+            continue;
+
+        // Files being written can vanish or be locked mid scan, they are picked up by the next one
+        for (auto it = std::filesystem::recursive_directory_iterator(root, std::filesystem::directory_options::skip_permission_denied, error);
+             !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+        {
+            if (!it->is_regular_file(error))
+                continue;
+
+            const FileStamp stamp{it->last_write_time(error), it->file_size(error)};
+            if (error)
+            {
+                error.clear();
+                continue;
+            }
+
+            std::string path = NormalizePath(it->path());
+            const auto [stampIt, inserted] = stamps.try_emplace(path, stamp);
+            if (inserted || stampIt->second.writeTime != stamp.writeTime || stampIt->second.size != stamp.size)
+            {
+                stampIt->second = stamp;
+                if (hasScanned)
+                    changedFiles.push_back(path);
+            }
+            seen.insert(std::move(path));
+        }
+    }
+
+    // Removed files are forgotten, their assets keep what they last loaded
+    std::erase_if(stamps, [&seen](const auto& entry) { return !seen.contains(entry.first); });
+
+    hasScanned = true;
+    std::ranges::sort(changedFiles);
+    return changedFiles;
+}
+
+std::string FileWatcher::NormalizePath(const std::filesystem::path& path)
+{
+    std::string normalized = path.lexically_normal().generic_string();
+    std::ranges::transform(normalized, normalized.begin(), [](const char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+    return normalized;
+}
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Snail
+{
+
+// Finds the files written under a set of directories by comparing their write times and sizes between scans.
+// Polling keeps it working on any file system and lets a scan run on a worker, without an OS notification thread.
+class FileWatcher
+{
+    struct FileStamp
+    {
+        std::filesystem::file_time_type writeTime;
+        uintmax_t size = 0;
+    };
+
+    std::vector<std::filesystem::path> roots;
+    std::unordered_map<std::string, FileStamp> stamps;
+    bool hasScanned = false;
+
+public:
+    // Every file under it, recursively, missing directories are watched once they exist
+    void Watch(const std::filesystem::path& root);
+
+    // Files created or modified since the last scan, as normalized paths. The first scan only records the files.
+    // Not thread safe, one scan at a time.
+    std::vector<std::string> Scan();
+
+    size_t GetFileCount() const noexcept { return stamps.size(); }
+
+    // Generic separators, no dot segments, lower case since the asset names and the files written by the editors
+    // don't agree on the case on Windows
+    static std::string NormalizePath(const std::filesystem::path& path);
+};
+
+}
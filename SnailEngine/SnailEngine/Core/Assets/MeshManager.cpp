@@ -1,15 +1,21 @@
 #include "stdafx.h"
 #include "MeshManager.h"
 
+#include <fstream>
 #include <rapidobj.hpp>
 #include <memory>
+#include <sstream>
 
 #include "Core/WindowsEngine.h"
+#include "Core/Mesh/BillboardMesh.h"
 #include "Core/Mesh/CubeMapMesh.h"
 #include "Core/Mesh/CubeMesh.h"
+#include "Core/Mesh/MeshSimplifier.h"
 #include "Core/Mesh/QuadMesh.h"
 #include "Core/Mesh/SphereMesh.h"
 #include "Core/Mesh/TerrainMesh.h"
+#include "Rendering/VertexCompression.h"
+#include "Util/RapidObjUtil.h"
 
 namespace Snail
 {
@@ -28,11 +34,306 @@ void MeshManager::Init()
     SaveAsset<SphereMesh>("SphereBig", std::make_unique<SphereMesh>(50, 50), true);
 }
 
+// Material libraries named by an OBJ, they come before its geometry
+static std::vector<std::string> FindMaterialLibraries(const std::string& filename)
+{
+    const std::filesystem::path directory = std::filesystem::path{filename}.parent_path();
+
+    std::vector<std::string> libraries;
+    std::ifstream file{filename};
+    for (std::string line; std::getline(file, line);)
+    {
+        if (line.starts_with("v "))
+            break;
+
+        if (line.starts_with("mtllib "))
+        {
+            std::istringstream names{line.substr(7)};
+            for (std::string name; names >> name;)
+                libraries.push_back((directory / name).generic_string());
+        }
+    }
+    return libraries;
+}
+
+bool MeshManager::LoadObj(const std::string& filename, const bool isPersistent, ObjGeometry& geometry, std::vector<DeferredMaterial>* deferredMaterials)
+{
+    std::string pathPrefix{};
+
+    // Check if the last slash was found
+    if (const size_t lastSlashPos = filename.find_last_of('/'); lastSlashPos != std::string::npos)
+    {
+        // Extract the substring from the beginning of the string up to the last '/'
+        pathPrefix = filename.substr(0, lastSlashPos) + "/";
+    }
+
+    if (!std::filesystem::exists(filename))
+    {
+        LOG(Logger::FATAL, "Load error: terrain mesh file not found: ", filename);
+        return false;
+    }
+
+    rapidobj::Result result = rapidobj::ParseFile(filename);
+
+    if (result.error)
+    {
+        LOG(Logger::FATAL, "Rapidobj: ", result.error.code.message());
+        return false;
+    }
+
+    if (!Triangulate(result))
+    {
+        LOG(Logger::ERROR, "Rapidobj: failed triangulation");
+    }
+
+    static constexpr auto hash = [](const rapidobj::Index& index) -> size_t
+        {
+            size_t h1 = std::hash<int>()(index.position_index);
+            size_t h2 = std::hash<int>()(index.normal_index);
+            size_t h3 = std::hash<double>()(index.texcoord_index);
+            return h1 ^ h2 << 1 ^ h3;
+        };
+
+    auto comp = [](const rapidobj::Index& a, const rapidobj::Index& b) -> bool
+        {
+            return a.position_index == b.position_index && a.normal_index == b.normal_index && a.texcoord_index == b.texcoord_index;
+        };
+
+    std::unordered_map<rapidobj::Index, uint32_t, decltype(hash), decltype(comp)> vertsIndex;
+
+    // Process each shape
+    for (const rapidobj::Shape& shape : result.shapes)
+    {
+        // Assuming that one shape = one material
+        SubMesh subMesh{};
+
+        subMesh.indexBufferStartIndex = static_cast<uint32_t>(geometry.indexes.size());
+        // Create material from rapidobj material
+
+        const int materialIndex = shape.mesh.material_ids[0];
+        if (deferredMaterials)
+        {
+            // Copied since the parse result is gone by the time the material is resolved
+            if (materialIndex != -1)
+            {
+                deferredMaterials->emplace_back([material = result.materials[materialIndex], pathPrefix, isPersistent]
+                {
+                    return ConvertRapidObjMatToTexturedMaterial(material, pathPrefix, isPersistent);
+                });
+            }
+            else
+            {
+                deferredMaterials->emplace_back();
+            }
+        }
+        else if (materialIndex != -1)
+        {
+            subMesh.SetMaterial(ConvertRapidObjMatToTexturedMaterial(result.materials[materialIndex], pathPrefix, isPersistent));
+        }
+
+        // Iterate through the faces of the shape
+        for (size_t i = 0; i < shape.mesh.indices.size(); i += 3)
+        {
+            // Iterate through the vertices of the face
+            // Use this loop for right handed winding:
+            // for (int j = 0; j < 3; ++j)
+            //
+            // Use this one for left handed winding:
+            for (int j = 2; j >= 0; --j)
+            {
+                const auto& indexes = shape.mesh.indices[i + j];
+                const auto& [positionIndex, texcoordIndex, normalIndex] = indexes;
+
+                Vector3 position = {
+                result.attributes.positions[positionIndex * 3], result.attributes.positions[positionIndex * 3 + 1],
+                result.attributes.positions[positionIndex * 3 + 2]
+                };
+
+
+                Vector3 normal{};
+                if (normalIndex != -1)
+                    normal = Vector3{
+                        result.attributes.normals[normalIndex * 3], result.attributes.normals[normalIndex * 3 + 1],
+                        result.attributes.normals[normalIndex * 3 + 2]
+                };
+
+                Vector2 uv{};
+                if (texcoordIndex != -1)
+                    uv = Vector2{
+                        result.attributes.texcoords[texcoordIndex * 2],
+                        result.attributes.texcoords[texcoordIndex * 2 + 1]
+                };
+
+                MeshVertex vertex{ position, normal, uv };
+
+                // To convert right handed vertexes as left handed
+                vertex.SwitchHandRule();
+
+                auto index = static_cast<uint32_t>(geometry.vertices.size());
+                // Only duplicate vertex when the combo vertex normal and uv doesnt already exists.
+                // This optimizes mesh verticies while still keeping uvs correctly
+                if (vertsIndex.contains(indexes))
+                {
+                    index = vertsIndex[indexes];
+                }
+                else
+                {
+                    geometry.vertices.push_back(vertex);
+                    vertsIndex[indexes] = index;
+                }
+                subMesh.indexBufferCount++;
+                geometry.indexes.push_back(index);
+            }
+        }
+        geometry.submeshes.push_back(subMesh);
+    }
+
+    return true;
+}
+
+BaseMesh* MeshManager::ImportMesh(const std::string& meshName, const std::string& filename, const bool isPersistent, const VertexFormat vertexFormat)
+{
+    std::unique_ptr<BaseMesh> mesh = BuildObjMesh(meshName, filename, isPersistent, vertexFormat, nullptr);
+    if (!mesh)
+        return nullptr;
+
+    {
+        std::lock_guard _{ assetManagerMutex };
+        importSources[meshName] = {filename, FindMaterialLibraries(filename), vertexFormat, isPersistent};
+    }
+
+    return SaveAsset(meshName, std::move(mesh), isPersistent);
+}
+
+std::unique_ptr<BaseMesh> MeshManager::BuildObjMesh(const std::string& meshName, const std::string& filename, const bool isPersistent, const VertexFormat vertexFormat, std::vector<DeferredMaterial>* deferredMaterials)
+{
+    ObjGeometry geometry;
+    if (!LoadObj(filename, isPersistent, geometry, deferredMaterials))
+        return nullptr;
+
+    const MeshOptimizer::Stats stats = MeshOptimizer::Optimize(geometry.vertices, geometry.indexes, geometry.submeshes);
+    LOGF("Optimized mesh \"{}\": ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, index bytes {} -> {}",
+        meshName,
+        stats.before.acmr,
+        stats.after.acmr,
+        stats.before.atvr,
+        stats.after.atvr,
+        stats.indexBytesBefore,
+        stats.indexBytesAfter);
+
+    // After the fetch optimization, since the LODs index the final vertices
+    const MeshSimplifier::LodStats lodStats = MeshSimplifier::BuildLods(geometry.vertices, geometry.indexes, geometry.submeshes);
+    LOGF("Built {} LODs for mesh \"{}\": {} / {} / {} / {} triangles",
+        lodStats.lodCount,
+        meshName,
+        lodStats.triangleCounts[0],
+        lodStats.triangleCounts[1],
+        lodStats.triangleCounts[2],
+        lodStats.triangleCounts[3]);
+
+    std::unique_ptr<BaseMesh> mesh;
+    if (MeshOptimizer::FitsIn16BitIndices(geometry.vertices.size()))
+        mesh = CreateMesh<Mesh<uint16_t>>(std::move(geometry));
+    else
+        mesh = CreateMesh<Mesh<uint32_t>>(std::move(geometry));
+    mesh->optimizationStats = stats;
+    mesh->SetVertexFormat(vertexFormat);
+    mesh->lodCount = lodStats.lodCount;
+    mesh->lodErrors = lodStats.errors;
+    return mesh;
+}
+
+std::unordered_map<std::string, std::vector<std::string>> MeshManager::GetImportFiles()
+{
+    std::lock_guard _{ assetManagerMutex };
+    std::unordered_map<std::string, std::vector<std::string>> files;
+    for (const auto& [meshName, source] : importSources)
+    {
+        // Sources of evicted meshes are kept in case they are imported again
+        if (!assetCache.contains(meshName))
+            continue;
+
+        std::vector<std::string>& meshFiles = files[meshName];
+        meshFiles.push_back(source.filename);
+        meshFiles.insert(meshFiles.end(), source.materialLibraries.begin(), source.materialLibraries.end());
+    }
+    return files;
+}
+
+std::function<bool()> MeshManager::PrepareReload(const std::string& meshName)
+{
+    ImportSource source;
+    {
+        std::lock_guard _{ assetManagerMutex };
+        const auto it = importSources.find(meshName);
+        if (it == importSources.end() || !assetCache.contains(meshName))
+            return {};
+        source = it->second;
+    }
+
+    auto materials = std::make_shared<std::vector<DeferredMaterial>>();
+    std::shared_ptr<BaseMesh> mesh = BuildObjMesh(meshName, source.filename, source.isPersistent, source.vertexFormat, materials.get());
+    if (!mesh)
+        return [] { return false; };
+
+    // Buffers and shaders are created off the main thread like on the loading thread, the textures can't be
+    mesh->name = meshName;
+    mesh->Init();
+
+    return [this, meshName, mesh, materials, libraries = FindMaterialLibraries(source.filename)]
+    {
+        for (size_t i = 0; i < materials->size(); ++i)
+        {
+            if (const DeferredMaterial& material = (*materials)[i])
+                mesh->submeshes[i].SetMaterial(material());
+        }
+
+        if (!SwapAsset(meshName, *mesh))
+        {
+            LOGF(Logger::WARN, "Mesh \"{}\" can't be reloaded in place since its index type changed, load the scene again to see it", meshName);
+            return false;
+        }
+
+        std::lock_guard _{ assetManagerMutex };
+        importSources[meshName].materialLibraries = libraries;
+        return true;
+    };
+}
+
+bool MeshManager::SwapContent(BaseMesh& current, BaseMesh& reloaded)
+{
+    return current.SwapGeometry(reloaded);
+}
+
+MeshManager::VertexMemory MeshManager::GetVertexMemory() const
+{
+    VertexMemory memory;
+    ForEachAsset([&memory](const BaseMesh* mesh)
+    {
+        memory.bufferBytes += mesh->GetVertexCount() * VertexCompression::GetStride(mesh->GetVertexFormat());
+        memory.fullBytes += mesh->GetVertexCount() * sizeof(MeshVertex);
+    });
+    return memory;
+}
+
+void MeshManager::LogVertexMemory() const
+{
+    const VertexMemory memory = GetVertexMemory();
+    LOGF("Vertex buffers: {:.1f} KB, {:.1f} KB saved by the compact vertex formats",
+        memory.bufferBytes / 1024.0,
+        (memory.fullBytes - memory.bufferBytes) / 1024.0);
+}
+
 void MeshManager::RenderImGui()
 {
 #ifdef _IMGUI_
     if (ImGui::CollapsingHeader("Meshes"))
     {
+        RenderResidencyImGui();
+
+        const VertexMemory vertexMemory = GetVertexMemory();
+        ImGui::Text("Vertex buffers: %.1f KB (%.1f KB as full vertices)", vertexMemory.bufferBytes / 1024.0, vertexMemory.fullBytes / 1024.0);
+
         for (auto& [meshName, mesh] : assetCache)
         {
             if (ImGui::TreeNode(meshName.c_str()))
@@ -46,4 +347,29 @@ void MeshManager::RenderImGui()
 #endif
 }
 
+AssetMemoryUsage MeshManager::ComputeMemoryUsage(const BaseMesh& mesh) const
+{
+    return mesh.GetMemoryUsage();
+}
+
+void MeshManager::CollectUsedTextures(std::unordered_set<const Texture*>& textures)
+{
+    static TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
+
+    std::lock_guard _{ assetManagerMutex };
+    for (const AssetCacheEntry& entry : assetCache | std::views::values)
+    {
+        for (const SubMesh& submesh : entry.asset->submeshes)
+        {
+            for (const auto member : MATERIAL_TEXTURE_MEMBERS)
+                textures.insert(textureManager.GetAsset(submesh.GetMaterial().*member));
+        }
+
+        if (const auto* billboardMesh = dynamic_cast<const BillboardMesh*>(entry.asset.get()))
+            textures.insert(billboardMesh->quadTexture);
+        else if (const auto* cubeMapMesh = dynamic_cast<const CubeMapMesh*>(entry.asset.get()))
+            textures.insert(cubeMapMesh->cubeMapTexture);
+    }
+}
+
 }
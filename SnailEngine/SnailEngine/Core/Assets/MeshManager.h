@@ -1,12 +1,9 @@
 #pragma once
+#include <functional>
 #include <string>
 
-#include "rapidobj.hpp"
-
 #include "ModuleManager.h"
 #include "Core/Mesh/Mesh.h"
-#include "Util/RapidObjUtil.h"
-
 
 namespace Snail
 {
@@ -18,6 +15,39 @@ class MeshManager : public GenericAssetManager<BaseMesh>
         LOGF(Logger::FATAL, "Saved base mesh \"{}\" to cache which is not allowed", filename);
         return nullptr;
     }
+
+    AssetMemoryUsage ComputeMemoryUsage(const BaseMesh& mesh) const override;
+    bool SwapContent(BaseMesh& current, BaseMesh& reloaded) override;
+
+    // OBJ shapes as submeshes, one material each, with 32 bit indices until the index type is picked
+    struct ObjGeometry
+    {
+        std::vector<MeshVertex> vertices;
+        std::vector<uint32_t> indexes;
+        std::vector<SubMesh> submeshes;
+    };
+
+    // Material of a submesh, resolved on the main thread when its textures can't be loaded where the mesh is built
+    using DeferredMaterial = std::function<TexturedMaterial()>;
+
+    // What an imported mesh is built again from when one of its files changes
+    struct ImportSource
+    {
+        std::string filename;
+        std::vector<std::string> materialLibraries;
+        VertexFormat vertexFormat = VertexFormat::COMPACT;
+        bool isPersistent = false;
+    };
+
+    std::unordered_map<std::string, ImportSource> importSources;
+
+    // Fills deferredMaterials with one material per submesh instead of setting them, when given
+    static bool LoadObj(const std::string& filename, bool isPersistent, ObjGeometry& geometry, std::vector<DeferredMaterial>* deferredMaterials = nullptr);
+    template<class T> requires std::is_base_of_v<BaseMesh, T>
+    static std::unique_ptr<T> CreateMesh(ObjGeometry&& geometry);
+    // Loads, optimizes and builds the LODs of an OBJ prop, with the index type its vertices allow
+    static std::unique_ptr<BaseMesh> BuildObjMesh(const std::string& meshName, const std::string& filename, bool isPersistent, VertexFormat vertexFormat, std::vector<DeferredMaterial>* deferredMaterials);
+
 public:
     void Init() override;
 
@@ -26,7 +56,30 @@ public:
 
     template<class T> requires std::is_base_of_v<BaseMesh, T>
     T* SaveAsset(const std::string& meshName, std::unique_ptr<T>&& mesh, bool isPersistent = false);
-    
+
+    // Loads an OBJ prop and optimizes it for the GPU, it gets 16 bit indices when its vertices allow it.
+    // Meshes whose vertex order matters, like terrains, must go through SaveAsset instead.
+    BaseMesh* ImportMesh(const std::string& meshName, const std::string& filename, bool isPersistent = false, VertexFormat vertexFormat = VertexFormat::COMPACT);
+
+    // Files each cached imported mesh was built from, its OBJ and material libraries
+    std::unordered_map<std::string, std::vector<std::string>> GetImportFiles();
+    // Imports a cached mesh again from its files, from any thread. The returned function swaps the new geometry in
+    // place on the main thread and returns false if it could not, it is empty when the mesh wasn't imported.
+    std::function<bool()> PrepareReload(const std::string& meshName);
+
+    struct VertexMemory
+    {
+        size_t bufferBytes = 0;
+        // What the same vertices take as full MeshVertex
+        size_t fullBytes = 0;
+    };
+
+    // Vertex buffers of the resident meshes
+    [[nodiscard]] VertexMemory GetVertexMemory() const;
+    void LogVertexMemory() const;
+
+    // Textures referenced by resident meshes, which must not be evicted while those meshes are cached
+    void CollectUsedTextures(std::unordered_set<const Texture*>& textures);
 
     void RenderImGui() override;
 };
@@ -35,127 +88,27 @@ public:
 template <class T> requires std::is_base_of_v<BaseMesh, T>
 T* MeshManager::SaveAsset(const std::string& meshName, const std::string& filename, bool isPersistent)
 {
-    std::string pathPrefix{};
-
-    // Check if the last slash was found
-    if (const size_t lastSlashPos = filename.find_last_of('/'); lastSlashPos != std::string::npos)
-    {
-        // Extract the substring from the beginning of the string up to the last '/'
-        pathPrefix = filename.substr(0, lastSlashPos) + "/";
-    }
-
-    if (!std::filesystem::exists(filename))
-    {
-        LOG(Logger::FATAL, "Load error: terrain mesh file not found: ", filename);
+    ObjGeometry geometry;
+    if (!LoadObj(filename, isPersistent, geometry))
         return nullptr;
-    }
 
-    rapidobj::Result result = rapidobj::ParseFile(filename);
-
-    if (result.error)
-    {
-        LOG(Logger::FATAL, "Rapidobj: ", result.error.code.message());
-        return nullptr;
-    }
-
-    if (!Triangulate(result))
-    {
-        LOG(Logger::ERROR, "Rapidobj: failed triangulation");
-    }
+    return SaveAsset(meshName, CreateMesh<T>(std::move(geometry)), isPersistent);
+}
 
+template <class T> requires std::is_base_of_v<BaseMesh, T>
+std::unique_ptr<T> MeshManager::CreateMesh(ObjGeometry&& geometry)
+{
     auto mesh = std::make_unique<T>();
-
-    static constexpr auto hash = [](const rapidobj::Index& index) -> size_t
-        {
-            size_t h1 = std::hash<int>()(index.position_index);
-            size_t h2 = std::hash<int>()(index.normal_index);
-            size_t h3 = std::hash<double>()(index.texcoord_index);
-            return h1 ^ h2 << 1 ^ h3;
-        };
-
-    auto comp = [](const rapidobj::Index& a, const rapidobj::Index& b) -> bool
-        {
-            return a.position_index == b.position_index && a.normal_index == b.normal_index && a.texcoord_index == b.texcoord_index;
-        };
-
-    std::unordered_map<rapidobj::Index, typename T::IndexType, decltype(hash), decltype(comp)> vertsIndex;
-
-    // Process each shape
-    for (const rapidobj::Shape& shape : result.shapes)
+    mesh->vertices = std::move(geometry.vertices);
+    mesh->indexes.reserve(geometry.indexes.size());
+    std::ranges::transform(geometry.indexes, std::back_inserter(mesh->indexes), [](const uint32_t index)
     {
-        // Assuming that one shape = one material
-        SubMesh subMesh{};
-
-        subMesh.indexBufferStartIndex = static_cast<uint32_t>(mesh->indexes.size());
-        // Create material from rapidobj material
-
-        if (int materialIndex = shape.mesh.material_ids[0]; materialIndex != -1)
-        {
-            subMesh.SetMaterial(ConvertRapidObjMatToTexturedMaterial(result.materials[materialIndex], pathPrefix, isPersistent));
-        }
-
-        // Iterate through the faces of the shape
-        for (size_t i = 0; i < shape.mesh.indices.size(); i += 3)
-        {
-            // Iterate through the vertices of the face
-            // Use this loop for right handed winding:
-            // for (int j = 0; j < 3; ++j)
-            //
-            // Use this one for left handed winding:
-            for (int j = 2; j >= 0; --j)
-            {
-                const auto& indexes = shape.mesh.indices[i + j];
-                const auto& [positionIndex, texcoordIndex, normalIndex] = indexes;
-
-                Vector3 position = {
-                result.attributes.positions[positionIndex * 3], result.attributes.positions[positionIndex * 3 + 1],
-                result.attributes.positions[positionIndex * 3 + 2]
-                };
-
-
-                Vector3 normal{};
-                if (normalIndex != -1)
-                    normal = Vector3{
-                        result.attributes.normals[normalIndex * 3], result.attributes.normals[normalIndex * 3 + 1],
-                        result.attributes.normals[normalIndex * 3 + 2]
-                };
-
-                Vector2 uv{};
-                if (texcoordIndex != -1)
-                    uv = Vector2{
-                        result.attributes.texcoords[texcoordIndex * 2],
-                        result.attributes.texcoords[texcoordIndex * 2 + 1]
-                };
-
-                MeshVertex vertex{ position, normal, uv };
-
-                // To convert right handed vertexes as left handed
-                vertex.SwitchHandRule();
-
-                auto index = static_cast<typename T::IndexType>(mesh->vertices.size());
-                // Only duplicate vertex when the combo vertex normal and uv doesnt already exists.
-                // This optimizes mesh verticies while still keeping uvs correctly
-                if (vertsIndex.contains(indexes))
-                {
-                    index = vertsIndex[indexes];
-                }
-                else
-                {
-                    mesh->vertices.push_back(vertex);
-                    vertsIndex[indexes] = index;
-                }
-                subMesh.indexBufferCount++;
-                mesh->indexes.push_back(index);
-            }
-        }
-        mesh->submeshes.push_back(subMesh);
-    }
-
-    return SaveAsset(meshName, std::move(mesh), isPersistent);
+        return static_cast<typename T::IndexType>(index);
+    });
+    mesh->submeshes.insert(mesh->submeshes.end(), geometry.submeshes.begin(), geometry.submeshes.end());
+    return mesh;
 }
 
-
-
 template <class T> requires std::is_base_of_v<BaseMesh, T>
 T* MeshManager::SaveAsset(const std::string& meshName, std::unique_ptr<T>&& mesh, bool isPersistent)
 {
@@ -163,10 +116,9 @@ T* MeshManager::SaveAsset(const std::string& meshName, std::unique_ptr<T>&& mesh
     mesh->name = meshName;
     mesh->Init();
 
-    std::lock_guard _{ assetManagerMutex };
-    assetCache[meshName] = { isPersistent, std::move(mesh) };
+    T* savedMesh = static_cast<T*>(StoreAsset(meshName, std::move(mesh), isPersistent));
     LOGF("Saved mesh \"{}\" to cache", meshName);
-    return dynamic_cast<T*>(assetCache[meshName].asset.get());
+    return savedMesh;
 }
 
 }
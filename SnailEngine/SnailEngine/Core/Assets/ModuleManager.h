@@ -2,27 +2,140 @@
 #include <type_traits>
 #include <cstddef>
 #include <tuple>
+#include <utility>
 #include <string>
 #include <memory>
 #include <ranges>
 #include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+
+#include "AssetHandle.h"
+#include "Core/DataStructures/AtomicSlotTable.h"
 
 namespace Snail
 {
+// Memory accounted to an asset, in bytes
+struct AssetMemoryUsage
+{
+    size_t cpuBytes = 0;
+    size_t gpuBytes = 0;
+
+    AssetMemoryUsage& operator+=(const AssetMemoryUsage& other) noexcept
+    {
+        cpuBytes += other.cpuBytes;
+        gpuBytes += other.gpuBytes;
+        return *this;
+    }
+
+    AssetMemoryUsage& operator-=(const AssetMemoryUsage& other) noexcept
+    {
+        cpuBytes -= std::min(cpuBytes, other.cpuBytes);
+        gpuBytes -= std::min(gpuBytes, other.gpuBytes);
+        return *this;
+    }
+
+    bool Fits(const AssetMemoryUsage& budget) const noexcept
+    {
+        return cpuBytes <= budget.cpuBytes && gpuBytes <= budget.gpuBytes;
+    }
+};
+
+struct AssetResidencyStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
+
+// Owners of residency references. Every asset looked up or loaded while a set is active
+// gets one reference from that set, which is dropped all at once by ReleaseReferenceSet.
+enum class AssetReferenceSet : uint8_t
+{
+    SCENE = 1 << 0,
+    PREFETCH = 1 << 1,
+};
+
 template <class T>
 class GenericAssetManager
 {
 public:
+    static constexpr size_t DEFAULT_CPU_BUDGET = 512ull * 1024 * 1024;
+    static constexpr size_t DEFAULT_GPU_BUDGET = 1024ull * 1024 * 1024;
 
     struct AssetCacheEntry
     {
         bool isPersistent;
         std::unique_ptr<T> asset;
+        SlotHandle handle{};
+
+        // Unreferenced assets stay resident until the budget is exceeded, least recently used first
+        uint32_t refCount = 0;
+        uint8_t referenceSets = 0;
+        uint64_t lastUsed = 0;
+        AssetMemoryUsage memoryUsage{};
+    };
+
+    struct AssetSlot
+    {
+        // Points to the key of the asset in the cache, which is stable for as long as the entry exists
+        const std::string* name = nullptr;
     };
 
 protected:
-    std::mutex assetManagerMutex;
+    // Exclusive to modify the cache, shared for the lookups that can run while the loading thread or
+    // the hot reload workers store assets
+    mutable std::shared_mutex assetManagerMutex;
     std::unordered_map<std::string, AssetCacheEntry> assetCache;
+    SlotMap<AssetSlot> assetSlots;
+    // Asset of each slot, written with the mutex held so that handle lookups, done per draw, don't take it
+    AtomicSlotTable<T> publishedAssets;
+
+    AssetReferenceSet activeReferenceSet = AssetReferenceSet::SCENE;
+    AssetMemoryUsage budget{DEFAULT_CPU_BUDGET, DEFAULT_GPU_BUDGET};
+    AssetResidencyStats residencyStats;
+    uint64_t useCounter = 0;
+
+    // Adds or replaces an asset in the cache.
+    // Replacing an asset keeps its slot, so handles that were given out for that name stay valid.
+    T* StoreAsset(const std::string& assetName, std::unique_ptr<T>&& asset, bool isPersistent);
+
+    void ReleaseEntry(const AssetCacheEntry& entry)
+    {
+        publishedAssets.Retract(entry.handle);
+        assetSlots.Remove(entry.handle);
+    }
+
+    // Must be called with the mutex held
+    void MarkUsed(AssetCacheEntry& entry)
+    {
+        entry.lastUsed = ++useCounter;
+        if (const auto set = static_cast<uint8_t>(activeReferenceSet); !(entry.referenceSets & set))
+        {
+            entry.referenceSets |= set;
+            ++entry.refCount;
+        }
+    }
+
+    // Handle of a cached asset, without counting as a use
+    SlotHandle FindHandle(const std::string& assetName)
+    {
+        std::lock_guard _{ assetManagerMutex };
+        const auto it = assetCache.find(assetName);
+        return it != assetCache.end() ? it->second.handle : SlotHandle{};
+    }
+
+    virtual AssetMemoryUsage ComputeMemoryUsage(const T&) const { return {}; }
+
+    // Moves the content of a reloaded asset into the cached one, so that the pointers and handles to it stay valid.
+    // Called with the mutex held, returns false when the two can't be swapped.
+    virtual bool SwapContent(T&, T&) { return false; }
+
+    // Assets that cannot be evicted even when unreferenced, e.g. textures used by resident meshes.
+    // Called before Trim takes the mutex, so that it can lock other managers.
+    virtual void CollectPinnedAssets(std::unordered_set<const T*>&) {}
 
 public:
     GenericAssetManager() = default;
@@ -33,59 +146,317 @@ public:
     template<class TChild> requires std::is_base_of_v<T, TChild>
     TChild* GetAsset(const std::string& assetName, const bool isPersistent = false)
     {
+        std::lock_guard _{ assetManagerMutex };
         auto it = assetCache.find(assetName);
         if (it != assetCache.end())
         {
             if (isPersistent)
                 it->second.isPersistent = true;
 
+            ++residencyStats.hits;
+            MarkUsed(it->second);
             return dynamic_cast<TChild*>(it->second.asset.get());
         }
 
         return nullptr;
     }
 
+    // Resolves an asset name to a handle. The asset type is verified here once,
+    // so that handle lookups do not need any RTTI.
+    template<class TChild> requires std::is_base_of_v<T, TChild>
+    AssetHandle<TChild> GetHandle(const std::string& assetName, const bool isPersistent = false)
+    {
+        std::lock_guard _{ assetManagerMutex };
+        auto it = assetCache.find(assetName);
+        if (it == assetCache.end() || !dynamic_cast<TChild*>(it->second.asset.get()))
+            return {};
+
+        if (isPersistent)
+            it->second.isPersistent = true;
+
+        ++residencyStats.hits;
+        MarkUsed(it->second);
+        return AssetHandle<TChild>{it->second.handle};
+    }
+
+    // O(1) lookup without locking, returns nullptr if the handle is stale.
+    // The asset stays valid until it is replaced or evicted, which only happens while loading.
+    template<class TChild> requires std::is_base_of_v<T, TChild>
+    TChild* GetAsset(const AssetHandle<TChild> handle) const noexcept
+    {
+        return static_cast<TChild*>(publishedAssets.Get(handle));
+    }
+
+    // Same asset as a more derived type, the handle is invalid when the asset isn't one
+    template<class TChild> requires std::is_base_of_v<T, TChild>
+    AssetHandle<TChild> CastHandle(const SlotHandle handle) const noexcept
+    {
+        return dynamic_cast<TChild*>(publishedAssets.Get(handle)) ? AssetHandle<TChild>{handle} : AssetHandle<TChild>{};
+    }
+
+    bool IsHandleValid(const SlotHandle handle) const noexcept
+    {
+        return publishedAssets.Get(handle) != nullptr;
+    }
+
+    const std::string& GetAssetName(const SlotHandle handle) const noexcept
+    {
+        static const std::string invalidName = "<stale handle>";
+        std::shared_lock _{ assetManagerMutex };
+        const AssetSlot* slot = assetSlots.Get(handle);
+        return slot ? *slot->name : invalidName;
+    }
+
     virtual bool DoesAssetExist(const std::string& name)
     {
+        std::shared_lock _{ assetManagerMutex };
         return assetCache.contains(name);
     }
 
     virtual bool IsAssetPersistent(const std::string& name)
     {
-        if (!DoesAssetExist(name))
-            return false;
-
-        return assetCache[name].isPersistent;
+        std::shared_lock _{ assetManagerMutex };
+        const auto it = assetCache.find(name);
+        return it != assetCache.end() && it->second.isPersistent;
     }
 
     virtual T* SaveAsset(const std::string& filename, bool isPersistent) = 0;
 
     virtual void DeleteAsset(const std::string& name)
     {
-        assetCache.erase(name);
+        std::lock_guard _{ assetManagerMutex };
+        if (const auto it = assetCache.find(name); it != assetCache.end())
+        {
+            ReleaseEntry(it->second);
+            assetCache.erase(it);
+        }
     }
 
-    // This cleans up all assets that are not persistent
+    // Replaces the content of a cached asset with a reloaded one, in place. Returns false if the asset is no longer
+    // cached or can't take that content, the reloaded asset then keeps it.
+    bool SwapAsset(const std::string& assetName, T& reloaded);
+    // Names of the cached assets
+    std::vector<std::string> GetAssetNames();
+
+    // Explicit residency references, for owners that outlive a reference set
+    void AddReference(SlotHandle handle);
+    void RemoveReference(SlotHandle handle);
+
+    // Assets looked up or loaded from now on are referenced by this set
+    void SetActiveReferenceSet(AssetReferenceSet set);
+    // Drops the references held by a set, the assets stay resident until Trim needs their memory
+    void ReleaseReferenceSet(AssetReferenceSet set);
+    // Evicts unreferenced assets, least recently used first, until the resident memory fits in the budget
+    void Trim();
+
+    void SetBudget(const AssetMemoryUsage& newBudget) { budget = newBudget; }
+    const AssetMemoryUsage& GetBudget() const noexcept { return budget; }
+    const AssetResidencyStats& GetResidencyStats() const noexcept { return residencyStats; }
+    AssetMemoryUsage GetResidentMemory() const;
+
+    // This cleans up all assets that are not persistent, regardless of references
     virtual void SoftCleanup()
     {
-        std::erase_if(assetCache, [](const auto& val){
-            return !val.second.isPersistent;
+        std::lock_guard _{ assetManagerMutex };
+        std::erase_if(assetCache, [this](const auto& val){
+            if (val.second.isPersistent)
+                return false;
+
+            ReleaseEntry(val.second);
+            return true;
         });
     }
 
     virtual void Cleanup()
     {
+        std::lock_guard _{ assetManagerMutex };
+        publishedAssets.Clear();
+        assetSlots.Clear();
         assetCache.clear();
     }
 
     virtual std::vector<T*> GetAllAssets() const;
+    // Same as GetAllAssets without building a vector, for per frame work.
+    // The cache stays locked for the iteration, fn must not store or remove assets of this manager.
+    template <class Fn>
+    void ForEachAsset(Fn&& fn) const
+    {
+        std::shared_lock _{ assetManagerMutex };
+        for (auto& entry : assetCache)
+            fn(entry.second.asset.get());
+    }
 
+    void RenderResidencyImGui();
     virtual void RenderImGui() = 0;
 };
 
+template <class T>
+T* GenericAssetManager<T>::StoreAsset(const std::string& assetName, std::unique_ptr<T>&& asset, const bool isPersistent)
+{
+    std::lock_guard _{ assetManagerMutex };
+    auto [it, inserted] = assetCache.try_emplace(assetName);
+    AssetCacheEntry& entry = it->second;
+    entry.isPersistent = isPersistent;
+    // A replaced asset is destroyed after its slot points to the new one
+    const std::unique_ptr<T> replaced = std::exchange(entry.asset, std::move(asset));
+    entry.memoryUsage = ComputeMemoryUsage(*entry.asset);
+
+    if (!assetSlots.Contains(entry.handle))
+        entry.handle = assetSlots.Insert({&it->first});
+    publishedAssets.Publish(entry.handle, entry.asset.get());
+
+    ++residencyStats.misses;
+    MarkUsed(entry);
+    return entry.asset.get();
+}
+
+template <class T>
+bool GenericAssetManager<T>::SwapAsset(const std::string& assetName, T& reloaded)
+{
+    std::lock_guard _{ assetManagerMutex };
+    const auto it = assetCache.find(assetName);
+    if (it == assetCache.end() || !SwapContent(*it->second.asset, reloaded))
+        return false;
+
+    it->second.memoryUsage = ComputeMemoryUsage(*it->second.asset);
+    return true;
+}
+
+template <class T>
+std::vector<std::string> GenericAssetManager<T>::GetAssetNames()
+{
+    std::lock_guard _{ assetManagerMutex };
+    std::vector<std::string> names;
+    names.reserve(assetCache.size());
+    for (const std::string& name : assetCache | std::views::keys)
+        names.push_back(name);
+    return names;
+}
+
+template <class T>
+void GenericAssetManager<T>::AddReference(const SlotHandle handle)
+{
+    std::lock_guard _{ assetManagerMutex };
+    if (const AssetSlot* slot = assetSlots.Get(handle))
+        ++assetCache.at(*slot->name).refCount;
+}
+
+template <class T>
+void GenericAssetManager<T>::RemoveReference(const SlotHandle handle)
+{
+    std::lock_guard _{ assetManagerMutex };
+    if (const AssetSlot* slot = assetSlots.Get(handle))
+    {
+        AssetCacheEntry& entry = assetCache.at(*slot->name);
+        assert(entry.refCount > 0);
+        --entry.refCount;
+        entry.lastUsed = ++useCounter;
+    }
+}
+
+template <class T>
+void GenericAssetManager<T>::SetActiveReferenceSet(const AssetReferenceSet set)
+{
+    std::lock_guard _{ assetManagerMutex };
+    activeReferenceSet = set;
+}
+
+template <class T>
+void GenericAssetManager<T>::ReleaseReferenceSet(const AssetReferenceSet set)
+{
+    std::lock_guard _{ assetManagerMutex };
+    const auto setBit = static_cast<uint8_t>(set);
+    for (AssetCacheEntry& entry : assetCache | std::views::values)
+    {
+        if (entry.referenceSets & setBit)
+        {
+            entry.referenceSets &= ~setBit;
+            --entry.refCount;
+        }
+    }
+}
+
+template <class T>
+void GenericAssetManager<T>::Trim()
+{
+    std::unordered_set<const T*> pinned;
+    CollectPinnedAssets(pinned);
+
+    std::lock_guard _{ assetManagerMutex };
+
+    // Assets can still grow after being stored (ex: terrain height fields), refresh their sizes
+    AssetMemoryUsage resident{};
+    for (AssetCacheEntry& entry : assetCache | std::views::values)
+    {
+        entry.memoryUsage = ComputeMemoryUsage(*entry.asset);
+        resident += entry.memoryUsage;
+    }
+
+    if (resident.Fits(budget))
+        return;
+
+    std::vector<typename decltype(assetCache)::iterator> candidates;
+    for (auto it = assetCache.begin(); it != assetCache.end(); ++it)
+    {
+        const AssetCacheEntry& entry = it->second;
+        if (!entry.isPersistent && entry.refCount == 0 && !pinned.contains(entry.asset.get()))
+            candidates.push_back(it);
+    }
+
+    std::ranges::sort(candidates, {}, [](const auto& it) { return it->second.lastUsed; });
+
+    for (const auto& it : candidates)
+    {
+        if (resident.Fits(budget))
+            break;
+
+        resident -= it->second.memoryUsage;
+        ++residencyStats.evictions;
+        LOGF("Evicted asset \"{}\" from cache", it->first);
+        ReleaseEntry(it->second);
+        assetCache.erase(it);
+    }
+
+    if (!resident.Fits(budget))
+        LOGF(Logger::WARN, "Referenced assets exceed the memory budget ({} MB CPU, {} MB GPU)", resident.cpuBytes >> 20, resident.gpuBytes >> 20);
+}
+
+template <class T>
+AssetMemoryUsage GenericAssetManager<T>::GetResidentMemory() const
+{
+    std::shared_lock _{ assetManagerMutex };
+    AssetMemoryUsage resident{};
+    for (const AssetCacheEntry& entry : assetCache | std::views::values)
+        resident += entry.memoryUsage;
+    return resident;
+}
+
+template <class T>
+void GenericAssetManager<T>::RenderResidencyImGui()
+{
+#ifdef _IMGUI_
+    const AssetMemoryUsage resident = GetResidentMemory();
+    const uint64_t lookups = residencyStats.hits + residencyStats.misses;
+
+    ImGui::Text("Resident: %zu assets, %.1f MB CPU, %.1f MB GPU", assetCache.size(), resident.cpuBytes / (1024.0 * 1024.0), resident.gpuBytes / (1024.0 * 1024.0));
+    ImGui::Text("Hits: %llu, misses: %llu (%.1f%% hit rate), evictions: %llu",
+        residencyStats.hits, residencyStats.misses,
+        lookups ? 100.0 * static_cast<double>(residencyStats.hits) / static_cast<double>(lookups) : 0.0,
+        residencyStats.evictions);
+
+    int budgetMB[2] = { static_cast<int>(budget.cpuBytes >> 20), static_cast<int>(budget.gpuBytes >> 20) };
+    if (ImGui::DragInt2("Budget CPU/GPU (MB)", budgetMB, 1, 0, 16384))
+        budget = { static_cast<size_t>(budgetMB[0]) << 20, static_cast<size_t>(budgetMB[1]) << 20 };
+
+    if (ImGui::Button("Trim to budget"))
+        Trim();
+#endif
+}
+
 template <class T>
 std::vector<T*> GenericAssetManager<T>::GetAllAssets() const
 {
+    std::shared_lock _{ assetManagerMutex };
     std::vector<T*> assets;
     assets.reserve(assetCache.size());
     for (auto& entry : assetCache)
@@ -132,10 +503,19 @@ class ModuleManager
     }
 
 public:
+    // Callers cache the reference in function statics, it must not be taken before the module is registered
     template <class T>
     T& Get()
     {
-        return *GetInstanceUniquePtr<T>();
+        auto& ptr = GetInstanceUniquePtr<T>();
+        assert(ptr && "Module used before it was registered");
+        return *ptr;
+    }
+
+    template <class T>
+    bool IsRegistered()
+    {
+        return GetInstanceUniquePtr<T>() != nullptr;
     }
 
     template <class T, typename... Args>
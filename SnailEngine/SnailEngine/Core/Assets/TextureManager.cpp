@@ -1,6 +1,11 @@
 #include "stdafx.h"
 #include "TextureManager.h"
 
+#include <filesystem>
+#include <typeinfo>
+
+#include "Core/WindowsEngine.h"
+#include "Rendering/StreamingTexture2D.h"
 #include "Util/Util.h"
 
 namespace Snail
@@ -15,10 +20,9 @@ T* TextureManager::SaveAsset(const std::string& filename, bool isPersistent)
 template <class T> requires std::is_base_of_v<Texture, T>
 T* TextureManager::SaveAsset(const std::string& filename, std::unique_ptr<T>&& asset, bool isPersistent)
 {
-    std::unique_lock lock(saveMutex);
-    assetCache[filename] = { isPersistent, std::move(asset) };
+    T* texture = static_cast<T*>(StoreAsset(filename, std::move(asset), isPersistent));
     LOGF("Saved texture \"{}\" to cache", filename);
-    return dynamic_cast<T*>(assetCache[filename].asset.get());
+    return texture;
 }
 
 Texture2D* TextureManager::GetTexture2D(const std::wstring& str, const bool isPersistent) { return GetTexture2D(WStringToString(str), isPersistent); }
@@ -26,31 +30,24 @@ Texture2D* TextureManager::GetTexture2D(const std::wstring& str, const bool isPe
 void TextureManager::Init()
 {
     // Initialise default textures
-
-    assetCache[DEFAULT_DIFFUSE_TEXTURE_NAME] = {
-       .isPersistent = true,
-       .asset = std::make_unique<Texture2D>(1, 1, Color{ 0xff, 0xff, 0xff, 0xff })
-    };
-
-    assetCache[DEFAULT_BLEND_TEXTURE_NAME] = {
-       .isPersistent = true,
-       .asset = std::make_unique<Texture2D>(1, 1, Color{ 0xff, 0xff, 0xff, 0xff })
-    };
-
-    assetCache[DEFAULT_AMBIENT_TEXTURE_NAME] = {
-       .isPersistent = true,
-       .asset = std::make_unique<Texture2D>(1, 1, Color{ 0xff, 0xff, 0xff, 0xff })
-    };
-
-    assetCache[DEFAULT_SPECULAR_TEXTURE_NAME] = {
-        .isPersistent = true,
-        .asset = std::make_unique<Texture2D>(1, 1, Color{ 0xff, 0xff, 0xff, 0xff })
-    };
-
-    assetCache[DEFAULT_NORMAL_MAP_TEXTURE_NAME] = {
-        .isPersistent = true,
-        .asset = std::make_unique<Texture2D>(1, 1, Color{ 0x80, 0x80, 0xff, 0xff })
-    };
+    // The order must match the DEFAULT_*_TEXTURE_HANDLE constants
+    SaveAsset<Texture2D>(DEFAULT_DIFFUSE_TEXTURE_NAME, std::make_unique<Texture2D>(1, 1, Color{ 0xff, 0xff, 0xff, 0xff }), true);
+    SaveAsset<Texture2D>(DEFAULT_BLEND_TEXTURE_NAME, std::make_unique<Texture2D>(1, 1, Color{ 0xff, 0xff, 0xff, 0xff }), true);
+    SaveAsset<Texture2D>(DEFAULT_AMBIENT_TEXTURE_NAME, std::make_unique<Texture2D>(1, 1, Color{ 0xff, 0xff, 0xff, 0xff }), true);
+    SaveAsset<Texture2D>(DEFAULT_SPECULAR_TEXTURE_NAME, std::make_unique<Texture2D>(1, 1, Color{ 0xff, 0xff, 0xff, 0xff }), true);
+    SaveAsset<Texture2D>(DEFAULT_NORMAL_MAP_TEXTURE_NAME, std::make_unique<Texture2D>(1, 1, Color{ 0x80, 0x80, 0xff, 0xff }), true);
+
+    // Looked up outside of the asserts, GetHandle interns the names and has to run in every configuration
+    [[maybe_unused]] const TextureHandle diffuseHandle = GetHandle<Texture2D>(DEFAULT_DIFFUSE_TEXTURE_NAME);
+    [[maybe_unused]] const TextureHandle blendHandle = GetHandle<Texture2D>(DEFAULT_BLEND_TEXTURE_NAME);
+    [[maybe_unused]] const TextureHandle ambientHandle = GetHandle<Texture2D>(DEFAULT_AMBIENT_TEXTURE_NAME);
+    [[maybe_unused]] const TextureHandle specularHandle = GetHandle<Texture2D>(DEFAULT_SPECULAR_TEXTURE_NAME);
+    [[maybe_unused]] const TextureHandle normalMapHandle = GetHandle<Texture2D>(DEFAULT_NORMAL_MAP_TEXTURE_NAME);
+    assert(diffuseHandle == DEFAULT_DIFFUSE_TEXTURE_HANDLE);
+    assert(blendHandle == DEFAULT_BLEND_TEXTURE_HANDLE);
+    assert(ambientHandle == DEFAULT_AMBIENT_TEXTURE_HANDLE);
+    assert(specularHandle == DEFAULT_SPECULAR_TEXTURE_HANDLE);
+    assert(normalMapHandle == DEFAULT_NORMAL_MAP_TEXTURE_HANDLE);
 }
 
 Texture2D* TextureManager::GetTexture2D(const std::string& str, const bool isPersistent)
@@ -62,10 +59,122 @@ Texture2D* TextureManager::GetTexture2D(const std::string& str, const bool isPer
         // Create texture by importing
         texture = SaveAsset<Texture2D>(str, isPersistent);
     }
+    else if (const auto streamingTexture = dynamic_cast<StreamingTexture2D*>(texture))
+    {
+        // Direct users of the texture expect it to be complete
+        streamingTexture->MakeFullyResident();
+    }
 
     return texture;
 }
 
+Texture2D* TextureManager::GetTexture2D(const TextureHandle handle, const TextureHandle fallback) const noexcept
+{
+    if (Texture2D* texture = GetAsset(handle))
+        return texture;
+
+    assert(false && "Stale texture handle");
+    return GetAsset(fallback);
+}
+
+Texture2D* TextureManager::GetBindableTexture2D(const TextureHandle handle, const TextureHandle fallback) const noexcept
+{
+    Texture2D* texture = GetTexture2D(handle, fallback);
+    return texture->IsResident() ? texture : GetAsset(fallback);
+}
+
+TextureHandle TextureManager::GetTexture2DHandle(const std::string& str, const bool isPersistent)
+{
+    static TextureStreamer& streamer = WindowsEngine::GetModule<TextureStreamer>();
+
+    if (const TextureHandle handle = GetHandle<Texture2D>(str, isPersistent); handle.IsValid())
+        return handle;
+
+    // Material textures are streamed in after the scene is loaded, the default textures are bound until then
+    if (streamer.IsEnabled() && StreamingTexture2D::CanStream(str))
+    {
+        SaveAsset<StreamingTexture2D>(str, isPersistent);
+        const SlotHandle handle = FindHandle(str);
+        streamer.Register(AssetHandle<StreamingTexture2D>{handle});
+        return TextureHandle{handle};
+    }
+
+    SaveAsset<Texture2D>(str, isPersistent);
+    return TextureHandle{FindHandle(str)};
+}
+
+std::function<bool()> TextureManager::PrepareReload(const std::string& name)
+{
+    enum class Kind { NONE, STREAMED, TEXTURE_2D, CUBE } kind = Kind::NONE;
+    {
+        std::lock_guard _{ assetManagerMutex };
+        if (const auto it = assetCache.find(name); it != assetCache.end())
+        {
+            const Texture* texture = it->second.asset.get();
+            if (dynamic_cast<const StreamingTexture2D*>(texture))
+                kind = Kind::STREAMED;
+            else if (dynamic_cast<const TextureCube*>(texture))
+                kind = Kind::CUBE;
+            else if (dynamic_cast<const Texture2D*>(texture))
+                kind = Kind::TEXTURE_2D;
+        }
+    }
+
+    if (kind == Kind::NONE || !std::filesystem::exists(name))
+        return {};
+
+    if (kind == Kind::STREAMED)
+        return [this, name] { return ReloadStreamingTexture(name); };
+
+    // Decoding is the slow part, the upload needs the immediate context
+    auto image = std::make_shared<const Image>(name);
+    return [this, name, image, kind]
+    {
+        if (kind == Kind::CUBE)
+        {
+            TextureCube reloaded{*image};
+            return SwapAsset(name, reloaded);
+        }
+
+        Texture2D reloaded{*image};
+        return SwapAsset(name, reloaded);
+    };
+}
+
+bool TextureManager::ReloadStreamingTexture(const std::string& name)
+{
+    static TextureStreamer& streamer = WindowsEngine::GetModule<TextureStreamer>();
+
+    const SlotHandle handle = FindHandle(name);
+    const auto texture = dynamic_cast<StreamingTexture2D*>(GetAsset(TextureHandle{handle}));
+    if (!texture || !texture->ReloadSource())
+        return false;
+
+    streamer.Restream(AssetHandle<StreamingTexture2D>{handle});
+    return true;
+}
+
+bool TextureManager::SwapContent(Texture& current, Texture& reloaded)
+{
+    if (typeid(current) != typeid(reloaded))
+        return false;
+
+    current.SwapResources(reloaded);
+    return true;
+}
+
+AssetMemoryUsage TextureManager::ComputeMemoryUsage(const Texture& texture) const
+{
+    // Images are released once uploaded, textures only live on the GPU
+    return { sizeof(texture), texture.GetGpuMemoryUsage() };
+}
+
+void TextureManager::CollectPinnedAssets(std::unordered_set<const Texture*>& pinned)
+{
+    static MeshManager& meshManager = WindowsEngine::GetModule<MeshManager>();
+    meshManager.CollectUsedTextures(pinned);
+}
+
 TextureCube* TextureManager::GetTextureCube(const std::wstring& str, const bool isPersistent) { return GetTextureCube(WStringToString(str), isPersistent); }
 
 void TextureManager::RenderImGui()
@@ -73,6 +182,8 @@ void TextureManager::RenderImGui()
 #ifdef _IMGUI_
     if (ImGui::CollapsingHeader("TextureManager"))
     {
+        RenderResidencyImGui();
+
         for (const auto& [textureName, texture] : assetCache)
         {
             if (ImGui::TreeNode(textureName.c_str()))
@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include <mutex>
 #include <string>
 
@@ -11,8 +12,6 @@ namespace Snail
 
 class TextureManager : public GenericAssetManager<Texture>
 {
-    std::mutex saveMutex;
-
     // Don't use standard GenericAssetManager::SaveToCache
     Texture* SaveAsset(const std::string&, bool) override
     {
@@ -22,6 +21,11 @@ class TextureManager : public GenericAssetManager<Texture>
         return nullptr;
 #endif
     }
+
+    AssetMemoryUsage ComputeMemoryUsage(const Texture& texture) const override;
+    void CollectPinnedAssets(std::unordered_set<const Texture*>& pinned) override;
+    bool SwapContent(Texture& current, Texture& reloaded) override;
+    bool ReloadStreamingTexture(const std::string& name);
 public:
     static inline const std::string DEFAULT_DIFFUSE_TEXTURE_NAME = "DefaultDiffuse";
     static inline const std::string DEFAULT_BLEND_TEXTURE_NAME = "DefaultBlend";
@@ -29,6 +33,13 @@ public:
     static inline const std::string DEFAULT_SPECULAR_TEXTURE_NAME = "DefaultSpecular";
     static inline const std::string DEFAULT_NORMAL_MAP_TEXTURE_NAME = "DefaultNormalMap";
 
+    // Default textures are the first persistent assets saved in Init, so their handles are known at compile time
+    static constexpr TextureHandle DEFAULT_DIFFUSE_TEXTURE_HANDLE{0, 1};
+    static constexpr TextureHandle DEFAULT_BLEND_TEXTURE_HANDLE{1, 1};
+    static constexpr TextureHandle DEFAULT_AMBIENT_TEXTURE_HANDLE{2, 1};
+    static constexpr TextureHandle DEFAULT_SPECULAR_TEXTURE_HANDLE{3, 1};
+    static constexpr TextureHandle DEFAULT_NORMAL_MAP_TEXTURE_HANDLE{4, 1};
+
     void Init() override;
 
     // Templated one allows to generate Cubemap or Texture2D
@@ -41,10 +52,22 @@ public:
 
     Texture2D* GetTexture2D(const std::string& str, bool isPersistent = false);
     Texture2D* GetTexture2D(const std::wstring& str, bool isPersistent = false);
+    // Stale handles give the fallback, the default texture of the material slot the handle was read from
+    Texture2D* GetTexture2D(TextureHandle handle, TextureHandle fallback) const noexcept;
+    // Texture to bind for a handle, the fallback is used while a streamed texture has no mips on the GPU
+    Texture2D* GetBindableTexture2D(TextureHandle handle, TextureHandle fallback) const noexcept;
+
+    // Loads the texture if it is not already cached, images are streamed in when the TextureStreamer is enabled
+    TextureHandle GetTexture2DHandle(const std::string& str, bool isPersistent = false);
 
     TextureCube* GetTextureCube(const std::string& str, bool isPersistent = false);
     TextureCube* GetTextureCube(const std::wstring& str, bool isPersistent = false);
 
+    // Decodes a cached texture again from its file, from any thread. The returned function uploads the new image in
+    // place on the main thread and returns false if it could not, it is empty when the texture has no file.
+    // Streamed textures are only dropped by it, the streamer brings their mips back.
+    std::function<bool()> PrepareReload(const std::string& name);
+
     void RenderImGui() override;
 };
 }
@@ -0,0 +1,161 @@
+#include "stdafx.h"
+#include "TextureStreamer.h"
+
+#include "Core/WindowsEngine.h"
+#include "Core/Memory/MemoryTracker.h"
+
+namespace Snail
+{
+
+void TextureStreamer::Register(const AssetHandle<StreamingTexture2D> handle)
+{
+    std::lock_guard _{newTexturesMutex};
+    newTextures.push_back(handle);
+}
+
+void TextureStreamer::Restream(const AssetHandle<StreamingTexture2D> handle)
+{
+    // A decode in flight finishes in the background and is dropped
+    if (const auto it = std::ranges::find_if(textures, [handle](const StreamedTexture& streamed) { return streamed.handle == handle; }); it != textures.end())
+    {
+        it->decodeJob.reset();
+        it->decodeFailed = false;
+    }
+}
+
+void TextureStreamer::Update()
+{
+    static TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
+    static ThreadPool& jobPool = WindowsEngine::GetModule<ThreadPool>();
+
+    {
+        std::lock_guard _{newTexturesMutex};
+        for (const AssetHandle<StreamingTexture2D> handle : newTextures)
+        {
+            if (std::ranges::none_of(textures, [handle](const StreamedTexture& streamed) { return streamed.handle == handle; }))
+                textures.push_back({handle});
+        }
+        newTextures.clear();
+    }
+
+    // Textures evicted by the texture manager, their decodes finish in the background and are dropped
+    std::erase_if(textures, [](const StreamedTexture& streamed) { return !textureManager.IsHandleValid(streamed.handle); });
+
+    states.clear();
+    scheduledTextures.clear();
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        StreamedTexture& streamed = textures[i];
+        StreamingTexture2D* texture = textureManager.GetAsset(streamed.handle);
+        const float requestedResolution = texture->ConsumeRequestedResolution();
+
+        const bool isDecoded = streamed.decodeJob && streamed.decodeJob->isDone;
+        if (isDecoded && streamed.decodeJob->mips.levels.empty())
+        {
+            streamed.decodeFailed = true;
+            streamed.decodeJob.reset();
+        }
+
+        if (streamed.decodeFailed || texture->IsKeptFullyResident())
+            continue;
+
+        states.push_back({texture->GetWidth(), texture->GetHeight(), texture->GetMipCount(), texture->GetResidentMipCount(), requestedResolution, isDecoded});
+        scheduledTextures.push_back(i);
+    }
+
+    scheduler.Schedule(states, result);
+
+    // Drops go first so that their memory is free before the new mips are created
+    lastUploadBytes = 0;
+    for (const bool isRaising : {false, true})
+    {
+        for (size_t i = 0; i < states.size(); ++i)
+        {
+            const uint32_t count = result.residentMipCounts[i];
+            if (isRaising ? count <= states[i].residentMipCount : count >= states[i].residentMipCount)
+                continue;
+
+            StreamedTexture& streamed = textures[scheduledTextures[i]];
+            StreamingTexture2D* texture = textureManager.GetAsset(streamed.handle);
+            lastUploadBytes += texture->SetResidentMipCount(count, streamed.decodeJob ? &streamed.decodeJob->mips : nullptr);
+        }
+    }
+    totalUploadBytes += lastUploadBytes;
+
+    // Decoded images are only kept for as long as they still have mips to give
+    for (size_t i = 0; i < states.size(); ++i)
+    {
+        TextureStreamingScheduler::TextureState state = states[i];
+        state.residentMipCount = result.residentMipCounts[i];
+
+        StreamedTexture& streamed = textures[scheduledTextures[i]];
+        if (state.isDecoded && state.residentMipCount >= TextureStreamingScheduler::GetDesiredMipCount(state))
+            streamed.decodeJob.reset();
+    }
+
+    decodesInFlight = static_cast<size_t>(std::ranges::count_if(textures, [](const StreamedTexture& streamed) { return streamed.decodeJob && !streamed.decodeJob->isDone; }));
+    for (const size_t i : result.decodeOrder)
+    {
+        if (decodesInFlight >= MAX_DECODES_IN_FLIGHT)
+            break;
+
+        StreamedTexture& streamed = textures[scheduledTextures[i]];
+        if (streamed.decodeJob)
+            continue;
+
+        const StreamingTexture2D* texture = textureManager.GetAsset(streamed.handle);
+        streamed.decodeJob = std::make_shared<DecodeJob>();
+        jobPool.AddTask([job = streamed.decodeJob, filename = texture->GetFilename(), width = texture->GetWidth(), height = texture->GetHeight(), mipCount = texture->GetMipCount()]
+        {
+            MemoryTagScope tag{MemoryTag::ASSETS};
+            try
+            {
+                job->mips = StreamingTexture2D::DecodeMipChain(filename, width, height, mipCount);
+            }
+            catch (const std::exception& e)
+            {
+                LOGF(Logger::WARN, "Could not stream texture \"{}\": {}", filename, e.what());
+            }
+            job->isDone = true;
+        });
+        ++decodesInFlight;
+    }
+}
+
+bool TextureStreamer::IsIdle()
+{
+    std::lock_guard _{newTexturesMutex};
+    return newTextures.empty() && decodesInFlight == 0 && result.isSettled;
+}
+
+void TextureStreamer::RenderImGui()
+{
+#ifdef _IMGUI_
+    if (ImGui::CollapsingHeader("Texture Streaming"))
+    {
+        ImGui::Checkbox("Stream textures of the next scenes", &isEnabled);
+
+        size_t fullyResidentCount = 0;
+        for (size_t i = 0; i < states.size(); ++i)
+        {
+            if (result.residentMipCounts[i] == states[i].mipCount)
+                ++fullyResidentCount;
+        }
+
+        ImGui::Text("Streamed textures: %zu (%zu with every mip)", textures.size(), fullyResidentCount);
+        ImGui::Text("Resident: %.1f MB, decodes in flight: %zu", result.residentBytes / (1024.0 * 1024.0), decodesInFlight);
+        ImGui::Text("Uploaded last frame: %.1f KB, total: %.1f MB", lastUploadBytes / 1024.0, totalUploadBytes / (1024.0 * 1024.0));
+        ImGui::Text("Status: %s", IsIdle() ? "idle" : "streaming");
+
+        int uploadBudgetKB = static_cast<int>(scheduler.uploadBudget >> 10);
+        if (ImGui::DragInt("Upload budget per frame (KB)", &uploadBudgetKB, 64, 64, 256 * 1024))
+            scheduler.uploadBudget = static_cast<size_t>(uploadBudgetKB) << 10;
+
+        int memoryCapMB = static_cast<int>(scheduler.memoryCap >> 20);
+        if (ImGui::DragInt("Memory cap (MB)", &memoryCapMB, 1, 1, 16384))
+            scheduler.memoryCap = static_cast<size_t>(memoryCapMB) << 20;
+    }
+#endif
+}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "AssetHandle.h"
+#include "TextureStreamingScheduler.h"
+#include "Rendering/StreamingTexture2D.h"
+
+namespace Snail
+{
+
+// Streams material textures in after their scene is loaded: images are decoded on the job system,
+// their mip tails are uploaded first and the larger mips follow under a per-frame upload budget,
+// most undersampled first, from the resolutions requested while culling the previous frame.
+class TextureStreamer
+{
+public:
+    static constexpr size_t MAX_DECODES_IN_FLIGHT = 4;
+
+private:
+    struct DecodeJob
+    {
+        StreamingTexture2D::MipChain mips;
+        // Set last by the worker, the mips are empty if decoding failed
+        std::atomic<bool> isDone = false;
+    };
+
+    struct StreamedTexture
+    {
+        AssetHandle<StreamingTexture2D> handle;
+        // Kept until the texture has all the mips it needs
+        std::shared_ptr<DecodeJob> decodeJob;
+        bool decodeFailed = false;
+    };
+
+    // Textures are registered from the loading thread
+    std::mutex newTexturesMutex;
+    std::vector<AssetHandle<StreamingTexture2D>> newTextures;
+
+    std::vector<StreamedTexture> textures;
+    TextureStreamingScheduler scheduler;
+
+    // Reused every frame
+    std::vector<TextureStreamingScheduler::TextureState> states;
+    std::vector<size_t> scheduledTextures;
+    TextureStreamingScheduler::Result result;
+
+    size_t decodesInFlight = 0;
+    size_t lastUploadBytes = 0;
+    uint64_t totalUploadBytes = 0;
+    bool isEnabled = true;
+
+public:
+    void Register(AssetHandle<StreamingTexture2D> handle);
+    // Forgets what was decoded for a texture whose file changed, its mips are decoded again from the file
+    void Restream(AssetHandle<StreamingTexture2D> handle);
+    void Update();
+
+    // Nothing left to decode or upload for the current views
+    bool IsIdle();
+    // Textures loaded while disabled are uploaded in full right away
+    bool IsEnabled() const noexcept { return isEnabled; }
+
+    void RenderImGui();
+};
+
+}
@@ -0,0 +1,189 @@
+#include "stdafx.h"
+#include "TextureStreamingScheduler.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace Snail
+{
+
+namespace
+{
+
+using TextureState = TextureStreamingScheduler::TextureState;
+
+// How undersampled the texture is with this many mips, the most undersampled textures are streamed in first
+float GetPriority(const TextureState& texture, const uint32_t residentMipCount)
+{
+    if (residentMipCount == 0)
+        return std::numeric_limits<float>::infinity();
+
+    const uint32_t topMip = texture.mipCount - residentMipCount;
+    const uint32_t topSize = std::max(1u, std::max(texture.width, texture.height) >> topMip);
+    return texture.requestedResolution / static_cast<float>(topSize);
+}
+
+}
+
+uint32_t TextureStreamingScheduler::GetMipCount(const uint32_t width, const uint32_t height) noexcept
+{
+    return std::bit_width(std::max({width, height, 1u}));
+}
+
+uint32_t TextureStreamingScheduler::GetTailMipCount(const uint32_t width, const uint32_t height) noexcept
+{
+    const uint32_t mipCount = GetMipCount(width, height);
+    return std::min(mipCount, GetMipCount(MIP_TAIL_SIZE, MIP_TAIL_SIZE));
+}
+
+size_t TextureStreamingScheduler::GetMipBytes(const TextureState& texture, const uint32_t mip) noexcept
+{
+    const size_t width = std::max(1u, texture.width >> mip);
+    const size_t height = std::max(1u, texture.height >> mip);
+    return width * height * BYTES_PER_TEXEL;
+}
+
+size_t TextureStreamingScheduler::GetResidentBytes(const TextureState& texture, const uint32_t residentMipCount) noexcept
+{
+    size_t bytes = 0;
+    for (uint32_t mip = texture.mipCount - residentMipCount; mip < texture.mipCount; ++mip)
+        bytes += GetMipBytes(texture, mip);
+    return bytes;
+}
+
+uint32_t TextureStreamingScheduler::GetDesiredMipCount(const TextureState& texture) noexcept
+{
+    const uint32_t tailMipCount = GetTailMipCount(texture.width, texture.height);
+    if (texture.requestedResolution <= 0)
+        return tailMipCount;
+
+    // Smallest mip that still has at least as many texels as there are pixels
+    const uint32_t size = std::max(texture.width, texture.height);
+    uint32_t mip = 0;
+    while (mip + 1 < texture.mipCount && static_cast<float>(size >> (mip + 1)) >= texture.requestedResolution)
+        ++mip;
+
+    return std::max(texture.mipCount - mip, tailMipCount);
+}
+
+void TextureStreamingScheduler::Schedule(const std::span<const TextureState> textures, Result& result) const
+{
+    const size_t count = textures.size();
+    std::vector<uint32_t>& residentMipCounts = result.residentMipCounts;
+    residentMipCounts.resize(count);
+    result.decodeOrder.clear();
+    result.uploadBytes = 0;
+    result.residentBytes = 0;
+    result.isSettled = true;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const TextureState& texture = textures[i];
+        residentMipCounts[i] = texture.residentMipCount;
+        result.residentBytes += GetResidentBytes(texture, texture.residentMipCount);
+
+        if (texture.residentMipCount < GetDesiredMipCount(texture) && !texture.isDecoded)
+            result.decodeOrder.push_back(i);
+    }
+
+    // Tails are uploaded regardless of the budget so that every texture shows up as soon as it is decoded
+    for (size_t i = 0; i < count; ++i)
+    {
+        const TextureState& texture = textures[i];
+        const uint32_t tailMipCount = GetTailMipCount(texture.width, texture.height);
+        if (!texture.isDecoded || residentMipCounts[i] >= tailMipCount)
+            continue;
+
+        const size_t bytes = GetResidentBytes(texture, tailMipCount) - GetResidentBytes(texture, residentMipCounts[i]);
+        result.uploadBytes += bytes;
+        result.residentBytes += bytes;
+        residentMipCounts[i] = tailMipCount;
+    }
+
+    // Least needed mip above a tail, to be dropped when memory is over the cap
+    const auto findDropCandidate = [&](const size_t excluded, const float maxPriority)
+    {
+        size_t candidate = count;
+        float candidatePriority = maxPriority;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const TextureState& texture = textures[i];
+            if (i == excluded || residentMipCounts[i] <= GetTailMipCount(texture.width, texture.height))
+                continue;
+
+            if (const float priority = GetPriority(texture, residentMipCounts[i]); priority < candidatePriority)
+            {
+                candidate = i;
+                candidatePriority = priority;
+            }
+        }
+        return candidate;
+    };
+    const auto dropMip = [&](const size_t i)
+    {
+        result.residentBytes -= GetMipBytes(textures[i], textures[i].mipCount - residentMipCounts[i]);
+        --residentMipCounts[i];
+    };
+
+    while (result.residentBytes > memoryCap)
+    {
+        const size_t candidate = findDropCandidate(count, std::numeric_limits<float>::infinity());
+        if (candidate == count)
+            break;
+        dropMip(candidate);
+    }
+
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (textures[i].isDecoded && residentMipCounts[i] < GetDesiredMipCount(textures[i]))
+            candidates.push_back(i);
+    }
+
+    // Stream in the most undersampled textures one mip at a time until the budget is spent
+    while (!candidates.empty())
+    {
+        const auto best = std::ranges::max_element(candidates, {}, [&](const size_t i) { return GetPriority(textures[i], residentMipCounts[i]); });
+        const size_t i = *best;
+        const TextureState& texture = textures[i];
+        const float priority = GetPriority(texture, residentMipCounts[i]);
+        const size_t bytes = GetMipBytes(texture, texture.mipCount - residentMipCounts[i] - 1);
+
+        // A mip bigger than the whole budget still goes through on its own
+        if (result.uploadBytes > 0 && result.uploadBytes + bytes > uploadBudget)
+        {
+            result.isSettled = false;
+            candidates.erase(best);
+            continue;
+        }
+
+        // Only mips needed much less than this one make room for it, so that two textures never swap a mip back and forth
+        while (result.residentBytes + bytes > memoryCap)
+        {
+            const size_t dropped = findDropCandidate(i, priority * 0.5f);
+            if (dropped == count)
+                break;
+            dropMip(dropped);
+        }
+
+        if (result.residentBytes + bytes > memoryCap)
+        {
+            candidates.erase(best);
+            continue;
+        }
+
+        ++residentMipCounts[i];
+        result.uploadBytes += bytes;
+        result.residentBytes += bytes;
+
+        if (residentMipCounts[i] >= GetDesiredMipCount(texture))
+            candidates.erase(best);
+    }
+
+    std::ranges::stable_sort(result.decodeOrder, std::ranges::greater{}, [&](const size_t i) { return textures[i].requestedResolution; });
+    if (!result.decodeOrder.empty())
+        result.isSettled = false;
+}
+
+}
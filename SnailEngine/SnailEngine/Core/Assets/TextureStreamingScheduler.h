@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Snail
+{
+
+// Picks the resident mips of every streamed texture from what was requested while culling.
+// Only works on sizes and mip counts so it can run without a GPU.
+class TextureStreamingScheduler
+{
+public:
+    struct TextureState
+    {
+        uint32_t width = 1;
+        uint32_t height = 1;
+        uint32_t mipCount = 1;
+        uint32_t residentMipCount = 0;
+        // Screen pixels covered by one UV unit, 0 when the texture was not visible
+        float requestedResolution = 0;
+        // Mips can only be streamed in once the image is decoded
+        bool isDecoded = false;
+    };
+
+    struct Result
+    {
+        // Resident mip count of every texture after this frame
+        std::vector<uint32_t> residentMipCounts;
+        // Textures to decode, most urgent first
+        std::vector<size_t> decodeOrder;
+        size_t uploadBytes = 0;
+        size_t residentBytes = 0;
+        // Nothing left to stream in once the current decodes are done
+        bool isSettled = true;
+    };
+
+    // Mips up to this size are the tail, uploaded as soon as the image is decoded
+    static constexpr uint32_t MIP_TAIL_SIZE = 64;
+    static constexpr uint32_t BYTES_PER_TEXEL = 4;
+    static constexpr size_t DEFAULT_UPLOAD_BUDGET = 8ull * 1024 * 1024;
+    static constexpr size_t DEFAULT_MEMORY_CAP = 512ull * 1024 * 1024;
+
+    // Bytes streamed in per frame, mip tails are always uploaded
+    size_t uploadBudget = DEFAULT_UPLOAD_BUDGET;
+    // Resident bytes of all the streamed textures, the least needed mips are dropped above it
+    size_t memoryCap = DEFAULT_MEMORY_CAP;
+
+    static uint32_t GetMipCount(uint32_t width, uint32_t height) noexcept;
+    static uint32_t GetTailMipCount(uint32_t width, uint32_t height) noexcept;
+    static size_t GetMipBytes(const TextureState& texture, uint32_t mip) noexcept;
+    static size_t GetResidentBytes(const TextureState& texture, uint32_t residentMipCount) noexcept;
+    // Mips needed to show one texel per pixel, never less than the tail
+    static uint32_t GetDesiredMipCount(const TextureState& texture) noexcept;
+
+    void Schedule(std::span<const TextureState> textures, Result& result) const;
+};
+
+}
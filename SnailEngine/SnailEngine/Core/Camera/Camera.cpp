@@ -303,7 +303,7 @@ Vector3 Camera::GetThirdPersonTargetPosition(const Vector3& targetPosition, cons
     Vector3 direction = nextPosition - targetPosition;
     const float dirDistance = direction.Length();
     direction.Normalize(direction);
-    if (const float dist = physicsModule.RaycastDistance(targetPosition, direction); dist < dirDistance)
+    if (const float dist = physicsModule.RaycastDistance(targetPosition, direction, CollisionLayers::Query::CAMERA); dist < dirDistance)
     {
         nextPosition = targetPosition + direction * std::max(dist, cameraMinDistance);
     }
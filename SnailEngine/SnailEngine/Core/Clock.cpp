@@ -2,6 +2,11 @@
 
 #include "Clock.h"
 
+// Windows 10 1803 and later, older SDKs don't define it
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
 namespace Snail
 {
 	Clock::Clock()
@@ -9,6 +14,17 @@ namespace Snail
 		LARGE_INTEGER counterFrequency;
 		QueryPerformanceFrequency(&counterFrequency);
 		secondsPerCount = 1.0 / static_cast<double>(counterFrequency.QuadPart);
+
+		// The regular timers only wake up on the scheduler ticks, up to 15.6 ms late
+		timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		if (!timer)
+			timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+	}
+
+	Clock::~Clock()
+	{
+		if (timer)
+			CloseHandle(timer);
 	}
 
 	int64_t Clock::GetTimeCount() const
@@ -22,4 +38,20 @@ namespace Snail
 	{
 		return static_cast<double>(stop - start) * secondsPerCount;
 	}
+
+	void Clock::SleepFor(const double seconds)
+	{
+		// Relative times are negative, in 100 nanoseconds
+		LARGE_INTEGER dueTime;
+		dueTime.QuadPart = -static_cast<LONGLONG>(seconds * 10000000.0);
+		if (timer && SetWaitableTimerEx(timer, &dueTime, 0, nullptr, nullptr, nullptr, 0))
+			WaitForSingleObject(timer, INFINITE);
+		else
+			Sleep(static_cast<DWORD>(seconds * 1000.0));
+	}
+
+	void Clock::SpinWait() noexcept
+	{
+		YieldProcessor();
+	}
 } // namespace Snail
\ No newline at end of file
@@ -1,17 +1,27 @@
 #pragma once
 #include <stdint.h>
 
+#include "FramePacer.h"
+
 namespace Snail
 {
-	class Clock
+	class Clock final : public PacingClock
 	{
 	public:
 		Clock();
-		int64_t GetTimeCount() const;
-		double GetSecPerCount() const noexcept { return secondsPerCount; }
+		~Clock() override;
+		Clock(const Clock&) = delete;
+		Clock& operator=(const Clock&) = delete;
+
+		int64_t GetTimeCount() const override;
+		double GetSecPerCount() const noexcept override { return secondsPerCount; }
 		// retourne le temps en millisecondes entre deux count.
 		double GetTimeBetweenCounts(int64_t start, int64_t stop) const;
+		// Sleeps on a high resolution waitable timer when the system has them
+		void SleepFor(double seconds) override;
+		void SpinWait() noexcept override;
 	private:
 		double secondsPerCount;
+		HANDLE timer = nullptr;
 	};
-} // namespace PM3
\ No newline at end of file
+} // namespace PM3
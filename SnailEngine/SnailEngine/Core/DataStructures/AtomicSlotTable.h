@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <memory>
+
+#include "SlotMap.h"
+
+namespace Snail
+{
+
+// Publishes pointers under the handles of a SlotMap, for lookups that don't take the lock guarding that map.
+// Pages are allocated on first use and only freed with the table, so readers never see a reallocated array.
+// Writers must be serialized by the owner of the SlotMap. A reader gets either nullptr or the pointer that was
+// published with its exact handle, never the one of a slot reused under a newer generation.
+template <class T>
+class AtomicSlotTable
+{
+    static constexpr uint32_t PAGE_BITS = 10;
+    static constexpr uint32_t PAGE_SIZE = 1u << PAGE_BITS;
+    static constexpr uint32_t PAGE_COUNT = (SlotHandle::INDEX_MASK + 1) / PAGE_SIZE;
+
+    struct Entry
+    {
+        std::atomic<uint32_t> handle = 0;
+        std::atomic<T*> value = nullptr;
+    };
+
+    struct Page
+    {
+        Entry entries[PAGE_SIZE];
+    };
+
+    std::unique_ptr<std::atomic<Page*>[]> pages = std::make_unique<std::atomic<Page*>[]>(PAGE_COUNT);
+
+public:
+    AtomicSlotTable() = default;
+    AtomicSlotTable(const AtomicSlotTable&) = delete;
+    AtomicSlotTable& operator=(const AtomicSlotTable&) = delete;
+    ~AtomicSlotTable();
+
+    // Writer only
+    void Publish(SlotHandle handle, T* value);
+    void Retract(SlotHandle handle) noexcept;
+    void Clear() noexcept;
+
+    // Any thread
+    [[nodiscard]] T* Get(SlotHandle handle) const noexcept;
+};
+
+template <class T>
+AtomicSlotTable<T>::~AtomicSlotTable()
+{
+    for (uint32_t i = 0; i < PAGE_COUNT; ++i)
+        delete pages[i].load(std::memory_order_relaxed);
+}
+
+template <class T>
+void AtomicSlotTable<T>::Publish(const SlotHandle handle, T* value)
+{
+    std::atomic<Page*>& pageSlot = pages[handle.GetIndex() >> PAGE_BITS];
+    Page* page = pageSlot.load(std::memory_order_relaxed);
+    if (!page)
+    {
+        page = new Page{};
+        pageSlot.store(page, std::memory_order_release);
+    }
+
+    // The value first, a reader that sees the handle also sees what it was published with
+    Entry& entry = page->entries[handle.GetIndex() & (PAGE_SIZE - 1)];
+    entry.value.store(value, std::memory_order_release);
+    entry.handle.store(handle.value, std::memory_order_release);
+}
+
+template <class T>
+void AtomicSlotTable<T>::Retract(const SlotHandle handle) noexcept
+{
+    Page* page = pages[handle.GetIndex() >> PAGE_BITS].load(std::memory_order_relaxed);
+    if (!page)
+        return;
+
+    // The handle first, a reader that sees the cleared value also sees that the handle changed
+    Entry& entry = page->entries[handle.GetIndex() & (PAGE_SIZE - 1)];
+    entry.handle.store(0, std::memory_order_release);
+    entry.value.store(nullptr, std::memory_order_release);
+}
+
+template <class T>
+void AtomicSlotTable<T>::Clear() noexcept
+{
+    for (uint32_t i = 0; i < PAGE_COUNT; ++i)
+    {
+        Page* page = pages[i].load(std::memory_order_relaxed);
+        if (!page)
+            continue;
+
+        for (Entry& entry : page->entries)
+        {
+            entry.handle.store(0, std::memory_order_release);
+            entry.value.store(nullptr, std::memory_order_release);
+        }
+    }
+}
+
+template <class T>
+T* AtomicSlotTable<T>::Get(const SlotHandle handle) const noexcept
+{
+    if (!handle.IsValid())
+        return nullptr;
+
+    const Page* page = pages[handle.GetIndex() >> PAGE_BITS].load(std::memory_order_acquire);
+    if (!page)
+        return nullptr;
+
+    const Entry& entry = page->entries[handle.GetIndex() & (PAGE_SIZE - 1)];
+    if (entry.handle.load(std::memory_order_acquire) != handle.value)
+        return nullptr;
+
+    T* value = entry.value.load(std::memory_order_acquire);
+    // The slot may have been retracted or reused between the two loads
+    return entry.handle.load(std::memory_order_acquire) == handle.value ? value : nullptr;
+}
+
+}
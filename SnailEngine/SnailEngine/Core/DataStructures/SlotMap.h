@@ -0,0 +1,134 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace Snail
+{
+
+// 32-bit generational handle: the low bits index a slot, the high bits store the generation of that slot
+// when the handle was issued. A handle whose generation does not match the slot's is stale.
+// A zero handle is always invalid since generations start at 1.
+struct SlotHandle
+{
+    static constexpr uint32_t INDEX_BITS = 20;
+    static constexpr uint32_t GENERATION_BITS = 32 - INDEX_BITS;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr uint32_t MAX_GENERATION = (1u << GENERATION_BITS) - 1;
+
+    uint32_t value = 0;
+
+    constexpr SlotHandle() = default;
+    constexpr SlotHandle(const uint32_t index, const uint32_t generation)
+        : value{(generation << INDEX_BITS) | (index & INDEX_MASK)}
+    {}
+
+    constexpr uint32_t GetIndex() const noexcept { return value & INDEX_MASK; }
+    constexpr uint32_t GetGeneration() const noexcept { return value >> INDEX_BITS; }
+    constexpr bool IsValid() const noexcept { return value != 0; }
+
+    constexpr bool operator==(const SlotHandle&) const = default;
+};
+
+// Stores values in a flat array addressed by SlotHandle.
+// Lookups are a bounds check, a generation compare and an array index.
+// Removed slots are recycled with a bumped generation so older handles are detected as stale.
+template <class T>
+class SlotMap
+{
+    struct Slot
+    {
+        T value{};
+        uint32_t generation = 1;
+        bool occupied = false;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    size_t count = 0;
+
+public:
+    SlotHandle Insert(T value);
+    bool Remove(SlotHandle handle);
+    void Clear();
+
+    [[nodiscard]] T* Get(SlotHandle handle) noexcept;
+    [[nodiscard]] const T* Get(SlotHandle handle) const noexcept;
+    [[nodiscard]] bool Contains(SlotHandle handle) const noexcept;
+    [[nodiscard]] size_t Size() const noexcept { return count; }
+};
+
+template <class T>
+SlotHandle SlotMap<T>::Insert(T value)
+{
+    uint32_t index;
+    if (!freeSlots.empty())
+    {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(slots.size());
+        assert(index <= SlotHandle::INDEX_MASK && "SlotMap is full");
+        slots.emplace_back();
+    }
+
+    Slot& slot = slots[index];
+    slot.value = std::move(value);
+    slot.occupied = true;
+    ++count;
+
+    return {index, slot.generation};
+}
+
+template <class T>
+bool SlotMap<T>::Remove(const SlotHandle handle)
+{
+    if (!Contains(handle))
+        return false;
+
+    Slot& slot = slots[handle.GetIndex()];
+    slot.value = T{};
+    slot.occupied = false;
+    // Skip generation 0 on wrap around so that a zero handle always stays invalid
+    slot.generation = slot.generation == SlotHandle::MAX_GENERATION ? 1 : slot.generation + 1;
+    freeSlots.push_back(handle.GetIndex());
+    --count;
+
+    return true;
+}
+
+template <class T>
+void SlotMap<T>::Clear()
+{
+    for (uint32_t i = 0; i < slots.size(); ++i)
+    {
+        if (slots[i].occupied)
+            Remove({i, slots[i].generation});
+    }
+}
+
+template <class T>
+T* SlotMap<T>::Get(const SlotHandle handle) noexcept
+{
+    return Contains(handle) ? &slots[handle.GetIndex()].value : nullptr;
+}
+
+template <class T>
+const T* SlotMap<T>::Get(const SlotHandle handle) const noexcept
+{
+    return Contains(handle) ? &slots[handle.GetIndex()].value : nullptr;
+}
+
+template <class T>
+bool SlotMap<T>::Contains(const SlotHandle handle) const noexcept
+{
+    const uint32_t index = handle.GetIndex();
+    return handle.IsValid()
+        && index < slots.size()
+        && slots[index].occupied
+        && slots[index].generation == handle.GetGeneration();
+}
+
+}
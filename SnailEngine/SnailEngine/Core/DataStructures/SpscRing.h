@@ -0,0 +1,68 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Snail
+{
+
+// Lock-free ring for exactly one producer thread and one consumer thread. Push and Pop never block, Push fails when
+// the ring is full. N must be a power of two.
+template <class T, size_t N>
+class SpscRing
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "The capacity of the ring must be a power of two");
+
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    // A cache line apart so that the two threads don't invalidate each other's. Padded rather than aligned, aligning
+    // warns about the padding.
+    std::atomic<size_t> head = 0;
+    char headPadding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)]{};
+    std::atomic<size_t> tail = 0;
+    char tailPadding[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)]{};
+    std::array<T, N> items{};
+
+public:
+    static constexpr size_t CAPACITY = N;
+
+    // Producer only
+    bool Push(const T& item) noexcept;
+    // Consumer only
+    bool Pop(T& item) noexcept;
+
+    // Exact from either thread when the other one is idle, an estimate otherwise
+    size_t GetSize() const noexcept;
+};
+
+template <class T, size_t N>
+bool SpscRing<T, N>::Push(const T& item) noexcept
+{
+    const size_t currentTail = tail.load(std::memory_order_relaxed);
+    if (currentTail - head.load(std::memory_order_acquire) == N)
+        return false;
+
+    items[currentTail & (N - 1)] = item;
+    tail.store(currentTail + 1, std::memory_order_release);
+    return true;
+}
+
+template <class T, size_t N>
+bool SpscRing<T, N>::Pop(T& item) noexcept
+{
+    const size_t currentHead = head.load(std::memory_order_relaxed);
+    if (currentHead == tail.load(std::memory_order_acquire))
+        return false;
+
+    item = items[currentHead & (N - 1)];
+    head.store(currentHead + 1, std::memory_order_release);
+    return true;
+}
+
+template <class T, size_t N>
+size_t SpscRing<T, N>::GetSize() const noexcept
+{
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+}
+
+}
@@ -6,11 +6,19 @@
 #include "Rendering/UI/Font.h"
 
 #include "Assets/ModuleManager.h"
+#include "Assets/AssetHotReload.h"
 #include "Assets/MeshManager.h"
 #include "Assets/TextureManager.h"
+#include "Assets/TextureStreamer.h"
 
 #include "Core/Camera/CameraManager.h"
 #include "Core/Scene.h"
+#include "Core/FramePacer.h"
+#include "Core/StartupGraph.h"
+#include "Core/Memory/FrameArena.h"
+#include "Core/Memory/MemoryTracker.h"
+#include "Core/ThreadPool.h"
+#include "Core/Math/TransformHierarchy.h"
 #include "GamePlay/GameManager.h"
 #include "Physics/PhysicsModule.h"
 #include "Util/Singleton.h"
@@ -28,8 +36,13 @@ class Engine : public Singleton<T>
 {
 public:
     virtual void Run();
+    // Waits for the frame to be due, then processes the window messages and updates. Run calls it until exit.
+    void RunFrame();
     virtual int Init();
     virtual void Update();
+    // Frame arena, job system and transform hierarchy, the modules that need neither a window nor a device. Called by
+    // Init, or alone by the tests.
+    void InitCoreModules();
 
     TDeviceType* GetRenderDevice();
 
@@ -48,9 +61,15 @@ public:
         return camManager.GetCurrentCamera();
     }
 
+    // Nothing is shown and the log file is left as it is, for the engine tests. Must be set before Init.
+    void SetHeadless(bool headless) noexcept { isHeadless = headless; }
+    bool IsHeadless() const noexcept { return isHeadless; }
+
     void SetPaused(bool setPaused);
     bool IsPaused() const;
     float GetDeltaTime() const;
+    const StartupGraph::Results& GetStartupResults() const noexcept { return startupResults; }
+    FramePacer& GetFramePacer() noexcept { return *framePacer; }
 
     void Exit();
 
@@ -64,6 +83,7 @@ protected:
 
     virtual void UpdateSpecific() = 0;
     virtual int64_t GetTimeSpecific() const = 0;
+    virtual PacingClock& GetClockSpecific() = 0;
     virtual double GetTimeIntervalsInSec(int64_t start, int64_t stop) const = 0;
 
     virtual void ResizeSpecific() = 0;
@@ -74,6 +94,7 @@ protected:
     virtual void ToggleFullscreen();
 
     bool isInitialized = false;
+    bool isHeadless = false;
     int64_t prevTime = 0;
     int64_t nextTime = 0;
     std::unique_ptr<TDeviceType> renderDevice;
@@ -87,17 +108,26 @@ protected:
 
     std::unique_ptr<Scene> scene;
     std::unique_ptr<Font> defaultFont;
+    StartupGraph::Results startupResults;
+    std::unique_ptr<FramePacer> framePacer;
+    // What the device was last told, 0 before the first frame
+    uint32_t frameLatency = 0;
 
     std::unique_ptr<LoadingScreen> loadingScreen;
 
     // Modules
     ModuleManager<
         TextureManager,
+        TextureStreamer,
         MeshManager,
+        AssetHotReload,
         RendererModule,
         CameraManager,
         PhysicsModule,
         GameManager,
+        TransformHierarchy,
+        ThreadPool,
+        FrameArena,
         DirectX::AudioEngine
     > modules;
 
@@ -111,16 +141,31 @@ template <class T, class TDeviceType> requires std::is_base_of_v<Device, TDevice
 void Engine<T, TDeviceType>::Run()
 {
     while (!shouldExit)
+        RunFrame();
+}
+
+template <class T, class TDeviceType> requires std::is_base_of_v<Device, TDeviceType>
+void Engine<T, TDeviceType>::RunFrame()
+{
+    // Sleeps until the frame is due, before the inputs are read
+    framePacer->WaitForNextFrame(isPaused || isMainMenuLoaded || scene->IsLoading());
+
+    if (const uint32_t maxFramesInFlight = framePacer->GetSettings().maxFramesInFlight; maxFramesInFlight != frameLatency)
     {
-        UpdateSpecific();
-        Update();
+        std::lock_guard lock{DeviceMutex};
+        renderDevice->SetMaximumFrameLatency(maxFramesInFlight);
+        frameLatency = maxFramesInFlight;
     }
+
+    UpdateSpecific();
+    Update();
 }
 
 template <class T, class TDeviceType> requires std::is_base_of_v<Device, TDeviceType>
 int Engine<T, TDeviceType>::Init()
 {
-    logger.SetLogFile("SnailEngine.log");
+    if (!isHeadless)
+        logger.SetLogFile("SnailEngine.log");
 
     // Propre à la plateforme
     InitSpecific();
@@ -133,40 +178,73 @@ int Engine<T, TDeviceType>::Init()
 
     LOG("Loading modules...");
 
-    // Initialise PhysX
-    modules.RegisterModule<PhysicsModule>();
-    LOG("Physics module initialized");
+    InitCoreModules();
 
-    // DirectX Tookit Audio Engine
-    DirectX::AUDIO_ENGINE_FLAGS eflags = DirectX::AudioEngine_Default;
-#ifdef _DEBUG
-    eflags |= DirectX::AudioEngine_Debug;
-#endif
-    modules.RegisterModule<DirectX::AudioEngine>(eflags);
-    LOG("Audio module initialised");
+    // Controllers are polled on their own thread from now on
+    InputModule::GetInstance().Controller.StartSampling(std::make_unique<XInputControllerSource>());
+    LOG("Input sampling started");
 
-    // Load asset manager modules once render device exists
-    modules.RegisterModule<TextureManager>();
-    LOG("Texture manager initialised");
+    using enum StartupGraph::Affinity;
+    StartupGraph startup;
 
-    modules.RegisterModule<MeshManager>();
-    LOG("Mesh manager initialised");
+    // Initialise PhysX
+    startup.Add("Physics", ANY_THREAD, {}, [this] { modules.RegisterModule<PhysicsModule>(); });
 
-    defaultFont = std::make_unique<Font>();
-    loadingScreen = std::make_unique<LoadingScreen>();
+    // DirectX Tookit Audio Engine, XAudio2 wants COM initialised on the thread creating it
+    startup.Add("Audio", MAIN_THREAD, {}, [this]
+    {
+        DirectX::AUDIO_ENGINE_FLAGS eflags = DirectX::AudioEngine_Default;
+        eflags |= DirectX::AudioEngine_Debug;
+        modules.RegisterModule<DirectX::AudioEngine>(eflags);
+    });
 
-    modules.RegisterModule<CameraManager>();
-    LOG("Camera manager initialised");
+    // Load asset manager modules once render device exists
+    // The texture manager hands out streamed textures once the streamer exists
+    startup.Add("Textures", ANY_THREAD, {}, [this]
+    {
+        modules.RegisterModule<TextureManager>();
+        modules.RegisterModule<TextureStreamer>();
+    });
+    startup.Add("Mesh manager", ANY_THREAD, {"Textures"}, [this] { modules.RegisterModule<MeshManager>(); });
+    startup.Add("Default font", ANY_THREAD, {"Textures"}, [this] { defaultFont = std::make_unique<Font>(); });
+    // Only starts watching, the files are first scanned after the main menu is loaded
+    startup.Add("Asset hot reload", ANY_THREAD, {}, [this] { modules.RegisterModule<AssetHotReload>(); });
+
+    // Drawn by the main thread while it waits for the rest
+    startup.Add("Loading screen", MAIN_THREAD, {"Textures"}, [this] { loadingScreen = std::make_unique<LoadingScreen>(); });
+
+    startup.Add("Camera manager", ANY_THREAD, {}, [this] { modules.RegisterModule<CameraManager>(); });
+    // Decodes the sound effects and the HUD textures, then hides its UI from the current camera
+    startup.Add("Game manager", ANY_THREAD, {"Audio", "Textures", "Default font", "Camera manager"}, [this] { modules.RegisterModule<GameManager>(); });
+
+    // Initialises ImGui on the window
+    startup.Add("Renderer", MAIN_THREAD, {"Textures", "Mesh manager", "Camera manager"}, [this] { modules.RegisterModule<RendererModule>(); });
+
+    // Starts loading the main menu, loading a scene flushes the render preparation
+    startup.Add("Scene", MAIN_THREAD, {"Physics", "Textures", "Mesh manager", "Camera manager", "Game manager", "Renderer"}, [this]
+    {
+        scene = std::make_unique<Scene>();
+    });
 
-    modules.RegisterModule<GameManager>();
-    LOG("Game manager initialised");
+    startupResults = startup.Run(modules.Get<ThreadPool>(), [this, lastTime = GetTimeSpecific()]() mutable
+    {
+        if (!loadingScreen)
+            return;
 
-    scene = std::make_unique<Scene>();
+        const int64_t currentTime = GetTimeSpecific();
+        loadingScreen->Update(static_cast<float>(GetTimeIntervalsInSec(lastTime, currentTime)));
+        lastTime = currentTime;
 
-    modules.RegisterModule<RendererModule>();
+        // The workers use the immediate context too
+        std::lock_guard lock{DeviceMutex};
+        loadingScreen->Draw();
+        renderDevice->Present();
+    });
+    StartupGraph::LogResults(startupResults);
     LOG("Modules loaded");
 
     isInitialized = true;
+    framePacer = std::make_unique<FramePacer>(GetClockSpecific());
 
     prevTime = nextTime = GetTimeSpecific();
     
@@ -175,35 +253,57 @@ int Engine<T, TDeviceType>::Init()
     return 0;
 }
 
+template <class T, class TDeviceType> requires std::is_base_of_v<Device, TDeviceType>
+void Engine<T, TDeviceType>::InitCoreModules()
+{
+    // Already registered by the tests when they initialise the whole engine afterwards
+    if (modules.template IsRegistered<FrameArena>())
+        return;
+
+    // Scratch memory for the data of a frame
+    modules.RegisterModule<FrameArena>();
+    LOG("Frame arena initialised");
+
+    // Job system shared by the engine's parallel updates
+    modules.RegisterModule<ThreadPool>();
+    LOG("Job system initialised");
+
+    // Entities own a node from their construction on
+    modules.RegisterModule<TransformHierarchy>();
+}
+
 template <class T, class TDeviceType> requires std::is_base_of_v<Device, TDeviceType>
 void Engine<T, TDeviceType>::Update()
 {
     static InputModule& inputs = InputModule::GetInstance();
 
-    inputs.Controller.DiscoverControllers();
-    
     static auto& cameraManager = modules.Get<CameraManager>();
     static auto& physicsModule = modules.Get<PhysicsModule>();
     static auto& audioModule = modules.Get<DirectX::AudioEngine>();
     static auto& rendererModule = modules.Get<RendererModule>();
     static auto& gameManager = modules.Get<GameManager>();
+    static auto& textureStreamer = modules.Get<TextureStreamer>();
+    static auto& assetHotReload = modules.Get<AssetHotReload>();
+    static auto& frameArena = modules.Get<FrameArena>();
 
     // Get elapsed time since previous frame
     const int64_t currentTime = GetTimeSpecific();
     if (const double dt = GetTimeIntervalsInSec(prevTime, currentTime))
     {
         frameDelta = static_cast<float>(dt);
-        // Prepare next image
-        renderDevice->Present();
-        // On rend l'image sur la surface de travail
-        // (tampon d'arrière plan)
+        MemoryTracker::BeginFrame();
+        frameArena.BeginFrame();
+
         inputs.PreUpdate();
 
-        if (!audioModule.Update())
         {
-            if (audioModule.IsCriticalError())
+            MemoryTagScope tag{MemoryTag::AUDIO};
+            if (!audioModule.Update())
             {
-                LOG(Logger::FATAL, "Audio engine was unable to be updated...");
+                if (audioModule.IsCriticalError())
+                {
+                    LOG(Logger::FATAL, "Audio engine was unable to be updated...");
+                }
             }
         }
         
@@ -218,8 +318,14 @@ void Engine<T, TDeviceType>::Update()
         {
             if (!isPaused)
             {
-                physicsModule.Update(frameDelta);
-                scene->Update(frameDelta);
+                {
+                    MemoryTagScope tag{MemoryTag::PHYSICS};
+                    physicsModule.Update(frameDelta);
+                }
+                {
+                    MemoryTagScope tag{MemoryTag::ENTITIES};
+                    scene->Update(frameDelta);
+                }
                 rendererModule.Update(frameDelta);
                 if (Camera* controlledCamera = cameraManager.GetControlledCamera(); controlledCamera)
                 {
@@ -229,9 +335,17 @@ void Engine<T, TDeviceType>::Update()
             }
             
             gameManager.Update(frameDelta);
+            // Before the streamer, which streams the reloaded textures back in
+            assetHotReload.Update(frameDelta);
+            // Uses the texture resolutions requested while drawing the previous frame
+            textureStreamer.Update();
+            MemoryTagScope tag{MemoryTag::RENDER};
             rendererModule.Render(scene.get());
         }
 
+        // As soon as it is drawn, the pacer sleeps before the next frame rather than holding this one back
+        renderDevice->Present();
+
         scene->CleanupRemoveEntity();
         inputs.PostUpdate();
 
@@ -282,10 +396,17 @@ template <class T, class TDeviceType> requires std::is_base_of_v<Device, TDevice
 void Engine<T, TDeviceType>::Cleanup()
 {
     if (scene)
+    {
         scene->Cleanup();
+        // Entities own nodes of the transform hierarchy, so they must go before the modules do
+        scene.reset();
+    }
 
-    static auto& audioModule = modules.Get<DirectX::AudioEngine>();
-    audioModule.Suspend();
+    // Not created unless Init completed
+    if (isInitialized)
+        modules.Get<DirectX::AudioEngine>().Suspend();
+
+    InputModule::GetInstance().Controller.StopSampling();
 
     renderDevice.reset();
 }
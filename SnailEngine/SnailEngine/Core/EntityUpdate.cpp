@@ -0,0 +1,130 @@
+#include "stdafx.h"
+#include "EntityUpdate.h"
+
+#include "Scene.h"
+#include "ThreadPool.h"
+#include "Core/WindowsEngine.h"
+#include "Core/Memory/FrameArena.h"
+#include "Entities/Entity.h"
+
+namespace Snail
+{
+
+thread_local SceneCommandBuffer* SceneCommandBuffer::recording = nullptr;
+
+void SceneCommandBuffer::RemoveEntity(Entity* entity)
+{
+    removedEntities.push_back(entity);
+}
+
+void SceneCommandBuffer::SetLightPosition(const LightHandle light, const Vector3& position)
+{
+    lightPositions.emplace_back(light, position);
+}
+
+void SceneCommandBuffer::DrawLine(const RendererModule::DebugLine& startLine, const RendererModule::DebugLine& endLine)
+{
+    debugLines.emplace_back(startLine, endLine);
+}
+
+void SceneCommandBuffer::SetLocalTransform(const TransformHierarchy::NodeHandle node, const Transform& local)
+{
+    localTransforms.emplace_back(node, local);
+}
+
+void SceneCommandBuffer::SetPhysicsTransform(const Entity* entity, const Transform& transform)
+{
+    physicsTransforms.emplace_back(entity, transform);
+}
+
+void SceneCommandBuffer::ApplyTransforms() const
+{
+    static TransformHierarchy& hierarchy = WindowsEngine::GetModule<TransformHierarchy>();
+    assert(!recording && "Command buffers must be executed outside of the parallel update");
+
+    for (const auto& [node, local] : localTransforms)
+        hierarchy.SetLocalTransform(node, local);
+
+    for (const auto& [entity, transform] : physicsTransforms)
+        entity->SetPhysicsTransform(transform);
+}
+
+void SceneCommandBuffer::Execute(Scene& scene, RendererModule& renderer) const
+{
+    assert(!recording && "Command buffers must be executed outside of the parallel update");
+
+    ApplyTransforms();
+
+    for (Entity* entity : removedEntities)
+        scene.RemoveEntity(entity);
+
+    for (const auto& [light, position] : lightPositions)
+        scene.GetLights().SetPosition(light, position);
+
+    for (const auto& [startLine, endLine] : debugLines)
+        renderer.DrawLine(startLine, endLine);
+}
+
+void SceneCommandBuffer::Clear() noexcept
+{
+    removedEntities.clear();
+    lightPositions.clear();
+    debugLines.clear();
+    localTransforms.clear();
+    physicsTransforms.clear();
+}
+
+size_t SceneCommandBuffer::GetCommandCount() const noexcept
+{
+    return removedEntities.size() + lightPositions.size() + debugLines.size() + localTransforms.size() + physicsTransforms.size();
+}
+
+SceneCommandBuffer* SceneCommandBuffer::GetRecording() noexcept
+{
+    return recording;
+}
+
+SceneCommandBuffer::ScopedRecording::ScopedRecording(SceneCommandBuffer& buffer) noexcept
+    : previous{recording}
+{
+    recording = &buffer;
+}
+
+SceneCommandBuffer::ScopedRecording::~ScopedRecording()
+{
+    recording = previous;
+}
+
+void UpdateEntitiesInParallel(const std::span<Entity* const> entities, const float dt, ThreadPool& pool, size_t jobCount,
+    std::vector<SceneCommandBuffer>& commandBuffers)
+{
+    jobCount = std::clamp(entities.size() / MIN_ENTITIES_PER_UPDATE_JOB, size_t{1}, std::max(jobCount, size_t{1}));
+
+    // Buffers are reused from frame to frame to keep their capacity
+    commandBuffers.resize(jobCount);
+    for (SceneCommandBuffer& commandBuffer : commandBuffers)
+        commandBuffer.Clear();
+
+    const size_t batchSize = (entities.size() + jobCount - 1) / jobCount;
+
+    static FrameArena& frameArena = WindowsEngine::GetModule<FrameArena>();
+    FrameVector<ThreadPool::TaskHandle> handles{frameArena};
+    handles.reserve(jobCount);
+    for (size_t job = 0; job < jobCount; ++job)
+    {
+        const size_t begin = std::min(job * batchSize, entities.size());
+        const size_t end = std::min(begin + batchSize, entities.size());
+
+        handles.push_back(pool.AddWaitableTask([batch = entities.subspan(begin, end - begin), dt, &commandBuffer = commandBuffers[job]]
+        {
+            SceneCommandBuffer::ScopedRecording recording{commandBuffer};
+            for (Entity* entity : batch)
+                entity->Update(dt);
+        }));
+    }
+
+    for (const ThreadPool::TaskHandle& handle : handles)
+        pool.WaitFor(handle);
+}
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <span>
+#include <vector>
+
+#include "RendererModule.h"
+#include "Core/Math/TransformHierarchy.h"
+#include "Rendering/Lights/LightManager.h"
+
+namespace Snail
+{
+class Entity;
+class Scene;
+class ThreadPool;
+
+// Writes to shared state made by entities while they are updated off the main thread.
+// They are recorded here instead of being applied, then executed on the main thread at the sync point.
+class SceneCommandBuffer
+{
+    static thread_local SceneCommandBuffer* recording;
+
+public:
+    std::vector<Entity*> removedEntities;
+    std::vector<std::pair<LightHandle, Vector3>> lightPositions;
+    std::vector<std::pair<RendererModule::DebugLine, RendererModule::DebugLine>> debugLines;
+    // The hierarchy and PhysX stay read only during the parallel update, world matrices read there are the previous ones
+    std::vector<std::pair<TransformHierarchy::NodeHandle, Transform>> localTransforms;
+    std::vector<std::pair<const Entity*, Transform>> physicsTransforms;
+
+    void RemoveEntity(Entity* entity);
+    void SetLightPosition(LightHandle light, const Vector3& position);
+    void DrawLine(const RendererModule::DebugLine& startLine, const RendererModule::DebugLine& endLine);
+    void SetLocalTransform(TransformHierarchy::NodeHandle node, const Transform& local);
+    void SetPhysicsTransform(const Entity* entity, const Transform& transform);
+
+    // Writes the recorded transforms, before the other commands since removed entities are only destroyed later
+    void ApplyTransforms() const;
+    void Execute(Scene& scene, RendererModule& renderer) const;
+    void Clear() noexcept;
+    [[nodiscard]] size_t GetCommandCount() const noexcept;
+
+    // Buffer commands of the current thread are recorded into, null outside of the parallel update
+    [[nodiscard]] static SceneCommandBuffer* GetRecording() noexcept;
+
+    class ScopedRecording
+    {
+        SceneCommandBuffer* previous;
+
+    public:
+        ScopedRecording(SceneCommandBuffer& buffer) noexcept;
+        ScopedRecording(const ScopedRecording&) = delete;
+        ScopedRecording& operator=(const ScopedRecording&) = delete;
+        ~ScopedRecording();
+    };
+};
+
+// Below this many entities per job, scheduling costs more than the updates themselves
+inline constexpr size_t MIN_ENTITIES_PER_UPDATE_JOB = 16;
+
+// Updates the entities in contiguous batches, one job per batch, and waits for all of them.
+// Every batch records into its own command buffer, so executing the buffers in order
+// gives the same result as updating the entities one after the other.
+void UpdateEntitiesInParallel(std::span<Entity* const> entities, float dt, ThreadPool& pool, size_t jobCount,
+    std::vector<SceneCommandBuffer>& commandBuffers);
+
+}
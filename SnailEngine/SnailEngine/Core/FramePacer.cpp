@@ -0,0 +1,106 @@
+#include "stdafx.h"
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace Snail
+{
+
+FramePacer::FramePacer(PacingClock& pacingClock)
+    : clock(pacingClock)
+{
+}
+
+double FramePacer::ToSeconds(const int64_t counts) const noexcept
+{
+    return static_cast<double>(counts) * clock.GetSecPerCount();
+}
+
+void FramePacer::WaitForNextFrame(const bool inMenu)
+{
+    int64_t now = clock.GetTimeCount();
+    if (!hasStarted)
+    {
+        frameStart = now;
+        hasStarted = true;
+        return;
+    }
+
+    stats.sleepMs = 0;
+    stats.spinMs = 0;
+    if (const float fps = inMenu ? settings.menuFps : settings.targetFps; settings.isEnabled && fps > 0)
+    {
+        const double period = 1.0 / fps;
+        if (const double remaining = period - ToSeconds(now - frameStart); remaining > spinMargin)
+        {
+            const double requested = remaining - spinMargin;
+            clock.SleepFor(requested);
+            const int64_t wokenUp = clock.GetTimeCount();
+            const double slept = ToSeconds(wokenUp - now);
+            stats.sleepMs = static_cast<float>(slept * 1000.0);
+            now = wokenUp;
+
+            // Covers the last late wake up, shrinks back slowly after it
+            spinMargin = std::clamp(std::max(slept - requested + MIN_SPIN_SECONDS, spinMargin * SPIN_MARGIN_DECAY), MIN_SPIN_SECONDS, MAX_SPIN_SECONDS);
+        }
+
+        const int64_t deadline = frameStart + std::llround(period / clock.GetSecPerCount());
+        const int64_t spinStart = now;
+        while (now < deadline)
+        {
+            clock.SpinWait();
+            now = clock.GetTimeCount();
+        }
+        stats.spinMs = static_cast<float>(ToSeconds(now - spinStart) * 1000.0);
+    }
+
+    Record(static_cast<float>(ToSeconds(now - frameStart) * 1000.0));
+    frameStart = now;
+}
+
+void FramePacer::Record(const float ms)
+{
+    frameMs[stats.totalFrameCount % HISTORY_SIZE] = ms;
+    historyCount = std::min(historyCount + 1, HISTORY_SIZE);
+    ++stats.totalFrameCount;
+
+    std::array<float, HISTORY_SIZE> sorted;
+    const auto sortedEnd = std::copy_n(frameMs.begin(), historyCount, sorted.begin());
+    std::sort(sorted.begin(), sortedEnd);
+
+    // Nearest rank
+    const auto percentile = [&sorted, this](const double fraction)
+    {
+        const auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(historyCount)));
+        return sorted[std::max(rank, size_t{1}) - 1];
+    };
+    stats.p50Ms = percentile(0.50);
+    stats.p95Ms = percentile(0.95);
+    stats.p99Ms = percentile(0.99);
+    stats.maxMs = sorted[historyCount - 1];
+
+    const float hitchMs = stats.p50Ms * settings.hitchFactor;
+    stats.hitchCount = static_cast<size_t>(sortedEnd - std::upper_bound(sorted.begin(), sortedEnd, hitchMs));
+    if (ms > hitchMs)
+        ++stats.totalHitchCount;
+}
+
+#ifdef _IMGUI_
+void FramePacer::RenderImGui()
+{
+    ImGui::Text("FPS: %.1f", stats.p50Ms > 0 ? 1000.0f / stats.p50Ms : 0.0f);
+    ImGui::Text("Frame time p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms", stats.p50Ms, stats.p95Ms, stats.p99Ms, stats.maxMs);
+    ImGui::Text("Hitches: %zu in the last %zu frames, %zu in total", stats.hitchCount, historyCount, stats.totalHitchCount);
+    ImGui::Text("Slept %.2f ms, spun %.3f ms, spin margin %.3f ms", stats.sleepMs, stats.spinMs, spinMargin * 1000.0);
+
+    ImGui::Checkbox("Frame pacing", &settings.isEnabled);
+    ImGui::SliderFloat("Target FPS (0 uncapped)", &settings.targetFps, 0, 360, "%.0f");
+    ImGui::SliderFloat("Menu FPS (0 uncapped)", &settings.menuFps, 0, 360, "%.0f");
+    if (int framesInFlight = static_cast<int>(settings.maxFramesInFlight); ImGui::SliderInt("Max frames in flight", &framesInFlight, 1, 16))
+        settings.maxFramesInFlight = static_cast<uint32_t>(framesInFlight);
+}
+#endif
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace Snail
+{
+
+// What the frame pacer reads the time from and sleeps on. A fake one makes the pacing deterministic.
+class PacingClock
+{
+public:
+    virtual ~PacingClock() = default;
+
+    virtual int64_t GetTimeCount() const = 0;
+    virtual double GetSecPerCount() const noexcept = 0;
+    // Blocks for about that long, waking up late rather than early
+    virtual void SleepFor(double seconds) = 0;
+    // One iteration of a busy wait
+    virtual void SpinWait() noexcept {}
+};
+
+// Caps the frame rate, with a lower cap in menus and while paused, and keeps rolling frame time statistics.
+// The pacer sleeps until the frame is due minus a spin margin, then busy waits the rest of the way. The margin
+// follows how late the sleeps wake up, so the deadline is met without spinning for most of the frame.
+class FramePacer
+{
+public:
+    static constexpr size_t HISTORY_SIZE = 256;
+    static constexpr double MIN_SPIN_SECONDS = 0.0002;
+    static constexpr double MAX_SPIN_SECONDS = 0.004;
+    // How fast the spin margin shrinks back after a late wake up, per frame
+    static constexpr double SPIN_MARGIN_DECAY = 0.98;
+
+    struct Settings
+    {
+        bool isEnabled = true;
+        // 0 leaves the frame rate uncapped
+        float targetFps = 0;
+        // In menus, while paused and while loading
+        float menuFps = 60;
+        // Frames the GPU may queue behind the CPU, applied to the device by the engine
+        uint32_t maxFramesInFlight = 2;
+        // Frames longer than this many times the median are hitches
+        float hitchFactor = 2.0f;
+    };
+
+    // Over the last HISTORY_SIZE frames, except the totals
+    struct Stats
+    {
+        float p50Ms = 0;
+        float p95Ms = 0;
+        float p99Ms = 0;
+        float maxMs = 0;
+        size_t hitchCount = 0;
+        size_t totalHitchCount = 0;
+        size_t totalFrameCount = 0;
+        // Of the last frame
+        float sleepMs = 0;
+        float spinMs = 0;
+    };
+
+private:
+    PacingClock& clock;
+    Settings settings;
+    Stats stats;
+
+    int64_t frameStart = 0;
+    bool hasStarted = false;
+    double spinMargin = MAX_SPIN_SECONDS;
+
+    std::array<float, HISTORY_SIZE> frameMs{};
+    size_t historyCount = 0;
+
+    double ToSeconds(int64_t counts) const noexcept;
+    void Record(float ms);
+
+public:
+    explicit FramePacer(PacingClock& pacingClock);
+
+    // Returns once the next frame is due, at the menu rate when inMenu. Once per frame, before reading the inputs.
+    void WaitForNextFrame(bool inMenu);
+
+    Settings& GetSettings() noexcept { return settings; }
+    const Stats& GetStats() const noexcept { return stats; }
+    double GetSpinMargin() const noexcept { return spinMargin; }
+
+#ifdef _IMGUI_
+    void RenderImGui();
+#endif
+};
+
+}
@@ -2,60 +2,71 @@
 #include "Controller.h"
 
 #include <algorithm>
+#include <chrono>
 #include <limits>
 
 namespace Snail
 {
-void ControllerManager::DiscoverControllers()
+void ControllerManager::StartSampling(std::unique_ptr<ControllerSource> source, const InputSampler::Settings& settings)
 {
-	for (int i = 0; i < XUSER_MAX_COUNT; ++i)
-	{
-		if (auto input = GetXInputGamepad(i); input)
-		{
-			if (!Controllers[i])
-			{
-                //LOGF("Controller connected at slot {}", i);
-				Controllers[i] = Controller{};
-			}
-			Controllers[i]->SetState(*input);
-		}
-		else
-		{
-            //LOGF("Controller disconnected at slot {}", i);
-			Controllers[i] = {};
-		}
-	}
+	StopSampling();
+	Sampler = std::make_unique<InputSampler>(std::move(source), settings);
+}
+
+void ControllerManager::StopSampling()
+{
+	Sampler.reset();
+	for (std::optional<Controller>& controller : Controllers)
+		controller.reset();
 }
 
 void ControllerManager::Update()
 {
-	for (int i = 0; i < XUSER_MAX_COUNT; ++i)
+	using Clock = std::chrono::high_resolution_clock;
+
+	const auto start = Clock::now();
+	for (std::optional<Controller>& controller : Controllers)
 	{
-		if (Controllers[i]) {
-			if (auto input = GetXInputGamepad(i); input) {
-				Controllers[i]->SetState(*input);
-			}
-			else {
-				Controllers[i] = {};
-			}
+		if (controller)
+			controller->BeginFrame();
+	}
+
+	LastEventCount = 0;
+	ControllerEvent event;
+	while (Sampler && Sampler->Pop(event))
+	{
+		++LastEventCount;
+		std::optional<Controller>& controller = Controllers[event.slot];
+		if (!event.isConnected)
+		{
+			//LOGF("Controller disconnected at slot {}", event.slot);
+			controller.reset();
+			continue;
+		}
+
+		if (!controller)
+		{
+			//LOGF("Controller connected at slot {}", event.slot);
+			controller = Controller{};
 		}
+		controller->SetState(event.state);
 	}
+	LastUpdateUs = std::chrono::duration<float, std::micro>(Clock::now() - start).count();
 }
 
 const Controller* ControllerManager::GetController(int controllerId)
 {
-	if (controllerId < 0 || controllerId > Controllers.size())
+	if (controllerId < 0 || controllerId >= static_cast<int>(Controllers.size()))
 		return nullptr;
 
-	std::ranges::partition(Controllers, [](const std::optional<Controller>& cont1) {
-		return cont1.has_value();
-	});
-
-	const auto& val = Controllers[controllerId];
-	if (!val)
-		return nullptr;
+	// Counts the active controllers only, without moving them out of the slots the sampler reports
+	for (const std::optional<Controller>& controller : Controllers)
+	{
+		if (controller && controllerId-- == 0)
+			return &*controller;
+	}
 
-	return &*val;
+	return nullptr;
 }
 
 const Controller* ControllerManager::GetFirstActiveController()
@@ -70,6 +81,25 @@ const Controller* ControllerManager::GetFirstActiveController()
 	return &**it;
 }
 
+void ControllerManager::RenderImGui()
+{
+#ifdef _IMGUI_
+	if (ImGui::CollapsingHeader("Input"))
+	{
+		if (Sampler)
+		{
+			const InputSampler::Stats stats = Sampler->GetStats();
+			const float sampleHz = 1e6f / static_cast<float>(Sampler->GetSettings().sampleInterval.count());
+			ImGui::Text("Sampling at %.0f Hz: %llu samples, %llu events, ring full %llu times", sampleHz, stats.sampleCount, stats.eventCount, stats.fullCount);
+			ImGui::Text("Polls of connected slots: %llu, probes of empty slots: %llu", stats.pollCount, stats.probeCount);
+		}
+		for (int slot = 0; slot < XUSER_MAX_COUNT; ++slot)
+			ImGui::Text("Slot %d: %s", slot, Controllers[slot] ? "connected" : "empty");
+		ImGui::Text("Main thread: %.1f us for %zu events last frame", LastUpdateUs, LastEventCount);
+	}
+#endif
+}
+
 DirectX::XMFLOAT2 Controller::GetLeftJoystick() const
 {
 	return {
@@ -98,7 +128,17 @@ float Controller::GetRightTrigger() const
 
 bool Controller::IsPressed(Buttons button) const
 {
-	return IsDown(GamepadState, button) && !IsDown(PrevGamepadState, button);
+	return PressCounts[static_cast<size_t>(button)] > 0;
+}
+
+int Controller::GetPressCount(Buttons button) const
+{
+	return PressCounts[static_cast<size_t>(button)];
+}
+
+int Controller::GetReleaseCount(Buttons button) const
+{
+	return ReleaseCounts[static_cast<size_t>(button)];
 }
 
 bool Controller::IsDown(Buttons button) const
@@ -108,7 +148,7 @@ bool Controller::IsDown(Buttons button) const
 
 bool Controller::IsUp(Buttons button) const
 {
-	return !IsDown(GamepadState, button) && IsDown(PrevGamepadState, button);
+	return ReleaseCounts[static_cast<size_t>(button)] > 0;
 }
 
 bool Controller::IsNeutral() const
@@ -117,19 +157,24 @@ bool Controller::IsNeutral() const
 	return memcmp(&GamepadState, &idle, sizeof(XINPUT_GAMEPAD));
 }
 
-std::optional<XINPUT_GAMEPAD> ControllerManager::GetXInputGamepad(int id)
+void Controller::BeginFrame()
 {
-	XINPUT_STATE GamepadState;
-	ZeroMemory(&GamepadState, sizeof(XINPUT_STATE));
-	if (XInputGetState(id, &GamepadState) == ERROR_SUCCESS)
-		return GamepadState.Gamepad;
-
-	return {};
+	PressCounts.fill(0);
+	ReleaseCounts.fill(0);
 }
 
 void Controller::SetState(const XINPUT_GAMEPAD& state)
 {
-	PrevGamepadState = GamepadState;
+	for (size_t i = 0; i < PressCounts.size(); ++i)
+	{
+		const Buttons button = static_cast<Buttons>(i);
+		const bool wasDown = IsDown(GamepadState, button);
+		const bool isDown = IsDown(state, button);
+		if (isDown && !wasDown)
+			++PressCounts[i];
+		if (wasDown && !isDown)
+			++ReleaseCounts[i];
+	}
 	GamepadState = state;
 }
 
@@ -151,6 +196,7 @@ bool Controller::IsDown(const XINPUT_GAMEPAD& state, Buttons button) const
 	case Buttons::LT: return state.bLeftTrigger > 0;
 	case Buttons::START: return state.wButtons & XINPUT_GAMEPAD_START;
 	case Buttons::SELECT: return state.wButtons & XINPUT_GAMEPAD_BACK;
+	case Buttons::COUNT: break;
 	}
 
 	return false;
@@ -1,10 +1,12 @@
 #pragma once
 #include <optional>
 #include <array>
+#include <memory>
 
 #include "Util/Singleton.h"
 
 #include "Xinput.h"
+#include "InputSampler.h"
 
 namespace Snail
 {
@@ -18,13 +20,18 @@ public:
 		A, B, X, Y,
 		D_UP, D_DOWN, D_LEFT, D_RIGHT,
 		RB, RT, LB, LT,
-		START, SELECT
+		START, SELECT,
+		COUNT
 	};
 private:
 	friend ControllerManager;
 
-	XINPUT_GAMEPAD PrevGamepadState;
-	XINPUT_GAMEPAD GamepadState;
+	XINPUT_GAMEPAD GamepadState{};
+	// Times each button went down and up since the start of the frame, a tap shorter than a frame counts in both
+	std::array<uint16_t, static_cast<size_t>(Buttons::COUNT)> PressCounts{};
+	std::array<uint16_t, static_cast<size_t>(Buttons::COUNT)> ReleaseCounts{};
+
+	void BeginFrame();
 	void SetState(const XINPUT_GAMEPAD& state);
 
 	bool IsDown(const XINPUT_GAMEPAD& state, Buttons button) const;
@@ -44,6 +51,9 @@ public:
 	float GetRightTrigger() const;
 
 	bool IsPressed(Buttons button) const;
+	// Taps faster than the frame rate all count
+	int GetPressCount(Buttons button) const;
+	int GetReleaseCount(Buttons button) const;
 	bool IsDown(Buttons button) const;
 	bool IsUp(Buttons button) const;
 	bool IsNeutral() const;
@@ -52,13 +62,26 @@ public:
 class ControllerManager : public Singleton<ControllerManager>
 {
 	std::array<std::optional<Controller>, XUSER_MAX_COUNT> Controllers{ };
-	std::optional<XINPUT_GAMEPAD> GetXInputGamepad(int id);
+	std::unique_ptr<InputSampler> Sampler;
+
+	// Main thread cost of the last Update
+	float LastUpdateUs = 0;
+	size_t LastEventCount = 0;
 public:
-	void DiscoverControllers();
+	// Starts polling the controllers on the sampling thread, Update applies what it sampled
+	void StartSampling(std::unique_ptr<ControllerSource> source, const InputSampler::Settings& settings = InputSampler::DEFAULT_SETTINGS);
+	void StopSampling();
+	// Applies every change sampled since the last frame, in order
 	void Update();
 
 	const Controller* GetController(int controllerId);
 	const Controller* GetFirstActiveController();
+
+	// Null until StartSampling
+	const InputSampler* GetSampler() const { return Sampler.get(); }
+
+	// Sampler stats and input cost
+	void RenderImGui();
 };
 
 }
@@ -0,0 +1,49 @@
+#include "stdafx.h"
+#include "ControllerSource.h"
+
+#include <algorithm>
+
+namespace Snail
+{
+
+std::optional<XINPUT_GAMEPAD> XInputControllerSource::GetState(const int slot)
+{
+    XINPUT_STATE state;
+    ZeroMemory(&state, sizeof(XINPUT_STATE));
+    if (XInputGetState(slot, &state) == ERROR_SUCCESS)
+        return state.Gamepad;
+
+    return {};
+}
+
+void ScriptedControllerSource::SetScript(const int slot, std::vector<std::optional<XINPUT_GAMEPAD>> states)
+{
+    std::lock_guard lock{mutex};
+    scripts[slot] = std::move(states);
+    pollCounts[slot] = 0;
+}
+
+std::optional<XINPUT_GAMEPAD> ScriptedControllerSource::GetState(const int slot)
+{
+    std::lock_guard lock{mutex};
+    const std::vector<std::optional<XINPUT_GAMEPAD>>& script = scripts[slot];
+    const size_t poll = pollCounts[slot]++;
+    if (script.empty())
+        return {};
+
+    return script[std::min(poll, script.size() - 1)];
+}
+
+size_t ScriptedControllerSource::GetPollCount(const int slot)
+{
+    std::lock_guard lock{mutex};
+    return pollCounts[slot];
+}
+
+bool ScriptedControllerSource::IsFinished(const int slot)
+{
+    std::lock_guard lock{mutex};
+    return pollCounts[slot] >= scripts[slot].size();
+}
+
+}
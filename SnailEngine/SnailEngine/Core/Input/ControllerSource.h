@@ -0,0 +1,45 @@
+#pragma once
+#include <optional>
+
+#include "Xinput.h"
+
+#include <array>
+#include <mutex>
+#include <vector>
+
+namespace Snail
+{
+
+// Where the controller states come from, the input sampler polls it from its own thread
+class ControllerSource
+{
+public:
+    virtual ~ControllerSource() = default;
+
+    // Empty when no controller is plugged in the slot
+    virtual std::optional<XINPUT_GAMEPAD> GetState(int slot) = 0;
+};
+
+class XInputControllerSource final : public ControllerSource
+{
+public:
+    std::optional<XINPUT_GAMEPAD> GetState(int slot) override;
+};
+
+// Plays a list of states per slot, one per poll, then keeps returning the last one. Slots without a script are empty.
+class ScriptedControllerSource final : public ControllerSource
+{
+    std::mutex mutex;
+    std::array<std::vector<std::optional<XINPUT_GAMEPAD>>, XUSER_MAX_COUNT> scripts;
+    std::array<size_t, XUSER_MAX_COUNT> pollCounts{};
+
+public:
+    void SetScript(int slot, std::vector<std::optional<XINPUT_GAMEPAD>> states);
+    std::optional<XINPUT_GAMEPAD> GetState(int slot) override;
+
+    size_t GetPollCount(int slot);
+    // Once every state of the script was returned
+    bool IsFinished(int slot);
+};
+
+}
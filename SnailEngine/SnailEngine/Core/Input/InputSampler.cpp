@@ -0,0 +1,120 @@
+#include "stdafx.h"
+#include "InputSampler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <timeapi.h>
+
+namespace Snail
+{
+
+InputSampler::InputSampler(std::unique_ptr<ControllerSource> controllerSource, const Settings& samplerSettings)
+    : source{std::move(controllerSource)}
+    , settings{samplerSettings}
+    , thread{[this] { Run(); }}
+{}
+
+InputSampler::~InputSampler()
+{
+    shouldStop = true;
+    thread.join();
+}
+
+void InputSampler::Run()
+{
+    // The default timer resolution would sleep for a whole scheduler tick between samples
+    timeBeginPeriod(1);
+
+    for (SlotState& slot : slots)
+        slot.probeInterval = settings.minProbeInterval;
+
+    Clock::time_point nextSample = Clock::now();
+    while (!shouldStop)
+    {
+        const Clock::time_point now = Clock::now();
+        for (int slot = 0; slot < XUSER_MAX_COUNT; ++slot)
+            SampleSlot(slot, now);
+        ++sampleCount;
+
+        // Skips the samples it was too late for instead of catching up
+        nextSample = std::max(nextSample + settings.sampleInterval, now);
+        std::this_thread::sleep_until(nextSample);
+    }
+
+    timeEndPeriod(1);
+}
+
+void InputSampler::SampleSlot(const int slot, const Clock::time_point now)
+{
+    SlotState& slotState = slots[slot];
+    if (!slotState.isConnected)
+    {
+        if (now < slotState.nextProbe)
+            return;
+
+        ++probeCount;
+        const std::optional<XINPUT_GAMEPAD> state = source->GetState(slot);
+        if (!state)
+        {
+            slotState.nextProbe = now + slotState.probeInterval;
+            slotState.probeInterval = std::min(slotState.probeInterval * 2, settings.maxProbeInterval);
+            return;
+        }
+
+        // Probed again on the next sample when the ring is full
+        if (Publish(slot, now, &*state))
+        {
+            slotState.isConnected = true;
+            slotState.lastState = *state;
+        }
+        return;
+    }
+
+    ++pollCount;
+    const std::optional<XINPUT_GAMEPAD> state = source->GetState(slot);
+    if (!state)
+    {
+        if (Publish(slot, now, nullptr))
+        {
+            slotState.isConnected = false;
+            // Plugged back soon more often than not
+            slotState.probeInterval = settings.minProbeInterval;
+            slotState.nextProbe = now + slotState.probeInterval;
+        }
+        return;
+    }
+
+    if (std::memcmp(&*state, &slotState.lastState, sizeof(XINPUT_GAMEPAD)) != 0 && Publish(slot, now, &*state))
+        slotState.lastState = *state;
+}
+
+bool InputSampler::Publish(const int slot, const Clock::time_point now, const XINPUT_GAMEPAD* state)
+{
+    ControllerEvent event;
+    event.timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    event.slot = static_cast<uint8_t>(slot);
+    event.isConnected = state != nullptr;
+    if (state)
+        event.state = *state;
+
+    if (!ring.Push(event))
+    {
+        ++fullCount;
+        return false;
+    }
+
+    ++eventCount;
+    return true;
+}
+
+bool InputSampler::Pop(ControllerEvent& event) noexcept
+{
+    return ring.Pop(event);
+}
+
+InputSampler::Stats InputSampler::GetStats() const noexcept
+{
+    return {sampleCount, pollCount, probeCount, eventCount, fullCount};
+}
+
+}
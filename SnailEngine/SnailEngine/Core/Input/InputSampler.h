@@ -0,0 +1,102 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "ControllerSource.h"
+#include "Core/DataStructures/SpscRing.h"
+
+namespace Snail
+{
+
+struct ControllerEvent
+{
+    // Steady clock, in nanoseconds
+    int64_t timeNs = 0;
+    // Zeroed when the controller was disconnected
+    XINPUT_GAMEPAD state{};
+    uint8_t slot = 0;
+    bool isConnected = false;
+};
+
+// Polls the controllers on its own thread, much more often than the frame rate, and queues every change of state in a
+// lock-free ring the main thread drains at the start of the frame. Connected slots are polled every sample, empty
+// slots are probed less and less often since polling an empty XInput slot can stall.
+class InputSampler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Enough for a few seconds of stick motion on every slot
+    static constexpr size_t RING_CAPACITY = 1024;
+
+    struct Settings
+    {
+        std::chrono::microseconds sampleInterval;
+        // Empty slots are probed after this, then twice as late every time they are still empty
+        std::chrono::microseconds minProbeInterval;
+        std::chrono::microseconds maxProbeInterval;
+    };
+
+    static constexpr Settings DEFAULT_SETTINGS{
+        std::chrono::microseconds{1000},
+        std::chrono::milliseconds{100},
+        std::chrono::seconds{2},
+    };
+
+    struct Stats
+    {
+        uint64_t sampleCount = 0;
+        // Polls of connected slots, and of empty ones
+        uint64_t pollCount = 0;
+        uint64_t probeCount = 0;
+        uint64_t eventCount = 0;
+        // Pushes that found the ring full, the change is pushed again on the next sample
+        uint64_t fullCount = 0;
+    };
+
+private:
+    // Only touched by the sampling thread
+    struct SlotState
+    {
+        bool isConnected = false;
+        XINPUT_GAMEPAD lastState{};
+        Clock::time_point nextProbe{};
+        std::chrono::microseconds probeInterval{};
+    };
+
+    std::unique_ptr<ControllerSource> source;
+    Settings settings;
+    SpscRing<ControllerEvent, RING_CAPACITY> ring;
+    std::array<SlotState, XUSER_MAX_COUNT> slots{};
+
+    std::atomic<uint64_t> sampleCount = 0;
+    std::atomic<uint64_t> pollCount = 0;
+    std::atomic<uint64_t> probeCount = 0;
+    std::atomic<uint64_t> eventCount = 0;
+    std::atomic<uint64_t> fullCount = 0;
+    std::atomic_bool shouldStop = false;
+
+    // Last, so that it starts once the rest is initialised
+    std::thread thread;
+
+    void Run();
+    void SampleSlot(int slot, Clock::time_point now);
+    bool Publish(int slot, Clock::time_point now, const XINPUT_GAMEPAD* state);
+
+public:
+    InputSampler(std::unique_ptr<ControllerSource> controllerSource, const Settings& samplerSettings);
+    InputSampler(const InputSampler&) = delete;
+    InputSampler& operator=(const InputSampler&) = delete;
+    ~InputSampler();
+
+    // Main thread only, false once the ring is empty
+    bool Pop(ControllerEvent& event) noexcept;
+
+    Stats GetStats() const noexcept;
+    const Settings& GetSettings() const noexcept { return settings; }
+};
+
+}
@@ -0,0 +1,366 @@
+#include "stdafx.h"
+#include "LevelArchive.h"
+
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace Snail
+{
+
+namespace
+{
+// Builds the sections of an archive in memory, then writes them after the header
+class ArchiveWriter
+{
+    std::array<std::vector<std::byte>, static_cast<size_t>(LevelArchive::Section::COUNT)> sections;
+
+    LevelArchive::Range Append(const LevelArchive::Section section, const void* bytes, const size_t size)
+    {
+        std::vector<std::byte>& buffer = sections[static_cast<size_t>(section)];
+        const LevelArchive::Range range{static_cast<uint32_t>(buffer.size()), static_cast<uint32_t>(size)};
+        buffer.resize(buffer.size() + size);
+        if (size)
+            std::memcpy(buffer.data() + range.offset, bytes, size);
+        return range;
+    }
+
+public:
+    template <class T>
+    void Add(const LevelArchive::Section section, const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Append(section, &value, sizeof(T));
+    }
+
+    LevelArchive::Range AddString(const std::string_view string)
+    {
+        return Append(LevelArchive::Section::STRINGS, string.data(), string.size());
+    }
+
+    LevelArchive::CookedEntityDescription AddDescription(const Entity::Description& description)
+    {
+        LevelArchive::CookedEntityDescription cooked{};
+        cooked.name = AddString(description.name);
+        cooked.mesh = AddString(description.mesh);
+        cooked.transform = description.transform;
+        cooked.occluder = description.occluder;
+        cooked.hasPhysics = description.physics.has_value();
+        if (const std::optional<Entity::PhysicsDescription>& physics = description.physics)
+        {
+            cooked.body = physics->body;
+            cooked.shape = physics->shape;
+            cooked.shapeTransform = physics->shapeTransform;
+            cooked.extents = physics->extents;
+            cooked.radius = physics->radius;
+            cooked.halfHeight = physics->halfHeight;
+            cooked.physicsMesh = AddString(physics->meshName);
+            cooked.layer = AddString(physics->layer);
+        }
+        return cooked;
+    }
+
+    LevelArchive::Range AddParams(const nlohmann::json& params)
+    {
+        const std::vector<uint8_t> bytes = nlohmann::json::to_msgpack(params);
+        return Append(LevelArchive::Section::BLOCKS, bytes.data(), bytes.size());
+    }
+
+    bool Write(const std::filesystem::path& path, LevelArchive::Header header) const
+    {
+        const auto alignUp = [](const size_t offset) { return (offset + LevelArchive::SECTION_ALIGNMENT - 1) & ~(LevelArchive::SECTION_ALIGNMENT - 1); };
+
+        size_t offset = alignUp(sizeof(LevelArchive::Header));
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            header.sections[i] = {static_cast<uint32_t>(offset), static_cast<uint32_t>(sections[i].size())};
+            offset = alignUp(offset + sections[i].size());
+        }
+
+        std::vector<std::byte> bytes(offset);
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            if (!sections[i].empty())
+                std::memcpy(bytes.data() + header.sections[i].offset, sections[i].data(), sections[i].size());
+        }
+
+        std::ofstream file{path, std::ios::binary | std::ios::trunc};
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return file.good();
+    }
+};
+
+std::optional<LevelArchive::Header> GetSourceHeader(const std::filesystem::path& sourcePath)
+{
+    std::error_code error;
+    const uintmax_t size = std::filesystem::file_size(sourcePath, error);
+    if (error)
+        return {};
+    const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(sourcePath, error);
+    if (error)
+        return {};
+
+    LevelArchive::Header header;
+    header.sourceSize = size;
+    header.sourceWriteTime = writeTime.time_since_epoch().count();
+    return header;
+}
+
+std::mutex cookMutex;
+}
+
+LevelArchive::LevelArchive(const std::filesystem::path& archivePath)
+    : file{archivePath}
+{
+    if (file.IsOpen() && !IsValid())
+    {
+        LOGF(Logger::WARN, "Ignoring invalid level archive {}", archivePath.string());
+        file.Close();
+    }
+}
+
+std::span<const std::byte> LevelArchive::GetBytes(const Section section) const noexcept
+{
+    const Range range = GetHeader().sections[static_cast<size_t>(section)];
+    return file.GetData().subspan(range.offset, range.size);
+}
+
+bool LevelArchive::IsValid() const noexcept
+{
+    const std::span<const std::byte> data = file.GetData();
+    if (data.size() < sizeof(Header))
+        return false;
+
+    const Header& header = GetHeader();
+    if (header.magic != MAGIC || header.version != VERSION || header.layoutHash != GetLayoutHash())
+        return false;
+
+    for (const Range range : header.sections)
+    {
+        if (range.offset % SECTION_ALIGNMENT != 0 || range.offset > data.size() || range.size > data.size() - range.offset)
+            return false;
+    }
+    return header.sections[static_cast<size_t>(Section::SETTINGS)].size == sizeof(CookedSettings);
+}
+
+bool LevelArchive::IsUpToDate(const std::filesystem::path& sourcePath) const
+{
+    if (!IsOpen())
+        return false;
+
+    const std::optional<Header> source = GetSourceHeader(sourcePath);
+    return source && source->sourceSize == GetHeader().sourceSize && source->sourceWriteTime == GetHeader().sourceWriteTime;
+}
+
+std::string_view LevelArchive::GetString(const Range range) const noexcept
+{
+    const std::span<const std::byte> strings = GetBytes(Section::STRINGS);
+    if (range.offset > strings.size() || range.size > strings.size() - range.offset)
+        return {};
+    return {reinterpret_cast<const char*>(strings.data()) + range.offset, range.size};
+}
+
+nlohmann::json LevelArchive::GetParams(const Range range) const
+{
+    const std::span<const std::byte> blocks = GetBytes(Section::BLOCKS);
+    if (range.offset > blocks.size() || range.size > blocks.size() - range.offset)
+        return {};
+
+    const auto begin = reinterpret_cast<const uint8_t*>(blocks.data()) + range.offset;
+    return nlohmann::json::from_msgpack(begin, begin + range.size);
+}
+
+Entity::Description LevelArchive::GetDescription(const uint32_t index) const
+{
+    const std::span<const CookedEntityDescription> descriptions = GetSection<CookedEntityDescription>(Section::ENTITY_DESCRIPTIONS);
+    if (index >= descriptions.size())
+        return {};
+
+    const CookedEntityDescription& cooked = descriptions[index];
+    Entity::Description description{std::string{GetString(cooked.name)}, std::string{GetString(cooked.mesh)}, cooked.transform, cooked.occluder};
+    if (cooked.hasPhysics)
+    {
+        description.physics = Entity::PhysicsDescription{
+            cooked.body,
+            cooked.shape,
+            cooked.shapeTransform,
+            cooked.extents,
+            cooked.radius,
+            cooked.halfHeight,
+            std::string{GetString(cooked.physicsMesh)},
+            std::string{GetString(cooked.layer)}};
+    }
+    return description;
+}
+
+uint64_t LevelArchive::GetLayoutHash() noexcept
+{
+    // Every struct read in place, and the counts of the enums indexed by the archive
+    constexpr std::array LAYOUT = {
+        sizeof(Header), alignof(Header),
+        sizeof(CookedSettings), alignof(CookedSettings),
+        sizeof(SceneSettings), alignof(SceneSettings),
+        sizeof(DirectionalLight), alignof(DirectionalLight),
+        sizeof(SpotLight), alignof(SpotLight),
+        sizeof(PointLight), alignof(PointLight),
+        sizeof(SceneCamera), alignof(SceneCamera),
+        sizeof(CookedGrassPatch), alignof(CookedGrassPatch),
+        sizeof(CookedMesh), alignof(CookedMesh),
+        sizeof(CookedEntity), alignof(CookedEntity),
+        sizeof(CookedEntityDescription), alignof(CookedEntityDescription),
+        sizeof(Range), alignof(Range),
+        sizeof(Transform), alignof(Transform),
+        static_cast<size_t>(Section::COUNT),
+        static_cast<size_t>(SceneParser::EntityType::COUNT),
+    };
+
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (const size_t value : LAYOUT)
+    {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::filesystem::path LevelArchive::GetArchivePath(const std::filesystem::path& sourcePath)
+{
+    return std::filesystem::path{sourcePath}.replace_extension(EXTENSION);
+}
+
+bool LevelArchive::Cook(const std::filesystem::path& sourcePath)
+{
+    using namespace nlohmann;
+
+    const std::optional<Header> header = GetSourceHeader(sourcePath);
+    if (!header)
+    {
+        LOGF(Logger::ERROR, "Unable to cook level archive, {} doesn't exist", sourcePath.string());
+        return false;
+    }
+
+    ArchiveWriter writer;
+    try
+    {
+        std::ifstream file{sourcePath};
+        const json sceneJson = json::parse(file, nullptr, true, true);
+
+        CookedSettings settings{SceneParser::ReadSettings(sceneJson)};
+        if (sceneJson.contains("skybox"))
+            settings.skybox = writer.AddParams(sceneJson.at("skybox"));
+        writer.Add(Section::SETTINGS, settings);
+
+        for (const json& light : sceneJson.at("lights"))
+        {
+            const std::string type = light.at("type").get<std::string>();
+            if (type == "directional")
+                writer.Add(Section::DIRECTIONAL_LIGHTS, light.get<DirectionalLight>());
+            if (type == "point")
+                writer.Add(Section::POINT_LIGHTS, light.get<PointLight>());
+            if (type == "spot")
+                writer.Add(Section::SPOT_LIGHTS, light.get<SpotLight>());
+        }
+
+        if (sceneJson.contains("cameras"))
+        {
+            for (const json& camera : sceneJson.at("cameras"))
+                writer.Add(Section::CAMERAS, SceneParser::ReadCamera(camera));
+        }
+
+        if (sceneJson.contains("grass_patches"))
+        {
+            for (const json& grassJson : sceneJson.at("grass_patches"))
+            {
+                const SceneGrassPatch grass = SceneParser::ReadGrass(grassJson);
+                writer.Add(Section::GRASS_PATCHES, CookedGrassPatch{grass.transform, grass.regionCount, grass.density, writer.AddString(grass.sampleTexture)});
+            }
+        }
+
+        for (const json& mesh : sceneJson.at("meshes"))
+        {
+            const Range name = writer.AddString(mesh.at("name").get<std::string>());
+            writer.Add(Section::MESHES, CookedMesh{name, writer.AddParams(mesh), SceneParser::HashMeshDescription(mesh)});
+        }
+
+        uint32_t descriptionCount = 0;
+        for (const json& object : sceneJson.at("objects"))
+        {
+            const std::string type = object.at("type").get<std::string>();
+            const std::optional<SceneParser::EntityType> entityType = SceneParser::GetEntityType(type);
+            if (entityType && SceneParser::IsBuiltFromDescription(*entityType))
+            {
+                // Loaded without decoding any MessagePack
+                writer.Add(Section::ENTITIES, CookedEntity{{}, *entityType, descriptionCount++});
+                writer.Add(Section::ENTITY_DESCRIPTIONS, writer.AddDescription(object.get<Entity::Description>()));
+            }
+            else if (entityType)
+                writer.Add(Section::ENTITIES, CookedEntity{writer.AddParams(object), *entityType});
+            else
+                LOGF(Logger::WARN, "Skipping entity of unknown type {} in {}", type, sourcePath.string());
+        }
+
+        if (sceneJson.contains("decals"))
+        {
+            for (const json& decal : sceneJson.at("decals"))
+                writer.Add(Section::DECALS, writer.AddParams(decal));
+        }
+    }
+    catch (const detail::exception& e)
+    {
+        LOGF(Logger::ERROR, "Unable to cook level archive of {}: {}", sourcePath.string(), e.what());
+        return false;
+    }
+
+    // Written aside then renamed, a load never maps a partial archive
+    const std::filesystem::path archivePath = GetArchivePath(sourcePath);
+    std::filesystem::path temporaryPath = archivePath;
+    temporaryPath += ".tmp";
+    Header archiveHeader = *header;
+    archiveHeader.layoutHash = GetLayoutHash();
+    if (!writer.Write(temporaryPath, archiveHeader))
+    {
+        LOGF(Logger::ERROR, "Unable to write level archive {}", temporaryPath.string());
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, archivePath, error);
+    if (error)
+    {
+        LOGF(Logger::ERROR, "Unable to replace level archive {}: {}", archivePath.string(), error.message());
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+
+    LOGF("Cooked level archive {}", archivePath.string());
+    return true;
+}
+
+std::optional<LevelArchive> LevelArchive::Load(const std::filesystem::path& sourcePath)
+{
+    // Loads and prefetches of the same scene would otherwise cook it twice, or replace an archive the other one mapped
+    std::lock_guard lock{cookMutex};
+
+    const std::filesystem::path archivePath = GetArchivePath(sourcePath);
+    if (LevelArchive archive{archivePath}; archive.IsUpToDate(sourcePath))
+        return archive;
+
+    if (!Cook(sourcePath))
+        return {};
+
+    if (LevelArchive archive{archivePath}; archive.IsUpToDate(sourcePath))
+        return archive;
+    return {};
+}
+
+#ifdef _IMGUI_
+void LevelArchive::RenderImGui()
+{
+    ImGui::Checkbox("Load from level archives", &SceneParser::useLevelArchives);
+}
+#endif
+
+}
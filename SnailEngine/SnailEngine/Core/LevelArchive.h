@@ -0,0 +1,164 @@
+#pragma once
+#include <array>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include "SceneParser.h"
+#include "Util/MappedFile.h"
+
+namespace Snail
+{
+
+// A scene file cooked into sections of plain structs, read in place from a memory mapped file. Offsets are relative to
+// their section so nothing is patched on load. The JSON stays the source, the archive is cooked again when it changes.
+class LevelArchive
+{
+public:
+    // "SNLV"
+    static constexpr uint32_t MAGIC = 0x564C4E53;
+    // Bump when the meaning of a cooked struct or SceneParser::EntityType changes, their sizes are checked by the layout hash
+    static constexpr uint32_t VERSION = 2;
+    static constexpr std::string_view EXTENSION = ".level";
+    static constexpr size_t SECTION_ALIGNMENT = 16;
+
+    enum class Section : uint8_t
+    {
+        SETTINGS,
+        DIRECTIONAL_LIGHTS,
+        SPOT_LIGHTS,
+        POINT_LIGHTS,
+        CAMERAS,
+        GRASS_PATCHES,
+        MESHES,
+        ENTITIES,
+        ENTITY_DESCRIPTIONS,
+        DECALS,
+        // Characters of the strings, not null terminated
+        STRINGS,
+        // MessagePack of the json objects the entities and meshes are built from
+        BLOCKS,
+        COUNT
+    };
+
+    // Bytes of a section, or of the STRINGS and BLOCKS sections for the ranges stored in the other ones
+    struct Range
+    {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    struct Header
+    {
+        uint32_t magic = MAGIC;
+        uint32_t version = VERSION;
+        // GetLayoutHash of the build that cooked the archive
+        uint64_t layoutHash = 0;
+        // Of the JSON the archive was cooked from
+        uint64_t sourceSize = 0;
+        int64_t sourceWriteTime = 0;
+        std::array<Range, static_cast<size_t>(Section::COUNT)> sections;
+    };
+
+    struct CookedSettings
+    {
+        SceneSettings settings;
+        // Empty without a skybox
+        Range skybox;
+    };
+
+    struct CookedGrassPatch
+    {
+        Transform transform;
+        std::array<uint32_t, 2> regionCount;
+        float density;
+        Range sampleTexture;
+    };
+
+    struct CookedMesh
+    {
+        Range name;
+        Range description;
+        // SceneParser::HashMeshDescription, resident meshes are skipped without decoding their description
+        uint64_t sourceHash;
+    };
+
+    // Entity::Description with its strings in the STRINGS section
+    struct CookedEntityDescription
+    {
+        Range name;
+        Range mesh;
+        Transform transform;
+        OccluderType occluder;
+        bool hasPhysics;
+        Entity::PhysicsDescription::Body body;
+        Entity::PhysicsDescription::Shape shape;
+        Transform shapeTransform;
+        Vector3 extents;
+        float radius;
+        float halfHeight;
+        Range physicsMesh;
+        Range layer;
+    };
+
+    struct CookedEntity
+    {
+        static constexpr uint32_t NO_DESCRIPTION = UINT32_MAX;
+
+        // Empty for the types built from a description
+        Range params;
+        SceneParser::EntityType type;
+        // Index in the ENTITY_DESCRIPTIONS section for the types SceneParser::IsBuiltFromDescription
+        uint32_t description = NO_DESCRIPTION;
+    };
+
+private:
+    MappedFile file;
+
+    [[nodiscard]] const Header& GetHeader() const noexcept { return *reinterpret_cast<const Header*>(file.GetData().data()); }
+    [[nodiscard]] std::span<const std::byte> GetBytes(Section section) const noexcept;
+    [[nodiscard]] bool IsValid() const noexcept;
+
+public:
+    LevelArchive() = default;
+    explicit LevelArchive(const std::filesystem::path& archivePath);
+
+    [[nodiscard]] bool IsOpen() const noexcept { return file.IsOpen(); }
+    // Same version, cooked from the current content of the JSON
+    [[nodiscard]] bool IsUpToDate(const std::filesystem::path& sourcePath) const;
+
+    template <class T>
+    [[nodiscard]] std::span<const T> GetSection(Section section) const noexcept;
+    [[nodiscard]] const CookedSettings& GetSettings() const noexcept { return GetSection<CookedSettings>(Section::SETTINGS).front(); }
+    [[nodiscard]] std::string_view GetString(Range range) const noexcept;
+    [[nodiscard]] nlohmann::json GetParams(Range range) const;
+    [[nodiscard]] Entity::Description GetDescription(uint32_t index) const;
+
+    // Of the sizes and alignments of the cooked structs, archives cooked by a build with other ones are invalid
+    [[nodiscard]] static uint64_t GetLayoutHash() noexcept;
+
+    // Next to the scene file
+    static std::filesystem::path GetArchivePath(const std::filesystem::path& sourcePath);
+    // Writes the archive of a scene file, false if it couldn't be parsed or written
+    static bool Cook(const std::filesystem::path& sourcePath);
+    // Opens the archive of a scene file, cooking it first when missing or out of date. Empty if it can't be cooked.
+    static std::optional<LevelArchive> Load(const std::filesystem::path& sourcePath);
+
+#ifdef _IMGUI_
+    static void RenderImGui();
+#endif
+};
+
+template <class T>
+std::span<const T> LevelArchive::GetSection(const Section section) const noexcept
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(alignof(T) <= SECTION_ALIGNMENT);
+
+    const std::span<const std::byte> bytes = GetBytes(section);
+    return {reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T)};
+}
+
+}
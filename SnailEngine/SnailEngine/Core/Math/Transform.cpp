@@ -6,16 +6,6 @@
 namespace Snail
 {
 
-Transform Transform::Combine(const Transform& other) const
-{
-    Matrix combinationMatrix = GetTransformationMatrix() * other.GetTransformationMatrix();
-
-    Transform retTransform;
-    combinationMatrix.Decompose(retTransform.scale, retTransform.rotation, retTransform.position);
-
-    return retTransform;
-}
-
 Matrix Transform::GetTransformationMatrix() const noexcept
 {
     return Matrix::CreateScale(scale) * Matrix::CreateFromQuaternion(rotation) * Matrix::CreateTranslation(position);
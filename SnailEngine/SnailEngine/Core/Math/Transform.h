@@ -18,7 +18,6 @@ struct Transform
     Vector3 scale = Vector3::One; // X, Y, Z
 
     Matrix GetTransformationMatrix() const noexcept;
-    Transform Combine(const Transform& other) const;
 
     Vector3 GetForwardVector() const noexcept;
     Vector3 GetUpVector() const noexcept;
@@ -0,0 +1,459 @@
+#include "stdafx.h"
+#include "TransformHierarchy.h"
+
+#include <atomic>
+#include <emmintrin.h>
+#include <thread>
+
+#include "Core/ThreadPool.h"
+#include "Core/WindowsEngine.h"
+#include "Core/Memory/FrameArena.h"
+
+using namespace DirectX;
+
+namespace Snail
+{
+
+namespace
+{
+// DirectXMath is built without intrinsics (_XM_NO_INTRINSICS_), so the propagation composes the matrices with SSE itself.
+// Rows of XMMatrixAffineTransformation(scale, 0, rotation, position), the rotation part being XMMatrixRotationQuaternion.
+void LoadLocalRows(const Vector3& position, const Quaternion& rotation, const Vector3& scale, __m128 rows[4])
+{
+    const float x2 = rotation.x + rotation.x, y2 = rotation.y + rotation.y, z2 = rotation.z + rotation.z;
+    const float xx = rotation.x * x2, yy = rotation.y * y2, zz = rotation.z * z2;
+    const float xy = rotation.x * y2, xz = rotation.x * z2, yz = rotation.y * z2;
+    const float wx = rotation.w * x2, wy = rotation.w * y2, wz = rotation.w * z2;
+
+    rows[0] = _mm_mul_ps(_mm_setr_ps(1.0f - yy - zz, xy + wz, xz - wy, 0.0f), _mm_set1_ps(scale.x));
+    rows[1] = _mm_mul_ps(_mm_setr_ps(xy - wz, 1.0f - xx - zz, yz + wx, 0.0f), _mm_set1_ps(scale.y));
+    rows[2] = _mm_mul_ps(_mm_setr_ps(xz + wy, yz - wx, 1.0f - xx - yy, 0.0f), _mm_set1_ps(scale.z));
+    rows[3] = _mm_setr_ps(position.x, position.y, position.z, 1.0f);
+}
+
+// Row vector times a matrix, one broadcast multiply-add per parent row
+__m128 TransformRow(const __m128 row, const __m128 parent[4])
+{
+    __m128 result = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), parent[0]);
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), parent[1]));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), parent[2]));
+    return _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), parent[3]));
+}
+
+void LoadRows(const Matrix& matrix, __m128 rows[4])
+{
+    for (int r = 0; r < 4; ++r)
+        rows[r] = _mm_loadu_ps(matrix.m[r]);
+}
+
+void StoreRows(const __m128 rows[4], Matrix& matrix)
+{
+    for (int r = 0; r < 4; ++r)
+        _mm_storeu_ps(matrix.m[r], rows[r]);
+}
+}
+
+uint32_t TransformHierarchy::GetIndex(const NodeHandle node) const
+{
+    const uint32_t* index = nodeIndices.Get(node);
+    assert(index && "Stale transform node");
+    return *index;
+}
+
+bool TransformHierarchy::IsWorldDirty(uint32_t index) const
+{
+    for (; index != NO_PARENT; index = parentIndices[index])
+    {
+        if (dirty[index])
+            return true;
+    }
+    return false;
+}
+
+Matrix TransformHierarchy::ComputeWorldMatrix(const uint32_t index) const
+{
+    if (!IsWorldDirty(index))
+        return worldMatrices[index];
+
+    __m128 local[4];
+    LoadLocalRows(localPositions[index], localRotations[index], localScales[index], local);
+
+    Matrix world;
+    if (const uint32_t parent = parentIndices[index]; parent != NO_PARENT)
+    {
+        __m128 parentRows[4];
+        LoadRows(ComputeWorldMatrix(parent), parentRows);
+        for (__m128& row : local)
+            row = TransformRow(row, parentRows);
+    }
+
+    StoreRows(local, world);
+    return world;
+}
+
+void TransformHierarchy::LinkChild(const uint32_t index, const uint32_t parent)
+{
+    const uint32_t first = firstChildren[parent];
+    nextSiblings[index] = first;
+    previousSiblings[index] = NO_NODE;
+    if (first != NO_NODE)
+        previousSiblings[first] = index;
+    firstChildren[parent] = index;
+}
+
+void TransformHierarchy::UnlinkChild(const uint32_t index)
+{
+    const uint32_t previous = previousSiblings[index];
+    const uint32_t next = nextSiblings[index];
+    if (previous != NO_NODE)
+        nextSiblings[previous] = next;
+    else if (parentIndices[index] != NO_PARENT)
+        firstChildren[parentIndices[index]] = next;
+
+    if (next != NO_NODE)
+        previousSiblings[next] = previous;
+
+    previousSiblings[index] = NO_NODE;
+    nextSiblings[index] = NO_NODE;
+}
+
+TransformHierarchy::NodeHandle TransformHierarchy::CreateNode(const Transform& local, const NodeHandle parent)
+{
+    std::unique_lock _{ hierarchyMutex };
+
+    const auto index = static_cast<uint32_t>(localPositions.size());
+    localPositions.push_back(local.position);
+    localRotations.push_back(local.rotation);
+    localScales.push_back(local.scale);
+    parentIndices.push_back(parent.IsValid() ? GetIndex(parent) : NO_PARENT);
+    worldMatrices.emplace_back();
+    worldVersions.push_back(0);
+    dirty.push_back(true);
+    firstChildren.push_back(NO_NODE);
+    nextSiblings.push_back(NO_NODE);
+    previousSiblings.push_back(NO_NODE);
+    if (parentIndices[index] != NO_PARENT)
+        LinkChild(index, parentIndices[index]);
+
+    const NodeHandle handle = nodeIndices.Insert(index);
+    nodeHandles.push_back(handle);
+
+    // Appending keeps parents before children, but breaks the contiguous root subtrees
+    needsReorder = true;
+    return handle;
+}
+
+void TransformHierarchy::DestroyNode(const NodeHandle node)
+{
+    std::unique_lock _{ hierarchyMutex };
+
+    const uint32_t index = GetIndex(node);
+    const auto last = static_cast<uint32_t>(localPositions.size() - 1);
+
+    // Orphaned children become roots, keeping their local transform
+    for (uint32_t child = firstChildren[index]; child != NO_NODE;)
+    {
+        const uint32_t next = nextSiblings[child];
+        parentIndices[child] = NO_PARENT;
+        previousSiblings[child] = NO_NODE;
+        nextSiblings[child] = NO_NODE;
+        dirty[child] = true;
+        child = next;
+    }
+    firstChildren[index] = NO_NODE;
+    UnlinkChild(index);
+
+    if (index != last)
+    {
+        localPositions[index] = localPositions[last];
+        localRotations[index] = localRotations[last];
+        localScales[index] = localScales[last];
+        parentIndices[index] = parentIndices[last];
+        worldMatrices[index] = worldMatrices[last];
+        worldVersions[index] = worldVersions[last];
+        dirty[index] = dirty[last];
+        nodeHandles[index] = nodeHandles[last];
+        firstChildren[index] = firstChildren[last];
+        nextSiblings[index] = nextSiblings[last];
+        previousSiblings[index] = previousSiblings[last];
+        *nodeIndices.Get(nodeHandles[index]) = index;
+
+        // Links to the moved node
+        if (const uint32_t previous = previousSiblings[index]; previous != NO_NODE)
+            nextSiblings[previous] = index;
+        else if (parentIndices[index] != NO_PARENT)
+            firstChildren[parentIndices[index]] = index;
+        if (const uint32_t next = nextSiblings[index]; next != NO_NODE)
+            previousSiblings[next] = index;
+        for (uint32_t child = firstChildren[index]; child != NO_NODE; child = nextSiblings[child])
+            parentIndices[child] = index;
+    }
+
+    localPositions.pop_back();
+    localRotations.pop_back();
+    localScales.pop_back();
+    parentIndices.pop_back();
+    worldMatrices.pop_back();
+    worldVersions.pop_back();
+    dirty.pop_back();
+    nodeHandles.pop_back();
+    firstChildren.pop_back();
+    nextSiblings.pop_back();
+    previousSiblings.pop_back();
+    nodeIndices.Remove(node);
+
+    needsReorder = true;
+}
+
+void TransformHierarchy::SetParent(const NodeHandle node, const NodeHandle parent)
+{
+    std::unique_lock _{ hierarchyMutex };
+
+    const uint32_t index = GetIndex(node);
+    const uint32_t parentIndex = parent.IsValid() ? GetIndex(parent) : NO_PARENT;
+
+#ifdef _DEBUG
+    for (uint32_t ancestor = parentIndex; ancestor != NO_PARENT; ancestor = parentIndices[ancestor])
+        assert(ancestor != index && "Transform hierarchy cycle");
+#endif
+
+    UnlinkChild(index);
+    parentIndices[index] = parentIndex;
+    if (parentIndex != NO_PARENT)
+        LinkChild(index, parentIndex);
+
+    dirty[index] = true;
+    needsReorder = true;
+}
+
+void TransformHierarchy::SetLocalTransform(const NodeHandle node, const Transform& local)
+{
+    // Exclusive, a reader of a descendant would otherwise see this node half written
+    std::unique_lock _{ hierarchyMutex };
+
+    const uint32_t index = GetIndex(node);
+    localPositions[index] = local.position;
+    localRotations[index] = local.rotation;
+    localScales[index] = local.scale;
+    dirty[index] = true;
+}
+
+Matrix TransformHierarchy::GetWorldMatrix(const NodeHandle node) const
+{
+    std::shared_lock _{ hierarchyMutex };
+    return ComputeWorldMatrix(GetIndex(node));
+}
+
+uint32_t TransformHierarchy::GetWorldVersion(const NodeHandle node) const
+{
+    std::shared_lock _{ hierarchyMutex };
+    const uint32_t index = GetIndex(node);
+    return IsWorldDirty(index) ? 0 : worldVersions[index];
+}
+
+void TransformHierarchy::Reorder()
+{
+    const auto count = static_cast<uint32_t>(localPositions.size());
+
+    // Children of every node, in compressed rows. Built from the parents rather than the child lists, whose order
+    // depends on the edits and would make the order of the nodes depend on it too.
+    std::vector<uint32_t> childOffsets(count + 1, 0);
+    for (const uint32_t parent : parentIndices)
+    {
+        if (parent != NO_PARENT)
+            ++childOffsets[parent + 1];
+    }
+    for (uint32_t i = 0; i < count; ++i)
+        childOffsets[i + 1] += childOffsets[i];
+
+    std::vector<uint32_t> children(childOffsets[count]);
+    std::vector<uint32_t> fill(childOffsets.begin(), childOffsets.end() - 1);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (parentIndices[i] != NO_PARENT)
+            children[fill[parentIndices[i]]++] = i;
+    }
+
+    // Depth first order, old index of every new position
+    std::vector<uint32_t> order;
+    order.reserve(count);
+    rootRanges.clear();
+
+    std::vector<uint32_t> stack;
+    for (uint32_t root = 0; root < count; ++root)
+    {
+        if (parentIndices[root] != NO_PARENT)
+            continue;
+
+        const auto begin = static_cast<uint32_t>(order.size());
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            const uint32_t node = stack.back();
+            stack.pop_back();
+            order.push_back(node);
+
+            // Reversed so that children keep their relative order
+            for (uint32_t c = childOffsets[node + 1]; c > childOffsets[node]; --c)
+                stack.push_back(children[c - 1]);
+        }
+        rootRanges.emplace_back(begin, static_cast<uint32_t>(order.size()));
+    }
+    assert(order.size() == count && "Transform hierarchy contains a cycle");
+
+    std::vector<uint32_t> newIndices(count);
+    for (uint32_t i = 0; i < count; ++i)
+        newIndices[order[i]] = i;
+
+    const auto permute = [&order](auto& values)
+    {
+        std::remove_reference_t<decltype(values)> permuted;
+        permuted.reserve(values.size());
+        for (const uint32_t oldIndex : order)
+            permuted.push_back(values[oldIndex]);
+        values = std::move(permuted);
+    };
+
+    permute(localPositions);
+    permute(localRotations);
+    permute(localScales);
+    permute(parentIndices);
+    permute(worldMatrices);
+    permute(worldVersions);
+    permute(dirty);
+    permute(nodeHandles);
+    permute(firstChildren);
+    permute(nextSiblings);
+    permute(previousSiblings);
+
+    const auto remap = [&newIndices](uint32_t& index)
+    {
+        if (index != NO_NODE)
+            index = newIndices[index];
+    };
+
+    static_assert(NO_PARENT == NO_NODE);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        remap(parentIndices[i]);
+        remap(firstChildren[i]);
+        remap(nextSiblings[i]);
+        remap(previousSiblings[i]);
+        *nodeIndices.Get(nodeHandles[i]) = i;
+    }
+
+    needsReorder = false;
+}
+
+size_t TransformHierarchy::UpdateRange(const uint32_t begin, const uint32_t end)
+{
+    size_t updatedCount = 0;
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        // A parent recomputed in this pass is still flagged, which propagates to its whole subtree
+        const uint32_t parent = parentIndices[i];
+        if (!dirty[i] && (parent == NO_PARENT || !dirty[parent]))
+            continue;
+
+        dirty[i] = true;
+
+        __m128 world[4];
+        LoadLocalRows(localPositions[i], localRotations[i], localScales[i], world);
+        if (parent != NO_PARENT)
+        {
+            __m128 parentRows[4];
+            LoadRows(worldMatrices[parent], parentRows);
+            for (__m128& row : world)
+                row = TransformRow(row, parentRows);
+        }
+
+        StoreRows(world, worldMatrices[i]);
+        worldVersions[i] = worldVersions[i] == std::numeric_limits<uint32_t>::max() ? 1 : worldVersions[i] + 1;
+        ++updatedCount;
+    }
+
+    std::fill(dirty.begin() + begin, dirty.begin() + end, uint8_t{0});
+    return updatedCount;
+}
+
+void TransformHierarchy::UpdateWorldMatrices(ThreadPool* pool)
+{
+    std::unique_lock _{ hierarchyMutex };
+
+    assert(updateThread == std::thread::id{} || updateThread == std::this_thread::get_id());
+    updateThread = std::this_thread::get_id();
+
+    if (needsReorder)
+        Reorder();
+
+    const auto count = static_cast<uint32_t>(localPositions.size());
+    if (!pool || count < PARALLEL_UPDATE_THRESHOLD || rootRanges.size() < 2)
+    {
+        lastUpdatedCount = UpdateRange(0, count);
+        return;
+    }
+
+    // Group consecutive roots into batches of roughly the same node count, one job each
+    const size_t jobCount = std::max(1u, std::thread::hardware_concurrency());
+    const size_t nodesPerJob = (count + jobCount - 1) / jobCount;
+
+    std::atomic<size_t> updatedCount = 0;
+    static FrameArena& frameArena = WindowsEngine::GetModule<FrameArena>();
+    FrameVector<ThreadPool::TaskHandle> handles{frameArena};
+    handles.reserve(jobCount);
+    uint32_t batchBegin = 0;
+    for (const auto& [rootBegin, rootEnd] : rootRanges)
+    {
+        if (rootEnd - batchBegin < nodesPerJob && rootEnd != count)
+            continue;
+
+        handles.push_back(pool->AddWaitableTask([this, &updatedCount, batchBegin, end = rootEnd]
+        {
+            updatedCount += UpdateRange(batchBegin, end);
+        }));
+        batchBegin = rootEnd;
+    }
+
+    for (const auto& handle : handles)
+        pool->WaitFor(handle);
+
+    lastUpdatedCount = updatedCount;
+}
+
+size_t TransformHierarchy::GetNodeCount() const
+{
+    std::shared_lock _{ hierarchyMutex };
+    return localPositions.size();
+}
+
+void TransformHierarchy::RenderImGui()
+{
+#ifdef _IMGUI_
+    if (ImGui::CollapsingHeader("Transform Hierarchy"))
+    {
+        ImGui::Text("Nodes: %zu, roots: %zu, updated last frame: %zu", GetNodeCount(), rootRanges.size(), lastUpdatedCount);
+    }
+#endif
+}
+
+TransformNode::TransformNode(const Transform& local)
+    : handle{WindowsEngine::GetModule<TransformHierarchy>().CreateNode(local)}
+{}
+
+TransformNode::TransformNode(TransformNode&& other) noexcept
+    : handle{std::exchange(other.handle, {})}
+{}
+
+TransformNode& TransformNode::operator=(TransformNode&& other) noexcept
+{
+    std::swap(handle, other.handle);
+    return *this;
+}
+
+TransformNode::~TransformNode()
+{
+    if (handle.IsValid())
+        WindowsEngine::GetModule<TransformHierarchy>().DestroyNode(handle);
+}
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <limits>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "Transform.h"
+#include "Core/DataStructures/SlotMap.h"
+
+namespace Snail
+{
+class ThreadPool;
+
+// Local transforms and cached world matrices of every entity, stored as SoA.
+// Nodes are kept in depth-first order: parents always come before their children and the subtree
+// of every root is contiguous, so world matrices are propagated in a single forward pass per root.
+class TransformHierarchy
+{
+public:
+    using NodeHandle = SlotHandle;
+    static constexpr uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+    // Below this many nodes, splitting the update across jobs costs more than it saves
+    static constexpr size_t PARALLEL_UPDATE_THRESHOLD = 4096;
+
+private:
+    // End of a child list
+    static constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+
+    std::vector<Vector3> localPositions;
+    std::vector<Quaternion> localRotations;
+    std::vector<Vector3> localScales;
+    std::vector<uint32_t> parentIndices;
+    std::vector<Matrix> worldMatrices;
+    // Bumped every time a world matrix is recomputed, 0 is never a valid version
+    std::vector<uint32_t> worldVersions;
+    std::vector<uint8_t> dirty;
+    std::vector<NodeHandle> nodeHandles;
+    // Children of every node as intrusive lists, so that destroying or reparenting a node only visits its neighbours
+    std::vector<uint32_t> firstChildren;
+    std::vector<uint32_t> nextSiblings;
+    std::vector<uint32_t> previousSiblings;
+
+    SlotMap<uint32_t> nodeIndices;
+    // [begin, end) of the subtree of every root, valid when needsReorder is false
+    std::vector<std::pair<uint32_t, uint32_t>> rootRanges;
+    bool needsReorder = false;
+
+    size_t lastUpdatedCount = 0;
+    // Thread of the first UpdateWorldMatrices, every later one must come from it
+    std::thread::id updateThread;
+
+    // Every write is exclusive, even to a single node, since reading a world matrix walks the ancestors of its node
+    mutable std::shared_mutex hierarchyMutex;
+
+    uint32_t GetIndex(NodeHandle node) const;
+    bool IsWorldDirty(uint32_t index) const;
+    Matrix ComputeWorldMatrix(uint32_t index) const;
+    void LinkChild(uint32_t index, uint32_t parent);
+    void UnlinkChild(uint32_t index);
+    void Reorder();
+    size_t UpdateRange(uint32_t begin, uint32_t end);
+
+public:
+    NodeHandle CreateNode(const Transform& local, NodeHandle parent = {});
+    void DestroyNode(NodeHandle node);
+    void SetParent(NodeHandle node, NodeHandle parent);
+
+    void SetLocalTransform(NodeHandle node, const Transform& local);
+    // Cached world matrix, computed from the ancestors instead when the node or one of them is dirty
+    Matrix GetWorldMatrix(NodeHandle node) const;
+    // Version of the cached world matrix, 0 while the node or one of its ancestors is dirty
+    uint32_t GetWorldVersion(NodeHandle node) const;
+
+    // Recomputes the world matrices of dirty subtrees, with a pool the roots are split across jobs.
+    // The hierarchy stays exclusively locked until the jobs are done, they write the arrays without locking. Must be
+    // called from the main thread, never from a job of the pool, and while no task queued on the pool reads or writes
+    // the hierarchy: such a task would block on the lock and the jobs waited on could never start.
+    void UpdateWorldMatrices(ThreadPool* pool = nullptr);
+
+    size_t GetNodeCount() const;
+    void RenderImGui();
+};
+
+// Owning handle to a node of the engine's hierarchy, the node is destroyed with it
+class TransformNode
+{
+    TransformHierarchy::NodeHandle handle;
+
+public:
+    TransformNode(const Transform& local);
+    TransformNode(TransformNode&& other) noexcept;
+    TransformNode& operator=(TransformNode&& other) noexcept;
+    TransformNode(const TransformNode&) = delete;
+    TransformNode& operator=(const TransformNode&) = delete;
+    ~TransformNode();
+
+    TransformHierarchy::NodeHandle Get() const noexcept { return handle; }
+};
+
+}
@@ -0,0 +1,100 @@
+#include "stdafx.h"
+#include "FrameArena.h"
+
+#include "MemoryTracker.h"
+
+namespace Snail
+{
+
+FrameArena::FrameArena(const size_t capacity)
+{
+    for (Buffer& buffer : buffers)
+        Reserve(buffer, capacity);
+}
+
+FrameArena::~FrameArena()
+{
+    for (Buffer& buffer : buffers)
+    {
+        ReleaseOverflow(buffer);
+        MemoryTracker::Free(buffer.memory);
+    }
+}
+
+void FrameArena::Reserve(Buffer& buffer, const size_t capacity)
+{
+    MemoryTracker::Free(buffer.memory);
+    buffer.memory = static_cast<std::byte*>(MemoryTracker::Allocate(capacity, MemoryTag::RENDER, alignof(std::max_align_t)));
+    buffer.capacity = capacity;
+}
+
+void FrameArena::ReleaseOverflow(Buffer& buffer)
+{
+    for (void* ptr : buffer.overflowAllocations)
+        MemoryTracker::Free(ptr);
+    buffer.overflowAllocations.clear();
+    buffer.overflowBytes = 0;
+}
+
+void* FrameArena::AllocateOverflow(Buffer& buffer, const size_t size, const size_t alignment)
+{
+    std::lock_guard lock{overflowMutex};
+    void* ptr = MemoryTracker::Allocate(size, MemoryTag::RENDER, alignment);
+    buffer.overflowAllocations.push_back(ptr);
+    buffer.overflowBytes += size + alignment;
+    return ptr;
+}
+
+void* FrameArena::Allocate(const size_t size, const size_t alignment)
+{
+    Buffer& buffer = buffers[currentBuffer];
+    const auto base = reinterpret_cast<uintptr_t>(buffer.memory);
+
+    size_t offset = buffer.offset.load(std::memory_order_relaxed);
+    size_t alignedOffset;
+    do
+    {
+        alignedOffset = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+        if (alignedOffset + size > buffer.capacity)
+            return AllocateOverflow(buffer, size, alignment);
+    }
+    while (!buffer.offset.compare_exchange_weak(offset, alignedOffset + size, std::memory_order_relaxed));
+
+    return buffer.memory + alignedOffset;
+}
+
+void FrameArena::BeginFrame()
+{
+    {
+        const Buffer& lastBuffer = buffers[currentBuffer];
+        lastFrameBytes = lastBuffer.offset.load(std::memory_order_relaxed);
+        lastFrameOverflowBytes = lastBuffer.overflowBytes;
+    }
+
+    currentBuffer = 1 - currentBuffer;
+    Buffer& buffer = buffers[currentBuffer];
+    if (buffer.overflowBytes > 0)
+    {
+        // Grown with some headroom so that a slowly growing frame doesn't reallocate every other frame
+        const size_t capacity = (buffer.capacity + buffer.overflowBytes) * 3 / 2;
+        LOGF(Logger::WARN, "Frame arena overflowed by {} bytes, growing it to {} bytes", buffer.overflowBytes, capacity);
+        ReleaseOverflow(buffer);
+        Reserve(buffer, capacity);
+    }
+    buffer.offset.store(0, std::memory_order_relaxed);
+}
+
+void FrameArena::RenderImGui()
+{
+#ifdef _IMGUI_
+    const size_t capacity = buffers[currentBuffer].capacity;
+    ImGui::Text("Frame arena: %.1f / %.1f KB", lastFrameBytes / 1024.0, capacity / 1024.0);
+    if (lastFrameOverflowBytes > 0)
+    {
+        ImGui::SameLine();
+        ImGui::Text("(overflowed by %.1f KB)", lastFrameOverflowBytes / 1024.0);
+    }
+#endif
+}
+
+}
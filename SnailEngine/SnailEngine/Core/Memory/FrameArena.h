@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace Snail
+{
+
+// Double buffered linear allocator for data that lives at most until the end of the next frame.
+// Allocating is a single atomic bump so jobs can use it too, nothing is ever freed individually.
+// When a buffer runs out, the rest of its frame falls back to the heap and it is grown the next time it is reused.
+class FrameArena
+{
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 4 * 1024 * 1024;
+
+private:
+    struct Buffer
+    {
+        std::byte* memory = nullptr;
+        size_t capacity = 0;
+        std::atomic<size_t> offset = 0;
+        std::vector<void*> overflowAllocations;
+        size_t overflowBytes = 0;
+    };
+
+    std::array<Buffer, 2> buffers;
+    size_t currentBuffer = 0;
+    std::mutex overflowMutex;
+
+    // Usage of the last full frame
+    size_t lastFrameBytes = 0;
+    size_t lastFrameOverflowBytes = 0;
+
+    void* AllocateOverflow(Buffer& buffer, size_t size, size_t alignment);
+    static void Reserve(Buffer& buffer, size_t capacity);
+    static void ReleaseOverflow(Buffer& buffer);
+
+public:
+    FrameArena(size_t capacity = DEFAULT_CAPACITY);
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    ~FrameArena();
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Switches buffers, everything allocated two frames ago is gone
+    void BeginFrame();
+
+    void RenderImGui();
+};
+
+// Standard allocator over the frame arena, for containers that are thrown away before the end of the next frame
+template <class T>
+struct FrameAllocator
+{
+    using value_type = T;
+
+    FrameArena* arena = nullptr;
+
+    // Assigning a container bound to an arena also hands over the arena, so that members can be bound again every frame
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    // Unbound, for members that are given a container bound to an arena before they are filled
+    FrameAllocator() noexcept = default;
+    FrameAllocator(FrameArena& frameArena) noexcept
+        : arena{&frameArena}
+    {}
+
+    template <class U>
+    FrameAllocator(const FrameAllocator<U>& other) noexcept
+        : arena{other.arena}
+    {}
+
+    T* allocate(const size_t count)
+    {
+        assert(arena && "the container was never bound to a frame arena");
+        return static_cast<T*>(arena->Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) noexcept {}
+
+    template <class U>
+    bool operator==(const FrameAllocator<U>& other) const noexcept { return arena == other.arena; }
+};
+
+template <class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+// For members filled and drained within a frame: an empty vector is bound to the arena again before it is filled, so
+// that it never writes to the storage of an earlier frame
+template <class T>
+FrameVector<T>& RebindIfEmpty(FrameVector<T>& vector, FrameArena& arena)
+{
+    if (vector.empty())
+        vector = FrameVector<T>{arena};
+    return vector;
+}
+
+}
@@ -0,0 +1,239 @@
+#include "stdafx.h"
+#include "MemoryTracker.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace Snail
+{
+
+namespace
+{
+
+// Stored right before every block returned by MemoryTracker::Allocate
+struct AllocationHeader
+{
+    size_t size;
+    uint32_t offset;
+    MemoryTag tag;
+};
+
+constexpr size_t ToIndex(const MemoryTag tag) noexcept
+{
+    return static_cast<size_t>(tag);
+}
+
+// Tags whose allocations don't count against the steady state, the debug UI and streaming are allowed to allocate
+constexpr bool IsSteadyStateTag(const MemoryTag tag) noexcept
+{
+    return tag != MemoryTag::UI && tag != MemoryTag::ASSETS;
+}
+
+}
+
+thread_local MemoryTag MemoryTracker::currentTag = MemoryTag::GENERAL;
+
+const char* GetMemoryTagName(const MemoryTag tag) noexcept
+{
+    switch (tag)
+    {
+    case MemoryTag::GENERAL: return "General";
+    case MemoryTag::RENDER: return "Render";
+    case MemoryTag::PHYSICS: return "Physics";
+    case MemoryTag::ASSETS: return "Assets";
+    case MemoryTag::UI: return "UI";
+    case MemoryTag::AUDIO: return "Audio";
+    case MemoryTag::ENTITIES: return "Entities";
+    default: return "Unknown";
+    }
+}
+
+void* MemoryTracker::Allocate(const size_t size, const MemoryTag tag, size_t alignment)
+{
+    alignment = std::max(alignment, alignof(AllocationHeader));
+    const size_t headerSize = (sizeof(AllocationHeader) + alignment - 1) / alignment * alignment;
+
+    auto* base = static_cast<std::byte*>(_aligned_malloc(headerSize + size, alignment));
+    if (!base)
+        throw std::bad_alloc();
+
+    std::byte* ptr = base + headerSize;
+    new(ptr - sizeof(AllocationHeader)) AllocationHeader{size, static_cast<uint32_t>(headerSize), tag};
+    TrackAllocation(tag, size);
+    return ptr;
+}
+
+void MemoryTracker::Free(void* ptr) noexcept
+{
+    if (!ptr)
+        return;
+
+    auto* bytes = static_cast<std::byte*>(ptr);
+    const AllocationHeader header = *reinterpret_cast<AllocationHeader*>(bytes - sizeof(AllocationHeader));
+    TrackFree(header.tag, header.size);
+    _aligned_free(bytes - header.offset);
+}
+
+void MemoryTracker::TrackAllocation(const MemoryTag tag, const size_t size) noexcept
+{
+    TagCounters& tagCounters = counters[ToIndex(tag)];
+    const size_t live = tagCounters.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    tagCounters.frameAllocations.fetch_add(1, std::memory_order_relaxed);
+    tagCounters.frameBytes.fetch_add(size, std::memory_order_relaxed);
+
+    size_t peak = tagCounters.peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !tagCounters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {}
+}
+
+void MemoryTracker::TrackFree(const MemoryTag tag, const size_t size) noexcept
+{
+    counters[ToIndex(tag)].liveBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+void MemoryTracker::CountHeapAllocation(const size_t size) noexcept
+{
+    TagCounters& tagCounters = counters[ToIndex(currentTag)];
+    tagCounters.frameAllocations.fetch_add(1, std::memory_order_relaxed);
+    tagCounters.frameBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void MemoryTracker::BeginFrame()
+{
+    for (size_t i = 0; i < counters.size(); ++i)
+    {
+        TagCounters& tagCounters = counters[i];
+        lastFrame[i].liveBytes = tagCounters.liveBytes.load(std::memory_order_relaxed);
+        lastFrame[i].peakBytes = tagCounters.peakBytes.load(std::memory_order_relaxed);
+        lastFrame[i].frameAllocations = tagCounters.frameAllocations.exchange(0, std::memory_order_relaxed);
+        lastFrame[i].frameBytes = tagCounters.frameBytes.exchange(0, std::memory_order_relaxed);
+    }
+
+    if (steadyStateFramesLeft == 0)
+        return;
+
+    // The first frame counted is the one the check was started in, it is skipped
+    if (steadyStateFramesLeft < STEADY_STATE_CHECK_FRAMES)
+    {
+        for (size_t i = 0; i < counters.size(); ++i)
+            steadyStateAllocations[i] += lastFrame[i].frameAllocations;
+    }
+
+    if (--steadyStateFramesLeft > 0)
+        return;
+
+    steadyStateCheckDone = true;
+    steadyStateCheckPassed = true;
+    for (size_t i = 0; i < counters.size(); ++i)
+    {
+        const auto tag = static_cast<MemoryTag>(i);
+        if (IsSteadyStateTag(tag) && steadyStateAllocations[i] > 0)
+        {
+            LOGF(Logger::WARN, "Steady state check: {} heap allocations tagged {} over {} frames", steadyStateAllocations[i], GetMemoryTagName(tag), STEADY_STATE_CHECK_FRAMES - 1);
+            steadyStateCheckPassed = false;
+        }
+    }
+    LOGF("Steady state allocation check {}", steadyStateCheckPassed ? "passed" : "failed");
+}
+
+MemoryTracker::TagStats MemoryTracker::GetStats(const MemoryTag tag) noexcept
+{
+    return lastFrame[ToIndex(tag)];
+}
+
+void MemoryTracker::StartSteadyStateCheck() noexcept
+{
+    steadyStateAllocations.fill(0);
+    steadyStateFramesLeft = STEADY_STATE_CHECK_FRAMES;
+    steadyStateCheckDone = false;
+}
+
+void MemoryTracker::RenderImGui()
+{
+#ifdef _IMGUI_
+    if (ImGui::CollapsingHeader("Memory"))
+    {
+        if (ImGui::BeginTable("MemoryTags", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Tag");
+            ImGui::TableSetupColumn("Live (KB)");
+            ImGui::TableSetupColumn("Peak (KB)");
+            ImGui::TableSetupColumn("Allocs / frame");
+            ImGui::TableSetupColumn("KB / frame");
+            ImGui::TableHeadersRow();
+
+            for (size_t i = 0; i < lastFrame.size(); ++i)
+            {
+                const TagStats& stats = lastFrame[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", GetMemoryTagName(static_cast<MemoryTag>(i)));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", stats.liveBytes / 1024.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", stats.peakBytes / 1024.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%zu", stats.frameAllocations);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", stats.frameBytes / 1024.0);
+            }
+            ImGui::EndTable();
+        }
+
+        if (ImGui::Button("Check steady state allocations"))
+            StartSteadyStateCheck();
+        ImGui::SameLine();
+        if (steadyStateFramesLeft > 0)
+            ImGui::Text("Running, %zu frames left", steadyStateFramesLeft);
+        else if (steadyStateCheckDone)
+            ImGui::Text("%s", steadyStateCheckPassed ? "Passed" : "Failed, see log");
+    }
+#endif
+}
+
+MemoryTagScope::MemoryTagScope(const MemoryTag tag) noexcept
+    : previous{MemoryTracker::GetCurrentTag()}
+{
+    MemoryTracker::SetCurrentTag(tag);
+}
+
+MemoryTagScope::~MemoryTagScope()
+{
+    MemoryTracker::SetCurrentTag(previous);
+}
+
+}
+
+// Every heap allocation of the engine is counted, the blocks themselves still come from the CRT
+void* operator new(const std::size_t size)
+{
+    Snail::MemoryTracker::CountHeapAllocation(size);
+    if (void* ptr = malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](const std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    free(ptr);
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Snail
+{
+
+// Subsystem that memory is accounted to
+enum class MemoryTag : uint8_t
+{
+    GENERAL,
+    RENDER,
+    PHYSICS,
+    ASSETS,
+    UI,
+    AUDIO,
+    ENTITIES,
+    COUNT
+};
+
+const char* GetMemoryTagName(MemoryTag tag) noexcept;
+
+// Counts the memory of every subsystem. Tagged allocations made through Allocate, the frame arena, the pools and the PhysX
+// allocator are tracked in live bytes. Every other heap allocation goes through the global operator new, which is counted
+// per frame under the tag of the innermost MemoryTagScope of its thread.
+class MemoryTracker
+{
+public:
+    // Allocations made during these frames must all be gone for the steady state check to pass
+    static constexpr size_t STEADY_STATE_CHECK_FRAMES = 120;
+
+    struct TagStats
+    {
+        size_t liveBytes = 0;
+        size_t peakBytes = 0;
+        size_t frameAllocations = 0;
+        size_t frameBytes = 0;
+    };
+
+private:
+    struct TagCounters
+    {
+        std::atomic<size_t> liveBytes = 0;
+        std::atomic<size_t> peakBytes = 0;
+        std::atomic<size_t> frameAllocations = 0;
+        std::atomic<size_t> frameBytes = 0;
+    };
+
+    static inline std::array<TagCounters, static_cast<size_t>(MemoryTag::COUNT)> counters;
+    // Allocation counts of the last full frame
+    static inline std::array<TagStats, static_cast<size_t>(MemoryTag::COUNT)> lastFrame{};
+    static thread_local MemoryTag currentTag;
+
+    static inline size_t steadyStateFramesLeft = 0;
+    static inline std::array<size_t, static_cast<size_t>(MemoryTag::COUNT)> steadyStateAllocations{};
+    static inline bool steadyStateCheckPassed = false;
+    static inline bool steadyStateCheckDone = false;
+
+public:
+    // Aligned heap allocation counted in live bytes, must be freed with Free
+    static void* Allocate(size_t size, MemoryTag tag, size_t alignment = alignof(std::max_align_t));
+    static void Free(void* ptr) noexcept;
+
+    // For allocators that know their sizes and don't need a header
+    static void TrackAllocation(MemoryTag tag, size_t size) noexcept;
+    static void TrackFree(MemoryTag tag, size_t size) noexcept;
+    // Called by the global operator new
+    static void CountHeapAllocation(size_t size) noexcept;
+
+    static MemoryTag GetCurrentTag() noexcept { return currentTag; }
+    static void SetCurrentTag(MemoryTag tag) noexcept { currentTag = tag; }
+
+    // Closes the frame counts and moves the steady state check forward
+    static void BeginFrame();
+    static TagStats GetStats(MemoryTag tag) noexcept;
+
+    // Counts the heap allocations of the next frames, outside of the UI and the asset loading
+    static void StartSteadyStateCheck() noexcept;
+    // Of the last check, until the next one is started
+    static bool IsSteadyStateCheckDone() noexcept { return steadyStateCheckDone; }
+    static bool HasSteadyStateCheckPassed() noexcept { return steadyStateCheckPassed; }
+    static size_t GetSteadyStateAllocations(MemoryTag tag) noexcept { return steadyStateAllocations[static_cast<size_t>(tag)]; }
+
+    static void RenderImGui();
+};
+
+// Untagged heap allocations of this thread are counted under the tag until the scope ends
+class MemoryTagScope
+{
+    MemoryTag previous;
+
+public:
+    MemoryTagScope(MemoryTag tag) noexcept;
+    MemoryTagScope(const MemoryTagScope&) = delete;
+    MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+    ~MemoryTagScope();
+};
+
+// Standard allocator counted under a tag, for containers owned by a subsystem
+template <class T, MemoryTag Tag>
+struct TaggedAllocator
+{
+    using value_type = T;
+
+    template <class U>
+    struct rebind
+    {
+        using other = TaggedAllocator<U, Tag>;
+    };
+
+    TaggedAllocator() noexcept = default;
+    template <class U>
+    TaggedAllocator(const TaggedAllocator<U, Tag>&) noexcept {}
+
+    T* allocate(const size_t count)
+    {
+        return static_cast<T*>(MemoryTracker::Allocate(count * sizeof(T), Tag, alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_t) noexcept
+    {
+        MemoryTracker::Free(ptr);
+    }
+
+    template <class U>
+    bool operator==(const TaggedAllocator<U, Tag>&) const noexcept { return true; }
+};
+
+}
@@ -0,0 +1,99 @@
+#include "stdafx.h"
+#include "PoolAllocator.h"
+
+#include <array>
+#include <bit>
+#include <mutex>
+
+namespace Snail
+{
+
+namespace
+{
+
+class MemoryPool
+{
+    // Blocks are carved out of chunks of this many bytes, or a single block for the biggest sizes
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    std::mutex mutex;
+    FreeBlock* freeList = nullptr;
+    // Chunks are linked through their first block so that the pool doesn't need a container
+    FreeBlock* chunks = nullptr;
+
+public:
+    void* Allocate(const size_t blockSize, const MemoryTag tag)
+    {
+        std::lock_guard lock{mutex};
+        if (!freeList)
+        {
+            const size_t chunkSize = std::max(CHUNK_SIZE, 2 * blockSize);
+            auto* chunk = static_cast<std::byte*>(MemoryTracker::Allocate(chunkSize, tag, POOL_BLOCK_ALIGNMENT));
+            chunks = new(chunk) FreeBlock{chunks};
+            for (size_t offset = blockSize; offset + blockSize <= chunkSize; offset += blockSize)
+                freeList = new(chunk + offset) FreeBlock{freeList};
+        }
+
+        FreeBlock* block = freeList;
+        freeList = block->next;
+        return block;
+    }
+
+    void Free(void* ptr) noexcept
+    {
+        std::lock_guard lock{mutex};
+        freeList = new(ptr) FreeBlock{freeList};
+    }
+
+    ~MemoryPool()
+    {
+        while (chunks)
+        {
+            FreeBlock* next = chunks->next;
+            MemoryTracker::Free(chunks);
+            chunks = next;
+        }
+    }
+};
+
+constexpr size_t SIZE_CLASS_COUNT = std::countr_zero(MAX_POOLED_SIZE) - std::countr_zero(MIN_POOLED_SIZE) + 1;
+
+// Namespace scope so that the pools are built before and destroyed after the engine and its entities
+std::array<std::array<MemoryPool, SIZE_CLASS_COUNT>, static_cast<size_t>(MemoryTag::COUNT)> pools;
+
+size_t GetSizeClass(const size_t size) noexcept
+{
+    return std::countr_zero(std::bit_ceil(std::max(size, MIN_POOLED_SIZE))) - std::countr_zero(MIN_POOLED_SIZE);
+}
+
+}
+
+void* PoolAllocate(const size_t size, const MemoryTag tag)
+{
+    if (size > MAX_POOLED_SIZE)
+        return MemoryTracker::Allocate(size, tag, POOL_BLOCK_ALIGNMENT);
+
+    const size_t sizeClass = GetSizeClass(size);
+    return pools[static_cast<size_t>(tag)][sizeClass].Allocate(MIN_POOLED_SIZE << sizeClass, tag);
+}
+
+void PoolFree(void* ptr, const size_t size, const MemoryTag tag) noexcept
+{
+    if (!ptr)
+        return;
+
+    if (size > MAX_POOLED_SIZE)
+    {
+        MemoryTracker::Free(ptr);
+        return;
+    }
+
+    pools[static_cast<size_t>(tag)][GetSizeClass(size)].Free(ptr);
+}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+
+#include "MemoryTracker.h"
+
+namespace Snail
+{
+
+// Fixed size blocks handed out from a free list, for objects that are created and destroyed while the game runs.
+// Sizes are rounded up to a power of two, anything bigger than MAX_POOLED_SIZE goes to the heap.
+// Freed blocks stay in their pool, so a scene that keeps the same amount of objects stops allocating.
+inline constexpr size_t MIN_POOLED_SIZE = 32;
+inline constexpr size_t MAX_POOLED_SIZE = 4096;
+// Alignment of every block: chunks are aligned to it and every block size is a multiple of it
+inline constexpr size_t POOL_BLOCK_ALIGNMENT = alignof(std::max_align_t);
+static_assert(MIN_POOLED_SIZE % POOL_BLOCK_ALIGNMENT == 0);
+
+void* PoolAllocate(size_t size, MemoryTag tag);
+// Size and tag must be the ones the block was allocated with
+void PoolFree(void* ptr, size_t size, MemoryTag tag) noexcept;
+
+// Standard allocator over the pools, for node based containers
+template <class T, MemoryTag Tag = MemoryTag::GENERAL>
+struct PoolAllocator
+{
+    using value_type = T;
+
+    template <class U>
+    struct rebind
+    {
+        using other = PoolAllocator<U, Tag>;
+    };
+
+    PoolAllocator() noexcept = default;
+    template <class U>
+    PoolAllocator(const PoolAllocator<U, Tag>&) noexcept {}
+
+    T* allocate(const size_t count)
+    {
+        static_assert(alignof(T) <= POOL_BLOCK_ALIGNMENT, "over-aligned types can't be pooled");
+        return static_cast<T*>(PoolAllocate(count * sizeof(T), Tag));
+    }
+
+    void deallocate(T* ptr, const size_t count) noexcept
+    {
+        PoolFree(ptr, count * sizeof(T), Tag);
+    }
+
+    template <class U>
+    bool operator==(const PoolAllocator<U, Tag>&) const noexcept { return true; }
+};
+
+}
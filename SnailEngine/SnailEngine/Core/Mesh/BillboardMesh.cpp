@@ -5,9 +5,15 @@
 
 namespace Snail
 {
+BillboardMesh::BillboardMesh()
+    : particleInstanceBuffer{D3D11_BIND_VERTEX_BUFFER}
+    , particleViewBuffer{D3D11Buffer::CreateConstantBuffer<ParticleViewData>()}
+{}
+
 void BillboardMesh::InitShaders()
 {
     effectsShader = std::make_unique<EffectsShader>(L"SnailEngine/Shaders/Billboard.fx", DEFAULT_ELEMENT_LAYOUT, DEFAULT_ELEMENT_COUNT);
+    particleShader = std::make_unique<EffectsShader>(L"SnailEngine/Shaders/Particles.fx", PARTICLE_ELEMENT_LAYOUT, PARTICLE_ELEMENT_COUNT);
 }
 
 void BillboardMesh::BindTextures(const SubMesh&) const
@@ -18,6 +24,8 @@ void BillboardMesh::BindTextures(const SubMesh&) const
 
 void BillboardMesh::Draw(const D3D11Buffer*)
 {
+    DrawParticles();
+
     if (instancesModelMatrix.empty())
         return;
 
@@ -32,6 +40,26 @@ void BillboardMesh::Draw(const D3D11Buffer*)
     InputAssembler::SetInstanceBuffer(instanceBuffer, sizeof(InstanceVertex), 0);
     InputAssembler::SetIndexBuffer(indexBuffer);
 
+    SetCulling();
+
+    for (SubMesh& submesh : submeshes)
+    {
+        if (submesh.indexBufferCount == 0)
+            continue;
+
+        BindTextures(submesh);
+        BindShaders();
+
+        submesh.DrawGeometry(device, static_cast<int>(instancesModelMatrix.size()));
+    }
+
+    instancesModelMatrix.clear();
+}
+
+void BillboardMesh::SetCulling() const
+{
+    static auto* device = WindowsEngine::GetInstance().GetRenderDevice();
+
     switch (cullingType)
     {
     case CullingType::FRONT:
@@ -44,19 +72,56 @@ void BillboardMesh::Draw(const D3D11Buffer*)
     default:
         device->SetBackFaceCulling();
     }
+}
 
-    for (SubMesh& submesh : submeshes)
-    {
-        if (submesh.indexBufferCount == 0)
-            continue;
+void BillboardMesh::DrawParticles()
+{
+    if (particleInstances.empty())
+        return;
 
-        BindTextures(submesh);
-        BindShaders();
+    static auto* device = WindowsEngine::GetInstance().GetRenderDevice();
+    static auto& renderer = WindowsEngine::GetModule<RendererModule>();
+    const FrameView::CameraView& camera = renderer.GetFrameView().camera;
 
-        submesh.DrawGeometry(device, static_cast<int>(instancesModelMatrix.size()));
-    }
+    ParticleViewData viewData;
+    viewData.viewProjection = camera.viewProjection.Transpose();
+    viewData.cameraPosition = camera.position;
+    viewData.cameraUp = camera.up;
+    viewData.cameraForward = camera.forward;
+    viewData.cameraRight = camera.right;
+    particleViewBuffer.UpdateData(viewData);
 
-    instancesModelMatrix.clear();
+    particleInstanceBuffer.UpdateData(particleInstances);
+
+    assert(particleShader.get());
+    InputAssembler::SetPrimitiveTopology(primitiveTopology);
+    InputAssembler::SetVertexBuffer(vertexBuffer, sizeof(MeshVertex), 0);
+    InputAssembler::SetInstanceBuffer(particleInstanceBuffer, sizeof(ParticleInstance), 0);
+    InputAssembler::SetIndexBuffer(indexBuffer);
+    SetCulling();
+
+    assert(quadTexture);
+    particleShader->BindTexture("Billboard", quadTexture);
+    particleShader->SetConstantBuffer("ParticleView", particleViewBuffer.GetBuffer());
+    particleShader->Bind();
+
+    // The quad is a single submesh
+    submeshes[0].DrawGeometry(device, static_cast<int>(particleInstances.size()));
+
+    particleInstances.clear();
+}
+
+void BillboardMesh::SubscribeParticles(const std::span<const ParticleInstance> instances)
+{
+    static FrameArena& frameArena = WindowsEngine::GetModule<FrameArena>();
+    RebindIfEmpty(particleInstances, frameArena);
+    particleInstances.insert(particleInstances.end(), instances.begin(), instances.end());
+}
+
+void BillboardMesh::ReloadShader()
+{
+    QuadMesh::ReloadShader();
+    particleShader->ReloadShader();
 }
 
 void BillboardMesh::RenderImGui()
@@ -1,5 +1,7 @@
 #pragma once
 #include "QuadMesh.h"
+#include "Rendering/Particles/ParticleBuffer.h"
+#include "Util/Util.h"
 
 namespace Snail
 {
@@ -8,12 +10,36 @@ namespace Snail
     {
     public:
         Texture2D* quadTexture = nullptr;
+
+        BillboardMesh();
+
     protected:
+        struct ParticleViewData
+        {
+            Matrix viewProjection;
+            DX_ALIGN Vector3 cameraPosition;
+            DX_ALIGN Vector3 cameraUp;
+            DX_ALIGN Vector3 cameraForward;
+            DX_ALIGN Vector3 cameraRight;
+        };
+
+        // Expands the particles into camera facing quads, all of them in one draw
+        std::unique_ptr<EffectsShader> particleShader;
+        D3D11Buffer particleInstanceBuffer;
+        D3D11Buffer particleViewBuffer;
+        // From the frame arena, drawn and emptied by every Draw
+        FrameVector<ParticleInstance> particleInstances;
 
         void InitShaders() override;
         void BindTextures(const SubMesh& submesh) const override;
         void Draw(const D3D11Buffer* viewProjBuffer) override;
+        void DrawParticles();
+        void SetCulling() const;
+
     public:
+        // Billboards and particle emitters add their quads, they are drawn with the next Draw
+        void SubscribeParticles(std::span<const ParticleInstance> instances);
+        void ReloadShader() override;
         void RenderImGui() override;
     };
 
@@ -9,10 +9,11 @@ namespace Snail
 void DecalMesh::Draw(const D3D11Buffer* viewProjBuffer)
 {
     MatricesBuffer mb;
-    const Camera* cam = WindowsEngine::GetCamera();
+    static auto& renderer = WindowsEngine::GetModule<RendererModule>();
+    const FrameView::CameraView& camera = renderer.GetFrameView().camera;
 
-    mb.invViewMatrix = cam->GetViewMatrix().Invert().Transpose();
-    mb.invProjMatrix = cam->GetProjectionMatrix().Invert().Transpose();
+    mb.invViewMatrix = camera.invView.Transpose();
+    mb.invProjMatrix = camera.invProjection.Transpose();
     matricesBuffer.UpdateData(mb);
 
     CubeMesh::Draw(viewProjBuffer);
@@ -33,9 +34,9 @@ void DecalMesh::BindTextures(const SubMesh& submesh) const
 {
     static D3D11Device* device = WindowsEngine::GetInstance().GetRenderDevice();
     static TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
-    const TexturedMaterial material = submesh.GetMaterial();
+    const TexturedMaterial& material = submesh.GetMaterial();
 
-    effectsShader->BindTexture("Diffuse", textureManager.GetAsset<Texture2D>(material.diffuseTexture));
+    effectsShader->BindTexture("Diffuse", textureManager.GetBindableTexture2D(material.diffuseTexture, TextureManager::DEFAULT_DIFFUSE_TEXTURE_HANDLE));
     effectsShader->BindShaderResourceView("DepthTexture", device->GetDepthShaderResourceView());
 }
 
@@ -3,9 +3,11 @@
 #include "Mesh.h"
 
 #include <algorithm>
+#include <typeinfo>
 
 #include "Core/WindowsEngine.h"
 #include "Rendering/InputAssembler.h"
+#include "Rendering/VertexCompression.h"
 
 using namespace DirectX::SimpleMath;
 
@@ -39,10 +41,71 @@ void BaseMesh::ReloadShader()
     effectsShader->ReloadShader();
 }
 
+void BaseMesh::SetAllMaterialMember(const TextureHandle texture, TextureHandle TexturedMaterial::* materialMember)
+{
+    std::erase_if(materialOverrides, [materialMember](const auto& materialOverride) { return materialOverride.first == materialMember; });
+    materialOverrides.emplace_back(materialMember, texture);
+
+    std::ranges::for_each(submeshes,
+        [&](SubMesh& subMesh)
+        {
+            TexturedMaterial mat = subMesh.GetMaterial();
+            mat.*materialMember = texture;
+            subMesh.SetMaterial(mat);
+        });
+}
+
+void BaseMesh::SetVertexFormat(const VertexFormat format) noexcept
+{
+    vertexFormat = format;
+}
+
+VertexFormat BaseMesh::GetVertexFormat() const noexcept
+{
+    return vertexFormat;
+}
+
+void BaseMesh::RequestTextureResolution(const float pixelsPerUv) const
+{
+    static TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
+
+    for (const SubMesh& submesh : submeshes)
+    {
+        const TexturedMaterial& material = submesh.GetMaterial();
+        for (const auto member : MATERIAL_TEXTURE_MEMBERS)
+        {
+            // Tiled textures cover more UV units in the same pixels
+            Vector2 uvScale = material.material.uvScale;
+            if (member == &TexturedMaterial::primaryBlendTexture)
+                uvScale = material.material.primaryBlendUvScale;
+            else if (member == &TexturedMaterial::secondaryBlendTexture)
+                uvScale = material.material.secondaryBlendUvScale;
+
+            const float tiling = std::max({std::abs(uvScale.x), std::abs(uvScale.y), 1e-3f});
+            textureManager.GetTexture2D(material.*member, GetDefaultTexture(member))->RequestResolution(pixelsPerUv / tiling);
+        }
+    }
+}
+
+const OccluderMesh& BaseMesh::GetOccluderMesh()
+{
+    if (!occluderMesh)
+        occluderMesh = BuildOccluderMesh();
+    return *occluderMesh;
+}
+
 void BaseMesh::RenderImGui()
 {
 #ifdef _IMGUI_
     ImGui::Text(("Name: " + name).c_str());
+    if (optimizationStats)
+    {
+        const MeshOptimizer::Stats& stats = *optimizationStats;
+        ImGui::Text("ACMR: %.3f -> %.3f", stats.before.acmr, stats.after.acmr);
+        ImGui::Text("ATVR: %.3f -> %.3f", stats.before.atvr, stats.after.atvr);
+        ImGui::Text("Index bytes: %zu -> %zu", stats.indexBytesBefore, stats.indexBytesAfter);
+        ImGui::Text("Overdraw clusters: %zu", stats.clusterCount);
+    }
 #endif
 }
 
@@ -67,6 +130,8 @@ void Mesh<IdxType>::Init()
             return sm.GetMaterial().isBlending;
         });
 
+    unitRangeUvs = vertexFormat != VertexFormat::FULL && VertexCompression::HasUnitRangeUvs(vertices);
+
     InitShaders();
     InitBuffers();
 }
@@ -100,6 +165,49 @@ bool Mesh<IdxType>::GetBlendingEnabled() const
     return usesBlending;
 }
 
+template <class IdxType> requires std::is_integral_v<IdxType>
+bool Mesh<IdxType>::SwapGeometry(BaseMesh& reloaded)
+{
+    // Meshes whose index type changed can't be swapped, their draws are compiled for the other type
+    if (typeid(*this) != typeid(reloaded))
+        return false;
+
+    auto& other = static_cast<Mesh&>(reloaded);
+    const bool wasTranslucent = effectsShader->HasDefine(THIN_TRANSLUCENCY_DEFINE);
+    const bool wasBlending = usesBlending;
+
+    for (const auto& [member, texture] : materialOverrides)
+        other.SetAllMaterialMember(texture, member);
+
+    std::swap(vertices, other.vertices);
+    std::swap(indexes, other.indexes);
+    std::swap(submeshes, other.submeshes);
+    vertexBuffer.Swap(other.vertexBuffer);
+    indexBuffer.Swap(other.indexBuffer);
+    std::swap(vertexStride, other.vertexStride);
+    std::swap(positionDecodeMatrix, other.positionDecodeMatrix);
+    std::swap(unitRangeUvs, other.unitRangeUvs);
+    std::swap(usesBlending, other.usesBlending);
+    std::swap(effectsShader, other.effectsShader);
+    std::swap(minBounds, other.minBounds);
+    std::swap(maxBounds, other.maxBounds);
+    std::swap(boundsAreDirty, other.boundsAreDirty);
+    std::swap(uvDensity, other.uvDensity);
+    std::swap(optimizationStats, other.optimizationStats);
+    std::swap(lodCount, other.lodCount);
+    std::swap(lodErrors, other.lodErrors);
+    // Built again from the new geometry the next time it is used
+    occluderMesh.reset();
+
+    if (wasBlending && !usesBlending)
+    {
+        usesBlending = true;
+        InitShaders();
+    }
+    SetTranslucent(wasTranslucent);
+    return true;
+}
+
 template <class IdxType> requires std::is_integral_v<IdxType>
 std::vector<IdxType>& Mesh<IdxType>::GetIndexes() { return indexes; }
 
@@ -110,26 +218,75 @@ template <class IdxType> requires std::is_integral_v<IdxType>
 uint32_t Mesh<IdxType>::GetIndexCount() { return static_cast<uint32_t>(indexes.size()); }
 
 template <class IdxType> requires std::is_integral_v<IdxType>
-void Mesh<IdxType>::SubscribeInstance(const Matrix m)
+size_t Mesh<IdxType>::GetVertexCount() const noexcept { return vertices.size(); }
+
+template <class IdxType> requires std::is_integral_v<IdxType>
+uint32_t Mesh<IdxType>::GetBaseIndexCount() const
+{
+    if (lodCount <= 1)
+        return static_cast<uint32_t>(indexes.size());
+
+    uint32_t end = 0;
+    for (const SubMesh& submesh : submeshes)
+        end = std::max(end, submesh.indexBufferStartIndex + submesh.indexBufferCount);
+    return end;
+}
+
+template <class IdxType> requires std::is_integral_v<IdxType>
+AssetMemoryUsage Mesh<IdxType>::GetMemoryUsage() const
+{
+    const size_t indexBytes = indexes.size() * sizeof(IdxType);
+    return { vertices.size() * sizeof(MeshVertex) + indexBytes, vertices.size() * VertexCompression::GetStride(vertexFormat) + indexBytes };
+}
+
+template <class IdxType> requires std::is_integral_v<IdxType>
+std::unique_ptr<OccluderMesh> Mesh<IdxType>::BuildOccluderMesh() const
+{
+    if (primitiveTopology != D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+        return std::make_unique<OccluderMesh>();
+
+    uint8_t lod = 0;
+    while (lod + 1 < lodCount && lodErrors[lod + 1] <= OccluderMesh::MAX_LOD_ERROR)
+        ++lod;
+
+    std::vector<uint32_t> occluderIndices;
+    for (const SubMesh& submesh : submeshes)
+    {
+        const auto [start, count] = submesh.GetLodRange(lod);
+        occluderIndices.insert(occluderIndices.end(), indexes.begin() + start, indexes.begin() + start + count);
+    }
+    return std::make_unique<OccluderMesh>(OccluderMesh::FromTriangles(vertices, occluderIndices));
+}
+
+template <class IdxType> requires std::is_integral_v<IdxType>
+void Mesh<IdxType>::SubscribeInstance(const Matrix m, const uint8_t lod)
 {
-    instancesModelMatrix.emplace_back(m.Transpose(), m.Invert().Transpose());
+    static FrameArena& frameArena = WindowsEngine::GetModule<FrameArena>();
+    FrameVector<InstanceVertex>& instances = RebindIfEmpty(lod == 0 || lodCount <= 1 ? instancesModelMatrix : lodInstances[std::min<uint8_t>(lod, lodCount - 1) - 1], frameArena);
+
+    // Normals go through the inverse of the original matrix, the decode scale only applies to positions
+    if (vertexFormat == VertexFormat::COMPACT_QUANTIZED_POSITION)
+        instances.emplace_back((positionDecodeMatrix * m).Transpose(), m.Invert().Transpose());
+    else
+        instances.emplace_back(m.Transpose(), m.Invert().Transpose());
 }
 
 template <class IdxType> requires std::is_integral_v<IdxType>
 void Mesh<IdxType>::BindTextures(const SubMesh& submesh) const
 {
     static TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
-    const TexturedMaterial material = submesh.GetMaterial();
+    const TexturedMaterial& material = submesh.GetMaterial();
 
-    effectsShader->BindTexture("NormalMap", textureManager.GetAsset<Texture2D>(material.normalMapTexture));
-    effectsShader->BindTexture("Diffuse", textureManager.GetAsset<Texture2D>(material.diffuseTexture));
+    // Streamed textures that have no mips yet are replaced by the default of their slot
+    effectsShader->BindTexture("NormalMap", textureManager.GetBindableTexture2D(material.normalMapTexture, TextureManager::DEFAULT_NORMAL_MAP_TEXTURE_HANDLE));
+    effectsShader->BindTexture("Diffuse", textureManager.GetBindableTexture2D(material.diffuseTexture, TextureManager::DEFAULT_DIFFUSE_TEXTURE_HANDLE));
 
     if (usesBlending)
     {
-        effectsShader->BindTexture("PrimaryBlendDiffuse", textureManager.GetAsset<Texture2D>(material.primaryBlendDiffuseTexture));
-        effectsShader->BindTexture("PrimaryBlend", textureManager.GetAsset<Texture2D>(material.primaryBlendTexture));
-        effectsShader->BindTexture("SecondaryBlendDiffuse", textureManager.GetAsset<Texture2D>(material.secondaryBlendDiffuseTexture));
-        effectsShader->BindTexture("SecondaryBlend", textureManager.GetAsset<Texture2D>(material.secondaryBlendTexture));
+        effectsShader->BindTexture("PrimaryBlendDiffuse", textureManager.GetBindableTexture2D(material.primaryBlendDiffuseTexture, TextureManager::DEFAULT_DIFFUSE_TEXTURE_HANDLE));
+        effectsShader->BindTexture("PrimaryBlend", textureManager.GetBindableTexture2D(material.primaryBlendTexture, TextureManager::DEFAULT_BLEND_TEXTURE_HANDLE));
+        effectsShader->BindTexture("SecondaryBlendDiffuse", textureManager.GetBindableTexture2D(material.secondaryBlendDiffuseTexture, TextureManager::DEFAULT_DIFFUSE_TEXTURE_HANDLE));
+        effectsShader->BindTexture("SecondaryBlend", textureManager.GetBindableTexture2D(material.secondaryBlendTexture, TextureManager::DEFAULT_BLEND_TEXTURE_HANDLE));
     }
 
     effectsShader->SetConstantBuffer("MaterialParameters", submesh.GetMaterialBuffer().GetBuffer());
@@ -141,8 +298,11 @@ void Mesh<IdxType>::InitShaders()
     std::unordered_set<std::string> defines;
     if (usesBlending)
         defines.insert(TEXTURE_BLENDING_DEFINE);
+    if (vertexFormat != VertexFormat::FULL)
+        defines.insert(COMPACT_VERTEX_DEFINE);
 
-    effectsShader = std::make_unique<EffectsShader>(L"SnailEngine/Shaders/DeferredPass.fx", DEFAULT_ELEMENT_LAYOUT, DEFAULT_ELEMENT_COUNT, defines);
+    const auto [layout, layoutCount] = VertexCompression::GetLayout(vertexFormat, unitRangeUvs);
+    effectsShader = std::make_unique<EffectsShader>(L"SnailEngine/Shaders/DeferredPass.fx", layout, layoutCount, defines);
 }
 
 template <class IdxType> requires std::is_integral_v<IdxType>
@@ -150,7 +310,17 @@ void Mesh<IdxType>::InitBuffers()
 {
     CalculateTangents();
 
-    vertexBuffer = D3D11Buffer(D3D11_BIND_VERTEX_BUFFER, vertices);
+    vertexStride = VertexCompression::GetStride(vertexFormat);
+    if (vertexFormat == VertexFormat::FULL)
+    {
+        vertexBuffer = D3D11Buffer(D3D11_BIND_VERTEX_BUFFER, vertices);
+    }
+    else
+    {
+        CalculateBounds();
+        vertexBuffer = D3D11Buffer(D3D11_BIND_VERTEX_BUFFER, VertexCompression::Encode(vertices, vertexFormat, unitRangeUvs, minBounds, maxBounds));
+        positionDecodeMatrix = VertexCompression::GetPositionDecodeMatrix(minBounds, maxBounds);
+    }
 
     indexBuffer = D3D11Buffer(D3D11_BIND_INDEX_BUFFER, indexes);
     indexBuffer.SetBufferElementWidth(sizeof(IdxType));
@@ -167,7 +337,9 @@ void Mesh<IdxType>::CalculateTangents()
     if (primitiveTopology != D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
         return;
 
-    for (int i = 0; i < indexes.size(); i += 3)
+    // The LODs reuse the vertices of LOD 0, counting their triangles would weigh the tangents twice
+    const uint32_t baseIndexCount = GetBaseIndexCount();
+    for (uint32_t i = 0; i + 2 < baseIndexCount; i += 3)
     {
         auto i0 = indexes[i];
         auto i1 = indexes[i + 1];
@@ -248,12 +420,65 @@ void Mesh<IdxType>::CalculateBounds()
         maxBounds.z = std::max(maxBounds.z, vertex.position.z);
     }
 
+    float area = 0;
+    float uvArea = 0;
+    if (primitiveTopology == D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+    {
+        const uint32_t baseIndexCount = GetBaseIndexCount();
+        for (size_t i = 0; i + 2 < baseIndexCount; i += 3)
+        {
+            const MeshVertex& v0 = vertices[indexes[i]];
+            const MeshVertex& v1 = vertices[indexes[i + 1]];
+            const MeshVertex& v2 = vertices[indexes[i + 2]];
+
+            area += (v1.position - v0.position).Cross(v2.position - v0.position).Length();
+            const Vector2 uv1 = v1.uv - v0.uv;
+            const Vector2 uv2 = v2.uv - v0.uv;
+            uvArea += std::abs(uv1.x * uv2.y - uv2.x * uv1.y);
+        }
+    }
+    uvDensity = area > 0 ? std::sqrt(uvArea / area) : 0;
+
     boundsAreDirty = false;
 }
 
+template <class IdxType> requires std::is_integral_v<IdxType>
+std::array<uint32_t, MAX_MESH_LODS + 1> Mesh<IdxType>::GatherLodInstances()
+{
+    static FrameArena& frameArena = WindowsEngine::GetModule<FrameArena>();
+    RebindIfEmpty(instancesModelMatrix, frameArena);
+
+    std::array<uint32_t, MAX_MESH_LODS + 1> lodOffsets{};
+    lodOffsets[1] = static_cast<uint32_t>(instancesModelMatrix.size());
+    for (size_t lod = 1; lod < MAX_MESH_LODS; ++lod)
+    {
+        FrameVector<InstanceVertex>& instances = lodInstances[lod - 1];
+        instancesModelMatrix.insert(instancesModelMatrix.end(), instances.begin(), instances.end());
+        instances.clear();
+        lodOffsets[lod + 1] = static_cast<uint32_t>(instancesModelMatrix.size());
+    }
+    return lodOffsets;
+}
+
+template <class IdxType> requires std::is_integral_v<IdxType>
+void Mesh<IdxType>::DrawSubmeshLods(SubMesh& submesh, const std::array<uint32_t, MAX_MESH_LODS + 1>& lodOffsets, TriangleCounts& counts)
+{
+    for (uint8_t lod = 0; lod < MAX_MESH_LODS; ++lod)
+    {
+        const uint32_t instanceCount = lodOffsets[lod + 1] - lodOffsets[lod];
+        if (instanceCount == 0)
+            continue;
+
+        submesh.DrawLod(renderDevice, lod, static_cast<int>(instanceCount), static_cast<int>(lodOffsets[lod]));
+        counts.drawn += instanceCount * (submesh.GetLodRange(lod).count / 3);
+        counts.atLod0 += instanceCount * (submesh.indexBufferCount / 3);
+    }
+}
+
 template <class IdxType> requires std::is_integral_v<IdxType>
 void Mesh<IdxType>::Draw(const D3D11Buffer* viewProjBuffer)
 {
+    const auto lodOffsets = GatherLodInstances();
     if (instancesModelMatrix.empty())
         return;
 
@@ -264,7 +489,7 @@ void Mesh<IdxType>::Draw(const D3D11Buffer* viewProjBuffer)
     // Must have an initialised shader
     assert(effectsShader.get());
     InputAssembler::SetPrimitiveTopology(primitiveTopology);
-    InputAssembler::SetVertexBuffer(vertexBuffer, sizeof(MeshVertex), 0);
+    InputAssembler::SetVertexBuffer(vertexBuffer, vertexStride, 0);
     InputAssembler::SetInstanceBuffer(instanceBuffer, sizeof(InstanceVertex), 0);
     InputAssembler::SetIndexBuffer(indexBuffer);
 
@@ -290,7 +515,7 @@ void Mesh<IdxType>::Draw(const D3D11Buffer* viewProjBuffer)
         BindTextures(submesh);
         BindShaders();
 
-        submesh.DrawGeometry(renderDevice, static_cast<int>(instancesModelMatrix.size()));
+        DrawSubmeshLods(submesh, lodOffsets, shadedTriangles);
     }
 
     instancesModelMatrix.clear();
@@ -299,13 +524,14 @@ void Mesh<IdxType>::Draw(const D3D11Buffer* viewProjBuffer)
 template <class IdxType> requires std::is_integral_v<IdxType>
 void Mesh<IdxType>::DrawGeometry()
 {
+    const auto lodOffsets = GatherLodInstances();
     if (instancesModelMatrix.empty())
         return;
 
     instanceBuffer.UpdateData(instancesModelMatrix);
 
     InputAssembler::SetPrimitiveTopology(primitiveTopology);
-    InputAssembler::SetVertexBuffer(vertexBuffer, sizeof(MeshVertex), 0);
+    InputAssembler::SetVertexBuffer(vertexBuffer, vertexStride, 0);
     InputAssembler::SetInstanceBuffer(instanceBuffer, sizeof(InstanceVertex), 0);
     InputAssembler::SetIndexBuffer(indexBuffer);
 
@@ -314,32 +540,23 @@ void Mesh<IdxType>::DrawGeometry()
         if (submesh.indexBufferCount == 0)
             continue;
 
-        submesh.DrawGeometry(renderDevice, static_cast<int>(instancesModelMatrix.size()));
+        DrawSubmeshLods(submesh, lodOffsets, depthOnlyTriangles);
     }
 
     instancesModelMatrix.clear();
 }
 
-template <class IdxType> requires std::is_integral_v<IdxType>
-void Mesh<IdxType>::SetAllMaterialMember(const std::string& textureFilepath, std::string TexturedMaterial::* materialMember)
-{
-    std::ranges::for_each(submeshes,
-        [&](SubMesh& subMesh)
-        {
-            TexturedMaterial mat = subMesh.GetMaterial();
-            mat.*materialMember = textureFilepath;
-            subMesh.SetMaterial(mat);
-        });
-}
-
 template <class IdxType> requires std::is_integral_v<IdxType>
 void Mesh<IdxType>::RenderImGui()
 {
 #ifdef _IMGUI_
     BaseMesh::RenderImGui();
     ImGui::Text("Vertex Count: %d", vertices.size());
+    ImGui::Text("Vertex Stride: %u bytes", vertexStride);
     ImGui::Text("Index Count: %d", indexes.size());
     ImGui::Text("Submesh Count: %d", submeshes.size());
+    for (uint8_t lod = 1; lod < lodCount; ++lod)
+        ImGui::Text("LOD %u error: %.4f", lod, lodErrors[lod]);
 
     if (ImGui::TreeNode(("Submeshes: ##" + name).c_str()))
     {
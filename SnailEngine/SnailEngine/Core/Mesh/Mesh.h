@@ -1,11 +1,17 @@
 #pragma once
 
+#include <array>
+#include <optional>
 #include <PxPhysicsAPI.h>
 #include <vector>
 
+#include "MeshLod.h"
+#include "MeshOptimizer.h"
 #include "SubMesh.h"
+#include "Core/Memory/FrameArena.h"
 #include "Rendering/TexturedMaterial.h"
 #include "Rendering/MeshVertex.h"
+#include "Rendering/Occlusion/OccluderMesh.h"
 #include "Rendering/Shaders/EffectsShader.h"
 
 namespace Snail
@@ -17,13 +23,21 @@ class BaseMesh
 protected:
     D3D11_PRIMITIVE_TOPOLOGY primitiveTopology;
     bool boundsAreDirty = true;
+    VertexFormat vertexFormat = VertexFormat::FULL;
+    // Picked at Init for the compact formats, UNORM16 UVs when they all fit in [0, 1], half floats otherwise
+    bool unitRangeUvs = false;
+    std::unique_ptr<OccluderMesh> occluderMesh;
+    // Set by SetAllMaterialMember, given again to the submeshes of a reloaded geometry
+    std::vector<std::pair<TextureHandle TexturedMaterial::*, TextureHandle>> materialOverrides;
 
     virtual void InitBuffers() = 0;
     virtual void BindBuffers(const D3D11Buffer* vsMatrixes) = 0;
     virtual void BindTextures(const SubMesh& submesh) const = 0;
     virtual void BindShaders() = 0;
+    virtual std::unique_ptr<OccluderMesh> BuildOccluderMesh() const = 0;
 
     static constexpr const char* THIN_TRANSLUCENCY_DEFINE = "THIN_TRANSLUCENCY";
+    static constexpr const char* COMPACT_VERTEX_DEFINE = "COMPACT_VERTEX";
 public:
     enum class CullingType
     {
@@ -31,10 +45,31 @@ public:
     } cullingType = CullingType::BACK;
 
     std::string name;
+    // Hash of the scene description the mesh was built from, lets the next scene reuse it while it is still cached
+    size_t sourceHash = 0;
     Vector3 minBounds, maxBounds;
+    // Average UV units per local unit of surface, computed with the bounds
+    float uvDensity = 0;
 
     std::unique_ptr<EffectsShader> effectsShader;
     std::vector<SubMesh> submeshes;
+    // Set when the geometry went through the import optimization
+    std::optional<MeshOptimizer::Stats> optimizationStats;
+    // LOD 0 included, the LODs of every submesh follow LOD 0 in the index buffer
+    uint8_t lodCount = 1;
+    // Largest simplification error of each LOD, relative to the mesh size
+    std::array<float, MAX_MESH_LODS> lodErrors{};
+
+    struct TriangleCounts
+    {
+        size_t drawn = 0;
+        // What the same instances would have cost without LODs
+        size_t atLod0 = 0;
+    };
+
+    // Triangles drawn since the renderer last reset them, shaded by Draw and depth only by DrawGeometry
+    static inline TriangleCounts shadedTriangles;
+    static inline TriangleCounts depthOnlyTriangles;
 
     BaseMesh(D3D11_PRIMITIVE_TOPOLOGY topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
@@ -46,12 +81,20 @@ public:
     virtual void CalculateTangents() = 0;
     virtual void CalculateBounds() = 0;
 
-    virtual void SubscribeInstance(Matrix m) = 0;
+    virtual void SubscribeInstance(Matrix m, uint8_t lod = 0) = 0;
     virtual void Draw(const D3D11Buffer* vsMatrixes) = 0;
     virtual void DrawGeometry() = 0;
     void SetCullingType(CullingType culling);
     void SetTranslucent(bool newValue);
-    void ReloadShader();
+    virtual void ReloadShader();
+    void SetAllMaterialMember(TextureHandle texture, TextureHandle TexturedMaterial::* materialMember);
+    // Takes the geometry, buffers and shader of a reloaded mesh of the same type, the instances, the culling, the
+    // material overrides and the translucency stay. Returns false when the types differ.
+    virtual bool SwapGeometry(BaseMesh&) { return false; }
+    // Must be set before Init
+    void SetVertexFormat(VertexFormat format) noexcept;
+    [[nodiscard]] VertexFormat GetVertexFormat() const noexcept;
+    [[nodiscard]] virtual size_t GetVertexCount() const noexcept = 0;
 
     [[nodiscard]] std::pair<Vector3, Vector3> GetBounds() noexcept
     {
@@ -62,6 +105,15 @@ public:
         return {minBounds, maxBounds};
     }
 
+    // Geometry rendered by the occlusion culling, built the first time the mesh is used as an occluder
+    const OccluderMesh& GetOccluderMesh();
+
+    // Forwards the on-screen resolution of the mesh to the streamed textures of its materials
+    void RequestTextureResolution(float pixelsPerUv) const;
+
+    // Geometry kept on the CPU and uploaded to the vertex and index buffers
+    virtual AssetMemoryUsage GetMemoryUsage() const = 0;
+
     virtual void RenderImGui() = 0;
 };
 
@@ -76,7 +128,14 @@ protected:
     D3D11Buffer indexBuffer;
 
     D3D11Buffer instanceBuffer;
-    std::vector<InstanceVertex> instancesModelMatrix;
+    // Draw lists, from the frame arena. Every pass draws the instances subscribed since the previous one.
+    FrameVector<InstanceVertex> instancesModelMatrix;
+    // Instances of the simplified LODs, they are moved after the LOD 0 ones in the instance buffer when drawing
+    std::array<FrameVector<InstanceVertex>, MAX_MESH_LODS - 1> lodInstances;
+
+    UINT vertexStride = sizeof(MeshVertex);
+    // Brings quantized positions back to the mesh space, folded into the model matrix of every instance
+    Matrix positionDecodeMatrix = Matrix::Identity;
 
     static constexpr const char* TEXTURE_BLENDING_DEFINE = "TEXTURE_BLENDING";
     static constexpr const char* DRAW_INSTANCED_DEFINE = "DRAW_INSTANCED";
@@ -90,6 +149,13 @@ protected:
 
     void CalculateBounds() override;
     void CalculateTangents() override;
+
+    // Coarsest LOD whose error is under OccluderMesh::MAX_LOD_ERROR
+    std::unique_ptr<OccluderMesh> BuildOccluderMesh() const override;
+
+    // Returns where the instances of each LOD start in instancesModelMatrix, the last entry being the instance count
+    std::array<uint32_t, MAX_MESH_LODS + 1> GatherLodInstances();
+    void DrawSubmeshLods(SubMesh& submesh, const std::array<uint32_t, MAX_MESH_LODS + 1>& lodOffsets, TriangleCounts& counts);
 public:
     void Init() override;
 
@@ -100,19 +166,22 @@ public:
 
     void SetEnableBlending(bool newValue);
     bool GetBlendingEnabled() const;
+    bool SwapGeometry(BaseMesh& reloaded) override;
     std::vector<IndexType>& GetIndexes();
     std::vector<MeshVertex>& GetVertices();
     uint32_t GetIndexCount();
+    size_t GetVertexCount() const noexcept override;
+    // Indices of LOD 0, which come before those of the other LODs
+    uint32_t GetBaseIndexCount() const;
+    AssetMemoryUsage GetMemoryUsage() const override;
 
-    void SubscribeInstance(Matrix m) override;
+    void SubscribeInstance(Matrix m, uint8_t lod = 0) override;
     void Draw(const D3D11Buffer* viewProjBuffer) override;
     void DrawGeometry() override;
 
     std::vector<MeshVertex> vertices;
     std::vector<IndexType> indexes;
 
-    void SetAllMaterialMember(const std::string& textureFilepath, std::string TexturedMaterial::* materialMember);
-
     void RenderImGui() override;
 };
 }
@@ -0,0 +1,29 @@
+#include "stdafx.h"
+#include "MeshLod.h"
+
+namespace Snail
+{
+
+uint8_t MeshLodSelector::Select(const float coverage, const uint8_t previousLod, const uint8_t lodCount) noexcept
+{
+    if (lodCount <= 1)
+        return 0;
+
+#ifdef _IMGUI_
+    if (forcedLod >= 0)
+        return static_cast<uint8_t>(std::min(forcedLod, lodCount - 1));
+#endif
+
+    uint8_t lod = 0;
+    while (lod + 1 < lodCount && coverage < LOD_SCREEN_COVERAGE[lod + 1])
+        ++lod;
+
+    const uint8_t previous = std::min<uint8_t>(previousLod, lodCount - 1);
+    if (lod > previous && coverage > LOD_SCREEN_COVERAGE[previous + 1] * (1 - HYSTERESIS))
+        return previous;
+    if (lod < previous && coverage < LOD_SCREEN_COVERAGE[previous] * (1 + HYSTERESIS))
+        return previous;
+    return lod;
+}
+
+}
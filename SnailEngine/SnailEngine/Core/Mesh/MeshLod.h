@@ -0,0 +1,35 @@
+#pragma once
+#include <array>
+
+namespace Snail
+{
+
+// LOD 0 plus up to three simplified versions built at import
+inline constexpr uint8_t MAX_MESH_LODS = 4;
+// The camera, then every shadow cascade of every directional light
+inline constexpr size_t MAX_LOD_VIEWS = 16;
+
+// LOD an entity was last drawn with in each view, kept between frames for the hysteresis
+struct MeshLodState
+{
+    std::array<uint8_t, MAX_LOD_VIEWS> lods{};
+};
+
+// Picks LODs from the fraction of the view height covered by the bounding sphere of what is drawn
+class MeshLodSelector
+{
+public:
+    // Each LOD is used once the coverage goes under its threshold, LOD 0 has none
+    static constexpr std::array<float, MAX_MESH_LODS> LOD_SCREEN_COVERAGE = {1.0f, 0.35f, 0.15f, 0.06f};
+    // Coverage has to go this much further past a threshold to switch back, so that nothing pops back and forth on it
+    static constexpr float HYSTERESIS = 0.15f;
+
+    [[nodiscard]] static uint8_t Select(float coverage, uint8_t previousLod, uint8_t lodCount) noexcept;
+
+#ifdef _IMGUI_
+    // Every mesh uses this LOD when it is set, -1 for the normal selection
+    static inline int forcedLod = -1;
+#endif
+};
+
+}
@@ -0,0 +1,316 @@
+#include "stdafx.h"
+#include "MeshOptimizer.h"
+
+#include <array>
+#include <cmath>
+#include <numeric>
+
+#include "SubMesh.h"
+
+namespace Snail
+{
+
+namespace
+{
+
+// Tom Forsyth's scoring, with his published constants
+constexpr size_t FORSYTH_CACHE_SIZE = 32;
+constexpr float CACHE_DECAY_POWER = 1.5f;
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+constexpr uint32_t NO_TRIANGLE = std::numeric_limits<uint32_t>::max();
+
+float GetVertexScore(const int cachePosition, const uint32_t remainingTriangles)
+{
+    // Vertices without triangles left must never attract the next pick
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0;
+    if (cachePosition >= 0)
+    {
+        // The vertices of the last triangle get a fixed score so that strips don't get favored over fans
+        if (cachePosition < 3)
+            score = LAST_TRIANGLE_SCORE;
+        else
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / (FORSYTH_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+    }
+
+    // Vertices with few triangles left are finished first so that they leave the working set
+    return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+}
+
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::span<const uint32_t> indices, const size_t vertexCount, const size_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indices.empty())
+        return stats;
+
+    // A vertex is still cached if fewer than cacheSize misses happened since it was last transformed
+    std::vector<size_t> missTimestamps(vertexCount, 0);
+    std::vector<uint8_t> used(vertexCount, false);
+    size_t misses = 0;
+    size_t usedCount = 0;
+    for (const uint32_t index : indices)
+    {
+        if (!used[index])
+        {
+            used[index] = true;
+            ++usedCount;
+        }
+
+        if (missTimestamps[index] == 0 || misses + 1 - missTimestamps[index] > cacheSize)
+            missTimestamps[index] = ++misses;
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(usedCount);
+    return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(const std::span<uint32_t> indices, const size_t vertexCount)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    // Triangles of every vertex, the ones not emitted yet are kept at the front of its range
+    std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+    for (const uint32_t index : indices)
+        ++remainingTriangles[index];
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    std::inclusive_scan(remainingTriangles.begin(), remainingTriangles.end(), adjacencyOffsets.begin() + 1);
+
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+        vertexScores[vertex] = GetVertexScore(-1, remainingTriangles[vertex]);
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<uint8_t> emitted(triangleCount, false);
+    uint32_t bestTriangle = 0;
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+        if (triangleScores[triangle] > triangleScores[bestTriangle])
+            bestTriangle = static_cast<uint32_t>(triangle);
+    }
+
+    // Vertices of the emitted triangle come first, the cache can briefly hold 3 more before the oldest are evicted
+    std::array<uint32_t, FORSYTH_CACHE_SIZE + 3> cache{};
+    std::array<uint32_t, FORSYTH_CACHE_SIZE + 3> nextCache{};
+    size_t cacheCount = 0;
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    size_t scanCursor = 0;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        // Nothing in the cache leads anywhere, restart from the first triangle not drawn yet
+        if (bestTriangle == NO_TRIANGLE)
+        {
+            while (emitted[scanCursor])
+                ++scanCursor;
+            bestTriangle = static_cast<uint32_t>(scanCursor);
+        }
+
+        emitted[bestTriangle] = true;
+        const std::array triangleVertices = {indices[bestTriangle * 3], indices[bestTriangle * 3 + 1], indices[bestTriangle * 3 + 2]};
+        output.insert(output.end(), triangleVertices.begin(), triangleVertices.end());
+
+        size_t nextCacheCount = 0;
+        for (const uint32_t vertex : triangleVertices)
+        {
+            nextCache[nextCacheCount++] = vertex;
+
+            // Moves the triangle past the remaining ones of the vertex
+            const uint32_t begin = adjacencyOffsets[vertex];
+            const uint32_t last = begin + --remainingTriangles[vertex];
+            for (uint32_t i = begin; i <= last; ++i)
+            {
+                if (adjacency[i] == bestTriangle)
+                {
+                    std::swap(adjacency[i], adjacency[last]);
+                    break;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < cacheCount; ++i)
+        {
+            const uint32_t vertex = cache[i];
+            if (std::ranges::find(triangleVertices, vertex) == triangleVertices.end())
+                nextCache[nextCacheCount++] = vertex;
+        }
+
+        std::swap(cache, nextCache);
+        cacheCount = nextCacheCount;
+
+        // Evicted vertices are rescored too, they lose their cache bonus
+        for (size_t i = 0; i < cacheCount; ++i)
+        {
+            const uint32_t vertex = cache[i];
+            cachePositions[vertex] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+            vertexScores[vertex] = GetVertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+        }
+
+        bestTriangle = NO_TRIANGLE;
+        float bestScore = -std::numeric_limits<float>::max();
+        for (size_t i = 0; i < cacheCount; ++i)
+        {
+            const uint32_t vertex = cache[i];
+            const uint32_t begin = adjacencyOffsets[vertex];
+            for (uint32_t j = begin; j < begin + remainingTriangles[vertex]; ++j)
+            {
+                const uint32_t triangle = adjacency[j];
+                const float score = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+                triangleScores[triangle] = score;
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestTriangle = triangle;
+                }
+            }
+        }
+
+        cacheCount = std::min(cacheCount, FORSYTH_CACHE_SIZE);
+    }
+
+    std::ranges::copy(output, indices.begin());
+}
+
+size_t MeshOptimizer::OptimizeOverdraw(const std::span<uint32_t> indices, const std::span<const MeshVertex> vertices)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return 0;
+
+    // A cluster starts on every triangle whose 3 vertices miss the cache, reordering clusters then costs no extra misses
+    std::vector<uint32_t> clusterStarts;
+    {
+        std::vector<size_t> missTimestamps(vertices.size(), 0);
+        size_t misses = 0;
+        for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            size_t triangleMisses = 0;
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const uint32_t index = indices[triangle * 3 + k];
+                if (missTimestamps[index] == 0 || misses + 1 - missTimestamps[index] > ANALYSIS_CACHE_SIZE)
+                {
+                    missTimestamps[index] = ++misses;
+                    ++triangleMisses;
+                }
+            }
+
+            if (triangleMisses == 3)
+                clusterStarts.push_back(static_cast<uint32_t>(triangle));
+        }
+    }
+    clusterStarts.push_back(static_cast<uint32_t>(triangleCount));
+
+    const size_t clusterCount = clusterStarts.size() - 1;
+    if (clusterCount < 2)
+        return clusterCount;
+
+    Vector3 meshCentroid;
+    float meshArea = 0;
+    std::vector<Vector3> clusterCentroids(clusterCount);
+    std::vector<Vector3> clusterNormals(clusterCount);
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+    {
+        float clusterArea = 0;
+        for (size_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; ++triangle)
+        {
+            const Vector3& a = vertices[indices[triangle * 3]].position;
+            const Vector3& b = vertices[indices[triangle * 3 + 1]].position;
+            const Vector3& c = vertices[indices[triangle * 3 + 2]].position;
+
+            // Length is twice the area, its direction follows the winding
+            const Vector3 normal = (b - a).Cross(c - a);
+            const float area = normal.Length();
+            clusterCentroids[cluster] += (a + b + c) * (area / 3.0f);
+            clusterNormals[cluster] += normal;
+            clusterArea += area;
+        }
+
+        meshCentroid += clusterCentroids[cluster];
+        meshArea += clusterArea;
+        if (clusterArea > 0)
+            clusterCentroids[cluster] /= clusterArea;
+        clusterNormals[cluster].Normalize();
+    }
+    if (meshArea > 0)
+        meshCentroid /= meshArea;
+
+    // Clusters far out along their own normal are unlikely to be hidden by the rest of the mesh, they are drawn first
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t cluster = 0; cluster < clusterCount; ++cluster)
+        sortKeys[cluster] = (clusterCentroids[cluster] - meshCentroid).Dot(clusterNormals[cluster]);
+
+    std::vector<uint32_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(order, [&](const uint32_t a, const uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (const uint32_t cluster : order)
+        output.insert(output.end(), indices.begin() + clusterStarts[cluster] * 3, indices.begin() + clusterStarts[cluster + 1] * 3);
+
+    std::ranges::copy(output, indices.begin());
+    return clusterCount;
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<MeshVertex>& vertices, const std::span<uint32_t> indices)
+{
+    constexpr uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> remap(vertices.size(), UNUSED);
+    std::vector<MeshVertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == UNUSED)
+        {
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices = std::move(reordered);
+}
+
+MeshOptimizer::Stats MeshOptimizer::Optimize(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, const std::span<const SubMesh> submeshes)
+{
+    Stats stats;
+    stats.before = AnalyzeVertexCache(indices, vertices.size());
+    stats.indexBytesBefore = indices.size() * sizeof(uint32_t);
+
+    for (const SubMesh& submesh : submeshes)
+    {
+        const std::span range{indices.data() + submesh.indexBufferStartIndex, submesh.indexBufferCount};
+        OptimizeVertexCache(range, vertices.size());
+        stats.clusterCount += OptimizeOverdraw(range, vertices);
+    }
+    OptimizeVertexFetch(vertices, indices);
+
+    stats.after = AnalyzeVertexCache(indices, vertices.size());
+    stats.indexBytesAfter = indices.size() * (FitsIn16BitIndices(vertices.size()) ? sizeof(uint16_t) : sizeof(uint32_t));
+    return stats;
+}
+
+}
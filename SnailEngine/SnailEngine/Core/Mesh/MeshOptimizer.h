@@ -0,0 +1,57 @@
+#pragma once
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "Rendering/MeshVertex.h"
+
+namespace Snail
+{
+class SubMesh;
+
+// Import time reordering of triangle meshes for the GPU: post-transform vertex cache, then overdraw, then vertex fetch.
+// Triangles only move within their submesh, so submesh ranges stay valid, and their winding is kept.
+class MeshOptimizer
+{
+public:
+    // Size of the FIFO cache the statistics are measured with, close to what current GPUs reuse
+    static constexpr size_t ANALYSIS_CACHE_SIZE = 16;
+
+    struct VertexCacheStats
+    {
+        // Vertices transformed per triangle, 0.5 at best for big regular meshes and 3 at worst
+        float acmr = 0;
+        // Vertices transformed per vertex used, 1 at best
+        float atvr = 0;
+    };
+
+    struct Stats
+    {
+        VertexCacheStats before;
+        VertexCacheStats after;
+        size_t indexBytesBefore = 0;
+        size_t indexBytesAfter = 0;
+        size_t clusterCount = 0;
+    };
+
+    [[nodiscard]] static VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, size_t cacheSize = ANALYSIS_CACHE_SIZE);
+
+    // Forsyth's linear speed vertex cache optimization over a triangle list
+    static void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount);
+    // Splits cache optimized triangles where the cache starts cold and draws the outward facing clusters first.
+    // Returns the number of clusters.
+    static size_t OptimizeOverdraw(std::span<uint32_t> indices, std::span<const MeshVertex> vertices);
+    // Orders vertices by first use and drops the unused ones
+    static void OptimizeVertexFetch(std::vector<MeshVertex>& vertices, std::span<uint32_t> indices);
+
+    // Whole mesh optimization, index bytes are counted for the narrowest index type that fits
+    static Stats Optimize(std::vector<MeshVertex>& vertices, std::vector<uint32_t>& indices, std::span<const SubMesh> submeshes);
+
+    // Every index fits in 16 bits, with 0xFFFF left out since it cuts strips
+    [[nodiscard]] static constexpr bool FitsIn16BitIndices(const size_t vertexCount) noexcept
+    {
+        return vertexCount < std::numeric_limits<uint16_t>::max();
+    }
+};
+
+}
@@ -0,0 +1,396 @@
+#include "stdafx.h"
+#include "MeshSimplifier.h"
+
+#include <bit>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+#include "MeshOptimizer.h"
+#include "SubMesh.h"
+
+namespace Snail
+{
+
+namespace
+{
+
+constexpr uint32_t NO_VERTEX = std::numeric_limits<uint32_t>::max();
+
+// Sum of squared distances to planes, weighted by the area of the triangles they come from
+struct Quadric
+{
+    // Upper triangle of the symmetric 4x4 matrix
+    double a2 = 0, ab = 0, ac = 0, ad = 0;
+    double b2 = 0, bc = 0, bd = 0;
+    double c2 = 0, cd = 0;
+    double d2 = 0;
+    double weight = 0;
+
+    void AddPlane(const Vector3& n, const double d, const double w) noexcept
+    {
+        const double a = n.x, b = n.y, c = n.z;
+        a2 += w * a * a; ab += w * a * b; ac += w * a * c; ad += w * a * d;
+        b2 += w * b * b; bc += w * b * c; bd += w * b * d;
+        c2 += w * c * c; cd += w * c * d;
+        d2 += w * d * d;
+        weight += w;
+    }
+
+    Quadric& operator+=(const Quadric& q) noexcept
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd;
+        d2 += q.d2;
+        weight += q.weight;
+        return *this;
+    }
+
+    [[nodiscard]] double Evaluate(const Vector3& p) const noexcept
+    {
+        const double x = p.x, y = p.y, z = p.z;
+        return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+            + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+            + c2 * z * z + 2 * cd * z
+            + d2;
+    }
+};
+
+struct PositionHash
+{
+    size_t operator()(const Vector3& p) const noexcept
+    {
+        // Adding zero turns -0 into 0, they compare equal so they must hash the same
+        const uint64_t x = std::bit_cast<uint32_t>(p.x + 0.0f), y = std::bit_cast<uint32_t>(p.y + 0.0f), z = std::bit_cast<uint32_t>(p.z + 0.0f);
+        return std::hash<uint64_t>{}(x * 73856093 ^ y * 19349663 ^ z * 83492791);
+    }
+};
+
+struct PositionEqual
+{
+    bool operator()(const Vector3& a, const Vector3& b) const noexcept
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+};
+
+// Real-Time Collision Detection, 5.1.5
+Vector3 ClosestPointOnTriangle(const Vector3& p, const Vector3& a, const Vector3& b, const Vector3& c) noexcept
+{
+    const Vector3 ab = b - a, ac = c - a, ap = p - a;
+    const float d1 = ab.Dot(ap), d2 = ac.Dot(ap);
+    if (d1 <= 0 && d2 <= 0)
+        return a;
+
+    const Vector3 bp = p - b;
+    const float d3 = ab.Dot(bp), d4 = ac.Dot(bp);
+    if (d3 >= 0 && d4 <= d3)
+        return b;
+
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0)
+        return a + ab * (d1 / (d1 - d3));
+
+    const Vector3 cp = p - c;
+    const float d5 = ab.Dot(cp), d6 = ac.Dot(cp);
+    if (d6 >= 0 && d5 <= d6)
+        return c;
+
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0)
+        return a + ac * (d2 / (d2 - d6));
+
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    const float denominator = 1 / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+float DirectedHausdorffDistance(const std::span<const MeshVertex> vertices, const std::span<const uint32_t> from, const std::span<const uint32_t> to)
+{
+    float maxDistanceSquared = 0;
+    for (size_t i = 0; i + 2 < from.size(); i += 3)
+    {
+        const Vector3& p0 = vertices[from[i]].position;
+        const Vector3& p1 = vertices[from[i + 1]].position;
+        const Vector3& p2 = vertices[from[i + 2]].position;
+
+        for (const Vector3& sample : {p0, p1, p2, (p0 + p1 + p2) / 3})
+        {
+            float minDistanceSquared = std::numeric_limits<float>::max();
+            for (size_t j = 0; j + 2 < to.size() && minDistanceSquared > maxDistanceSquared; j += 3)
+            {
+                const Vector3 closest = ClosestPointOnTriangle(sample, vertices[to[j]].position, vertices[to[j + 1]].position, vertices[to[j + 2]].position);
+                minDistanceSquared = std::min(minDistanceSquared, Vector3::DistanceSquared(sample, closest));
+            }
+            // Samples closer than the current maximum can't raise it, the inner loop stops as soon as it knows
+            maxDistanceSquared = std::max(maxDistanceSquared, minDistanceSquared);
+        }
+    }
+    return std::sqrt(maxDistanceSquared);
+}
+
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify(const std::span<const MeshVertex> vertices, const std::span<const uint32_t> indices, const size_t targetIndexCount, const float maxError, float& resultError)
+{
+    resultError = 0;
+    std::vector<uint32_t> result(indices.begin(), indices.end());
+    if (result.size() <= targetIndexCount || vertices.empty())
+        return result;
+
+    const size_t vertexCount = vertices.size();
+
+    // Positions relative to the mesh size, so that the errors don't depend on its units
+    Vector3 minBounds{std::numeric_limits<float>::max()}, maxBounds{std::numeric_limits<float>::lowest()};
+    for (const MeshVertex& vertex : vertices)
+    {
+        minBounds = Vector3::Min(minBounds, vertex.position);
+        maxBounds = Vector3::Max(maxBounds, vertex.position);
+    }
+    const Vector3 size = maxBounds - minBounds;
+    const float extent = std::max({size.x, size.y, size.z});
+    const float invScale = extent > 0 ? 1 / extent : 1;
+
+    std::vector<Vector3> positions(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+        positions[i] = (vertices[i].position - minBounds) * invScale;
+
+    std::vector<uint8_t> locked(vertexCount, 0);
+    {
+        // Several vertices at one position make a seam, edges are then counted on positions so that seams aren't borders
+        std::unordered_map<Vector3, uint32_t, PositionHash, PositionEqual> firstAtPosition;
+        std::vector<uint32_t> canonical(vertexCount, NO_VERTEX);
+        for (const uint32_t index : result)
+        {
+            if (canonical[index] != NO_VERTEX)
+                continue;
+
+            const auto [it, inserted] = firstAtPosition.try_emplace(vertices[index].position, index);
+            canonical[index] = it->second;
+            if (!inserted)
+            {
+                locked[index] = 1;
+                locked[it->second] = 1;
+            }
+        }
+
+        std::unordered_map<uint64_t, uint32_t> edgeUses;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const uint32_t a = canonical[result[i + k]];
+                const uint32_t b = canonical[result[i + (k + 1) % 3]];
+                ++edgeUses[static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b)];
+            }
+        }
+
+        // Open borders and non manifold edges
+        for (const auto& [edge, uses] : edgeUses)
+        {
+            if (uses == 2)
+                continue;
+            locked[static_cast<uint32_t>(edge >> 32)] = 1;
+            locked[static_cast<uint32_t>(edge)] = 1;
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < result.size(); i += 3)
+    {
+        const Vector3& p0 = positions[result[i]];
+        Vector3 normal = (positions[result[i + 1]] - p0).Cross(positions[result[i + 2]] - p0);
+        const float doubleArea = normal.Length();
+        if (doubleArea <= 0)
+            continue;
+
+        normal /= doubleArea;
+        const double d = -normal.Dot(p0);
+        for (size_t k = 0; k < 3; ++k)
+            quadrics[result[i + k]].AddPlane(normal, d, doubleArea * 0.5);
+    }
+
+    // Squared error of moving u onto v, the triangles of u take the attributes of v
+    const auto collapseError = [&](const uint32_t u, const uint32_t v)
+    {
+        Quadric q = quadrics[u];
+        q += quadrics[v];
+        const double positionError = std::max(q.Evaluate(positions[v]), 0.0) / std::max(q.weight, 1e-12);
+        const float attributeError = NORMAL_WEIGHT * (vertices[u].normal - vertices[v].normal).LengthSquared()
+            + UV_WEIGHT * (vertices[u].uv - vertices[v].uv).LengthSquared();
+        return static_cast<float>(positionError) + attributeError;
+    };
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacencyCursors(vertexCount);
+    std::vector<uint32_t> adjacency;
+    std::vector<float> collapseCosts(vertexCount);
+    std::vector<uint32_t> collapseTargets(vertexCount);
+    std::vector<uint32_t> collapseRemap(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<uint32_t> candidates;
+
+    const auto trianglesAround = [&](const uint32_t vertex)
+    {
+        return std::span{adjacency}.subspan(adjacencyOffsets[vertex], adjacencyOffsets[vertex + 1] - adjacencyOffsets[vertex]);
+    };
+
+    // Moving u onto v must not turn any remaining triangle around
+    const auto flipsTriangles = [&](const uint32_t u, const uint32_t v)
+    {
+        for (const uint32_t triangle : trianglesAround(u))
+        {
+            const uint32_t* corners = &result[triangle * 3];
+            if (corners[0] == v || corners[1] == v || corners[2] == v)
+                continue;
+
+            std::array<Vector3, 3> before, after;
+            for (size_t k = 0; k < 3; ++k)
+            {
+                before[k] = positions[corners[k]];
+                after[k] = corners[k] == u ? positions[v] : before[k];
+            }
+            const Vector3 normalBefore = (before[1] - before[0]).Cross(before[2] - before[0]);
+            const Vector3 normalAfter = (after[1] - after[0]).Cross(after[2] - after[0]);
+            if (normalBefore.Dot(normalAfter) <= 0)
+                return true;
+        }
+        return false;
+    };
+
+    const float maxErrorSquared = maxError * maxError;
+    float maxCollapseError = 0;
+
+    // Every pass collapses the cheapest edges that don't share a triangle, then rebuilds the triangles
+    while (result.size() > targetIndexCount)
+    {
+        std::ranges::fill(adjacencyOffsets, 0);
+        for (const uint32_t index : result)
+            ++adjacencyOffsets[index + 1];
+        std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+        std::copy(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1, adjacencyCursors.begin());
+        adjacency.resize(result.size());
+        for (size_t i = 0; i < result.size(); ++i)
+            adjacency[adjacencyCursors[result[i]]++] = static_cast<uint32_t>(i / 3);
+
+        std::ranges::fill(collapseCosts, std::numeric_limits<float>::max());
+        candidates.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const uint32_t u = result[i + k];
+                if (locked[u])
+                    continue;
+
+                for (const uint32_t v : {result[i + (k + 1) % 3], result[i + (k + 2) % 3]})
+                {
+                    const float cost = collapseError(u, v);
+                    if (cost >= collapseCosts[u])
+                        continue;
+
+                    if (collapseCosts[u] == std::numeric_limits<float>::max())
+                        candidates.push_back(u);
+                    collapseCosts[u] = cost;
+                    collapseTargets[u] = v;
+                }
+            }
+        }
+        std::ranges::sort(candidates, [&](const uint32_t a, const uint32_t b) { return collapseCosts[a] < collapseCosts[b]; });
+
+        std::ranges::fill(touched, 0);
+        std::iota(collapseRemap.begin(), collapseRemap.end(), 0);
+        size_t removedIndices = 0;
+        size_t collapseCount = 0;
+        for (const uint32_t u : candidates)
+        {
+            if (collapseCosts[u] > maxErrorSquared || result.size() - removedIndices <= targetIndexCount)
+                break;
+
+            const uint32_t v = collapseTargets[u];
+            if (touched[u] || touched[v] || flipsTriangles(u, v))
+                continue;
+
+            // The costs around u were computed on the surface before this collapse, they wait for the next pass
+            for (const uint32_t triangle : trianglesAround(u))
+            {
+                const uint32_t* corners = &result[triangle * 3];
+                touched[corners[0]] = touched[corners[1]] = touched[corners[2]] = 1;
+                if (corners[0] == v || corners[1] == v || corners[2] == v)
+                    removedIndices += 3;
+            }
+
+            collapseRemap[u] = v;
+            quadrics[v] += quadrics[u];
+            maxCollapseError = std::max(maxCollapseError, collapseCosts[u]);
+            ++collapseCount;
+        }
+
+        if (collapseCount == 0)
+            break;
+
+        size_t kept = 0;
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            const uint32_t a = collapseRemap[result[i]], b = collapseRemap[result[i + 1]], c = collapseRemap[result[i + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            result[kept++] = a;
+            result[kept++] = b;
+            result[kept++] = c;
+        }
+        result.resize(kept);
+    }
+
+    resultError = std::sqrt(maxCollapseError);
+    return result;
+}
+
+MeshSimplifier::LodStats MeshSimplifier::BuildLods(const std::span<const MeshVertex> vertices, std::vector<uint32_t>& indices, const std::span<SubMesh> submeshes)
+{
+    LodStats stats;
+    for (SubMesh& submesh : submeshes)
+    {
+        // Copied since the LODs are appended to the same indices
+        const std::vector<uint32_t> baseIndices(indices.begin() + submesh.indexBufferStartIndex, indices.begin() + submesh.indexBufferStartIndex + submesh.indexBufferCount);
+        size_t previousIndexCount = baseIndices.size();
+
+        // Every LOD starts from LOD 0 so that its error is measured against the original surface
+        for (uint8_t lod = 1; lod < MAX_MESH_LODS; ++lod)
+        {
+            const size_t targetIndexCount = static_cast<size_t>(static_cast<float>(baseIndices.size() / 3) * LOD_TRIANGLE_RATIOS[lod]) * 3;
+            float error;
+            std::vector<uint32_t> lodIndices = Simplify(vertices, baseIndices, targetIndexCount, LOD_MAX_ERRORS[lod], error);
+            if (lodIndices.empty() || static_cast<float>(lodIndices.size()) > static_cast<float>(previousIndexCount) * MIN_LOD_REDUCTION)
+                break;
+
+            MeshOptimizer::OptimizeVertexCache(lodIndices, vertices.size());
+            submesh.lodRanges[lod - 1] = {static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lodIndices.size())};
+            submesh.lodCount = lod + 1;
+            indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+
+            previousIndexCount = lodIndices.size();
+            stats.errors[lod] = std::max(stats.errors[lod], error);
+        }
+
+        stats.lodCount = std::max(stats.lodCount, submesh.lodCount);
+    }
+
+    // Submeshes with fewer LODs keep drawing their coarsest one
+    for (const SubMesh& submesh : submeshes)
+        for (uint8_t lod = 0; lod < stats.lodCount; ++lod)
+            stats.triangleCounts[lod] += submesh.GetLodRange(lod).count / 3;
+
+    return stats;
+}
+
+float MeshSimplifier::ComputeHausdorffDistance(const std::span<const MeshVertex> vertices, const std::span<const uint32_t> a, const std::span<const uint32_t> b)
+{
+    return std::max(DirectedHausdorffDistance(vertices, a, b), DirectedHausdorffDistance(vertices, b, a));
+}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <array>
+#include <span>
+#include <vector>
+
+#include "MeshLod.h"
+#include "Rendering/MeshVertex.h"
+
+namespace Snail
+{
+class SubMesh;
+
+// Import time quadric error simplification, builds the LOD chain of imported meshes.
+// Edges collapse onto one of their vertices, so every LOD indexes the vertices of LOD 0.
+class MeshSimplifier
+{
+public:
+    // Attribute errors added to the squared position error, positions being taken relative to the mesh size
+    static constexpr float NORMAL_WEIGHT = 5e-4f;
+    static constexpr float UV_WEIGHT = 1e-2f;
+
+    // Share of the LOD 0 triangles each LOD aims for, and the error at which it stops on the way
+    static constexpr std::array<float, MAX_MESH_LODS> LOD_TRIANGLE_RATIOS = {1.0f, 0.5f, 0.25f, 0.125f};
+    static constexpr std::array<float, MAX_MESH_LODS> LOD_MAX_ERRORS = {0.0f, 0.01f, 0.03f, 0.08f};
+    // A LOD keeping more than this share of the previous one isn't worth its indices
+    static constexpr float MIN_LOD_REDUCTION = 0.8f;
+
+    struct LodStats
+    {
+        uint8_t lodCount = 1;
+        std::array<size_t, MAX_MESH_LODS> triangleCounts{};
+        // Largest error of each LOD over all submeshes, relative to the mesh size
+        std::array<float, MAX_MESH_LODS> errors{};
+    };
+
+    // Collapses edges until there are at most targetIndexCount indices or the next collapse costs more than maxError.
+    // Vertices on open borders and seams, where several vertices share a position, never move, which also keeps
+    // the borders between submeshes. Errors are distances relative to the mesh size, resultError is the largest collapse.
+    [[nodiscard]] static std::vector<uint32_t> Simplify(std::span<const MeshVertex> vertices, std::span<const uint32_t> indices, size_t targetIndexCount, float maxError, float& resultError);
+
+    // Appends the LODs of every submesh after the existing indices
+    static LodStats BuildLods(std::span<const MeshVertex> vertices, std::vector<uint32_t>& indices, std::span<SubMesh> submeshes);
+
+    // Symmetric Hausdorff distance between two triangle lists over the same vertices, sampled at the corners and
+    // centers of the triangles. Brute force, meant for tests.
+    [[nodiscard]] static float ComputeHausdorffDistance(std::span<const MeshVertex> vertices, std::span<const uint32_t> a, std::span<const uint32_t> b);
+};
+
+}
@@ -11,12 +11,16 @@ SubMesh::SubMesh(const SubMesh& subMesh)
 {
     indexBufferCount = subMesh.indexBufferCount;
     indexBufferStartIndex = subMesh.indexBufferStartIndex;
+    lodRanges = subMesh.lodRanges;
+    lodCount = subMesh.lodCount;
 }
 
 SubMesh& SubMesh::operator=(const SubMesh& subMesh)
 {
     indexBufferCount = subMesh.indexBufferCount;
     indexBufferStartIndex = subMesh.indexBufferStartIndex;
+    lodRanges = subMesh.lodRanges;
+    lodCount = subMesh.lodCount;
     material = subMesh.material;
     return *this;
 }
@@ -25,6 +29,20 @@ void SubMesh::DrawGeometry(D3D11Device* renderDevice, const int instancesCount)
 {
     renderDevice->DrawIndexedInstanced(indexBufferCount, instancesCount, indexBufferStartIndex);
 }
+
+void SubMesh::DrawLod(D3D11Device* renderDevice, const uint8_t lod, const int instancesCount, const int startInstance)
+{
+    const IndexRange range = GetLodRange(lod);
+    renderDevice->DrawIndexedInstanced(static_cast<int>(range.count), instancesCount, static_cast<int>(range.start), 0, startInstance);
+}
+
+SubMesh::IndexRange SubMesh::GetLodRange(const uint8_t lod) const noexcept
+{
+    const uint8_t clampedLod = std::min<uint8_t>(lod, lodCount - 1);
+    if (clampedLod == 0)
+        return {indexBufferStartIndex, indexBufferCount};
+    return lodRanges[clampedLod - 1];
+}
 const D3D11Buffer& SubMesh::GetMaterialBuffer() const noexcept
 {
     if (isBufferDirty)
@@ -50,47 +68,49 @@ void SubMesh::RenderImGui(const int id)
     static TextureManager& tm = WindowsEngine::GetModule<TextureManager>();
     ImGui::Text(("Index Start Index: " + std::to_string(indexBufferStartIndex)).c_str());
     ImGui::Text(("Index Count: " + std::to_string(indexBufferCount)).c_str());
+    for (uint8_t lod = 1; lod < lodCount; ++lod)
+        ImGui::Text("LOD %u Index Count: %u", lod, lodRanges[lod - 1].count);
 
     if (ImGui::TreeNode(("Material:##" + std::to_string(id)).c_str()))
     {
-        if (ImGui::TreeNode(("Diffuse: " + material.diffuseTexture + "##" + material.diffuseTexture).c_str()))
+        if (ImGui::TreeNode(("Diffuse: " + tm.GetAssetName(material.diffuseTexture) + "##diffuseTexture").c_str()))
         {
-            tm.GetTexture2D(material.diffuseTexture)->RenderImGui();
+            tm.GetTexture2D(material.diffuseTexture, GetDefaultTexture(&TexturedMaterial::diffuseTexture))->RenderImGui();
             ImGui::TreePop();
         }
-        if (ImGui::TreeNode(("Primary Blend Diffuse Texture: " + material.primaryBlendDiffuseTexture + "##" + material.primaryBlendDiffuseTexture).c_str()))
+        if (ImGui::TreeNode(("Primary Blend Diffuse Texture: " + tm.GetAssetName(material.primaryBlendDiffuseTexture) + "##primaryBlendDiffuseTexture").c_str()))
         {
-            tm.GetTexture2D(material.primaryBlendDiffuseTexture)->RenderImGui();
+            tm.GetTexture2D(material.primaryBlendDiffuseTexture, GetDefaultTexture(&TexturedMaterial::primaryBlendDiffuseTexture))->RenderImGui();
             ImGui::TreePop();
         }
-        if (ImGui::TreeNode(("Primary Blend Texture: " + material.primaryBlendTexture + "##" + material.primaryBlendTexture).c_str()))
+        if (ImGui::TreeNode(("Primary Blend Texture: " + tm.GetAssetName(material.primaryBlendTexture) + "##primaryBlendTexture").c_str()))
         {
-            tm.GetTexture2D(material.primaryBlendTexture)->RenderImGui();
+            tm.GetTexture2D(material.primaryBlendTexture, GetDefaultTexture(&TexturedMaterial::primaryBlendTexture))->RenderImGui();
             ImGui::TreePop();
         }
-        if (ImGui::TreeNode(("Secondary Blend Diffuse Texture: " + material.secondaryBlendDiffuseTexture + "##" + material.secondaryBlendDiffuseTexture).c_str()))
+        if (ImGui::TreeNode(("Secondary Blend Diffuse Texture: " + tm.GetAssetName(material.secondaryBlendDiffuseTexture) + "##secondaryBlendDiffuseTexture").c_str()))
         {
-            tm.GetTexture2D(material.secondaryBlendDiffuseTexture)->RenderImGui();
+            tm.GetTexture2D(material.secondaryBlendDiffuseTexture, GetDefaultTexture(&TexturedMaterial::secondaryBlendDiffuseTexture))->RenderImGui();
             ImGui::TreePop();
         }
-        if (ImGui::TreeNode(("Secondary Blend Texture: " + material.secondaryBlendTexture + "##" + material.secondaryBlendTexture).c_str()))
+        if (ImGui::TreeNode(("Secondary Blend Texture: " + tm.GetAssetName(material.secondaryBlendTexture) + "##secondaryBlendTexture").c_str()))
         {
-            tm.GetTexture2D(material.secondaryBlendTexture)->RenderImGui();
+            tm.GetTexture2D(material.secondaryBlendTexture, GetDefaultTexture(&TexturedMaterial::secondaryBlendTexture))->RenderImGui();
             ImGui::TreePop();
         }
-        if (ImGui::TreeNode(("Normal Map: " + material.normalMapTexture + "##" + material.normalMapTexture).c_str()))
+        if (ImGui::TreeNode(("Normal Map: " + tm.GetAssetName(material.normalMapTexture) + "##normalMapTexture").c_str()))
         {
-            tm.GetTexture2D(material.normalMapTexture)->RenderImGui();
+            tm.GetTexture2D(material.normalMapTexture, GetDefaultTexture(&TexturedMaterial::normalMapTexture))->RenderImGui();
             ImGui::TreePop();
         }
-        if (ImGui::TreeNode(("Specular Texture: " + material.specularTexture + "##" + material.specularTexture).c_str()))
+        if (ImGui::TreeNode(("Specular Texture: " + tm.GetAssetName(material.specularTexture) + "##specularTexture").c_str()))
         {
-            tm.GetTexture2D(material.specularTexture)->RenderImGui();
+            tm.GetTexture2D(material.specularTexture, GetDefaultTexture(&TexturedMaterial::specularTexture))->RenderImGui();
             ImGui::TreePop();
         }
-        if (ImGui::TreeNode(("Ambient Texture: " + material.ambientTexture + "##" + material.ambientTexture).c_str()))
+        if (ImGui::TreeNode(("Ambient Texture: " + tm.GetAssetName(material.ambientTexture) + "##ambientTexture").c_str()))
         {
-            tm.GetTexture2D(material.ambientTexture)->RenderImGui();
+            tm.GetTexture2D(material.ambientTexture, GetDefaultTexture(&TexturedMaterial::ambientTexture))->RenderImGui();
             ImGui::TreePop();
         }
 
@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include "MeshLod.h"
 #include "Rendering/Buffers/D3D11Buffer.h"
 #include "Rendering/D3D11Device.h"
 #include "Rendering/TexturedMaterial.h"
@@ -13,15 +14,29 @@ public:
     uint32_t indexBufferCount = 0;
     uint32_t indexBufferStartIndex = 0;
 
+    struct IndexRange
+    {
+        uint32_t start = 0;
+        uint32_t count = 0;
+    };
+
+    // Simplified versions of the range above in the same index buffer, from the finest to the coarsest
+    std::array<IndexRange, MAX_MESH_LODS - 1> lodRanges{};
+    // LOD 0 included
+    uint8_t lodCount = 1;
+
     SubMesh() = default;
     SubMesh(const SubMesh& subMesh);
     SubMesh& operator=(const SubMesh& subMesh);
     virtual ~SubMesh() = default;
 
     virtual void DrawGeometry(D3D11Device* renderDevice, int instancesCount = 1);
+    // Past the last LOD of this submesh the coarsest one is drawn
+    void DrawLod(D3D11Device* renderDevice, uint8_t lod, int instancesCount, int startInstance);
+    [[nodiscard]] IndexRange GetLodRange(uint8_t lod) const noexcept;
 
     const D3D11Buffer& GetMaterialBuffer() const noexcept;
-    TexturedMaterial GetMaterial() const noexcept { return material; }
+    const TexturedMaterial& GetMaterial() const noexcept { return material; }
     void SetMaterial(const TexturedMaterial& mat);
 
     void RenderImGui(int id);
@@ -2,6 +2,7 @@
 #include "TerrainMesh.h"
 
 #include "Core/WindowsEngine.h"
+#include "Core/Physics/PhysicsVehicle.h"
 using namespace physx;
 
 namespace Snail
@@ -11,19 +12,12 @@ TerrainMesh::TerrainMesh()
     static const PhysicsModule& physicsModule = WindowsEngine::GetModule<PhysicsModule>();
     physXMats[0] = physicsModule.physics->createMaterial(0, 0, 0);
 
-    static auto roadCallback = []{};
-    physXMats[0]->userData = roadCallback;
+    static PhysicsSurface road{};
+    physXMats[0]->userData = &road;
     physXMats[1] = physicsModule.physics->createMaterial(0, 0, 0);
 
-    static auto grassCallback = []
-    {
-        auto& gm = WindowsEngine::GetInstance().GetModule<GameManager>();
-        if (const auto vehicle = gm.GetVehicle())
-        {
-            vehicle->SetOnGrass(true);
-        }
-    };
-    physXMats[1]->userData = grassCallback;
+    static PhysicsSurface grass{true};
+    physXMats[1]->userData = &grass;
 }
 
 TerrainMesh::~TerrainMesh()
@@ -43,6 +37,11 @@ void TerrainMesh::PopulateHeightField(const uint32_t w, const uint32_t h)
     height = h;
 }
 
+std::unique_ptr<OccluderMesh> TerrainMesh::BuildOccluderMesh() const
+{
+    return std::make_unique<OccluderMesh>(OccluderMesh::FromHeightField(vertices, width, height));
+}
+
 void TerrainMesh::SortVertices()
 {
     std::ranges::sort(vertices,
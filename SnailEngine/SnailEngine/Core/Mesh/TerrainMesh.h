@@ -8,6 +8,11 @@ class TerrainMesh : public Mesh<uint32_t>
 {
     PhysXUniquePtr<physx::PxMaterial> physXmat[2];
     physx::PxMaterial*  physXMats[2];
+
+protected:
+    // Coarser heightfield kept under the terrain
+    std::unique_ptr<OccluderMesh> BuildOccluderMesh() const override;
+
 public:
     std::vector<int> materialIds;
     uint32_t width = 0, height = 0;
@@ -2,65 +2,74 @@
 
 #include <PxPhysicsAPI.h>
 
+#include "Core/Physics/CollisionLayers.h"
+#include "Core/Physics/PhysicsEventQueue.h"
 #include "Entities/Triggers/TriggerBox.h"
 
 using namespace physx;
 
 namespace Snail
 {
-class ContactCallback : public PxSimulationEventCallback, public PxContactModifyCallback
+// Hands the physics events of the step to the entities, see PhysicsEventQueue
+class ContactCallback : public PhysicsEventHandler, public PxContactModifyCallback
 {
 public:
-    void onTrigger(PxTriggerPair* pairs, PxU32 count) override
+    void OnTriggerEnter(void* triggerUserData) override
     {
-        for (PxU32 i = 0; i < count; i++)
-        {
-            // ignore pairs when shapes have been deleted
-            if (pairs[i].flags & (PxTriggerPairFlag::eREMOVED_SHAPE_TRIGGER | PxTriggerPairFlag::eREMOVED_SHAPE_OTHER))
-                continue;
+        if (triggerUserData)
+            static_cast<TriggerBox::TriggerUserData*>(triggerUserData)->triggerBox->OnTriggerEnter();
+    }
 
-            if (pairs[i].triggerShape->userData)
-            {
-                auto* triggerData = static_cast<TriggerBox::TriggerUserData*>(pairs[i].triggerShape->userData);
-                triggerData->OnTrigger(triggerData->triggerBox);
+    void OnTriggerExit(void* triggerUserData) override
+    {
+        if (triggerUserData)
+            static_cast<TriggerBox::TriggerUserData*>(triggerUserData)->triggerBox->OnTriggerExit();
+    }
 
-                if (pairs[i].otherShape->userData)
-                {
-                    auto* userData = static_cast<Entity::UserData*>(pairs[i].otherShape->userData);
-                    userData->OnTrigger(triggerData->triggerBox);
-                }
-            }
+    // Entities are told of the triggers they enter and leave alike
+    void OnShapeEnterTrigger(void* triggerUserData, void* otherUserData) override
+    {
+        if (triggerUserData && otherUserData)
+        {
+            auto* triggerData = static_cast<TriggerBox::TriggerUserData*>(triggerUserData);
+            static_cast<Entity::UserData*>(otherUserData)->OnTrigger(triggerData->triggerBox);
         }
     }
 
-    void onContact(const PxContactPairHeader&, const PxContactPair*, PxU32) override
-    { }
-
-    void onContactModify(PxContactModifyPair* const, PxU32) override
-    { }
-
-    void onConstraintBreak(PxConstraintInfo*, PxU32) override
-    { }
-
-    void onWake(PxActor**, PxU32) override
-    { }
+    void OnShapeExitTrigger(void* triggerUserData, void* otherUserData) override
+    {
+        OnShapeEnterTrigger(triggerUserData, otherUserData);
+    }
 
-    void onSleep(PxActor**, PxU32) override
-    { }
+    void OnContact(void* userData0, void* userData1, const float impulse) override
+    {
+        auto* data0 = static_cast<Entity::UserData*>(userData0);
+        auto* data1 = static_cast<Entity::UserData*>(userData1);
+        if (data0)
+            data0->OnContact(data1 ? data1->entity : nullptr, impulse);
+        if (data1)
+            data1->OnContact(data0 ? data0->entity : nullptr, impulse);
+    }
 
-    void onAdvance(const PxRigidBody* const*, const PxTransform*, const PxU32) override
+    void onContactModify(PxContactModifyPair* const, PxU32) override
     { }
 };
 
-PxFilterFlags FilterShader(
+inline PxFilterFlags FilterShader(
     PxFilterObjectAttributes attributes0,
-    PxFilterData,
+    PxFilterData filterData0,
     PxFilterObjectAttributes attributes1,
-    PxFilterData,
+    PxFilterData filterData1,
     PxPairFlags& pairFlags,
     const void*,
     PxU32)
 {
+    // Layers don't change while the shapes are in the scene, killed pairs aren't filtered again until they separate
+    if (!CollisionLayers::Interact(filterData0, filterData1))
+    {
+        return PxFilterFlag::eKILL;
+    }
+
     // Check if either object is a trigger
     const bool isTrigger0 = PxFilterObjectIsTrigger(attributes0);
     const bool isTrigger1 = PxFilterObjectIsTrigger(attributes1);
@@ -79,6 +88,9 @@ PxFilterFlags FilterShader(
     }
 
     pairFlags = PxPairFlag::eCONTACT_DEFAULT;
+    // Hard hits are reported for the actors with a contact report threshold, on the layers listening to them
+    if (CollisionLayers::ShouldReportContacts(filterData0, filterData1))
+        pairFlags |= PxPairFlag::eNOTIFY_THRESHOLD_FORCE_FOUND | PxPairFlag::eNOTIFY_CONTACT_POINTS;
 
     return PxFilterFlag::eDEFAULT;
 }
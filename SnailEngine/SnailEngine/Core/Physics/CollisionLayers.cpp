@@ -0,0 +1,205 @@
+#include "stdafx.h"
+#include "CollisionLayers.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace physx;
+
+namespace Snail
+{
+
+CollisionLayers CollisionLayers::CreateDefault()
+{
+    // Debris only settles on what's under it, triggers only notice the vehicles
+    return FromJson(nlohmann::json::parse(R"({
+        "layers": [ "default", "terrain", "wall", "vehicle", "prop", "debris", "trigger" ],
+        "collisions": {
+            "default": [ "default", "terrain", "wall", "vehicle", "prop" ],
+            "terrain": [ "vehicle", "prop", "debris" ],
+            "wall": [ "vehicle", "prop" ],
+            "vehicle": [ "vehicle", "prop", "debris", "trigger" ],
+            "prop": [ "prop", "debris" ]
+        },
+        "queries": {
+            "wheel": [ "default", "terrain", "prop" ],
+            "camera": [ "default", "terrain", "wall" ],
+            "gameplay": [ "default", "terrain", "wall", "vehicle", "prop" ]
+        },
+        "contact_reports": [ "vehicle" ]
+    })"));
+}
+
+CollisionLayers CollisionLayers::FromJson(const nlohmann::json& json)
+{
+    CollisionLayers layers;
+    for (const nlohmann::json& name : json.at("layers"))
+    {
+        if (layers.names.size() == MAX_LAYER_COUNT)
+        {
+            LOGF(Logger::ERROR, "Only {} collision layers are supported, the ones after \"{}\" are ignored", MAX_LAYER_COUNT, layers.names.back());
+            break;
+        }
+        layers.names.push_back(name.get<std::string>());
+    }
+
+    if (!layers.FindLayer(DEFAULT_LAYER))
+        LOGF(Logger::FATAL, "The collision layers must have a \"{}\" layer", DEFAULT_LAYER);
+
+    if (json.contains("collisions"))
+    {
+        for (const auto& [name, others] : json.at("collisions").items())
+        {
+            const std::optional<uint32_t> layer = layers.FindLayer(name);
+            if (!layer)
+            {
+                LOGF(Logger::WARN, "Collisions of unknown layer \"{}\" are ignored", name);
+                continue;
+            }
+
+            const Mask mask = layers.GetMask(others);
+            layers.collisionMasks[*layer] |= mask;
+            // Symmetric
+            for (uint32_t other = 0; other < layers.names.size(); ++other)
+            {
+                if (mask & 1u << other)
+                    layers.collisionMasks[other] |= 1u << *layer;
+            }
+        }
+    }
+
+    if (json.contains("queries"))
+    {
+        for (const auto& [name, queried] : json.at("queries").items())
+        {
+            const auto it = std::ranges::find(QUERY_NAMES, name);
+            if (it == QUERY_NAMES.end())
+            {
+                LOGF(Logger::WARN, "Unknown query \"{}\" is ignored", name);
+                continue;
+            }
+            layers.queryMasks[it - QUERY_NAMES.begin()] = layers.GetMask(queried);
+        }
+    }
+
+    if (json.contains("contact_reports"))
+        layers.contactReportMask = layers.GetMask(json.at("contact_reports"));
+
+    return layers;
+}
+
+CollisionLayers CollisionLayers::Load(const std::string& filename)
+{
+    if (!std::filesystem::exists(filename))
+        return CreateDefault();
+
+    std::ifstream file{filename};
+    CollisionLayers layers = FromJson(nlohmann::json::parse(file, nullptr, true, true));
+    LOGF("Loaded {} collision layers from {}", layers.names.size(), filename);
+    return layers;
+}
+
+CollisionLayers::Mask CollisionLayers::GetMask(const nlohmann::json& layerNames) const
+{
+    Mask mask = 0;
+    for (const nlohmann::json& name : layerNames)
+    {
+        if (const std::optional<uint32_t> layer = FindLayer(name.get<std::string>()))
+            mask |= 1u << *layer;
+        else
+            LOGF(Logger::WARN, "Unknown collision layer \"{}\" is ignored", name.get<std::string>());
+    }
+    return mask;
+}
+
+std::optional<uint32_t> CollisionLayers::FindLayer(const std::string_view name) const
+{
+    const auto it = std::ranges::find(names, name);
+    if (it == names.end())
+        return {};
+    return static_cast<uint32_t>(it - names.begin());
+}
+
+uint32_t CollisionLayers::GetLayer(const std::string_view name) const
+{
+    if (const std::optional<uint32_t> layer = FindLayer(name))
+        return *layer;
+
+    LOGF(Logger::WARN, "Unknown collision layer \"{}\", using \"{}\"", name, DEFAULT_LAYER);
+    return *FindLayer(DEFAULT_LAYER);
+}
+
+bool CollisionLayers::Collide(const uint32_t layer0, const uint32_t layer1) const noexcept
+{
+    return collisionMasks[layer0] & 1u << layer1;
+}
+
+PxFilterData CollisionLayers::GetSimulationFilterData(const uint32_t layer) const noexcept
+{
+    return PxFilterData{1u << layer, collisionMasks[layer], ReportsContacts(layer), 0};
+}
+
+PxFilterData CollisionLayers::GetQueryFilterData(const uint32_t layer) const noexcept
+{
+    return PxFilterData{1u << layer, 0, 0, 0};
+}
+
+PxQueryFilterData CollisionLayers::GetQueryFilter(const Query query) const noexcept
+{
+    return PxQueryFilterData{PxFilterData{GetQueryMask(query), 0, 0, 0}, PxQueryFlag::eSTATIC | PxQueryFlag::eDYNAMIC};
+}
+
+void CollisionLayers::Apply(PxShape& shape, const std::string_view layerName) const
+{
+    const uint32_t layer = GetLayer(layerName);
+    shape.setSimulationFilterData(GetSimulationFilterData(layer));
+    shape.setQueryFilterData(GetQueryFilterData(layer));
+}
+
+#ifdef _IMGUI_
+void CollisionLayers::RenderImGui() const
+{
+    const int columnCount = static_cast<int>(names.size()) + 1;
+    if (ImGui::BeginTable("CollisionLayers", columnCount, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("");
+        for (const std::string& name : names)
+            ImGui::TableSetupColumn(name.c_str());
+        ImGui::TableHeadersRow();
+
+        for (uint32_t row = 0; row < names.size(); ++row)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", names[row].c_str());
+            for (uint32_t column = 0; column < names.size(); ++column)
+            {
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", Collide(row, column) ? "x" : "");
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    for (size_t query = 0; query < QUERY_NAMES.size(); ++query)
+    {
+        std::string queried;
+        for (uint32_t layer = 0; layer < names.size(); ++layer)
+        {
+            if (queryMasks[query] & 1u << layer)
+                queried += (queried.empty() ? "" : ", ") + names[layer];
+        }
+        ImGui::Text("%s queries hit: %s", QUERY_NAMES[query], queried.c_str());
+    }
+
+    std::string reporting;
+    for (uint32_t layer = 0; layer < names.size(); ++layer)
+    {
+        if (ReportsContacts(layer))
+            reporting += (reporting.empty() ? "" : ", ") + names[layer];
+    }
+    ImGui::Text("Contacts reported for: %s", reporting.c_str());
+}
+#endif
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <json.hpp>
+#include <PxPhysicsAPI.h>
+
+namespace Snail
+{
+
+// Named collision layers and which of them interact, read from JSON:
+//
+// {
+//   "layers": [ "default", "terrain", "vehicle", "trigger" ],
+//   // Symmetric, listing a pair on one side is enough. Triggers only pair with the layers listed here too.
+//   "collisions": { "default": [ "default", "terrain", "vehicle" ], "trigger": [ "vehicle" ] },
+//   // Layers each kind of scene query hits
+//   "queries": { "wheel": [ "default", "terrain" ], "camera": [ "terrain" ], "gameplay": [ "default", "vehicle" ] },
+//   // Layers with a contact listener, only the pairs involving one of them report contact forces and points
+//   "contact_reports": [ "vehicle" ]
+// }
+//
+// The simulation filter data of a shape holds the bit of its layer in word0, the layers it collides with in word1 and
+// whether its layer reports contacts in word2, its query filter data the bit of its layer in word0. Queries hit the shapes sharing a bit with their mask, without
+// filter callbacks. Shapes without a layer collide with everything, the queries miss them.
+class CollisionLayers
+{
+public:
+    using Mask = uint32_t;
+
+    static constexpr size_t MAX_LAYER_COUNT = 32;
+    static constexpr Mask ALL_LAYERS = ~Mask{0};
+    // Read by PhysicsModule::Init, the defaults are used when it doesn't exist
+    static constexpr const char* FILE_PATH = "Resources/collision_layers.json";
+    static constexpr const char* DEFAULT_LAYER = "default";
+
+    enum class Query : uint8_t
+    {
+        // Suspension raycasts of the vehicles
+        WHEEL,
+        // Keeps the follow camera out of the walls
+        CAMERA,
+        // Everything else
+        GAMEPLAY,
+        COUNT
+    };
+
+    static constexpr std::array<const char*, static_cast<size_t>(Query::COUNT)> QUERY_NAMES{"wheel", "camera", "gameplay"};
+
+private:
+    std::vector<std::string> names;
+    std::array<Mask, MAX_LAYER_COUNT> collisionMasks{};
+    std::array<Mask, static_cast<size_t>(Query::COUNT)> queryMasks{};
+    Mask contactReportMask = 0;
+
+    Mask GetMask(const nlohmann::json& layerNames) const;
+
+public:
+    // default, terrain, wall, vehicle, prop, debris and trigger
+    static CollisionLayers CreateDefault();
+    static CollisionLayers FromJson(const nlohmann::json& json);
+    static CollisionLayers Load(const std::string& filename);
+
+    std::optional<uint32_t> FindLayer(std::string_view name) const;
+    // Falls back on the default layer with a warning
+    uint32_t GetLayer(std::string_view name) const;
+    size_t GetLayerCount() const noexcept { return names.size(); }
+    const std::string& GetLayerName(uint32_t layer) const { return names[layer]; }
+
+    bool Collide(uint32_t layer0, uint32_t layer1) const noexcept;
+    Mask GetQueryMask(Query query) const noexcept { return queryMasks[static_cast<size_t>(query)]; }
+    bool ReportsContacts(uint32_t layer) const noexcept { return contactReportMask & 1u << layer; }
+
+    physx::PxFilterData GetSimulationFilterData(uint32_t layer) const noexcept;
+    physx::PxFilterData GetQueryFilterData(uint32_t layer) const noexcept;
+    // What the queries of that kind pass to PhysX
+    physx::PxQueryFilterData GetQueryFilter(Query query) const noexcept;
+
+    // Sets both filter data of the shape, before it is attached to an actor
+    void Apply(physx::PxShape& shape, std::string_view layerName) const;
+
+    // Whether the filter shader lets two shapes pair
+    static bool Interact(const physx::PxFilterData& data0, const physx::PxFilterData& data1) noexcept;
+    // Whether the filter shader asks PhysX for the contact forces and points of two interacting shapes
+    static bool ShouldReportContacts(const physx::PxFilterData& data0, const physx::PxFilterData& data1) noexcept { return data0.word2 || data1.word2; }
+
+#ifdef _IMGUI_
+    // Layer against layer matrix and the query masks
+    void RenderImGui() const;
+#endif
+};
+
+inline bool CollisionLayers::Interact(const physx::PxFilterData& data0, const physx::PxFilterData& data1) noexcept
+{
+    const Mask layer0 = data0.word0 ? data0.word0 : ALL_LAYERS;
+    const Mask layer1 = data1.word0 ? data1.word0 : ALL_LAYERS;
+    const Mask collisions0 = data0.word0 ? data0.word1 : ALL_LAYERS;
+    const Mask collisions1 = data1.word0 ? data1.word1 : ALL_LAYERS;
+    return (layer0 & collisions1) && (layer1 & collisions0);
+}
+
+}
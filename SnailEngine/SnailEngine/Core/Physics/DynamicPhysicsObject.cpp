@@ -9,7 +9,7 @@ namespace Snail {
 
 DynamicPhysicsObject::DynamicPhysicsObject(physx::PxShape* shape, const Transform& initialTransform)
 {
-    std::unique_lock lock{ PhysxMutex };
+    PhysxWriteLock lock;
 
     DynamicPhysicsObject::SetShape(shape);
     body->setGlobalPose(initialTransform);
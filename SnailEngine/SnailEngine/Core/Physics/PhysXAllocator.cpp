@@ -0,0 +1,28 @@
+#include "stdafx.h"
+#include "PhysXAllocator.h"
+
+#include "Core/Memory/MemoryTracker.h"
+
+namespace Snail
+{
+
+void* PhysXAllocatorCallback::allocate(const size_t size, const char*, const char*, int)
+{
+    // PhysX expects a null pointer rather than an exception when out of memory
+    try
+    {
+        return MemoryTracker::Allocate(size, MemoryTag::PHYSICS, ALIGNMENT);
+    }
+    catch (const std::bad_alloc&)
+    {
+        LOGF(Logger::ERROR, "PhysX allocation of {} bytes failed", size);
+        return nullptr;
+    }
+}
+
+void PhysXAllocatorCallback::deallocate(void* ptr)
+{
+    MemoryTracker::Free(ptr);
+}
+
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include <memory>
 
+#include <foundation/PxAllocatorCallback.h>
+
 namespace Snail {
 
 using PhysXDeleter = decltype([](auto* p) {
@@ -9,4 +11,15 @@ using PhysXDeleter = decltype([](auto* p) {
 
 template<class T>
 using PhysXUniquePtr = std::unique_ptr<T, PhysXDeleter>;
+
+// Routes PhysX's allocations through the memory tracker under the PHYSICS tag
+class PhysXAllocatorCallback : public physx::PxAllocatorCallback
+{
+public:
+	// PhysX requires 16 byte aligned blocks
+	static constexpr size_t ALIGNMENT = 16;
+
+	void* allocate(size_t size, const char* typeName, const char* filename, int line) override;
+	void deallocate(void* ptr) override;
+};
 }
@@ -0,0 +1,143 @@
+#include "stdafx.h"
+#include "PhysicsEventQueue.h"
+
+#include <array>
+#include <chrono>
+#include <functional>
+
+using namespace physx;
+
+namespace Snail
+{
+
+size_t PhysicsEventQueue::PairHash::operator()(const Pair& pair) const noexcept
+{
+    const size_t hash = std::hash<const void*>{}(pair.trigger);
+    return hash ^ (std::hash<const void*>{}(pair.other) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+void PhysicsEventQueue::onTrigger(PxTriggerPair* pairs, const PxU32 count)
+{
+    for (PxU32 i = 0; i < count; ++i)
+    {
+        const PxTriggerPair& pair = pairs[i];
+        PhysicsEvent& event = events.emplace_back();
+        event.type = pair.status == PxPairFlag::eNOTIFY_TOUCH_FOUND ? PhysicsEvent::Type::TRIGGER_FOUND : PhysicsEvent::Type::TRIGGER_LOST;
+        event.isRemoved0 = pair.flags.isSet(PxTriggerPairFlag::eREMOVED_SHAPE_TRIGGER);
+        event.isRemoved1 = pair.flags.isSet(PxTriggerPairFlag::eREMOVED_SHAPE_OTHER);
+        event.object0 = pair.triggerShape;
+        event.object1 = pair.otherShape;
+        event.userData0 = event.isRemoved0 ? nullptr : pair.triggerShape->userData;
+        event.userData1 = event.isRemoved1 ? nullptr : pair.otherShape->userData;
+    }
+}
+
+void PhysicsEventQueue::onContact(const PxContactPairHeader& pairHeader, const PxContactPair* pairs, const PxU32 count)
+{
+    // Enough points for a box resting on a face, the impulse of the others is left out
+    constexpr PxU32 MAX_POINT_COUNT = 16;
+
+    if (pairHeader.flags & (PxContactPairHeaderFlag::eREMOVED_ACTOR_0 | PxContactPairHeaderFlag::eREMOVED_ACTOR_1))
+        return;
+
+    std::array<PxContactPairPoint, MAX_POINT_COUNT> points;
+    for (PxU32 i = 0; i < count; ++i)
+    {
+        const PxContactPair& pair = pairs[i];
+        if (!pair.events.isSet(PxPairFlag::eNOTIFY_THRESHOLD_FORCE_FOUND) || pair.flags & (PxContactPairFlag::eREMOVED_SHAPE_0 | PxContactPairFlag::eREMOVED_SHAPE_1))
+            continue;
+
+        PhysicsEvent& event = events.emplace_back();
+        event.type = PhysicsEvent::Type::CONTACT;
+        event.object0 = pair.shapes[0];
+        event.object1 = pair.shapes[1];
+        event.userData0 = pair.shapes[0]->userData;
+        event.userData1 = pair.shapes[1]->userData;
+
+        const PxU32 pointCount = pair.extractContacts(points.data(), MAX_POINT_COUNT);
+        for (PxU32 point = 0; point < pointCount; ++point)
+            event.impulse += points[point].impulse.magnitude();
+    }
+}
+
+void PhysicsEventQueue::onWake(PxActor** actors, const PxU32 count)
+{
+    for (PxU32 i = 0; i < count; ++i)
+        events.push_back({.type = PhysicsEvent::Type::WAKE, .object0 = actors[i], .userData0 = actors[i]->userData});
+}
+
+void PhysicsEventQueue::onSleep(PxActor** actors, const PxU32 count)
+{
+    for (PxU32 i = 0; i < count; ++i)
+        events.push_back({.type = PhysicsEvent::Type::SLEEP, .object0 = actors[i], .userData0 = actors[i]->userData});
+}
+
+void PhysicsEventQueue::Dispatch(PhysicsEventHandler& handler)
+{
+    using Clock = std::chrono::high_resolution_clock;
+    const auto start = Clock::now();
+
+    stats.eventCount = events.size();
+    stats.ignoredCount = 0;
+
+    for (const PhysicsEvent& event : events)
+    {
+        switch (event.type)
+        {
+        case PhysicsEvent::Type::TRIGGER_FOUND:
+        {
+            if (!touchingPairs.insert({event.object0, event.object1}).second)
+            {
+                ++stats.ignoredCount;
+                break;
+            }
+
+            if (triggerOccupancy[event.object0]++ == 0)
+                handler.OnTriggerEnter(event.userData0);
+            handler.OnShapeEnterTrigger(event.userData0, event.userData1);
+            break;
+        }
+        case PhysicsEvent::Type::TRIGGER_LOST:
+        {
+            if (!touchingPairs.erase({event.object0, event.object1}))
+            {
+                ++stats.ignoredCount;
+                break;
+            }
+
+            if (!event.isRemoved0 && !event.isRemoved1)
+                handler.OnShapeExitTrigger(event.userData0, event.userData1);
+
+            const auto occupancy = triggerOccupancy.find(event.object0);
+            if (--occupancy->second > 0)
+                break;
+
+            triggerOccupancy.erase(occupancy);
+            // A removed trigger is gone with its entity, a removed shape leaving a trigger still exits it
+            if (!event.isRemoved0)
+                handler.OnTriggerExit(event.userData0);
+            break;
+        }
+        case PhysicsEvent::Type::CONTACT:
+            handler.OnContact(event.userData0, event.userData1, event.impulse);
+            break;
+        case PhysicsEvent::Type::WAKE:
+        case PhysicsEvent::Type::SLEEP:
+            handler.OnSleepChanged(event.userData0, event.type == PhysicsEvent::Type::SLEEP);
+            break;
+        }
+    }
+
+    events.clear();
+    stats.dispatchMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+#ifdef _IMGUI_
+void PhysicsEventQueue::RenderImGui()
+{
+    ImGui::Text("Last step: %zu events, %zu ignored, dispatched in %.3f ms", stats.eventCount, stats.ignoredCount, stats.dispatchMs);
+    ImGui::Text("Shapes in triggers: %zu", touchingPairs.size());
+}
+#endif
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <PxPhysicsAPI.h>
+
+namespace Snail
+{
+
+// What the simulation callbacks record, copied as is into the buffer of the step
+struct PhysicsEvent
+{
+    enum class Type : uint8_t
+    {
+        TRIGGER_FOUND,
+        TRIGGER_LOST,
+        CONTACT,
+        WAKE,
+        SLEEP,
+    };
+
+    Type type = Type::TRIGGER_FOUND;
+    // The shape or actor was removed from the scene, its user data may be gone and must not be read
+    bool isRemoved0 = false;
+    bool isRemoved1 = false;
+    // The trigger shape and the other shape, the two shapes in contact or the actor waking up or falling asleep.
+    // Only used to tell pairs apart.
+    const void* object0 = nullptr;
+    const void* object1 = nullptr;
+    void* userData0 = nullptr;
+    void* userData1 = nullptr;
+    // Sum of the impulses of the contact points
+    float impulse = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<PhysicsEvent>);
+
+// Receives the events once the step is over, with the user data of the shapes and actors
+class PhysicsEventHandler
+{
+public:
+    virtual ~PhysicsEventHandler() = default;
+
+    // The first shape entered the trigger, or the last one left it
+    virtual void OnTriggerEnter(void* /*triggerUserData*/) {}
+    virtual void OnTriggerExit(void* /*triggerUserData*/) {}
+    // Every shape entering a trigger, after OnTriggerEnter
+    virtual void OnShapeEnterTrigger(void* /*triggerUserData*/, void* /*otherUserData*/) {}
+    // Every shape leaving a trigger, before OnTriggerExit. Not for removed shapes, nor for removed triggers.
+    virtual void OnShapeExitTrigger(void* /*triggerUserData*/, void* /*otherUserData*/) {}
+    // Only for the actors with a contact report threshold, when the force of the contact exceeds it
+    virtual void OnContact(void* /*userData0*/, void* /*userData1*/, float /*impulse*/) {}
+    // Only for the actors with PxActorFlag::eSEND_SLEEP_NOTIFIES
+    virtual void OnSleepChanged(void* /*actorUserData*/, bool /*isAsleep*/) {}
+};
+
+// Set as the simulation event callback of the scene. The callbacks run inside fetchResults and only append events to
+// the buffer of the step, Dispatch hands them to the gameplay code after the step. Triggers enter and exit from the
+// touch found and lost flags of PhysX, with the pairs touching them tracked across steps so that a duplicated or
+// missing event can't flip their state.
+class PhysicsEventQueue : public physx::PxSimulationEventCallback
+{
+public:
+    struct Stats
+    {
+        size_t eventCount = 0;
+        // Events about pairs already in the state they report
+        size_t ignoredCount = 0;
+        float dispatchMs = 0;
+    };
+
+private:
+    struct Pair
+    {
+        const void* trigger;
+        const void* other;
+
+        bool operator==(const Pair&) const = default;
+    };
+
+    struct PairHash
+    {
+        size_t operator()(const Pair& pair) const noexcept;
+    };
+
+    std::vector<PhysicsEvent> events;
+    std::unordered_set<Pair, PairHash> touchingPairs;
+    // Number of shapes touching each trigger
+    std::unordered_map<const void*, uint32_t> triggerOccupancy;
+    Stats stats;
+
+public:
+    void onTrigger(physx::PxTriggerPair* pairs, physx::PxU32 count) override;
+    void onContact(const physx::PxContactPairHeader& pairHeader, const physx::PxContactPair* pairs, physx::PxU32 count) override;
+    void onWake(physx::PxActor** actors, physx::PxU32 count) override;
+    void onSleep(physx::PxActor** actors, physx::PxU32 count) override;
+    void onConstraintBreak(physx::PxConstraintInfo*, physx::PxU32) override {}
+    void onAdvance(const physx::PxRigidBody* const*, const physx::PxTransform*, physx::PxU32) override {}
+
+    // Hands the events of the last step to the handler in the order PhysX reported them, then clears them.
+    // On the thread calling fetchResults, once the scene lock is released since handlers may query the scene.
+    void Dispatch(PhysicsEventHandler& handler);
+
+    // Appends an event to the buffer of the step, as the simulation callbacks do
+    void Record(const PhysicsEvent& event) { events.push_back(event); }
+
+    size_t GetPendingEventCount() const noexcept { return events.size(); }
+    size_t GetTouchingPairCount() const noexcept { return touchingPairs.size(); }
+    size_t GetOccupiedTriggerCount() const noexcept { return triggerOccupancy.size(); }
+    const Stats& GetStats() const noexcept { return stats; }
+
+#ifdef _IMGUI_
+    void RenderImGui();
+#endif
+};
+
+}
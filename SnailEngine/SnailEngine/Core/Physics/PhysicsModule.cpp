@@ -5,6 +5,7 @@
 #include <cooking/PxCooking.h>
 
 #include "Callbacks/ContactCallback.h"
+#include "Core/WindowsEngine.h"
 
 using namespace physx;
 
@@ -12,6 +13,8 @@ namespace Snail
 {
 void PhysicsModule::Init()
 {
+    collisionLayers = CollisionLayers::Load(CollisionLayers::FILE_PATH);
+
     foundation.reset(PxCreateFoundation(PX_PHYSICS_VERSION, allocator, errorCallback));
     dispatcher.reset(PxDefaultCpuDispatcherCreate(2));
 
@@ -34,8 +37,9 @@ void PhysicsModule::Init()
     sceneDesc.cpuDispatcher = dispatcher.get();
     sceneDesc.filterShader = FilterShader;
     static ContactCallback callback;
+    eventHandler = &callback;
     sceneDesc.contactModifyCallback = &callback;
-    sceneDesc.simulationEventCallback = &callback;
+    sceneDesc.simulationEventCallback = &eventQueue;
     sceneDesc.flags |= PxSceneFlag::eENABLE_CCD;
     scene.reset(physics->createScene(sceneDesc));
 
@@ -60,24 +64,40 @@ void PhysicsModule::Init()
     materialFrictions[0].material = defaultMaterial.get();
     defaultMaterialFriction = 1.0f;
     nbMaterialFrictions = 1;
+
+    vehicles.Init({physics.get(), scene.get(), defaultMaterial.get(), &collisionLayers, materialFrictions, nbMaterialFrictions, defaultMaterialFriction});
 }
 
 void PhysicsModule::Update(const float dt)
 {
-    scene->simulate(dt);
-    scene->fetchResults(true);
+    static ThreadPool& jobPool = WindowsEngine::GetModule<ThreadPool>();
+    static CameraManager& cameraManager = WindowsEngine::GetModule<CameraManager>();
+
+    {
+        PhysxWriteLock lock;
+        // Vehicles far from the camera are stepped at a reduced rate
+        const Camera* camera = cameraManager.GetCurrentCamera();
+        vehicles.Step(dt, camera ? camera->transform.position : Vector3::Zero, &jobPool, std::thread::hardware_concurrency());
+        scene->simulate(dt);
+        scene->fetchResults(true);
+        lastQueryCount = 0;
+    }
+
+    // Once the scene is unlocked, the entities may query or change it
+    eventQueue.Dispatch(*eventHandler);
 }
 
-float PhysicsModule::RaycastDistance(const Vector3& position, const Vector3& direction)
+float PhysicsModule::RaycastDistance(const Vector3& position, const Vector3& direction, const CollisionLayers::Query query)
 {
     const PxVec3 origin{ position.x, position.y, position.z };
     const PxVec3 unitDir{ direction.x, direction.y, direction.z };
     const PxReal maxDistance = 10000.0f;
     PxRaycastBuffer hit;
 
-    // Raycast against all static & dynamic objects (no filtering)
+    const auto lock = LockPhysxForQueries();
+    // Raycast against the static & dynamic objects in the layers of the query
     // The main result from this call is the closest hit, stored in the 'hit.block' structure
-    if (scene->raycast(origin, unitDir, maxDistance, hit))
+    if (scene->raycast(origin, unitDir, maxDistance, hit, PxHitFlag::eDEFAULT, collisionLayers.GetQueryFilter(query)))
     {
         return hit.block.distance;
     }
@@ -85,6 +105,32 @@ float PhysicsModule::RaycastDistance(const Vector3& position, const Vector3& dir
     return std::numeric_limits<float>::max();
 }
 
+void PhysicsModule::ExecuteQueries(PhysicsQueryBatch& batch)
+{
+    static ThreadPool& jobPool = WindowsEngine::GetModule<ThreadPool>();
+
+    const auto lock = LockPhysxForQueries();
+    batch.Execute(*scene, jobPool, std::thread::hardware_concurrency());
+    lastQueryCount += batch.GetQueryCount();
+}
+
+void PhysicsModule::RenderImGui()
+{
+#ifdef _IMGUI_
+    if (ImGui::CollapsingHeader("Physics Queries"))
+        ImGui::Text("Batched queries this frame: %zu", lastQueryCount);
+
+    if (ImGui::CollapsingHeader("Physics Events"))
+        eventQueue.RenderImGui();
+
+    if (ImGui::CollapsingHeader("Vehicles"))
+        vehicles.RenderImGui();
+
+    if (ImGui::CollapsingHeader("Collision Layers"))
+        collisionLayers.RenderImGui();
+#endif
+}
+
 PhysicsModule::~PhysicsModule()
 {
     vehicle2::PxCloseVehicleExtension();
@@ -1,7 +1,14 @@
 #pragma once
+#include <cassert>
+#include <mutex>
+#include <shared_mutex>
 #include <PxPhysicsAPI.h>
 
+#include "CollisionLayers.h"
+#include "PhysicsEventQueue.h"
+#include "PhysicsQueryBatch.h"
 #include "PhysXAllocator.h"
+#include "VehicleManager.h"
 #include "Core/Mesh/Mesh.h"
 
 namespace physx
@@ -14,7 +21,36 @@ class PxScene;
 class PxMaterial;
 }
 
-inline std::mutex PhysxMutex;
+// Exclusive for simulation and scene changes, shared for scene queries
+inline std::shared_mutex PhysxMutex;
+
+// Exclusive lock of PhysxMutex that knows it is held by this thread. Code reached while it is held (vehicle step,
+// scene changes) asserts when it would lock again instead of deadlocking.
+class PhysxWriteLock
+{
+    static inline thread_local bool isHeld = false;
+    std::unique_lock<std::shared_mutex> lock;
+
+public:
+    PhysxWriteLock()
+    {
+        assert(!isHeld && "PhysxMutex is already locked by this thread");
+        lock = std::unique_lock{PhysxMutex};
+        isHeld = true;
+    }
+    PhysxWriteLock(const PhysxWriteLock&) = delete;
+    PhysxWriteLock& operator=(const PhysxWriteLock&) = delete;
+    ~PhysxWriteLock() { isHeld = false; }
+
+    [[nodiscard]] static bool IsHeld() noexcept { return isHeld; }
+};
+
+// Shared lock of PhysxMutex, which must not be locked exclusively by this thread
+inline std::shared_lock<std::shared_mutex> LockPhysxForQueries()
+{
+    assert(!PhysxWriteLock::IsHeld() && "PhysxMutex is already locked by this thread");
+    return std::shared_lock{PhysxMutex};
+}
 
 namespace Snail
 {
@@ -25,7 +61,7 @@ struct PhysicsModule
     physx::PxReal defaultMaterialFriction;
     physx::vehicle2::PxVehiclePhysXMaterialFriction materialFrictions[16];
 
-    physx::PxDefaultAllocator allocator{};
+    PhysXAllocatorCallback allocator{};
     physx::PxDefaultErrorCallback errorCallback{};
 
     // THE ORDER OF THESE DECLARATIONS MUST STAY THE SAME!!
@@ -40,10 +76,25 @@ struct PhysicsModule
     PhysXUniquePtr<physx::PxScene> scene;
     PhysXUniquePtr<physx::PxMaterial> defaultMaterial;
 
+    CollisionLayers collisionLayers;
+    PhysicsEventQueue eventQueue;
+    // Hands the events to the entities
+    PhysicsEventHandler* eventHandler = nullptr;
+    VehicleManager vehicles;
+
+    size_t lastQueryCount = 0;
+
     void Init();
+    // Steps the vehicles and the simulation, then dispatches its events
     void Update(float dt);
 
-    float RaycastDistance(const Vector3& position, const Vector3& direction);
+    // Only hits the layers of the query
+    float RaycastDistance(const Vector3& position, const Vector3& direction, CollisionLayers::Query query = CollisionLayers::Query::GAMEPLAY);
+    // Runs the queries on the job system and waits for them, the scene is read locked meanwhile.
+    // Must not be called from a job since it waits on other jobs.
+    void ExecuteQueries(PhysicsQueryBatch& batch);
+
+    void RenderImGui();
 
     ~PhysicsModule();
 
@@ -109,7 +160,8 @@ physx::PxShape* PhysicsModule::GenerateMeshTriangleShape(const Mesh<IdxType>* me
     meshDesc.points.stride = sizeof(PxVec3);
     meshDesc.points.data = verts.data();
 
-    meshDesc.triangles.count = static_cast<PxU32>(mesh->indexes.size() / 3);
+    // Collision uses the full detail triangles, the LODs come after them
+    meshDesc.triangles.count = static_cast<PxU32>(mesh->GetBaseIndexCount() / 3);
     if constexpr (std::is_same_v<IdxType, uint16_t>)
         meshDesc.flags.raise(PxMeshFlag::e16_BIT_INDICES);
 
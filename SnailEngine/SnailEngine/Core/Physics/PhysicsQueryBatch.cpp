@@ -0,0 +1,180 @@
+#include "stdafx.h"
+#include "PhysicsQueryBatch.h"
+
+#include "Core/ThreadPool.h"
+#include "Core/WindowsEngine.h"
+#include "Core/Memory/FrameArena.h"
+
+using namespace physx;
+
+namespace Snail
+{
+
+namespace
+{
+
+PxVec3 ToPx(const Vector3& v)
+{
+    return {v.x, v.y, v.z};
+}
+
+Vector3 FromPx(const PxVec3& v)
+{
+    return {v.x, v.y, v.z};
+}
+
+}
+
+void PhysicsQueryBatch::Hits::Resize(const size_t count)
+{
+    hasHit.assign(count, false);
+    distances.assign(count, std::numeric_limits<float>::max());
+    positions.resize(count);
+    normals.resize(count);
+    actors.assign(count, nullptr);
+}
+
+size_t PhysicsQueryBatch::Hits::GetHitCount() const noexcept
+{
+    return static_cast<size_t>(std::ranges::count(hasHit, true));
+}
+
+void PhysicsQueryBatch::Overlaps::Resize(const size_t count)
+{
+    hasHit.assign(count, false);
+    actors.assign(count, nullptr);
+}
+
+size_t PhysicsQueryBatch::Overlaps::GetHitCount() const noexcept
+{
+    return static_cast<size_t>(std::ranges::count(hasHit, true));
+}
+
+size_t PhysicsQueryBatch::AddRaycast(const Vector3& origin, const Vector3& direction, const float maxDistance, const Filter& filter)
+{
+    raycasts.origins.push_back(origin);
+    raycasts.directions.push_back(direction);
+    raycasts.maxDistances.push_back(maxDistance);
+    raycasts.filters.push_back(filter);
+    return raycasts.origins.size() - 1;
+}
+
+size_t PhysicsQueryBatch::AddSweep(const PxGeometry& geometry, const PxTransform& pose, const Vector3& direction, const float maxDistance, const Filter& filter)
+{
+    sweeps.geometries.emplace_back(geometry);
+    sweeps.poses.push_back(pose);
+    sweeps.directions.push_back(direction);
+    sweeps.maxDistances.push_back(maxDistance);
+    sweeps.filters.push_back(filter);
+    return sweeps.geometries.size() - 1;
+}
+
+size_t PhysicsQueryBatch::AddOverlap(const PxGeometry& geometry, const PxTransform& pose, const Filter& filter)
+{
+    overlapQueries.geometries.emplace_back(geometry);
+    overlapQueries.poses.push_back(pose);
+    overlapQueries.filters.push_back(filter);
+    return overlapQueries.geometries.size() - 1;
+}
+
+void PhysicsQueryBatch::Clear() noexcept
+{
+    raycasts.origins.clear();
+    raycasts.directions.clear();
+    raycasts.maxDistances.clear();
+    raycasts.filters.clear();
+
+    sweeps.geometries.clear();
+    sweeps.poses.clear();
+    sweeps.directions.clear();
+    sweeps.maxDistances.clear();
+    sweeps.filters.clear();
+
+    overlapQueries.geometries.clear();
+    overlapQueries.poses.clear();
+    overlapQueries.filters.clear();
+}
+
+size_t PhysicsQueryBatch::GetQueryCount() const noexcept
+{
+    return raycasts.origins.size() + sweeps.geometries.size() + overlapQueries.geometries.size();
+}
+
+void PhysicsQueryBatch::ExecuteRange(const PxScene& scene, const size_t begin, const size_t end)
+{
+    const size_t raycastCount = raycasts.origins.size();
+    const size_t sweepCount = sweeps.geometries.size();
+
+    const auto storeHit = [](Hits& hits, const size_t i, const PxLocationHit& hit)
+    {
+        hits.hasHit[i] = true;
+        hits.distances[i] = hit.distance;
+        hits.positions[i] = FromPx(hit.position);
+        hits.normals[i] = FromPx(hit.normal);
+        hits.actors[i] = hit.actor;
+    };
+
+    for (size_t query = begin; query < end; ++query)
+    {
+        if (query < raycastCount)
+        {
+            const size_t i = query;
+            const Filter& filter = raycasts.filters[i];
+            PxRaycastBuffer hit;
+            if (scene.raycast(ToPx(raycasts.origins[i]), ToPx(raycasts.directions[i]), raycasts.maxDistances[i], hit, PxHitFlag::eDEFAULT, PxQueryFilterData(filter.data, filter.flags)))
+                storeHit(raycastHits, i, hit.block);
+        }
+        else if (query < raycastCount + sweepCount)
+        {
+            const size_t i = query - raycastCount;
+            const Filter& filter = sweeps.filters[i];
+            PxSweepBuffer hit;
+            if (scene.sweep(sweeps.geometries[i].any(), sweeps.poses[i], ToPx(sweeps.directions[i]), sweeps.maxDistances[i], hit, PxHitFlag::eDEFAULT, PxQueryFilterData(filter.data, filter.flags)))
+                storeHit(sweepHits, i, hit.block);
+        }
+        else
+        {
+            const size_t i = query - raycastCount - sweepCount;
+            const Filter& filter = overlapQueries.filters[i];
+            // Any overlapping shape is enough, its touch is reported as the blocking hit
+            PxOverlapBuffer hit;
+            if (scene.overlap(overlapQueries.geometries[i].any(), overlapQueries.poses[i], hit, PxQueryFilterData(filter.data, filter.flags | PxQueryFlag::eANY_HIT)))
+            {
+                overlaps.hasHit[i] = true;
+                overlaps.actors[i] = hit.block.actor;
+            }
+        }
+    }
+}
+
+void PhysicsQueryBatch::Execute(const PxScene& scene, ThreadPool& pool, size_t jobCount)
+{
+    raycastHits.Resize(raycasts.origins.size());
+    sweepHits.Resize(sweeps.geometries.size());
+    overlaps.Resize(overlapQueries.geometries.size());
+
+    const size_t queryCount = GetQueryCount();
+    jobCount = std::clamp(queryCount / MIN_QUERIES_PER_JOB, size_t{1}, std::max(jobCount, size_t{1}));
+    if (jobCount == 1)
+    {
+        ExecuteRange(scene, 0, queryCount);
+        return;
+    }
+
+    // Every job writes to its own range of the results
+    const size_t batchSize = (queryCount + jobCount - 1) / jobCount;
+    static FrameArena& frameArena = WindowsEngine::GetModule<FrameArena>();
+    FrameVector<ThreadPool::TaskHandle> handles{frameArena};
+    handles.reserve(jobCount);
+    for (size_t job = 0; job < jobCount; ++job)
+    {
+        const size_t begin = std::min(job * batchSize, queryCount);
+        const size_t end = std::min(begin + batchSize, queryCount);
+        handles.push_back(pool.AddWaitableTask([this, &scene, begin, end] { ExecuteRange(scene, begin, end); }));
+    }
+
+    for (const ThreadPool::TaskHandle& handle : handles)
+        pool.WaitFor(handle);
+}
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+
+#include <PxPhysicsAPI.h>
+
+namespace Snail
+{
+class ThreadPool;
+
+// Scene queries submitted together and executed in parallel batches on the job system.
+// Queries and their results are stored as parallel arrays, indexed by what the Add functions return.
+class PhysicsQueryBatch
+{
+public:
+    // Below this many queries per job, scheduling costs more than the queries themselves
+    static constexpr size_t MIN_QUERIES_PER_JOB = 64;
+
+    struct Filter
+    {
+        // Only shapes whose query filter data shares a bit with this are hit, every shape when left at zero
+        physx::PxFilterData data{};
+        physx::PxQueryFlags flags = physx::PxQueryFlag::eSTATIC | physx::PxQueryFlag::eDYNAMIC;
+    };
+
+    // Closest hit of every raycast or sweep
+    struct Hits
+    {
+        std::vector<uint8_t> hasHit;
+        std::vector<float> distances;
+        std::vector<Vector3> positions;
+        std::vector<Vector3> normals;
+        std::vector<physx::PxRigidActor*> actors;
+
+        void Resize(size_t count);
+        [[nodiscard]] size_t GetHitCount() const noexcept;
+    };
+
+    // Any shape overlapping each geometry
+    struct Overlaps
+    {
+        std::vector<uint8_t> hasHit;
+        std::vector<physx::PxRigidActor*> actors;
+
+        void Resize(size_t count);
+        [[nodiscard]] size_t GetHitCount() const noexcept;
+    };
+
+private:
+    struct Raycasts
+    {
+        std::vector<Vector3> origins;
+        std::vector<Vector3> directions;
+        std::vector<float> maxDistances;
+        std::vector<Filter> filters;
+    };
+
+    struct Sweeps
+    {
+        std::vector<physx::PxGeometryHolder> geometries;
+        std::vector<physx::PxTransform> poses;
+        std::vector<Vector3> directions;
+        std::vector<float> maxDistances;
+        std::vector<Filter> filters;
+    };
+
+    struct OverlapQueries
+    {
+        std::vector<physx::PxGeometryHolder> geometries;
+        std::vector<physx::PxTransform> poses;
+        std::vector<Filter> filters;
+    };
+
+    Raycasts raycasts;
+    Sweeps sweeps;
+    OverlapQueries overlapQueries;
+
+    Hits raycastHits;
+    Hits sweepHits;
+    Overlaps overlaps;
+
+    // Queries are numbered raycasts first, then sweeps, then overlaps
+    void ExecuteRange(const physx::PxScene& scene, size_t begin, size_t end);
+
+public:
+    // Directions must be normalized
+    size_t AddRaycast(const Vector3& origin, const Vector3& direction, float maxDistance, const Filter& filter = {});
+    size_t AddSweep(const physx::PxGeometry& geometry, const physx::PxTransform& pose, const Vector3& direction, float maxDistance, const Filter& filter = {});
+    size_t AddOverlap(const physx::PxGeometry& geometry, const physx::PxTransform& pose, const Filter& filter = {});
+
+    // Removes every query, the arrays keep their capacity for the next frame
+    void Clear() noexcept;
+    [[nodiscard]] size_t GetQueryCount() const noexcept;
+
+    // The scene must not be simulated nor modified until this returns, see PhysicsModule::ExecuteQueries
+    void Execute(const physx::PxScene& scene, ThreadPool& pool, size_t jobCount);
+
+    [[nodiscard]] const Hits& GetRaycastHits() const noexcept { return raycastHits; }
+    [[nodiscard]] const Hits& GetSweepHits() const noexcept { return sweepHits; }
+    [[nodiscard]] const Overlaps& GetOverlaps() const noexcept { return overlaps; }
+};
+
+}
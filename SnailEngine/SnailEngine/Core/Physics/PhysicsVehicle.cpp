@@ -2,40 +2,43 @@
 
 #include "PhysicsVehicle.h"
 
+#include "VehicleManager.h"
 #include "Core/WindowsEngine.h"
 
-#include "Util/PhysX/BaseSerialization.h"
-#include "Util/PhysX/DirectDrivetrainSerialization.h"
-#include "Util/PhysX/EngineDrivetrainSerialization.h"
-
 using namespace physx;
 
 namespace Snail
 {
 PhysicsVehicle::PhysicsVehicle(const Transform& initialTransform)
+    : PhysicsVehicle(initialTransform, WindowsEngine::GetModule<PhysicsModule>().vehicles)
+{
+}
+
+PhysicsVehicle::PhysicsVehicle(const Transform& initialTransform, VehicleManager& vehicleManager, const std::string& paramsDirectory)
+    : manager(&vehicleManager)
 {
-    std::unique_lock lock{PhysxMutex};
+    // Parsed by the first vehicle of the model only
+    model = &manager->GetModel(paramsDirectory);
+    const VehicleWorld& world = manager->GetWorld();
 
-    static PhysicsModule& physicsMod = WindowsEngine::GetModule<PhysicsModule>();
+    PhysxWriteLock lock;
 
-    readBaseParamsFromJsonFile(DefaultParamsDirectory, DefaultVehicleBaseParamsFile, engineDriveVehicle.mBaseParams);
-    SetPhysXIntegrationParams(engineDriveVehicle.mBaseParams.axleDescription,
-        physicsMod.materialFrictions,
-        physicsMod.nbMaterialFrictions,
-        physicsMod.defaultMaterialFriction,
-        engineDriveVehicle.mPhysXParams);
-    readEngineDrivetrainParamsFromJsonFile(DefaultParamsDirectory, DefaultVehicleEngineDriveParams, engineDriveVehicle.mEngineDriveParams);
+    engineDriveVehicle.mBaseParams = model->baseParams;
+    engineDriveVehicle.mPhysXParams = model->physxParams;
+    engineDriveVehicle.mEngineDriveParams = model->engineDriveParams;
 
     //Set the states to default.
-    if (!engineDriveVehicle.Initialize(*physicsMod.physics,
+    //The manager runs the components touching the physx actor itself, around the parallel part of the step.
+    if (!engineDriveVehicle.Initialize(*world.physics,
         PxCookingParams(PxTolerancesScale()),
-        *physicsMod.defaultMaterial,
-        EngineDriveVehicle::eDIFFTYPE_FOURWHEELDRIVE))
+        *world.defaultMaterial,
+        EngineDriveVehicle::eDIFFTYPE_FOURWHEELDRIVE,
+        false))
     {
         LOG(Logger::FATAL, "Unable to instantiate vehicle physics!");
     }
 
-    engineDriveVehicle.SetUpActor(*physicsMod.scene, initialTransform, "Vehicle");
+    engineDriveVehicle.SetUpActor(*world.scene, initialTransform, "Vehicle");
 
     engineDriveVehicle.mCommandState.nbBrakes = 1;
     engineDriveVehicle.mCommandState.brakes[0] = 0;
@@ -43,21 +46,20 @@ PhysicsVehicle::PhysicsVehicle(const Transform& initialTransform)
     engineDriveVehicle.mEngineDriveState.gearboxState.targetGear = engineDriveVehicle.mEngineDriveParams.gearBoxParams.neutralGear + 1;
     engineDriveVehicle.mTransmissionCommandState.targetGear = static_cast<PxU32>(GearState::AUTOMATIC);
 
-    // Set up the simulation context.
-    // SnailEngine uses:
-    //      a) z as the longitudinal axis
-    //      b) x as the lateral axis
-    //      c) y as the vertical axis.
-    //      d) metres  as the lengthscale.
-    gVehicleSimulationContext.setToDefault();
-    gVehicleSimulationContext.frame.lngAxis = PxVehicleAxes::ePosZ;
-    gVehicleSimulationContext.frame.latAxis = PxVehicleAxes::ePosX;
-    gVehicleSimulationContext.frame.vrtAxis = PxVehicleAxes::ePosY;
-    gVehicleSimulationContext.scale.scale = 1.0f;
-    gVehicleSimulationContext.gravity = physicsMod.scene->getGravity();
-    gVehicleSimulationContext.physxScene = physicsMod.scene.get();
-    gVehicleSimulationContext.physxActorUpdateMode = PxVehiclePhysXActorUpdateMode::eAPPLY_ACCELERATION;
+    manager->Register(*this);
+}
+
+void PhysicsVehicle::ApplyModel(const VehicleModel& reloadedModel)
+{
+    model = &reloadedModel;
+    engineDriveVehicle.mBaseParams = reloadedModel.baseParams;
+    engineDriveVehicle.mPhysXParams = reloadedModel.physxParams;
+    engineDriveVehicle.mEngineDriveParams = reloadedModel.engineDriveParams;
 
+    // The actor took its mass from the parameters when it was created
+    const PxVehicleRigidBodyParams& rigidBodyParams = reloadedModel.baseParams.rigidBodyParams;
+    engineDriveVehicle.GetRigidBody()->setMass(rigidBodyParams.mass);
+    engineDriveVehicle.GetRigidBody()->setMassSpaceInertiaTensor(rigidBodyParams.moi);
 }
 
 bool PhysicsVehicle::SetTransform(const Transform& transform)
@@ -93,6 +95,18 @@ Vector3 PhysicsVehicle::GetLinearVelocity()
     return {globalLinearVelocity.x, globalLinearVelocity.y, globalLinearVelocity.z};
 }
 
+Vector3 PhysicsVehicle::GetPosition() const
+{
+    const PxVec3 position = engineDriveVehicle.GetRigidBody()->getGlobalPose().p;
+    return {position.x, position.y, position.z};
+}
+
+float PhysicsVehicle::GetForwardSpeed() const
+{
+    const PxRigidBody* driveBody = engineDriveVehicle.GetRigidBody();
+    return driveBody->getLinearVelocity().dot(driveBody->getGlobalPose().q.getBasisVector2());
+}
+
 void PhysicsVehicle::Accelerate(const float intensity)
 {
     LOG(Logger::INFO, "intensite voiture, ", intensity);
@@ -140,20 +154,40 @@ void PhysicsVehicle::Neutral()
     //Brake(0.3f);
 }
 
-void PhysicsVehicle::Update(const float dt)
+bool PhysicsVehicle::BeginStep(const float dt, const PxVehicleSimulationContext& context)
+{
+    return static_cast<PxVehiclePhysXActorBeginComponent&>(engineDriveVehicle).update(dt, context);
+}
+
+void PhysicsVehicle::SimulateStep(const float dt, const PxVehicleSimulationContext& context, const PxU8 substeps)
 {
-    // Apply substepping at low forward speed to improve simulation fidelity
-    const PxVec3 linVel = engineDriveVehicle.mPhysXState.physxActor.rigidBody->getLinearVelocity();
-    const PxVec3 forwardDir = engineDriveVehicle.mPhysXState.physxActor.rigidBody->getGlobalPose().q.getBasisVector2();
-    const PxReal forwardSpeed = linVel.dot(forwardDir);
-    const PxU8 nbSubsteps = forwardSpeed < 5.0f ? 3 : 1;
-    engineDriveVehicle.mComponentSequence.setSubsteps(engineDriveVehicle.mComponentSequenceSubstepGroupHandle, nbSubsteps);
+    engineDriveVehicle.mComponentSequence.setSubsteps(engineDriveVehicle.mComponentSequenceSubstepGroupHandle, substeps);
+    engineDriveVehicle.Step(dt, context);
+}
 
-    engineDriveVehicle.Step(dt, gVehicleSimulationContext);
+void PhysicsVehicle::EndStep(const float dt, const PxVehicleSimulationContext& context)
+{
+    static_cast<PxVehiclePhysXConstraintComponent&>(engineDriveVehicle).update(dt, context);
+    static_cast<PxVehiclePhysXActorEndComponent&>(engineDriveVehicle).update(dt, context);
+
+    // Materials with a PhysicsSurface in their user data tell what the wheels are rolling on
+    isOnGrass = false;
+    const PxVehicleAxleDescription& axleDescription = engineDriveVehicle.mBaseParams.axleDescription;
+    for (PxU32 i = 0; i < axleDescription.nbWheels; ++i)
+    {
+        const PxU32 wheelId = axleDescription.wheelIdsInAxleOrder[i];
+        if (!engineDriveVehicle.mBaseState.roadGeomStates[wheelId].hitState)
+            continue;
+
+        if (const PxMaterial* material = engineDriveVehicle.mPhysXState.physxRoadGeometryStates[wheelId].material; material && material->userData)
+            isOnGrass |= static_cast<const PhysicsSurface*>(material->userData)->isGrass;
+    }
 }
 
 PhysicsVehicle::~PhysicsVehicle()
 {
+    PhysxWriteLock lock;
+    manager->Unregister(*this);
     engineDriveVehicle.Destroy();
 }
 
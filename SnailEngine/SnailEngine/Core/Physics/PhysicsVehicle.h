@@ -5,6 +5,7 @@
 #include "Vehicle/DirectDriveVehicle.h"
 #include "Vehicle/EngineDriveVehicle.h"
 #include <array>
+#include <string>
 
 namespace physx
 {
@@ -18,14 +19,30 @@ static constexpr const char* DefaultParamsDirectory = "Resources/VehicleData";
 static constexpr const char* DefaultVehicleBaseParamsFile = "Base.json";
 static constexpr const char* DefaultVehicleEngineDriveParams = "EngineDrive.json";
 
+class VehicleManager;
+struct VehicleModel;
+
+// What the wheels roll on, set as the user data of the PhysX materials of the ground
+struct PhysicsSurface
+{
+    // Slows the vehicles down
+    bool isGrass = false;
+};
+
 class PhysicsVehicle : public PhysicsObject
 {
-    //Vehicle simulation needs a simulation context
-    //to store global parameters of the simulation such as 
-    //gravitational acceleration.
-    PxVehiclePhysXSimulationContext gVehicleSimulationContext;
+    friend VehicleManager;
+
+    VehicleManager* manager;
+    size_t managerIndex = 0;
+    // Shared with the other vehicles of the model, owned by the manager
+    const VehicleModel* model = nullptr;
+
     inline static physx::PxVec3 force{0.0f, 0.0f, -20000.0f};
 
+    // A wheel touched grass during the last step
+    bool isOnGrass = false;
+
     enum class GearState : PxU32
     {
         REVERSE = 0,
@@ -36,8 +53,19 @@ class PhysicsVehicle : public PhysicsObject
 protected:
     EngineDriveVehicle engineDriveVehicle;
 
+    // The steps of the manager, with the scene locked. Begin and end run on the thread of the manager, they read and
+    // write the actor. Simulate runs on any thread and only queries the scene.
+    // Begin returns false when the vehicle is asleep and has nothing to do.
+    bool BeginStep(float dt, const PxVehicleSimulationContext& context);
+    void SimulateStep(float dt, const PxVehicleSimulationContext& context, PxU8 substeps);
+    void EndStep(float dt, const PxVehicleSimulationContext& context);
+    // Takes the parameters of a reloaded model, under the exclusive PhysX lock
+    void ApplyModel(const VehicleModel& reloadedModel);
+
 public:
+    // Stepped by the vehicle manager of the physics module
     PhysicsVehicle(const Transform& initialTransform);
+    PhysicsVehicle(const Transform& initialTransform, VehicleManager& vehicleManager, const std::string& paramsDirectory = DefaultParamsDirectory);
     ~PhysicsVehicle() override;
 
     PxShape* GetChassisShape();
@@ -52,6 +80,8 @@ public:
     void UpdateTransformWheels(std::array<Transform, 4>& transforms, const std::array<Vector3, 4>& meshOffsets);
 
     Vector3 GetLinearVelocity();
+    Vector3 GetPosition() const;
+    float GetForwardSpeed() const;
 
     void Accelerate(float intensity);
     void Reverse(float intensity);
@@ -65,10 +95,9 @@ public:
     void Neutral();
 
     float GetSpeed() const;
+    bool IsOnGrass() const noexcept { return isOnGrass; }
     void Boost(const Vector3& direction, float intensity);
 
-    void Update(float dt);
-
     void RenderImGui() override;
 };
 }
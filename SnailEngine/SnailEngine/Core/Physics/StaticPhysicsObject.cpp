@@ -8,7 +8,7 @@ namespace Snail
 
 StaticPhysicsObject::StaticPhysicsObject(physx::PxShape* shape, const Transform& initialTransform)
 {
-    std::unique_lock lock{ PhysxMutex };
+    PhysxWriteLock lock;
 
     StaticPhysicsObject::SetShape(shape);
     StaticPhysicsObject::SetTransform(initialTransform);
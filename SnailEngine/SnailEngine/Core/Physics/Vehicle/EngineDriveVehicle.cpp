@@ -115,7 +115,10 @@ void EngineDriveVehicle::InitComponentSequence(const bool addPhysXBeginEndCompon
 
     //Apply any "sticky" velocity constraints to a data buffer that will be consumed by the physx scene
     //during the next physx scene update.
-    mComponentSequence.add(static_cast<PxVehiclePhysXConstraintComponent*>(this));
+    //Like the begin and end components it writes to the physx scene, left out with them. Only the last substep's
+    //constraints are consumed by the scene, so it can run once after the sequence instead.
+    if (addPhysXBeginEndComponents)
+        mComponentSequence.add(static_cast<PxVehiclePhysXConstraintComponent*>(this));
 
     //Update the rotational speed of the engine and wheels by applying the available drive torque 
     //to the wheels through the clutch, differential and gears and accounting for the longitudinal
@@ -1,8 +1,6 @@
 ﻿#include "stdafx.h"
 #include "PhysXActorVehicle.h"
 
-#include "Core/Physics/Callbacks/VehicleQueryCallback.h"
-
 namespace Snail
 {
 
@@ -15,7 +13,9 @@ void PhysXIntegrationParams::Create(
     const PxReal defaultFriction,
     const PxTransform& actorCMassLocalPose,
     const PxVec3& actorBoxShapeHalfExtents,
-    const PxTransform& actorBoxShapeLocalPose)
+    const PxTransform& actorBoxShapeLocalPose,
+    const PxFilterData& actorSimulationFilterData,
+    const PxFilterData& actorQueryFilterData)
 {
     physxRoadGeometryQueryParams.roadGeometryQueryType = PxVehiclePhysXRoadGeometryQueryType::eRAYCAST;
     physxRoadGeometryQueryParams.defaultFilterData = queryFilterData;
@@ -39,6 +39,8 @@ void PhysXIntegrationParams::Create(
     physxActorCMassLocalPose = actorCMassLocalPose;
     physxActorBoxShapeHalfExtents = actorBoxShapeHalfExtents;
     physxActorBoxShapeLocalPose = actorBoxShapeLocalPose;
+    physxActorSimulationFilterData = actorSimulationFilterData;
+    physxActorQueryFilterData = actorQueryFilterData;
 }
 
 PhysXIntegrationParams PhysXIntegrationParams::TransformAndScale(
@@ -75,9 +77,9 @@ void PhysXIntegrationState::Create(
         const PxVehiclePhysXRigidActorShapeParams physxActorShapeParams(boxGeom,
             physxParams.physxActorBoxShapeLocalPose,
             defaultMaterial,
-            PxShapeFlags(PxShapeFlag::eSIMULATION_SHAPE),
-            PxFilterData(),
-            PxFilterData());
+            PxShapeFlags(PxShapeFlag::eSIMULATION_SHAPE | PxShapeFlag::eSCENE_QUERY_SHAPE),
+            physxParams.physxActorSimulationFilterData,
+            physxParams.physxActorQueryFilterData);
 
         const PxVehiclePhysXWheelParams physxWheelParams(baseParams.axleDescription, baseParams.wheelParams);
         const PxVehiclePhysXWheelShapeParams physxWheelShapeParams(defaultMaterial,
@@ -111,16 +113,13 @@ void SetPhysXIntegrationParams(
     PxVehiclePhysXMaterialFriction* physXMaterialFrictions,
     PxU32 nbPhysXMaterialFrictions,
     PxReal physXDefaultMaterialFriction,
+    const PxQueryFilterData& wheelQueryFilterData,
+    const PxFilterData& chassisSimulationFilterData,
+    const PxFilterData& chassisQueryFilterData,
     PhysXIntegrationParams& physXParams)
 {
-    // This defines how the vehicle's QueryFilter responds to other objects
-    static VehicleQueryCallback callback;
-    // The first flag defines that the prefilter callback should be executed no matter what to potentially filter certain shapes
-    // (in our case triggers since we do not want them to have a physical collision with our vehicle)
-    // The other two flags (eSTATIC and eDYNAMIC) define the types of shapes that this vehicle can collide with in a SceneQuery
-    const PxQueryFilterData queryFilterData = PxQueryFilterData(PxFilterData{},
-        PxQueryFlag::ePREFILTER | PxQueryFlag::ePOSTFILTER | PxQueryFlag::eSTATIC | PxQueryFlag::eDYNAMIC);
-    PxQueryFilterCallback* queryFilterCallback = &callback;
+    // The layers in the mask of the filter data pick what the wheels roll on, triggers aren't query shapes at all.
+    // Without a filter callback PhysX doesn't call back into the engine for every shape the raycasts touch.
 
     // The physx integration params are hardcoded rather than loaded from file.
     // Either could work since I imported the rapidjson serialisation code from the PhysX snippets aswell.
@@ -129,14 +128,16 @@ void SetPhysXIntegrationParams(
     const PxTransform physxActorBoxShapeLocalPose(PxVec3(0.0f,1.f, 1.37003f), PxQuat(PxIdentity));
 
     physXParams.Create(axleDescription,
-        queryFilterData,
-        queryFilterCallback,
+        wheelQueryFilterData,
+        nullptr,
         physXMaterialFrictions,
         nbPhysXMaterialFrictions,
         physXDefaultMaterialFriction,
         physxActorCMassLocalPose,
         physxActorBoxShapeHalfExtents,
-        physxActorBoxShapeLocalPose);
+        physxActorBoxShapeLocalPose,
+        chassisSimulationFilterData,
+        chassisQueryFilterData);
 }
 
 bool PhysXActorVehicle::Initialize(PxPhysics& physics, const PxCookingParams& params, PxMaterial& defaultMaterial)
@@ -277,7 +278,7 @@ void PhysXActorVehicle::getDataForPhysXRoadGeometrySceneQueryComponent(
     suspensionParams.setData(mBaseParams.suspensionParams);
     materialFrictionParams.setData(mPhysXParams.physxMaterialFrictionParams);
     roadGeometryStates.setData(mBaseState.roadGeomStates);
-    physxRoadGeometryStates.setEmpty();
+    physxRoadGeometryStates.setData(mPhysXState.physxRoadGeometryStates);
 }
 
 }
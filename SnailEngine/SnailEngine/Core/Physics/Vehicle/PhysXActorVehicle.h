@@ -17,6 +17,9 @@ struct PhysXIntegrationParams
     PxTransform physxActorCMassLocalPose;
     PxVec3 physxActorBoxShapeHalfExtents;
     PxTransform physxActorBoxShapeLocalPose;
+    //Collision layer of the chassis shape
+    PxFilterData physxActorSimulationFilterData;
+    PxFilterData physxActorQueryFilterData;
     PxTransform physxWheelShapeLocalPoses[PxVehicleLimits::eMAX_NB_WHEELS];
 
     void Create(
@@ -28,7 +31,9 @@ struct PhysXIntegrationParams
         PxReal defaultFriction,
         const PxTransform& physXActorCMassLocalPose,
         const PxVec3& physXActorBoxShapeHalfExtents,
-        const PxTransform& physxActorBoxShapeLocalPose);
+        const PxTransform& physxActorBoxShapeLocalPose,
+        const PxFilterData& physxActorSimulationFilterData,
+        const PxFilterData& physxActorQueryFilterData);
 
     PhysXIntegrationParams TransformAndScale(
         const PxVehicleFrame& srcFrame,
@@ -57,12 +62,15 @@ struct PhysXIntegrationState
     PxVehiclePhysXActor physxActor; //physx actor
     PxVehiclePhysXSteerState physxSteerState;
     PxVehiclePhysXConstraints physxConstraints; //susp limit and sticky tire constraints
+    PxVehiclePhysXRoadGeometryQueryState physxRoadGeometryStates[PxVehicleLimits::eMAX_NB_WHEELS]; //what the wheels hit
 
     PX_FORCE_INLINE void SetToDefault()
     {
         physxActor.setToDefault();
         physxSteerState.setToDefault();
         physxConstraints.setToDefault();
+        for (PxVehiclePhysXRoadGeometryQueryState& physxRoadGeometryState : physxRoadGeometryStates)
+            physxRoadGeometryState.setToDefault();
     }
 
     void Create(
@@ -75,11 +83,15 @@ struct PhysXIntegrationState
     void Destroy();
 };
 
+//The wheels only hit the shapes matching the mask of wheelQueryFilterData, without filter callbacks
 void SetPhysXIntegrationParams(
     const PxVehicleAxleDescription&,
     PxVehiclePhysXMaterialFriction*,
     PxU32 nbPhysXMaterialFrictions,
     PxReal physXDefaultMaterialFriction,
+    const PxQueryFilterData& wheelQueryFilterData,
+    const PxFilterData& chassisSimulationFilterData,
+    const PxFilterData& chassisQueryFilterData,
     PhysXIntegrationParams&);
 
 //
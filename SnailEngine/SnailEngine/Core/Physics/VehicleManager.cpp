@@ -0,0 +1,240 @@
+#include "stdafx.h"
+#include "VehicleManager.h"
+
+#include <chrono>
+
+#include "CollisionLayers.h"
+#include "PhysicsVehicle.h"
+#include "Core/ThreadPool.h"
+#include "Core/WindowsEngine.h"
+#include "Core/Memory/FrameArena.h"
+
+#include "Util/PhysX/BaseSerialization.h"
+#include "Util/PhysX/EngineDrivetrainSerialization.h"
+
+namespace Snail
+{
+
+void VehicleManager::Init(const VehicleWorld& vehicleWorld)
+{
+    world = vehicleWorld;
+
+    // SnailEngine uses:
+    //      a) z as the longitudinal axis
+    //      b) x as the lateral axis
+    //      c) y as the vertical axis.
+    //      d) metres  as the lengthscale.
+    fullRateContext.setToDefault();
+    fullRateContext.frame.lngAxis = PxVehicleAxes::ePosZ;
+    fullRateContext.frame.latAxis = PxVehicleAxes::ePosX;
+    fullRateContext.frame.vrtAxis = PxVehicleAxes::ePosY;
+    fullRateContext.scale.scale = 1.0f;
+    fullRateContext.gravity = world.scene->getGravity();
+    fullRateContext.physxScene = world.scene;
+    fullRateContext.physxActorUpdateMode = PxVehiclePhysXActorUpdateMode::eAPPLY_ACCELERATION;
+
+    reducedRateContext = fullRateContext;
+    reducedRateContext.physxActorUpdateMode = PxVehiclePhysXActorUpdateMode::eAPPLY_VELOCITY;
+}
+
+const VehicleModel& VehicleManager::GetModel(const std::string& directory)
+{
+    std::lock_guard lock{modelMutex};
+    std::unique_ptr<const VehicleModel>& model = models[directory];
+    if (model)
+        return *model;
+
+    std::unique_ptr<VehicleModel> parsed = ParseModel(directory);
+    if (!parsed)
+        LOGF(Logger::FATAL, "Unable to read the vehicle parameters in {}", directory);
+
+    model = std::move(parsed);
+    return *model;
+}
+
+std::unique_ptr<VehicleModel> VehicleManager::ParseModel(const std::string& directory) const
+{
+    auto parsed = std::make_unique<VehicleModel>();
+    if (!readBaseParamsFromJsonFile(directory.c_str(), DefaultVehicleBaseParamsFile, parsed->baseParams)
+        || !readEngineDrivetrainParamsFromJsonFile(directory.c_str(), DefaultVehicleEngineDriveParams, parsed->engineDriveParams))
+    {
+        return nullptr;
+    }
+
+    const CollisionLayers& layers = *world.collisionLayers;
+    const uint32_t vehicleLayer = layers.GetLayer("vehicle");
+    SetPhysXIntegrationParams(parsed->baseParams.axleDescription,
+        world.materialFrictions,
+        world.nbMaterialFrictions,
+        world.defaultMaterialFriction,
+        layers.GetQueryFilter(CollisionLayers::Query::WHEEL),
+        layers.GetSimulationFilterData(vehicleLayer),
+        layers.GetQueryFilterData(vehicleLayer),
+        parsed->physxParams);
+
+    return parsed;
+}
+
+std::vector<std::string> VehicleManager::GetModelDirectories()
+{
+    std::lock_guard lock{modelMutex};
+    std::vector<std::string> directories;
+    for (const auto& [directory, model] : models)
+    {
+        if (model)
+            directories.push_back(directory);
+    }
+    return directories;
+}
+
+bool VehicleManager::ReplaceModel(const std::string& directory, const VehicleModel& model)
+{
+    std::lock_guard lock{modelMutex};
+    const auto it = models.find(directory);
+    if (it == models.end() || !it->second)
+        return false;
+
+    if (model.baseParams.axleDescription.nbWheels != it->second->baseParams.axleDescription.nbWheels)
+    {
+        LOGF(Logger::WARN, "The wheel count of vehicle model \"{}\" changed, load the scene again to use it", directory);
+        return false;
+    }
+
+    auto replacement = std::make_unique<const VehicleModel>(model);
+    for (PhysicsVehicle* vehicle : vehicles)
+    {
+        if (vehicle->model == it->second.get())
+            vehicle->ApplyModel(*replacement);
+    }
+    it->second = std::move(replacement);
+    return true;
+}
+
+void VehicleManager::Register(PhysicsVehicle& vehicle)
+{
+    vehicle.managerIndex = vehicles.size();
+    vehicles.push_back(&vehicle);
+    pendingDts.push_back(0);
+    pendingFrames.push_back(0);
+    substeps.push_back(1);
+    isReducedRate.push_back(false);
+}
+
+void VehicleManager::Unregister(PhysicsVehicle& vehicle)
+{
+    // Swap with the last vehicle and pop
+    const size_t index = vehicle.managerIndex;
+    const size_t last = vehicles.size() - 1;
+    vehicles[index] = vehicles[last];
+    vehicles[index]->managerIndex = index;
+    pendingDts[index] = pendingDts[last];
+    pendingFrames[index] = pendingFrames[last];
+    substeps[index] = substeps[last];
+    isReducedRate[index] = isReducedRate[last];
+
+    vehicles.pop_back();
+    pendingDts.pop_back();
+    pendingFrames.pop_back();
+    substeps.pop_back();
+    isReducedRate.pop_back();
+}
+
+const PxVehicleSimulationContext& VehicleManager::GetContext(const size_t index) const noexcept
+{
+    return isReducedRate[index] ? reducedRateContext : fullRateContext;
+}
+
+void VehicleManager::SimulateRange(const size_t begin, const size_t end)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        const uint32_t index = steppingIndices[i];
+        vehicles[index]->SimulateStep(pendingDts[index], GetContext(index), substeps[index]);
+    }
+}
+
+void VehicleManager::Step(const float dt, const Vector3& focus, ThreadPool* pool, size_t jobCount)
+{
+    using Clock = std::chrono::high_resolution_clock;
+    const auto elapsedMs = [](const Clock::time_point start) { return std::chrono::duration<float, std::milli>(Clock::now() - start).count(); };
+
+    stats = {};
+    stats.vehicleCount = vehicles.size();
+
+    // Reads the actors, wakes the ones the commands want moving
+    auto start = Clock::now();
+    steppingIndices.clear();
+    for (uint32_t i = 0; i < vehicles.size(); ++i)
+    {
+        pendingDts[i] += dt;
+        ++pendingFrames[i];
+
+        isReducedRate[i] = Vector3::DistanceSquared(vehicles[i]->GetPosition(), focus) > REDUCED_RATE_DISTANCE * REDUCED_RATE_DISTANCE;
+        stats.reducedRateCount += isReducedRate[i];
+        if (isReducedRate[i] && pendingFrames[i] < REDUCED_RATE_INTERVAL)
+            continue;
+
+        if (!vehicles[i]->BeginStep(pendingDts[i], GetContext(i)))
+        {
+            // Nothing happened to it meanwhile
+            pendingDts[i] = 0;
+            pendingFrames[i] = 0;
+            ++stats.asleepCount;
+            continue;
+        }
+
+        // Substepping at low forward speed improves the simulation fidelity, as many per frame as the frames it waited
+        const PxU8 frameSubsteps = vehicles[i]->GetForwardSpeed() < LOW_SPEED ? LOW_SPEED_SUBSTEPS : 1;
+        substeps[i] = static_cast<PxU8>(std::min<uint32_t>(frameSubsteps * pendingFrames[i], std::numeric_limits<PxU8>::max()));
+        steppingIndices.push_back(i);
+    }
+    stats.steppedCount = steppingIndices.size();
+    stats.beginMs = elapsedMs(start);
+
+    // Only touches the state of each vehicle and queries the scene
+    start = Clock::now();
+    const size_t steppingCount = steppingIndices.size();
+    jobCount = pool ? std::clamp(steppingCount / MIN_VEHICLES_PER_JOB, size_t{1}, std::max(jobCount, size_t{1})) : 1;
+    if (jobCount == 1)
+    {
+        SimulateRange(0, steppingCount);
+    }
+    else
+    {
+        const size_t batchSize = (steppingCount + jobCount - 1) / jobCount;
+        static FrameArena& frameArena = WindowsEngine::GetModule<FrameArena>();
+        FrameVector<ThreadPool::TaskHandle> handles{frameArena};
+        handles.reserve(jobCount);
+        for (size_t job = 0; job < jobCount; ++job)
+        {
+            const size_t begin = std::min(job * batchSize, steppingCount);
+            const size_t end = std::min(begin + batchSize, steppingCount);
+            handles.push_back(pool->AddWaitableTask([this, begin, end] { SimulateRange(begin, end); }));
+        }
+
+        for (const ThreadPool::TaskHandle& handle : handles)
+            pool->WaitFor(handle);
+    }
+    stats.simulateMs = elapsedMs(start);
+
+    // Writes the constraints and the actors back
+    start = Clock::now();
+    for (const uint32_t index : steppingIndices)
+    {
+        vehicles[index]->EndStep(pendingDts[index], GetContext(index));
+        pendingDts[index] = 0;
+        pendingFrames[index] = 0;
+    }
+    stats.endMs = elapsedMs(start);
+}
+
+#ifdef _IMGUI_
+void VehicleManager::RenderImGui() const
+{
+    ImGui::Text("%zu vehicles, %zu stepped, %zu asleep, %zu at a reduced rate", stats.vehicleCount, stats.steppedCount, stats.asleepCount, stats.reducedRateCount);
+    ImGui::Text("Begin %.3f ms, simulate %.3f ms, end %.3f ms", stats.beginMs, stats.simulateMs, stats.endMs);
+    ImGui::Text("Models: %zu", models.size());
+}
+#endif
+
+}
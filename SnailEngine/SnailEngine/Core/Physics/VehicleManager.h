@@ -0,0 +1,114 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Vehicle/EngineDriveVehicle.h"
+
+namespace Snail
+{
+class CollisionLayers;
+class PhysicsVehicle;
+class ThreadPool;
+
+// Parameters of a vehicle model, parsed once and shared by every vehicle of that model
+struct VehicleModel
+{
+    BaseVehicleParams baseParams;
+    PhysXIntegrationParams physxParams;
+    EngineDrivetrainParams engineDriveParams;
+};
+
+// What the vehicles of a manager are created in and drive on
+struct VehicleWorld
+{
+    PxPhysics* physics = nullptr;
+    PxScene* scene = nullptr;
+    PxMaterial* defaultMaterial = nullptr;
+    const CollisionLayers* collisionLayers = nullptr;
+    PxVehiclePhysXMaterialFriction* materialFrictions = nullptr;
+    PxU32 nbMaterialFrictions = 0;
+    PxReal defaultMaterialFriction = 1.0f;
+};
+
+// Steps the vehicles of a scene together, before the scene simulates. The components reading and writing the PhysX
+// actors and constraints run on the calling thread, everything in between, wheel road queries included, runs in
+// parallel chunks on the job system. Vehicles far from the focus are stepped every few frames with the time
+// accumulated meanwhile, asleep ones aren't stepped at all.
+class VehicleManager
+{
+public:
+    // Below this many vehicles per job, scheduling costs more than the vehicles themselves
+    static constexpr size_t MIN_VEHICLES_PER_JOB = 4;
+    static constexpr float REDUCED_RATE_DISTANCE = 80.0f;
+    static constexpr uint32_t REDUCED_RATE_INTERVAL = 4;
+    // Substeps of the suspensions and tires below that forward speed, for stability
+    static constexpr PxReal LOW_SPEED = 5.0f;
+    static constexpr PxU8 LOW_SPEED_SUBSTEPS = 3;
+
+    struct Stats
+    {
+        size_t vehicleCount = 0;
+        size_t steppedCount = 0;
+        size_t asleepCount = 0;
+        size_t reducedRateCount = 0;
+        float beginMs = 0;
+        float simulateMs = 0;
+        float endMs = 0;
+    };
+
+private:
+    VehicleWorld world;
+    // The reduced rate one applies velocities, the accelerations of several frames would be applied over one step
+    PxVehiclePhysXSimulationContext fullRateContext;
+    PxVehiclePhysXSimulationContext reducedRateContext;
+
+    std::mutex modelMutex;
+    std::unordered_map<std::string, std::unique_ptr<const VehicleModel>> models;
+
+    // Indexed by PhysicsVehicle::managerIndex
+    std::vector<PhysicsVehicle*> vehicles;
+    std::vector<float> pendingDts;
+    std::vector<uint32_t> pendingFrames;
+    std::vector<PxU8> substeps;
+    std::vector<uint8_t> isReducedRate;
+    // Vehicles past the begin phase this frame
+    std::vector<uint32_t> steppingIndices;
+    Stats stats;
+
+    const PxVehicleSimulationContext& GetContext(size_t index) const noexcept;
+    void SimulateRange(size_t begin, size_t end);
+
+public:
+    void Init(const VehicleWorld& vehicleWorld);
+    const VehicleWorld& GetWorld() const noexcept { return world; }
+
+    // Parses the model on the first call for its directory, from any thread
+    const VehicleModel& GetModel(const std::string& directory);
+    // Reads a model from its directory, from any thread. Returns nullptr if its files can't be read.
+    std::unique_ptr<VehicleModel> ParseModel(const std::string& directory) const;
+    // Directories of the models parsed so far
+    std::vector<std::string> GetModelDirectories();
+    // Under the exclusive PhysX lock. Gives the parameters of a reloaded model to the vehicles of that model, unless
+    // its wheel count changed since their actors were built for the previous one.
+    bool ReplaceModel(const std::string& directory, const VehicleModel& model);
+
+    // Under the exclusive PhysX lock
+    void Register(PhysicsVehicle& vehicle);
+    void Unregister(PhysicsVehicle& vehicle);
+
+    // Under the exclusive PhysX lock, before the scene simulates. Must not be called from a job since it waits on
+    // other jobs, every vehicle is stepped on the calling thread without a pool.
+    void Step(float dt, const Vector3& focus, ThreadPool* pool, size_t jobCount);
+
+    size_t GetVehicleCount() const noexcept { return vehicles.size(); }
+    const Stats& GetStats() const noexcept { return stats; }
+
+#ifdef _IMGUI_
+    void RenderImGui() const;
+#endif
+};
+
+}
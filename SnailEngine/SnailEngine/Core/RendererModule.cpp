@@ -2,8 +2,13 @@
 #include "RendererModule.h"
 
 #include "Rendering/D3D11Device.h"
+#include "Rendering/GBufferPacking.h"
 #include "Rendering/MeshVertex.h"
 #include "WindowsEngine.h"
+#include "EntityUpdate.h"
+#include "Core/Memory/FrameArena.h"
+#include "Core/Input/InputModule.h"
+#include "Core/Memory/MemoryTracker.h"
 #include "Mesh/BillboardMesh.h"
 #include "Mesh/Mesh.h"
 #include "Mesh/DecalMesh.h"
@@ -14,6 +19,9 @@
 #include "Rendering/Effects/PostProcessing/VignetteEffect.h"
 #include "Rendering/Effects/PostProcessing/ChromaticAberrationEffect.h"
 #include "Rendering/Shadows/DirectionalShadowMap.h"
+#include "Rendering/RenderPrepThread.h"
+#include "Rendering/Occlusion/OcclusionCulling.h"
+#include "Rendering/UI/FrameTimeUI.h"
 
 namespace Snail
 {
@@ -41,6 +49,10 @@ void RendererModule::Init()
 
     volumetricLighting = std::make_unique<VolumetricLighting>(device);
 
+    occlusionCulling = std::make_unique<OcclusionCulling>();
+
+    renderPrepThread = std::make_unique<RenderPrepThread>([this](const FrameView& view) { PrepareFrame(view); });
+
     lightingPassShader.reset(new EffectsShader(L"SnailEngine/Shaders/LightingPass.fx",
         DEFAULT_ELEMENT_LAYOUT,
         DEFAULT_ELEMENT_COUNT,
@@ -84,6 +96,9 @@ void RendererModule::Init()
     imGuiEffectsShader.reset(new EffectsShader(L"SnailEngine/Shaders/Default.fx", DEFAULT_ELEMENT_LAYOUT, DEFAULT_ELEMENT_COUNT));
 
     IMGUI_CHECKVERSION();
+    ImGui::SetAllocatorFunctions(
+        [](const size_t size, void*) { return MemoryTracker::Allocate(size, MemoryTag::UI); },
+        [](void* ptr, void*) { MemoryTracker::Free(ptr); });
     ImGui::CreateContext();
 
     ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_DockingEnable;
@@ -125,8 +140,22 @@ void RendererModule::DrawFinalPassFXAA()
 
 void RendererModule::DrawUI()
 {
+    static WindowsEngine& engine = WindowsEngine::GetInstance();
+
     const auto& camera = WindowsEngine::GetCamera();
     camera->DrawOverlays();
+
+    // F3 shows the frame times over the game UI, in release builds too
+    if (InputModule::GetInstance().Keyboard.GetState().IsKeyPressed(Keyboard::F3))
+        showFrameTimeUI = !showFrameTimeUI;
+
+    if (showFrameTimeUI)
+    {
+        if (!frameTimeUI)
+            frameTimeUI = std::make_unique<FrameTimeUI>();
+        frameTimeUI->Update(engine.GetDeltaTime(), engine.GetFramePacer().GetStats());
+        frameTimeUI->Draw();
+    }
 }
 
 void RendererModule::Update(const float dt)
@@ -145,6 +174,9 @@ void RendererModule::BeginRenderScene()
             rdoc_api->StartFrameCapture(nullptr, hMainWnd);
 #endif
 
+    lastFrameShadedTriangles = std::exchange(BaseMesh::shadedTriangles, {});
+    lastFrameDepthOnlyTriangles = std::exchange(BaseMesh::depthOnlyTriangles, {});
+
     device->Clear();
     if (volumetricLighting->IsActive())
     {
@@ -165,9 +197,7 @@ void RendererModule::DrawLines()
         return;
     }
 
-    const Matrix vpMatrix = WindowsEngine::GetCamera()->GetViewProjectionMatrix();
-
-    debugLinesMVPBuffer.UpdateData(vpMatrix);
+    debugLinesMVPBuffer.UpdateData(GetFrameView().camera.viewProjection);
     debugLineShader->SetConstantBuffer("TransformMatrixes", debugLinesMVPBuffer.GetBuffer());
 
     // Add lines data to buffers
@@ -190,23 +220,37 @@ void RendererModule::DrawMeshes(std::function<bool(BaseMesh*)> filter) const
     static auto& engine = WindowsEngine::GetInstance();
     static auto& mm = engine.GetModule<MeshManager>();
 
-    const auto& buff = engine.GetCamera()->GetTransformMatrixesBuffer();
-
-    for (BaseMesh* mesh : mm.GetAllAssets() | std::views::filter(filter))
+    mm.ForEachAsset([&](BaseMesh* mesh)
     {
-        mesh->Draw(&buff);
-    }
+        if (filter(mesh))
+            mesh->Draw(&viewProjectionBuffer);
+    });
 }
 
-void RendererModule::DrawMeshesGeometry() const
+void RendererModule::DrawMeshesGeometry(std::function<bool(BaseMesh*)> filter) const
 {
     static auto& engine = WindowsEngine::GetInstance();
     static auto& mm = engine.GetModule<MeshManager>();
 
-    for (BaseMesh* mesh : mm.GetAllAssets())
+    mm.ForEachAsset([&](BaseMesh* mesh)
     {
-        mesh->DrawGeometry();
-    }
+        if (filter(mesh))
+            mesh->DrawGeometry();
+    });
+}
+
+void RendererModule::BindGBuffer(EffectsShader& shader) const
+{
+    shader.BindShaderResourceView("GBufferNormal", device->GetGBufferTexture(GBufferTarget::NORMAL)->GetShaderResourceView());
+    shader.BindShaderResourceView("GBufferAlbedo", device->GetGBufferTexture(GBufferTarget::ALBEDO)->GetShaderResourceView());
+    shader.BindShaderResourceView("GBufferMaterial", device->GetGBufferTexture(GBufferTarget::MATERIAL)->GetShaderResourceView());
+    shader.BindShaderResourceView("GBufferEmission", device->GetGBufferTexture(GBufferTarget::EMISSION)->GetShaderResourceView());
+}
+
+void RendererModule::UnbindGBuffer(EffectsShader& shader) const
+{
+    for (const char* name : {"GBufferNormal", "GBufferAlbedo", "GBufferMaterial", "GBufferEmission"})
+        shader.UnbindResource(name);
 }
 
 void RendererModule::DrawLighting(Scene* scene)
@@ -216,10 +260,11 @@ void RendererModule::DrawLighting(Scene* scene)
     {
         gBufferIndexBuffer.UpdateData(currentBufferToShow);
         imGuiEffectsShader->SetConstantBuffer("IndexGBuffer", gBufferIndexBuffer.GetBuffer());
-        imGuiEffectsShader->BindTexture("GBuffer", device->GetGBufferTexture2DArray());
+        BindGBuffer(*imGuiEffectsShader);
         imGuiEffectsShader->Bind();
 
         device->GetImmediateContext()->Draw(6, 0);
+        UnbindGBuffer(*imGuiEffectsShader);
         return;
     }
 #endif
@@ -228,8 +273,6 @@ void RendererModule::DrawLighting(Scene* scene)
     const auto& ptLights = scene->GetPointLightsBuffer();
     const auto& psBuff = scene->GetSceneInfoBuffer();
     lightingPassShader->SetConstantBuffer("SceneInfo", psBuff.GetBuffer());
-    lightingPassShader->SetConstantBuffer("SpotLights", spotLights.GetBuffer());
-    lightingPassShader->SetConstantBuffer("PointLights", ptLights.GetBuffer());
     lightingPassShader->SetConstantBuffer("DirectionalLights", dirLights.GetBuffer());
     lightingPassShader->SetConstantBuffer("DirectionalLightShadows", dirshadowMap->GetViewProjBuffer(scene->GetDirectionalLights()).GetBuffer());
 
@@ -237,7 +280,9 @@ void RendererModule::DrawLighting(Scene* scene)
     postProcessBuffer.UpdateData(postProcessBufferData);
     lightingPassShader->SetConstantBuffer("PostProcess", postProcessBuffer.GetBuffer());
 
-    lightingPassShader->BindTexture("GBuffer", device->GetGBufferTexture2DArray());
+    lightingPassShader->BindShaderResourceView("SpotLights", spotLights.srv);
+    lightingPassShader->BindShaderResourceView("PointLights", ptLights.srv);
+    BindGBuffer(*lightingPassShader);
     lightingPassShader->BindShaderResourceView("DepthTexture", device->GetDepthShaderResourceView());
     lightingPassShader->BindShaderResourceView("SSAOTexture", ssaoEffect->GetSSAOSRV());
     lightingPassShader->BindTexture("DirectionalShadowMap", dirshadowMap->GetDepthTexture());
@@ -254,7 +299,9 @@ void RendererModule::DrawLighting(Scene* scene)
     lightingPassShader->UnbindResource("DirectionalShadowMap");
     lightingPassShader->UnbindResource("DepthTexture");
     lightingPassShader->UnbindResource("SSAOTexture");
-    lightingPassShader->UnbindResource("GBuffer");
+    UnbindGBuffer(*lightingPassShader);
+    lightingPassShader->UnbindResource("SpotLights");
+    lightingPassShader->UnbindResource("PointLights");
     if (volumetricLighting->IsActive())
     {
         lightingPassShader->UnbindResource("VolumetricAccumulationBuffer");
@@ -291,6 +338,8 @@ void RendererModule::EndRenderScene()
 RendererModule::RendererModule()
     : postProcessBuffer{D3D11Buffer::CreateConstantBuffer<PostProcessBufferData>()}
     , fxaaBuffer{D3D11Buffer::CreateConstantBuffer<FXAABufferData>()}
+    , frameViews{FrameView{WindowsEngine::GetModule<FrameArena>()}, FrameView{WindowsEngine::GetModule<FrameArena>()}}
+    , viewProjectionBuffer{D3D11Buffer::CreateConstantBuffer<Matrix>()}
 #ifdef _DEBUG
     , debugLinesVertexBuffer{D3D11_BIND_VERTEX_BUFFER}
 #ifdef _IMGUI_
@@ -313,6 +362,81 @@ RendererModule::~RendererModule()
 #endif
 }
 
+const FrameView& RendererModule::ExtractFrameView(const Scene& scene, const Camera& camera, const Camera& cullingCamera)
+{
+    FrameView& view = frameViews[++frameIndex % frameViews.size()];
+    view.Clear();
+    view.frameIndex = frameIndex;
+    view.camera = FrameView::CameraView::FromCamera(camera);
+    view.cullingCamera = FrameView::CameraView::FromCamera(cullingCamera);
+    view.cullingFrustum = cullingCamera.IsPerspectiveCamera() ? GetFrustumFromCamera(&cullingCamera) : DirectX::BoundingFrustum{};
+
+    view.cascadeFrustums = dirshadowMap->GetCascadeFrustums();
+    const auto& lights = scene.GetDirectionalLights();
+    view.directionalLights.assign(lights.begin(), lights.end());
+
+    view.occlusionEnabled = occlusionCulling->enabled;
+    if (view.occlusionEnabled)
+    {
+        for (Entity* entity : scene.GetEntities())
+            entity->GatherOccluders(view);
+    }
+    return view;
+}
+
+void RendererModule::PrepareFrame(const FrameView& view) const
+{
+    // Only the camera view tests against the occluders, the shadow views draw what the camera can't see
+    occlusionCulling->Render(view);
+    dirshadowMap->PrepareCascades(view);
+}
+
+void RendererModule::UsePreparedFrame(const uint64_t preparedFrame) const
+{
+    occlusionCulling->UseFrame(preparedFrame);
+    dirshadowMap->UseFrame(preparedFrame);
+}
+
+void RendererModule::ReloadShaders()
+{
+    static WindowsEngine& engine = WindowsEngine::GetInstance();
+    static MeshManager& mm = engine.GetModule<MeshManager>();
+
+#ifdef _IMGUI_
+    imGuiEffectsShader->ReloadShader();
+#endif
+
+    const std::vector<BaseMesh*> meshes = mm.GetAllAssets();
+    for (auto* mesh : meshes)
+    {
+        mesh->ReloadShader();
+    }
+    engine.GetScene()->ReloadShaders();
+    lightingPassShader->ReloadShader();
+
+#ifdef _IMGUI_
+    if (activateFXAA)
+        finalFXAAPassShader.reset(new EffectsShader(L"SnailEngine/Shaders/FXAAPass.fx", DEFAULT_ELEMENT_LAYOUT, DEFAULT_ELEMENT_COUNT));
+    else
+        finalFXAAPassShader.reset(new EffectsShader(L"SnailEngine/Shaders/ConvertPass.fx", DEFAULT_ELEMENT_LAYOUT, DEFAULT_ELEMENT_COUNT));
+#else
+    finalFXAAPassShader.reset(new EffectsShader(L"SnailEngine/Shaders/FXAAPass.fx", DEFAULT_ELEMENT_LAYOUT, DEFAULT_ELEMENT_COUNT));
+#endif
+
+    vignetteEffect->ReloadShader();
+    ssaoEffect->ReloadShader();
+    blurEffect->ReloadShader();
+    chromaticAberrationEffect->ReloadShader();
+    volumetricLighting->ReloadShaders();
+}
+
+void RendererModule::FlushRenderPrep()
+{
+    if (renderPrepThread)
+        renderPrepThread->Wait();
+    canUsePreviousPrep = false;
+}
+
 void RendererModule::Render(Scene* scene)
 {
     static WindowsEngine& engine = WindowsEngine::GetInstance();
@@ -324,16 +448,37 @@ void RendererModule::Render(Scene* scene)
         return;
     }
 
-    DirectX::BoundingFrustum frustum;
-    if (frustumCamera->IsPerspectiveCamera())
-        frustum = GetFrustumFromCamera(frustumCamera);
+    BeginRenderScene();
 
-    SceneDrawContext ctx{&engine.GetModule<RendererModule>(), engine.GetRenderDevice(), frustum};
+    // After the screen shake moved the camera
+    const FrameView& view = ExtractFrameView(*scene, *WindowsEngine::GetCamera(), *frustumCamera);
+    viewProjectionBuffer.UpdateData(view.camera.viewProjection.Transpose());
 
-    BeginRenderScene();
+    // The previous view was prepared while this frame was simulated, it is drawn with that preparation
+    std::optional<uint64_t> preparedFrame;
+    if (pipelineRenderPrep && canUsePreviousPrep)
+    {
+        preparedFrame = renderPrepThread->Wait();
+        UsePreparedFrame(*preparedFrame);
+    }
+    renderPrepThread->Submit(view);
+    canUsePreviousPrep = true;
+
+    {
+        // The debug UI is free to allocate, it is kept out of the steady state check
+        MemoryTagScope tag{MemoryTag::UI};
+        RenderImGui();
+        scene->RenderImGui();
+    }
+
+    // Otherwise the preparation only overlaps the debug UI
+    if (!preparedFrame)
+    {
+        preparedFrame = renderPrepThread->Wait();
+        UsePreparedFrame(*preparedFrame);
+    }
 
-    RenderImGui();
-    scene->RenderImGui();
+    SceneDrawContext ctx{this, engine.GetRenderDevice(), view, occlusionCulling.get()};
 
     dirshadowMap->Render(scene->GetDirectionalLights());
 
@@ -400,6 +545,13 @@ void RendererModule::Resize(const long width, const long height) const
 #ifdef _DEBUG
 void RendererModule::DrawLine(const DebugLine& startLine, const DebugLine& endLine)
 {
+    // Lines drawn during the parallel entity update are added at the sync point
+    if (SceneCommandBuffer* commands = SceneCommandBuffer::GetRecording())
+    {
+        commands->DrawLine(startLine, endLine);
+        return;
+    }
+
     debugLines.push_back(startLine);
     debugLines.push_back(endLine);
 }
@@ -502,16 +654,8 @@ void RendererModule::RenderImGui()
 
     ImGui::Checkbox("VSync", &device->VSyncEnabled);
 
-    static float elapsedTime = 0;
-    auto dt = engine.GetDeltaTime();
-    static auto FPS = 1 / dt;
-    if (elapsedTime > 0.5)
-    {
-        FPS = 1 / dt;
-        elapsedTime = 0;
-    }
-    ImGui::Text(("FPS: " + std::to_string(FPS)).c_str());
-    elapsedTime += dt;
+    engine.GetFramePacer().RenderImGui();
+    ImGui::Checkbox("Frame time overlay (F3)", &showFrameTimeUI);
 
     ImGui::Separator();
 
@@ -519,30 +663,11 @@ void RendererModule::RenderImGui()
 
     if (ImGui::Button("Recompile Shaders"))
     {
-        imGuiEffectsShader->ReloadShader();
-
-        const std::vector<BaseMesh*> meshes = mm.GetAllAssets();
-        for (auto* mesh : meshes)
-        {
-            mesh->ReloadShader();
-        }
-        engine.GetScene()->ReloadShaders();
-        lightingPassShader->ReloadShader();
-
-        if (activateFXAA)
-            finalFXAAPassShader.reset(new EffectsShader(L"SnailEngine/Shaders/FXAAPass.fx", DEFAULT_ELEMENT_LAYOUT, DEFAULT_ELEMENT_COUNT));
-        else
-            finalFXAAPassShader.reset(new EffectsShader(L"SnailEngine/Shaders/ConvertPass.fx", DEFAULT_ELEMENT_LAYOUT, DEFAULT_ELEMENT_COUNT));
-
-        vignetteEffect->ReloadShader();
-        ssaoEffect->ReloadShader();
-        blurEffect->ReloadShader();
-        chromaticAberrationEffect->ReloadShader();
-        volumetricLighting->ReloadShaders();
+        ReloadShaders();
     }
 
     ImGui::Text("Choose rendering pass to show: ");
-    static constexpr std::array possiblePasses = {"Default", "WorldPosition", "Normal", "Albedo", "Specular", "Emission", "Unlit"};
+    static constexpr std::array possiblePasses = {"Default", "Normal", "Albedo", "Specular", "Specular exponent", "Emission", "Flags"};
     static const char* currentItem = "Default";
 
     if (ImGui::BeginCombo("##render pass", currentItem))
@@ -564,9 +689,36 @@ void RendererModule::RenderImGui()
         ImGui::EndCombo();
     }
 
+    if (ImGui::TreeNode("G-buffer"))
+    {
+        int precision = static_cast<int>(device->GetGBufferPrecision());
+        if (ImGui::Combo("Precision", &precision, "Compact\0High\0"))
+            device->SetGBufferPrecision(static_cast<GBufferPrecision>(precision));
+
+        size_t totalBytes = 0;
+        for (int i = 0; i < GBufferPacking::TARGET_COUNT; ++i)
+        {
+            const auto target = static_cast<GBufferTarget>(i);
+            const size_t bytes = device->GetGBufferTargetByteSize(target);
+            totalBytes += bytes;
+            ImGui::Text("%s, %s: %.2f MB", GBufferPacking::GetTargetName(target),
+                GBufferPacking::GetFormatName(GBufferPacking::GetFormat(target, device->GetGBufferPrecision())), static_cast<double>(bytes) / (1024 * 1024));
+        }
+
+        const DirectX::XMINT2& resolution = device->GetResolutionSize();
+        const size_t legacyBytes = static_cast<size_t>(resolution.x) * static_cast<size_t>(resolution.y) * GBufferPacking::LEGACY_BYTES_PER_PIXEL;
+        ImGui::Text("Total: %.2f MB, %u bytes per pixel (unpacked layout: %.2f MB)", static_cast<double>(totalBytes) / (1024 * 1024),
+            GBufferPacking::GetBytesPerPixel(device->GetGBufferPrecision()), static_cast<double>(legacyBytes) / (1024 * 1024));
+        ImGui::TreePop();
+    }
+
     ImGui::Checkbox("Draw Entity Transforms", &drawEntityTransform);
     ImGui::Checkbox("Draw Bounding Boxes", &drawBoundingBoxes);
 
+    ImGui::Text("Shaded triangles: %zu (%zu without LODs)", lastFrameShadedTriangles.drawn, lastFrameShadedTriangles.atLod0);
+    ImGui::Text("Shadow triangles: %zu (%zu without LODs)", lastFrameDepthOnlyTriangles.drawn, lastFrameDepthOnlyTriangles.atLod0);
+    ImGui::SliderInt("Forced LOD", &MeshLodSelector::forcedLod, -1, MAX_MESH_LODS - 1);
+
     if (ImGui::Checkbox("FXAA Active", &activateFXAA))
     {
         if (activateFXAA)
@@ -592,7 +744,13 @@ void RendererModule::RenderImGui()
             lightingPassShader->RemoveDefine(SHADOWS_DEBUG_DEFINE);
     }
 
+    ImGui::SeparatorText("Render Preparation");
+    ImGui::Checkbox("Prepare while the next frame is simulated", &pipelineRenderPrep);
+    ImGui::Text("Overlaps the preparation with the simulation, but occlusion and shadow cascades\nlag a frame behind the camera: objects it reveals can pop in for a frame");
+    ImGui::Text("Prepared in %.3f ms", renderPrepThread->GetLastPrepareMs());
+
     volumetricLighting->RenderImGui();
+    occlusionCulling->RenderImGui();
 
     ImGui::Separator();
 
@@ -629,6 +787,38 @@ void RendererModule::RenderImGui()
     ImGui::Separator();
 
     tm.RenderImGui();
+
+    ImGui::Separator();
+
+    static TextureStreamer& streamer = engine.GetModule<TextureStreamer>();
+    streamer.RenderImGui();
+
+    ImGui::Separator();
+
+    static AssetHotReload& hotReload = engine.GetModule<AssetHotReload>();
+    hotReload.RenderImGui();
+
+    ImGui::Separator();
+
+    static TransformHierarchy& hierarchy = engine.GetModule<TransformHierarchy>();
+    hierarchy.RenderImGui();
+
+    ImGui::Separator();
+
+    static PhysicsModule& physicsModule = engine.GetModule<PhysicsModule>();
+    physicsModule.RenderImGui();
+
+    InputModule::GetInstance().Controller.RenderImGui();
+
+    ImGui::Separator();
+
+    static FrameArena& frameArena = engine.GetModule<FrameArena>();
+    frameArena.RenderImGui();
+    MemoryTracker::RenderImGui();
+
+    ImGui::Separator();
+
+    StartupGraph::RenderImGui(engine.GetStartupResults());
 #endif
 }
 
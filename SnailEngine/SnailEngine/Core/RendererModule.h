@@ -1,6 +1,8 @@
 ﻿#pragma once
 #include <memory>
 
+#include "Core/Mesh/Mesh.h"
+#include "Rendering/FrameView.h"
 #include "Rendering/Buffers/D3D11Buffer.h"
 #include "Rendering/Effects/ScreenShakeEffect.h"
 #include "Util/Util.h"
@@ -17,6 +19,9 @@ class Scene;
 class SSAOEffect;
 class BaseMesh;
 class BlurEffect;
+class OcclusionCulling;
+class RenderPrepThread;
+class FrameTimeUI;
 
 class RendererModule
 {
@@ -65,6 +70,17 @@ private:
     std::unique_ptr<EffectsShader> finalFXAAPassShader;
 
     std::unique_ptr<VolumetricLighting> volumetricLighting;
+    std::unique_ptr<OcclusionCulling> occlusionCulling;
+
+    // The view being drawn and the one being prepared
+    std::array<FrameView, 2> frameViews;
+    uint64_t frameIndex = 0;
+    // Whether the view submitted last frame may be drawn with, false after a flush
+    bool canUsePreviousPrep = false;
+    // View projection of the drawn camera, for the passes that draw every mesh
+    D3D11Buffer viewProjectionBuffer;
+    // After the modules it prepares, so that it stops before they are destroyed
+    std::unique_ptr<RenderPrepThread> renderPrepThread;
 
 #ifdef _DEBUG
     D3D11Buffer debugLinesVertexBuffer;
@@ -74,6 +90,10 @@ private:
     std::vector<DebugLine> debugLines;
     std::unique_ptr<EffectsShader> debugLineShader;
 
+    // Created the first time it is shown, the default font is loaded by then
+    std::unique_ptr<FrameTimeUI> frameTimeUI;
+    bool showFrameTimeUI = false;
+
 public:
     std::unique_ptr<VignetteEffect> vignetteEffect;
     std::unique_ptr<SSAOEffect> ssaoEffect;
@@ -90,8 +110,16 @@ private:
 #endif
 
     void BeginRenderScene();
+    // Copies what the frame is drawn with out of the scene and the cameras
+    const FrameView& ExtractFrameView(const Scene& scene, const Camera& camera, const Camera& cullingCamera);
+    // Runs on the render preparation thread
+    void PrepareFrame(const FrameView& view) const;
+    void UsePreparedFrame(uint64_t preparedFrame) const;
     void RenderImGui();
     void DrawLighting(Scene* scene);
+    // Each target under its name in GBufferPacking.hlsli
+    void BindGBuffer(EffectsShader& shader) const;
+    void UnbindGBuffer(EffectsShader& shader) const;
     void DrawPostEffects() const;
     void DrawLines();
     void DrawMeshes(std::function<bool(BaseMesh*)> filter = [](BaseMesh*) { return true; }) const;
@@ -99,7 +127,7 @@ private:
     void EndRenderScene();
 
 public:
-    void DrawMeshesGeometry() const;
+    void DrawMeshesGeometry(std::function<bool(BaseMesh*)> filter = [](BaseMesh*) { return true; }) const;
     RendererModule();
     ~RendererModule();
     void Init();
@@ -114,9 +142,24 @@ public:
     void DrawBoundingBox(const DirectX::BoundingOrientedBox& boundingBox, const Color& boundingColor);
     void DrawBoundingBox(const std::array<Vector3, 8>& boundingBox, const Color& boundingColor);
 
+    // The view of the frame being drawn
+    const FrameView& GetFrameView() const noexcept { return frameViews[frameIndex % frameViews.size()]; }
+    // Waits for the render preparation, must be called before destroying what the last view refers to
+    void FlushRenderPrep();
+    // Recompiles every shader from its file, the meshes keep their defines
+    void ReloadShaders();
+
     DirectionalShadowMap* GetDirectionalShadowMap() const noexcept { return dirshadowMap.get(); }
     VolumetricLighting* GetVolumetricLighting() const noexcept { return volumetricLighting.get(); }
 
+    // Prepares the next frame's view while the current one is drawn. The preparation is then a frame behind: objects
+    // revealed by the camera are culled with the previous occlusion buffer and the cascades fit the previous frustum,
+    // so they pop in for a frame. Off by default, it trades that for the preparation overlapping the simulation.
+    bool pipelineRenderPrep = false;
+
+    // Triangles of the previous frame, the meshes count them while drawing
+    BaseMesh::TriangleCounts lastFrameShadedTriangles;
+    BaseMesh::TriangleCounts lastFrameDepthOnlyTriangles;
 #ifdef _IMGUI_
     std::unique_ptr<EffectsShader> imGuiEffectsShader;
     D3D11Buffer gBufferIndexBuffer;
@@ -5,15 +5,20 @@
 #include <memory>
 #include <random>
 
+#include "LevelArchive.h"
 #include "SceneParser.h"
 #include "ThreadPool.h"
+#include "EntityUpdate.h"
+#include "Core/Memory/MemoryTracker.h"
 #include "Core/WindowsEngine.h"
 #include "Core/Math/Transform.h"
+#include "Core/Math/TransformHierarchy.h"
 #include "Core/Camera/CameraManager.h"
 #include "Rendering/UI/Button.h"
 #include "Entities/Entity.h"
 #include "Entities/Decal.h"
 #include "Entities/CubeSkybox.h"
+#include "Rendering/Occlusion/OcclusionCulling.h"
 
 using namespace physx;
 
@@ -21,8 +26,8 @@ namespace Snail
 {
 Scene::Scene(const std::string& scenePath)
     : directionalLightsBuffer{D3D11Buffer::CreateConstantBuffer<DirectionalLight[SceneData::MAX_DIR_LIGHTS]>()}
-    , spotLightsBuffer{D3D11Buffer::CreateConstantBuffer<SpotLight[SceneData::MAX_SPOT_LIGHTS]>()}
-    , pointLightsBuffer{D3D11Buffer::CreateConstantBuffer<PointLight[SceneData::MAX_PT_LIGHTS]>()}
+    , spotLightsBuffer{WindowsEngine::GetInstance().GetRenderDevice()->GetD3DDevice(), LightManager::MAX_GPU_SPOT_LIGHTS, data.lights.GetGpuSpotLights().data()}
+    , pointLightsBuffer{WindowsEngine::GetInstance().GetRenderDevice()->GetD3DDevice(), LightManager::MAX_GPU_POINT_LIGHTS, data.lights.GetGpuPointLights().data()}
     , sceneInfoBuffer{D3D11Buffer::CreateConstantBuffer<SceneBufferData>()}
 {
     StartLoadFromFile(scenePath);
@@ -40,6 +45,12 @@ void Scene::SetVolumetricFactor(float val)
 
 void Scene::RemoveEntity(Entity* entityToRemove)
 {
+    if (SceneCommandBuffer* commands = SceneCommandBuffer::GetRecording())
+    {
+        commands->RemoveEntity(entityToRemove);
+        return;
+    }
+
     data.objectsToRemove.insert(entityToRemove);
 }
 
@@ -48,6 +59,10 @@ void Scene::CleanupRemoveEntity()
     if (data.objectsToRemove.empty())
         return;
 
+    // The view being prepared can point at the occluders of the removed entities
+    static auto& renderer = WindowsEngine::GetModule<RendererModule>();
+    renderer.FlushRenderPrep();
+
     for (auto entityToRemove : data.objectsToRemove)
     {
         const auto it = std::ranges::find_if(data.objects,
@@ -61,31 +76,93 @@ void Scene::CleanupRemoveEntity()
     data.objectsToRemove.clear();
 }
 
+void Scene::UpdateLoadTimings()
+{
+    static TextureStreamer& streamer = WindowsEngine::GetModule<TextureStreamer>();
+
+    if (texturesStreamedSeconds)
+        return;
+
+    const float elapsedSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - loadStartTime).count();
+    if (!firstFrameSeconds)
+    {
+        firstFrameSeconds = elapsedSeconds;
+        LOGF("First interactive frame {:.2f} s after the scene started loading", elapsedSeconds);
+    }
+    else if (streamer.IsIdle())
+    {
+        texturesStreamedSeconds = elapsedSeconds;
+        LOGF("Textures fully streamed {:.2f} s after the scene started loading", elapsedSeconds);
+    }
+}
+
 void Scene::Update(const float dt)
 {
+    UpdateLoadTimings();
+
     for (const std::unique_ptr<UIElement>& elem : sceneUiElements)
         elem->Update(dt);
 
+    static ThreadPool& jobPool = WindowsEngine::GetModule<ThreadPool>();
+    static RendererModule& renderer = WindowsEngine::GetModule<RendererModule>();
+
+    parallelUpdateEntities.clear();
+    serialUpdateEntities.clear();
     for (const std::unique_ptr<Entity>& entity : data.objects)
+        (entity->CanUpdateInParallel() ? parallelUpdateEntities : serialUpdateEntities).push_back(entity.get());
+
+    // Independent entities first, their writes to shared state are applied in order at the sync point
+    UpdateEntitiesInParallel(parallelUpdateEntities, dt, jobPool, std::thread::hardware_concurrency(), entityCommandBuffers);
+
+    lastEntityCommandCount = 0;
+    for (const SceneCommandBuffer& commands : entityCommandBuffers)
+    {
+        commands.Execute(*this, renderer);
+        lastEntityCommandCount += commands.GetCommandCount();
+    }
+
+    for (Entity* entity : serialUpdateEntities)
         entity->Update(dt);
 
     for (const std::unique_ptr<GrassGenerator>& grassGenerator : data.grassPatches)
         grassGenerator->Update(dt);
 
+    static TransformHierarchy& hierarchy = WindowsEngine::GetModule<TransformHierarchy>();
+    hierarchy.UpdateWorldMatrices(&jobPool);
+
+    // Ranks the lights once they all moved, from the camera of this frame
+    static CameraManager& cameraManager = WindowsEngine::GetModule<CameraManager>();
+    if (const Camera* camera = cameraManager.GetCurrentCamera())
+    {
+        const FrameView::CameraView cameraView = FrameView::CameraView::FromCamera(*camera);
+        LightView lightView{cameraView.position, cameraView.projection._22, {}};
+        // Captured by reference, a frustum doesn't fit in the function and would be copied to the heap every frame
+        const DirectX::BoundingFrustum frustum = cameraView.isPerspective ? GetFrustumFromCamera(camera) : DirectX::BoundingFrustum{};
+        if (cameraView.isPerspective)
+        {
+            lightView.isVisible = [&frustum](const Vector3& center, const float radius)
+            {
+                return frustum.Contains(DirectX::BoundingSphere{center, radius}) != DirectX::DISJOINT;
+            };
+        }
+        data.lights.Update(lightView, dt);
+    }
+
     if (WindowsEngine::GetInstance().isMainMenuLoaded)
         mainMenuUI->Update(dt);
 }
 
 const D3D11Buffer& Scene::GetSceneInfoBuffer()
 {
-    const Camera* camera = WindowsEngine::GetInstance().GetCamera();
-    sceneInfo.invViewProj = camera->GetViewProjectionMatrix().Invert().Transpose();
-    sceneInfo.invView = camera->GetViewMatrix().Invert().Transpose();
-    sceneInfo.view = camera->GetViewMatrix().Transpose();
-    sceneInfo.cameraPosition = camera->GetWorldTransform().position;
+    static auto& renderer = WindowsEngine::GetModule<RendererModule>();
+    const FrameView::CameraView& camera = renderer.GetFrameView().camera;
+    sceneInfo.invViewProj = camera.invViewProjection.Transpose();
+    sceneInfo.invView = camera.invView.Transpose();
+    sceneInfo.view = camera.view.Transpose();
+    sceneInfo.cameraPosition = camera.position;
     sceneInfo.nbDirectional = static_cast<int>(data.directionalLights.size());
-    sceneInfo.nbSpotLight = static_cast<int>(data.spotLights.size());
-    sceneInfo.nbPointLight = static_cast<int>(data.pointLights.size());
+    sceneInfo.nbSpotLight = data.lights.GetSlotCount(LightType::SPOT);
+    sceneInfo.nbPointLight = data.lights.GetSlotCount(LightType::POINT);
 
     sceneInfoBuffer.UpdateData(&sceneInfo, sizeof(sceneInfo));
 
@@ -115,11 +192,16 @@ void Scene::StartLoadFromFile(const std::string& filename)
 #endif
 
     isLoading = true;
+    loadStartTime = std::chrono::steady_clock::now();
+    firstFrameSeconds.reset();
+    texturesStreamedSeconds.reset();
+
     static auto& gameManager = WindowsEngine::GetModule<GameManager>();
     gameManager.Cleanup();
 
     loadingThread = std::thread([=]
     {
+        MemoryTagScope tag{MemoryTag::ASSETS};
         try
         {
             if (auto parsed = SceneParser::Parse(filename, shouldStopLoading); parsed.has_value())
@@ -128,10 +210,19 @@ void Scene::StartLoadFromFile(const std::string& filename)
                 LOGF("Done loading scene:\n" "\tDirectional light count: {}\n" "\tPoint light count: {}\n" "\tSpot light count: {}\n"
                     "\tObject count: {}",
                     data.directionalLights.size(),
-                    data.pointLights.size(),
-                    data.spotLights.size(),
+                    data.lights.GetCount(LightType::POINT),
+                    data.lights.GetCount(LightType::SPOT),
                     data.objects.size());
 
+                // The new scene now holds its own references to the prefetched assets
+                ReleaseAssets(AssetReferenceSet::PREFETCH);
+
+                static const auto& tm = WindowsEngine::GetModule<TextureManager>();
+                static const auto& mm = WindowsEngine::GetModule<MeshManager>();
+                LOGF("Asset residency:\n" "\tTextures: {} hits, {} misses, {} evictions\n" "\tMeshes: {} hits, {} misses, {} evictions",
+                    tm.GetResidencyStats().hits, tm.GetResidencyStats().misses, tm.GetResidencyStats().evictions,
+                    mm.GetResidencyStats().hits, mm.GetResidencyStats().misses, mm.GetResidencyStats().evictions);
+
                 gameManager.Start();
             }
             else { LOG(Logger::WARN, "Scene parsing interrupted"); }
@@ -185,6 +276,8 @@ void Scene::StartLoadFromFile(const std::string& filename)
 void Scene::DoneLoading()
 {
     static auto& engine = WindowsEngine::GetInstance();
+    static const auto& mm = WindowsEngine::GetModule<MeshManager>();
+    mm.LogVertexMemory();
     engine.ResetClock();
     isLoading = false;
 }
@@ -199,39 +292,37 @@ bool Scene::IsLoading()
     return isLoading;
 }
 
-std::vector<Entity*> Scene::GetEntities() const
+const D3D11Buffer& Scene::GetDirectionalLightsBuffer()
 {
-    auto retVal = data.objects | std::views::transform([](auto& ptr) { return ptr.get(); });
-    return {retVal.begin(), retVal.end()};
+    directionalLightsBuffer.UpdateData(data.directionalLights);
+    return directionalLightsBuffer;
 }
 
-std::vector<GrassGenerator*> Scene::GetGrassPatches() const
+namespace
 {
-    auto retVal = data.grassPatches | std::views::transform([](auto& ptr) { return ptr.get(); });
-    return {retVal.begin(), retVal.end()};
-}
 
-std::vector<Decal*> Scene::GetDecals() const
+template <class T>
+void UploadDirtyRange(const StructuredBuffer& buffer, const std::span<const T> lights, const LightManager::DirtyRange range)
 {
-    auto retVal = data.decals | std::views::transform([](auto& ptr) { return ptr.get(); });
-    return {retVal.begin(), retVal.end()};
+    if (range.count == 0)
+        return;
+
+    static ID3D11DeviceContext* context = WindowsEngine::GetInstance().GetRenderDevice()->GetImmediateContext();
+    const D3D11_BOX box{static_cast<UINT>(range.first * sizeof(T)), 0, 0, static_cast<UINT>((range.first + range.count) * sizeof(T)), 1, 1};
+    context->UpdateSubresource(buffer.internalBuffer, 0, &box, lights.data() + range.first, 0, 0);
 }
 
-const D3D11Buffer& Scene::GetDirectionalLightsBuffer()
-{
-    directionalLightsBuffer.UpdateData(data.directionalLights);
-    return directionalLightsBuffer;
 }
 
-const D3D11Buffer& Scene::GetPointLightsBuffer()
+const StructuredBuffer& Scene::GetPointLightsBuffer()
 {
-    pointLightsBuffer.UpdateData(data.pointLights);
+    UploadDirtyRange(pointLightsBuffer, data.lights.GetGpuPointLights(), data.lights.TakeDirtyRange(LightType::POINT));
     return pointLightsBuffer;
 }
 
-const D3D11Buffer& Scene::GetSpotLightsBuffer()
+const StructuredBuffer& Scene::GetSpotLightsBuffer()
 {
-    spotLightsBuffer.UpdateData(data.spotLights);
+    UploadDirtyRange(spotLightsBuffer, data.lights.GetGpuSpotLights(), data.lights.TakeDirtyRange(LightType::SPOT));
     return spotLightsBuffer;
 }
 
@@ -307,6 +398,23 @@ void Scene::RenderImGui()
         LoadScene(currentlySelectedScenePath.string());
     }
 
+    if (!currentlySelectedScenePath.string().empty() && ImGui::Button(("Prefetch Scene: " + currentlySelectedScenePath.filename().string()).c_str()))
+    {
+        PrefetchScene(currentlySelectedScenePath.string());
+    }
+
+    LevelArchive::RenderImGui();
+
+    if (firstFrameSeconds)
+        ImGui::Text("First interactive frame after %.2f s", *firstFrameSeconds);
+    if (texturesStreamedSeconds)
+        ImGui::Text("Textures fully streamed after %.2f s", *texturesStreamedSeconds);
+
+    if (ImGui::CollapsingHeader("Entity Update"))
+    {
+        ImGui::Text("Parallel: %zu, serial: %zu, deferred commands: %zu", parallelUpdateEntities.size(), serialUpdateEntities.size(), lastEntityCommandCount);
+    }
+
     ImGui::SeparatorText(("Scene Entities: " + std::to_string(data.objects.size())).c_str());
 
     constexpr int MAX_JSON_SIZE = 1024;
@@ -333,7 +441,7 @@ void Scene::RenderImGui()
         data.skybox->RenderImGui(0);
     }
 
-    const std::vector<Entity*> entities = GetEntities();
+    const auto entities = GetEntities();
     for (int i = 0; i < static_cast<int>(data.objects.size()); ++i)
     {
         if (Entity* entity = entities[i]; ImGui::CollapsingHeader((std::to_string(i + 1) + ": " + entity->entityName).c_str(), ImGuiTreeNodeFlags_Framed))
@@ -344,7 +452,7 @@ void Scene::RenderImGui()
 
     ImGui::SeparatorText(("Scene Decals: " + std::to_string(data.decals.size())).c_str());
 
-    const std::vector<Decal*> decals = GetDecals();
+    const auto decals = GetDecals();
     for (int i = 0; i < static_cast<int>(data.decals.size()); ++i)
     {
         if (Decal* decal = decals[i]; ImGui::CollapsingHeader((std::to_string(i) + ": " + decal->entityName).c_str(), ImGuiTreeNodeFlags_Framed))
@@ -369,21 +477,28 @@ void Scene::RenderImGui()
         }
     }
 
-    for (int i = 0; i < static_cast<int>(data.spotLights.size()); ++i)
+    if (ImGui::CollapsingHeader("Light Budget", ImGuiTreeNodeFlags_Framed))
+        data.lights.RenderImGui();
+
+    const std::vector<LightHandle> spotLights = data.lights.GetHandles(LightType::SPOT);
+    for (int i = 0; i < static_cast<int>(spotLights.size()); ++i)
     {
-        if (SpotLight& spotLight = data.spotLights[i]; ImGui::CollapsingHeader((std::to_string(i) + ": Spot Light").c_str(),
-            ImGuiTreeNodeFlags_Framed))
+        if (ImGui::CollapsingHeader((std::to_string(i) + ": Spot Light").c_str(), ImGuiTreeNodeFlags_Framed))
         {
+            SpotLight spotLight = data.lights.GetSpotLight(spotLights[i]);
             spotLight.RenderImGui(i);
+            data.lights.SetSpotLight(spotLights[i], spotLight);
         }
     }
 
-    for (int i = 0; i < static_cast<int>(data.pointLights.size()); ++i)
+    const std::vector<LightHandle> pointLights = data.lights.GetHandles(LightType::POINT);
+    for (int i = 0; i < static_cast<int>(pointLights.size()); ++i)
     {
-        if (PointLight& pointLight = data.pointLights[i]; ImGui::CollapsingHeader((std::to_string(i) + ": Point Light").c_str(),
-            ImGuiTreeNodeFlags_Framed))
+        if (ImGui::CollapsingHeader((std::to_string(i) + ": Point Light").c_str(), ImGuiTreeNodeFlags_Framed))
         {
+            PointLight pointLight = data.lights.GetPointLight(pointLights[i]);
             pointLight.RenderImGui(i);
+            data.lights.SetPointLight(pointLights[i], pointLight);
         }
     }
 
@@ -414,8 +529,7 @@ void Scene::Cleanup()
 {
     LOG("Cleaning up scene...");
 
-    static TextureManager& tm = WindowsEngine::GetModule<TextureManager>();
-    static MeshManager& mm = WindowsEngine::GetModule<MeshManager>();
+    WindowsEngine::GetModule<RendererModule>().FlushRenderPrep();
 
     shouldStopLoading = true;
     if (loadingThread.joinable())
@@ -426,13 +540,46 @@ void Scene::Cleanup()
 
     WindowsEngine::GetModule<CameraManager>().Cleanup();
 
-    // TODO: refactor this into assetManager.Cleanup();
-    mm.SoftCleanup();
-    tm.SoftCleanup();
+    // Assets stay cached for the next scene, only what doesn't fit in the budget is evicted
+    ReleaseAssets(AssetReferenceSet::SCENE);
 
     LOG("Scene cleaned up");
 }
 
+void Scene::PrefetchScene(const std::string& filename)
+{
+    static TextureManager& tm = WindowsEngine::GetModule<TextureManager>();
+    static MeshManager& mm = WindowsEngine::GetModule<MeshManager>();
+
+    if (isLoading)
+    {
+        LOGF(Logger::WARN, "Tried to prefetch scene \"{}\" while loading another", filename);
+        return;
+    }
+
+    LOGF("Prefetching scene \"{}\"", filename);
+    mm.SetActiveReferenceSet(AssetReferenceSet::PREFETCH);
+    tm.SetActiveReferenceSet(AssetReferenceSet::PREFETCH);
+
+    SceneParser::PrefetchAssets(filename);
+
+    mm.SetActiveReferenceSet(AssetReferenceSet::SCENE);
+    tm.SetActiveReferenceSet(AssetReferenceSet::SCENE);
+}
+
+void Scene::ReleaseAssets(const AssetReferenceSet set)
+{
+    static TextureManager& tm = WindowsEngine::GetModule<TextureManager>();
+    static MeshManager& mm = WindowsEngine::GetModule<MeshManager>();
+
+    mm.ReleaseReferenceSet(set);
+    tm.ReleaseReferenceSet(set);
+
+    // Meshes first, evicted meshes no longer pin their textures
+    mm.Trim();
+    tm.Trim();
+}
+
 void Scene::Reset()
 {
     LoadScene(data.sourceFilename);
@@ -446,14 +593,21 @@ void Scene::ReloadShaders() const
     }
 }
 
-SceneDrawContext::SceneDrawContext(RendererModule* renderer, D3D11Device* device, const DirectX::BoundingFrustum& cam)
+SceneDrawContext::SceneDrawContext(RendererModule* renderer, D3D11Device* device, const FrameView& view, OcclusionCulling* occlusionCulling)
     : DrawContext{ renderer, device }
-    , cameraFrustum{cam}
+    , cameraFrustum{view.cullingFrustum}
+    , occlusion{occlusionCulling}
+    , viewPosition{view.cullingCamera.position}
+    , projectionScale{view.cullingCamera.projection._22 * static_cast<float>(device->GetResolutionSize().y) * 0.5f}
+    , projectionYScale{view.cullingCamera.projection._22}
+    , isPerspective{view.cullingCamera.isPerspective}
 {}
 
 bool SceneDrawContext::ShouldBeCulled(const DirectX::BoundingBox& bb)
 {
-    const bool cull = !cameraFrustum.Intersects(bb);
+    bool cull = !cameraFrustum.Intersects(bb);
+    if (!cull && occlusion)
+        cull = occlusion->IsOccluded(bb);
 #if _DEBUG
     if (renderer->drawBoundingBoxes)
         DrawBoundingBox(bb, cull);
@@ -476,4 +630,31 @@ bool SceneDrawContext::ShouldBeCulled(const DirectX::BoundingSphere& bs)
     return !cameraFrustum.Intersects(bs);
 }
 
+void SceneDrawContext::RequestTextureDetail(const BaseMesh& mesh, const DirectX::BoundingBox& worldBounds, const Matrix& world)
+{
+    if (mesh.uvDensity <= 0)
+        return;
+
+    float pixelsPerUnit = projectionScale;
+    if (isPerspective)
+    {
+        // The closest point of the bounds is where the textures are the most magnified
+        const float distance = Vector3::Distance(viewPosition, worldBounds.Center) - Vector3{worldBounds.Extents}.Length();
+        pixelsPerUnit /= std::max(distance, MIN_TEXTURE_DETAIL_DISTANCE);
+    }
+
+    const float worldScale = std::max({world.Right().Length(), world.Up().Length(), world.Backward().Length()});
+    mesh.RequestTextureResolution(pixelsPerUnit * worldScale / mesh.uvDensity);
+}
+
+float SceneDrawContext::GetScreenCoverage(const DirectX::BoundingSphere& bs)
+{
+    if (!isPerspective)
+        return bs.Radius * projectionYScale;
+
+    // Inside the sphere it covers the whole view
+    const float distance = std::max(Vector3::Distance(viewPosition, bs.Center), bs.Radius);
+    return bs.Radius * projectionYScale / distance;
+}
+
 }
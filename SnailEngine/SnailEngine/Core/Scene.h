@@ -1,10 +1,15 @@
 #pragma once
+#include <chrono>
+#include <ranges>
 #include <vector>
 
 #include "RendererModule.h"
+#include "EntityUpdate.h"
+#include "Assets/ModuleManager.h"
 #include "SceneParser.h"
 #include "Rendering/Lights/DirectionalLight.h"
 #include "Rendering/Buffers/D3D11Buffer.h"
+#include "Rendering/Buffers/StructuredBuffer.h"
 #include "Rendering/UI/LoadingScreen.h"
 #include "Rendering/DrawContext.h"
 
@@ -16,6 +21,8 @@ namespace Snail
 class Entity;
 class Sprite;
 class DrawContext;
+class Camera;
+class OcclusionCulling;
 
 class Scene
 {
@@ -26,8 +33,9 @@ class Scene
     std::thread loadingThread;
 
 	D3D11Buffer directionalLightsBuffer;
-	D3D11Buffer spotLightsBuffer;
-	D3D11Buffer pointLightsBuffer;
+	// Written slot by slot, only the dirty range of the light manager is uploaded
+	StructuredBuffer spotLightsBuffer;
+	StructuredBuffer pointLightsBuffer;
 	D3D11Buffer sceneInfoBuffer;
 
 	mutable struct DX_ALIGN SceneBufferData
@@ -46,9 +54,22 @@ class Scene
     bool isLoading = false;
     std::atomic<bool> shouldStopLoading = false;
 
+    // Seconds from the start of the load to the first updated frame, then to the end of texture streaming
+    std::chrono::steady_clock::time_point loadStartTime;
+    std::optional<float> firstFrameSeconds;
+    std::optional<float> texturesStreamedSeconds;
+
+    // Reused every frame by the entity update
+    std::vector<Entity*> parallelUpdateEntities;
+    std::vector<Entity*> serialUpdateEntities;
+    std::vector<SceneCommandBuffer> entityCommandBuffers;
+    size_t lastEntityCommandCount = 0;
+
     std::vector<std::unique_ptr<UIElement>> sceneUiElements;
     std::unique_ptr<MainMenu> mainMenuUI = std::make_unique<MainMenu>();
     void StartLoadFromFile(const std::string& filename);
+    static void ReleaseAssets(AssetReferenceSet set);
+    void UpdateLoadTimings();
 
 public:
     Scene(const std::string& scenePath = DEFAULT_SCENE_PATH);
@@ -62,19 +83,21 @@ public:
     void SetVolumetricFactor(float val);
 
 	const auto& GetDirectionalLights() const { return data.directionalLights; }
-    const auto& GetSpotLights() const { return data.spotLights; }
-	const auto& GetPointLights() const { return data.pointLights; }
+    LightManager& GetLights() { return data.lights; }
 
-    std::vector<Entity*> GetEntities() const;
-    std::vector<GrassGenerator*> GetGrassPatches() const;
-    std::vector<Decal*> GetDecals() const;
+    // Views over the scene's objects, they don't copy anything and are invalidated when objects are added or removed
+    auto GetEntities() const { return data.objects | std::views::transform([](const auto& ptr) { return ptr.get(); }); }
+    auto GetGrassPatches() const { return data.grassPatches | std::views::transform([](const auto& ptr) { return ptr.get(); }); }
+    auto GetDecals() const { return data.decals | std::views::transform([](const auto& ptr) { return ptr.get(); }); }
 
     const D3D11Buffer& GetDirectionalLightsBuffer();
-	const D3D11Buffer& GetSpotLightsBuffer();
-	const D3D11Buffer& GetPointLightsBuffer();
+	const StructuredBuffer& GetSpotLightsBuffer();
+	const StructuredBuffer& GetPointLightsBuffer();
 	const D3D11Buffer& GetSceneInfoBuffer();
 
     void LoadScene(const std::string& name);
+    // Loads the assets of a scene ahead of LoadScene, they are kept resident until that scene is done loading
+    void PrefetchScene(const std::string& filename);
     void DoneLoading();
     bool IsLoading();
 
@@ -93,14 +116,29 @@ public:
 
 class SceneDrawContext : public DrawContext
 {
+    // Meshes closer than this request the same resolution, so that entering a mesh doesn't ask for infinite detail
+    static constexpr float MIN_TEXTURE_DETAIL_DISTANCE = 0.5f;
+
     const DirectX::BoundingFrustum& cameraFrustum;
+    // Tested after the frustum, null when the view has no occlusion culling
+    OcclusionCulling* occlusion;
+    Vector3 viewPosition;
+    // Screen pixels covered by one world unit at a distance of one unit
+    float projectionScale;
+    // Half the view height covered by one world unit at a distance of one unit, the projection _22
+    float projectionYScale;
+    bool isPerspective;
 
 public:
-    SceneDrawContext(RendererModule* renderer, D3D11Device* device, const DirectX::BoundingFrustum& cam);
+    // Culls against the culling camera of the view
+    SceneDrawContext(RendererModule* renderer, D3D11Device* device, const FrameView& view, OcclusionCulling* occlusionCulling = nullptr);
 
     bool ShouldBeCulled(const DirectX::BoundingBox&) override;
     bool ShouldBeCulled(const DirectX::BoundingOrientedBox&) override;
     bool ShouldBeCulled(const DirectX::BoundingSphere&) override;
+
+    void RequestTextureDetail(const BaseMesh& mesh, const DirectX::BoundingBox& worldBounds, const Matrix& world) override;
+    float GetScreenCoverage(const DirectX::BoundingSphere& bs) override;
 };
 
 }
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "SceneParser.h"
 
+#include "LevelArchive.h"
 #include "ThreadPool.h"
 #include "WindowsEngine.h"
 #include "Entities/Billboard.h"
@@ -30,8 +31,7 @@ namespace Snail
 void SceneData::Clear()
 {
     directionalLights.clear();
-    spotLights.clear();
-    pointLights.clear();
+    lights.Clear();
     objects.clear();
     grassPatches.clear();
     decals.clear();
@@ -39,37 +39,49 @@ void SceneData::Clear()
     LOG("Cleared scene data");
 }
 
-void SceneParser::ParseGrass(const nlohmann::basic_json<>& grassJson)
+SceneGrassPatch SceneParser::ReadGrass(const nlohmann::json& grassJson)
 {
-    float grassDensity;
-    if (!get_to_if_exists(grassJson, "grass_density", grassDensity))
+    SceneGrassPatch grass;
+    if (!get_to_if_exists(grassJson, "grass_density", grass.density))
     {
         LOG(Logger::FATAL, "The patch of grass must have a clearly defined density.");
     }
-    std::array<uint32_t, 2> regionCount;
-    if (!get_to_if_exists(grassJson, "region_count", regionCount))
+    if (!get_to_if_exists(grassJson, "region_count", grass.regionCount))
     {
         LOG(Logger::FATAL, "The patch of grass must have a clearly defined regionCount.");
     }
-    Transform grassPatchPosition;
-    if (!get_to_if_exists(grassJson, "transform", grassPatchPosition))
+    if (!get_to_if_exists(grassJson, "transform", grass.transform))
     {
         LOG(Logger::FATAL, "The patch of grass must have a clearly defined transform.");
     }
-    std::string samplePatchTextureFilepath;
+    get_to_if_exists(grassJson, "sample_filepath", grass.sampleTexture);
+    return grass;
+}
 
-    Texture2D* tex = nullptr;
-    get_to_if_exists(grassJson, "sample_filepath", samplePatchTextureFilepath);
-    if (!samplePatchTextureFilepath.empty())
-    {
-        tex = WindowsEngine::GetInstance().GetModule<TextureManager>().GetTexture2D(samplePatchTextureFilepath);
-    }
+void SceneParser::ParseGrass(const nlohmann::basic_json<>& grassJson)
+{
+    AddGrass(ReadGrass(grassJson));
+}
+
+void SceneParser::AddGrass(const SceneGrassPatch& grass)
+{
+    static TextureManager& tm = WindowsEngine::GetModule<TextureManager>();
+
+    // Loaded as a plain texture, the whole image is sampled once when the instance data is generated
+    TextureHandle sampleTexture;
+    if (!grass.sampleTexture.empty() && tm.GetTexture2D(grass.sampleTexture))
+        sampleTexture = tm.GetHandle<Texture2D>(grass.sampleTexture);
 
     std::lock_guard lock{DeviceMutex};
-    data.grassPatches.push_back(std::make_unique<GrassGenerator>(grassDensity, regionCount, grassPatchPosition, tex));
+    data.grassPatches.push_back(std::make_unique<GrassGenerator>(grass.density, grass.regionCount, grass.transform, sampleTexture));
 }
 
-void SceneParser::ParseMesh(const nlohmann::basic_json<>& jMesh)
+size_t SceneParser::HashMeshDescription(const nlohmann::json& jMesh)
+{
+    return std::hash<std::string>{}(jMesh.dump());
+}
+
+void SceneParser::ParseMesh(const nlohmann::basic_json<>& jMesh, const size_t sourceHash)
 {
     static TextureManager& tm = WindowsEngine::GetModule<TextureManager>();
     static MeshManager& mm = WindowsEngine::GetModule<MeshManager>();
@@ -78,6 +90,10 @@ void SceneParser::ParseMesh(const nlohmann::basic_json<>& jMesh)
     const std::string type = jMesh.at("type").get<std::string>();
     const std::string meshName = jMesh.at("name").get<std::string>();
 
+    // Reuse the mesh left resident by a previous scene if it was built from the same description
+    if (const BaseMesh* residentMesh = mm.GetAsset<BaseMesh>(meshName); residentMesh && residentMesh->sourceHash == sourceHash)
+        return;
+
     BaseMesh* mesh{};
     if (type == "cubemesh")
     {
@@ -143,8 +159,7 @@ void SceneParser::ParseMesh(const nlohmann::basic_json<>& jMesh)
 
         if (std::string diffuseFile; get_to_if_exists(jMesh, "diffuse_filepath", diffuseFile))
         {
-            tm.SaveAsset<Texture2D>(diffuseFile);
-            decalMesh->SetAllMaterialMember(diffuseFile, &TexturedMaterial::diffuseTexture);
+            decalMesh->SetAllMaterialMember(tm.GetTexture2DHandle(diffuseFile), &TexturedMaterial::diffuseTexture);
         }
 
         mesh = mm.SaveAsset<DecalMesh>(meshName, std::move(decalMesh));
@@ -158,59 +173,68 @@ void SceneParser::ParseMesh(const nlohmann::basic_json<>& jMesh)
             return;
         }
 
-        Mesh<uint32_t>* complexMesh = mm.SaveAsset<Mesh<uint32_t>>(meshName, meshFile);
+        VertexFormat vertexFormat = VertexFormat::COMPACT;
+        if (std::string format; get_to_if_exists(jMesh, "vertex_format", format))
+        {
+            if (format == "full")
+                vertexFormat = VertexFormat::FULL;
+            else if (format == "compact")
+                vertexFormat = VertexFormat::COMPACT;
+            else if (format == "quantized")
+                vertexFormat = VertexFormat::COMPACT_QUANTIZED_POSITION;
+            else
+                LOGF("Invalid value for mesh vertex format : {}", format);
+        }
+
+        BaseMesh* complexMesh = mm.ImportMesh(meshName, meshFile, false, vertexFormat);
+        if (!complexMesh)
+            return;
         mesh = complexMesh;
 
         // If a texture is passed, override all submesh's materials
         if (std::string diffuseFile; get_to_if_exists(jMesh, "diffuse_filepath", diffuseFile))
         {
-            tm.SaveAsset<Texture2D>(diffuseFile);
-            complexMesh->SetAllMaterialMember(diffuseFile, &TexturedMaterial::diffuseTexture);
+            complexMesh->SetAllMaterialMember(tm.GetTexture2DHandle(diffuseFile), &TexturedMaterial::diffuseTexture);
         }
 
         if (std::string blendDiffuseFile; get_to_if_exists(jMesh, "primary_blend_diffuse_filepath", blendDiffuseFile))
         {
-            tm.SaveAsset<Texture2D>(blendDiffuseFile);
-            complexMesh->SetAllMaterialMember(blendDiffuseFile, &TexturedMaterial::primaryBlendDiffuseTexture);
+            complexMesh->SetAllMaterialMember(tm.GetTexture2DHandle(blendDiffuseFile), &TexturedMaterial::primaryBlendDiffuseTexture);
         }
 
         if (std::string blendFile; get_to_if_exists(jMesh, "primary_blend_filepath", blendFile))
         {
-            tm.SaveAsset<Texture2D>(blendFile);
-            complexMesh->SetAllMaterialMember(blendFile, &TexturedMaterial::primaryBlendTexture);
+            complexMesh->SetAllMaterialMember(tm.GetTexture2DHandle(blendFile), &TexturedMaterial::primaryBlendTexture);
         }
 
         if (std::string blendDiffuseFile; get_to_if_exists(jMesh, "secondary_blend_diffuse_filepath", blendDiffuseFile))
         {
-            tm.SaveAsset<Texture2D>(blendDiffuseFile);
-            complexMesh->SetAllMaterialMember(blendDiffuseFile, &TexturedMaterial::secondaryBlendDiffuseTexture);
+            complexMesh->SetAllMaterialMember(tm.GetTexture2DHandle(blendDiffuseFile), &TexturedMaterial::secondaryBlendDiffuseTexture);
         }
 
         if (std::string blendFile; get_to_if_exists(jMesh, "secondary_blend_filepath", blendFile))
         {
-            tm.SaveAsset<Texture2D>(blendFile);
-            complexMesh->SetAllMaterialMember(blendFile, &TexturedMaterial::secondaryBlendTexture);
+            complexMesh->SetAllMaterialMember(tm.GetTexture2DHandle(blendFile), &TexturedMaterial::secondaryBlendTexture);
         }
 
         if (std::string ambientFilepath; get_to_if_exists(jMesh, "ambient_filepath", ambientFilepath))
         {
-            tm.SaveAsset<Texture2D>(ambientFilepath);
-            complexMesh->SetAllMaterialMember(ambientFilepath, &TexturedMaterial::ambientTexture);
+            complexMesh->SetAllMaterialMember(tm.GetTexture2DHandle(ambientFilepath), &TexturedMaterial::ambientTexture);
         }
 
         if (std::string specularFilepath; get_to_if_exists(jMesh, "specular_filepath", specularFilepath))
         {
-            tm.SaveAsset<Texture2D>(specularFilepath);
-            complexMesh->SetAllMaterialMember(specularFilepath, &TexturedMaterial::specularTexture);
+            complexMesh->SetAllMaterialMember(tm.GetTexture2DHandle(specularFilepath), &TexturedMaterial::specularTexture);
         }
 
         if (std::string normalMapFilepath; get_to_if_exists(jMesh, "normalmap_filepath", normalMapFilepath))
         {
-            tm.SaveAsset<Texture2D>(normalMapFilepath);
-            complexMesh->SetAllMaterialMember(normalMapFilepath, &TexturedMaterial::normalMapTexture);
+            complexMesh->SetAllMaterialMember(tm.GetTexture2DHandle(normalMapFilepath), &TexturedMaterial::normalMapTexture);
         }
     }
 
+    mesh->sourceHash = sourceHash;
+
     if (std::string culling; get_to_if_exists(jMesh, "culling", culling))
     {
         if (culling == "front")
@@ -229,183 +253,190 @@ void SceneParser::ParseMesh(const nlohmann::basic_json<>& jMesh)
     }
 }
 
-void SceneParser::ParseCamera(const nlohmann::json& cameraJson)
+SceneCamera SceneParser::ReadCamera(const nlohmann::json& cameraJson)
 {
-    static CameraManager& cm = WindowsEngine::GetModule<CameraManager>();
+    SceneCamera camera;
+    get_to_if_exists(cameraJson, "transform", camera.transform);
 
     std::string type;
     get_to_if_exists(cameraJson, "type", type);
-    if (type == "orthographic")
-    {
-        Transform t;
-        get_to_if_exists(cameraJson, "transform", t);
+    camera.isOrthographic = type == "orthographic";
+    if (!camera.isOrthographic && get_to_if_exists(cameraJson, "FOV", camera.fov)) { camera.fov *= DirectX::XM_PI / 180.0f; }
+    return camera;
+}
 
-        cm.AddCameraOrtho(t);
-    }
+void SceneParser::ParseCamera(const nlohmann::json& cameraJson)
+{
+    AddCamera(ReadCamera(cameraJson));
+}
+
+void SceneParser::AddCamera(const SceneCamera& camera)
+{
+    static CameraManager& cm = WindowsEngine::GetModule<CameraManager>();
+
+    if (camera.isOrthographic)
+        cm.AddCameraOrtho(camera.transform);
     else
-    {
-        float FOV = PerspectiveProjection::DEFAULT_FOV;
-        if (get_to_if_exists(cameraJson, "FOV", FOV)) { FOV *= DirectX::XM_PI / 180.0f; }
+        cm.AddCameraPerspective(camera.transform, camera.fov);
+}
 
-        Transform t;
-        get_to_if_exists(cameraJson, "transform", t);
+std::optional<SceneParser::EntityType> SceneParser::GetEntityType(const std::string_view type) noexcept
+{
+    static constexpr std::array<std::string_view, static_cast<size_t>(EntityType::COUNT)> TYPE_NAMES = {
+        "sphere",
+        "cube",
+        "checkpoint_trigger",
+        "boost_trigger",
+        "key_trigger",
+        "lighting_trigger",
+        "billboard",
+        "terrain",
+        "vehicle",
+        "door",
+        "entity",
+        "instanced_entity",
+        "firefly",
+        "invisible_wall",
+        "menu_mesh",
+    };
+
+    if (const auto it = std::ranges::find(TYPE_NAMES, type); it != TYPE_NAMES.end())
+        return static_cast<EntityType>(it - TYPE_NAMES.begin());
+    return {};
+}
 
-        cm.AddCameraPerspective(t, FOV);
+std::unique_ptr<Entity> SceneParser::CreateEntity(const EntityType type, const nlohmann::json& object)
+{
+    switch (type)
+    {
+    case EntityType::SPHERE:
+        return Entity::CreateObject<Sphere>(object);
+    case EntityType::CUBE:
+        return Entity::CreateObject<Cube>(object);
+    case EntityType::CHECKPOINT_TRIGGER:
+        return Entity::CreateObject<CheckpointTrigger>(object);
+    case EntityType::BOOST_TRIGGER:
+        return Entity::CreateObject<BoostTrigger>(object);
+    case EntityType::KEY_TRIGGER:
+        return Entity::CreateObject<KeyTrigger>(object);
+    case EntityType::LIGHTING_TRIGGER:
+        return Entity::CreateObject<AdaptiveLightingTrigger>(object);
+    case EntityType::BILLBOARD:
+        return Entity::CreateObject<Billboard>(object);
+    case EntityType::TERRAIN:
+        return Entity::CreateObject<Terrain>(object);
+    case EntityType::VEHICLE:
+        return Entity::CreateObject<Vehicle>(object);
+    case EntityType::DOOR:
+        return Entity::CreateObject<Door>(object);
+    case EntityType::ENTITY:
+        return Entity::CreateObject<Entity>(object);
+    case EntityType::INSTANCED_ENTITY:
+        return Entity::CreateObject<InstancedEntity>(object);
+    case EntityType::FIREFLY:
+        return Entity::CreateObject<Firefly>(object);
+    case EntityType::INVISIBLE_WALL:
+        return Entity::CreateObject<InvisibleWall>(object);
+    case EntityType::MENU_MESH:
+        return Entity::CreateObject<MenuMesh>(object);
+    default:
+        return nullptr;
     }
 }
 
-std::unique_ptr<Entity> SceneParser::ParseEntity(const nlohmann::json& object)
+bool SceneParser::IsBuiltFromDescription(const EntityType type) noexcept
 {
-    std::unique_ptr<Entity> entity;
+    return type == EntityType::ENTITY || type == EntityType::CUBE || type == EntityType::SPHERE;
+}
 
-    if (const std::string type = object.at("type").get<std::string>(); type == "sphere")
-    {
-        entity = Entity::CreateObject<Sphere>(object);
-    }
-    else if (type == "cube")
-    {
-        entity = Entity::CreateObject<Cube>(object);
-    }
-    else if (type == "checkpoint_trigger")
-    {
-        entity = Entity::CreateObject<CheckpointTrigger>(object);
-    }
-    else if (type == "boost_trigger")
-    {
-        entity = Entity::CreateObject<BoostTrigger>(object);
-    }
-    else if (type == "key_trigger")
-    {
-        entity = Entity::CreateObject<KeyTrigger>(object);
-    }
-    else if (type == "lighting_trigger")
-    {
-        entity = Entity::CreateObject<AdaptiveLightingTrigger>(object);
-    }
-    else if (type == "billboard")
-    {
-        entity = Entity::CreateObject<Billboard>(object);
-    }
-    else if (type == "terrain")
-    {
-        entity = Entity::CreateObject<Terrain>(object);
-    }
-    else if (type == "vehicle")
-    {
-        entity = Entity::CreateObject<Vehicle>(object);
-    }
-    else if (type == "door")
-    {
-        entity = Entity::CreateObject<Door>(object);
-    }
-    else if (type == "entity")
+std::unique_ptr<Entity> SceneParser::CreateEntity(const EntityType type, const Entity::Description& description)
+{
+    static MeshManager& mm = WindowsEngine::GetModule<MeshManager>();
+
+    // Like their from_json, cubes and spheres look their mesh up with its type
+    switch (type)
     {
-        entity = Entity::CreateObject<Entity>(object);
-    }
-    else if (type == "instanced_entity")
+    case EntityType::SPHERE:
     {
-        entity = Entity::CreateObject<InstancedEntity>(object);
+        Sphere::Params params;
+        Entity::Resolve(description, params);
+        if (!description.mesh.empty())
+            params.mesh = mm.GetHandle<SphereMesh>(description.mesh);
+        return Entity::CreateObject<Sphere>(params);
     }
-    else if(type == "firefly")
+    case EntityType::CUBE:
     {
-        entity = Entity::CreateObject<Firefly>(object);
+        Cube::Params params;
+        Entity::Resolve(description, params);
+        if (!description.mesh.empty())
+            params.mesh = mm.GetHandle<CubeMesh>(description.mesh);
+        return Entity::CreateObject<Cube>(params);
     }
-    else if (type == "invisible_wall")
+    case EntityType::ENTITY:
     {
-        entity = Entity::CreateObject<InvisibleWall>(object);
+        Entity::Params params;
+        Entity::Resolve(description, params);
+        return Entity::CreateObject<Entity>(params);
     }
-    else if (type == "menu_mesh")
-    {
-        entity = Entity::CreateObject<MenuMesh>(object);
+    default:
+        return nullptr;
     }
-    return entity;
+}
+
+std::unique_ptr<Entity> SceneParser::ParseEntity(const nlohmann::json& object)
+{
+    const std::optional<EntityType> type = GetEntityType(object.at("type").get<std::string>());
+    return type ? CreateEntity(*type, object) : nullptr;
 }
 
 std::unique_ptr<Entity> SceneParser::ParseEntityObject(const nlohmann::json& object)
 {
-    std::unique_ptr<Entity> entity;
+    const std::optional<EntityType> type = GetEntityType(object.at("type").get<std::string>());
+    if (!type)
+        return nullptr;
 
-    if (const std::string type = object.at("type").get<std::string>(); type == "sphere")
+    std::unique_ptr<Entity> entity = CreateEntity(*type, object);
+    if (*type == EntityType::FIREFLY)
     {
-        entity = Entity::CreateObject<Sphere>(object);
-    }
-    else if (type == "cube")
-    {
-        entity = Entity::CreateObject<Cube>(object);
-    }
-    else if (type == "checkpoint_trigger")
-    {
-        entity = Entity::CreateObject<CheckpointTrigger>(object);
-    }
-    else if (type == "boost_trigger")
-    {
-        entity = Entity::CreateObject<BoostTrigger>(object);
-    }
-    else if (type == "key_trigger")
-    {
-        entity = Entity::CreateObject<KeyTrigger>(object);
-    }
-    else if (type == "lighting_trigger")
-    {
-        entity = Entity::CreateObject<AdaptiveLightingTrigger>(object);
-    }
-    else if (type == "billboard")
-    {
-        entity = Entity::CreateObject<Billboard>(object);
-    }
-    else if (type == "terrain")
-    {
-        entity = Entity::CreateObject<Terrain>(object);
-    }
-    else if (type == "vehicle")
-    {
-        entity = Entity::CreateObject<Vehicle>(object);
-    }
-    else if (type == "door")
-    {
-        entity = Entity::CreateObject<Door>(object);
-    }
-    else if (type == "entity")
-    {
-        entity = Entity::CreateObject<Entity>(object);
-    }
-    else if (type == "instanced_entity")
-    {
-        entity = Entity::CreateObject<InstancedEntity>(object);
-    }
-    else if (type == "firefly")
-    {
-        entity = Entity::CreateObject<Firefly>(object);
-        reinterpret_cast<Firefly*>(entity.get())->addLights(&data);
-    }
-    else if (type == "invisible_wall")
-    {
-        entity = Entity::CreateObject<InvisibleWall>(object);
-    }
-    else if (type == "menu_mesh")
-    {
-        entity = Entity::CreateObject<MenuMesh>(object);
+        std::lock_guard lock{objectsMutex};
+        static_cast<Firefly*>(entity.get())->addLights(&data);
     }
     return entity;
 }
 
-void SceneParser::ParseScene(const nlohmann::json& sceneJson)
+SceneSettings SceneParser::ReadSettings(const nlohmann::json& sceneJson)
+{
+    SceneSettings settings;
+    settings.hasClearColor = get_to_if_exists(sceneJson, "clear_color", settings.clearColor);
+    get_to_if_exists(sceneJson, "is_main_menu", settings.isMainMenu);
+    get_to_if_exists(sceneJson, "number_of_laps", settings.numberOfLaps);
+    return settings;
+}
+
+void SceneParser::ApplySettings(const SceneSettings& settings)
 {
-    if (Color color; get_to_if_exists(sceneJson, "clear_color", color))
+    if (settings.hasClearColor)
     {
-        WindowsEngine::GetInstance().GetRenderDevice()->SetClearColor(color);
+        WindowsEngine::GetInstance().GetRenderDevice()->SetClearColor(settings.clearColor);
     }
 
-    bool is_main_menu = false; get_to_if_exists(sceneJson, "is_main_menu", is_main_menu);
-    WindowsEngine::GetInstance().isMainMenuLoaded = is_main_menu;
+    WindowsEngine::GetInstance().isMainMenuLoaded = settings.isMainMenu;
+    WindowsEngine::GetInstance().GetModule<GameManager>().SetNumberOfLaps(settings.numberOfLaps);
+}
 
-    if(int numberOfLaps; get_to_if_exists(sceneJson, "number_of_laps", numberOfLaps))
-    {
-        WindowsEngine::GetInstance().GetModule<GameManager>().SetNumberOfLaps(numberOfLaps);
-    }
-    else{
-        WindowsEngine::GetInstance().GetModule<GameManager>().SetNumberOfLaps(3);
-    }
+void SceneParser::AddLights(const std::span<const DirectionalLight> directionalLights, const std::span<const SpotLight> spotLights, const std::span<const PointLight> pointLights)
+{
+    for (const DirectionalLight& light : directionalLights)
+        data.directionalLights.push_back(light);
+    for (const SpotLight& light : spotLights)
+        data.lights.AddSpotLight(light);
+    for (const PointLight& light : pointLights)
+        data.lights.AddPointLight(light);
+}
+
+void SceneParser::ParseScene(const nlohmann::json& sceneJson)
+{
+    ApplySettings(ReadSettings(sceneJson));
 
     const auto lights = sceneJson.at("lights").get<std::vector<nlohmann::basic_json<>>>();
     for (const auto& light : lights)
@@ -414,9 +445,9 @@ void SceneParser::ParseScene(const nlohmann::json& sceneJson)
         if (type == "directional")
             data.directionalLights.push_back(light.get<DirectionalLight>());
         if (type == "point")
-            data.pointLights.push_back(light.get<PointLight>());
+            data.lights.AddPointLight(light.get<PointLight>());
         if (type == "spot")
-            data.spotLights.push_back(light.get<SpotLight>());
+            data.lights.AddSpotLight(light.get<SpotLight>());
     }
 
     if (sceneJson.contains("skybox"))
@@ -426,6 +457,133 @@ void SceneParser::ParseScene(const nlohmann::json& sceneJson)
 }
 
 std::optional<SceneData> SceneParser::Parse(const std::string& filename, const std::atomic_bool& shouldStopLoading)
+{
+    if (useLevelArchives)
+    {
+        if (const std::optional<LevelArchive> archive = LevelArchive::Load(filename))
+            return ParseArchive(*archive, filename, shouldStopLoading);
+        LOGF(Logger::WARN, "No level archive for {}, loading it from JSON", filename);
+    }
+    return ParseJson(filename, shouldStopLoading);
+}
+
+std::optional<SceneData> SceneParser::ParseArchive(const LevelArchive& archive, const std::string& filename, const std::atomic_bool& shouldStopLoading)
+{
+    static CameraManager& cm = WindowsEngine::GetModule<CameraManager>();
+    static MeshManager& mm = WindowsEngine::GetModule<MeshManager>();
+    using Section = LevelArchive::Section;
+
+    SceneParser sceneData;
+    sceneData.data.sourceFilename = filename;
+    ThreadPool pool;
+    std::vector<ThreadPool::TaskHandle> handles;
+
+    auto before = std::chrono::high_resolution_clock::now();
+
+    const LevelArchive::CookedSettings& settings = archive.GetSettings();
+    sceneData.ApplySettings(settings.settings);
+    sceneData.AddLights(archive.GetSection<DirectionalLight>(Section::DIRECTIONAL_LIGHTS),
+        archive.GetSection<SpotLight>(Section::SPOT_LIGHTS),
+        archive.GetSection<PointLight>(Section::POINT_LIGHTS));
+    if (settings.skybox.size)
+        sceneData.data.skybox = Entity::CreateObject<CubeSkybox>(archive.GetParams(settings.skybox));
+
+    const std::span<const SceneCamera> cameras = archive.GetSection<SceneCamera>(Section::CAMERAS);
+    for (const SceneCamera& camera : cameras)
+        AddCamera(camera);
+    if (cameras.empty())
+        cm.AddCameraPerspective({});
+
+    for (const LevelArchive::CookedGrassPatch& grass : archive.GetSection<LevelArchive::CookedGrassPatch>(Section::GRASS_PATCHES))
+    {
+        if (shouldStopLoading)
+            return {};
+
+        sceneData.AddGrass({grass.transform, grass.regionCount, grass.density, std::string{archive.GetString(grass.sampleTexture)}});
+    }
+
+    for (const LevelArchive::CookedMesh& mesh : archive.GetSection<LevelArchive::CookedMesh>(Section::MESHES))
+    {
+        handles.push_back(pool.AddWaitableTask([&]
+        {
+            try
+            {
+                if (shouldStopLoading)
+                    return;
+
+                const BaseMesh* residentMesh = mm.GetAsset<BaseMesh>(std::string{archive.GetString(mesh.name)});
+                if (residentMesh && residentMesh->sourceHash == mesh.sourceHash)
+                    return;
+
+                sceneData.ParseMesh(archive.GetParams(mesh.description), mesh.sourceHash);
+            }
+            catch (nlohmann::detail::exception e)
+            {
+                LOG(Logger::ERROR, "Unable to load archived mesh: ", e.what());
+            }
+        }));
+    }
+
+    for (auto& handle : handles)
+        pool.WaitFor(handle);
+    handles.clear();
+
+    if (shouldStopLoading)
+        return {};
+
+    cm.ChangeCamera(0);
+
+    // Every entity is built in its own slot, so the scene keeps the order of the file
+    const std::span<const LevelArchive::CookedEntity> entities = archive.GetSection<LevelArchive::CookedEntity>(Section::ENTITIES);
+    std::vector<std::unique_ptr<Entity>> objects(entities.size());
+    for (size_t i = 0; i < entities.size(); ++i)
+    {
+        handles.push_back(pool.AddWaitableTask([&, i]
+        {
+            try
+            {
+                if (shouldStopLoading)
+                    return;
+
+                const LevelArchive::CookedEntity& entity = entities[i];
+                objects[i] = entity.description != LevelArchive::CookedEntity::NO_DESCRIPTION
+                    ? CreateEntity(entity.type, archive.GetDescription(entity.description))
+                    : CreateEntity(entity.type, archive.GetParams(entity.params));
+            }
+            catch (nlohmann::detail::exception e)
+            {
+                LOG(Logger::ERROR, "Unable to load archived entity: ", e.what());
+            }
+        }));
+    }
+
+    for (auto& handle : handles)
+        pool.WaitFor(handle);
+    handles.clear();
+
+    if (shouldStopLoading)
+        return {};
+
+    // Point lights are added in the order of the entities, like when parsing the scene
+    for (size_t i = 0; i < entities.size(); ++i)
+    {
+        if (entities[i].type == EntityType::FIREFLY && objects[i])
+            static_cast<Firefly*>(objects[i].get())->addLights(&sceneData.data);
+    }
+
+    std::erase(objects, nullptr);
+    sceneData.data.objects = std::move(objects);
+
+    for (const LevelArchive::Range decal : archive.GetSection<LevelArchive::Range>(Section::DECALS))
+        sceneData.data.decals.push_back(Entity::CreateObject<Decal>(archive.GetParams(decal)));
+
+    auto after = std::chrono::high_resolution_clock::now();
+    DebugPrint("Loading from level archive done in: ", std::chrono::duration_cast<std::chrono::milliseconds>(after - before), '\n');
+
+    return std::move(sceneData.data);
+}
+
+std::optional<SceneData> SceneParser::ParseJson(const std::string& filename, const std::atomic_bool& shouldStopLoading)
 {
     static CameraManager& cm = WindowsEngine::GetModule<CameraManager>();
 
@@ -499,7 +657,7 @@ std::optional<SceneData> SceneParser::Parse(const std::string& filename, const s
                 if (shouldStopLoading)
                     return;
 
-                sceneData.ParseMesh(mesh);
+                sceneData.ParseMesh(mesh, HashMeshDescription(mesh));
             }
             catch (detail::exception e)
             {
@@ -560,4 +718,84 @@ std::optional<SceneData> SceneParser::Parse(const std::string& filename, const s
 
     return std::move(sceneData.data);
 }
+
+void SceneParser::PrefetchAssets(const std::string& filename)
+{
+    static ThreadPool& pool = WindowsEngine::GetModule<ThreadPool>();
+    static TextureManager& tm = WindowsEngine::GetModule<TextureManager>();
+
+    SceneParser sceneData;
+    std::vector<ThreadPool::TaskHandle> handles;
+
+    // Textures the scene loads outside of the mesh materials, which are loaded with their mesh
+    std::vector<std::string> textures;
+    std::string skyboxTexture;
+
+    auto before = std::chrono::high_resolution_clock::now();
+
+    using namespace nlohmann;
+
+    const auto prefetchMesh = [&sceneData](const json& mesh, const size_t sourceHash)
+    {
+        try
+        {
+            sceneData.ParseMesh(mesh, sourceHash);
+        }
+        catch (detail::exception e)
+        {
+            LOG(Logger::ERROR, "Unable to prefetch mesh: ", e.what());
+        }
+    };
+
+    std::optional<LevelArchive> archive;
+    if (useLevelArchives)
+        archive = LevelArchive::Load(filename);
+
+    std::optional<json> sceneJson;
+    if (archive)
+    {
+        for (const LevelArchive::CookedMesh& mesh : archive->GetSection<LevelArchive::CookedMesh>(LevelArchive::Section::MESHES))
+            handles.push_back(pool.AddWaitableTask([&] { prefetchMesh(archive->GetParams(mesh.description), mesh.sourceHash); }));
+
+        for (const LevelArchive::CookedGrassPatch& grass : archive->GetSection<LevelArchive::CookedGrassPatch>(LevelArchive::Section::GRASS_PATCHES))
+            textures.emplace_back(archive->GetString(grass.sampleTexture));
+
+        if (const LevelArchive::Range skybox = archive->GetSettings().skybox; skybox.size)
+            get_to_if_exists(archive->GetParams(skybox), "texture", skyboxTexture);
+    }
+    else
+    {
+        std::ifstream file{filename};
+        sceneJson = json::parse(file, nullptr, true, true);
+
+        for (const json& mesh : sceneJson->at("meshes"))
+            handles.push_back(pool.AddWaitableTask([&] { prefetchMesh(mesh, HashMeshDescription(mesh)); }));
+
+        if (sceneJson->contains("grass_patches"))
+        {
+            for (const json& grass : sceneJson->at("grass_patches"))
+            {
+                if (std::string sampleTexture; get_to_if_exists(grass, "sample_filepath", sampleTexture))
+                    textures.push_back(std::move(sampleTexture));
+            }
+        }
+
+        if (sceneJson->contains("skybox"))
+            get_to_if_exists(sceneJson->at("skybox"), "texture", skyboxTexture);
+    }
+
+    std::erase(textures, std::string{});
+    for (const std::string& texture : textures)
+        handles.push_back(pool.AddWaitableTask([&] { tm.GetTexture2D(texture); }));
+
+    if (!skyboxTexture.empty())
+        handles.push_back(pool.AddWaitableTask([&] { tm.GetTextureCube(skyboxTexture); }));
+
+    for (auto& handle : handles)
+        pool.WaitFor(handle);
+
+    auto after = std::chrono::high_resolution_clock::now();
+    DebugPrint(archive ? "Prefetching from level archive done in: " : "Prefetching done in: ",
+        std::chrono::duration_cast<std::chrono::milliseconds>(after - before), '\n');
+}
 }
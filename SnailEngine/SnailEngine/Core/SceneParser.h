@@ -3,13 +3,16 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <span>
 #include <unordered_set>
 
 #include "DataStructures/FixedVector.h"
+#include "Camera/Projections/PerspectiveProjection.h"
+#include "Math/Transform.h"
+#include "Entities/Entity.h"
 #include "Entities/GrassGenerator.h"
-#include "Rendering/Lights/PointLight.h"
 #include "Rendering/Lights/DirectionalLight.h"
-#include "Rendering/Lights/SpotLight.h"
+#include "Rendering/Lights/LightManager.h"
 #include "Util/JsonUtil.h"
 
 namespace Snail
@@ -25,11 +28,8 @@ struct SceneData
     static constexpr uint8_t MAX_DIR_LIGHTS = 2;
     FixedVector<DirectionalLight, MAX_DIR_LIGHTS> directionalLights;
 
-    static constexpr uint8_t MAX_SPOT_LIGHTS = 10;
-    FixedVector<SpotLight, MAX_SPOT_LIGHTS> spotLights;
-
-    static constexpr uint8_t MAX_PT_LIGHTS = 40;
-    FixedVector<PointLight, MAX_PT_LIGHTS> pointLights;
+    // Point and spot lights, any number of them, the most important ones are lit
+    LightManager lights;
 
     std::vector<std::unique_ptr<Entity>> objects;
     std::unordered_set<Entity*> objectsToRemove;
@@ -46,17 +46,76 @@ struct SceneData
     void Clear();
 };
 
+// Scene wide values of the scene file, besides its lists
+struct SceneSettings
+{
+    Color clearColor;
+    int32_t numberOfLaps = 3;
+    bool hasClearColor = false;
+    bool isMainMenu = false;
+};
+
+struct SceneCamera
+{
+    Transform transform;
+    float fov = PerspectiveProjection::DEFAULT_FOV;
+    bool isOrthographic = false;
+};
+
+struct SceneGrassPatch
+{
+    Transform transform;
+    std::array<uint32_t, 2> regionCount;
+    float density;
+    std::string sampleTexture;
+};
+
+class LevelArchive;
+
 class SceneParser
 {
+public:
+    // The "type" of the scene objects, stored as is by the level archives
+    enum class EntityType : uint16_t
+    {
+        SPHERE,
+        CUBE,
+        CHECKPOINT_TRIGGER,
+        BOOST_TRIGGER,
+        KEY_TRIGGER,
+        LIGHTING_TRIGGER,
+        BILLBOARD,
+        TERRAIN,
+        VEHICLE,
+        DOOR,
+        ENTITY,
+        INSTANCED_ENTITY,
+        FIREFLY,
+        INVISIBLE_WALL,
+        MENU_MESH,
+        COUNT
+    };
+
+    // Load scenes from their cooked level archive, cooking it first when the JSON changed
+    static inline bool useLevelArchives = true;
+
+private:
     SceneData data;
     std::mutex objectsMutex;
 
     void ParseGrass(const nlohmann::basic_json<>& grassJson);
-    void ParseMesh(const nlohmann::basic_json<>& jMesh);
+    void AddGrass(const SceneGrassPatch& grass);
+    void ParseMesh(const nlohmann::basic_json<>& jMesh, size_t sourceHash);
     void ParseCamera(const nlohmann::json& cameraJson);
+    static void AddCamera(const SceneCamera& camera);
     void ParseScene(const nlohmann::json& sceneJson);
+    void ApplySettings(const SceneSettings& settings);
+    void AddLights(std::span<const DirectionalLight> directionalLights, std::span<const SpotLight> spotLights, std::span<const PointLight> pointLights);
     SceneParser() = default;
 
+    static std::optional<SceneData> ParseJson(const std::string& filename, const std::atomic_bool& shouldStopLoading);
+    static std::optional<SceneData> ParseArchive(const LevelArchive& archive, const std::string& filename, const std::atomic_bool& shouldStopLoading);
+
 public:
     SceneParser(const SceneParser&) = delete;
     SceneParser& operator=(const SceneParser&) = delete;
@@ -64,8 +123,23 @@ public:
     SceneParser& operator=(SceneParser&&) = delete;
 
     static std::optional<SceneData> Parse(const std::string& filename, const std::atomic_bool& shouldStopLoading);
+    // Loads the meshes of a scene file and their textures into the asset caches, without building the scene
+    static void PrefetchAssets(const std::string& filename);
     static std::unique_ptr<Entity> ParseEntity(const nlohmann::json& object);
     std::unique_ptr<Entity> ParseEntityObject(const nlohmann::json& object);
+
+    // Empty for unknown types
+    static std::optional<EntityType> GetEntityType(std::string_view type) noexcept;
+    static std::unique_ptr<Entity> CreateEntity(EntityType type, const nlohmann::json& object);
+    // Types whose params are nothing more than an Entity::Description
+    [[nodiscard]] static bool IsBuiltFromDescription(EntityType type) noexcept;
+    // Null for the types not built from a description
+    static std::unique_ptr<Entity> CreateEntity(EntityType type, const Entity::Description& description);
+    // Meshes built from the same description are reused across scenes
+    static size_t HashMeshDescription(const nlohmann::json& jMesh);
+    static SceneSettings ReadSettings(const nlohmann::json& sceneJson);
+    static SceneCamera ReadCamera(const nlohmann::json& cameraJson);
+    static SceneGrassPatch ReadGrass(const nlohmann::json& grassJson);
 };
 
 }
@@ -0,0 +1,192 @@
+#include "stdafx.h"
+#include "StartupGraph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+#include "Core/ThreadPool.h"
+
+namespace Snail
+{
+
+void StartupGraph::Add(std::string name, const Affinity affinity, std::vector<std::string> dependencies, std::function<void()> function)
+{
+    tasks.push_back({std::move(name), affinity, std::move(dependencies), std::move(function)});
+}
+
+StartupGraph::Results StartupGraph::Run(ThreadPool& pool, const std::function<void()>& idle)
+{
+    // Between two idle calls while the main thread has nothing to run
+    constexpr std::chrono::milliseconds IDLE_INTERVAL{16};
+
+    using Clock = std::chrono::high_resolution_clock;
+    const auto start = Clock::now();
+    const auto elapsedMs = [](const Clock::time_point from, const Clock::time_point to) { return std::chrono::duration<float, std::milli>(to - from).count(); };
+
+    std::vector<size_t> remainingDependencies(tasks.size());
+    std::vector<std::vector<size_t>> dependents(tasks.size());
+    for (size_t i = 0; i < tasks.size(); ++i)
+    {
+        for (const std::string& dependency : tasks[i].dependencies)
+        {
+            const auto it = std::ranges::find(tasks, dependency, &Task::name);
+            if (it == tasks.end())
+                LOGF(Logger::FATAL, "Startup task \"{}\" depends on unknown task \"{}\"", tasks[i].name, dependency);
+
+            dependents[it - tasks.begin()].push_back(i);
+            ++remainingDependencies[i];
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<size_t> readyMainTasks;
+    // Scheduled and not finished, the main thread returns once it drops to zero
+    size_t pendingCount = 0;
+    size_t finishedCount = 0;
+    std::exception_ptr error;
+    Results results;
+
+    // Called with the mutex held
+    std::function<void(size_t)> schedule;
+
+    const auto runTask = [&](const size_t index, const bool onMainThread)
+    {
+        const auto taskStart = Clock::now();
+        std::exception_ptr taskError;
+        try
+        {
+            tasks[index].function();
+        }
+        catch (...)
+        {
+            taskError = std::current_exception();
+        }
+        const auto taskEnd = Clock::now();
+
+        std::lock_guard lock{mutex};
+        results.timings.push_back({tasks[index].name, elapsedMs(start, taskStart), elapsedMs(taskStart, taskEnd), onMainThread});
+        ++finishedCount;
+        if (taskError && !error)
+            error = taskError;
+
+        if (!error)
+        {
+            for (const size_t dependent : dependents[index])
+            {
+                if (--remainingDependencies[dependent] == 0)
+                    schedule(dependent);
+            }
+        }
+
+        --pendingCount;
+        // Under the lock, the main thread can return and destroy the condition as soon as it is released
+        condition.notify_all();
+    };
+
+    schedule = [&](const size_t index)
+    {
+        ++pendingCount;
+        if (tasks[index].affinity == Affinity::MAIN_THREAD)
+            readyMainTasks.push_back(index);
+        else
+            pool.AddTask([&runTask, index] { runTask(index, false); });
+    };
+
+    {
+        std::unique_lock lock{mutex};
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            if (remainingDependencies[i] == 0)
+                schedule(i);
+        }
+
+        while (pendingCount > 0)
+        {
+            if (!readyMainTasks.empty())
+            {
+                const size_t index = readyMainTasks.back();
+                readyMainTasks.pop_back();
+                if (error)
+                {
+                    --pendingCount;
+                    continue;
+                }
+
+                lock.unlock();
+                runTask(index, true);
+                lock.lock();
+                continue;
+            }
+
+            if (idle)
+            {
+                lock.unlock();
+                idle();
+                lock.lock();
+            }
+            condition.wait_for(lock, IDLE_INTERVAL, [&] { return !readyMainTasks.empty() || pendingCount == 0; });
+        }
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+
+    if (finishedCount < tasks.size())
+        LOGF(Logger::FATAL, "Startup tasks depend on each other, {} of them never ran", tasks.size() - finishedCount);
+
+    results.totalMs = elapsedMs(start, Clock::now());
+    for (const Timing& timing : results.timings)
+        results.serialMs += timing.durationMs;
+    return results;
+}
+
+void StartupGraph::LogResults(const Results& results)
+{
+    std::vector<const Timing*> timings;
+    for (const Timing& timing : results.timings)
+        timings.push_back(&timing);
+    std::ranges::sort(timings, {}, &Timing::startMs);
+
+    for (const Timing* timing : timings)
+        LOGF("{} initialised in {:.1f} ms, started at {:.1f} ms on {}", timing->name, timing->durationMs, timing->startMs, timing->onMainThread ? "the main thread" : "a worker");
+    LOGF("Startup took {:.1f} ms, {:.1f} ms when run one task after the other", results.totalMs, results.serialMs);
+}
+
+#ifdef _IMGUI_
+void StartupGraph::RenderImGui(const Results& results)
+{
+    if (ImGui::CollapsingHeader("Startup"))
+    {
+        ImGui::Text("Took %.1f ms, %.1f ms when run one task after the other", results.totalMs, results.serialMs);
+
+        if (ImGui::BeginTable("StartupTasks", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+        {
+            ImGui::TableSetupColumn("Task");
+            ImGui::TableSetupColumn("Start (ms)");
+            ImGui::TableSetupColumn("Duration (ms)");
+            ImGui::TableSetupColumn("Thread");
+            ImGui::TableHeadersRow();
+
+            for (const Timing& timing : results.timings)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", timing.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", timing.startMs);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", timing.durationMs);
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", timing.onMainThread ? "Main" : "Worker");
+            }
+            ImGui::EndTable();
+        }
+    }
+}
+#endif
+
+}
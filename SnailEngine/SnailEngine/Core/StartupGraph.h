@@ -0,0 +1,66 @@
+#pragma once
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace Snail
+{
+class ThreadPool;
+
+// Initialisation tasks of the engine with the tasks they depend on. Independent tasks run concurrently on the job
+// system, the ones bound to the device or the window run on the thread calling Run.
+class StartupGraph
+{
+public:
+    enum class Affinity : uint8_t
+    {
+        ANY_THREAD,
+        MAIN_THREAD,
+    };
+
+    struct Timing
+    {
+        std::string name;
+        // From the start of Run
+        float startMs = 0;
+        float durationMs = 0;
+        bool onMainThread = false;
+    };
+
+    struct Results
+    {
+        // In the order the tasks finished
+        std::vector<Timing> timings;
+        float totalMs = 0;
+        // What running the tasks one after the other would have taken
+        float serialMs = 0;
+    };
+
+private:
+    struct Task
+    {
+        std::string name;
+        Affinity affinity;
+        std::vector<std::string> dependencies;
+        std::function<void()> function;
+    };
+
+    std::vector<Task> tasks;
+
+public:
+    // Dependencies are the names of tasks added before or after this one
+    void Add(std::string name, Affinity affinity, std::vector<std::string> dependencies, std::function<void()> function);
+
+    // Runs every task once, after its dependencies. While it waits, the main thread calls idle between its own tasks.
+    // The first exception thrown by a task is rethrown once the running tasks are done, the tasks left are skipped.
+    Results Run(ThreadPool& pool, const std::function<void()>& idle = {});
+
+    static void LogResults(const Results& results);
+
+#ifdef _IMGUI_
+    static void RenderImGui(const Results& results);
+#endif
+};
+
+}
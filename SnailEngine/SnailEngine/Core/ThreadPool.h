@@ -1,9 +1,15 @@
 #pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <mutex>
 #include <queue>
 #include <set>
 #include <thread>
 
+#include "Core/Memory/PoolAllocator.h"
+
 namespace Snail
 {
 class ThreadPool
@@ -46,10 +52,11 @@ private:
 
     TaskHandle currentHandle{0};
 
-    std::queue<Task> taskQueue;
+    // Pooled so that submitting jobs every frame doesn't go to the heap
+    std::queue<Task, std::deque<Task, PoolAllocator<Task>>> taskQueue;
 
     // Done tasks is only cleared when someone waits for the task
-    std::set<TaskHandle> doneTasks;
+    std::set<TaskHandle, std::less<TaskHandle>, PoolAllocator<TaskHandle>> doneTasks;
     std::vector<std::thread> pool;
 
     void Run();
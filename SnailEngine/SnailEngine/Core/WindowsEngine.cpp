@@ -110,7 +110,9 @@ int WindowsEngine::InitSpecific()
     const auto& inputModule = InputModule::GetInstance();
     inputModule.Mouse.SetWindow(hMainWnd);
 
-    Show();
+    // The window of the engine tests stays hidden, the swap chain only needs it to exist
+    if (!isHeadless)
+        Show();
 
     RAWINPUTDEVICE dev[1];
     dev[0].usUsagePage = 0x01; // HID_USAGE_PAGE_GENERIC
@@ -56,6 +56,7 @@ private:
     int InitSpecific() override;
     void UpdateSpecific() override;
     int64_t GetTimeSpecific() const override;
+    PacingClock& GetClockSpecific() override { return clock; }
     double GetTimeIntervalsInSec(int64_t start, int64_t stop) const override;
 
     // Fonctions "Callback" -- Doivent �tre statiques
@@ -2,6 +2,7 @@
 #include "Billboard.h"
 
 #include "Core/WindowsEngine.h"
+#include "Core/Mesh/BillboardMesh.h"
 #include "Core/Mesh/QuadMesh.h"
 
 namespace Snail
@@ -10,7 +11,7 @@ Billboard::Params::Params()
 {
     static MeshManager& meshManager = WindowsEngine::GetModule<MeshManager>();
     name = "Billboard";
-    mesh = meshManager.GetAsset<QuadMesh>("Quad");
+    mesh = meshManager.GetHandle<QuadMesh>("Quad");
     billboardType = WORLD_ALIGNED;
 }
 
@@ -37,6 +38,7 @@ Matrix Billboard::GetWorldTransformMatrix()
     const Matrix viewProjMatrix = cam->GetViewProjectionMatrix();
     const Matrix scale = Matrix::CreateScale(worldTr.scale);
 
+    Matrix worldTransformMatrix;
     switch (type)
     {
         case WORLD_ALIGNED:
@@ -69,10 +71,30 @@ Matrix Billboard::GetWorldTransformMatrix()
     return worldTransformMatrix;
 }
 
-void Billboard::Draw(DrawContext&)
+void Billboard::Draw(DrawContext& ctx)
 {
+    BaseMesh* mesh = GetMesh();
+    if (!mesh)
+        return;
+
     // TODO: improve this by adding translucency and rendering all non-opaque objects after deferred
-    mesh->SubscribeInstance(GetWorldTransformMatrix());
+    if (auto* billboardMesh = dynamic_cast<BillboardMesh*>(mesh))
+    {
+        // The vertex shader turns the quad towards the camera, no matrix to build. Opaque white keeps the texture as is.
+        const Transform worldTr = GetWorldTransform();
+        const ParticleInstance instance{worldTr.position, {worldTr.scale.x, worldTr.scale.y}, 0xFFFFFFFF, static_cast<uint32_t>(type)};
+        billboardMesh->SubscribeParticles({&instance, 1});
+        return;
+    }
+
+    const Matrix world = GetWorldTransformMatrix();
+    ctx.RequestTextureDetail(*mesh, GetBoundingBox(), world);
+    mesh->SubscribeInstance(world);
+}
+
+Billboard::BillboardType Billboard::GetBillboardType() const noexcept
+{
+    return type;
 }
 
 void Billboard::RenderImGui(const int idNumber)
@@ -29,7 +29,9 @@ public:
     };
 
     Billboard(const Params& params);
+    // Camera facing and multiplied by the view projection, a BillboardMesh expands the quad on the GPU instead
     [[nodiscard]] Matrix GetWorldTransformMatrix() override;
+    [[nodiscard]] BillboardType GetBillboardType() const noexcept;
     void Draw(DrawContext& ctx) override;
 
     void RenderImGui(int idNumber) override;
@@ -12,7 +12,7 @@ Cube::Params::Params()
     static MeshManager& mm = WindowsEngine::GetModule<MeshManager>();
 
     name = "Cube";
-    mesh = mm.GetAsset<CubeMesh>("Cube");
+    mesh = mm.GetHandle<CubeMesh>("Cube");
 }
 
 Cube::Cube(const Params& params)
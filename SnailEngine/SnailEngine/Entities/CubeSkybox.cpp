@@ -11,7 +11,7 @@ CubeSkybox::Params::Params()
     static MeshManager& meshManager = WindowsEngine::GetModule<MeshManager>();
 
     name = "Skybox";
-    mesh = meshManager.GetAsset<CubeMapMesh>("CubeMap");
+    mesh = meshManager.GetHandle<CubeMapMesh>("CubeMap");
     castsShadows = false;
 }
 
@@ -24,7 +24,8 @@ CubeSkybox::CubeSkybox(const Params& params)
 void CubeSkybox::Draw(DrawContext& ctx)
 {
     Entity::Draw(ctx);
-    mesh->Draw(&WindowsEngine::GetCamera()->GetTransformMatrixesBuffer());
+    if (BaseMesh* mesh = GetMesh())
+        mesh->Draw(&WindowsEngine::GetCamera()->GetTransformMatrixesBuffer());
 }
 
 }
@@ -9,7 +9,7 @@ Decal::Params::Params()
 {
     name = "Decal";
     // Decal without mesh makes no sense!
-    mesh = nullptr;
+    mesh = {};
 }
 
 Decal::Decal(const Params& params)
@@ -2,18 +2,118 @@
 
 #include "Entity.h"
 
+#include "Core/EntityUpdate.h"
 #include "Core/WindowsEngine.h"
+#include "Core/Memory/PoolAllocator.h"
 #include "Core/Physics/DynamicPhysicsObject.h"
+#include "Core/Physics/PhysicsModule.h"
+#include "Core/Physics/StaticPhysicsObject.h"
+#include "Rendering/FrameView.h"
 
 namespace Snail
 {
 
+namespace
+{
+physx::PxShape* GenerateMeshShape(BaseMesh* mesh, const bool isTriangleMesh, const Vector3& scale)
+{
+    static PhysicsModule& pm = WindowsEngine::GetModule<PhysicsModule>();
+
+    // Imported meshes use 16 bit indices when they are small enough
+    if (const auto* mesh32 = dynamic_cast<Mesh<uint32_t>*>(mesh))
+        return isTriangleMesh ? pm.GenerateMeshTriangleShape(mesh32, scale) : pm.GenerateMeshConvexShape(mesh32, scale);
+    if (const auto* mesh16 = dynamic_cast<Mesh<>*>(mesh))
+        return isTriangleMesh ? pm.GenerateMeshTriangleShape(mesh16, scale) : pm.GenerateMeshConvexShape(mesh16, scale);
+    return nullptr;
+}
+
+PhysicsObject* CreatePhysicsObject(const Entity::PhysicsDescription& description, const Entity::Params& params)
+{
+    using Body = Entity::PhysicsDescription::Body;
+    using Shape = Entity::PhysicsDescription::Shape;
+
+    static MeshManager& mm = WindowsEngine::GetModule<MeshManager>();
+    static PhysicsModule& pm = WindowsEngine::GetModule<PhysicsModule>();
+
+    Transform physicsTransform = description.shapeTransform;
+    physicsTransform.scale *= params.transform.scale;
+
+    PhysXUniquePtr<physx::PxShape> shape{};
+    switch (description.shape)
+    {
+    case Shape::BOX:
+    {
+        const Vector3 extents = description.extents * physicsTransform.scale;
+        shape.reset(pm.physics->createShape(physx::PxBoxGeometry{extents.x, extents.y, extents.z}, *pm.defaultMaterial));
+        break;
+    }
+    case Shape::SPHERE:
+        shape.reset(pm.physics->createShape(physx::PxSphereGeometry{description.radius * physicsTransform.scale.x}, *pm.defaultMaterial));
+        break;
+    case Shape::CAPSULE:
+        shape.reset(pm.physics->createShape(physx::PxCapsuleGeometry{description.radius * physicsTransform.scale.x, description.halfHeight * physicsTransform.scale.y}, *pm.defaultMaterial));
+        break;
+    case Shape::PLANE:
+        shape.reset(pm.physics->createShape(physx::PxPlaneGeometry(), *pm.defaultMaterial));
+        break;
+    case Shape::CONVEX_MESH:
+    case Shape::TRIANGLE_MESH:
+    {
+        // Default to mesh of the entity
+        BaseMesh* physicsMesh = description.meshName.empty() ? mm.GetAsset(params.mesh) : mm.GetAsset<BaseMesh>(description.meshName);
+        if (!physicsMesh)
+            break;
+
+        if (description.shape == Shape::TRIANGLE_MESH && description.body == Body::DYNAMIC)
+            LOGF(Logger::FATAL, "Dynamic physics triangle meshes are not supported");
+        else
+            shape.reset(GenerateMeshShape(physicsMesh, description.shape == Shape::TRIANGLE_MESH, physicsTransform.scale));
+        break;
+    }
+    case Shape::UNKNOWN:
+        break;
+    }
+
+    if (!shape)
+    {
+        LOGF(Logger::WARN, "Physics shape wasn't created when physics description was supplied for entity \"{}\"", params.name);
+        return nullptr;
+    }
+
+    pm.collisionLayers.Apply(*shape, description.layer.empty() ? std::string_view{CollisionLayers::DEFAULT_LAYER} : description.layer);
+
+    shape->setLocalPose(physicsTransform);
+    if (description.body == Body::DYNAMIC)
+        return new DynamicPhysicsObject{shape.get(), params.transform};
+    if (description.body == Body::STATIC)
+        return new StaticPhysicsObject{shape.get(), params.transform};
+    return nullptr;
+}
+}
+
+void Entity::Resolve(const Description& description, Params& params)
+{
+    static MeshManager& mm = WindowsEngine::GetModule<MeshManager>();
+
+    if (!description.name.empty())
+        params.name = description.name;
+    params.transform = description.transform;
+    if (!description.mesh.empty())
+        params.mesh = mm.GetHandle<BaseMesh>(description.mesh);
+    params.occluder = description.occluder;
+
+    if (description.physics)
+        params.physicsObject = CreatePhysicsObject(*description.physics, params);
+}
+
 Entity::Entity(const Params& params) noexcept
     : entityName{params.name}
-    , mesh{params.mesh}
+    , meshHandle{params.mesh}
     , transform{params.transform}
+    , transformNode{params.transform}
     , physicsObject{params.physicsObject}
     , castsShadows{params.castsShadows}
+    , occluderType{params.occluder}
 {}
 
 Entity::Entity(Entity&&) noexcept = default;
@@ -22,51 +122,102 @@ Entity& Entity::operator=(Entity&&) noexcept = default;
 
 Entity::~Entity() = default;
 
+void* Entity::operator new(const size_t size)
+{
+    return PoolAllocate(size, MemoryTag::ENTITIES);
+}
+
+void Entity::operator delete(void* ptr, const size_t size) noexcept
+{
+    PoolFree(ptr, size, MemoryTag::ENTITIES);
+}
+
 void Entity::Update(const float) noexcept
 {
     if (physicsObject)
     {
-        dirtyFlags.set();
         physicsObject->UpdateTransform(transform);
+        MarkTransformDirty();
+    }
+}
+
+bool Entity::CanUpdateInParallel() const noexcept { return true; }
+
+void Entity::MarkTransformDirty()
+{
+    if (SceneCommandBuffer* commands = SceneCommandBuffer::GetRecording())
+    {
+        commands->SetLocalTransform(transformNode.Get(), transform);
+        return;
     }
+
+    static TransformHierarchy& hierarchy = WindowsEngine::GetModule<TransformHierarchy>();
+    hierarchy.SetLocalTransform(transformNode.Get(), transform);
+}
+
+bool Entity::SetPhysicsTransform(const Transform& t) const
+{
+    // Setting a pose can't fail, the write is applied at the sync point
+    if (SceneCommandBuffer* commands = SceneCommandBuffer::GetRecording())
+    {
+        commands->SetPhysicsTransform(this, t);
+        return true;
+    }
+
+    PhysxWriteLock lock;
+    return physicsObject->SetTransform(t);
 }
 
 void Entity::Draw(DrawContext& ctx)
 {
+    BaseMesh* mesh = GetMesh();
     if (!mesh || (shouldFrustumCull && ctx.ShouldBeCulled(GetBoundingBox())))
         return;
 
-    mesh->SubscribeInstance(GetWorldTransformMatrix());
+    const Matrix world = GetWorldTransformMatrix();
+    ctx.RequestTextureDetail(*mesh, GetBoundingBox(), world);
+    mesh->SubscribeInstance(world, ctx.SelectLod(*mesh, GetBoundingBox(), lodState));
+}
+
+void Entity::GatherOccluders(FrameView& view)
+{
+    const BaseMesh* mesh = GetMesh();
+    if (occluderType == OccluderType::MESH && mesh)
+    {
+        view.AddOccluder(mesh->GetOccluderMesh(), GetWorldTransformMatrix());
+    }
+    else if (occluderType == OccluderType::BOX)
+    {
+        Matrix box = Matrix::Identity;
+        if (mesh)
+        {
+            const auto [min, max] = mesh->GetBounds();
+            box = Matrix::CreateScale(max - min) * Matrix::CreateTranslation((min + max) * 0.5f);
+        }
+        view.AddOccluder(OccluderMesh::GetUnitBox(), box * GetWorldTransformMatrix());
+    }
 }
 
 const Transform& Entity::GetTransform() const { return transform; }
 
 void Entity::SetTransform(const Transform& t)
 {
-    dirtyFlags.set();
-
-    if (!physicsObject)
+    if (!physicsObject || SetPhysicsTransform(t))
     {
         transform = t;
-        return;
+        MarkTransformDirty();
     }
-
-    if (physicsObject->SetTransform(t)) { transform = t; }
 }
 
 void Entity::SetPosition(const Vector3& pos)
 {
-    dirtyFlags.set();
-
-    if (!physicsObject)
+    Transform newTransform = transform;
+    newTransform.position = pos;
+    if (!physicsObject || SetPhysicsTransform(newTransform))
     {
         transform.position = pos;
-        return;
+        MarkTransformDirty();
     }
-
-    Transform newTransform = transform;
-    newTransform.position = pos;
-    if (physicsObject->SetTransform(newTransform)) { transform.position = pos; }
 }
 
 Entity* Entity::GetParent() const noexcept { return parent; }
@@ -87,52 +238,58 @@ void Entity::PrepareShadows()
 
 void Entity::SetRotation(const Vector3& euler)
 {
-    dirtyFlags.set();
     transform.rotation = Quaternion::CreateFromYawPitchRoll(euler);
-    if (physicsObject) { physicsObject->SetTransform(transform); }
+    if (physicsObject) { SetPhysicsTransform(transform); }
+    MarkTransformDirty();
 }
 
 void Entity::SetRotation(const Quaternion& quat)
 {
-    dirtyFlags.set();
     transform.rotation = quat;
-    if (physicsObject) { physicsObject->SetTransform(transform); }
+    if (physicsObject) { SetPhysicsTransform(transform); }
+    MarkTransformDirty();
 }
 
 void Entity::SetScale(const Vector3& scale)
 {
-    dirtyFlags.set();
     transform.scale = scale;
+    MarkTransformDirty();
 }
 
 void Entity::SetParent(Entity* pParent) noexcept
 {
-    dirtyFlags.set();
+    static TransformHierarchy& hierarchy = WindowsEngine::GetModule<TransformHierarchy>();
     parent = pParent;
+    hierarchy.SetParent(transformNode.Get(), parent ? parent->transformNode.Get() : TransformHierarchy::NodeHandle{});
 }
 
 Transform Entity::GetWorldTransform()
 {
+    // Roots have no parent to combine with
     if (!parent)
     {
         return GetTransform();
     }
 
-    if (!dirtyFlags.test(2))
-    {
-        return worldTransform;
-    }
+    static TransformHierarchy& hierarchy = WindowsEngine::GetModule<TransformHierarchy>();
+    Matrix worldMatrix = hierarchy.GetWorldMatrix(transformNode.Get());
 
-    Matrix worldMatrix = GetWorldTransformMatrix();
+    Transform worldTransform;
     worldMatrix.Decompose(worldTransform.scale, worldTransform.rotation, worldTransform.position);
-    dirtyFlags.set(2, false);
     return worldTransform;
 }
 
-const BaseMesh* Entity::GetMesh() const noexcept { return mesh; }
+MeshHandle Entity::GetMeshHandle() const noexcept { return meshHandle; }
+
+BaseMesh* Entity::GetMesh() const noexcept
+{
+    static const MeshManager& mm = WindowsEngine::GetModule<MeshManager>();
+    return mm.GetAsset(meshHandle);
+}
 
 Vector3 Entity::GetBoundsLocalCenter() const noexcept
 {
+    const BaseMesh* mesh = GetMesh();
     if (!mesh) { return Vector3::Zero; }
 
     auto [min, max] = mesh->GetBounds();
@@ -142,14 +299,17 @@ Vector3 Entity::GetBoundsLocalCenter() const noexcept
 const DirectX::BoundingBox& Entity::GetBoundingBox()
 {
     static RendererModule& renderer = WindowsEngine::GetModule<RendererModule>();
-    const Transform _worldTransform = GetWorldTransform();
+    static TransformHierarchy& hierarchy = WindowsEngine::GetModule<TransformHierarchy>();
 
-    if (!dirtyFlags.test(1))
+    // Checked before decomposing the world matrix, a hit must stay as cheap as the version lookup
+    const uint32_t worldVersion = hierarchy.GetWorldVersion(transformNode.Get());
+    if (worldVersion != 0 && worldVersion == boundingBoxVersion)
     {
 #ifdef _DEBUG
         if (renderer.drawEntityTransform)
         {
             // Additional computations only occur for debugging purposes
+            const Transform _worldTransform = GetWorldTransform();
             const Vector3 globalCenter = Vector3::Transform(GetBoundsLocalCenter(), GetWorldTransformMatrix());
             const Vector3 extents = GetExtents() * _worldTransform.scale;
 
@@ -172,6 +332,7 @@ const DirectX::BoundingBox& Entity::GetBoundingBox()
     // ===================================================================================================
 
     // Get global scale thanks to our transform
+    const Transform _worldTransform = GetWorldTransform();
     const Vector3 globalCenter = Vector3::Transform(GetBoundsLocalCenter(), GetWorldTransformMatrix());
 
     const Vector3 extents = GetExtents() * _worldTransform.scale;
@@ -197,7 +358,7 @@ const DirectX::BoundingBox& Entity::GetBoundingBox()
 
     // Store center and extents.
     boundingBox = DirectX::BoundingBox{globalCenter, Vector3{newIi, newIj, newIk}};
-    dirtyFlags.set(1, false);
+    boundingBoxVersion = worldVersion;
 
     return boundingBox;
 }
@@ -206,25 +367,15 @@ const PhysicsObject* Entity::GetPhysicsObject() const noexcept { return physicsO
 
 Matrix Entity::GetWorldTransformMatrix()
 {
-    if (!dirtyFlags.test(0)) { return worldTransformMatrix; }
-
-    // Update world transform matrix
-    if (!parent) { worldTransformMatrix = transform.GetTransformationMatrix(); }
-    else
-    {
-        const Matrix parentTransform = parent->transform.GetTransformationMatrix();
-        worldTransformMatrix = transform.GetTransformationMatrix() * parentTransform;
-    }
-
-    dirtyFlags.set(0, false);
-
-    return worldTransformMatrix;
+    static TransformHierarchy& hierarchy = WindowsEngine::GetModule<TransformHierarchy>();
+    return hierarchy.GetWorldMatrix(transformNode.Get());
 }
 
 bool Entity::ShouldCastShadows() const noexcept { return castsShadows; }
 
 Vector3 Entity::GetExtents() const noexcept
 {
+    const BaseMesh* mesh = GetMesh();
     if (!mesh) { return Vector3::Zero; }
     auto [min, max] = mesh->GetBounds();
     return (max - min) * 0.5f;
@@ -261,7 +412,7 @@ void Entity::RenderImGui(const int idNumber)
 
         ImGui::TreePop();
     }
-    if (mesh && ImGui::TreeNodeEx(("Mesh ##" + std::to_string(idNumber) + entityName).c_str(), ImGuiTreeNodeFlags_DefaultOpen))
+    if (BaseMesh* mesh = GetMesh(); mesh && ImGui::TreeNodeEx(("Mesh ##" + std::to_string(idNumber) + entityName).c_str(), ImGuiTreeNodeFlags_DefaultOpen))
     {
         ImGui::PushStyleColor(ImGuiCol_Text, IM_COL32(255, 255, 255, 255));
         mesh->RenderImGui();
@@ -1,7 +1,9 @@
 #pragma once
+#include <optional>
 
-#include <bitset>
+#include "Core/Assets/AssetHandle.h"
 #include "Core/Math/Transform.h"
+#include "Core/Math/TransformHierarchy.h"
 #include "Core/Mesh/Mesh.h"
 
 namespace Snail
@@ -10,6 +12,7 @@ class DrawContext;
 class PhysicsObject;
 class EffectsShader;
 class TriggerBox;
+struct FrameView;
 
 class Entity
 {
@@ -17,39 +20,85 @@ public:
     struct Params
     {
         std::string name = "Entity";
-        BaseMesh* mesh = nullptr;
+        MeshHandle mesh{};
         Transform transform = {};
         bool castsShadows = true;
         PhysicsObject* physicsObject = nullptr;
+        OccluderType occluder = OccluderType::NONE;
     };
 
+    // Physics block of a scene object, as written in the scene file
+    struct PhysicsDescription
+    {
+        enum class Body : uint8_t
+        {
+            STATIC,
+            DYNAMIC,
+            UNKNOWN,
+        };
+
+        enum class Shape : uint8_t
+        {
+            BOX,
+            SPHERE,
+            CAPSULE,
+            PLANE,
+            CONVEX_MESH,
+            TRIANGLE_MESH,
+            UNKNOWN,
+        };
+
+        Body body = Body::STATIC;
+        Shape shape = Shape::UNKNOWN;
+        // Scaled by the entity when resolved
+        Transform shapeTransform = {};
+        Vector3 extents = Vector3::One / 2.0f;
+        float radius = 1;
+        float halfHeight = 1;
+        // Mesh of the entity when empty
+        std::string meshName;
+        // Default layer when empty
+        std::string layer;
+    };
+
+    // Params as written in the scene file, before the meshes are looked up and the physics object is created.
+    // Level archives cook it as a plain struct for the entity types whose params are nothing more.
+    struct Description
+    {
+        // The params keep their default for what is empty
+        std::string name;
+        std::string mesh;
+        Transform transform = {};
+        OccluderType occluder = OccluderType::NONE;
+        std::optional<PhysicsDescription> physics;
+    };
+
+    // Looks up the mesh and creates the physics object of a description
+    static void Resolve(const Description& description, Params& params);
+
     std::string entityName;
 
 protected:
     Entity* parent = nullptr;
-    BaseMesh* mesh = nullptr;
-
-    /**
-     * DirtyFlags field signification:
-     * 0: the transform is dirty
-     * 1: the bounding box is dirty
-     * 2: the world transform is dirty
-     * All fields should default to true for first lazy loading
-     */
-    std::bitset<3> dirtyFlags = std::bitset<3>().set();
+    // Resolved when drawn, a mesh evicted or deleted from the MeshManager is then no longer drawn
+    MeshHandle meshHandle;
 
     Transform transform;
-
-    // TODO: Hierarchy: must also update the dirty flags of all children when this entity's dirtyFlag is toggled
-    Transform worldTransform;
-    Matrix worldTransformMatrix;
+    // Mirrors the local transform in the engine's TransformHierarchy, which caches the world matrix
+    TransformNode transformNode;
 
     DirectX::BoundingBox boundingBox;
+    // World matrix version the bounding box was computed with
+    uint32_t boundingBoxVersion = 0;
 
     std::unique_ptr<PhysicsObject> physicsObject;
 
     bool castsShadows = false;
     bool shouldFrustumCull = true;
+    // Occluders must not cover more than what is drawn for them, so they are opted in from the scene description
+    OccluderType occluderType = OccluderType::NONE;
+
+    MeshLodState lodState;
 
 public:
     Entity(const Params& params = {}) noexcept;
@@ -58,10 +107,23 @@ public:
     // Must be defined in cpp for smart pointers to work
     virtual ~Entity();
 
+    // Entities come from the ENTITIES memory pools, the virtual destructor gives delete the size of the derived class
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr, size_t size) noexcept;
+
     virtual void InitPhysics();
     virtual void Update(float) noexcept;
+    // Entities touching shared state (input, game state, scene settings) outside of SceneCommandBuffer must return false
+    [[nodiscard]] virtual bool CanUpdateInParallel() const noexcept;
     virtual void Draw(DrawContext& ctx);
     virtual void PrepareShadows();
+    // Adds what hides the entities behind this one to the occluders of the frame view
+    virtual void GatherOccluders(FrameView& view);
+
+    // Must be called after modifying transform so that the hierarchy picks up the change, recorded during the parallel update
+    void MarkTransformDirty();
+    // Recorded during the parallel update, otherwise locks PhysX, which must not already be locked by this thread
+    bool SetPhysicsTransform(const Transform& t) const;
 
     [[nodiscard]] Entity* GetParent() const noexcept;
     void SetParent(Entity* pParent) noexcept;
@@ -74,7 +136,9 @@ public:
     virtual void SetRotation(const Quaternion& quat);
     virtual void SetScale(const Vector3& scale);
 
-    [[nodiscard]] const BaseMesh* GetMesh() const noexcept;
+    [[nodiscard]] MeshHandle GetMeshHandle() const noexcept;
+    // Null when the entity has no mesh or when its mesh is no longer cached
+    [[nodiscard]] BaseMesh* GetMesh() const noexcept;
     [[nodiscard]] const PhysicsObject* GetPhysicsObject() const noexcept;
     [[nodiscard]] virtual bool ShouldCastShadows() const noexcept;
     [[nodiscard]] virtual Matrix GetWorldTransformMatrix();
@@ -104,6 +168,9 @@ public:
         {
             LOG("Triggered");
         };
+
+        // Other is null when it isn't an entity
+        virtual void OnContact(Entity* /*other*/, float /*impulse*/) {}
     };
 
     std::unique_ptr<UserData> userData = std::make_unique<UserData>(this);
@@ -3,6 +3,8 @@
 #include "Firefly.h"
 
 #include "Core/WindowsEngine.h"
+#include "Core/EntityUpdate.h"
+#include "Core/Mesh/BillboardMesh.h"
 
 namespace Snail
 {
@@ -11,41 +13,57 @@ Firefly::Params::Params()
     name = "Fireflies";
 }
 
-void Firefly::Draw(DrawContext& ctx)
+void Firefly::Draw(DrawContext&)
 {
-    for (const auto& instanceTransform : instanceTransforms)
-    {
-        billboard.SetTransform(instanceTransform);
-        billboard.Draw(ctx);
-    }
+    static const MeshManager& mm = WindowsEngine::GetModule<MeshManager>();
+    BillboardMesh* mesh = mm.GetAsset(billboardMesh);
+    if (!mesh)
+        return;
+
+    particleInstances.clear();
+    particles.WriteInstances(billboardType, particleInstances);
+    mesh->SubscribeParticles(particleInstances);
 }
 
 void Firefly::Update(const float deltaTime) noexcept
 {
-    elapsedTime += deltaTime;
     InstancedEntity::Update(deltaTime);
 
+    particles.Update(deltaTime, {.hoverAmplitude = HOVER_AMPLITUDE});
+
     //update lights
-    for (int i = 0; i < instanceTransforms.size(); ++i)
+    SceneCommandBuffer* commands = SceneCommandBuffer::GetRecording();
+    particles.ForEachBoundLight([&](const int32_t light, const Vector3& position)
     {
-        Vector3 calculatedPosition = instanceTransforms[i].position;
-        calculatedPosition.y += cos(elapsedTime + billboardOffsets[i]) * 0.01f;
-        instanceTransforms[i].position = calculatedPosition;
-        lights[i]->Position = calculatedPosition;
-    }
+        if (static_cast<size_t>(light) >= lights.size())
+            return;
 
+        if (commands)
+            commands->SetLightPosition(lights[light], position);
+        else
+            WindowsEngine::GetScene()->GetLights().SetPosition(lights[light], position);
+    });
 }
 
 Firefly::Firefly(const Params& params)
     : InstancedEntity(params)
-    , billboard{params.billboard}
+    , billboardMesh{WindowsEngine::GetModule<MeshManager>().CastHandle<BillboardMesh>(params.billboard.mesh)}
+    , billboardType{params.billboard.billboardType}
     , color{params.color}
     , coefficients{params.coefficients}
 {
-    billboardOffsets.resize(instanceTransforms.size());
+    if (!billboardMesh)
+        LOGF(Logger::WARN, "Fireflies {} need a billboard mesh, they won't be drawn", entityName);
+
     for (int i = 0; i < instanceTransforms.size(); ++i)
     {
-        billboardOffsets[i] = rand() % 1000 / 1000.0f * 3.14f;
+        ParticleBuffer::Particle particle;
+        particle.position = instanceTransforms[i].position;
+        particle.size = {instanceTransforms[i].scale.x, instanceTransforms[i].scale.y};
+        particle.phase = rand() % 1000 / 1000.0f * 3.14f;
+        // Its light is added with the same index by addLights
+        particle.light = i;
+        particles.Emit(particle);
     }
 }
 
@@ -54,11 +72,8 @@ void Firefly::addLights(SceneData* sceneData)
     //add lights to the scene
     for (int i = 0; i < instanceTransforms.size(); ++i)
     {
-        instanceTransforms[i].position;
         PointLight light(instanceTransforms[i].position, color, coefficients, true);
-        sceneData->pointLights.push_back(light);
-        //size is reserved at the start of the scene, so we can have a pointer to the light
-        lights.push_back(&sceneData->pointLights[sceneData->pointLights.size() - 1]);
+        lights.push_back(sceneData->lights.AddPointLight(light));
     }
 }
 
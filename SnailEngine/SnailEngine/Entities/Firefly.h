@@ -3,15 +3,22 @@
 #include "InstancedEntity.h"
 #include "Billboard.h"
 #include "Core/SceneParser.h"
-#include "Rendering/Lights/PointLight.h"
+#include "Rendering/Lights/LightManager.h"
+#include "Rendering/Particles/ParticleBuffer.h"
 
 namespace Snail
 {
 	class D3D11Device;
+	class BillboardMesh;
 
+	// Particle emitter, one particle and one point light per instance. All the fireflies are drawn with one instanced
+	// draw of the billboard mesh.
 	class Firefly : public InstancedEntity
 	{
     public:
+        // Height of the hovering, in units
+        static constexpr float HOVER_AMPLITUDE = 0.6f;
+
         struct Params : InstancedEntity::Params
         {
             Params();
@@ -20,14 +27,19 @@ namespace Snail
             Vector3 coefficients{1, 0.045f, 0.0075f};
         };
 
-        Billboard billboard;
-        std::vector<PointLight*> lights;
-        std::vector<float> billboardOffsets;
+        AssetHandle<BillboardMesh> billboardMesh;
+        Billboard::BillboardType billboardType;
+        ParticleBuffer particles;
+        // Follow the particles bound to them
+        std::vector<LightHandle> lights;
         Vector3 color{1, 1, 1};
         Vector3 coefficients{1, 0.045f, 0.0075f};
-        float elapsedTime = 0;
 
+    private:
+        // Reused every frame
+        std::vector<ParticleInstance> particleInstances;
 
+    public:
         void Draw(DrawContext& ctx) override;
         void Update(const float deltaTime) noexcept override;
 
@@ -11,23 +11,96 @@
 namespace Snail
 {
 
-void GrassGenerator::DoDrawCall() const
+void GrassGenerator::DoDrawCall(EffectsShader& shader, const CulledBlades& blades) const
 {
     static D3D11Device* device = WindowsEngine::GetInstance().GetRenderDevice();
     InputAssembler::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     InputAssembler::SetVertexBuffer(vertexBuffer, sizeof(GrassVertex), 0);
     InputAssembler::SetIndexBuffer(indexBuffer);
-    // Could draw indirect to specify the correct amount depending on grass coverage texture
-    device->DrawIndexedInstanced(21, DispatchThreadCount[0] * DispatchThreadCount[1] * regionCount[0] * regionCount[1]);
+
+    // Instance counts are the visible blades counted by the cull shader
+    for (uint32_t lod = 0; lod < GrassRegionCulling::LOD_COUNT; ++lod)
+    {
+        shader.BindShaderResourceView("visibleBlades", blades.visibleBladesBuffers[lod].srv);
+        shader.Bind();
+        device->DrawIndexedInstancedIndirect(blades.drawArgsBuffer.internalBuffer, lod * IndirectArgsBuffer::DRAW_INDEXED_ARGS_COUNT * sizeof(UINT));
+    }
+    // The lists are written again by the next cull
+    shader.UnbindResource("visibleBlades");
+}
+
+void GrassGenerator::CreateBladeBuffers()
+{
+    static D3D11Device* device = WindowsEngine::GetInstance().GetRenderDevice();
+
+    // Instantiate with garbage, will be filled in correctly by ComputeShader
+    const UINT totalRegionsCount = regionCount[0] * regionCount[1];
+    const UINT totalBladesCount = BladeCountPerRegion * totalRegionsCount;
+    std::vector<GrassInstancedData> gid;
+    gid.resize(totalBladesCount);
+    instancedDataBuffer = StructuredBuffer(device->GetD3DDevice(), totalBladesCount, gid.data());
+
+    for (CulledBlades* blades : {&cameraBlades, &shadowBlades})
+    {
+        blades->visibleRegionsBuffer = StructuredBuffer(device->GetD3DDevice(), totalRegionsCount, static_cast<const GrassRegionCulling::RegionDraw*>(nullptr));
+        for (StructuredBuffer& visibleBlades : blades->visibleBladesBuffers)
+            visibleBlades = StructuredBuffer(device->GetD3DDevice(), totalBladesCount, static_cast<const uint32_t*>(nullptr));
+    }
+}
+
+void GrassGenerator::CullRegions(DrawContext& ctx, CulledBlades& blades)
+{
+    // Shadows keep the LODs of the camera, so that the shadows of the blades match the blades
+    const Vector3& lodCenter = ctx.renderer->GetFrameView().camera.position;
+    ID3D11DeviceContext* context = ctx.device->GetImmediateContext();
+
+    GrassRegionCulling::SelectRegions(generatedRegionCount,
+        generatedDensityScale,
+        grassPatchPosition.GetTransformationMatrix(),
+        lodCenter,
+        lodSettings,
+        [&ctx](const DirectX::BoundingBox& bounds) { return ctx.ShouldBeCulled(bounds); },
+        blades.visibleRegions);
+
+    blades.drawArgsBuffer.Reset(context);
+    if (blades.visibleRegions.empty())
+        return;
+
+    const D3D11_BOX regionsBox{0, 0, 0, static_cast<UINT>(blades.visibleRegions.size() * sizeof(GrassRegionCulling::RegionDraw)), 1, 1};
+    context->UpdateSubresource(blades.visibleRegionsBuffer.internalBuffer, 0, &regionsBox, blades.visibleRegions.data(), 0, 0);
+
+    GrassCullParams params;
+    params.groupCount = generatedRegionCount;
+    params.visibleRegionCount = static_cast<uint32_t>(blades.visibleRegions.size());
+    grassCullConstantBuffer.UpdateData(params);
+    cullGrassComputeShader->SetConstantBuffer("GrassCullParams", grassCullConstantBuffer.GetBuffer());
+
+    cullGrassComputeShader->BindSRV(0, instancedDataBuffer.srv);
+    cullGrassComputeShader->BindSRV(1, blades.visibleRegionsBuffer.srv);
+    for (uint32_t lod = 0; lod < GrassRegionCulling::LOD_COUNT; ++lod)
+        cullGrassComputeShader->BindUAV(lod, blades.visibleBladesBuffers[lod].uav);
+    cullGrassComputeShader->BindUAV(GrassRegionCulling::LOD_COUNT, blades.drawArgsBuffer.uav);
+
+    // One thread group per visible region
+    constexpr uint32_t MaxGroupCountX = D3D11_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION;
+    const uint32_t groupCount = params.visibleRegionCount;
+    cullGrassComputeShader->Bind();
+    cullGrassComputeShader->Execute(std::min(groupCount, MaxGroupCountX), (groupCount + MaxGroupCountX - 1) / MaxGroupCountX, 1);
+
+    for (uint32_t slot = 0; slot <= GrassRegionCulling::LOD_COUNT; ++slot)
+        cullGrassComputeShader->UnbindUAV(slot);
+    cullGrassComputeShader->UnbindSRV(0);
+    cullGrassComputeShader->UnbindSRV(1);
 }
 
 GrassGenerator::GrassGenerator(
     float grassDensityScale,
     std::array<uint32_t, 2> regionCount,
     Transform grassPatchPosition,
-    Texture2D* sampleTexture)
+    TextureHandle sampleTexture)
     : grassComputeConstantBuffer(D3D11Buffer::CreateConstantBuffer<GrassComputeParams>())
     , grassEffectsConstantBuffer(D3D11Buffer::CreateConstantBuffer<GrassEffectsParams>())
+    , grassCullConstantBuffer(D3D11Buffer::CreateConstantBuffer<GrassCullParams>())
     , indexBuffer(D3D11_BIND_INDEX_BUFFER)
     , vertexBuffer(D3D11_BIND_VERTEX_BUFFER)
     , sampleTexture(sampleTexture)
@@ -36,11 +109,20 @@ GrassGenerator::GrassGenerator(
     , grassDensityScale(grassDensityScale)
 {
     static D3D11Device* device = WindowsEngine::GetInstance().GetRenderDevice();
+    static TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
 
-    // Instantiate with garbage, will be filled in correctly by ComputeShader
-    std::vector<GrassInstancedData> gid;
-    gid.resize(BladeCountPerRegion * regionCount[0] * regionCount[1]);
-    instancedDataBuffer = StructuredBuffer(device->GetD3DDevice(), BladeCountPerRegion * regionCount[0] * regionCount[1], gid.data());
+    if (sampleTexture.IsValid())
+        textureManager.AddReference(sampleTexture);
+
+    CreateBladeBuffers();
+
+    // Lod 0 and lod 1 draw args, the instance counts are filled in by the cull shader
+    constexpr std::array<UINT, IndirectArgsBuffer::DRAW_INDEXED_ARGS_COUNT * GrassRegionCulling::LOD_COUNT> drawArgs = {
+    IndexCountPerLod[0], 0, 0, 0, 0,
+    IndexCountPerLod[1], 0, IndexCountPerLod[0], 0, 0,
+    };
+    cameraBlades.drawArgsBuffer = IndirectArgsBuffer(device->GetD3DDevice(), drawArgs);
+    shadowBlades.drawArgsBuffer = IndirectArgsBuffer(device->GetD3DDevice(), drawArgs);
 
     grassEffectsShader = std::make_unique<EffectsShader>(L"SnailEngine/Shaders/Grass/GrassPass.fx", GrassVertex::layout, GrassVertex::elementCount);
     grassShadowsEffectsShader = std::make_unique<EffectsShader>(L"SnailEngine/Shaders/Grass/GrassPassShadows.fx",
@@ -48,7 +130,8 @@ GrassGenerator::GrassGenerator(
         GrassVertex::elementCount);
 
     generateGrassInstanceDataComputeShader = std::make_unique<ComputeShader>(L"SnailEngine/Shaders/Grass/GrassGeneration.cs.hlsl",
-        sampleTexture ? std::unordered_set<std::string>{"SAMPLE_GRASS"} : std::unordered_set<std::string>{});
+        sampleTexture.IsValid() ? std::unordered_set<std::string>{"SAMPLE_GRASS"} : std::unordered_set<std::string>{});
+    cullGrassComputeShader = std::make_unique<ComputeShader>(L"SnailEngine/Shaders/Grass/GrassCulling.cs.hlsl");
     GenerateInstanceData();
 
     // Our blade of grass, we declare it here to avoid IO costs for such a small .obj
@@ -56,7 +139,11 @@ GrassGenerator::GrassGenerator(
     GrassVertex{{-0.25f, 0.0f, 0.0f}}, GrassVertex{{0.25f, 0.0f, 0.0f}}, GrassVertex{{-0.1875f, 0.5f, 0.0f}}, GrassVertex{{0.1875f, 0.5f, 0.0f}},
     GrassVertex{{-0.125f, 1.0f, 0.0f}}, GrassVertex{{0.125f, 1.0f, 0.0f}}, GrassVertex{{-0.0625f, 1.5f, 0.0f}}, GrassVertex{{0.0625f, 1.5f, 0.0f}},
     GrassVertex{{0.0f, 2.0f, 0.0f}},
+    // Lod blade
+    GrassVertex{{-0.25f, 0.0f, 0.0f}}, GrassVertex{{0.25f, 0.0f, 0.0f}}, GrassVertex{{-0.125f, 1.0f, 0.0f}}, GrassVertex{{0.125f, 1.0f, 0.0f}},
+    GrassVertex{{0.0f, 2.0f, 0.0f}},
     };
+    static_assert(vertices.size() == VerticesPerGrassBladeCount + VerticesPerLodGrassBladeCount);
     // Generate uvs
     for (auto& [position, uv] : vertices)
     {
@@ -66,13 +153,19 @@ GrassGenerator::GrassGenerator(
 
     vertexBuffer.UpdateData(vertices);
 
-    constexpr std::array indices = {0, 1, 2, 1, 3, 2, 2, 3, 4, 3, 5, 4, 4, 5, 6, 5, 7, 6, 6, 7, 8};
+    constexpr std::array indices = {0, 1, 2, 1, 3, 2, 2, 3, 4, 3, 5, 4, 4, 5, 6, 5, 7, 6, 6, 7, 8, 9, 10, 11, 10, 12, 11, 11, 12, 13};
+    static_assert(indices.size() == IndexCountPerLod[0] + IndexCountPerLod[1]);
 
     indexBuffer.UpdateData(indices);
 }
 
 GrassGenerator::~GrassGenerator()
-{}
+{
+    static TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
+
+    if (sampleTexture.IsValid())
+        textureManager.RemoveReference(sampleTexture);
+}
 
 void GrassGenerator::Update(const float dt)
 {
@@ -81,14 +174,15 @@ void GrassGenerator::Update(const float dt)
 
 void GrassGenerator::UpdateGrassBuffer()
 {
-    const Camera* cam = WindowsEngine::GetCamera();
+    static auto& renderer = WindowsEngine::GetModule<RendererModule>();
+    const FrameView::CameraView& camera = renderer.GetFrameView().camera;
 
     GrassEffectsParams grassEffectsParams;
-    grassEffectsParams.matWorldViewProj = (grassPatchPosition.GetTransformationMatrix() * cam->GetViewProjectionMatrix()).
+    grassEffectsParams.matWorldViewProj = (grassPatchPosition.GetTransformationMatrix() * camera.viewProjection).
     Transpose();
     grassEffectsParams.matWorld = grassPatchPosition.GetTransformationMatrix().Transpose();
-    grassEffectsParams.matView = cam->GetViewMatrix().Transpose();
-    grassEffectsParams.matViewInv = cam->GetViewMatrix().Invert();
+    grassEffectsParams.matView = camera.view.Transpose();
+    grassEffectsParams.matViewInv = camera.invView;
     grassEffectsParams.time = totalTime;
     grassEffectsConstantBuffer.UpdateData(grassEffectsParams);
 }
@@ -96,39 +190,42 @@ void GrassGenerator::UpdateGrassBuffer()
 void GrassGenerator::Draw(DrawContext& ctx)
 {
     if (ctx.ShouldBeCulled(GetBoundingBox()))
+    {
+        cameraBlades.visibleRegions.clear();
+        cameraBlades.drawArgsBuffer.Reset(ctx.device->GetImmediateContext());
         return;
+    }
 
 #ifdef _IMGUI_
     if (liveRegenerateGrassInstanceData)
     {
-        // Instantiate with garbage, will be filled in correctly by ComputeShader
-        std::vector<GrassInstancedData> gid;
-        gid.resize(BladeCountPerRegion * regionCount[0] * regionCount[1]);
-        instancedDataBuffer = StructuredBuffer(ctx.device->GetD3DDevice(), BladeCountPerRegion * regionCount[0] * regionCount[1], gid.data());
-
+        CreateBladeBuffers();
         GenerateInstanceData();
     }
 #endif
 
+    CullRegions(ctx, cameraBlades);
+
     // Bind Grass Instanced data
     grassEffectsShader->BindShaderResourceView("grassInstanceData", instancedDataBuffer.srv);
     UpdateGrassBuffer();
     grassEffectsShader->SetConstantBuffer("GrassParams", grassEffectsConstantBuffer.GetBuffer());
-    grassEffectsShader->Bind();
 
-    DoDrawCall();
+    DoDrawCall(*grassEffectsShader, cameraBlades);
 }
 
-void GrassGenerator::DrawShadows(D3D11Buffer& lightMatrixBuffer)
+void GrassGenerator::DrawShadows(DrawContext& ctx, D3D11Buffer& lightMatrixBuffer)
 {
+    CullRegions(ctx, shadowBlades);
+    if (shadowBlades.visibleRegions.empty())
+        return;
+
     UpdateGrassBuffer();
     grassShadowsEffectsShader->BindShaderResourceView("grassInstanceData", instancedDataBuffer.srv);
     grassShadowsEffectsShader->SetConstantBuffer("GrassParams", grassEffectsConstantBuffer.GetBuffer());
     grassShadowsEffectsShader->SetConstantBuffer("TransformMatrixes", lightMatrixBuffer.GetBuffer());
 
-    grassShadowsEffectsShader->Bind();
-
-    DoDrawCall();
+    DoDrawCall(*grassShadowsEffectsShader, shadowBlades);
 }
 
 void GrassGenerator::GenerateInstanceData()
@@ -142,12 +239,16 @@ void GrassGenerator::GenerateInstanceData()
     grassComputeConstantBuffer.UpdateData(params);
     generateGrassInstanceDataComputeShader->SetConstantBuffer("GrassParams", grassComputeConstantBuffer.GetBuffer());
 
-    if (sampleTexture)
-        generateGrassInstanceDataComputeShader->BindSRVAndSampler(0, sampleTexture->GetShaderResourceView(), sampleTexture->GetSamplerState());
+    static TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
+    if (const Texture2D* texture = textureManager.GetAsset(sampleTexture))
+        generateGrassInstanceDataComputeShader->BindSRVAndSampler(0, texture->GetShaderResourceView(), texture->GetSamplerState());
 
     generateGrassInstanceDataComputeShader->Bind();
     generateGrassInstanceDataComputeShader->Execute(regionCount[0], regionCount[1], 1);
     generateGrassInstanceDataComputeShader->Unbind();
+
+    generatedRegionCount = regionCount;
+    generatedDensityScale = grassDensityScale;
 }
 
 DirectX::BoundingOrientedBox GrassGenerator::GetBoundingBox() const
@@ -182,14 +283,16 @@ void GrassGenerator::ReloadShaders()
 
     generateGrassInstanceDataComputeShader->Unbind();
 
-    // Instantiate with garbage, will be filled in correctly by ComputeShader
-    std::vector<GrassInstancedData> gid{};
-    const int totalBladesCount = BladeCountPerRegion * regionCount[0] * regionCount[1];
-    gid.resize(totalBladesCount);
-    instancedDataBuffer = StructuredBuffer(device->GetD3DDevice(), totalBladesCount, gid.data());
+    CreateBladeBuffers();
+    for (CulledBlades* blades : {&cameraBlades, &shadowBlades})
+    {
+        blades->visibleRegions.clear();
+        blades->drawArgsBuffer.Reset(device->GetImmediateContext());
+    }
 
     generateGrassInstanceDataComputeShader.reset(new ComputeShader(L"SnailEngine/Shaders/Grass/GrassGeneration.cs.hlsl",
-        sampleTexture ? std::unordered_set<std::string>{"SAMPLE_GRASS"} : std::unordered_set<std::string>{}));
+        sampleTexture.IsValid() ? std::unordered_set<std::string>{"SAMPLE_GRASS"} : std::unordered_set<std::string>{}));
+    cullGrassComputeShader.reset(new ComputeShader(L"SnailEngine/Shaders/Grass/GrassCulling.cs.hlsl"));
     GenerateInstanceData();
     grassEffectsShader->ReloadShader();
     grassShadowsEffectsShader->ReloadShader();
@@ -213,6 +316,27 @@ void GrassGenerator::RenderImGui()
         ImGui::Text((std::string("Total Number of Grass Blades: ") + std::to_string(BladeCountPerRegion * regionCount[0] * regionCount[1])).c_str());
     }
     ImGui::PopID();
+    ImGui::PushID("GrassLods");
+    {
+        ImGui::SeparatorText("Region Culling");
+        ImGui::DragFloat("Full Detail Distance", &lodSettings.fullDetailDistance, 1, 0, lodSettings.maxDistance);
+        ImGui::DragFloat("Thinning Start Distance", &lodSettings.thinningStartDistance, 1, 0, lodSettings.maxDistance);
+        ImGui::DragFloat("Max Distance", &lodSettings.maxDistance, 1, 0, 2000);
+        ImGui::SliderFloat("Min Kept Blades", &lodSettings.minKeepFraction, 0, 1);
+
+        // Upper bound of what the GPU draws, blades outside of the coverage texture are dropped there
+        std::array<size_t, GrassRegionCulling::LOD_COUNT> regionCounts{};
+        std::array<float, GrassRegionCulling::LOD_COUNT> bladeCounts{};
+        for (const GrassRegionCulling::RegionDraw& region : cameraBlades.visibleRegions)
+        {
+            ++regionCounts[region.lod];
+            bladeCounts[region.lod] += region.keepFraction * BladeCountPerRegion;
+        }
+        ImGui::Text("Visible Regions: %zu / %u", cameraBlades.visibleRegions.size(), generatedRegionCount[0] * generatedRegionCount[1]);
+        for (uint32_t lod = 0; lod < GrassRegionCulling::LOD_COUNT; ++lod)
+            ImGui::Text("Lod %u: %zu regions, ~%.0f blades", lod, regionCounts[lod], bladeCounts[lod]);
+    }
+    ImGui::PopID();
     ImGui::PushID("ChunkPosition");
     {
         ImGui::SeparatorText("Chunk Position");
@@ -2,7 +2,10 @@
 
 #include <memory>
 
+#include "GrassRegionCulling.h"
+#include "Core/Assets/AssetHandle.h"
 #include "Rendering/Texture2D.h"
+#include "Rendering/Buffers/IndirectArgsBuffer.h"
 #include "Rendering/Buffers/StructuredBuffer.h"
 #include "Rendering/Shaders/ComputeShader.h"
 #include "Rendering/Shaders/EffectsShader.h"
@@ -15,6 +18,9 @@ class DrawContext;
 class GrassGenerator
 {
     constexpr static int VerticesPerGrassBladeCount = 9;
+    // Distant regions use a 5 vertex blade, drawn from the end of the same vertex and index buffers
+    constexpr static int VerticesPerLodGrassBladeCount = 5;
+    constexpr static std::array<UINT, GrassRegionCulling::LOD_COUNT> IndexCountPerLod = {21, 9};
     // This is hard coded as compute shaders should avoid using more than 8x8
     constexpr static int BladeCountPerRegion = 64;
     constexpr static std::array<uint32_t, 2> DispatchThreadCount = {8, 8};
@@ -57,40 +63,71 @@ class GrassGenerator
         DX_ALIGN float time;
     };
 
+    struct GrassCullParams
+    {
+        DX_ALIGN std::array<uint32_t, 2> groupCount;
+        uint32_t visibleRegionCount;
+    };
+
     D3D11Buffer grassComputeConstantBuffer;
     D3D11Buffer grassEffectsConstantBuffer;
+    D3D11Buffer grassCullConstantBuffer;
 
     D3D11Buffer indexBuffer;
     D3D11Buffer vertexBuffer;
 
     StructuredBuffer instancedDataBuffer;
 
+    // Blades of the patch visible from one view, filled by the cull shader from the regions selected on the CPU
+    struct CulledBlades
+    {
+        std::vector<GrassRegionCulling::RegionDraw> visibleRegions;
+        StructuredBuffer visibleRegionsBuffer;
+        std::array<StructuredBuffer, GrassRegionCulling::LOD_COUNT> visibleBladesBuffers;
+        IndirectArgsBuffer drawArgsBuffer;
+    };
+
+    CulledBlades cameraBlades;
+    // Culled again before each cascade is drawn, the cascades are drawn one after the other
+    CulledBlades shadowBlades;
+
     std::unique_ptr<ComputeShader> generateGrassInstanceDataComputeShader;
+    std::unique_ptr<ComputeShader> cullGrassComputeShader;
     std::unique_ptr<EffectsShader> grassEffectsShader;
     std::unique_ptr<EffectsShader> grassShadowsEffectsShader;
 
-    Texture2D* sampleTexture = nullptr;
+    // Referenced for as long as the patch exists, it can be sampled again whenever the instance data is regenerated
+    TextureHandle sampleTexture;
 
     std::array<uint32_t, 2> regionCount = {8, 8};
 
     Transform grassPatchPosition;
     float grassDensityScale;
 
+    // What the instance data was generated with, the ImGui values only apply once it is regenerated
+    std::array<uint32_t, 2> generatedRegionCount = {};
+    float generatedDensityScale = 0;
+
+    GrassRegionCulling::LodSettings lodSettings;
+
     float totalTime = 0;
 
 #ifdef _IMGUI_
     bool liveRegenerateGrassInstanceData = false;
 #endif
 
-    void DoDrawCall() const;
+    void CreateBladeBuffers();
+    void CullRegions(DrawContext& ctx, CulledBlades& blades);
+    void DoDrawCall(EffectsShader& shader, const CulledBlades& blades) const;
 
 public:
-    GrassGenerator(float grassDensityScale, std::array<uint32_t, 2> regionCount, Transform grassPatchPosition, Texture2D* sampleTexture);
+    GrassGenerator(float grassDensityScale, std::array<uint32_t, 2> regionCount, Transform grassPatchPosition, TextureHandle sampleTexture);
     ~GrassGenerator();
     void Update(float dt);
     void UpdateGrassBuffer();
     void Draw(DrawContext& ctx);
-    void DrawShadows(D3D11Buffer& lightMatrixBuffer);
+    // Culls the blades against the cascade of the context before drawing them
+    void DrawShadows(DrawContext& ctx, D3D11Buffer& lightMatrixBuffer);
 
     void GenerateInstanceData();
 
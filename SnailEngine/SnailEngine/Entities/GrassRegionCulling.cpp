@@ -0,0 +1,156 @@
+#include "stdafx.h"
+#include "GrassRegionCulling.h"
+
+#include <bit>
+
+namespace Snail
+{
+
+namespace
+{
+
+// murmurHash42 and Hash42 of Noise.hlsl
+std::array<float, 4> Hash42(const float x, const float y) noexcept
+{
+    constexpr uint32_t M = 0x5bd1e995u;
+    std::array<uint32_t, 4> h = {1190494759u, 2147483647u, 3559788179u, 179424673u};
+    std::array src = {std::bit_cast<uint32_t>(x), std::bit_cast<uint32_t>(y)};
+    for (uint32_t& s : src)
+    {
+        s *= M;
+        s ^= s >> 24u;
+        s *= M;
+    }
+
+    std::array<float, 4> hash{};
+    for (size_t i = 0; i < h.size(); ++i)
+    {
+        h[i] *= M;
+        h[i] ^= src[0];
+        h[i] *= M;
+        h[i] ^= src[1];
+        h[i] ^= h[i] >> 13u;
+        h[i] *= M;
+        h[i] ^= h[i] >> 15u;
+        hash[i] = std::bit_cast<float>(h[i] & 0x007fffffu | 0x3f800000u) - 1.0f;
+    }
+    return hash;
+}
+
+}
+
+GrassRegionCulling::Blade GrassRegionCulling::PlaceBlade(const uint32_t x, const uint32_t y, const float densityScale) noexcept
+{
+    const float positionX = static_cast<float>(x) * densityScale;
+    const float positionZ = static_cast<float>(y) * densityScale;
+    const std::array hash = Hash42(positionX, positionZ);
+
+    // The blade mesh is 2 units tall before its random height
+    Blade blade;
+    blade.position = Vector3(positionX + hash[0] + hash[1], 0, positionZ + hash[2] + hash[3]);
+    blade.height = 2.0f * (0.85f + hash[2] * 0.25f);
+    return blade;
+}
+
+float GrassRegionCulling::GetThinningValue(const uint32_t bladeIndex) noexcept
+{
+    // Wang hash, cheap and well spread over consecutive indices
+    uint32_t h = (bladeIndex ^ 61u) ^ (bladeIndex >> 16u);
+    h *= 9u;
+    h ^= h >> 4u;
+    h *= 0x27d4eb2du;
+    h ^= h >> 15u;
+    return static_cast<float>(h & 0xffffffu) / 16777216.0f;
+}
+
+DirectX::BoundingBox GrassRegionCulling::GetBladeBounds(const Blade& blade) noexcept
+{
+    // Blades bend and turn around their base, their tip stays within their height of it
+    return DirectX::BoundingBox(blade.position + Vector3(0, blade.height / 2, 0), Vector3(blade.height, blade.height / 2, blade.height));
+}
+
+float GrassRegionCulling::GetClosestDistance(const DirectX::BoundingBox& box, const Vector3& point) noexcept
+{
+    const Vector3 center = box.Center;
+    const Vector3 extents = box.Extents;
+    const Vector3 closest = Vector3::Clamp(point, center - extents, center + extents);
+    return Vector3::Distance(closest, point);
+}
+
+uint32_t GrassRegionCulling::GetBladeIndex(const uint32_t regionIndex, const uint32_t bladeInRegion, const std::array<uint32_t, 2>& regionCount) noexcept
+{
+    const uint32_t x = regionIndex % regionCount[0] * REGION_SIZE + bladeInRegion % REGION_SIZE;
+    const uint32_t y = regionIndex / regionCount[0] * REGION_SIZE + bladeInRegion / REGION_SIZE;
+    return x + y * regionCount[0] * REGION_SIZE;
+}
+
+DirectX::BoundingBox GrassRegionCulling::GetRegionBounds(const uint32_t regionX, const uint32_t regionY, const float densityScale) noexcept
+{
+    const float regionSize = static_cast<float>(REGION_SIZE - 1) * densityScale;
+    const Vector3 min = Vector3(static_cast<float>(regionX * REGION_SIZE) * densityScale, 0, static_cast<float>(regionY * REGION_SIZE) * densityScale)
+        - Vector3(MAX_BLADE_EXTENT, 0, MAX_BLADE_EXTENT);
+    const Vector3 max = min + Vector3(regionSize + MAX_BLADE_OFFSET + 2 * MAX_BLADE_EXTENT, MAX_BLADE_EXTENT, regionSize + MAX_BLADE_OFFSET + 2 * MAX_BLADE_EXTENT);
+
+    DirectX::BoundingBox bounds;
+    DirectX::BoundingBox::CreateFromPoints(bounds, min, max);
+    return bounds;
+}
+
+void GrassRegionCulling::SelectRegions(const std::array<uint32_t, 2>& regionCount,
+    const float densityScale,
+    const Matrix& patchWorld,
+    const Vector3& viewPosition,
+    const LodSettings& settings,
+    const std::function<bool(const DirectX::BoundingBox&)>& isCulled,
+    std::vector<RegionDraw>& regions)
+{
+    regions.clear();
+    for (uint32_t y = 0; y < regionCount[1]; ++y)
+    {
+        for (uint32_t x = 0; x < regionCount[0]; ++x)
+        {
+            DirectX::BoundingBox worldBounds;
+            GetRegionBounds(x, y, densityScale).Transform(worldBounds, patchWorld);
+
+            const float distance = GetClosestDistance(worldBounds, viewPosition);
+            if (distance > settings.maxDistance || isCulled(worldBounds))
+                continue;
+
+            RegionDraw region;
+            region.regionIndex = x + y * regionCount[0];
+            region.lod = distance < settings.fullDetailDistance ? 0 : 1;
+            region.keepFraction = 1;
+            if (distance > settings.thinningStartDistance)
+            {
+                const float t = (distance - settings.thinningStartDistance) / std::max(settings.maxDistance - settings.thinningStartDistance, 1e-3f);
+                region.keepFraction = std::lerp(1.0f, settings.minKeepFraction, std::min(t, 1.0f));
+            }
+            regions.push_back(region);
+        }
+    }
+}
+
+void GrassRegionCulling::CompactBlades(const std::array<uint32_t, 2>& regionCount,
+    const float densityScale,
+    const std::vector<RegionDraw>& regions,
+    std::array<std::vector<uint32_t>, LOD_COUNT>& visibleBlades)
+{
+    for (std::vector<uint32_t>& blades : visibleBlades)
+        blades.clear();
+
+    const uint32_t bladesPerRow = regionCount[0] * REGION_SIZE;
+    for (const RegionDraw& region : regions)
+    {
+        for (uint32_t i = 0; i < BLADES_PER_REGION; ++i)
+        {
+            const uint32_t bladeIndex = GetBladeIndex(region.regionIndex, i, regionCount);
+            const Blade blade = PlaceBlade(bladeIndex % bladesPerRow, bladeIndex / bladesPerRow, densityScale);
+            if (blade.height == 0 || GetThinningValue(bladeIndex) >= region.keepFraction)
+                continue;
+
+            visibleBlades[region.lod].push_back(bladeIndex);
+        }
+    }
+}
+
+}
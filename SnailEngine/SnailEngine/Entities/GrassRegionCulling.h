@@ -0,0 +1,73 @@
+#pragma once
+#include <array>
+#include <functional>
+#include <vector>
+
+namespace Snail
+{
+
+// CPU side of the grass culling: picks the visible 8x8 blade regions of a patch and their LOD,
+// and mirrors the placement and thinning done on the GPU so that both can be checked against each other.
+class GrassRegionCulling
+{
+public:
+    // Blades of a region are generated by one 8x8 thread group
+    static constexpr uint32_t REGION_SIZE = 8;
+    static constexpr uint32_t BLADES_PER_REGION = REGION_SIZE * REGION_SIZE;
+    static constexpr uint32_t LOD_COUNT = 2;
+    // Blades are offset by up to 2 units from their grid cell and are at most 2 * 1.10 units tall, in patch space
+    static constexpr float MAX_BLADE_OFFSET = 2.0f;
+    static constexpr float MAX_BLADE_EXTENT = 2.2f;
+
+    struct LodSettings
+    {
+        // Regions closer than this use the full blade
+        float fullDetailDistance = 50;
+        // Past this distance regions keep fewer and fewer blades, down to minKeepFraction at maxDistance
+        float thinningStartDistance = 150;
+        float maxDistance = 400;
+        float minKeepFraction = 0.25f;
+    };
+
+    // Must match GrassRegionDraw in GrassCulling.cs.hlsl
+    struct RegionDraw
+    {
+        uint32_t regionIndex;
+        uint32_t lod;
+        float keepFraction;
+    };
+
+    struct Blade
+    {
+        Vector3 position;
+        float height;
+    };
+
+    // Same placement as GrassGeneration.cs.hlsl, without the coverage texture
+    static Blade PlaceBlade(uint32_t x, uint32_t y, float densityScale) noexcept;
+    // Same as GetThinningValue in GrassDef.hlsli, blades are kept while it is below the keep fraction of their region
+    static float GetThinningValue(uint32_t bladeIndex) noexcept;
+    // Bounds of a blade in patch space
+    static DirectX::BoundingBox GetBladeBounds(const Blade& blade) noexcept;
+    static float GetClosestDistance(const DirectX::BoundingBox& box, const Vector3& point) noexcept;
+    static uint32_t GetBladeIndex(uint32_t regionIndex, uint32_t bladeInRegion, const std::array<uint32_t, 2>& regionCount) noexcept;
+
+    // Bounds of every blade of the region in patch space
+    static DirectX::BoundingBox GetRegionBounds(uint32_t regionX, uint32_t regionY, float densityScale) noexcept;
+
+    static void SelectRegions(const std::array<uint32_t, 2>& regionCount,
+        float densityScale,
+        const Matrix& patchWorld,
+        const Vector3& viewPosition,
+        const LodSettings& settings,
+        const std::function<bool(const DirectX::BoundingBox&)>& isCulled,
+        std::vector<RegionDraw>& regions);
+
+    // What GrassCulling.cs.hlsl writes to the visible blade lists, in no particular order on the GPU
+    static void CompactBlades(const std::array<uint32_t, 2>& regionCount,
+        float densityScale,
+        const std::vector<RegionDraw>& regions,
+        std::array<std::vector<uint32_t>, LOD_COUNT>& visibleBlades);
+};
+
+}
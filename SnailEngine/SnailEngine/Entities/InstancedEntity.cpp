@@ -22,10 +22,12 @@ InstancedEntity::InstancedEntity(const Params& params)
 
 void InstancedEntity::Draw(DrawContext& ctx)
 {
+    BaseMesh* mesh = GetMesh();
     if (!mesh)
         return;
 
     const DirectX::BoundingBox baseBoundingBox = GetBoundingBox();
+    instanceLodStates.resize(instanceTransforms.size());
 
     for (int i = 0; i < instanceTransforms.size(); ++i)
     {
@@ -42,7 +44,8 @@ void InstancedEntity::Draw(DrawContext& ctx)
         if (ctx.ShouldBeCulled(instanceBoundingBox))
             continue;
 
-        mesh->SubscribeInstance(modelMatrix);
+        ctx.RequestTextureDetail(*mesh, instanceBoundingBox, modelMatrix);
+        mesh->SubscribeInstance(modelMatrix, ctx.SelectLod(*mesh, instanceBoundingBox, instanceLodStates[i]));
     }
 }
 
@@ -19,6 +19,8 @@ public:
 #endif
 
     std::vector<Transform> instanceTransforms;
+    // Follows instanceTransforms, instances can be added from the editor
+    std::vector<MeshLodState> instanceLodStates;
 
     InstancedEntity(const Params&);
 
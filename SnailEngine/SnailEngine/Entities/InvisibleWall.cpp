@@ -11,7 +11,7 @@ InvisibleWall::InvisibleWall(const Params& params)
 {
 #ifdef _DEBUG // Show boxes in debug
     static auto& mm = WindowsEngine::GetModule<MeshManager>();
-    mesh = mm.GetAsset<BaseMesh>("Cube");
+    meshHandle = mm.GetHandle<BaseMesh>("Cube");
     castsShadows = false;
 #endif
 }
@@ -21,6 +21,7 @@ void InvisibleWall::InitPhysics()
     static PhysicsModule& physModule = WindowsEngine::GetModule<PhysicsModule>();
     PhysXUniquePtr<PxShape> shape;
     shape.reset(physModule.physics->createShape(PxBoxGeometry{ transform.scale.x / 2, transform.scale.y / 2, transform.scale.z / 2 }, *physModule.defaultMaterial));
+    physModule.collisionLayers.Apply(*shape, "wall");
     physicsObject = std::make_unique<StaticPhysicsObject>(shape.get(), transform);
 }
 
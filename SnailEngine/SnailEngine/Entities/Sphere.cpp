@@ -17,7 +17,7 @@ Sphere::Params::Params()
     static MeshManager& mm = WindowsEngine::GetModule<MeshManager>();
 
     name = "Sphere";
-    mesh = mm.GetAsset<SphereMesh>("Sphere");
+    mesh = mm.GetHandle<SphereMesh>("Sphere");
 }
 
 Sphere::Sphere(const Params& params)
@@ -9,7 +9,7 @@ using namespace physx;
 
 namespace Snail
 {
-TerrainMesh* Terrain::GenerateChunkMesh(const int chunkX, const int chunkY, const TerrainMesh* tmesh) const
+AssetHandle<TerrainMesh> Terrain::GenerateChunkMesh(const int chunkX, const int chunkY, const TerrainMesh* tmesh) const
 {
     static MeshManager& meshManager = WindowsEngine::GetModule<MeshManager>();
 
@@ -21,8 +21,9 @@ TerrainMesh* Terrain::GenerateChunkMesh(const int chunkX, const int chunkY, cons
     // Count for overlap on non-edges
     terrainMeshChunk->PopulateHeightField(width + (chunkX != chunkCount.x - 1), height + (chunkY != chunkCount.y - 1));
 
-    auto mat = tmesh->submeshes[0].GetMaterial();
-    const Image tex(mat.secondaryBlendTexture);
+    static TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
+    const TexturedMaterial& mat = tmesh->submeshes[0].GetMaterial();
+    const Image tex(textureManager.GetAssetName(mat.secondaryBlendTexture));
     
     // Add in the chunk's verts by extracting from terrainMesh
     for (uint32_t y = height * chunkY; y < height * (chunkY + 1) + (terrainMeshChunk->height - height); ++y)
@@ -76,7 +77,9 @@ TerrainMesh* Terrain::GenerateChunkMesh(const int chunkX, const int chunkY, cons
     terrainMeshChunk->SetEnableBlending(tmesh->GetBlendingEnabled());
     terrainMeshChunk->submeshes.push_back(std::move(chunkSubMesh));
 
-    return meshManager.SaveAsset<TerrainMesh>(entityName + "_chunk_" + std::to_string(chunkX * chunkCount.y + chunkY), std::move(terrainMeshChunk));
+    const std::string chunkName = entityName + "_chunk_" + std::to_string(chunkX * chunkCount.y + chunkY);
+    meshManager.SaveAsset<TerrainMesh>(chunkName, std::move(terrainMeshChunk));
+    return meshManager.GetHandle<TerrainMesh>(chunkName);
 }
 
 void Terrain::GenerateChunks(const TerrainMesh* sourceMesh)
@@ -88,8 +91,7 @@ void Terrain::GenerateChunks(const TerrainMesh* sourceMesh)
             TerrainChunk::Params chunkParam;
             chunkParam.name = sourceMesh->name + "_chunk_" + std::to_string(chunkX * chunkCount.y + chunkY);
             chunkParam.castsShadows = castsShadows;
-            auto* terrainMesh = GenerateChunkMesh(chunkX, chunkY, sourceMesh);
-            chunkParam.mesh = terrainMesh;
+            chunkParam.mesh = GenerateChunkMesh(chunkX, chunkY, sourceMesh);
 
             // Position for rendering relative to parents scale
             chunkParam.transform.position = Vector3{
@@ -117,7 +119,7 @@ void Terrain::GenerateChunks(const TerrainMesh* sourceMesh)
 Terrain::Params::Params()
 {
     name = "Terrain";
-    mesh = nullptr; // No default heightmap mesh as this not being defined is a catastrophic problem
+    mesh = {}; // No default heightmap mesh as this not being defined is a catastrophic problem
     chunkSize = Vector2::One;
 }
 
@@ -127,16 +129,17 @@ Terrain::Terrain(const Params& params)
 {
     shouldFrustumCull = false;
     // Terrain without mesh makes no sense
-    assert(mesh);
+    const auto* sourceMesh = static_cast<TerrainMesh*>(GetMesh());
+    assert(sourceMesh);
     // Shadow toggling isn't done cleanly, the renderer doesn't take into account child components when rendering.
     // Once (or if) an entity hierarchy is implemented, the castShadows of the chunks will be individually be taken into account.
     // For now I've changed each chunk to use its parent's castShadows bool and have made it toggleable in ImGui
-    GenerateChunks(reinterpret_cast<TerrainMesh*>(mesh));
+    GenerateChunks(sourceMesh);
 
     // Delete main sourceMesh now that it has been chunked
     static MeshManager& meshManager = WindowsEngine::GetModule<MeshManager>();
-    meshManager.DeleteAsset(mesh->name);
-    mesh = nullptr;
+    meshManager.DeleteAsset(std::string{sourceMesh->name});
+    meshHandle = {};
 }
 
 void Terrain::Draw(DrawContext& ctx)
@@ -145,6 +148,12 @@ void Terrain::Draw(DrawContext& ctx)
         chunk->Draw(ctx);
 }
 
+void Terrain::GatherOccluders(FrameView& view)
+{
+    for (const auto& chunk : chunks)
+        chunk->GatherOccluders(view);
+}
+
 void Terrain::RenderImGui(const int idNumber)
 {
 #ifdef _IMGUI_
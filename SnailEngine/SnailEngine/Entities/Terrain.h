@@ -9,7 +9,7 @@ namespace Snail
 
 class Terrain : public Entity
 {
-    TerrainMesh* GenerateChunkMesh(int chunkX, int chunkY, const TerrainMesh* tmesh) const;
+    AssetHandle<TerrainMesh> GenerateChunkMesh(int chunkX, int chunkY, const TerrainMesh* tmesh) const;
     void GenerateChunks(const TerrainMesh* sourceMesh);
 public:
     std::vector<std::unique_ptr<TerrainChunk>> chunks;
@@ -24,6 +24,7 @@ public:
     Terrain(const Params& params);
 
     void Draw(DrawContext& ctx) override;
+    void GatherOccluders(FrameView& view) override;
     void RenderImGui(int idNumber) override;
 };
 
@@ -12,15 +12,19 @@ TerrainChunk::TerrainChunk(const Params& params)
     : Entity(params)
     , chunkSize{params.chunkSize}
 {
+    // Terrain is seen from above, its occluder stays under it
+    occluderType = OccluderType::MESH;
 }
 
 void TerrainChunk::InitPhysics()
 {
-    if (mesh && physicsObject == nullptr)
+    if (auto* mesh = static_cast<TerrainMesh*>(GetMesh()); mesh && physicsObject == nullptr)
     {
         Transform _worldTransform = Entity::GetWorldTransform();
-        if (auto* shape = static_cast<TerrainMesh*>(mesh)->GetPhysicsShape(chunkSize); shape)
+        if (auto* shape = mesh->GetPhysicsShape(chunkSize); shape)
         {
+            static const PhysicsModule& physicsModule = WindowsEngine::GetModule<PhysicsModule>();
+            physicsModule.collisionLayers.Apply(*shape, "terrain");
             physicsObject = std::make_unique<StaticPhysicsObject>(shape, _worldTransform);
         }
     }
@@ -25,6 +25,12 @@ void AdaptiveLightingTrigger::Update(float dt) noexcept
     else
         scene->SetVolumetricFactor(std::max(val - incrementValue * dt, lowerBound));
 }
+// Every trigger blends the same scene volumetric factor
+bool AdaptiveLightingTrigger::CanUpdateInParallel() const noexcept
+{
+    return false;
+}
+
 void AdaptiveLightingTrigger::OnTriggerEnter()
 {
     TriggerBox::OnTriggerEnter();
@@ -12,6 +12,7 @@ namespace Snail
     public:
         AdaptiveLightingTrigger(const Params& params);
         void Update(float) noexcept override;
+        bool CanUpdateInParallel() const noexcept override;
         void OnTriggerEnter() override;
         void OnTriggerExit() override;
 
@@ -22,6 +22,8 @@ void TriggerBox::InitPhysics()
     shape->setFlag(PxShapeFlag::eSIMULATION_SHAPE, false);
     shape->setFlag(PxShapeFlag::eTRIGGER_SHAPE, true);
     shape->setFlag(PxShapeFlag::eSCENE_QUERY_SHAPE, false);
+    // Only pairs with the layers the trigger layer collides with
+    physModule.collisionLayers.Apply(*shape, "trigger");
     shape->userData = static_cast<void*>(triggerUD.get());
     physicsObject = std::make_unique<StaticPhysicsObject>(shape.get(), transform);
 }
@@ -66,14 +68,4 @@ TriggerBox::TriggerUserData::TriggerUserData(TriggerBox* trigger, Entity* entity
     : UserData(entity)
     , triggerBox(trigger)
 { }
-
-void TriggerBox::TriggerUserData::OnTrigger(TriggerBox* _triggerBox)
-{
-    if (!alreadyIn)
-        _triggerBox->OnTriggerEnter();
-    else
-        _triggerBox->OnTriggerExit();
-
-    alreadyIn = !alreadyIn;
-}
 }
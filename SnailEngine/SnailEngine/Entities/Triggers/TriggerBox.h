@@ -12,11 +12,8 @@ class TriggerBox : public Entity
 public:
     struct TriggerUserData : UserData
     {
-        bool alreadyIn = false;
-
         TriggerUserData(TriggerBox* trigger, Entity* entity);
 
-        void OnTrigger(TriggerBox*) override;
         TriggerBox* triggerBox;
     };
 
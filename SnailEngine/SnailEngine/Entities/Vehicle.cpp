@@ -30,6 +30,11 @@ void Vehicle::VehicleUserData::OnTrigger(TriggerBox* triggerBox)
     LOGF("Car hit triggered \"{}\" trigger.", triggerBox->entityName);
 }
 
+void Vehicle::VehicleUserData::OnContact(Entity* other, const float impulse)
+{
+    LOGF("Car crashed into \"{}\" with an impulse of {:.0f}", other ? other->entityName : "the level", impulse);
+}
+
 bool Vehicle::IsUpsideDown()
 {
     return transform.GetUpVector().Dot(Vector3::Up) < UPSIDE_DOWN_THRESHOLD;
@@ -62,10 +67,11 @@ void Vehicle::InitPhysics()
     PhysicsVehicle* vehicle = new PhysicsVehicle(t);
     physicsVehicle = vehicle;
     vehicle->GetChassisShape()->userData = static_cast<void*>(userData.get());
+    vehicle->GetChassisShape()->getActor()->is<PxRigidDynamic>()->setContactReportThreshold(CRASH_FORCE_THRESHOLD);
     physicsObject.reset(vehicle);
 }
 
-void Vehicle::Update(const float dt) noexcept
+void Vehicle::Update(const float) noexcept
 {
     static auto& renderer = WindowsEngine::GetModule<RendererModule>();
     renderer.DrawLine({{GetWorldTransform().position}, {1, 0, 0}},
@@ -184,17 +190,21 @@ void Vehicle::Update(const float dt) noexcept
 
     if (physicsVehicle)
     {
-        if (isOnGrass)
+        if (physicsVehicle->IsOnGrass())
             physicsVehicle->SlowToSpeed(grassSpeedThreshold);
 
-        isOnGrass = false;
-        dirtyFlags.set();
-        physicsVehicle->Update(dt);
         physicsVehicle->UpdateTransform(transform, meshPhysicsOffset);
         physicsVehicle->UpdateTransformWheels(wheelTransforms, wheelMeshOffsets);
+        MarkTransformDirty();
     }
 }
 
+// Reads input and drives the camera and game state
+bool Vehicle::CanUpdateInParallel() const noexcept
+{
+    return false;
+}
+
 void Vehicle::CollectBoost()
 {
     hasBoost = true;
@@ -205,26 +215,19 @@ bool Vehicle::HasBoost()
     return hasBoost;
 }
 
-void Vehicle::SetOnGrass(const bool onGrass)
-{
-    isOnGrass = onGrass;
-}
-
 void Vehicle::SetTransform(const Transform& t)
 {
-    dirtyFlags.set();
-
     if (!physicsVehicle)
     {
         transform = t;
-        return;
     }
-
-    if (physicsVehicle->SetTransform(t))
+    else if (physicsVehicle->SetTransform(t))
     {
         transform = t;
         transform.position += meshPhysicsOffset;
     }
+
+    MarkTransformDirty();
 }
 
 void Vehicle::Draw(DrawContext& ctx)
@@ -241,24 +244,20 @@ void Vehicle::Draw(DrawContext& ctx)
 
 void Vehicle::SetPosition(const Vector3& pos)
 {
-    dirtyFlags.set();
-
-    if (!physicsVehicle)
+    Transform newTransform = transform;
+    newTransform.position = pos;
+    if (!physicsVehicle || physicsVehicle->SetTransform(newTransform))
     {
         transform.position = pos;
-        return;
+        MarkTransformDirty();
     }
-
-    Transform newTransform = transform;
-    newTransform.position = pos;
-    if (physicsVehicle->SetTransform(newTransform)) { transform.position = pos; }
 }
 
 void Vehicle::SetRotation(const Vector3& euler)
 {
-    dirtyFlags.set();
     transform.rotation = Quaternion::CreateFromYawPitchRoll(euler);
     if (physicsVehicle) { physicsVehicle->SetTransform(transform); }
+    MarkTransformDirty();
 }
 
 void Vehicle::RenderImGui(const int idNumber)
@@ -14,6 +14,7 @@ namespace Snail {
         {
             VehicleUserData(Entity* entity);
             void OnTrigger(TriggerBox*) override;
+            void OnContact(Entity* other, float impulse) override;
         };
 
         std::array<BaseMesh*, 4> wheelMeshes;
@@ -23,12 +24,13 @@ namespace Snail {
         PhysicsVehicle* physicsVehicle = nullptr;
         Vector3 meshPhysicsOffset;
         bool hasBoost = false;
-        bool isOnGrass = false;
         float grassBreakingFactor = 1;
         float grassSpeedThreshold = 10;
         float boostIntensity = 40000;
 
         static constexpr float UPSIDE_DOWN_THRESHOLD = 0.3f;
+        // Contact force above which the chassis reports a crash
+        static constexpr float CRASH_FORCE_THRESHOLD = 150000.0f;
         bool IsUpsideDown();
         void FlipCar();
         float GetForwardVelocity();
@@ -49,12 +51,11 @@ namespace Snail {
 
         void InitPhysics() override;
         void Update(float) noexcept override;
+        bool CanUpdateInParallel() const noexcept override;
         void Draw(DrawContext& ctx) override;
         void CollectBoost();
         bool HasBoost();
 
-        void SetOnGrass(bool onGrass);
-
         void SetTransform(const Transform& t) override;
         void SetPosition(const Vector3& pos) override;
         void SetRotation(const Vector3& euler) override;
@@ -0,0 +1,59 @@
+#include "stdafx.h"
+
+#include "IndirectArgsBuffer.h"
+
+namespace Snail
+{
+
+IndirectArgsBuffer::IndirectArgsBuffer(ID3D11Device* pd3dDevice, const std::span<const UINT> args)
+    : initialArgs{args.begin(), args.end()}
+{
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.ByteWidth = static_cast<UINT>(initialArgs.size() * sizeof(UINT));
+    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    bufferDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+    bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+
+    D3D11_SUBRESOURCE_DATA bufferInitData = {};
+    bufferInitData.pSysMem = initialArgs.data();
+    DX_CALL(pd3dDevice->CreateBuffer(&bufferDesc, &bufferInitData, &internalBuffer), "Error creating indirect args buffer.");
+
+    // Raw view so that shaders can InterlockedAdd into the instance counts
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.NumElements = static_cast<UINT>(initialArgs.size());
+    uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+    DX_CALL(pd3dDevice->CreateUnorderedAccessView(internalBuffer, &uavDesc, &uav), "Error creating UAV of indirect args buffer.");
+}
+
+IndirectArgsBuffer::IndirectArgsBuffer(IndirectArgsBuffer&& buffer) noexcept
+    : internalBuffer{std::exchange(buffer.internalBuffer, nullptr)}
+    , uav{std::exchange(buffer.uav, nullptr)}
+    , initialArgs{std::move(buffer.initialArgs)} {}
+
+IndirectArgsBuffer& IndirectArgsBuffer::operator=(IndirectArgsBuffer&& buffer) noexcept
+{
+    IndirectArgsBuffer{std::move(buffer)}.Swap(*this);
+    return *this;
+}
+
+IndirectArgsBuffer::~IndirectArgsBuffer()
+{
+    DX_RELEASE(uav);
+    DX_RELEASE(internalBuffer);
+}
+
+void IndirectArgsBuffer::Reset(ID3D11DeviceContext* context) const
+{
+    context->UpdateSubresource(internalBuffer, 0, nullptr, initialArgs.data(), 0, 0);
+}
+
+void IndirectArgsBuffer::Swap(IndirectArgsBuffer& buf) noexcept
+{
+    std::swap(internalBuffer, buf.internalBuffer);
+    std::swap(uav, buf.uav);
+    std::swap(initialArgs, buf.initialArgs);
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <span>
+#include <vector>
+
+#include "Util/Util.h"
+
+namespace Snail
+{
+
+// Arguments of DrawIndexedInstancedIndirect, written by compute shaders through a raw UAV
+struct IndirectArgsBuffer
+{
+    // IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation
+    static constexpr UINT DRAW_INDEXED_ARGS_COUNT = 5;
+    static constexpr UINT INSTANCE_COUNT_OFFSET = sizeof(UINT);
+
+    ID3D11Buffer* internalBuffer = nullptr;
+    ID3D11UnorderedAccessView* uav = nullptr;
+    std::vector<UINT> initialArgs;
+
+    IndirectArgsBuffer() = default;
+    IndirectArgsBuffer(ID3D11Device* pd3dDevice, std::span<const UINT> args);
+
+    IndirectArgsBuffer(const IndirectArgsBuffer&) = delete;
+    IndirectArgsBuffer& operator=(const IndirectArgsBuffer&) = delete;
+
+    IndirectArgsBuffer(IndirectArgsBuffer&& buffer) noexcept;
+    IndirectArgsBuffer& operator=(IndirectArgsBuffer&& buffer) noexcept;
+
+    ~IndirectArgsBuffer();
+
+    // Restores the arguments the buffer was created with, before compute shaders accumulate into them again
+    void Reset(ID3D11DeviceContext* context) const;
+    void Swap(IndirectArgsBuffer& buf) noexcept;
+};
+
+}
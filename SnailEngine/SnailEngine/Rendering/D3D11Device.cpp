@@ -136,36 +136,52 @@ void D3D11Device::InitGBuffer()
     textureDesc.Width = resolutionSize.x;
     textureDesc.Height = resolutionSize.y;
     textureDesc.MipLevels = 1;
-    textureDesc.ArraySize = 7;
-    textureDesc.Format = DXGI_FORMAT_R11G11B10_FLOAT;
+    textureDesc.ArraySize = 1;
     textureDesc.SampleDesc.Count = 1;
     textureDesc.Usage = D3D11_USAGE_DEFAULT;
     textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
 
-    deferredPassTexture.reset(new Texture2D(textureDesc, DXGI_FORMAT_R11G11B10_FLOAT));
-
-    // Generate the render target view
-    D3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc;
-    renderTargetViewDesc.Format = textureDesc.Format;
-    renderTargetViewDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
-    renderTargetViewDesc.Texture2DArray.MipSlice = 0;
-    renderTargetViewDesc.Texture2DArray.ArraySize = 1;
-
+    // One texture per target since their formats differ, see GBufferPacking.hlsli
     for (int i = 0; i < NUM_DEFERRED_TEXTURES; ++i)
     {
-        renderTargetViewDesc.Texture2DArray.FirstArraySlice = i;
+        textureDesc.Format = GBufferPacking::GetFormat(static_cast<GBufferTarget>(i), gBufferPrecision);
+        gBufferTextures[i].reset(new Texture2D(textureDesc, textureDesc.Format));
 
-        DX_CALL(device->CreateRenderTargetView( deferredPassTexture.get()->GetRawTexture(), &renderTargetViewDesc, &renderTargetViewDeferred[i] ),
+        DX_CALL(device->CreateRenderTargetView(gBufferTextures[i]->GetRawTexture(), nullptr, &renderTargetViewDeferred[i]),
             DXE_ERREURCREATIONRENDERTARGET);
     }
 }
 
+void D3D11Device::SetGBufferPrecision(const GBufferPrecision precision)
+{
+    if (precision == gBufferPrecision)
+        return;
+
+    gBufferPrecision = precision;
+    for (int i = 0; i < NUM_DEFERRED_TEXTURES; ++i) { DX_RELEASE(renderTargetViewDeferred[i]); }
+    InitGBuffer();
+}
+
+size_t D3D11Device::GetGBufferTargetByteSize(const GBufferTarget target) const noexcept
+{
+    const uint32_t bytesPerPixel = GBufferPacking::GetBytesPerPixel(GBufferPacking::GetFormat(target, gBufferPrecision));
+    return static_cast<size_t>(resolutionSize.x) * static_cast<size_t>(resolutionSize.y) * bytesPerPixel;
+}
+
 void D3D11Device::PresentSpecific()
 {
     // 1 means VSYNC on
     DX_CALL(swapChain->Present(VSyncEnabled, 0), "Error presenting swapchain.");
 }
 
+void D3D11Device::SetMaximumFrameLatency(const uint32_t frameCount)
+{
+    IDXGIDevice1* dxgiDevice;
+    DX_CALL(device->QueryInterface(__uuidof(IDXGIDevice1), reinterpret_cast<void**>(&dxgiDevice)), "Error getting the DXGI device");
+    DX_CALL(dxgiDevice->SetMaximumFrameLatency(frameCount), "Error setting the maximum frame latency");
+    dxgiDevice->Release();
+}
+
 DirectX::XMINT2 D3D11Device::GetFullscreenResolution() const
 {
     /*auto width = GetSystemMetrics(SM_CXSCREEN);
@@ -338,10 +354,11 @@ void D3D11Device::Clear()
     immediateContext->ClearUnorderedAccessViewFloat(postProcessUAV, color);
 
     constexpr float black[4]{};
+    // albedo should be cleared with clear color, without any flag in alpha
+    const float albedo[4] = {clearColor.x, clearColor.y, clearColor.z, 0.0f};
     for (int i = 0; i < NUM_DEFERRED_TEXTURES; ++i)
     {
-        // albedo should be cleared with clear color
-        immediateContext->ClearRenderTargetView(renderTargetViewDeferred[i], i == 2 ? color : black);
+        immediateContext->ClearRenderTargetView(renderTargetViewDeferred[i], i == static_cast<int>(GBufferTarget::ALBEDO) ? albedo : black);
     }
 
     immediateContext->ClearDepthStencilView(depthStencilView, D3D11_CLEAR_DEPTH, 0.0, 0);
@@ -376,6 +393,11 @@ void D3D11Device::DrawIndexedInstanced(const uint32_t indexBufferCount, const in
     immediateContext->DrawIndexedInstanced(indexBufferCount, instancesCount, indexBufferStartIndex, 0, 0);
 }
 
+void D3D11Device::DrawIndexedInstancedIndirect(ID3D11Buffer* argsBuffer, const uint32_t argsOffset)
+{
+    immediateContext->DrawIndexedInstancedIndirect(argsBuffer, argsOffset);
+}
+
 #ifdef _PRIVATE_DATA
 void D3D11Device::SetDebugName(ID3D11DeviceChild* object, const std::string& name)
 {
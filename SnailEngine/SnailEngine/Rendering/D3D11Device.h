@@ -1,7 +1,9 @@
 #pragma once
+#include <array>
 #include <memory>
 #include <windef.h>
 
+#include "GBufferPacking.h"
 #include "Texture2D.h"
 #include "Rendering/Device.h"
 
@@ -14,6 +16,7 @@ public:
     ~D3D11Device() override;
     void InitGBuffer() override;
     void PresentSpecific() override;
+    void SetMaximumFrameLatency(uint32_t frameCount) override;
 
     DirectX::XMINT2 GetFullscreenResolution() const;
     DirectX::XMINT2 GetWindowedResolution() const;
@@ -29,6 +32,8 @@ public:
         int baseVertexLocation = 0,
         int startInstanceLocation = 0) override;
     void DrawIndexedInstanced(uint32_t indexBufferCount, int instancesCount, uint32_t indexBufferStartIndex);
+    // Arguments are read from the buffer at the byte offset, see IndirectArgsBuffer
+    void DrawIndexedInstancedIndirect(ID3D11Buffer* argsBuffer, uint32_t argsOffset);
     void Draw(unsigned int vertexCount) override;
 
     void PrepareDeferredDraw() override;
@@ -64,7 +69,11 @@ public:
     ID3D11DepthStencilView* GetDepthStencilView() const noexcept { return depthStencilView; }
     ID3D11ShaderResourceView* GetDepthShaderResourceView() const noexcept { return depthShaderResource; }
 
-    Texture2D* GetGBufferTexture2DArray() const { return deferredPassTexture.get(); }
+    Texture2D* GetGBufferTexture(GBufferTarget target) const { return gBufferTextures[static_cast<int>(target)].get(); }
+    GBufferPrecision GetGBufferPrecision() const noexcept { return gBufferPrecision; }
+    // Creates the targets again when the precision changes, between frames
+    void SetGBufferPrecision(GBufferPrecision precision);
+    size_t GetGBufferTargetByteSize(GBufferTarget target) const noexcept;
 
     ID3D11Texture2D* GetPostProcessTexture() const { return postProcessTexture; }
     ID3D11SamplerState* GetPostProcessSamplerState() const { return postProcessSamplerState; }
@@ -78,7 +87,7 @@ public:
     static void SetDebugName(ID3D11DeviceChild* object, const std::string& name);
 #endif
 private:
-    static constexpr int NUM_DEFERRED_TEXTURES = 6;
+    static constexpr int NUM_DEFERRED_TEXTURES = GBufferPacking::TARGET_COUNT;
 
     ID3D11Device* device{};
     ID3D11DeviceContext* immediateContext{};
@@ -98,7 +107,8 @@ private:
     ID3D11BlendState* alphaBlendDisable{};
 
     ID3D11RenderTargetView* renderTargetViewDeferred[NUM_DEFERRED_TEXTURES]{};
-    std::unique_ptr<Texture2D> deferredPassTexture{};
+    std::array<std::unique_ptr<Texture2D>, NUM_DEFERRED_TEXTURES> gBufferTextures{};
+    GBufferPrecision gBufferPrecision = GBufferPrecision::COMPACT;
 
     ID3D11Texture2D* postProcessTexture{};
     ID3D11SamplerState* postProcessSamplerState{};
@@ -34,6 +34,8 @@ public:
     virtual void SetResolution(long width, long height) = 0;
     virtual void SetDisplayMode(DisplayMode) = 0;
     virtual void PresentSpecific() = 0;
+    // Frames the CPU may queue ahead of the GPU
+    virtual void SetMaximumFrameLatency(uint32_t frameCount) = 0;
     // Rendering
     virtual void PrepareDeferredDraw() = 0;
     virtual void PrepareDecalDraw() = 0;
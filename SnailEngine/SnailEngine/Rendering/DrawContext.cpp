@@ -2,6 +2,7 @@
 #include "DrawContext.h"
 
 #include "Core/RendererModule.h"
+#include "Core/Mesh/Mesh.h"
 
 namespace Snail
 {
@@ -20,6 +21,18 @@ namespace Snail
         return false;
     }
 
+    uint8_t DrawContext::SelectLod(const BaseMesh& mesh, const DirectX::BoundingBox& worldBounds, MeshLodState& state)
+    {
+        if (mesh.lodCount <= 1)
+            return 0;
+
+        assert(lodView < MAX_LOD_VIEWS);
+        const DirectX::BoundingSphere sphere{worldBounds.Center, Vector3{worldBounds.Extents}.Length()};
+        uint8_t& lod = state.lods[lodView];
+        lod = MeshLodSelector::Select(GetScreenCoverage(sphere), lod, mesh.lodCount);
+        return lod;
+    }
+
     template void DrawContext::DrawBoundingBox(const DirectX::BoundingOrientedBox& obb, bool hit);
     template void DrawContext::DrawBoundingBox(const DirectX::BoundingBox& bb, bool hit);
 
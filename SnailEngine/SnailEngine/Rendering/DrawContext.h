@@ -4,6 +4,8 @@ namespace Snail
 {
 class RendererModule;
 class D3D11Device;
+class BaseMesh;
+struct MeshLodState;
 
 class DrawContext
 {
@@ -14,6 +16,8 @@ protected:
 public:
     RendererModule* renderer;
     D3D11Device* device;
+    // Slot of this view in MeshLodState, 0 is the camera
+    uint8_t lodView = 0;
 
     DrawContext(RendererModule* renderer, D3D11Device* device);
     virtual ~DrawContext() = default;
@@ -21,6 +25,14 @@ public:
     virtual bool ShouldBeCulled(const DirectX::BoundingBox&);
     virtual bool ShouldBeCulled(const DirectX::BoundingOrientedBox&);
     virtual bool ShouldBeCulled(const DirectX::BoundingSphere&);
+
+    // Called for every mesh that passed culling, lets the view request the texture resolution it needs
+    virtual void RequestTextureDetail(const BaseMesh&, const DirectX::BoundingBox&, const Matrix&) {}
+
+    // Fraction of the view height the sphere covers, views that don't say get full detail
+    virtual float GetScreenCoverage(const DirectX::BoundingSphere&) { return 1; }
+    // LOD to draw the mesh with in this view, updates the state of the view for the hysteresis
+    uint8_t SelectLod(const BaseMesh& mesh, const DirectX::BoundingBox& worldBounds, MeshLodState& state);
 };
 
 }
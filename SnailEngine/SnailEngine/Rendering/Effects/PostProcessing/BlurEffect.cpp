@@ -1,8 +1,6 @@
 #include "stdafx.h"
 #include "BlurEffect.h"
 
-#include <random>
-
 #include "Core/WindowsEngine.h"
 #include "Rendering/D3D11Device.h"
 
@@ -11,32 +9,105 @@ namespace Snail
 
     BlurEffect::BlurEffect()
         : PostProcessEffect(L"SnailEngine/Shaders/PostProcessing/Blur.cs.hlsl")
+        , verticalShader(std::make_unique<ComputeShader>(effectShaderFile, std::unordered_set<std::string>{"VERTICAL"}))
     {
+        UpdateWeights();
     }
 
-    void BlurEffect::RenderEffect(D3D11Device* renderDevice, ID3D11Texture2D* tex, ID3D11UnorderedAccessView* output)
+    BlurEffect::~BlurEffect()
+    {
+        DX_RELEASE(intermediateUAV);
+        DX_RELEASE(intermediateSRV);
+        DX_RELEASE(intermediateTexture);
+        DX_RELEASE(sourceSRV);
+    }
+
+    void BlurEffect::UpdateWeights()
+    {
+        const BlurWeights weights = BlurWeights::Gaussian(radius, sigma);
+        data.weights = {};
+        std::copy_n(weights.weights.data(), weights.weights.size(), &data.weights[0].x);
+        data.radius = weights.radius;
+        dataBuffer.UpdateData(data);
+    }
+
+    void BlurEffect::PrepareTextures(D3D11Device* renderDevice, ID3D11Texture2D* tex)
     {
-        UNREFERENCED_PARAMETER(renderDevice);
-        if (isActive)
+        ID3D11Device* device = renderDevice->GetD3DDevice();
+
+        D3D11_TEXTURE2D_DESC desc;
+        tex->GetDesc(&desc);
+
+        if (tex != sourceTexture)
         {
-            computeShader->BindComputedUAV(output);
+            // The view keeps the texture alive, a new texture can't come back at the same address
+            DX_RELEASE(sourceSRV);
+            DX_CALL(device->CreateShaderResourceView(tex, nullptr, &sourceSRV), "Failed to create blur source SRV");
+            sourceTexture = tex;
+        }
 
-            SetData(data);
-            computeShader->SetConstantBuffer("BlurParams", dataBuffer.GetBuffer());
+        if (intermediateTexture)
+        {
+            D3D11_TEXTURE2D_DESC intermediateDesc;
+            intermediateTexture->GetDesc(&intermediateDesc);
+            if (intermediateDesc.Width == desc.Width && intermediateDesc.Height == desc.Height && intermediateDesc.Format == desc.Format)
+                return;
+        }
+
+        desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
+        desc.MipLevels = 1;
+        desc.ArraySize = 1;
+        desc.CPUAccessFlags = 0;
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        desc.MiscFlags = 0;
+
+        DX_RELEASE(intermediateUAV);
+        DX_RELEASE(intermediateSRV);
+        DX_RELEASE(intermediateTexture);
+        DX_CALL(device->CreateTexture2D(&desc, nullptr, &intermediateTexture), "Failed to create blur intermediate texture");
+        DX_CALL(device->CreateUnorderedAccessView(intermediateTexture, nullptr, &intermediateUAV), "Failed to create blur intermediate UAV");
+        DX_CALL(device->CreateShaderResourceView(intermediateTexture, nullptr, &intermediateSRV), "Failed to create blur intermediate SRV");
+    }
+
+    void BlurEffect::RenderEffect(D3D11Device* renderDevice, ID3D11Texture2D* tex, ID3D11UnorderedAccessView* output)
+    {
+        if (isActive && data.radius > 0)
+        {
+            PrepareTextures(renderDevice, tex);
 
-            computeShader->Bind();
-            // Get the dimensions of the UAV texture
             D3D11_TEXTURE2D_DESC desc;
             tex->GetDesc(&desc);
-            const UINT width = desc.Width, height = desc.Height;
-            // Determine the number of thread groups based on the dimensions
-            const int numGroupsX = (width + 7) / 8;
-            const int numGroupsY = (height + 7) / 8;
-            computeShader->Execute(numGroupsX, numGroupsY, 1);
-            computeShader->Unbind(); // Could put this in execute...
+            const int width = static_cast<int>(desc.Width), height = static_cast<int>(desc.Height);
+            // A group per tile of a row or a column
+            const int tileCountX = (width + BLUR_TILE_SIZE - 1) / BLUR_TILE_SIZE;
+            const int tileCountY = (height + BLUR_TILE_SIZE - 1) / BLUR_TILE_SIZE;
+
+            // Horizontal, from the texture to the intermediate one
+            computeShader->SetConstantBuffer("BlurParams", dataBuffer.GetBuffer());
+            computeShader->BindComputedUAV(intermediateUAV);
+            computeShader->BindSRV(0, sourceSRV);
+            computeShader->Bind();
+            computeShader->Execute(tileCountX, height, 1);
+            computeShader->UnbindSRV(0);
+            computeShader->Unbind();
+
+            // Vertical, back into the texture
+            verticalShader->SetConstantBuffer("BlurParams", dataBuffer.GetBuffer());
+            verticalShader->BindComputedUAV(output);
+            verticalShader->BindSRV(0, intermediateSRV);
+            verticalShader->Bind();
+            verticalShader->Execute(width, tileCountY, 1);
+            verticalShader->UnbindSRV(0);
+            verticalShader->Unbind();
         }
     }
 
+    void BlurEffect::ReloadShader()
+    {
+        PostProcessEffect::ReloadShader();
+        verticalShader = std::make_unique<ComputeShader>(effectShaderFile, std::unordered_set<std::string>{"VERTICAL"});
+    }
+
     void BlurEffect::RenderImGui()
     {
 #ifdef _IMGUI_
@@ -44,7 +115,10 @@ namespace Snail
 
         ImGui::Checkbox("Active##Blur", &isActive);
 
-        ImGui::DragInt("Kernel Size##BlurKernelSize", &data.kernelSize, 1, 0, 100);
+        bool changed = ImGui::SliderInt("Radius##BlurRadius", &radius, 0, MAX_BLUR_RADIUS);
+        changed |= ImGui::DragFloat("Sigma (0 for box)##BlurSigma", &sigma, 0.1f, 0.0f, static_cast<float>(MAX_BLUR_RADIUS));
+        if (changed)
+            UpdateWeights();
 #endif
     }
 
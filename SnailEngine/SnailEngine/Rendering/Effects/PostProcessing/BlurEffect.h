@@ -1,5 +1,6 @@
 #pragma once
 #include "PostProcessEffect.h"
+#include "PostProcessKernels.h"
 
 namespace Snail
 {
@@ -7,19 +8,40 @@ namespace Snail
 
     struct BlurParameters
     {
-        int kernelSize = 4;
+        // Weights of the offsets 0 to MAX_BLUR_RADIUS, four per vector
+        std::array<Vector4, MAX_BLUR_RADIUS / 4 + 1> weights{};
+        DX_ALIGN int radius = 0;
     };
 
+    // Separable blur, a horizontal pass into an intermediate texture then a vertical one back into the output. Each
+    // pass caches its row or column in group shared memory.
     class BlurEffect : public PostProcessEffect<BlurParameters>
     {
-        std::unique_ptr<Texture2D> noiseTexture{};
+        std::unique_ptr<ComputeShader> verticalShader;
+
+        int radius = 2;
+        // 0 for a box blur
+        float sigma = 0;
+
+        // Same size and format as the blurred texture
+        ID3D11Texture2D* intermediateTexture{};
+        ID3D11UnorderedAccessView* intermediateUAV{};
+        ID3D11ShaderResourceView* intermediateSRV{};
+
+        ID3D11Texture2D* sourceTexture{};
+        ID3D11ShaderResourceView* sourceSRV{};
+
+        void UpdateWeights();
+        void PrepareTextures(D3D11Device* renderDevice, ID3D11Texture2D* tex);
 
     public:
         BlurEffect();
+        ~BlurEffect() override;
 
         using PostProcessEffect::RenderEffect;
         void RenderEffect(D3D11Device* renderDevice, ID3D11Texture2D* tex, ID3D11UnorderedAccessView* output) override;
 
+        void ReloadShader() override;
         void RenderImGui() override;
     };
 
@@ -33,7 +33,7 @@ public:
     T GetData() const noexcept;
     void SetData(const T& newData);
 
-    void ReloadShader();
+    virtual void ReloadShader();
 };
 
 template <class T>
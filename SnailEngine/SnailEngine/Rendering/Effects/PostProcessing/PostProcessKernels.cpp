@@ -0,0 +1,253 @@
+#include "stdafx.h"
+#include "PostProcessKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+namespace Snail
+{
+
+BlurWeights BlurWeights::Box(const int kernelRadius)
+{
+    BlurWeights box;
+    box.radius = std::clamp(kernelRadius, 0, MAX_BLUR_RADIUS);
+    std::fill_n(box.weights.begin(), box.radius + 1, 1.0f / static_cast<float>(2 * box.radius + 1));
+    return box;
+}
+
+BlurWeights BlurWeights::Gaussian(const int kernelRadius, const float sigma)
+{
+    BlurWeights gaussian;
+    gaussian.radius = std::clamp(kernelRadius, 0, MAX_BLUR_RADIUS);
+    if (sigma <= 0)
+        return Box(gaussian.radius);
+
+    float sum = 0;
+    for (int i = 0; i <= gaussian.radius; ++i)
+    {
+        gaussian.weights[i] = std::exp(-static_cast<float>(i * i) / (2.0f * sigma * sigma));
+        sum += i == 0 ? gaussian.weights[i] : 2.0f * gaussian.weights[i];
+    }
+    for (int i = 0; i <= gaussian.radius; ++i)
+        gaussian.weights[i] /= sum;
+    return gaussian;
+}
+
+namespace
+{
+
+// Walks an image along lines of one direction, rows for the horizontal passes and columns for the vertical ones
+struct Lines
+{
+    int count;
+    int length;
+    // In pixels
+    size_t lineStride;
+    size_t step;
+
+    Lines(const int width, const int height, const bool isVertical)
+        : count(isVertical ? width : height)
+        , length(isVertical ? height : width)
+        , lineStride(isVertical ? 1 : static_cast<size_t>(width))
+        , step(isVertical ? static_cast<size_t>(width) : 1)
+    {}
+
+    size_t Pixel(const int line, const int i) const noexcept
+    {
+        return static_cast<size_t>(line) * lineStride + static_cast<size_t>(std::clamp(i, 0, length - 1)) * step;
+    }
+};
+
+float BilateralWeight(const float depth, const float centerDepth, const int offset)
+{
+    const float r2 = BILATERAL_DEPTH_FALLOFF * std::abs(depth - centerDepth);
+    return std::exp(-r2 * r2) * BILATERAL_WEIGHTS[std::abs(offset)];
+}
+
+}
+
+void BlurPass(const std::span<const float> source, const std::span<float> destination, const int width, const int height, const BlurWeights& weights, const bool isVertical)
+{
+    const Lines lines{width, height, isVertical};
+    for (int line = 0; line < lines.count; ++line)
+    {
+        for (int i = 0; i < lines.length; ++i)
+        {
+            const size_t center = lines.Pixel(line, i) * 4;
+            for (size_t c = 0; c < 4; ++c)
+            {
+                float result = source[center + c] * weights.weights[0];
+                for (int r = 1; r <= weights.radius; ++r)
+                    result += (source[lines.Pixel(line, i - r) * 4 + c] + source[lines.Pixel(line, i + r) * 4 + c]) * weights.weights[r];
+                destination[center + c] = result;
+            }
+        }
+    }
+}
+
+void BlurPassSimd(const std::span<const float> source, const std::span<float> destination, const int width, const int height, const BlurWeights& weights, const bool isVertical)
+{
+    const Lines lines{width, height, isVertical};
+    for (int line = 0; line < lines.count; ++line)
+    {
+        for (int i = 0; i < lines.length; ++i)
+        {
+            const size_t center = lines.Pixel(line, i) * 4;
+            __m128 result = _mm_mul_ps(_mm_loadu_ps(&source[center]), _mm_set1_ps(weights.weights[0]));
+            for (int r = 1; r <= weights.radius; ++r)
+            {
+                const __m128 pair = _mm_add_ps(_mm_loadu_ps(&source[lines.Pixel(line, i - r) * 4]), _mm_loadu_ps(&source[lines.Pixel(line, i + r) * 4]));
+                result = _mm_add_ps(result, _mm_mul_ps(pair, _mm_set1_ps(weights.weights[r])));
+            }
+            _mm_storeu_ps(&destination[center], result);
+        }
+    }
+}
+
+void BlurFull(const std::span<const float> source, const std::span<float> destination, const int width, const int height, const BlurWeights& weights)
+{
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            std::array<float, 4> result{};
+            for (int dy = -weights.radius; dy <= weights.radius; ++dy)
+            {
+                const size_t row = static_cast<size_t>(std::clamp(y + dy, 0, height - 1)) * width;
+                for (int dx = -weights.radius; dx <= weights.radius; ++dx)
+                {
+                    const size_t pixel = (row + std::clamp(x + dx, 0, width - 1)) * 4;
+                    const float weight = weights.weights[std::abs(dx)] * weights.weights[std::abs(dy)];
+                    for (size_t c = 0; c < 4; ++c)
+                        result[c] += source[pixel + c] * weight;
+                }
+            }
+            std::ranges::copy(result, destination.begin() + (static_cast<ptrdiff_t>(y) * width + x) * 4);
+        }
+    }
+}
+
+void BilateralBlurPass(const std::span<const float> source, const std::span<const float> depths, const std::span<float> destination, const int width, const int height, const bool isVertical)
+{
+    const Lines lines{width, height, isVertical};
+    for (int line = 0; line < lines.count; ++line)
+    {
+        for (int i = 0; i < lines.length; ++i)
+        {
+            const size_t center = lines.Pixel(line, i);
+            std::array<float, 4> result{};
+            float weightSum = 0;
+            for (int r = -BILATERAL_HALF_SAMPLES; r <= BILATERAL_HALF_SAMPLES; ++r)
+            {
+                const size_t pixel = lines.Pixel(line, i + r);
+                const float weight = BilateralWeight(depths[pixel], depths[center], r);
+                for (size_t c = 0; c < 4; ++c)
+                    result[c] += weight * source[pixel * 4 + c];
+                weightSum += weight;
+            }
+            for (size_t c = 0; c < 4; ++c)
+                destination[center * 4 + c] = result[c] / weightSum;
+        }
+    }
+}
+
+void BilateralBlurPassSimd(const std::span<const float> source, const std::span<const float> depths, const std::span<float> destination, const int width, const int height, const bool isVertical)
+{
+    const Lines lines{width, height, isVertical};
+    for (int line = 0; line < lines.count; ++line)
+    {
+        for (int i = 0; i < lines.length; ++i)
+        {
+            const size_t center = lines.Pixel(line, i);
+            __m128 result = _mm_setzero_ps();
+            __m128 weightSum = _mm_setzero_ps();
+            for (int r = -BILATERAL_HALF_SAMPLES; r <= BILATERAL_HALF_SAMPLES; ++r)
+            {
+                const size_t pixel = lines.Pixel(line, i + r);
+                const __m128 weight = _mm_set1_ps(BilateralWeight(depths[pixel], depths[center], r));
+                result = _mm_add_ps(result, _mm_mul_ps(weight, _mm_loadu_ps(&source[pixel * 4])));
+                weightSum = _mm_add_ps(weightSum, weight);
+            }
+            _mm_storeu_ps(&destination[center * 4], _mm_div_ps(result, weightSum));
+        }
+    }
+}
+
+void SsaoOcclusion(const SsaoInputs& inputs, const std::span<float> occlusion, const bool useTileCache)
+{
+    struct Float3
+    {
+        float x, y, z;
+
+        Float3 operator+(const Float3& other) const noexcept { return {x + other.x, y + other.y, z + other.z}; }
+        Float3 operator-(const Float3& other) const noexcept { return {x - other.x, y - other.y, z - other.z}; }
+        Float3 operator*(const float scale) const noexcept { return {x * scale, y * scale, z * scale}; }
+        float Dot(const Float3& other) const noexcept { return x * other.x + y * other.y + z * other.z; }
+        Float3 Cross(const Float3& other) const noexcept { return {y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x}; }
+        Float3 Normalized() const noexcept { return *this * (1.0f / std::sqrt(Dot(*this))); }
+    };
+    const auto load = [](const std::span<const float> values, const size_t index) { return Float3{values[index * 3], values[index * 3 + 1], values[index * 3 + 2]}; };
+    const auto& p = inputs.projection;
+    const size_t sampleCount = inputs.samples.size() / 3;
+
+    std::array<float, SSAO_TILE_SIZE * SSAO_TILE_SIZE> tile{};
+    for (int groupY = 0; groupY < inputs.height; groupY += SSAO_GROUP_SIZE)
+    {
+        for (int groupX = 0; groupX < inputs.width; groupX += SSAO_GROUP_SIZE)
+        {
+            const int tileX = groupX - SSAO_TILE_APRON;
+            const int tileY = groupY - SSAO_TILE_APRON;
+            if (useTileCache)
+            {
+                for (int i = 0; i < SSAO_TILE_SIZE * SSAO_TILE_SIZE; ++i)
+                {
+                    const int x = std::clamp(tileX + i % SSAO_TILE_SIZE, 0, inputs.width - 1);
+                    const int y = std::clamp(tileY + i / SSAO_TILE_SIZE, 0, inputs.height - 1);
+                    tile[i] = inputs.positions[(static_cast<size_t>(y) * inputs.width + x) * 3 + 2];
+                }
+            }
+
+            const auto depthAt = [&](const int x, const int y)
+            {
+                if (x < 0 || y < 0 || x >= inputs.width || y >= inputs.height)
+                    return inputs.offscreenDepth;
+                if (const int localX = x - tileX, localY = y - tileY; useTileCache && localX >= 0 && localY >= 0 && localX < SSAO_TILE_SIZE && localY < SSAO_TILE_SIZE)
+                    return tile[localY * SSAO_TILE_SIZE + localX];
+                return inputs.positions[(static_cast<size_t>(y) * inputs.width + x) * 3 + 2];
+            };
+
+            for (int y = groupY; y < std::min(groupY + SSAO_GROUP_SIZE, inputs.height); ++y)
+            {
+                for (int x = groupX; x < std::min(groupX + SSAO_GROUP_SIZE, inputs.width); ++x)
+                {
+                    const size_t pixel = static_cast<size_t>(y) * inputs.width + x;
+                    const Float3 viewPos = load(inputs.positions, pixel);
+                    const Float3 normal = load(inputs.normals, pixel).Normalized();
+                    const Float3 randomVec = load(inputs.noise, static_cast<size_t>(y % 4 * 4 + x % 4)).Normalized();
+                    const Float3 tangent = (randomVec - normal * normal.Dot(randomVec)).Normalized();
+                    const Float3 bitangent = tangent.Cross(normal).Normalized();
+
+                    float sum = 0;
+                    for (size_t i = 0; i < sampleCount; ++i)
+                    {
+                        const Float3 sample = load(inputs.samples, i);
+                        const Float3 samplePos = viewPos + (tangent * sample.x + bitangent * sample.y + normal * sample.z) * inputs.radius;
+
+                        const float w = samplePos.x * p[3] + samplePos.y * p[7] + samplePos.z * p[11] + p[15];
+                        const float u = (samplePos.x * p[0] + samplePos.y * p[4] + samplePos.z * p[8] + p[12]) / w * 0.5f + 0.5f;
+                        const float v = 1.0f - ((samplePos.x * p[1] + samplePos.y * p[5] + samplePos.z * p[9] + p[13]) / w * 0.5f + 0.5f);
+
+                        // Truncated like the shader's load
+                        const float pixelDepth = depthAt(static_cast<int>(u * static_cast<float>(inputs.width)), static_cast<int>(v * static_cast<float>(inputs.height)));
+                        const float rangeCheck = std::clamp(inputs.radius / std::abs(pixelDepth - samplePos.z), 0.0f, 1.0f);
+                        sum += (samplePos.z - inputs.bias > pixelDepth ? 1.0f : 0.0f) * rangeCheck * rangeCheck * (3.0f - 2.0f * rangeCheck);
+                    }
+                    occlusion[pixel] = std::pow(1.0f - sum / static_cast<float>(sampleCount), inputs.power);
+                }
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <span>
+
+namespace Snail
+{
+
+// Keep in sync with Blur.cs.hlsl
+static constexpr int BLUR_TILE_SIZE = 64;
+// The tile holds the pixels of the group and radius more on both sides
+static constexpr int MAX_BLUR_RADIUS = BLUR_TILE_SIZE / 2;
+
+// Keep in sync with BilateralGaussianBlur.cs.hlsl
+static constexpr int BILATERAL_TILE_SIZE = 64;
+static constexpr int BILATERAL_HALF_SAMPLES = 7;
+static constexpr std::array<float, BILATERAL_HALF_SAMPLES + 1> BILATERAL_WEIGHTS = {0.14446445f, 0.13543542f, 0.11153505f, 0.08055309f, 0.05087564f, 0.02798160f, 0.01332457f, 0.00545096f};
+static constexpr float BILATERAL_DEPTH_FALLOFF = 1000.0f;
+
+// Keep in sync with SSAO.cs.hlsl
+static constexpr int SSAO_GROUP_SIZE = 8;
+// Pixels cached around the group, samples landing further away read the depth buffer
+static constexpr int SSAO_TILE_APRON = 8;
+static constexpr int SSAO_TILE_SIZE = SSAO_GROUP_SIZE + 2 * SSAO_TILE_APRON;
+
+// Weights of the offsets 0 to radius of a symmetric kernel, summing to 1 over the whole kernel
+struct BlurWeights
+{
+    std::array<float, MAX_BLUR_RADIUS + 1> weights{};
+    int radius = 0;
+
+    static BlurWeights Box(int kernelRadius);
+    static BlurWeights Gaussian(int kernelRadius, float sigma);
+};
+
+// CPU references of the post processing compute shaders, on the same data layout and with the same clamp to edge
+// borders. Images are rows of RGBA floats, depths rows of floats. The SIMD versions only differ by their cost.
+
+// One direction of the separable blur
+void BlurPass(std::span<const float> source, std::span<float> destination, int width, int height, const BlurWeights& weights, bool isVertical);
+void BlurPassSimd(std::span<const float> source, std::span<float> destination, int width, int height, const BlurWeights& weights, bool isVertical);
+// Every pixel of the kernel at once, what the separable passes must add up to
+void BlurFull(std::span<const float> source, std::span<float> destination, int width, int height, const BlurWeights& weights);
+
+// One direction of the depth aware gaussian blur of the volumetric lighting
+void BilateralBlurPass(std::span<const float> source, std::span<const float> depths, std::span<float> destination, int width, int height, bool isVertical);
+void BilateralBlurPassSimd(std::span<const float> source, std::span<const float> depths, std::span<float> destination, int width, int height, bool isVertical);
+
+struct SsaoInputs
+{
+    int width = 0;
+    int height = 0;
+    // View space, rows of xyz
+    std::span<const float> positions;
+    std::span<const float> normals;
+    // 4x4 rotation vectors as xyz, read without filtering
+    std::span<const float> noise;
+    // Hemisphere samples as xyz
+    std::span<const float> samples;
+    // Multiplies row vectors, like the shader
+    std::array<float, 16> projection{};
+    // View space depth read for samples outside the screen
+    float offscreenDepth = 0;
+    float radius = 0.5f;
+    float bias = 0.025f;
+    float power = 4;
+};
+
+// Ambient occlusion of every pixel. With the tile cache the depths come from a copy of the tile of the group and
+// its apron, like the shader, which must not change the result.
+void SsaoOcclusion(const SsaoInputs& inputs, std::span<float> occlusion, bool useTileCache);
+
+}
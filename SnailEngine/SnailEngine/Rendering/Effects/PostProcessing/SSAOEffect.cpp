@@ -164,9 +164,8 @@ namespace Snail
     {
         if (isActive)
         {
-            static auto& cm = WindowsEngine::GetModule<CameraManager>();
-
-            const Camera* cam = cm.GetCurrentCamera();
+            static auto& renderer = WindowsEngine::GetModule<RendererModule>();
+            const FrameView::CameraView& camera = renderer.GetFrameView().camera;
 
             // Get the dimensions of the UAV texture
             D3D11_TEXTURE2D_DESC desc;
@@ -174,16 +173,16 @@ namespace Snail
             const UINT width = desc.Width, height = desc.Height;
 
             data.screenSize = DirectX::XMINT2{ static_cast<int>(width), static_cast<int>(height) };
-            data.invProjMat = cam->GetProjectionMatrix().Invert().Transpose();
-            data.projMat = cam->GetProjectionMatrix().Transpose();
-            data.invViewMat = cam->GetViewMatrix().Invert();
+            data.invProjMat = camera.invProjection.Transpose();
+            data.projMat = camera.projection.Transpose();
+            data.invViewMat = camera.invView;
             dataBuffer.UpdateData(data);
 
             computeShader->SetConstantBuffer("SSAOParams", dataBuffer.GetBuffer());
 
             computeShader->BindComputedUAV(output);
 
-            computeShader->BindSRV(0, renderDevice->GetGBufferTexture2DArray()->GetShaderResourceView());
+            computeShader->BindSRV(0, renderDevice->GetGBufferTexture(GBufferTarget::NORMAL)->GetShaderResourceView());
             computeShader->BindSRV(1, renderDevice->GetDepthShaderResourceView());
             computeShader->BindSRV(2, noiseTexture->GetShaderResourceView());
             computeShader->BindSampler(0, noiseTexture->GetSamplerState());
@@ -199,6 +198,7 @@ namespace Snail
             computeShader->UnbindSRV(2);
             computeShader->Unbind(); // Could put this in execute...
 
+            // Smooths out the 4x4 noise pattern
             blur.RenderEffect(renderDevice, tex, output);
         }
     }
@@ -208,6 +208,12 @@ namespace Snail
         ResizeTexture(width, height);
     }
 
+    void SSAOEffect::ReloadShader()
+    {
+        PostProcessEffect::ReloadShader();
+        blur.ReloadShader();
+    }
+
     void SSAOEffect::RenderImGui()
     {
 #ifdef _IMGUI_
@@ -46,6 +46,7 @@ public:
     void RenderEffect(D3D11Device* renderDevice) override;
     void RenderEffect(D3D11Device* renderDevice, ID3D11Texture2D* tex, ID3D11UnorderedAccessView* output) override;
 
+    void ReloadShader() override;
     void RenderImGui() override;
     void Resize(long width, long height);
 };
@@ -0,0 +1,52 @@
+#include "stdafx.h"
+#include "FrameView.h"
+
+#include "Core/Camera/Camera.h"
+
+namespace Snail
+{
+
+FrameView::CameraView FrameView::CameraView::Create(const Transform& transform, const Matrix& projection, const float nearPlane, const float farPlane, const bool isPerspective)
+{
+    CameraView cameraView;
+    cameraView.position = transform.position;
+    cameraView.forward = transform.GetForwardVector();
+    cameraView.up = transform.GetUpVector();
+    cameraView.right = transform.GetRightVector();
+    // Same as Camera::GetViewMatrix
+    cameraView.view = Matrix::CreateLookAt(cameraView.position, cameraView.position + cameraView.forward, cameraView.up);
+    cameraView.projection = projection;
+    cameraView.viewProjection = cameraView.view * projection;
+    cameraView.invView = cameraView.view.Invert();
+    cameraView.invProjection = projection.Invert();
+    cameraView.invViewProjection = cameraView.viewProjection.Invert();
+    cameraView.nearPlane = nearPlane;
+    cameraView.farPlane = farPlane;
+    cameraView.isPerspective = isPerspective;
+    return cameraView;
+}
+
+FrameView::CameraView FrameView::CameraView::FromCamera(const Camera& camera)
+{
+    return Create(camera.GetTransform(), camera.GetProjectionMatrix(), camera.GetNearPlane(), camera.GetFarPlane(), camera.IsPerspectiveCamera());
+}
+
+FrameView::FrameView(FrameArena& frameArena)
+    : arena{&frameArena}
+    , directionalLights{frameArena}
+    , occluders{frameArena}
+{}
+
+void FrameView::Clear()
+{
+    directionalLights = FrameVector<DirectionalLight>{*arena};
+    occluders = FrameVector<OcclusionCulling::Occluder>{*arena};
+}
+
+void FrameView::AddOccluder(const OccluderMesh& mesh, const Matrix& world)
+{
+    if (!mesh.indices.empty())
+        occluders.push_back({&mesh, world});
+}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <optional>
+
+#include "Core/Math/Transform.h"
+#include "Core/Memory/FrameArena.h"
+#include "Rendering/Lights/DirectionalLight.h"
+#include "Rendering/Occlusion/OcclusionCulling.h"
+
+namespace Snail
+{
+class Camera;
+
+inline constexpr uint8_t SHADOW_CASCADE_COUNT = 6;
+
+// What a frame is drawn with, extracted from the simulation once per frame. Nothing writes to it after the extraction,
+// so the render preparation reads it on its own thread while the main thread moves on to the next frame.
+// Its lists are allocated from the frame arena, the preparation is done with them before the end of the next frame.
+struct FrameView
+{
+    // The matrices of a camera and their inverses, computed once instead of by every pass that needs them
+    struct CameraView
+    {
+        Matrix view;
+        Matrix projection;
+        Matrix viewProjection;
+        Matrix invView;
+        Matrix invProjection;
+        Matrix invViewProjection;
+        Vector3 position;
+        Vector3 forward;
+        Vector3 up;
+        Vector3 right;
+        float nearPlane = 0;
+        float farPlane = 0;
+        bool isPerspective = true;
+
+        static CameraView Create(const Transform& transform, const Matrix& projection, float nearPlane, float farPlane, bool isPerspective);
+        static CameraView FromCamera(const Camera& camera);
+    };
+
+    FrameArena* arena;
+    uint64_t frameIndex = 0;
+    // The camera the frame is drawn from
+    CameraView camera;
+    // The scene is culled against the first camera, which isn't the drawn one while debugging the culling
+    CameraView cullingCamera;
+    // Default constructed for orthographic culling cameras
+    DirectX::BoundingFrustum cullingFrustum;
+
+    // View projection of the shadow camera cut to the range of every cascade, empty for cascades without a range
+    std::array<std::optional<Matrix>, SHADOW_CASCADE_COUNT> cascadeFrustums;
+    FrameVector<DirectionalLight> directionalLights;
+
+    // Render proxies of the occluders, their meshes outlive the frame
+    FrameVector<OcclusionCulling::Occluder> occluders;
+    bool occlusionEnabled = true;
+
+    explicit FrameView(FrameArena& frameArena);
+
+    // Empties the lists before a new extraction, they are bound to the current frame of the arena
+    void Clear();
+    void AddOccluder(const OccluderMesh& mesh, const Matrix& world);
+};
+
+}
@@ -0,0 +1,184 @@
+#include "stdafx.h"
+#include "GBufferPacking.h"
+
+#include <cmath>
+
+#include "VertexCompression.h"
+
+namespace Snail
+{
+
+namespace
+{
+
+constexpr DXGI_FORMAT TARGET_FORMATS[][GBufferPacking::TARGET_COUNT] = {
+    // COMPACT
+    {DXGI_FORMAT_R16G16_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R11G11B10_FLOAT},
+    // HIGH, the albedo is stored linearly with enough bits to not need sRGB
+    {DXGI_FORMAT_R16G16_UNORM, DXGI_FORMAT_R16G16B16A16_UNORM, DXGI_FORMAT_R16G16B16A16_UNORM, DXGI_FORMAT_R16G16B16A16_FLOAT},
+};
+
+float QuantizeUnorm(const float v, const int bits) noexcept
+{
+    const auto max = static_cast<float>((1u << bits) - 1);
+    return std::round(std::clamp(v, 0.0f, 1.0f) * max) / max;
+}
+
+// Floats with a 5 bits exponent, the mantissa size varies
+float QuantizeSmallFloat(float v, const int mantissaBits, const bool isSigned) noexcept
+{
+    if (!isSigned)
+        v = std::max(v, 0.0f);
+    if (v == 0)
+        return 0;
+
+    int exponent;
+    std::frexp(v, &exponent);
+    // Below 2^-14 the values are denormals and keep the step of the smallest exponent
+    exponent = std::max(exponent, -13);
+    const float step = std::ldexp(1.0f, exponent - 1 - mantissaBits);
+    const float maxValue = std::ldexp(2.0f - std::ldexp(1.0f, -mantissaBits), 15);
+    return std::clamp(std::round(v / step) * step, -maxValue, maxValue);
+}
+
+float LinearToSrgb(const float v) noexcept
+{
+    return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1 / 2.4f) - 0.055f;
+}
+
+float SrgbToLinear(const float v) noexcept
+{
+    return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+}
+
+}
+
+DXGI_FORMAT GBufferPacking::GetFormat(const GBufferTarget target, const GBufferPrecision precision) noexcept
+{
+    return TARGET_FORMATS[static_cast<int>(precision)][static_cast<int>(target)];
+}
+
+uint32_t GBufferPacking::GetBytesPerPixel(const DXGI_FORMAT format) noexcept
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R16G16_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+        return 4;
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+uint32_t GBufferPacking::GetBytesPerPixel(const GBufferPrecision precision) noexcept
+{
+    uint32_t bytes = 0;
+    for (int i = 0; i < TARGET_COUNT; ++i)
+        bytes += GetBytesPerPixel(GetFormat(static_cast<GBufferTarget>(i), precision));
+    return bytes;
+}
+
+const char* GBufferPacking::GetTargetName(const GBufferTarget target) noexcept
+{
+    switch (target)
+    {
+    case GBufferTarget::NORMAL:
+        return "Normal";
+    case GBufferTarget::ALBEDO:
+        return "Albedo and flags";
+    case GBufferTarget::MATERIAL:
+        return "Specular";
+    case GBufferTarget::EMISSION:
+        return "Emission";
+    default:
+        return "Unknown";
+    }
+}
+
+const char* GBufferPacking::GetPrecisionName(const GBufferPrecision precision) noexcept
+{
+    return precision == GBufferPrecision::COMPACT ? "Compact" : "High";
+}
+
+const char* GBufferPacking::GetFormatName(const DXGI_FORMAT format) noexcept
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R16G16_UNORM:
+        return "RG16 UNORM";
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+        return "RGBA8 UNORM";
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        return "RGBA8 sRGB";
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+        return "R11G11B10 FLOAT";
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+        return "RGBA16 UNORM";
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        return "RGBA16 FLOAT";
+    default:
+        return "Unknown";
+    }
+}
+
+Vector2 GBufferPacking::PackNormal(const Vector3& normal) noexcept
+{
+    Vector3 n = normal;
+    n.Normalize();
+    return VertexCompression::OctEncode(n) * 0.5f + Vector2{0.5f, 0.5f};
+}
+
+Vector3 GBufferPacking::UnpackNormal(const Vector2& packed) noexcept
+{
+    return VertexCompression::OctDecode(packed * 2 - Vector2::One);
+}
+
+float GBufferPacking::PackSpecularExponent(const float exponent) noexcept
+{
+    return std::log2(1 + std::clamp(exponent, 0.0f, MAX_SPECULAR_EXPONENT)) / std::log2(1 + MAX_SPECULAR_EXPONENT);
+}
+
+float GBufferPacking::UnpackSpecularExponent(const float packed) noexcept
+{
+    return std::exp2(packed * std::log2(1 + MAX_SPECULAR_EXPONENT)) - 1;
+}
+
+float GBufferPacking::PackFlags(const uint32_t flags) noexcept
+{
+    return static_cast<float>(flags) / MAX_FLAGS;
+}
+
+uint32_t GBufferPacking::UnpackFlags(const float packed) noexcept
+{
+    return static_cast<uint32_t>(std::lround(std::clamp(packed, 0.0f, 1.0f) * MAX_FLAGS));
+}
+
+float GBufferPacking::Quantize(const float value, const DXGI_FORMAT format, const int channel) noexcept
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R16G16_UNORM:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+        return QuantizeUnorm(value, 16);
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+        return QuantizeUnorm(value, 8);
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        // The alpha stays linear
+        if (channel == 3)
+            return QuantizeUnorm(value, 8);
+        return SrgbToLinear(QuantizeUnorm(LinearToSrgb(std::clamp(value, 0.0f, 1.0f)), 8));
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+        return QuantizeSmallFloat(value, channel == 2 ? 5 : 6, false);
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        return QuantizeSmallFloat(value, 10, true);
+    default:
+        return value;
+    }
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+
+namespace Snail
+{
+
+// Render targets of the G-buffer, in the order of the SV_Target semantics of GBufferPacking.hlsli
+enum class GBufferTarget : uint8_t
+{
+    NORMAL,
+    ALBEDO,
+    MATERIAL,
+    EMISSION,
+    COUNT,
+};
+
+// Formats the targets are created with, the encodings don't change between them
+enum class GBufferPrecision : uint8_t
+{
+    // 16 bytes per pixel
+    COMPACT,
+    // 16 bits per channel, to compare the banding against
+    HIGH,
+};
+
+// CPU mirror of the encodings of GBufferPacking.hlsli, used to measure what each target format loses
+class GBufferPacking
+{
+public:
+    static constexpr int TARGET_COUNT = static_cast<int>(GBufferTarget::COUNT);
+
+    static constexpr uint32_t FLAG_TRANSLUCENT = 1;
+    static constexpr uint32_t MAX_FLAGS = 3;
+    static constexpr float MAX_SPECULAR_EXPONENT = 8191;
+
+    // The layout this one replaced, seven R11G11B10 slices of which six were drawn to
+    static constexpr uint32_t LEGACY_BYTES_PER_PIXEL = 7 * 4;
+
+    [[nodiscard]] static DXGI_FORMAT GetFormat(GBufferTarget target, GBufferPrecision precision) noexcept;
+    [[nodiscard]] static uint32_t GetBytesPerPixel(DXGI_FORMAT format) noexcept;
+    [[nodiscard]] static uint32_t GetBytesPerPixel(GBufferPrecision precision) noexcept;
+    [[nodiscard]] static const char* GetTargetName(GBufferTarget target) noexcept;
+    [[nodiscard]] static const char* GetPrecisionName(GBufferPrecision precision) noexcept;
+    [[nodiscard]] static const char* GetFormatName(DXGI_FORMAT format) noexcept;
+
+    [[nodiscard]] static Vector2 PackNormal(const Vector3& normal) noexcept;
+    [[nodiscard]] static Vector3 UnpackNormal(const Vector2& packed) noexcept;
+    [[nodiscard]] static float PackSpecularExponent(float exponent) noexcept;
+    [[nodiscard]] static float UnpackSpecularExponent(float packed) noexcept;
+    [[nodiscard]] static float PackFlags(uint32_t flags) noexcept;
+    [[nodiscard]] static uint32_t UnpackFlags(float packed) noexcept;
+
+    // What a target of the format reads back for a value written to one of its channels, 3 being alpha
+    [[nodiscard]] static float Quantize(float value, DXGI_FORMAT format, int channel) noexcept;
+};
+
+}
@@ -0,0 +1,453 @@
+#include "stdafx.h"
+#include "LightManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "Core/WindowsEngine.h"
+#include "Core/Memory/FrameArena.h"
+
+namespace Snail
+{
+
+namespace
+{
+
+template <class Column>
+void MoveLast(Column& column, const uint32_t to)
+{
+    if (column.empty())
+        return;
+    column[to] = column.back();
+    column.pop_back();
+}
+
+}
+
+LightHandle LightManager::AddPointLight(const PointLight& light)
+{
+    return Add(LightType::POINT, light.Position, light.Color, light.Coefficients, light.isActive);
+}
+
+LightHandle LightManager::AddSpotLight(const SpotLight& light)
+{
+    const LightHandle handle = Add(LightType::SPOT, light.Position, light.Color, light.Coefficients, light.isActive);
+    Pool& pool = GetPool(LightType::SPOT);
+    pool.directions.push_back(light.Direction);
+    pool.innerConeAngles.push_back(light.InnerConeAngle);
+    pool.outerConeAngles.push_back(light.OuterConeAngle);
+    return handle;
+}
+
+LightHandle LightManager::Add(const LightType type, const Vector3& position, const Vector3& color, const Vector3& coefficients, const bool isActive)
+{
+    Pool& pool = GetPool(type);
+
+    uint32_t handleIndex;
+    if (!pool.freeHandleIndices.empty())
+    {
+        handleIndex = pool.freeHandleIndices.back();
+        pool.freeHandleIndices.pop_back();
+    }
+    else
+    {
+        handleIndex = static_cast<uint32_t>(pool.denseIndices.size());
+        pool.denseIndices.push_back(NO_INDEX);
+        pool.generations.push_back(0);
+    }
+
+    const auto denseIndex = static_cast<uint32_t>(pool.Size());
+    pool.denseIndices[handleIndex] = denseIndex;
+    pool.positions.push_back(position);
+    pool.colors.push_back(color);
+    pool.coefficients.push_back(coefficients);
+    pool.isActive.push_back(isActive);
+    pool.ranges.push_back(0);
+    pool.importances.push_back(0);
+    pool.fades.push_back(0);
+    pool.isSelected.push_back(false);
+    pool.isDirty.push_back(true);
+    pool.gpuSlots.push_back(NO_INDEX);
+    pool.handleIndices.push_back(handleIndex);
+    UpdateRange(pool, denseIndex);
+
+    return {handleIndex, pool.generations[handleIndex], type};
+}
+
+void LightManager::Remove(const LightHandle handle)
+{
+    const uint32_t denseIndex = GetDenseIndex(handle);
+    if (denseIndex == NO_INDEX)
+        return;
+
+    Pool& pool = GetPool(handle.type);
+    if (const uint32_t slot = pool.gpuSlots[denseIndex]; slot != NO_INDEX)
+        ReleaseSlot(handle.type, slot);
+
+    // The last light takes the place of the removed one
+    if (const uint32_t lastIndex = static_cast<uint32_t>(pool.Size()) - 1; denseIndex != lastIndex)
+    {
+        pool.denseIndices[pool.handleIndices[lastIndex]] = denseIndex;
+        if (const uint32_t lastSlot = pool.gpuSlots[lastIndex]; lastSlot != NO_INDEX)
+            pool.slotLights[lastSlot] = denseIndex;
+    }
+    MoveLast(pool.positions, denseIndex);
+    MoveLast(pool.colors, denseIndex);
+    MoveLast(pool.coefficients, denseIndex);
+    MoveLast(pool.isActive, denseIndex);
+    MoveLast(pool.directions, denseIndex);
+    MoveLast(pool.innerConeAngles, denseIndex);
+    MoveLast(pool.outerConeAngles, denseIndex);
+    MoveLast(pool.ranges, denseIndex);
+    MoveLast(pool.importances, denseIndex);
+    MoveLast(pool.fades, denseIndex);
+    MoveLast(pool.isSelected, denseIndex);
+    MoveLast(pool.isDirty, denseIndex);
+    MoveLast(pool.gpuSlots, denseIndex);
+    MoveLast(pool.handleIndices, denseIndex);
+
+    pool.denseIndices[handle.index] = NO_INDEX;
+    ++pool.generations[handle.index];
+    pool.freeHandleIndices.push_back(handle.index);
+}
+
+void LightManager::Clear()
+{
+    for (const LightType type : {LightType::POINT, LightType::SPOT})
+    {
+        Pool& pool = GetPool(type);
+        for (uint32_t slot = 0; slot < pool.slotCount; ++slot)
+        {
+            if (pool.slotLights[slot] != NO_INDEX)
+                ReleaseSlot(type, slot);
+        }
+        pool.slotCount = 0;
+
+        for (const uint32_t handleIndex : pool.handleIndices)
+        {
+            pool.denseIndices[handleIndex] = NO_INDEX;
+            ++pool.generations[handleIndex];
+            pool.freeHandleIndices.push_back(handleIndex);
+        }
+        pool.positions.clear();
+        pool.colors.clear();
+        pool.coefficients.clear();
+        pool.isActive.clear();
+        pool.directions.clear();
+        pool.innerConeAngles.clear();
+        pool.outerConeAngles.clear();
+        pool.ranges.clear();
+        pool.importances.clear();
+        pool.fades.clear();
+        pool.isSelected.clear();
+        pool.isDirty.clear();
+        pool.gpuSlots.clear();
+        pool.handleIndices.clear();
+    }
+}
+
+uint32_t LightManager::GetDenseIndex(const LightHandle handle) const noexcept
+{
+    const Pool& pool = GetPool(handle.type);
+    if (handle.index >= pool.denseIndices.size() || pool.generations[handle.index] != handle.generation)
+        return NO_INDEX;
+    return pool.denseIndices[handle.index];
+}
+
+bool LightManager::IsAlive(const LightHandle handle) const noexcept
+{
+    return GetDenseIndex(handle) != NO_INDEX;
+}
+
+std::vector<LightHandle> LightManager::GetHandles(const LightType type) const
+{
+    const Pool& pool = GetPool(type);
+    std::vector<LightHandle> handles;
+    handles.reserve(pool.Size());
+    for (const uint32_t handleIndex : pool.handleIndices)
+        handles.push_back({handleIndex, pool.generations[handleIndex], type});
+    return handles;
+}
+
+PointLight LightManager::GetPointLight(const LightHandle handle) const
+{
+    const uint32_t i = GetDenseIndex(handle);
+    if (i == NO_INDEX || handle.type != LightType::POINT)
+        return {};
+    const Pool& pool = GetPool(LightType::POINT);
+    return {pool.positions[i], pool.colors[i], pool.coefficients[i], pool.isActive[i] != 0};
+}
+
+SpotLight LightManager::GetSpotLight(const LightHandle handle) const
+{
+    const uint32_t i = GetDenseIndex(handle);
+    if (i == NO_INDEX || handle.type != LightType::SPOT)
+        return {};
+    const Pool& pool = GetPool(LightType::SPOT);
+    return {pool.positions[i], pool.colors[i], pool.directions[i], pool.coefficients[i], pool.innerConeAngles[i], pool.outerConeAngles[i], pool.isActive[i] != 0};
+}
+
+void LightManager::SetPointLight(const LightHandle handle, const PointLight& light)
+{
+    const uint32_t i = GetDenseIndex(handle);
+    if (i == NO_INDEX || handle.type != LightType::POINT)
+        return;
+    Pool& pool = GetPool(LightType::POINT);
+    pool.positions[i] = light.Position;
+    pool.colors[i] = light.Color;
+    pool.coefficients[i] = light.Coefficients;
+    pool.isActive[i] = light.isActive;
+    UpdateRange(pool, i);
+    MarkDirty(pool, i);
+}
+
+void LightManager::SetSpotLight(const LightHandle handle, const SpotLight& light)
+{
+    const uint32_t i = GetDenseIndex(handle);
+    if (i == NO_INDEX || handle.type != LightType::SPOT)
+        return;
+    Pool& pool = GetPool(LightType::SPOT);
+    pool.positions[i] = light.Position;
+    pool.colors[i] = light.Color;
+    pool.directions[i] = light.Direction;
+    pool.coefficients[i] = light.Coefficients;
+    pool.innerConeAngles[i] = light.InnerConeAngle;
+    pool.outerConeAngles[i] = light.OuterConeAngle;
+    pool.isActive[i] = light.isActive;
+    UpdateRange(pool, i);
+    MarkDirty(pool, i);
+}
+
+void LightManager::SetPosition(const LightHandle handle, const Vector3& position)
+{
+    const uint32_t i = GetDenseIndex(handle);
+    if (i == NO_INDEX)
+        return;
+    Pool& pool = GetPool(handle.type);
+    if (pool.positions[i] == position)
+        return;
+    pool.positions[i] = position;
+    MarkDirty(pool, i);
+}
+
+float LightManager::GetFade(const LightHandle handle) const noexcept
+{
+    const uint32_t i = GetDenseIndex(handle);
+    return i == NO_INDEX ? 0.0f : GetPool(handle.type).fades[i];
+}
+
+float LightManager::GetImportance(const LightHandle handle) const noexcept
+{
+    const uint32_t i = GetDenseIndex(handle);
+    return i == NO_INDEX ? 0.0f : GetPool(handle.type).importances[i];
+}
+
+void LightManager::MarkDirty(Pool& pool, const uint32_t denseIndex) noexcept
+{
+    pool.isDirty[denseIndex] = true;
+}
+
+void LightManager::UpdateRange(Pool& pool, const uint32_t denseIndex)
+{
+    // Distance where intensity / (constant + linear * d + quadratic * d^2) falls to RANGE_CUTOFF
+    const Vector3& color = pool.colors[denseIndex];
+    const Vector3& k = pool.coefficients[denseIndex];
+    const float intensity = std::max({color.x, color.y, color.z});
+    const float c = k.x - intensity / RANGE_CUTOFF;
+
+    float range = 0;
+    if (c >= 0)
+        range = 0;
+    else if (k.z > 0)
+        range = (-k.y + std::sqrt(k.y * k.y - 4 * k.z * c)) / (2 * k.z);
+    else if (k.y > 0)
+        range = -c / k.y;
+    else
+        range = std::numeric_limits<float>::max();
+    pool.ranges[denseIndex] = range;
+}
+
+void LightManager::ReleaseSlot(const LightType type, const uint32_t slot)
+{
+    Pool& pool = GetPool(type);
+    if (const uint32_t light = pool.slotLights[slot]; light != NO_INDEX)
+    {
+        pool.gpuSlots[light] = NO_INDEX;
+        pool.fades[light] = 0;
+    }
+    pool.slotLights[slot] = NO_INDEX;
+
+    if (type == LightType::POINT)
+        gpuPointLights[slot] = {};
+    else
+        gpuSpotLights[slot] = {};
+
+    DirtyRange& range = pool.dirtyRange;
+    const uint32_t end = range.count == 0 ? slot + 1 : std::max(range.first + range.count, slot + 1);
+    range.first = range.count == 0 ? slot : std::min(range.first, slot);
+    range.count = end - range.first;
+}
+
+void LightManager::WriteSlot(const LightType type, const uint32_t slot)
+{
+    Pool& pool = GetPool(type);
+    const uint32_t i = pool.slotLights[slot];
+    if (type == LightType::POINT)
+        gpuPointLights[slot] = {pool.positions[i], pool.colors[i] * pool.fades[i], pool.coefficients[i], 1};
+    else
+        gpuSpotLights[slot] = {pool.positions[i], pool.colors[i] * pool.fades[i], pool.directions[i], pool.coefficients[i], pool.innerConeAngles[i], pool.outerConeAngles[i], 1};
+    pool.isDirty[i] = false;
+
+    DirtyRange& range = pool.dirtyRange;
+    const uint32_t end = range.count == 0 ? slot + 1 : std::max(range.first + range.count, slot + 1);
+    range.first = range.count == 0 ? slot : std::min(range.first, slot);
+    range.count = end - range.first;
+}
+
+void LightManager::UpdatePool(const LightType type, const LightView& view, const float dt, uint32_t budget)
+{
+    Pool& pool = GetPool(type);
+    const uint32_t capacity = type == LightType::POINT ? MAX_GPU_POINT_LIGHTS : MAX_GPU_SPOT_LIGHTS;
+    budget = std::min(budget, capacity);
+    pool.slotLights.resize(capacity, NO_INDEX);
+
+    // Screen importance, the ranking is scratch of this frame
+    static FrameArena& frameArena = WindowsEngine::GetModule<FrameArena>();
+    FrameVector<uint32_t> ranking{frameArena};
+    ranking.reserve(pool.Size());
+    for (uint32_t i = 0; i < pool.Size(); ++i)
+    {
+        float importance = 0;
+        if (pool.isActive[i] && pool.ranges[i] > 0 && (!view.isVisible || view.isVisible(pool.positions[i], pool.ranges[i])))
+        {
+            const Vector3& color = pool.colors[i];
+            const float distance = std::max(Vector3::Distance(view.position, pool.positions[i]), 0.0001f);
+            const float projectedRadius = std::min(pool.ranges[i] / distance * view.projectionYScale, MAX_PROJECTED_RADIUS);
+            importance = std::max({color.x, color.y, color.z}) * projectedRadius;
+        }
+
+        pool.importances[i] = importance;
+        pool.isSelected[i] = false;
+        if (importance > 0)
+            ranking.push_back(i);
+    }
+
+    const auto selectedCount = std::min(static_cast<size_t>(budget), ranking.size());
+    // Ties go to the oldest handle so that equal lights don't swap from frame to frame
+    std::nth_element(ranking.begin(), ranking.begin() + static_cast<ptrdiff_t>(selectedCount), ranking.end(), [&pool](const uint32_t a, const uint32_t b)
+    {
+        return pool.importances[a] > pool.importances[b] || (pool.importances[a] == pool.importances[b] && pool.handleIndices[a] < pool.handleIndices[b]);
+    });
+    for (size_t rank = 0; rank < selectedCount; ++rank)
+        pool.isSelected[ranking[rank]] = true;
+
+    // Lights in the budget fade in, the others fade out in their slot until they are gone
+    const float fadeStep = settings.fadeSeconds > 0 ? dt / settings.fadeSeconds : 1.0f;
+    for (uint32_t slot = 0; slot < capacity; ++slot)
+    {
+        const uint32_t i = pool.slotLights[slot];
+        if (i == NO_INDEX)
+            continue;
+
+        const float fade = pool.isSelected[i] ? std::min(pool.fades[i] + fadeStep, 1.0f) : std::max(pool.fades[i] - fadeStep, 0.0f);
+        if (fade <= 0)
+        {
+            ReleaseSlot(type, slot);
+            continue;
+        }
+        if (fade != pool.fades[i])
+        {
+            pool.fades[i] = fade;
+            pool.isDirty[i] = true;
+        }
+        if (!pool.isSelected[i])
+            ++stats.fadingCount;
+    }
+
+    // Lights entering the budget take a free slot, or the one of the most faded out light
+    uint32_t freeSlot = 0;
+    for (size_t rank = 0; rank < selectedCount; ++rank)
+    {
+        const uint32_t i = ranking[rank];
+        if (pool.gpuSlots[i] != NO_INDEX)
+            continue;
+
+        while (freeSlot < capacity && pool.slotLights[freeSlot] != NO_INDEX)
+            ++freeSlot;
+
+        uint32_t slot = freeSlot;
+        if (slot == capacity)
+        {
+            // There are fewer lights in the budget than slots, one of them is fading out
+            float lowestFade = std::numeric_limits<float>::max();
+            for (uint32_t candidate = 0; candidate < capacity; ++candidate)
+            {
+                if (const uint32_t light = pool.slotLights[candidate]; !pool.isSelected[light] && pool.fades[light] < lowestFade)
+                {
+                    lowestFade = pool.fades[light];
+                    slot = candidate;
+                }
+            }
+            ReleaseSlot(type, slot);
+            --stats.fadingCount;
+        }
+
+        pool.slotLights[slot] = i;
+        pool.gpuSlots[i] = slot;
+        pool.fades[i] = std::min(fadeStep, 1.0f);
+        pool.isDirty[i] = true;
+    }
+
+    pool.slotCount = 0;
+    for (uint32_t slot = 0; slot < capacity; ++slot)
+    {
+        const uint32_t i = pool.slotLights[slot];
+        if (i == NO_INDEX)
+            continue;
+        pool.slotCount = slot + 1;
+        if (pool.isDirty[i])
+            WriteSlot(type, slot);
+    }
+
+    stats.lightCount += pool.Size();
+    stats.visibleCount += ranking.size();
+    stats.selectedCount += selectedCount;
+    stats.fullUploadBytes += pool.Size() * (type == LightType::POINT ? sizeof(GpuPointLight) : sizeof(GpuSpotLight));
+}
+
+void LightManager::Update(const LightView& view, const float dt)
+{
+    const size_t totalUploadedBytes = stats.totalUploadedBytes;
+    stats = {};
+    stats.totalUploadedBytes = totalUploadedBytes;
+
+    UpdatePool(LightType::POINT, view, dt, settings.pointBudget);
+    UpdatePool(LightType::SPOT, view, dt, settings.spotBudget);
+}
+
+LightManager::DirtyRange LightManager::TakeDirtyRange(const LightType type) noexcept
+{
+    const DirtyRange range = std::exchange(GetPool(type).dirtyRange, {});
+    const size_t bytes = range.count * (type == LightType::POINT ? sizeof(GpuPointLight) : sizeof(GpuSpotLight));
+    stats.uploadedBytes += bytes;
+    stats.totalUploadedBytes += bytes;
+    return range;
+}
+
+#ifdef _IMGUI_
+void LightManager::RenderImGui()
+{
+    ImGui::Text("Lights: %zu, in view %zu, selected %zu, fading out %zu", stats.lightCount, stats.visibleCount, stats.selectedCount, stats.fadingCount);
+    ImGui::Text("Uploaded %zu bytes this frame, %zu for every light", stats.uploadedBytes, stats.fullUploadBytes);
+    ImGui::Text("GPU slots: %u point, %u spot", GetSlotCount(LightType::POINT), GetSlotCount(LightType::SPOT));
+
+    if (int budget = static_cast<int>(settings.pointBudget); ImGui::SliderInt("Point light budget", &budget, 0, static_cast<int>(MAX_GPU_POINT_LIGHTS)))
+        settings.pointBudget = static_cast<uint32_t>(budget);
+    if (int budget = static_cast<int>(settings.spotBudget); ImGui::SliderInt("Spot light budget", &budget, 0, static_cast<int>(MAX_GPU_SPOT_LIGHTS)))
+        settings.spotBudget = static_cast<uint32_t>(budget);
+    ImGui::SliderFloat("Fade seconds", &settings.fadeSeconds, 0, 2);
+}
+#endif
+
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "PointLight.h"
+#include "SpotLight.h"
+
+namespace Snail
+{
+
+enum class LightType : uint8_t
+{
+    POINT,
+    SPOT,
+};
+
+// Stays valid until its light is removed, and never refers to another light afterward
+struct LightHandle
+{
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+    LightType type = LightType::POINT;
+
+    bool IsValid() const noexcept { return index != INVALID_INDEX; }
+    bool operator==(const LightHandle&) const = default;
+};
+
+// Layouts of the structured buffers of the lighting pass, keep in sync with LightsDef.hlsli
+struct GpuPointLight
+{
+    Vector3 position;
+    Vector3 color;
+    Vector3 coefficients;
+    uint32_t isActive = 0;
+};
+
+struct GpuSpotLight
+{
+    Vector3 position;
+    Vector3 color;
+    Vector3 direction;
+    Vector3 coefficients;
+    float innerConeAngle = 0;
+    float outerConeAngle = 0;
+    uint32_t isActive = 0;
+};
+
+// Where the lights are ranked from
+struct LightView
+{
+    Vector3 position;
+    // The projection _22, half screen heights covered by one unit at a distance of one unit
+    float projectionYScale = 1;
+    // Whether a light's sphere of influence is in view, every light is when empty
+    std::function<bool(const Vector3& center, float radius)> isVisible;
+};
+
+// Stores the point and spot lights of a scene, column by column, and chooses which ones the lighting pass gets.
+// Every frame the lights are ranked by screen importance, their intensity times their projected radius, and the most
+// important ones up to a budget get a slot in the GPU buffers. Lights entering or leaving the budget fade in and out
+// instead of popping. Only the slots whose light changed, moved in or faded are rewritten, and only the range
+// covering them is uploaded.
+class LightManager
+{
+public:
+    static constexpr uint32_t MAX_GPU_POINT_LIGHTS = 128;
+    static constexpr uint32_t MAX_GPU_SPOT_LIGHTS = 32;
+    // Fraction of its intensity past which a light is out of range
+    static constexpr float RANGE_CUTOFF = 1.0f / 256.0f;
+    // Lights covering more than the screen are as important as the ones covering it
+    static constexpr float MAX_PROJECTED_RADIUS = 1.0f;
+
+    struct Settings
+    {
+        uint32_t pointBudget = 48;
+        uint32_t spotBudget = 10;
+        // 0 to switch lights on and off at once
+        float fadeSeconds = 0.25f;
+    };
+
+    // Slots [first, first + count) of a GPU buffer
+    struct DirtyRange
+    {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    // Of the last update, over both types
+    struct Stats
+    {
+        size_t lightCount = 0;
+        size_t visibleCount = 0;
+        size_t selectedCount = 0;
+        size_t fadingCount = 0;
+        size_t uploadedBytes = 0;
+        // What uploading every stored light would take
+        size_t fullUploadBytes = 0;
+        size_t totalUploadedBytes = 0;
+    };
+
+private:
+    static constexpr uint32_t NO_INDEX = std::numeric_limits<uint32_t>::max();
+
+    struct Pool
+    {
+        // Indexed by the dense index, the last light fills the hole of a removed one
+        std::vector<Vector3> positions;
+        std::vector<Vector3> colors;
+        std::vector<Vector3> coefficients;
+        std::vector<uint8_t> isActive;
+        // Spot lights only
+        std::vector<Vector3> directions;
+        std::vector<float> innerConeAngles;
+        std::vector<float> outerConeAngles;
+        // Distance past which the light is under RANGE_CUTOFF
+        std::vector<float> ranges;
+        std::vector<float> importances;
+        std::vector<float> fades;
+        std::vector<uint8_t> isSelected;
+        // Changed since its slot was last written
+        std::vector<uint8_t> isDirty;
+        std::vector<uint32_t> gpuSlots;
+        std::vector<uint32_t> handleIndices;
+
+        // Indexed by the handle index
+        std::vector<uint32_t> denseIndices;
+        std::vector<uint32_t> generations;
+        std::vector<uint32_t> freeHandleIndices;
+
+        // Dense index of the light in each GPU slot
+        std::vector<uint32_t> slotLights;
+        uint32_t slotCount = 0;
+        DirtyRange dirtyRange;
+
+        size_t Size() const noexcept { return positions.size(); }
+    };
+
+    Settings settings;
+    Stats stats;
+    std::array<Pool, 2> pools;
+    std::vector<GpuPointLight> gpuPointLights = std::vector<GpuPointLight>(MAX_GPU_POINT_LIGHTS);
+    std::vector<GpuSpotLight> gpuSpotLights = std::vector<GpuSpotLight>(MAX_GPU_SPOT_LIGHTS);
+
+    Pool& GetPool(LightType type) noexcept { return pools[static_cast<size_t>(type)]; }
+    const Pool& GetPool(LightType type) const noexcept { return pools[static_cast<size_t>(type)]; }
+    uint32_t GetDenseIndex(LightHandle handle) const noexcept;
+
+    LightHandle Add(LightType type, const Vector3& position, const Vector3& color, const Vector3& coefficients, bool isActive);
+    void MarkDirty(Pool& pool, uint32_t denseIndex) noexcept;
+    static void UpdateRange(Pool& pool, uint32_t denseIndex);
+    void ReleaseSlot(LightType type, uint32_t slot);
+    void WriteSlot(LightType type, uint32_t slot);
+    void UpdatePool(LightType type, const LightView& view, float dt, uint32_t budget);
+
+public:
+    LightHandle AddPointLight(const PointLight& light);
+    LightHandle AddSpotLight(const SpotLight& light);
+    void Remove(LightHandle handle);
+    void Clear();
+
+    bool IsAlive(LightHandle handle) const noexcept;
+    size_t GetCount(LightType type) const noexcept { return GetPool(type).Size(); }
+    // The handle of every stored light of that type, invalidated by additions and removals
+    std::vector<LightHandle> GetHandles(LightType type) const;
+
+    PointLight GetPointLight(LightHandle handle) const;
+    SpotLight GetSpotLight(LightHandle handle) const;
+    void SetPointLight(LightHandle handle, const PointLight& light);
+    void SetSpotLight(LightHandle handle, const SpotLight& light);
+    void SetPosition(LightHandle handle, const Vector3& position);
+
+    // Once per frame, after the lights moved
+    void Update(const LightView& view, float dt);
+
+    // The GPU buffers' content, the lighting pass loops over the first GetSlotCount slots
+    std::span<const GpuPointLight> GetGpuPointLights() const noexcept { return gpuPointLights; }
+    std::span<const GpuSpotLight> GetGpuSpotLights() const noexcept { return gpuSpotLights; }
+    uint32_t GetSlotCount(LightType type) const noexcept { return GetPool(type).slotCount; }
+    // Slots rewritten since the last call, to upload
+    DirtyRange TakeDirtyRange(LightType type) noexcept;
+
+    // Of the last update, 0 when the light has no slot
+    float GetFade(LightHandle handle) const noexcept;
+    float GetImportance(LightHandle handle) const noexcept;
+
+    Settings& GetSettings() noexcept { return settings; }
+    const Stats& GetStats() const noexcept { return stats; }
+
+#ifdef _IMGUI_
+    void RenderImGui();
+#endif
+};
+
+}
@@ -23,6 +23,44 @@ inline D3D11_INPUT_ELEMENT_DESC DEFAULT_ELEMENT_LAYOUT[] = {
 
 inline UINT DEFAULT_ELEMENT_COUNT = ARRAYSIZE(DEFAULT_ELEMENT_LAYOUT);
 
+// How the vertices of a mesh are stored in its vertex buffer, the CPU side always keeps full MeshVertex
+enum class VertexFormat : uint8_t
+{
+    // 56 bytes, MeshVertex as is
+    FULL,
+    // 24 bytes, float position, octahedral normal and tangent with the handedness, 16 bits UVs
+    COMPACT,
+    // 20 bytes, same as COMPACT with the position in 16 bits relative to the mesh bounds
+    COMPACT_QUANTIZED_POSITION,
+};
+
+// Normal and tangent share NORMAL0, the UV format depends on whether the mesh UVs stay in [0, 1]
+template <DXGI_FORMAT PositionFormat, DXGI_FORMAT UvFormat>
+inline D3D11_INPUT_ELEMENT_DESC COMPACT_ELEMENT_LAYOUT[] = {
+    {"POSITION", 0, PositionFormat, 0, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_VERTEX_DATA, 0},
+    {"NORMAL", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_VERTEX_DATA, 0},
+    {"TEXCOORD", 0, UvFormat, 0, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_VERTEX_DATA, 0},
+    {"MODEL_MATRIX", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    {"MODEL_MATRIX", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    {"MODEL_MATRIX", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    {"MODEL_MATRIX", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    {"INV_MODEL_MATRIX", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    {"INV_MODEL_MATRIX", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    {"INV_MODEL_MATRIX", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    {"INV_MODEL_MATRIX", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_INSTANCE_DATA, 1},
+};
+
+// Depth only passes read the position and the model matrix, this one is for the quantized positions
+inline D3D11_INPUT_ELEMENT_DESC QUANTIZED_POSITION_DEPTH_LAYOUT[] = {
+    {"POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_VERTEX_DATA, 0},
+    {"MODEL_MATRIX", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    {"MODEL_MATRIX", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    {"MODEL_MATRIX", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    {"MODEL_MATRIX", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT , D3D11_INPUT_PER_INSTANCE_DATA, 1},
+};
+
+inline UINT QUANTIZED_POSITION_DEPTH_ELEMENT_COUNT = ARRAYSIZE(QUANTIZED_POSITION_DEPTH_LAYOUT);
+
 struct MeshVertex
 {
     MeshVertex() = default;
@@ -35,6 +73,25 @@ struct MeshVertex
     void SwitchHandRule();
 };
 
+struct CompactMeshVertex
+{
+    Vector3 position;
+    // Octahedral normal in xy, octahedral tangent in zw with the handedness as the sign of w
+    int16_t normalTangent[4];
+    // UNORM or half floats
+    uint16_t uv[2];
+};
+
+struct QuantizedMeshVertex
+{
+    // UNORM over the mesh bounds, w is padding
+    uint16_t position[4];
+    int16_t normalTangent[4];
+    uint16_t uv[2];
+};
+
+static_assert(sizeof(CompactMeshVertex) == 24 && sizeof(QuantizedMeshVertex) == 20);
+
 struct InstanceVertex
 {
     static UINT elementCount;
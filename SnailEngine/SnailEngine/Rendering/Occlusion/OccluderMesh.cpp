@@ -0,0 +1,103 @@
+#include "stdafx.h"
+#include "OccluderMesh.h"
+
+#include <unordered_map>
+
+namespace Snail
+{
+
+OccluderMesh OccluderMesh::FromTriangles(const std::span<const MeshVertex> vertices, const std::span<const uint32_t> indices)
+{
+    OccluderMesh occluder;
+    occluder.indices.reserve(indices.size());
+
+    std::unordered_map<uint32_t, uint32_t> remap;
+    for (const uint32_t index : indices)
+    {
+        const auto [it, inserted] = remap.try_emplace(index, static_cast<uint32_t>(occluder.positions.size()));
+        if (inserted)
+            occluder.positions.push_back(vertices[index].position);
+        occluder.indices.push_back(it->second);
+    }
+    return occluder;
+}
+
+OccluderMesh OccluderMesh::FromHeightField(const std::span<const MeshVertex> vertices, const uint32_t width, const uint32_t height)
+{
+    OccluderMesh occluder;
+    if (width < 2 || height < 2 || vertices.size() < static_cast<size_t>(width) * height)
+        return occluder;
+
+    // Every HEIGHTFIELD_STEP vertices, the last row and column always being kept
+    const auto getSamples = [](const uint32_t count)
+    {
+        std::vector<uint32_t> samples;
+        for (uint32_t i = 0; i < count - 1; i += HEIGHTFIELD_STEP)
+            samples.push_back(i);
+        samples.push_back(count - 1);
+        return samples;
+    };
+    const std::vector<uint32_t> columns = getSamples(width);
+    const std::vector<uint32_t> rows = getSamples(height);
+
+    occluder.positions.reserve(columns.size() * rows.size());
+    for (size_t row = 0; row < rows.size(); ++row)
+    {
+        const uint32_t firstY = rows[row == 0 ? 0 : row - 1];
+        const uint32_t lastY = rows[std::min(row + 1, rows.size() - 1)];
+        for (size_t column = 0; column < columns.size(); ++column)
+        {
+            const uint32_t firstX = columns[column == 0 ? 0 : column - 1];
+            const uint32_t lastX = columns[std::min(column + 1, columns.size() - 1)];
+
+            // Lowest over the cells around the vertex, the coarse triangles can't go above any of the vertices they replace
+            float lowest = std::numeric_limits<float>::max();
+            for (uint32_t y = firstY; y <= lastY; ++y)
+            {
+                for (uint32_t x = firstX; x <= lastX; ++x)
+                    lowest = std::min(lowest, vertices[x + y * width].position.y);
+            }
+
+            Vector3 position = vertices[columns[column] + rows[row] * width].position;
+            position.y = lowest;
+            occluder.positions.push_back(position);
+        }
+    }
+
+    const auto columnCount = static_cast<uint32_t>(columns.size());
+    occluder.indices.reserve((columns.size() - 1) * (rows.size() - 1) * 6);
+    for (uint32_t row = 0; row + 1 < rows.size(); ++row)
+    {
+        for (uint32_t column = 0; column + 1 < columnCount; ++column)
+        {
+            const uint32_t topLeft = column + row * columnCount;
+            const uint32_t bottomLeft = topLeft + columnCount;
+            occluder.indices.insert(occluder.indices.end(), {topLeft + 1, topLeft, bottomLeft, topLeft + 1, bottomLeft, bottomLeft + 1});
+        }
+    }
+    return occluder;
+}
+
+const OccluderMesh& OccluderMesh::GetUnitBox()
+{
+    static const OccluderMesh box = []
+    {
+        OccluderMesh cube;
+        for (int corner = 0; corner < 8; ++corner)
+            cube.positions.emplace_back((corner & 1) ? 0.5f : -0.5f, (corner & 2) ? 0.5f : -0.5f, (corner & 4) ? 0.5f : -0.5f);
+
+        // Two triangles per face, occluders are drawn without face culling so the winding doesn't matter
+        cube.indices = {
+            0, 1, 3, 0, 3, 2,
+            4, 6, 7, 4, 7, 5,
+            0, 4, 5, 0, 5, 1,
+            2, 3, 7, 2, 7, 6,
+            0, 2, 6, 0, 6, 4,
+            1, 5, 7, 1, 7, 3,
+        };
+        return cube;
+    }();
+    return box;
+}
+
+}
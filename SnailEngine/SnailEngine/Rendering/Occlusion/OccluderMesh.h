@@ -0,0 +1,42 @@
+#pragma once
+#include <span>
+#include <vector>
+
+#include "Rendering/MeshVertex.h"
+
+namespace Snail
+{
+
+enum class OccluderType : uint8_t
+{
+    NONE,
+    // Simplified geometry of the entity's mesh
+    MESH,
+    // Bounds of the entity's mesh, or a unit cube scaled by the transform like invisible walls when it has none
+    BOX,
+};
+
+// Geometry rendered into the occlusion buffer. It must not cover more of the screen than what it stands for,
+// everything behind the difference would be culled.
+struct OccluderMesh
+{
+    // Coarsest LOD error accepted for an occluder, relative to the mesh size, coarser LODs bulge out too much
+    static constexpr float MAX_LOD_ERROR = 0.01f;
+    // Heightfield vertices merged along each axis into one occluder vertex
+    static constexpr uint32_t HEIGHTFIELD_STEP = 4;
+
+    std::vector<Vector3> positions;
+    std::vector<uint32_t> indices;
+
+    [[nodiscard]] size_t GetTriangleCount() const noexcept { return indices.size() / 3; }
+
+    // Only the vertices used by the triangles are kept
+    [[nodiscard]] static OccluderMesh FromTriangles(std::span<const MeshVertex> vertices, std::span<const uint32_t> indices);
+    // Coarser grid of a width * height grid of vertices, each vertex takes the lowest height around it so that the
+    // occluder stays under the terrain
+    [[nodiscard]] static OccluderMesh FromHeightField(std::span<const MeshVertex> vertices, uint32_t width, uint32_t height);
+    // Cube from -0.5 to 0.5
+    [[nodiscard]] static const OccluderMesh& GetUnitBox();
+};
+
+}
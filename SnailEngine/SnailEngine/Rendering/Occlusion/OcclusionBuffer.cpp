@@ -0,0 +1,285 @@
+#include "stdafx.h"
+#include "OcclusionBuffer.h"
+
+#include <emmintrin.h>
+
+namespace Snail
+{
+
+OcclusionBuffer::OcclusionBuffer()
+    : depth(static_cast<size_t>(WIDTH) * HEIGHT)
+    , tileFarthestDepth(static_cast<size_t>(TILES_X) * TILES_Y)
+{}
+
+void OcclusionBuffer::Clear(const uint32_t firstRow, const uint32_t endRow) noexcept
+{
+    std::fill(depth.begin() + firstRow * WIDTH, depth.begin() + endRow * WIDTH, 0.0f);
+}
+
+void OcclusionBuffer::ProjectTriangles(const std::span<const Vector3> positions, const std::span<const uint32_t> indices, const Matrix& worldViewProjection, std::vector<ScreenTriangle>& triangles)
+{
+    const auto toScreen = [](const Vector4& clip)
+    {
+        const float invW = 1.0f / clip.w;
+        return Vector3{(clip.x * invW * 0.5f + 0.5f) * static_cast<float>(WIDTH), (0.5f - clip.y * invW * 0.5f) * static_cast<float>(HEIGHT), clip.z * invW};
+    };
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::array<Vector4, 3> clip;
+        for (size_t corner = 0; corner < 3; ++corner)
+        {
+            const Vector3& position = positions[indices[i + corner]];
+            clip[corner] = Vector4::Transform(Vector4{position.x, position.y, position.z, 1.0f}, worldViewProjection);
+        }
+
+        // Entirely on the outer side of one of the view planes, the far plane being at z = 0
+        const auto allOutside = [&clip](auto&& isOutside) { return std::ranges::all_of(clip, isOutside); };
+        if (allOutside([](const Vector4& c) { return c.x > c.w; }) || allOutside([](const Vector4& c) { return c.x < -c.w; })
+            || allOutside([](const Vector4& c) { return c.y > c.w; }) || allOutside([](const Vector4& c) { return c.y < -c.w; })
+            || allOutside([](const Vector4& c) { return c.z < 0; }))
+            continue;
+
+        // Near plane clipping, the reversed depth puts it at z = w
+        std::array<Vector4, 4> polygon;
+        size_t cornerCount = 0;
+        for (size_t corner = 0; corner < 3; ++corner)
+        {
+            const Vector4& a = clip[corner];
+            const Vector4& b = clip[(corner + 1) % 3];
+            const float distanceA = a.w - a.z;
+            const float distanceB = b.w - b.z;
+            if (distanceA >= 0)
+                polygon[cornerCount++] = a;
+            if ((distanceA >= 0) != (distanceB >= 0))
+                polygon[cornerCount++] = a + (b - a) * (distanceA / (distanceA - distanceB));
+        }
+
+        for (size_t corner = 1; corner + 1 < cornerCount; ++corner)
+            triangles.push_back({toScreen(polygon[0]), toScreen(polygon[corner]), toScreen(polygon[corner + 1])});
+    }
+}
+
+bool OcclusionBuffer::SetupTriangle(const ScreenTriangle& triangle, const uint32_t firstRow, const uint32_t endRow, TriangleSetup& setup) noexcept
+{
+    const auto& [v0, v1, v2] = triangle.vertices;
+
+    // Pixels whose center is within the bounds, clamped before converting since clipped vertices can be far off screen
+    const float minY = std::max(std::ceil(std::min({v0.y, v1.y, v2.y}) - 0.5f), static_cast<float>(firstRow));
+    const float maxY = std::min(std::floor(std::max({v0.y, v1.y, v2.y}) - 0.5f), static_cast<float>(endRow) - 1);
+    const float minX = std::max(std::ceil(std::min({v0.x, v1.x, v2.x}) - 0.5f), 0.0f);
+    const float maxX = std::min(std::floor(std::max({v0.x, v1.x, v2.x}) - 0.5f), static_cast<float>(WIDTH) - 1);
+    if (minY > maxY || minX > maxX)
+        return false;
+
+    for (size_t edge = 0; edge < 3; ++edge)
+    {
+        const Vector3& a = triangle.vertices[edge];
+        const Vector3& b = triangle.vertices[(edge + 1) % 3];
+        setup.edgeA[edge] = static_cast<double>(a.y) - b.y;
+        setup.edgeB[edge] = static_cast<double>(b.x) - a.x;
+        setup.edgeC[edge] = static_cast<double>(a.x) * b.y - static_cast<double>(a.y) * b.x;
+    }
+
+    // The first edge at the opposite vertex, twice the signed area
+    double area = setup.edgeA[0] * v2.x + setup.edgeB[0] * v2.y + setup.edgeC[0];
+    if (area == 0)
+        return false;
+
+    // Occluders have no face culling, the inside is made positive whatever the winding
+    if (area < 0)
+    {
+        for (size_t edge = 0; edge < 3; ++edge)
+        {
+            setup.edgeA[edge] = -setup.edgeA[edge];
+            setup.edgeB[edge] = -setup.edgeB[edge];
+            setup.edgeC[edge] = -setup.edgeC[edge];
+        }
+        area = -area;
+    }
+
+    // Each vertex is weighted by the edge facing it
+    setup.depthA = (setup.edgeA[1] * v0.z + setup.edgeA[2] * v1.z + setup.edgeA[0] * v2.z) / area;
+    setup.depthB = (setup.edgeB[1] * v0.z + setup.edgeB[2] * v1.z + setup.edgeB[0] * v2.z) / area;
+    setup.depthC = (setup.edgeC[1] * v0.z + setup.edgeC[2] * v1.z + setup.edgeC[0] * v2.z) / area;
+    setup.depthSlope = static_cast<float>(0.5 * (std::abs(setup.depthA) + std::abs(setup.depthB)));
+    setup.farthestDepth = std::min({v0.z, v1.z, v2.z});
+
+    setup.minX = static_cast<uint32_t>(minX);
+    setup.maxX = static_cast<uint32_t>(maxX);
+    setup.minY = static_cast<uint32_t>(minY);
+    setup.maxY = static_cast<uint32_t>(maxY);
+    return true;
+}
+
+void OcclusionBuffer::Rasterize(const std::span<const ScreenTriangle> triangles, const uint32_t firstRow, const uint32_t endRow) noexcept
+{
+    static_assert(WIDTH % 4 == 0);
+    const __m128 laneOffsets = _mm_setr_ps(0, 1, 2, 3);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (const ScreenTriangle& triangle : triangles)
+    {
+        TriangleSetup setup;
+        if (!SetupTriangle(triangle, firstRow, endRow, setup))
+            continue;
+
+        // Groups of 4 pixels aligned on the row, the width being a multiple of 4 they never leave it
+        const uint32_t startX = setup.minX & ~3u;
+        const double startCenterX = startX + 0.5;
+
+        std::array<__m128, 3> edgeLanes;
+        std::array<__m128, 3> edgeSteps;
+        for (size_t edge = 0; edge < 3; ++edge)
+        {
+            edgeLanes[edge] = _mm_mul_ps(laneOffsets, _mm_set1_ps(static_cast<float>(setup.edgeA[edge])));
+            edgeSteps[edge] = _mm_set1_ps(static_cast<float>(setup.edgeA[edge] * 4));
+        }
+        const __m128 depthLanes = _mm_mul_ps(laneOffsets, _mm_set1_ps(static_cast<float>(setup.depthA)));
+        const __m128 depthStep = _mm_set1_ps(static_cast<float>(setup.depthA * 4));
+        const __m128 depthSlope = _mm_set1_ps(setup.depthSlope);
+        const __m128 farthestDepth = _mm_set1_ps(setup.farthestDepth);
+
+        for (uint32_t y = setup.minY; y <= setup.maxY; ++y)
+        {
+            const double centerY = y + 0.5;
+
+            // Each row starts from double precision, the edge constants get large when vertices are far off screen
+            std::array<__m128, 3> edges;
+            for (size_t edge = 0; edge < 3; ++edge)
+            {
+                const double rowStart = setup.edgeA[edge] * startCenterX + setup.edgeB[edge] * centerY + setup.edgeC[edge];
+                edges[edge] = _mm_add_ps(_mm_set1_ps(static_cast<float>(rowStart)), edgeLanes[edge]);
+            }
+            const double rowStartDepth = setup.depthA * startCenterX + setup.depthB * centerY + setup.depthC;
+            __m128 planeDepth = _mm_add_ps(_mm_set1_ps(static_cast<float>(rowStartDepth)), depthLanes);
+
+            float* row = depth.data() + static_cast<size_t>(y) * WIDTH;
+            for (uint32_t x = startX; x <= setup.maxX; x += 4)
+            {
+                const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edges[0], zero), _mm_cmpge_ps(edges[1], zero)), _mm_cmpge_ps(edges[2], zero));
+                if (_mm_movemask_ps(inside) != 0)
+                {
+                    const __m128 pixelDepth = _mm_max_ps(_mm_sub_ps(planeDepth, depthSlope), farthestDepth);
+                    const __m128 current = _mm_loadu_ps(row + x);
+                    const __m128 nearest = _mm_max_ps(current, pixelDepth);
+                    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+                }
+
+                for (size_t edge = 0; edge < 3; ++edge)
+                    edges[edge] = _mm_add_ps(edges[edge], edgeSteps[edge]);
+                planeDepth = _mm_add_ps(planeDepth, depthStep);
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::RasterizeReference(const std::span<const ScreenTriangle> triangles) noexcept
+{
+    for (const ScreenTriangle& triangle : triangles)
+    {
+        TriangleSetup setup;
+        if (!SetupTriangle(triangle, 0, HEIGHT, setup))
+            continue;
+
+        for (uint32_t y = setup.minY; y <= setup.maxY; ++y)
+        {
+            const double centerY = y + 0.5;
+            for (uint32_t x = setup.minX; x <= setup.maxX; ++x)
+            {
+                const double centerX = x + 0.5;
+                bool inside = true;
+                for (size_t edge = 0; edge < 3; ++edge)
+                    inside &= setup.edgeA[edge] * centerX + setup.edgeB[edge] * centerY + setup.edgeC[edge] >= 0;
+                if (!inside)
+                    continue;
+
+                const double planeDepth = setup.depthA * centerX + setup.depthB * centerY + setup.depthC;
+                const float pixelDepth = std::max(static_cast<float>(planeDepth) - setup.depthSlope, setup.farthestDepth);
+                float& pixel = depth[x + y * WIDTH];
+                pixel = std::max(pixel, pixelDepth);
+            }
+        }
+    }
+}
+
+void OcclusionBuffer::UpdateTiles(const uint32_t firstRow, const uint32_t endRow) noexcept
+{
+    static_assert(TILE_SIZE == 8, "Tiles are read as two groups of 4 pixels per row");
+    for (uint32_t tileY = firstRow / TILE_SIZE; tileY < endRow / TILE_SIZE; ++tileY)
+    {
+        for (uint32_t tileX = 0; tileX < TILES_X; ++tileX)
+        {
+            __m128 farthest = _mm_set1_ps(std::numeric_limits<float>::max());
+            for (uint32_t y = tileY * TILE_SIZE; y < (tileY + 1) * TILE_SIZE; ++y)
+            {
+                const float* pixels = depth.data() + static_cast<size_t>(y) * WIDTH + tileX * TILE_SIZE;
+                farthest = _mm_min_ps(farthest, _mm_min_ps(_mm_loadu_ps(pixels), _mm_loadu_ps(pixels + 4)));
+            }
+            farthest = _mm_min_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(1, 0, 3, 2)));
+            farthest = _mm_min_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(2, 3, 0, 1)));
+            tileFarthestDepth[tileX + tileY * TILES_X] = _mm_cvtss_f32(farthest);
+        }
+    }
+}
+
+bool OcclusionBuffer::IsOccluded(const DirectX::BoundingBox& bb, const Matrix& viewProjection) const noexcept
+{
+    std::array<Vector3, 8> corners;
+    bb.GetCorners(corners.data());
+
+    float minX = std::numeric_limits<float>::max(), minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest(), maxY = std::numeric_limits<float>::lowest();
+    // Depth is projective, the nearest point of the box is one of its corners
+    float nearestDepth = 0;
+    for (const Vector3& corner : corners)
+    {
+        const Vector4 clip = Vector4::Transform(Vector4{corner.x, corner.y, corner.z, 1.0f}, viewProjection);
+        if (clip.w <= 0 || clip.z > clip.w)
+            return false;
+
+        const float invW = 1.0f / clip.w;
+        const float x = (clip.x * invW * 0.5f + 0.5f) * static_cast<float>(WIDTH);
+        const float y = (0.5f - clip.y * invW * 0.5f) * static_cast<float>(HEIGHT);
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearestDepth = std::max(nearestDepth, clip.z * invW);
+    }
+
+    // Off screen boxes are the frustum culling's business
+    if (maxX < 0 || maxY < 0 || minX > static_cast<float>(WIDTH) || minY > static_cast<float>(HEIGHT))
+        return false;
+
+    // The pixels the box touches and their neighbours. Occluders only cover the pixels whose center they contain,
+    // when an occluder edge crosses a pixel one of its neighbours is left uncovered.
+    const auto x0 = static_cast<uint32_t>(std::max(std::floor(minX) - 1, 0.0f));
+    const auto x1 = static_cast<uint32_t>(std::min(std::ceil(maxX), static_cast<float>(WIDTH) - 1));
+    const auto y0 = static_cast<uint32_t>(std::max(std::floor(minY) - 1, 0.0f));
+    const auto y1 = static_cast<uint32_t>(std::min(std::ceil(maxY), static_cast<float>(HEIGHT) - 1));
+
+    for (uint32_t tileY = y0 / TILE_SIZE; tileY <= y1 / TILE_SIZE; ++tileY)
+    {
+        for (uint32_t tileX = x0 / TILE_SIZE; tileX <= x1 / TILE_SIZE; ++tileX)
+        {
+            if (nearestDepth < tileFarthestDepth[tileX + tileY * TILES_X])
+                continue;
+
+            // Part of the tile is farther than the box, only the pixels under it decide
+            const uint32_t tileMaxY = std::min(y1, (tileY + 1) * TILE_SIZE - 1);
+            const uint32_t tileMaxX = std::min(x1, (tileX + 1) * TILE_SIZE - 1);
+            for (uint32_t y = std::max(y0, tileY * TILE_SIZE); y <= tileMaxY; ++y)
+            {
+                for (uint32_t x = std::max(x0, tileX * TILE_SIZE); x <= tileMaxX; ++x)
+                {
+                    if (depth[x + y * WIDTH] <= nearestDepth)
+                        return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <array>
+#include <span>
+#include <vector>
+
+namespace Snail
+{
+
+// Low resolution depth buffer the occluders are rasterized into on the CPU. Depth is reversed like the G-buffer's,
+// 1 on the near plane and 0 on the far plane. Every tile also keeps its farthest depth so that most box tests
+// don't read pixels.
+class OcclusionBuffer
+{
+public:
+    static constexpr uint32_t WIDTH = 256;
+    static constexpr uint32_t HEIGHT = 128;
+    static constexpr uint32_t TILE_SIZE = 8;
+    static constexpr uint32_t TILES_X = WIDTH / TILE_SIZE;
+    static constexpr uint32_t TILES_Y = HEIGHT / TILE_SIZE;
+
+    // x and y in pixels, z is the depth
+    struct ScreenTriangle
+    {
+        std::array<Vector3, 3> vertices;
+    };
+
+private:
+    // Edge functions and depth plane of a triangle, they are evaluated at pixel centers
+    struct TriangleSetup
+    {
+        std::array<double, 3> edgeA, edgeB, edgeC;
+        double depthA, depthB, depthC;
+        // Half the depth change over a pixel, takes the depth to the farthest point of the pixel
+        float depthSlope;
+        float farthestDepth;
+        uint32_t minX, maxX, minY, maxY;
+    };
+
+    std::vector<float> depth;
+    std::vector<float> tileFarthestDepth;
+
+    // False when the triangle covers no pixel center in the rows
+    static bool SetupTriangle(const ScreenTriangle& triangle, uint32_t firstRow, uint32_t endRow, TriangleSetup& setup) noexcept;
+
+public:
+    OcclusionBuffer();
+
+    // Clears rows [firstRow, endRow) to the far plane
+    void Clear(uint32_t firstRow = 0, uint32_t endRow = HEIGHT) noexcept;
+
+    // Clips the triangles against the near plane and appends those that can be on screen
+    static void ProjectTriangles(std::span<const Vector3> positions, std::span<const uint32_t> indices, const Matrix& worldViewProjection, std::vector<ScreenTriangle>& triangles);
+
+    // Only touches rows [firstRow, endRow), so that jobs can share the buffer by bands of rows. Pixels keep the
+    // nearest depth, triangles cover the pixels whose center they contain like on the GPU.
+    void Rasterize(std::span<const ScreenTriangle> triangles, uint32_t firstRow = 0, uint32_t endRow = HEIGHT) noexcept;
+    // Same coverage and depth one pixel at a time in double precision, the SIMD rasterizer is checked against it
+    void RasterizeReference(std::span<const ScreenTriangle> triangles) noexcept;
+    // Must be called after rasterizing, the rows must start and end on tiles
+    void UpdateTiles(uint32_t firstRow = 0, uint32_t endRow = HEIGHT) noexcept;
+
+    // Conservative, false as soon as part of the box could be in front of the occluders or crosses the near plane
+    [[nodiscard]] bool IsOccluded(const DirectX::BoundingBox& bb, const Matrix& viewProjection) const noexcept;
+
+    [[nodiscard]] float GetDepth(uint32_t x, uint32_t y) const noexcept { return depth[x + y * WIDTH]; }
+};
+
+}
@@ -0,0 +1,121 @@
+#include "stdafx.h"
+#include "OcclusionCulling.h"
+
+#include <chrono>
+#include <thread>
+
+#include "Core/WindowsEngine.h"
+#include "Rendering/FrameView.h"
+
+namespace Snail
+{
+
+void OcclusionCulling::Render(const FrameView& view)
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    Target& target = targets[view.frameIndex % targets.size()];
+    target.stats = {};
+    target.isRendered = false;
+    if (!view.occlusionEnabled)
+        return;
+
+    const auto start = Clock::now();
+    Rasterize(view.occluders, view.cullingCamera.viewProjection, std::thread::hardware_concurrency(), target);
+    target.stats.rasterizeMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+void OcclusionCulling::UseFrame(const uint64_t frameIndex)
+{
+    testedTarget = &targets[frameIndex % targets.size()];
+}
+
+void OcclusionCulling::Rasterize(const std::span<const Occluder> occluders, const Matrix& viewProjection, size_t jobCount, Target& target)
+{
+    static_assert(OcclusionBuffer::HEIGHT % BAND_HEIGHT == 0 && BAND_HEIGHT % OcclusionBuffer::TILE_SIZE == 0);
+    static ThreadPool& pool = WindowsEngine::GetModule<ThreadPool>();
+
+    target.viewProjection = viewProjection;
+
+    jobCount = std::clamp(occluders.size() / MIN_OCCLUDERS_PER_JOB, size_t{1}, std::max(jobCount, size_t{1}));
+    if (jobTriangles.size() < jobCount)
+        jobTriangles.resize(jobCount);
+
+    const auto projectOccluders = [&occluders, &viewProjection](const size_t begin, const size_t end, std::vector<OcclusionBuffer::ScreenTriangle>& triangles)
+    {
+        triangles.clear();
+        for (size_t i = begin; i < end; ++i)
+            OcclusionBuffer::ProjectTriangles(occluders[i].mesh->positions, occluders[i].mesh->indices, occluders[i].world * viewProjection, triangles);
+    };
+
+    // Not from the frame arena, the preparation can run past the end of the frame
+    handles.clear();
+
+    // Every job projects a range of the occluders into its own list of triangles
+    if (jobCount == 1)
+    {
+        projectOccluders(0, occluders.size(), jobTriangles[0]);
+    }
+    else
+    {
+        const size_t batchSize = (occluders.size() + jobCount - 1) / jobCount;
+        for (size_t job = 0; job < jobCount; ++job)
+        {
+            const size_t begin = std::min(job * batchSize, occluders.size());
+            const size_t end = std::min(begin + batchSize, occluders.size());
+            handles.push_back(pool.AddWaitableTask([&projectOccluders, begin, end, &triangles = jobTriangles[job]] { projectOccluders(begin, end, triangles); }));
+        }
+
+        for (const ThreadPool::TaskHandle& handle : handles)
+            pool.WaitFor(handle);
+        handles.clear();
+    }
+
+    // Then every job rasterizes all of them into its own band of rows, bands share neither pixels nor tiles
+    const std::span<const std::vector<OcclusionBuffer::ScreenTriangle>> triangleLists{jobTriangles.data(), jobCount};
+    for (uint32_t firstRow = 0; firstRow < OcclusionBuffer::HEIGHT; firstRow += BAND_HEIGHT)
+    {
+        handles.push_back(pool.AddWaitableTask([&buffer = target.buffer, triangleLists, firstRow]
+        {
+            const uint32_t endRow = firstRow + BAND_HEIGHT;
+            buffer.Clear(firstRow, endRow);
+            for (const std::vector<OcclusionBuffer::ScreenTriangle>& triangles : triangleLists)
+                buffer.Rasterize(triangles, firstRow, endRow);
+            buffer.UpdateTiles(firstRow, endRow);
+        }));
+    }
+
+    for (const ThreadPool::TaskHandle& handle : handles)
+        pool.WaitFor(handle);
+
+    target.stats.occluderCount = occluders.size();
+    for (const std::vector<OcclusionBuffer::ScreenTriangle>& triangles : triangleLists)
+        target.stats.triangleCount += triangles.size();
+    target.isRendered = true;
+}
+
+bool OcclusionCulling::IsOccluded(const DirectX::BoundingBox& bb)
+{
+    if (!testedTarget || !testedTarget->isRendered)
+        return false;
+
+    const bool occluded = testedTarget->buffer.IsOccluded(bb, testedTarget->viewProjection);
+    ++testedTarget->stats.testedCount;
+    testedTarget->stats.culledCount += occluded;
+    return occluded;
+}
+
+void OcclusionCulling::RenderImGui()
+{
+#ifdef _IMGUI_
+    ImGui::SeparatorText("Occlusion Culling");
+    ImGui::Checkbox("Occlusion Culling", &enabled);
+
+    const Stats stats = testedTarget ? testedTarget->stats : Stats{};
+    ImGui::Text("Occluders: %zu, triangles: %zu, rasterized in %.3f ms", stats.occluderCount, stats.triangleCount, stats.rasterizeMs);
+    const float culledPercent = stats.testedCount ? 100.0f * static_cast<float>(stats.culledCount) / static_cast<float>(stats.testedCount) : 0.0f;
+    ImGui::Text("Culled %zu of %zu boxes (%.1f%%)", stats.culledCount, stats.testedCount, culledPercent);
+#endif
+}
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <span>
+#include <vector>
+
+#include "OccluderMesh.h"
+#include "OcclusionBuffer.h"
+#include "Core/ThreadPool.h"
+
+namespace Snail
+{
+struct FrameView;
+
+// Software occlusion culling of the camera view. The occluders extracted with the frame view are rasterized into an
+// OcclusionBuffer on the job system during the render preparation, then entity bounds are tested against it before
+// their instances are submitted. Shadow views don't use it, what the camera doesn't see can still cast visible shadows.
+// There is a buffer per frame in flight, the preparation of a frame writes one while the boxes are tested against the
+// other.
+class OcclusionCulling
+{
+public:
+    // Rows rasterized by one job, every band starting on a tile
+    static constexpr uint32_t BAND_HEIGHT = 16;
+    // Below this many occluders per job, projecting costs less than scheduling
+    static constexpr size_t MIN_OCCLUDERS_PER_JOB = 8;
+
+    struct Stats
+    {
+        size_t occluderCount = 0;
+        // On screen after near plane clipping
+        size_t triangleCount = 0;
+        size_t testedCount = 0;
+        size_t culledCount = 0;
+        float rasterizeMs = 0;
+    };
+
+    struct Occluder
+    {
+        const OccluderMesh* mesh;
+        Matrix world;
+    };
+
+private:
+    struct Target
+    {
+        OcclusionBuffer buffer;
+        Matrix viewProjection;
+        // Whether the buffer holds the occluders of its frame
+        bool isRendered = false;
+        Stats stats;
+    };
+
+    std::array<Target, 2> targets;
+    // Selected by UseFrame, the boxes are tested against it
+    Target* testedTarget = nullptr;
+
+    // Reused every frame
+    std::vector<std::vector<OcclusionBuffer::ScreenTriangle>> jobTriangles;
+    std::vector<ThreadPool::TaskHandle> handles;
+
+    // Projects the occluders and rasterizes them, both in parallel
+    void Rasterize(std::span<const Occluder> occluders, const Matrix& viewProjection, size_t jobCount, Target& target);
+
+public:
+    // Read on the main thread when the frame view is extracted
+    bool enabled = true;
+
+    // Rasterizes the occluders of the view into the buffer of its frame, on the render preparation thread
+    void Render(const FrameView& view);
+    // Tests the boxes against the buffer of a frame whose Render is done
+    void UseFrame(uint64_t frameIndex);
+
+    // False when nothing was rendered for the tested frame
+    [[nodiscard]] bool IsOccluded(const DirectX::BoundingBox& bb);
+
+    void RenderImGui();
+};
+
+}
@@ -0,0 +1,258 @@
+#include "stdafx.h"
+#include "ParticleBuffer.h"
+
+#include <emmintrin.h>
+
+namespace Snail
+{
+
+namespace
+{
+constexpr float HALF_PI = 1.57079632679f;
+constexpr float PI = 3.14159265359f;
+constexpr float TWO_PI = 6.28318530718f;
+
+// Cosine of 4 angles, within 1e-6 after reducing the angles to [-pi, pi]. DirectXMath is built without intrinsics
+// so its vector functions are scalar.
+__m128 Cos(__m128 x)
+{
+    const __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.0f / TWO_PI))));
+    x = _mm_sub_ps(x, _mm_mul_ps(turns, _mm_set1_ps(TWO_PI)));
+
+    // cos(x) = -cos(pi - |x|) brings the angle to [0, pi / 2]
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    x = _mm_andnot_ps(signBit, x);
+    const __m128 mirrored = _mm_cmpgt_ps(x, _mm_set1_ps(HALF_PI));
+    x = _mm_or_ps(_mm_and_ps(mirrored, _mm_sub_ps(_mm_set1_ps(PI), x)), _mm_andnot_ps(mirrored, x));
+
+    // Taylor series up to x^10
+    const __m128 x2 = _mm_mul_ps(x, x);
+    __m128 result = _mm_set1_ps(-1.0f / 3628800.0f);
+    result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(1.0f / 40320.0f));
+    result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(-1.0f / 720.0f));
+    result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(1.0f / 24.0f));
+    result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(-0.5f));
+    result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(1.0f));
+    return _mm_xor_ps(result, _mm_and_ps(mirrored, signBit));
+}
+
+// Alpha multiplier of the fade, the age over an infinite lifetime gives 0
+float GetFade(const float age, const float lifetime, const float endAlpha)
+{
+    return 1.0f + (endAlpha - 1.0f) * std::min(age / lifetime, 1.0f);
+}
+}
+
+size_t ParticleBuffer::GetPaddedCount(const size_t particleCount) noexcept
+{
+    return (particleCount + LANE_COUNT - 1) / LANE_COUNT * LANE_COUNT;
+}
+
+uint32_t ParticleBuffer::PackColor(const float r, const float g, const float b, const float a) noexcept
+{
+    const auto toByte = [](const float channel)
+    {
+        return static_cast<uint32_t>(std::nearbyint(std::clamp(channel, 0.0f, 1.0f) * 255.0f));
+    };
+    return toByte(r) | toByte(g) << 8 | toByte(b) << 16 | toByte(a) << 24;
+}
+
+void ParticleBuffer::Resize(const size_t particleCount)
+{
+    const size_t paddedCount = GetPaddedCount(particleCount);
+    if (packedColors.size() >= paddedCount)
+        return;
+
+    // Geometric growth, emitters add their particles one at a time
+    const size_t capacity = std::max(paddedCount, packedColors.size() * 2);
+    for (std::vector<float>& stream : streams)
+        stream.resize(capacity);
+    packedColors.resize(capacity);
+    lights.resize(capacity, NO_LIGHT);
+}
+
+void ParticleBuffer::MoveParticle(const size_t from, const size_t to) noexcept
+{
+    for (std::vector<float>& stream : streams)
+        stream[to] = stream[from];
+    packedColors[to] = packedColors[from];
+    lights[to] = lights[from];
+}
+
+void ParticleBuffer::Emit(const Particle& particle)
+{
+    Resize(count + 1);
+
+    const size_t i = count++;
+    streams[POSITION_X][i] = particle.position.x;
+    streams[POSITION_Y][i] = particle.position.y;
+    streams[POSITION_Z][i] = particle.position.z;
+    streams[VELOCITY_X][i] = particle.velocity.x;
+    streams[VELOCITY_Y][i] = particle.velocity.y;
+    streams[VELOCITY_Z][i] = particle.velocity.z;
+    streams[AGE][i] = 0;
+    streams[LIFETIME][i] = particle.lifetime;
+    streams[PHASE][i] = particle.phase;
+    streams[SIZE_X][i] = particle.size.x;
+    streams[SIZE_Y][i] = particle.size.y;
+    streams[COLOR_R][i] = particle.color.x;
+    streams[COLOR_G][i] = particle.color.y;
+    streams[COLOR_B][i] = particle.color.z;
+    streams[COLOR_A][i] = particle.color.w;
+    // Drawable before its first update
+    packedColors[i] = PackColor(particle.color.x, particle.color.y, particle.color.z, particle.color.w);
+    lights[i] = particle.light;
+}
+
+void ParticleBuffer::Clear() noexcept
+{
+    count = 0;
+}
+
+Vector3 ParticleBuffer::GetPosition(const size_t particle) const noexcept
+{
+    return {streams[POSITION_X][particle], streams[POSITION_Y][particle], streams[POSITION_Z][particle]};
+}
+
+void ParticleBuffer::Integrate(const float deltaTime, const UpdateParams& params) noexcept
+{
+    float* positionX = streams[POSITION_X].data();
+    float* positionY = streams[POSITION_Y].data();
+    float* positionZ = streams[POSITION_Z].data();
+    float* velocityX = streams[VELOCITY_X].data();
+    float* velocityY = streams[VELOCITY_Y].data();
+    float* velocityZ = streams[VELOCITY_Z].data();
+    float* age = streams[AGE].data();
+    const float* phase = streams[PHASE].data();
+
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 accelerationX = _mm_set1_ps(params.acceleration.x * deltaTime);
+    const __m128 accelerationY = _mm_set1_ps(params.acceleration.y * deltaTime);
+    const __m128 accelerationZ = _mm_set1_ps(params.acceleration.z * deltaTime);
+    const __m128 hoverFrequency = _mm_set1_ps(params.hoverFrequency);
+    // Derivative of the hovering offset, amplitude * sin(frequency * age + phase)
+    const __m128 hoverSpeed = _mm_set1_ps(params.hoverAmplitude * params.hoverFrequency);
+
+    const size_t paddedCount = GetPaddedCount(count);
+    for (size_t i = 0; i < paddedCount; i += LANE_COUNT)
+    {
+        const __m128 newAge = _mm_add_ps(_mm_loadu_ps(age + i), dt);
+        _mm_storeu_ps(age + i, newAge);
+
+        const __m128 newVelocityX = _mm_add_ps(_mm_loadu_ps(velocityX + i), accelerationX);
+        const __m128 newVelocityY = _mm_add_ps(_mm_loadu_ps(velocityY + i), accelerationY);
+        const __m128 newVelocityZ = _mm_add_ps(_mm_loadu_ps(velocityZ + i), accelerationZ);
+        _mm_storeu_ps(velocityX + i, newVelocityX);
+        _mm_storeu_ps(velocityY + i, newVelocityY);
+        _mm_storeu_ps(velocityZ + i, newVelocityZ);
+
+        const __m128 hover = _mm_mul_ps(hoverSpeed, Cos(_mm_add_ps(_mm_mul_ps(hoverFrequency, newAge), _mm_loadu_ps(phase + i))));
+        _mm_storeu_ps(positionX + i, _mm_add_ps(_mm_loadu_ps(positionX + i), _mm_mul_ps(newVelocityX, dt)));
+        _mm_storeu_ps(positionY + i, _mm_add_ps(_mm_loadu_ps(positionY + i), _mm_mul_ps(_mm_add_ps(newVelocityY, hover), dt)));
+        _mm_storeu_ps(positionZ + i, _mm_add_ps(_mm_loadu_ps(positionZ + i), _mm_mul_ps(newVelocityZ, dt)));
+    }
+}
+
+void ParticleBuffer::UpdateColors(const UpdateParams& params) noexcept
+{
+    const float* age = streams[AGE].data();
+    const float* lifetime = streams[LIFETIME].data();
+    const float* colorR = streams[COLOR_R].data();
+    const float* colorG = streams[COLOR_G].data();
+    const float* colorB = streams[COLOR_B].data();
+    const float* colorA = streams[COLOR_A].data();
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 fadeRange = _mm_set1_ps(params.endAlpha - 1.0f);
+    const auto toByte = [zero, one](const __m128 channel)
+    {
+        return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(channel, zero), one), _mm_set1_ps(255.0f)));
+    };
+
+    const size_t paddedCount = GetPaddedCount(count);
+    for (size_t i = 0; i < paddedCount; i += LANE_COUNT)
+    {
+        const __m128 progress = _mm_min_ps(_mm_div_ps(_mm_loadu_ps(age + i), _mm_loadu_ps(lifetime + i)), one);
+        const __m128 alpha = _mm_mul_ps(_mm_loadu_ps(colorA + i), _mm_add_ps(one, _mm_mul_ps(fadeRange, progress)));
+
+        __m128i packed = toByte(_mm_loadu_ps(colorR + i));
+        packed = _mm_or_si128(packed, _mm_slli_epi32(toByte(_mm_loadu_ps(colorG + i)), 8));
+        packed = _mm_or_si128(packed, _mm_slli_epi32(toByte(_mm_loadu_ps(colorB + i)), 16));
+        packed = _mm_or_si128(packed, _mm_slli_epi32(toByte(alpha), 24));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(packedColors.data() + i), packed);
+    }
+}
+
+size_t ParticleBuffer::RemoveExpired() noexcept
+{
+    const float* age = streams[AGE].data();
+    const float* lifetime = streams[LIFETIME].data();
+
+    size_t removed = 0;
+    for (size_t block = 0; block < count; block += LANE_COUNT)
+    {
+        // Most blocks have no expired particle
+        if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(age + block), _mm_loadu_ps(lifetime + block))) == 0)
+            continue;
+
+        // The particle moved in is checked in turn
+        for (size_t i = block; i < std::min(block + LANE_COUNT, count);)
+        {
+            if (age[i] >= lifetime[i])
+            {
+                MoveParticle(--count, i);
+                ++removed;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+    return removed;
+}
+
+void ParticleBuffer::Update(const float deltaTime, const UpdateParams& params) noexcept
+{
+    Integrate(deltaTime, params);
+    UpdateColors(params);
+    RemoveExpired();
+}
+
+void ParticleBuffer::UpdateReference(const float deltaTime, const UpdateParams& params) noexcept
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float age = streams[AGE][i] += deltaTime;
+        const float velocityX = streams[VELOCITY_X][i] += params.acceleration.x * deltaTime;
+        const float velocityY = streams[VELOCITY_Y][i] += params.acceleration.y * deltaTime;
+        const float velocityZ = streams[VELOCITY_Z][i] += params.acceleration.z * deltaTime;
+
+        const float hover = params.hoverAmplitude * params.hoverFrequency * std::cos(params.hoverFrequency * age + streams[PHASE][i]);
+        streams[POSITION_X][i] += velocityX * deltaTime;
+        streams[POSITION_Y][i] += (velocityY + hover) * deltaTime;
+        streams[POSITION_Z][i] += velocityZ * deltaTime;
+
+        const float alpha = streams[COLOR_A][i] * GetFade(age, streams[LIFETIME][i], params.endAlpha);
+        packedColors[i] = PackColor(streams[COLOR_R][i], streams[COLOR_G][i], streams[COLOR_B][i], alpha);
+    }
+
+    for (size_t i = 0; i < count;)
+    {
+        if (streams[AGE][i] >= streams[LIFETIME][i])
+            MoveParticle(--count, i);
+        else
+            ++i;
+    }
+}
+
+void ParticleBuffer::WriteInstances(const uint32_t alignment, std::vector<ParticleInstance>& instances) const
+{
+    const size_t first = instances.size();
+    instances.resize(first + count);
+    for (size_t i = 0; i < count; ++i)
+        instances[first + i] = {GetPosition(i), {streams[SIZE_X][i], streams[SIZE_Y][i]}, packedColors[i], alignment};
+}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "Rendering/MeshVertex.h"
+
+namespace Snail
+{
+
+// One camera facing quad, the vertex shader expands it around the position. 28 bytes instead of the two matrices of
+// InstanceVertex.
+struct ParticleInstance
+{
+    Vector3 position;
+    // Width and height of the quad in world units
+    Vector2 size;
+    // R8G8B8A8 UNORM, multiplies the texture
+    uint32_t color;
+    // Billboard::BillboardType
+    uint32_t alignment;
+};
+
+static_assert(sizeof(ParticleInstance) == 28);
+
+// The quad corners come from the MeshVertex of the billboard mesh, the rest from the particle instances
+inline D3D11_INPUT_ELEMENT_DESC PARTICLE_ELEMENT_LAYOUT[] = {
+    {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(MeshVertex, position), D3D11_INPUT_PER_VERTEX_DATA, 0},
+    {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(MeshVertex, uv), D3D11_INPUT_PER_VERTEX_DATA, 0},
+    {"PARTICLE_POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    {"PARTICLE_SIZE", 0, DXGI_FORMAT_R32G32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    {"PARTICLE_COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+    {"PARTICLE_ALIGNMENT", 0, DXGI_FORMAT_R32_UINT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+};
+
+inline UINT PARTICLE_ELEMENT_COUNT = ARRAYSIZE(PARTICLE_ELEMENT_LAYOUT);
+
+// Particles of an emitter stored as a structure of arrays, so that the update kernels move 4 particles per SSE
+// instruction. The arrays are padded to a multiple of 4 particles, the padding is updated and never read back.
+class ParticleBuffer
+{
+public:
+    // Particles processed together by the kernels
+    static constexpr size_t LANE_COUNT = 4;
+    static constexpr int32_t NO_LIGHT = -1;
+
+    struct Particle
+    {
+        Vector3 position;
+        Vector3 velocity;
+        Vector2 size{1, 1};
+        Vector4 color{1, 1, 1, 1};
+        // In seconds, particles live forever by default
+        float lifetime = std::numeric_limits<float>::infinity();
+        // Offset of the hovering, in radians
+        float phase = 0;
+        // Index of the light following the particle, in the emitter's list of lights
+        int32_t light = NO_LIGHT;
+    };
+
+    struct UpdateParams
+    {
+        Vector3 acceleration;
+        // Vertical oscillation added to the velocity, fireflies hover around where they were emitted
+        float hoverAmplitude = 0;
+        // In radians per second
+        float hoverFrequency = 1;
+        // Alpha multiplier at the end of the lifetime, the particles fade linearly towards it
+        float endAlpha = 1;
+    };
+
+private:
+    enum Stream : uint8_t
+    {
+        POSITION_X, POSITION_Y, POSITION_Z,
+        VELOCITY_X, VELOCITY_Y, VELOCITY_Z,
+        AGE, LIFETIME, PHASE,
+        SIZE_X, SIZE_Y,
+        COLOR_R, COLOR_G, COLOR_B, COLOR_A,
+        STREAM_COUNT
+    };
+
+    size_t count = 0;
+    std::array<std::vector<float>, STREAM_COUNT> streams;
+    // Written by UpdateColors, what the instances are drawn with
+    std::vector<uint32_t> packedColors;
+    std::vector<int32_t> lights;
+
+    // Rounds up to the padding of the arrays
+    static size_t GetPaddedCount(size_t particleCount) noexcept;
+    // Rounds like the SIMD conversion, to the nearest even
+    static uint32_t PackColor(float r, float g, float b, float a) noexcept;
+    void Resize(size_t particleCount);
+    void MoveParticle(size_t from, size_t to) noexcept;
+
+public:
+    void Emit(const Particle& particle);
+    void Clear() noexcept;
+    [[nodiscard]] size_t GetCount() const noexcept { return count; }
+    [[nodiscard]] Vector3 GetPosition(size_t particle) const noexcept;
+    [[nodiscard]] uint32_t GetPackedColor(size_t particle) const noexcept { return packedColors[particle]; }
+
+    // Ages, accelerates and moves the particles
+    void Integrate(float deltaTime, const UpdateParams& params) noexcept;
+    // Fades the alpha over the lifetime and packs the colors
+    void UpdateColors(const UpdateParams& params) noexcept;
+    // Swaps the particles that outlived their lifetime with the last ones, returns how many were removed
+    size_t RemoveExpired() noexcept;
+    // All three kernels, in order
+    void Update(float deltaTime, const UpdateParams& params) noexcept;
+    // Same math one particle at a time, the kernels are checked against it
+    void UpdateReference(float deltaTime, const UpdateParams& params) noexcept;
+
+    // Calls setLightPosition(light, position) for every particle bound to a light
+    template <class F>
+    void ForEachBoundLight(F&& setLightPosition) const;
+
+    // Appends an instance per particle
+    void WriteInstances(uint32_t alignment, std::vector<ParticleInstance>& instances) const;
+};
+
+template <class F>
+void ParticleBuffer::ForEachBoundLight(F&& setLightPosition) const
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (lights[i] != NO_LIGHT)
+            setLightPosition(lights[i], GetPosition(i));
+    }
+}
+
+}
@@ -0,0 +1,75 @@
+#include "stdafx.h"
+#include "RenderPrepThread.h"
+
+#include <chrono>
+
+#include "FrameView.h"
+
+namespace Snail
+{
+
+RenderPrepThread::RenderPrepThread(PrepareFunction prepareFunction)
+    : prepare{std::move(prepareFunction)}
+    , thread{[this] { Run(); }}
+{}
+
+RenderPrepThread::~RenderPrepThread()
+{
+    {
+        std::lock_guard lock{mutex};
+        shouldStop = true;
+    }
+    condition.notify_all();
+    thread.join();
+}
+
+void RenderPrepThread::Run()
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    std::unique_lock lock{mutex};
+    while (true)
+    {
+        condition.wait(lock, [this] { return shouldStop || pendingView; });
+        if (!pendingView)
+            return;
+
+        const FrameView& view = *pendingView;
+        lock.unlock();
+
+        const auto start = Clock::now();
+        prepare(view);
+        const float prepareMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+        lock.lock();
+        pendingView = nullptr;
+        preparedFrame = view.frameIndex;
+        lastPrepareMs = prepareMs;
+        condition.notify_all();
+    }
+}
+
+void RenderPrepThread::Submit(const FrameView& view)
+{
+    {
+        std::unique_lock lock{mutex};
+        condition.wait(lock, [this] { return !pendingView; });
+        pendingView = &view;
+    }
+    condition.notify_all();
+}
+
+std::optional<uint64_t> RenderPrepThread::Wait()
+{
+    std::unique_lock lock{mutex};
+    condition.wait(lock, [this] { return !pendingView; });
+    return preparedFrame;
+}
+
+float RenderPrepThread::GetLastPrepareMs()
+{
+    std::lock_guard lock{mutex};
+    return lastPrepareMs;
+}
+
+}
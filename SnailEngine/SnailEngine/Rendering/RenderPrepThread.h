@@ -0,0 +1,49 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace Snail
+{
+struct FrameView;
+
+// Runs the render preparation of the frame views on its own thread. At most one view is in flight: Submit waits for
+// the previous one, so the preparation is never more than a frame behind the main thread.
+class RenderPrepThread
+{
+public:
+    using PrepareFunction = std::function<void(const FrameView&)>;
+
+private:
+    PrepareFunction prepare;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    // Submitted and not prepared yet
+    const FrameView* pendingView = nullptr;
+    std::optional<uint64_t> preparedFrame;
+    float lastPrepareMs = 0;
+    bool shouldStop = false;
+
+    // Last, so that it starts once the rest is initialised
+    std::thread thread;
+
+    void Run();
+
+public:
+    explicit RenderPrepThread(PrepareFunction prepareFunction);
+    RenderPrepThread(const RenderPrepThread&) = delete;
+    RenderPrepThread& operator=(const RenderPrepThread&) = delete;
+    // Prepares the view in flight before stopping
+    ~RenderPrepThread();
+
+    // The view must not change until it is prepared
+    void Submit(const FrameView& view);
+    // Waits for the last submitted view, returns its frame index. Empty when nothing was ever submitted.
+    std::optional<uint64_t> Wait();
+    float GetLastPrepareMs();
+};
+
+}
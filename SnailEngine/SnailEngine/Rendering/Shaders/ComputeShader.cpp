@@ -71,6 +71,19 @@ void ComputeShader::BindComputedUAV(ID3D11UnorderedAccessView* uav)
     device->GetImmediateContext()->CSSetUnorderedAccessViews(0, 1, &uav, nullptr);
 }
 
+void ComputeShader::BindUAV(const int slot, ID3D11UnorderedAccessView* uav)
+{
+    static D3D11Device* device = WindowsEngine::GetInstance().GetRenderDevice();
+    device->GetImmediateContext()->CSSetUnorderedAccessViews(slot, 1, &uav, nullptr);
+}
+
+void ComputeShader::UnbindUAV(const int slot)
+{
+    static D3D11Device* device = WindowsEngine::GetInstance().GetRenderDevice();
+    ID3D11UnorderedAccessView* uav[] = { nullptr };
+    device->GetImmediateContext()->CSSetUnorderedAccessViews(slot, 1, uav, nullptr);
+}
+
 void ComputeShader::BindSRVAndSampler(const int slot, ID3D11ShaderResourceView* srv, ID3D11SamplerState* samplerState)
 {
     BindSRV(slot, srv);
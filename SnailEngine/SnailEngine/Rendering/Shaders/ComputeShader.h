@@ -25,6 +25,8 @@ public:
      * <b>DOES NOT MANAGE IF THERE ARE MORE THAN ONE UAV TO BIND!!</b>
      */
     void BindComputedUAV(ID3D11UnorderedAccessView* uav);
+    void BindUAV(int slot, ID3D11UnorderedAccessView* uav);
+    void UnbindUAV(int slot);
     void BindSRVAndSampler(int slot, ID3D11ShaderResourceView* srv, ID3D11SamplerState* samplerState);
     void BindSampler(int slot, ID3D11SamplerState* samplerState);
     void BindSRV(int slot, ID3D11ShaderResourceView* srv);
@@ -2,6 +2,7 @@
 #include "DirectionalShadowMap.h"
 
 #include "Core/WindowsEngine.h"
+#include "Core/Mesh/Mesh.h"
 #include "Entities/Entity.h"
 #include "Entities/Terrain.h"
 #include "Rendering/MeshVertex.h"
@@ -12,6 +13,7 @@ namespace Snail
 DirectionalShadowMap::DirectionalShadowMap(D3D11Device* device)
     : renderDevice(device)
     , vsShader{L"SnailEngine/Shaders/WriteToDepth.vs.hlsl", DEFAULT_ELEMENT_LAYOUT, DEFAULT_ELEMENT_COUNT}
+    , quantizedVsShader{L"SnailEngine/Shaders/WriteToDepth.vs.hlsl", QUANTIZED_POSITION_DEPTH_LAYOUT, QUANTIZED_POSITION_DEPTH_ELEMENT_COUNT}
     , psShader{L"SnailEngine/Shaders/WriteToDepth.ps.hlsl"}
     , cascadeShadowBuffer{D3D11Buffer::CreateConstantBuffer<CascadeShadowData[CASCADE_COUNT * SceneData::MAX_DIR_LIGHTS]>()}
     , viewProjBuffer{D3D11Buffer::CreateConstantBuffer<Matrix>()}
@@ -100,30 +102,9 @@ Texture2D* DirectionalShadowMap::GetDepthTexture() const
     return shadowMap.get();
 }
 
-std::pair<Matrix, DirectX::BoundingOrientedBox> DirectionalShadowMap::GetLightSpaceMatrix(const DirectionalLight& light, const int cascadeId)
+DirectionalShadowMap::CascadeInfo DirectionalShadowMap::FitCascade(const Matrix& cascadeFrustum, const Vector3& lightDirection)
 {
-    static auto& cameraManager = WindowsEngine::GetModule<CameraManager>();
-    const Camera* camera = cameraManager.GetFirstPerspectiveCamera();
-#ifdef _DEBUG
-    if (drawCascades)
-        camera = cameraManager.GetCamera(0);
-#endif
-
-    auto& [n, f] = cascades[cascadeId];
-
-    if (n == f)
-        return { Matrix::Identity, DirectX::BoundingOrientedBox() };
-
-    const std::vector frustrumPoints = GetFrustumCornersWorldSpace(camera->GetViewMatrix() * camera->GetProjectionMatrix(n, f));
-#ifdef _DEBUG
-    if (drawCascades)
-    {
-        static auto& renderer = WindowsEngine::GetModule<RendererModule>();
-        DirectX::BoundingFrustum frustum{camera->GetProjectionMatrix(n, f)};
-        frustum.Transform(frustum, camera->GetViewMatrix().Invert());
-        renderer.DrawFrustum(frustum, Color{ 1,0,1 });
-    }
-#endif
+    const std::array frustrumPoints = GetFrustumCornersWorldSpace(cascadeFrustum);
 
     Vector3 center{};
     for (const Vector3& v : frustrumPoints)
@@ -131,15 +112,15 @@ std::pair<Matrix, DirectX::BoundingOrientedBox> DirectionalShadowMap::GetLightSp
     center /= static_cast<float>(frustrumPoints.size());
 
 
-    Vector3 cross = light.Direction;
+    Vector3 cross = lightDirection;
     cross.x += 1;
     cross.z -= 1;
 
     Vector3 result;
-    light.Direction.Cross(cross, result);
+    lightDirection.Cross(cross, result);
     result.Normalize();
 
-    const Matrix viewMatrix = Matrix::CreateLookAt(center, center + light.Direction, result);
+    const Matrix viewMatrix = Matrix::CreateLookAt(center, center + lightDirection, result);
 
     float minX = std::numeric_limits<float>::max();
     float maxX = std::numeric_limits<float>::lowest();
@@ -162,26 +143,77 @@ std::pair<Matrix, DirectX::BoundingOrientedBox> DirectionalShadowMap::GetLightSp
     minZ -= 20;
     maxZ += 20;
 
-    auto inv = viewMatrix.Invert();
+    const Matrix inv = viewMatrix.Invert();
 
     DirectX::BoundingOrientedBox boundingBox{ {}, { maxX - minX, maxY - minY, maxZ - minZ }, Quaternion::Identity };
     boundingBox.Transform(boundingBox, inv);
 
+    const Matrix projection = Matrix::CreateOrthographicOffCenter(minX, maxX, minY, maxY, maxZ, minZ);
+    return { viewMatrix * projection, boundingBox };
+}
+
+std::array<std::optional<Matrix>, DirectionalShadowMap::CASCADE_COUNT> DirectionalShadowMap::GetCascadeFrustums()
+{
+    static auto& cameraManager = WindowsEngine::GetModule<CameraManager>();
+    const Camera* camera = cameraManager.GetFirstPerspectiveCamera();
+#ifdef _DEBUG
+    if (drawCascades)
+        camera = cameraManager.GetCamera(0);
+#endif
+
+    std::array<std::optional<Matrix>, CASCADE_COUNT> frustums;
+    for (int i = 0; i < CASCADE_COUNT; ++i)
+    {
+        auto& [n, f] = cascades[i];
+        if (n == f)
+            continue;
+
+        frustums[i] = camera->GetViewMatrix() * camera->GetProjectionMatrix(n, f);
+#ifdef _DEBUG
+        if (drawCascades)
+        {
+            static auto& renderer = WindowsEngine::GetModule<RendererModule>();
+            DirectX::BoundingFrustum frustum{camera->GetProjectionMatrix(n, f)};
+            frustum.Transform(frustum, camera->GetViewMatrix().Invert());
+            renderer.DrawFrustum(frustum, Color{ 1,0,1 });
+        }
+#endif
+    }
+    return frustums;
+}
+
+void DirectionalShadowMap::PrepareCascades(const FrameView& view)
+{
+    CascadeInfos& infos = cascadeInfos[view.frameIndex % cascadeInfos.size()];
+    for (size_t lightI = 0; lightI < view.directionalLights.size(); ++lightI)
+    {
+        const DirectionalLight& light = view.directionalLights[lightI];
+        if (!light.castsShadows)
+            continue;
+
+        for (size_t i = 0; i < CASCADE_COUNT; ++i)
+        {
+            const std::optional<Matrix>& cascadeFrustum = view.cascadeFrustums[i];
+            infos[lightI * CASCADE_COUNT + i] = cascadeFrustum
+                ? FitCascade(*cascadeFrustum, light.Direction)
+                : CascadeInfo{ Matrix::Identity, DirectX::BoundingOrientedBox() };
+        }
+    }
+}
+
+void DirectionalShadowMap::UseFrame(const uint64_t frameIndex)
+{
+    usedCascadeInfos = &cascadeInfos[frameIndex % cascadeInfos.size()];
+
 #ifdef _DEBUG
     if (drawCascades)
     {
         constexpr Color blue{0,0,1};
         static auto& renderer = WindowsEngine::GetModule<RendererModule>();
-        renderer.DrawBoundingBox(boundingBox, blue);
-
-        constexpr Color red{1,0,0};
-        renderer.DrawLine({ Vector3::Transform({ 1, 0, 0 }, inv), red }, { Vector3::Transform({ -1, 0, 0 }, inv), red });
-        renderer.DrawLine({ Vector3::Transform({ 0, 1, 0 }, inv), red }, { Vector3::Transform({ 0, -1, 0 }, inv), red });
-        renderer.DrawLine({ Vector3::Transform({ 0, 0, 1 }, inv), red }, { Vector3::Transform({ 0, 0, -1 }, inv), red });
+        for (int i = 0; i < CASCADE_COUNT; ++i)
+            renderer.DrawBoundingBox((*usedCascadeInfos)[i].second, blue);
     }
 #endif
-    const Matrix projection = Matrix::CreateOrthographicOffCenter(minX, maxX, minY, maxY, maxZ, minZ);
-    return { viewMatrix * projection, boundingBox };
 }
 
 const D3D11Buffer& DirectionalShadowMap::GetViewProjBuffer(const std::vector<DirectionalLight>& lights)
@@ -201,7 +233,7 @@ const D3D11Buffer& DirectionalShadowMap::GetViewProjBuffer(const std::vector<Dir
                 cascades[i].first.value_or(camera->GetNearPlane()),
                 cascades[i].second.value_or(camera->GetFarPlane())
             };
-            data[lightI * CASCADE_COUNT + i].matrix = cascadeInfo[i].first.Transpose();
+            data[lightI * CASCADE_COUNT + i].matrix = (*usedCascadeInfos)[lightI * CASCADE_COUNT + i].first.Transpose();
         }
     }
 
@@ -223,6 +255,8 @@ void DirectionalShadowMap::Render(const FixedVector<DirectionalLight, SceneData:
     ID3D11UnorderedAccessView* nullUAV = nullptr;
     context->OMSetRenderTargetsAndUnorderedAccessViews(1, &nullRTV, nullptr, 1, 1, &nullUAV, nullptr);
 
+    static_assert(1 + SceneData::MAX_DIR_LIGHTS * CASCADE_COUNT <= MAX_LOD_VIEWS, "Every cascade needs its LOD view");
+
     // Repeat this for each section of the cascade
     for (int lightI = 0; lightI < lights.size(); ++lightI)
     {
@@ -237,9 +271,10 @@ void DirectionalShadowMap::Render(const FixedVector<DirectionalLight, SceneData:
             context->ClearDepthStencilView(depthStencilView[dvIndex], D3D11_CLEAR_DEPTH, 0, 0);
             context->RSSetViewports(1, &viewport);
 
-            cascadeInfo[i] = GetLightSpaceMatrix(lights[lightI], i);
+            const auto& [cascadeViewProj, cascadeBox] = (*usedCascadeInfos)[dvIndex];
 
-            ShadowDrawContext ctx{ &renderer, device, cascadeInfo[i].second };
+            // The camera uses the first LOD view
+            ShadowDrawContext ctx{ &renderer, device, cascadeBox, static_cast<uint8_t>(1 + dvIndex) };
 
             for (Entity* entity : scene->GetEntities())
             {
@@ -247,7 +282,7 @@ void DirectionalShadowMap::Render(const FixedVector<DirectionalLight, SceneData:
                 if (!entity->ShouldCastShadows())
                     continue;
 
-                viewProjBuffer.UpdateData(cascadeInfo[i].first.Transpose());
+                viewProjBuffer.UpdateData(cascadeViewProj.Transpose());
                 vsShader.SetConstantBuffer(0, viewProjBuffer.GetBuffer());
 
                 vsShader.Bind();
@@ -257,17 +292,22 @@ void DirectionalShadowMap::Render(const FixedVector<DirectionalLight, SceneData:
                 entity->Draw(ctx);
             }
 
-            renderer.DrawMeshesGeometry();
+            // Compact vertices keep a float position first, so only the quantized ones need another input layout
+            renderer.DrawMeshesGeometry([](BaseMesh* mesh) { return mesh->GetVertexFormat() != VertexFormat::COMPACT_QUANTIZED_POSITION; });
+
+            quantizedVsShader.SetConstantBuffer(0, viewProjBuffer.GetBuffer());
+            quantizedVsShader.Bind();
+            renderer.DrawMeshesGeometry([](BaseMesh* mesh) { return mesh->GetVertexFormat() == VertexFormat::COMPACT_QUANTIZED_POSITION; });
 
             for (GrassGenerator* grassPatch : scene->GetGrassPatches())
             {
-                if (!cascadeInfo[i].second.Intersects(grassPatch->GetBoundingBox()))
+                if (!cascadeBox.Intersects(grassPatch->GetBoundingBox()))
                     continue;
 
-                viewProjBuffer.UpdateData(cascadeInfo[i].first.Transpose());
+                viewProjBuffer.UpdateData(cascadeViewProj.Transpose());
                 device->GetImmediateContext()->RSSetState(shadowRS);
 
-                grassPatch->DrawShadows(viewProjBuffer);
+                grassPatch->DrawShadows(ctx, viewProjBuffer);
             }
         }
     }
@@ -319,10 +359,11 @@ void DirectionalShadowMap::RenderImGui()
     }
 #endif
 }
-ShadowDrawContext::ShadowDrawContext(RendererModule* rm, D3D11Device* dev, const DirectX::BoundingOrientedBox& obb)
+ShadowDrawContext::ShadowDrawContext(RendererModule* rm, D3D11Device* dev, const DirectX::BoundingOrientedBox& obb, const uint8_t cascadeView)
     : DrawContext(rm, dev)
     , sumObb{obb}
 {
+    lodView = cascadeView;
 }
 bool ShadowDrawContext::ShouldBeCulled(const DirectX::BoundingBox& bb)
 {
@@ -336,4 +377,8 @@ bool ShadowDrawContext::ShouldBeCulled(const DirectX::BoundingSphere& bs)
 {
     return !sumObb.Intersects(bs);
 }
+float ShadowDrawContext::GetScreenCoverage(const DirectX::BoundingSphere& bs)
+{
+    return bs.Radius / std::max({sumObb.Extents.x, sumObb.Extents.y, 1e-3f});
+}
 }
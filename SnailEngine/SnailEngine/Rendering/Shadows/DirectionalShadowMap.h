@@ -11,6 +11,7 @@
 #include "Core/SceneParser.h"
 #include "Core/DataStructures/FixedVector.h"
 #include "Rendering/DrawContext.h"
+#include "Rendering/FrameView.h"
 #include "Rendering/Buffers/D3D11Buffer.h"
 #include "Rendering/Shaders/PixelShader.h"
 #include "Rendering/Shaders/VertexShader.h"
@@ -27,7 +28,7 @@ namespace Snail
 
 	class DirectionalShadowMap : public ShadowMap
 	{
-		static constexpr uint8_t CASCADE_COUNT = 6;
+		static constexpr uint8_t CASCADE_COUNT = SHADOW_CASCADE_COUNT;
 
 		std::vector<std::pair<std::optional<float>, std::optional<float>>> cascades = {
 			{{}, 10.0f},
@@ -45,6 +46,8 @@ namespace Snail
 		D3D11_VIEWPORT viewport;
 
 		VertexShader vsShader;
+		// Same shader for the meshes with 16 bits positions
+		VertexShader quantizedVsShader;
 		PixelShader psShader;
 
 		struct DX_ALIGN CascadeShadowData
@@ -60,14 +63,27 @@ namespace Snail
         bool drawCascades = false;
 #endif
 
-        std::array<std::pair<Matrix, DirectX::BoundingOrientedBox>, CASCADE_COUNT> cascadeInfo;
+        using CascadeInfo = std::pair<Matrix, DirectX::BoundingOrientedBox>;
+        using CascadeInfos = std::array<CascadeInfo, CASCADE_COUNT * SceneData::MAX_DIR_LIGHTS>;
+
+        // Fitted by the render preparation of every frame in flight, for every cascade of every light
+        std::array<CascadeInfos, 2> cascadeInfos;
+        // Selected by UseFrame
+        const CascadeInfos* usedCascadeInfos = &cascadeInfos[0];
 
 	public:
 		DirectionalShadowMap(D3D11Device* device);
 		~DirectionalShadowMap();
 
 		Texture2D* GetDepthTexture() const;
-        std::pair<Matrix, DirectX::BoundingOrientedBox> GetLightSpaceMatrix(const DirectionalLight& light, int cascadeId);
+        // Orthographic light view projection around the part of the camera frustum covered by a cascade
+        static CascadeInfo FitCascade(const Matrix& cascadeFrustum, const Vector3& lightDirection);
+        // View projection of the camera for every cascade range, extracted with the frame view
+        std::array<std::optional<Matrix>, CASCADE_COUNT> GetCascadeFrustums();
+        // Fits the cascades of the view's lights, on the render preparation thread
+        void PrepareCascades(const FrameView& view);
+        // Draws and samples the cascades of a frame whose PrepareCascades is done
+        void UseFrame(uint64_t frameIndex);
 		const D3D11Buffer& GetViewProjBuffer(const std::vector<DirectionalLight>& lights);
 		void Render(const FixedVector<DirectionalLight, SceneData::MAX_DIR_LIGHTS>& lights);
         void RenderImGui();
@@ -77,10 +93,12 @@ namespace Snail
     {
         const DirectX::BoundingOrientedBox& sumObb;
     public:
-        ShadowDrawContext(RendererModule* rm, D3D11Device* dev, const DirectX::BoundingOrientedBox& obb);
+        ShadowDrawContext(RendererModule* rm, D3D11Device* dev, const DirectX::BoundingOrientedBox& obb, uint8_t cascadeView);
 
         bool ShouldBeCulled(const DirectX::BoundingBox&) override;
         bool ShouldBeCulled(const DirectX::BoundingOrientedBox&) override;
         bool ShouldBeCulled(const DirectX::BoundingSphere&) override;
+        // Relative to the cascade, which covers the whole shadow map
+        float GetScreenCoverage(const DirectX::BoundingSphere& bs) override;
     };
 }
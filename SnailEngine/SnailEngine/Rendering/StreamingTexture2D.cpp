@@ -0,0 +1,207 @@
+#include "stdafx.h"
+#include "StreamingTexture2D.h"
+
+#include <d3d11.h>
+#include <filesystem>
+
+#include "stb_image.h"
+
+#include "Core/WindowsEngine.h"
+#include "Core/Assets/TextureStreamingScheduler.h"
+#include "Core/WindowsResource/resource.h"
+
+namespace Snail
+{
+
+namespace
+{
+
+constexpr uint32_t BYTES_PER_TEXEL = TextureStreamingScheduler::BYTES_PER_TEXEL;
+
+// Averages every 2x2 block of the previous mip, edges are clamped for odd sizes
+std::vector<uint8_t> Downsample(const std::vector<uint8_t>& source, const uint32_t sourceWidth, const uint32_t sourceHeight)
+{
+    const uint32_t width = std::max(1u, sourceWidth >> 1);
+    const uint32_t height = std::max(1u, sourceHeight >> 1);
+    std::vector<uint8_t> mip(static_cast<size_t>(width) * height * BYTES_PER_TEXEL);
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const uint32_t y0 = std::min(y * 2, sourceHeight - 1);
+        const uint32_t y1 = std::min(y * 2 + 1, sourceHeight - 1);
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint32_t x0 = std::min(x * 2, sourceWidth - 1);
+            const uint32_t x1 = std::min(x * 2 + 1, sourceWidth - 1);
+            for (uint32_t c = 0; c < BYTES_PER_TEXEL; ++c)
+            {
+                const auto texel = [&](const uint32_t tx, const uint32_t ty) { return static_cast<uint32_t>(source[(static_cast<size_t>(ty) * sourceWidth + tx) * BYTES_PER_TEXEL + c]); };
+                const uint32_t sum = texel(x0, y0) + texel(x1, y0) + texel(x0, y1) + texel(x1, y1);
+                mip[(static_cast<size_t>(y) * width + x) * BYTES_PER_TEXEL + c] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+    return mip;
+}
+
+}
+
+StreamingTexture2D::StreamingTexture2D(const std::string& textureFilename)
+    : filename{textureFilename}
+{
+    if (!std::filesystem::exists(filename))
+        throw FileNotFoundException(filename);
+
+    // Only the header is read here, the image is decoded on a worker thread once the streamer needs it
+    int imageWidth, imageHeight, components;
+    if (!stbi_info(filename.c_str(), &imageWidth, &imageHeight, &components))
+        throw SnailException(("Unsupported image format: " + filename).c_str());
+
+    width = static_cast<uint32_t>(imageWidth);
+    height = static_cast<uint32_t>(imageHeight);
+    mipCount = TextureStreamingScheduler::GetMipCount(width, height);
+
+    Texture::InitSampler();
+}
+
+bool StreamingTexture2D::CanStream(const std::string& filename)
+{
+    int imageWidth, imageHeight, components;
+    return std::filesystem::exists(filename) && stbi_info(filename.c_str(), &imageWidth, &imageHeight, &components);
+}
+
+StreamingTexture2D::MipChain StreamingTexture2D::DecodeMipChain(const std::string& filename, const uint32_t width, const uint32_t height, const uint32_t mipCount)
+{
+    const Image image(filename);
+    if (!image.GetData() || static_cast<uint32_t>(image.GetWidth()) != width || static_cast<uint32_t>(image.GetHeight()) != height)
+        throw SnailException(("Could not decode image: " + filename).c_str());
+
+    MipChain chain;
+    chain.levels.reserve(mipCount);
+    chain.levels.emplace_back(image.GetData(), image.GetData() + static_cast<size_t>(width) * height * BYTES_PER_TEXEL);
+
+    for (uint32_t mip = 1; mip < mipCount; ++mip)
+        chain.levels.push_back(Downsample(chain.levels.back(), std::max(1u, width >> (mip - 1)), std::max(1u, height >> (mip - 1))));
+
+    return chain;
+}
+
+size_t StreamingTexture2D::SetResidentMipCount(const uint32_t count, const MipChain* source)
+{
+    static D3D11Device* renderDevice = WindowsEngine::GetInstance().GetRenderDevice();
+
+    if (count == residentMipCount)
+        return 0;
+
+    if (count == 0)
+    {
+        std::lock_guard lock{DeviceMutex};
+        DX_RELEASE(shaderResourceView);
+        DX_RELEASE(rawTexture);
+        shaderResourceView = nullptr;
+        rawTexture = nullptr;
+        residentMipCount = 0;
+        return 0;
+    }
+
+    const uint32_t topMip = mipCount - count;
+    const uint32_t previousTopMip = mipCount - residentMipCount;
+
+    D3D11_TEXTURE2D_DESC desc{};
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.Width = std::max(1u, width >> topMip);
+    desc.Height = std::max(1u, height >> topMip);
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.MipLevels = count;
+    desc.ArraySize = 1;
+    desc.SampleDesc.Count = 1;
+
+    ID3D11Texture2D* texture = nullptr;
+    DX_CALL(renderDevice->GetD3DDevice()->CreateTexture2D(&desc, nullptr, &texture), DXE_ERROR_CREATING_TEXTURE);
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc{};
+    viewDesc.Format = desc.Format;
+    viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    viewDesc.Texture2D.MipLevels = count;
+    ID3D11ShaderResourceView* view = nullptr;
+    DX_CALL(renderDevice->GetD3DDevice()->CreateShaderResourceView(texture, &viewDesc, &view), DXE_ERROR_CREATING_SHADER_VIEW);
+
+    size_t uploadedBytes = 0;
+    {
+        std::lock_guard lock{DeviceMutex};
+        ID3D11DeviceContext* context = renderDevice->GetImmediateContext();
+        for (uint32_t level = 0; level < count; ++level)
+        {
+            const uint32_t mip = topMip + level;
+            if (rawTexture && mip >= previousTopMip)
+            {
+                context->CopySubresourceRegion(texture, level, 0, 0, 0, rawTexture, mip - previousTopMip, nullptr);
+                continue;
+            }
+
+            assert(source && source->levels.size() == mipCount && "Missing mips must be uploaded from the decoded image");
+            const std::vector<uint8_t>& data = source->levels[mip];
+            context->UpdateSubresource(texture, level, nullptr, data.data(), std::max(1u, width >> mip) * BYTES_PER_TEXEL, 0);
+            uploadedBytes += data.size();
+        }
+
+        DX_RELEASE(shaderResourceView);
+        DX_RELEASE(rawTexture);
+        rawTexture = texture;
+        shaderResourceView = view;
+    }
+
+    residentMipCount = count;
+    return uploadedBytes;
+}
+
+void StreamingTexture2D::MakeFullyResident()
+{
+    isKeptFullyResident = true;
+    if (residentMipCount == mipCount)
+        return;
+
+    const MipChain chain = DecodeMipChain(filename, width, height, mipCount);
+    SetResidentMipCount(mipCount, &chain);
+}
+
+bool StreamingTexture2D::ReloadSource()
+{
+    int imageWidth, imageHeight, components;
+    if (!stbi_info(filename.c_str(), &imageWidth, &imageHeight, &components))
+        return false;
+
+    SetResidentMipCount(0, nullptr);
+    width = static_cast<uint32_t>(imageWidth);
+    height = static_cast<uint32_t>(imageHeight);
+    mipCount = TextureStreamingScheduler::GetMipCount(width, height);
+
+    if (isKeptFullyResident)
+        MakeFullyResident();
+    return true;
+}
+
+void StreamingTexture2D::RequestResolution(const float resolution) noexcept
+{
+    float current = requestedResolution.load(std::memory_order_relaxed);
+    while (resolution > current && !requestedResolution.compare_exchange_weak(current, resolution, std::memory_order_relaxed))
+    {}
+}
+
+float StreamingTexture2D::ConsumeRequestedResolution() noexcept
+{
+    return requestedResolution.exchange(0, std::memory_order_relaxed);
+}
+
+void StreamingTexture2D::RenderImGui()
+{
+#ifdef _IMGUI_
+    ImGui::Text("Size: %u x %u", width, height);
+    ImGui::Text("Resident mips: %u / %u%s", residentMipCount, mipCount, isKeptFullyResident ? " (kept fully resident)" : "");
+    if (IsResident())
+        ImGui::Image(shaderResourceView, ImVec2(100, 100));
+#endif
+}
+
+}
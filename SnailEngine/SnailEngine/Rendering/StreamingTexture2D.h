@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <vector>
+
+#include "Texture2D.h"
+
+namespace Snail
+{
+
+// Texture2D whose mips are uploaded progressively by the TextureStreamer, smallest first.
+// Only the smallest resident mips are kept on the GPU, the texture is recreated when that count changes.
+class StreamingTexture2D : public Texture2D
+{
+public:
+    // Decoded RGBA8 mips, largest first
+    struct MipChain
+    {
+        std::vector<std::vector<uint8_t>> levels;
+    };
+
+private:
+    std::string filename;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipCount = 0;
+    uint32_t residentMipCount = 0;
+    bool isKeptFullyResident = false;
+
+    // Highest resolution requested since the streamer last looked at it
+    std::atomic<float> requestedResolution = 0;
+
+public:
+    StreamingTexture2D(const std::string& textureFilename);
+
+    // Whether the file is an image that can be decoded mip by mip
+    static bool CanStream(const std::string& filename);
+    // Decodes the image and builds its mips with a box filter, safe to call from any thread
+    static MipChain DecodeMipChain(const std::string& filename, uint32_t width, uint32_t height, uint32_t mipCount);
+
+    // Recreates the texture with the smallest count mips, already resident mips are copied on the GPU
+    // and the others are uploaded from source. Returns the uploaded bytes.
+    size_t SetResidentMipCount(uint32_t count, const MipChain* source);
+    // Loads every mip right away and keeps them, for users that need the full texture (ex: CPU sampling, UI)
+    void MakeFullyResident();
+    // Drops every mip and reads the image size again, after its file changed. Returns false if the file is no longer
+    // an image. Kept fully resident textures are loaded again right away, the others are streamed back in.
+    bool ReloadSource();
+
+    void RequestResolution(float resolution) noexcept override;
+    float ConsumeRequestedResolution() noexcept;
+
+    const std::string& GetFilename() const noexcept { return filename; }
+    uint32_t GetWidth() const noexcept { return width; }
+    uint32_t GetHeight() const noexcept { return height; }
+    uint32_t GetMipCount() const noexcept { return mipCount; }
+    uint32_t GetResidentMipCount() const noexcept { return residentMipCount; }
+    bool IsKeptFullyResident() const noexcept { return isKeptFullyResident; }
+
+    void RenderImGui() override;
+};
+
+}
@@ -41,6 +41,12 @@ void Texture::SetSampler(const D3D11_SAMPLER_DESC& samplerDesc)
     );
 }
 
+void Texture::SwapResources(Texture& other) noexcept
+{
+    std::swap(rawTexture, other.rawTexture);
+    std::swap(shaderResourceView, other.shaderResourceView);
+}
+
 void Texture::RenderImGui()
 {
 #ifdef _IMGUI_
@@ -59,6 +65,25 @@ Vector2 Texture::GetDimensions() const
     return Vector2{ static_cast<float>(desc.Width), static_cast<float>(desc.Height) };
 }
 
+size_t Texture::GetGpuMemoryUsage() const
+{
+    if (!rawTexture)
+        return 0;
+
+    D3D11_TEXTURE2D_DESC desc;
+    rawTexture->GetDesc(&desc);
+
+    const size_t bitsPerPixel = GetFormatBitsPerPixel(desc.Format);
+    size_t bits = 0;
+    for (uint32_t mip = 0; mip < desc.MipLevels; ++mip)
+    {
+        const size_t width = std::max(1u, desc.Width >> mip);
+        const size_t height = std::max(1u, desc.Height >> mip);
+        bits += width * height * bitsPerPixel;
+    }
+    return bits / 8 * desc.ArraySize;
+}
+
 Texture::~Texture()
 {
     DX_RELEASE(samplerState);
@@ -28,11 +28,17 @@ public:
     ID3D11ShaderResourceView* GetShaderResourceView() const noexcept { return shaderResourceView; }
     ID3D11SamplerState* GetSamplerState() const noexcept { return samplerState; }
     ID3D11Texture2D* GetRawTexture() const noexcept { return rawTexture; }
+    // Streamed textures have no GPU resource until their first mips are uploaded
+    bool IsResident() const noexcept { return shaderResourceView != nullptr; }
     void SetSampler(const D3D11_SAMPLER_DESC& samplerDesc);
+    // Trades the texture and its view with a reloaded texture of the same kind, the sampler stays
+    void SwapResources(Texture& other) noexcept;
 
     virtual void RenderImGui();
 
     Vector2 GetDimensions() const;
+    // Size of every mip and array slice of the texture
+    size_t GetGpuMemoryUsage() const;
 };
 
 }
@@ -13,6 +13,8 @@ class Texture2D : public Texture
 
     void InitResources(const Image& image) override;
 	void InitShaderResource(const D3D11_TEXTURE2D_DESC& desc, DXGI_FORMAT viewFormat);
+protected:
+    Texture2D() = default;
 public:
     Texture2D(const std::wstring& filename);
     Texture2D(const std::string& filename, bool generateMips = true);
@@ -21,6 +23,9 @@ public:
     Texture2D(const D3D11_TEXTURE2D_DESC& texDesc, DXGI_FORMAT viewFormat, bool generateMips = false);
     Texture2D(const D3D11_TEXTURE2D_DESC& texDesc, DXGI_FORMAT viewFormat, const D3D11_SUBRESOURCE_DATA& initialData, bool generateMips = false);
     ~Texture2D() override;
+
+    // Screen pixels covered by one UV unit where the texture was drawn, only used by streamed textures
+    virtual void RequestResolution(float) noexcept {}
 };
 
 }
@@ -26,14 +26,32 @@ struct TexturedMaterial
 
     bool isBlending = false;
 
-    // Textures
-    std::string diffuseTexture = TextureManager::DEFAULT_DIFFUSE_TEXTURE_NAME;
-	std::string primaryBlendDiffuseTexture = TextureManager::DEFAULT_DIFFUSE_TEXTURE_NAME;
-	std::string primaryBlendTexture = TextureManager::DEFAULT_BLEND_TEXTURE_NAME;
-    std::string secondaryBlendDiffuseTexture = TextureManager::DEFAULT_DIFFUSE_TEXTURE_NAME;
-    std::string secondaryBlendTexture = TextureManager::DEFAULT_BLEND_TEXTURE_NAME;
-    std::string ambientTexture = TextureManager::DEFAULT_AMBIENT_TEXTURE_NAME;
-    std::string specularTexture = TextureManager::DEFAULT_SPECULAR_TEXTURE_NAME;
-    std::string normalMapTexture = TextureManager::DEFAULT_NORMAL_MAP_TEXTURE_NAME;
+    // Textures, resolved to handles once at load
+    TextureHandle diffuseTexture = TextureManager::DEFAULT_DIFFUSE_TEXTURE_HANDLE;
+    TextureHandle primaryBlendDiffuseTexture = TextureManager::DEFAULT_DIFFUSE_TEXTURE_HANDLE;
+    TextureHandle primaryBlendTexture = TextureManager::DEFAULT_BLEND_TEXTURE_HANDLE;
+    TextureHandle secondaryBlendDiffuseTexture = TextureManager::DEFAULT_DIFFUSE_TEXTURE_HANDLE;
+    TextureHandle secondaryBlendTexture = TextureManager::DEFAULT_BLEND_TEXTURE_HANDLE;
+    TextureHandle ambientTexture = TextureManager::DEFAULT_AMBIENT_TEXTURE_HANDLE;
+    TextureHandle specularTexture = TextureManager::DEFAULT_SPECULAR_TEXTURE_HANDLE;
+    TextureHandle normalMapTexture = TextureManager::DEFAULT_NORMAL_MAP_TEXTURE_HANDLE;
 };
+
+inline constexpr TextureHandle TexturedMaterial::* MATERIAL_TEXTURE_MEMBERS[] = {
+    &TexturedMaterial::diffuseTexture,
+    &TexturedMaterial::primaryBlendDiffuseTexture,
+    &TexturedMaterial::primaryBlendTexture,
+    &TexturedMaterial::secondaryBlendDiffuseTexture,
+    &TexturedMaterial::secondaryBlendTexture,
+    &TexturedMaterial::ambientTexture,
+    &TexturedMaterial::specularTexture,
+    &TexturedMaterial::normalMapTexture,
+};
+
+// Default texture of a material slot, what it is bound to when its own texture can't be
+inline TextureHandle GetDefaultTexture(TextureHandle TexturedMaterial::* member) noexcept
+{
+    static const TexturedMaterial defaults;
+    return defaults.*member;
+}
 }
@@ -0,0 +1,36 @@
+#include "stdafx.h"
+
+#include "FrameTimeUI.h"
+
+#include "Text.h"
+#include "Core/WindowsEngine.h"
+
+namespace Snail
+{
+FrameTimeUI::FrameTimeUI()
+    : UIElement{{.sizeType = SizeType::TYPE_PERCENTAGE, .size = {1, 1}}}
+{
+    Text::Params txtParams;
+    txtParams.parentHorizontalAnchor = Alignment::END;
+    txtParams.parentVerticalAnchor = Alignment::END;
+    txtParams.localHorizontalAnchor = Alignment::END;
+    txtParams.localVerticalAnchor = Alignment::START;
+    txtParams.transform.position.y = -40;
+    txtParams.transform.position.x = -10;
+    txtParams.transform.scale = Vector2{0.5f, 0.5f};
+    txtParams.text = "FRAME TIME";
+    txtParams.font = WindowsEngine::GetDefaultFont();
+    percentilesText = dynamic_cast<Text*>(AddChild(CreatePtr<Text>(txtParams)));
+
+    txtParams.transform.position.y = -70;
+    txtParams.text = "HITCHES";
+    hitchesText = dynamic_cast<Text*>(AddChild(CreatePtr<Text>(txtParams)));
+}
+
+void FrameTimeUI::Update(const float dt, const FramePacer::Stats& stats)
+{
+    UIElement::Update(dt);
+    percentilesText->SetText(std::format("p50 {:.1f} ms  p95 {:.1f} ms  p99 {:.1f} ms", stats.p50Ms, stats.p95Ms, stats.p99Ms));
+    hitchesText->SetText(std::format("Max {:.1f} ms  Hitches {} ({} total)", stats.maxMs, stats.hitchCount, stats.totalHitchCount));
+}
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "Text.h"
+#include "UIElement.h"
+#include "Core/FramePacer.h"
+
+namespace Snail
+{
+// Frame time percentiles and hitches of the frame pacer, in the top right corner. Drawn in every build.
+class FrameTimeUI : public UIElement
+{
+    Text* percentilesText;
+    Text* hitchesText;
+
+public:
+    FrameTimeUI();
+    FrameTimeUI(FrameTimeUI&&) = default;
+    FrameTimeUI& operator=(FrameTimeUI&&) = default;
+
+    void Update(const float dt, const FramePacer::Stats& stats);
+};
+}
@@ -0,0 +1,279 @@
+#include "stdafx.h"
+#include "VertexCompression.h"
+
+#include <cmath>
+#include <cstring>
+#include <DirectXPackedVector.h>
+
+using namespace DirectX::PackedVector;
+
+namespace Snail
+{
+
+namespace
+{
+
+constexpr float SNORM16_MAX = 32767.0f;
+constexpr float UNORM16_MAX = 65535.0f;
+
+float SignNotZero(const float v) noexcept
+{
+    return v < 0 ? -1.0f : 1.0f;
+}
+
+int16_t ToSnorm16(const float v) noexcept
+{
+    return static_cast<int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * SNORM16_MAX));
+}
+
+float FromSnorm16(const int16_t v) noexcept
+{
+    // Same rule as the GPU, -32768 and -32767 both map to -1
+    return std::max(v / SNORM16_MAX, -1.0f);
+}
+
+uint16_t ToUnorm16(const float v) noexcept
+{
+    return static_cast<uint16_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * UNORM16_MAX));
+}
+
+float FromUnorm16(const uint16_t v) noexcept
+{
+    return v / UNORM16_MAX;
+}
+
+// Flat axes of the bounds get a unit extent so that quantizing them doesn't divide by zero
+Vector3 GetQuantizationExtent(const Vector3& minBounds, const Vector3& maxBounds) noexcept
+{
+    const Vector3 extent = maxBounds - minBounds;
+    return {extent.x > 0 ? extent.x : 1.0f, extent.y > 0 ? extent.y : 1.0f, extent.z > 0 ? extent.z : 1.0f};
+}
+
+void EncodeUv(const Vector2& uv, const bool unitRangeUvs, uint16_t (&encoded)[2]) noexcept
+{
+    if (unitRangeUvs)
+    {
+        encoded[0] = ToUnorm16(uv.x);
+        encoded[1] = ToUnorm16(uv.y);
+    }
+    else
+    {
+        encoded[0] = XMConvertFloatToHalf(uv.x);
+        encoded[1] = XMConvertFloatToHalf(uv.y);
+    }
+}
+
+Vector2 DecodeUv(const uint16_t (&encoded)[2], const bool unitRangeUvs) noexcept
+{
+    if (unitRangeUvs)
+        return {FromUnorm16(encoded[0]), FromUnorm16(encoded[1])};
+    return {XMConvertHalfToFloat(encoded[0]), XMConvertHalfToFloat(encoded[1])};
+}
+
+// Tries the four roundings around the exact encoding and keeps the closest direction,
+// plain rounding is about 50% worse in the worst case
+std::array<int16_t, 2> EncodeDirectionPrecise(const Vector3& direction) noexcept
+{
+    const Vector2 e = VertexCompression::OctEncode(direction);
+    const float baseX = std::floor(std::clamp(e.x, -1.0f, 1.0f) * SNORM16_MAX);
+    const float baseY = std::floor(std::clamp(e.y, -1.0f, 1.0f) * SNORM16_MAX);
+
+    std::array<int16_t, 2> best{};
+    float bestDot = -2;
+    for (int i = 0; i < 4; ++i)
+    {
+        const auto x = static_cast<int16_t>(std::clamp(baseX + static_cast<float>(i & 1), -SNORM16_MAX, SNORM16_MAX));
+        const auto y = static_cast<int16_t>(std::clamp(baseY + static_cast<float>(i >> 1), -SNORM16_MAX, SNORM16_MAX));
+        const float candidateDot = VertexCompression::OctDecode({FromSnorm16(x), FromSnorm16(y)}).Dot(direction);
+        if (candidateDot > bestDot)
+        {
+            bestDot = candidateDot;
+            best = {x, y};
+        }
+    }
+    return best;
+}
+
+}
+
+Vector2 VertexCompression::OctEncode(const Vector3& n) noexcept
+{
+    const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    Vector2 e{n.x / l1, n.y / l1};
+    // The lower hemisphere is folded over the diagonals
+    if (n.z < 0)
+        e = Vector2{(1 - std::abs(e.y)) * SignNotZero(e.x), (1 - std::abs(e.x)) * SignNotZero(e.y)};
+    return e;
+}
+
+Vector3 VertexCompression::OctDecode(const Vector2& e) noexcept
+{
+    Vector3 n{e.x, e.y, 1 - std::abs(e.x) - std::abs(e.y)};
+    const float fold = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0 ? -fold : fold;
+    n.y += n.y >= 0 ? -fold : fold;
+    n.Normalize();
+    return n;
+}
+
+std::array<int16_t, 4> VertexCompression::EncodeTangentFrame(const Vector3& normal, const Vector3& tangent, const float handedness) noexcept
+{
+    Vector3 n = normal;
+    n.Normalize();
+
+    Vector3 t = tangent;
+    if (t.LengthSquared() < 1e-12f)
+    {
+        // Vertices without UVs have no tangent, any direction along the surface will do
+        const Vector3 axis = std::abs(n.x) < 0.9f ? Vector3::UnitX : Vector3::UnitY;
+        t = axis - axis.Dot(n) * n;
+    }
+    t.Normalize();
+
+    const auto [nx, ny] = EncodeDirectionPrecise(n);
+    const Vector2 te = OctEncode(t);
+    const float w = 0.5f + 0.25f * (std::clamp(te.y, -1.0f, 1.0f) + 1);
+    return {nx, ny, ToSnorm16(te.x), ToSnorm16(handedness < 0 ? -w : w)};
+}
+
+void VertexCompression::DecodeTangentFrame(const int16_t (&encoded)[4], Vector3& normal, Vector3& tangent, float& handedness) noexcept
+{
+    const float w = FromSnorm16(encoded[3]);
+    normal = OctDecode({FromSnorm16(encoded[0]), FromSnorm16(encoded[1])});
+    tangent = OctDecode({FromSnorm16(encoded[2]), (std::abs(w) - 0.5f) * 4 - 1});
+    handedness = SignNotZero(w);
+}
+
+float VertexCompression::GetHandedness(const MeshVertex& vertex) noexcept
+{
+    return SignNotZero(vertex.normal.Cross(vertex.tangent).Dot(vertex.bitangent));
+}
+
+bool VertexCompression::HasUnitRangeUvs(const std::span<const MeshVertex> vertices) noexcept
+{
+    return std::ranges::all_of(vertices, [](const MeshVertex& v)
+    {
+        return v.uv.x >= 0 && v.uv.x <= 1 && v.uv.y >= 0 && v.uv.y <= 1;
+    });
+}
+
+UINT VertexCompression::GetStride(const VertexFormat format) noexcept
+{
+    switch (format)
+    {
+    case VertexFormat::COMPACT:
+        return sizeof(CompactMeshVertex);
+    case VertexFormat::COMPACT_QUANTIZED_POSITION:
+        return sizeof(QuantizedMeshVertex);
+    case VertexFormat::FULL:
+    default:
+        return sizeof(MeshVertex);
+    }
+}
+
+std::pair<D3D11_INPUT_ELEMENT_DESC*, UINT> VertexCompression::GetLayout(const VertexFormat format, const bool unitRangeUvs) noexcept
+{
+    constexpr DXGI_FORMAT FLOAT_POSITION = DXGI_FORMAT_R32G32B32_FLOAT;
+    constexpr DXGI_FORMAT QUANTIZED_POSITION = DXGI_FORMAT_R16G16B16A16_UNORM;
+    constexpr DXGI_FORMAT UNORM_UV = DXGI_FORMAT_R16G16_UNORM;
+    constexpr DXGI_FORMAT HALF_UV = DXGI_FORMAT_R16G16_FLOAT;
+
+    switch (format)
+    {
+    case VertexFormat::COMPACT:
+        if (unitRangeUvs)
+            return {COMPACT_ELEMENT_LAYOUT<FLOAT_POSITION, UNORM_UV>, ARRAYSIZE(COMPACT_ELEMENT_LAYOUT<FLOAT_POSITION, UNORM_UV>)};
+        return {COMPACT_ELEMENT_LAYOUT<FLOAT_POSITION, HALF_UV>, ARRAYSIZE(COMPACT_ELEMENT_LAYOUT<FLOAT_POSITION, HALF_UV>)};
+    case VertexFormat::COMPACT_QUANTIZED_POSITION:
+        if (unitRangeUvs)
+            return {COMPACT_ELEMENT_LAYOUT<QUANTIZED_POSITION, UNORM_UV>, ARRAYSIZE(COMPACT_ELEMENT_LAYOUT<QUANTIZED_POSITION, UNORM_UV>)};
+        return {COMPACT_ELEMENT_LAYOUT<QUANTIZED_POSITION, HALF_UV>, ARRAYSIZE(COMPACT_ELEMENT_LAYOUT<QUANTIZED_POSITION, HALF_UV>)};
+    case VertexFormat::FULL:
+    default:
+        return {DEFAULT_ELEMENT_LAYOUT, DEFAULT_ELEMENT_COUNT};
+    }
+}
+
+std::vector<std::byte> VertexCompression::Encode(const std::span<const MeshVertex> vertices, const VertexFormat format, const bool unitRangeUvs, const Vector3& minBounds, const Vector3& maxBounds)
+{
+    const UINT stride = GetStride(format);
+    std::vector<std::byte> encoded(vertices.size() * stride);
+
+    const Vector3 extent = GetQuantizationExtent(minBounds, maxBounds);
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        const MeshVertex& v = vertices[i];
+        std::byte* destination = encoded.data() + i * stride;
+
+        switch (format)
+        {
+        case VertexFormat::COMPACT:
+        {
+            CompactMeshVertex compact{v.position};
+            std::ranges::copy(EncodeTangentFrame(v.normal, v.tangent, GetHandedness(v)), compact.normalTangent);
+            EncodeUv(v.uv, unitRangeUvs, compact.uv);
+            std::memcpy(destination, &compact, stride);
+            break;
+        }
+        case VertexFormat::COMPACT_QUANTIZED_POSITION:
+        {
+            const Vector3 p = (v.position - minBounds) / extent;
+            QuantizedMeshVertex quantized{{ToUnorm16(p.x), ToUnorm16(p.y), ToUnorm16(p.z), 0}};
+            std::ranges::copy(EncodeTangentFrame(v.normal, v.tangent, GetHandedness(v)), quantized.normalTangent);
+            EncodeUv(v.uv, unitRangeUvs, quantized.uv);
+            std::memcpy(destination, &quantized, stride);
+            break;
+        }
+        case VertexFormat::FULL:
+        default:
+            std::memcpy(destination, &v, stride);
+            break;
+        }
+    }
+
+    return encoded;
+}
+
+MeshVertex VertexCompression::Decode(const std::byte* vertex, const VertexFormat format, const bool unitRangeUvs, const Vector3& minBounds, const Vector3& maxBounds) noexcept
+{
+    MeshVertex decoded;
+    float handedness = 1;
+
+    switch (format)
+    {
+    case VertexFormat::COMPACT:
+    {
+        CompactMeshVertex compact;
+        std::memcpy(&compact, vertex, sizeof(compact));
+        decoded.position = compact.position;
+        DecodeTangentFrame(compact.normalTangent, decoded.normal, decoded.tangent, handedness);
+        decoded.uv = DecodeUv(compact.uv, unitRangeUvs);
+        break;
+    }
+    case VertexFormat::COMPACT_QUANTIZED_POSITION:
+    {
+        QuantizedMeshVertex quantized;
+        std::memcpy(&quantized, vertex, sizeof(quantized));
+        // Goes through the same matrix as the instances get on the GPU
+        const Vector3 p{FromUnorm16(quantized.position[0]), FromUnorm16(quantized.position[1]), FromUnorm16(quantized.position[2])};
+        decoded.position = Vector3::Transform(p, GetPositionDecodeMatrix(minBounds, maxBounds));
+        DecodeTangentFrame(quantized.normalTangent, decoded.normal, decoded.tangent, handedness);
+        decoded.uv = DecodeUv(quantized.uv, unitRangeUvs);
+        break;
+    }
+    case VertexFormat::FULL:
+    default:
+        std::memcpy(&decoded, vertex, sizeof(decoded));
+        return decoded;
+    }
+
+    decoded.bitangent = handedness * decoded.normal.Cross(decoded.tangent);
+    return decoded;
+}
+
+Matrix VertexCompression::GetPositionDecodeMatrix(const Vector3& minBounds, const Vector3& maxBounds) noexcept
+{
+    return Matrix::CreateScale(GetQuantizationExtent(minBounds, maxBounds)) * Matrix::CreateTranslation(minBounds);
+}
+
+}
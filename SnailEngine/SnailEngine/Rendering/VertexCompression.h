@@ -0,0 +1,41 @@
+#pragma once
+#include <array>
+#include <span>
+#include <vector>
+
+#include "MeshVertex.h"
+
+namespace Snail
+{
+
+// Packs MeshVertex into the compact vertex formats and back, the decode side mirrors DeferredPass.fx
+class VertexCompression
+{
+public:
+    // Maps a unit vector to the [-1, 1] square
+    [[nodiscard]] static Vector2 OctEncode(const Vector3& n) noexcept;
+    [[nodiscard]] static Vector3 OctDecode(const Vector2& e) noexcept;
+
+    // Normal and tangent as SNORM16, the tangent y is moved to [0.5, 1] so that the sign of w can hold the handedness
+    [[nodiscard]] static std::array<int16_t, 4> EncodeTangentFrame(const Vector3& normal, const Vector3& tangent, float handedness) noexcept;
+    static void DecodeTangentFrame(const int16_t (&encoded)[4], Vector3& normal, Vector3& tangent, float& handedness) noexcept;
+
+    // Sign of the bitangent against cross(normal, tangent), mirrored UVs give -1
+    [[nodiscard]] static float GetHandedness(const MeshVertex& vertex) noexcept;
+
+    // UNORM16 UVs only cover [0, 1], tiled or wrapped UVs fall back to half floats
+    [[nodiscard]] static bool HasUnitRangeUvs(std::span<const MeshVertex> vertices) noexcept;
+
+    [[nodiscard]] static UINT GetStride(VertexFormat format) noexcept;
+    [[nodiscard]] static std::pair<D3D11_INPUT_ELEMENT_DESC*, UINT> GetLayout(VertexFormat format, bool unitRangeUvs) noexcept;
+
+    // Bounds are only used by COMPACT_QUANTIZED_POSITION
+    [[nodiscard]] static std::vector<std::byte> Encode(std::span<const MeshVertex> vertices, VertexFormat format, bool unitRangeUvs, const Vector3& minBounds, const Vector3& maxBounds);
+    // The bitangent is rebuilt from the handedness
+    [[nodiscard]] static MeshVertex Decode(const std::byte* vertex, VertexFormat format, bool unitRangeUvs, const Vector3& minBounds, const Vector3& maxBounds) noexcept;
+
+    // Brings quantized positions back to the mesh space, meant to be applied before the model matrix
+    [[nodiscard]] static Matrix GetPositionDecodeMatrix(const Vector3& minBounds, const Vector3& maxBounds) noexcept;
+};
+
+}
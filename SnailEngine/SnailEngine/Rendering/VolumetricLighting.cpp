@@ -7,6 +7,7 @@
 #include "D3D11Device.h"
 #include "Core/WindowsEngine.h"
 #include "Core/WindowsResource/resource.h"
+#include "Rendering/Effects/PostProcessing/PostProcessKernels.h"
 #include "Rendering/Shaders/ComputeShader.h"
 #include "Rendering/Shadows/DirectionalShadowMap.h"
 
@@ -26,6 +27,7 @@ VolumetricLighting::~VolumetricLighting()
 {
     DX_RELEASE(finalAccumulationUAV);
     DX_RELEASE(halfResAccumulationUAV);
+    DX_RELEASE(halfResBlurUAV);
     DX_RELEASE(halfResDepthUAV);
 
     DX_RELEASE(comparisonFilteringSampler);
@@ -71,6 +73,7 @@ void VolumetricLighting::ReloadShaders()
     halfResAccumulationPass = std::make_unique<ComputeShader>(L"SnailEngine/Shaders/VolumetricLighting/AccumulationPass.cs.hlsl");
     halfResDepthPass = std::make_unique<ComputeShader>(L"SnailEngine/Shaders/VolumetricLighting/DownsampleDepthPass.cs.hlsl");
     bilateralGaussianBlurPass = std::make_unique<ComputeShader>(L"SnailEngine/Shaders/VolumetricLighting/BilateralGaussianBlur.cs.hlsl");
+    bilateralGaussianBlurVerticalPass = std::make_unique<ComputeShader>(L"SnailEngine/Shaders/VolumetricLighting/BilateralGaussianBlur.cs.hlsl", std::unordered_set<std::string>{"VERTICAL"});
     upsamplePass = std::make_unique<ComputeShader>(L"SnailEngine/Shaders/VolumetricLighting/UpsamplePass.cs.hlsl");
     std::random_device rd;
     std::mt19937 g(rd());
@@ -124,6 +127,12 @@ void VolumetricLighting::InitTextures(const long width, const long height)
     DX_CALL(renderDevice->GetD3DDevice()->CreateUnorderedAccessView(halfResAccumulationTexture->GetRawTexture(), &uavDesc, &halfResAccumulationUAV),
         "Failed to create half resolution UAV");
 
+    halfResBlurTexture = std::make_unique<Texture2D>(desc, desc.Format);
+
+    DX_RELEASE(halfResBlurUAV);
+    DX_CALL(renderDevice->GetD3DDevice()->CreateUnorderedAccessView(halfResBlurTexture->GetRawTexture(), &uavDesc, &halfResBlurUAV),
+        "Failed to create half resolution blur UAV");
+
     // Half res depth texture
     desc.Format = DXGI_FORMAT_R16_FLOAT;
     halfResDepthTexture = std::make_unique<Texture2D>(desc, desc.Format);
@@ -196,8 +205,8 @@ void VolumetricLighting::RenderHalfResAccumulationPass()
 
     const FixedVector<DirectionalLight, SceneData::MAX_DIR_LIGHTS>& dirLights = WindowsEngine::GetScene()->GetDirectionalLights();
     const D3D11Buffer& dirLightsBuffer = WindowsEngine::GetScene()->GetDirectionalLightsBuffer();
-    const Camera* cam = WindowsEngine::GetCamera();
-    HalfResAccumulationData data = {cam->GetProjectionMatrix().Invert().Transpose(), cam->GetViewMatrix().Invert().Transpose()};
+    const FrameView::CameraView& camera = rm.GetFrameView().camera;
+    HalfResAccumulationData data = {camera.invProjection.Transpose(), camera.invView.Transpose()};
     data.nbDirectional = static_cast<uint32_t>(dirLights.size());
 
     for (int i = 0; i < 16; ++i)
@@ -246,19 +255,29 @@ void VolumetricLighting::RenderHalfResDepthPass()
 
 void VolumetricLighting::RenderBilateralGaussianBlurPass()
 {
-    bilateralGaussianBlurPass->BindComputedUAV(halfResAccumulationUAV);
-    bilateralGaussianBlurPass->BindSRV(0, halfResDepthTexture->GetShaderResourceView());
-    bilateralGaussianBlurPass->Bind();
-
     D3D11_TEXTURE2D_DESC desc;
     halfResAccumulationTexture->GetRawTexture()->GetDesc(&desc);
-    const UINT width = desc.Width, height = desc.Height;
+    const int width = static_cast<int>(desc.Width), height = static_cast<int>(desc.Height);
 
-    const int numGroupsX = (width + 7) / 8;
-    const int numGroupsY = (height + 7) / 8;
-    bilateralGaussianBlurPass->Execute(numGroupsX, numGroupsY, 1);
+    // A group per tile of a row or a column. Horizontal, from the accumulation texture to the blur one
+    bilateralGaussianBlurPass->BindComputedUAV(halfResBlurUAV);
+    bilateralGaussianBlurPass->BindSRV(0, halfResDepthTexture->GetShaderResourceView());
+    bilateralGaussianBlurPass->BindSRV(1, halfResAccumulationTexture->GetShaderResourceView());
+    bilateralGaussianBlurPass->Bind();
+    bilateralGaussianBlurPass->Execute((width + BILATERAL_TILE_SIZE - 1) / BILATERAL_TILE_SIZE, height, 1);
     bilateralGaussianBlurPass->UnbindSRV(0);
+    bilateralGaussianBlurPass->UnbindSRV(1);
     bilateralGaussianBlurPass->Unbind();
+
+    // Vertical, back into the accumulation texture
+    bilateralGaussianBlurVerticalPass->BindComputedUAV(halfResAccumulationUAV);
+    bilateralGaussianBlurVerticalPass->BindSRV(0, halfResDepthTexture->GetShaderResourceView());
+    bilateralGaussianBlurVerticalPass->BindSRV(1, halfResBlurTexture->GetShaderResourceView());
+    bilateralGaussianBlurVerticalPass->Bind();
+    bilateralGaussianBlurVerticalPass->Execute(width, (height + BILATERAL_TILE_SIZE - 1) / BILATERAL_TILE_SIZE, 1);
+    bilateralGaussianBlurVerticalPass->UnbindSRV(0);
+    bilateralGaussianBlurVerticalPass->UnbindSRV(1);
+    bilateralGaussianBlurVerticalPass->Unbind();
 }
 
 void VolumetricLighting::RenderUpsamplePass()
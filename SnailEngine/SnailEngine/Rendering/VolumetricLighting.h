@@ -45,6 +45,10 @@ private:
     std::unique_ptr<Texture2D> halfResAccumulationTexture;
     ID3D11UnorderedAccessView* halfResAccumulationUAV = nullptr;
 
+    // Between the horizontal and vertical blur passes
+    std::unique_ptr<Texture2D> halfResBlurTexture;
+    ID3D11UnorderedAccessView* halfResBlurUAV = nullptr;
+
     std::unique_ptr<Texture2D> halfResDepthTexture;
     ID3D11UnorderedAccessView* halfResDepthUAV = nullptr;
 
@@ -58,6 +62,7 @@ private:
     std::unique_ptr<ComputeShader> halfResAccumulationPass;
     std::unique_ptr<ComputeShader> halfResDepthPass;
     std::unique_ptr<ComputeShader> bilateralGaussianBlurPass;
+    std::unique_ptr<ComputeShader> bilateralGaussianBlurVerticalPass;
     std::unique_ptr<ComputeShader> upsamplePass;
 
     void InitTextures(long width, long height);
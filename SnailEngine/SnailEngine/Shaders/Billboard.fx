@@ -1,4 +1,5 @@
 #include "ScreenSpaceDef.hlsli"
+#include "GBufferPacking.hlsli"
 
 Texture2D Billboard;
 SamplerState BillboardSampler;
@@ -25,10 +26,12 @@ struct PixelIn
     float2 uv : TEXCOORD;
 };
 
+// Unlit, the color is emitted over a black surface. The normal is left to what is behind.
 struct PixelOut
 {
-    float4 albedo : SV_Target2;
-    float4 unlit : SV_Target5;
+    float4 albedo : SV_Target1;
+    float4 material : SV_Target2;
+    float4 emission : SV_Target3;
 };
 
 PixelIn BillboardVS(VertexIn input)
@@ -42,15 +45,19 @@ PixelIn BillboardVS(VertexIn input)
 
 PixelOut BillboardPS(PixelIn input)
 {
-    PixelOut pout;
-    pout.albedo = Billboard.Sample(BillboardSampler, input.uv);
+    const float4 color = Billboard.Sample(BillboardSampler, input.uv);
     
     // Perform alpha test on billboard pixel
-    if (pout.albedo.w <= 0.05f)
+    if (color.w <= 0.05f)
     {
         discard;
     }
-    pout.unlit = float4(1, 1, 1, 1);
+
+    // Blended by their alpha, which also ends up in the alpha channels under the edges
+    PixelOut pout;
+    pout.albedo = float4(0, 0, 0, color.w);
+    pout.material = float4(0, 0, 0, color.w);
+    pout.emission = color;
     return pout;
 }
 
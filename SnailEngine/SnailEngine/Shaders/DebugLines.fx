@@ -15,10 +15,12 @@ struct PixelIn
     float4 color : COLOR;
 };
 
+// Unlit, the color is emitted over a black surface. The normal is left to what is behind.
 struct PixelOut
 {
-    float4 albedo : SV_Target2;
-    float4 unlit : SV_Target5;
+    float4 albedo : SV_Target1;
+    float4 material : SV_Target2;
+    float4 emission : SV_Target3;
 };
 
 PixelIn DebugLinesVS(VertexIn input)
@@ -32,8 +34,9 @@ PixelIn DebugLinesVS(VertexIn input)
 PixelOut DebugLinesPS(PixelIn input)
 {
     PixelOut pout;
-    pout.albedo = input.color;
-    pout.unlit = float4(1, 1, 1, 1);
+    pout.albedo = 0;
+    pout.material = 0;
+    pout.emission = input.color;
     return pout;
 }
 
@@ -1,4 +1,5 @@
 #include "CommonMath.hlsli"
+#include "GBufferPacking.hlsli"
 
 cbuffer TransformMatrixes : register(b0)
 {
@@ -28,10 +29,10 @@ struct PixelIn
     matrix invModelMatrix : INV_MODEL_MATRIX;
 };
 
-struct GBuffer
+// Only the albedo is replaced, the decal is lit like the surface under it
+struct DecalOut
 {
-    float3 albedo : SV_Target2;
-    float3 unlit : SV_Target5;
+    float4 albedo : SV_Target1;
 };
 
 Texture2D Diffuse;
@@ -48,9 +49,9 @@ PixelIn DecalVS(VertexIn input)
     return output;
 }
 
-GBuffer DecalPS(PixelIn input)
+DecalOut DecalPS(PixelIn input)
 {
-    GBuffer gbuffer;
+    DecalOut output;
           
     float2 resolution;
     DepthTexture.GetDimensions(resolution.x, resolution.y);
@@ -80,10 +81,10 @@ GBuffer DecalPS(PixelIn input)
         discard;
     }
     
-    gbuffer.albedo = color.xyz;
-    gbuffer.unlit = 0;
+    // The flags can't be kept without reading the target, decals make the surface opaque
+    output.albedo = float4(color.xyz, PackFlags(0));
 
-    return gbuffer;
+    return output;
 }
 
 technique11 Decal
@@ -1,4 +1,5 @@
 #include "ScreenSpaceDef.hlsli"
+#include "GBufferPacking.hlsli"
 
 float4 DefaultVS(uint vertexId : SV_VertexID) : SV_Position
 {
@@ -10,12 +11,31 @@ cbuffer IndexGBuffer
     int index;
 };
 
-Texture2DArray GBuffer;
-SamplerState GBufferSampler;
+Texture2D GBufferNormal;
+Texture2D GBufferAlbedo;
+Texture2D GBufferMaterial;
+Texture2D GBufferEmission;
 
+// The channels unpacked, in the order of the passes listed by RendererModule::RenderImGui
 float4 DefaultPS(float4 position : SV_Position) : SV_Target
 {
-    return GBuffer.Load(float4(position.xy, index, 0));
+    const int3 pixel = int3(position.xy, 0);
+    switch (index)
+    {
+    case 0:
+        return float4(UnpackNormal(GBufferNormal.Load(pixel).rg) * 0.5 + 0.5, 1);
+    case 1:
+        return float4(GBufferAlbedo.Load(pixel).rgb, 1);
+    case 2:
+        return float4(GBufferMaterial.Load(pixel).rgb, 1);
+    case 3:
+        return float4(GBufferMaterial.Load(pixel).aaa, 1);
+    case 4:
+        return float4(GBufferEmission.Load(pixel).rgb, 1);
+    default:
+        const float flags = UnpackFlags(GBufferAlbedo.Load(pixel).a) / float(GBUFFER_MAX_FLAGS);
+        return float4(flags, flags, flags, 1);
+    }
 }
 
 technique11 Deferred
@@ -1,3 +1,5 @@
+#include "GBufferPacking.hlsli"
+
 cbuffer TransformMatrixes : register(b0)
 {
     matrix matViewProj;
@@ -20,12 +22,18 @@ cbuffer MaterialParameters : register(b1)
     MaterialParameters material;
 }
 
+// Quantized positions need nothing here, their decode is folded into modelMatrix
 struct VertexIn
 {
     float3 position : POSITION;
+#ifdef COMPACT_VERTEX
+    // Octahedral normal in xy, octahedral tangent in zw with the handedness as the sign of w
+    float4 normalTangent : NORMAL0;
+#else
     float3 bitangent : NORMAL0;
     float3 tangent : NORMAL1;
     float3 normal : NORMAL2;
+#endif
     float2 uv : TEXCOORD;
     matrix modelMatrix : MODEL_MATRIX;
     matrix invModelMatrix : INV_MODEL_MATRIX;
@@ -41,20 +49,6 @@ struct PixelIn
     float2 uv : TEXCOORD;
 };
 
-struct GBuffer
-{
-    // Extra params
-    // .r = specular exponent
-    // .g = isTranslucent
-    // .b = TBD
-    float3 extraParams : SV_Target0;
-    float3 normal : SV_Target1;
-    float3 albedo : SV_Target2;
-    float3 specular : SV_Target3;
-    float3 emission : SV_Target4;
-    float3 unlit : SV_Target5;
-};
-
 Texture2D Diffuse;
 SamplerState DiffuseSampler;
 
@@ -75,16 +69,37 @@ SamplerState SecondaryBlendSampler;
 Texture2D NormalMap;
 SamplerState NormalMapSampler;
 
+#ifdef COMPACT_VERTEX
+// Tangent y was moved to [0.5, 1] so that the sign of w could hold the handedness
+void DecodeTangentFrame(float4 encoded, out float3 normal, out float3 tangent, out float handedness)
+{
+    normal = OctDecode(encoded.xy);
+    tangent = OctDecode(float2(encoded.z, (abs(encoded.w) - 0.5) * 4 - 1));
+    handedness = encoded.w < 0 ? -1 : 1;
+}
+#endif
+
 PixelIn DeferredVS(VertexIn input)
 {
     PixelIn output;
     matrix matWorldViewProj = mul(input.modelMatrix, matViewProj);
     output.position = mul(float4(input.position, 1), matWorldViewProj);
+
+#ifdef COMPACT_VERTEX
+    float3 normal, tangent;
+    float handedness;
+    DecodeTangentFrame(input.normalTangent, normal, tangent, handedness);
+#else
+    const float3 normal = input.normal;
+    const float3 tangent = input.tangent;
+    // Mirrored UVs flip the bitangent
+    const float handedness = dot(cross(input.normal, input.tangent), input.bitangent) < 0 ? -1 : 1;
+#endif
     
     // Normals
-    output.tangent = normalize(mul(float4(normalize(input.tangent), 0), transpose(input.invModelMatrix)).xyz);
-    output.normal = normalize(mul(float4(normalize(input.normal), 0), transpose(input.invModelMatrix)).xyz);
-    output.bitangent = normalize(mul(float4(normalize(cross(output.normal, output.tangent)), 0), transpose(input.invModelMatrix)).xyz);
+    output.tangent = normalize(mul(float4(normalize(tangent), 0), transpose(input.invModelMatrix)).xyz);
+    output.normal = normalize(mul(float4(normalize(normal), 0), transpose(input.invModelMatrix)).xyz);
+    output.bitangent = handedness * normalize(mul(float4(normalize(cross(output.normal, output.tangent)), 0), transpose(input.invModelMatrix)).xyz);
     
     output.uv = input.uv;
     return output;
@@ -92,8 +107,6 @@ PixelIn DeferredVS(VertexIn input)
 
 GBuffer DeferredPS(PixelIn input, bool isFrontFace : SV_IsFrontFace)
 {
-    GBuffer gbuffer;
-    
     float3x3 TBN = float3x3(input.tangent, input.bitangent, input.normal);
     float3 N = NormalMap.Sample(NormalMapSampler, input.uv).xyz * 2 - 1;
     
@@ -101,8 +114,6 @@ GBuffer DeferredPS(PixelIn input, bool isFrontFace : SV_IsFrontFace)
     
     if (!isFrontFace)
         normal = -normal;
-        
-    gbuffer.normal = normal * 0.5 + 0.5;
     
     const float3 diffuse = Diffuse.Sample(DiffuseSampler, input.uv * material.uvScale).rgb;
 
@@ -115,23 +126,19 @@ GBuffer DeferredPS(PixelIn input, bool isFrontFace : SV_IsFrontFace)
     
     const float3 firstBlendAlbedo = lerp(primaryDiffuse, diffuse, primaryBlend);
     const float3 finalAlbedo = lerp(secondaryDiffuse, firstBlendAlbedo, secondaryBlend);
-    gbuffer.albedo = float4(material.diffuse, 1) * finalAlbedo;
-
+    const float3 albedo = material.diffuse * finalAlbedo;
 #else 
-    gbuffer.albedo = material.diffuse * diffuse;
+    const float3 albedo = material.diffuse * diffuse;
 #endif
-    // Specular exponent
-    gbuffer.extraParams.r = material.specularExp;
-    
+
 #ifdef THIN_TRANSLUCENCY
-    gbuffer.extraParams.g = 1;
+    const uint flags = GBUFFER_FLAG_TRANSLUCENT;
+#else
+    const uint flags = 0;
 #endif
-    
-    gbuffer.specular = material.specular;
-    gbuffer.emission = material.emission;
-    gbuffer.unlit = 0;
 
-    return gbuffer;
+    // Emission is tinted by the albedo
+    return PackGBuffer(normal, albedo, material.specular, material.specularExp, material.emission * albedo, flags);
 }
 
 technique11 Deferred
@@ -0,0 +1,84 @@
+#ifndef __GBUFFER_PACKING_HLSL__
+#define __GBUFFER_PACKING_HLSL__
+
+// Mirrored by GBufferPacking.cpp, which checks the precision of these encodings
+
+// Bits of the albedo alpha, two of them so that A2 formats hold them too
+#define GBUFFER_FLAG_TRANSLUCENT 1
+#define GBUFFER_MAX_FLAGS 3
+
+#define GBUFFER_MAX_SPECULAR_EXPONENT 8191
+
+// Every target of the packed G-buffer, in the order of GBufferTarget
+struct GBuffer
+{
+    // Octahedral normal moved to [0, 1]
+    float2 normal : SV_Target0;
+    // Linear albedo, the target is sRGB, and the flags in alpha
+    float4 albedo : SV_Target1;
+    // Specular color and exponent
+    float4 material : SV_Target2;
+    // Emitted light, unlit surfaces write their color here over a black albedo and specular
+    float3 emission : SV_Target3;
+};
+
+// Maps a unit vector to the [-1, 1] square
+float2 OctEncode(float3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    // The lower hemisphere is folded over the diagonals
+    if (n.z < 0)
+        n.xy = (1 - abs(n.yx)) * (n.xy >= 0 ? 1 : -1);
+    return n.xy;
+}
+
+float3 OctDecode(float2 e)
+{
+    float3 n = float3(e, 1 - abs(e.x) - abs(e.y));
+    const float fold = saturate(-n.z);
+    n.xy += n.xy >= 0 ? -fold : fold;
+    return normalize(n);
+}
+
+float2 PackNormal(float3 normal)
+{
+    return OctEncode(normalize(normal)) * 0.5 + 0.5;
+}
+
+float3 UnpackNormal(float2 packed)
+{
+    return OctDecode(packed * 2 - 1);
+}
+
+// Logarithmic, the highlights change as much between 4 and 8 as between 512 and 1024
+float PackSpecularExponent(float exponent)
+{
+    return log2(1 + clamp(exponent, 0, GBUFFER_MAX_SPECULAR_EXPONENT)) / log2(1 + GBUFFER_MAX_SPECULAR_EXPONENT);
+}
+
+float UnpackSpecularExponent(float packed)
+{
+    return exp2(packed * log2(1 + GBUFFER_MAX_SPECULAR_EXPONENT)) - 1;
+}
+
+float PackFlags(uint flags)
+{
+    return flags / float(GBUFFER_MAX_FLAGS);
+}
+
+uint UnpackFlags(float packed)
+{
+    return uint(round(saturate(packed) * GBUFFER_MAX_FLAGS));
+}
+
+GBuffer PackGBuffer(float3 normal, float3 albedo, float3 specular, float specularExp, float3 emission, uint flags)
+{
+    GBuffer gbuffer;
+    gbuffer.normal = PackNormal(normal);
+    gbuffer.albedo = float4(albedo, PackFlags(flags));
+    gbuffer.material = float4(specular, PackSpecularExponent(specularExp));
+    gbuffer.emission = emission;
+    return gbuffer;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#include "GrassDef.hlsli"
+
+// Must match GrassRegionCulling::RegionDraw
+struct GrassRegionDraw
+{
+    uint regionIndex;
+    uint lod;
+    float keepFraction;
+};
+
+cbuffer GrassCullParams
+{
+    uint2 GroupCount;
+    uint VisibleRegionCount;
+};
+
+static const int ThreadCount = 8;
+// Dispatches are split over y past the 65535 thread groups limit
+static const uint MaxGroupCountX = 65535;
+// Size of the indexed draw arguments of each lod, the instance count comes after the index count
+static const uint DrawArgsStride = 20;
+
+StructuredBuffer<GrassInstanceData> instanceDataBuffer : register(t0);
+StructuredBuffer<GrassRegionDraw> visibleRegions : register(t1);
+
+RWStructuredBuffer<uint> visibleBladesLod0 : register(u0);
+RWStructuredBuffer<uint> visibleBladesLod1 : register(u1);
+RWByteAddressBuffer drawArgs : register(u2);
+
+// One thread group per visible region, appends the blades it keeps to the list of the region's lod
+[numthreads(ThreadCount, ThreadCount, 1)]
+void main(uint2 threadID : SV_GroupThreadID, uint2 groupID : SV_GroupID)
+{
+    uint visibleRegionIndex = groupID.x + groupID.y * MaxGroupCountX;
+    if (visibleRegionIndex >= VisibleRegionCount)
+        return;
+
+    GrassRegionDraw region = visibleRegions[visibleRegionIndex];
+    uint2 bladeCoords = uint2(region.regionIndex % GroupCount.x, region.regionIndex / GroupCount.x) * ThreadCount + threadID;
+    uint bladeIndex = bladeCoords.x + bladeCoords.y * (GroupCount.x * ThreadCount);
+
+    if (instanceDataBuffer[bladeIndex].randomHeight == 0 || GetThinningValue(bladeIndex) >= region.keepFraction)
+        return;
+
+    uint slot;
+    drawArgs.InterlockedAdd(region.lod * DrawArgsStride + 4, 1, slot);
+
+    if (region.lod == 0)
+        visibleBladesLod0[slot] = bladeIndex;
+    else
+        visibleBladesLod1[slot] = bladeIndex;
+}
@@ -2,6 +2,7 @@
 #define __GRASS_DEF_HLSL__
 
 static const int GRASS_VERTEX_COUNT = 9;
+static const int GRASS_LOD_COUNT = 2;
 
 static const float3 LOD_GRASS_COLOR = float3(0.65, 0.8, 0.25);
 
@@ -37,6 +38,17 @@ float remap(float v, float inMin, float inMax, float outMin, float outMax)
     return lerp(outMin, outMax, t);
 }
 
+// Same as GrassRegionCulling::GetThinningValue, blades are kept while it is below the keep fraction of their region
+float GetThinningValue(uint bladeIndex)
+{
+    uint h = (bladeIndex ^ 61u) ^ (bladeIndex >> 16u);
+    h *= 9u;
+    h ^= h >> 4u;
+    h *= 0x27d4eb2du;
+    h ^= h >> 15u;
+    return (h & 0xffffffu) / 16777216.0;
+}
+
 float decayWithFunction(float val, float x1, float x2)
 {
     float a = 1 / (x1 - x2);
@@ -1,8 +1,11 @@
 #include "GrassDef.hlsli"
 #include "../CommonMath.hlsli"
+#include "../GBufferPacking.hlsli"
 #include "../Noise.hlsl"
 
 StructuredBuffer<GrassInstanceData> grassInstanceData;
+// Blades kept by GrassCulling.cs.hlsl for the lod being drawn
+StructuredBuffer<uint> visibleBlades;
 
 cbuffer GrassParams
 {
@@ -27,30 +30,21 @@ struct PSInput
     float2 uv : TEXCOORD;
     float3 normal1 : NORMAL0;
     float3 normal2 : NORMAL1;
-    uint instanceID : SV_InstanceID;
+    nointerpolation uint bladeIndex : BLADE_INDEX;
     float depth : DEPTH;
 };
 
-struct GBuffer
-{
-    float3 extraParams : SV_Target0;
-    float3 normal : SV_Target1;
-    float3 albedo : SV_Target2;
-    float3 specular : SV_Target3;
-    float3 emission : SV_Target4;
-    float3 unlit : SV_Target5;
-};
-
 PSInput GrassVS(VSInput input)
 {
     PSInput output = (PSInput)0;
     
-    GrassInstanceData gid = grassInstanceData[input.instanceID];
+    uint bladeIndex = visibleBlades[input.instanceID];
+    GrassInstanceData gid = grassInstanceData[bladeIndex];
+    output.bladeIndex = bladeIndex;
     
     // If not valid grass then set all verts to 0 to not render grass (vertex degeneracy)
     if (gid.randomHeight == 0)
     {
-        output.instanceID = input.instanceID;
         return output;
     }
     
@@ -64,7 +58,6 @@ PSInput GrassVS(VSInput input)
     if (worldPositionVS.z > 400)
     {
         output.position = float4(-10, -10, -10, 1);
-        output.instanceID = input.instanceID;
         return output;
     }
     
@@ -134,25 +127,20 @@ PSInput GrassVS(VSInput input)
     
     output.uv = input.uv;
     output.depth = worldPositionVS.z;
-    output.instanceID = input.instanceID;
     
     return output;
 }
 
 GBuffer GrassPS(const PSInput input)
 {
-    GrassInstanceData gid = grassInstanceData[input.instanceID];
+    GrassInstanceData gid = grassInstanceData[input.bladeIndex];
     
-    // Write to GBuffer (worldPos, normals, specular, etc...)
-    GBuffer gBuffer;
-    gBuffer.extraParams = float3(16, 0, 0);
-
     // Decay the color and normals with distance
     float lodDecayValue = decayWithFunction(input.depth, 75, 350);
     
     // Lerp between the two extremity normals using the current width as scaling to give a 3d effect
     // After a certain distance, only use a default normal to avoid noise
-    gBuffer.normal = lerp(float3(0, -1, 0), normalize(lerp(input.normal1, input.normal2, input.uv.x)), lodDecayValue);
+    const float3 normal = lerp(float3(0, -1, 0), normalize(lerp(input.normal1, input.normal2, input.uv.x)), lodDecayValue);
 
     // Calculate final pixel color
     float grassMiddle = smoothstep(abs(input.uv.x), 0.0, 0.1);
@@ -160,13 +148,9 @@ GBuffer GrassPS(const PSInput input)
     diffuse *= lerp(0.85, 1.0, grassMiddle);
     
     // Decay color with distance
-    gBuffer.albedo = lerp(LOD_GRASS_COLOR, diffuse, lodDecayValue);
-    
-    gBuffer.specular = float3(0.5, 0.5, 0.5);
-    gBuffer.emission = 0;
-    gBuffer.unlit = 0;
+    const float3 albedo = lerp(LOD_GRASS_COLOR, diffuse, lodDecayValue);
     
-    return gBuffer;
+    return PackGBuffer(normal, albedo, float3(0.5, 0.5, 0.5), 16, 0, 0);
 }
 
 technique11 Deferred
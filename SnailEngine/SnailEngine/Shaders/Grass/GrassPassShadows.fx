@@ -3,6 +3,8 @@
 #include "../Noise.hlsl"
 
 StructuredBuffer<GrassInstanceData> grassInstanceData;
+// Blades kept by GrassCulling.cs.hlsl for the lod being drawn
+StructuredBuffer<uint> visibleBlades;
 
 cbuffer GrassParams
 {
@@ -34,7 +36,7 @@ struct PSInput
 
 PSInput GrassVS(VSInput input)
 {    
-    GrassInstanceData gid = grassInstanceData[input.instanceID];
+    GrassInstanceData gid = grassInstanceData[visibleBlades[input.instanceID]];
     
     PSInput output = (PSInput) 0;
 
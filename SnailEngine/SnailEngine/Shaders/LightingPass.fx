@@ -1,6 +1,7 @@
 #include "Lights.hlsl"
 #include "ScreenSpaceDef.hlsli"
 #include "CommonMath.hlsli"
+#include "GBufferPacking.hlsli"
 
 cbuffer SceneInfo
 {
@@ -29,20 +30,16 @@ cbuffer DirectionalLightShadows
     CascadeShadows dirLightMatrix[MAX_DIR_LIGHTS];
 }
 
-cbuffer SpotLights
-{
-    SpotLight spotLights[MAX_SPOT_LIGHTS];
-}
-
-cbuffer PointLights
-{
-    PointLight pointLights[MAX_POINT_LIGHTS];
-}
+// The lights chosen by the light manager, nbSpot and nbPoint long
+StructuredBuffer<SpotLight> SpotLights;
+StructuredBuffer<PointLight> PointLights;
 
 static const float globalAmbient = 0.3;
 
-Texture2DArray GBuffer;
-SamplerState GBufferSampler;
+Texture2D GBufferNormal;
+Texture2D GBufferAlbedo;
+Texture2D GBufferMaterial;
+Texture2D GBufferEmission;
 
 Texture2DArray DirectionalShadowMap;
 SamplerState DirectionalShadowMapSampler;
@@ -82,7 +79,7 @@ float4 LightingPS(VSOutput input) : SV_Target
     
     float ssao = 1;
     if (ssaoEnabled)
-        ssao = saturate(SSAOTexture.Sample(GBufferSampler, input.uv).r);
+        ssao = saturate(SSAOTexture.Load(int3(pos, 0)).r);
         
     // Rebuild world pos from depth
     input.uv.y = 1 - input.uv.y;
@@ -95,28 +92,23 @@ float4 LightingPS(VSOutput input) : SV_Target
     computeData.viewMatrix = viewMat;
     computeData.invViewMatrix = invViewMatrix;
     computeData.cameraPosition = cameraPosition;
-    computeData.normal = normalize(GBuffer.Load(float4(pos, 1, 0)).rgb * 2 - 1);
+    computeData.normal = UnpackNormal(GBufferNormal.Load(int3(pos, 0)).rg);
     
     computeData.nbDirectional = nbDirectional;
     computeData.nbSpot = nbSpot;
     computeData.nbPoint = nbPoint;
     
-    float3 extraParams = GBuffer.Load(float4(pos, 0, 0));
-    computeData.specularExp = extraParams.r;
-    computeData.isTranslucent = extraParams.g == 1;
+    const float4 albedoFlags = GBufferAlbedo.Load(int3(pos, 0));
+    const float4 material = GBufferMaterial.Load(int3(pos, 0));
+    computeData.specularExp = UnpackSpecularExponent(material.a);
+    computeData.isTranslucent = (UnpackFlags(albedoFlags.a) & GBUFFER_FLAG_TRANSLUCENT) != 0;
     
     computeData.screenSpacePos = input.pos.xyz;
 
-    const float3 albedo = GBuffer.Load(float4(pos, 2, 0)).rgb;
-
-    float unlit = GBuffer.Load(float4(pos, 5, 0)).r;
-    if (unlit == 1)
-    {
-        return float4(albedo, 1);
-    }
+    const float3 albedo = albedoFlags.rgb;
 
     // Calculate lighting result via BlinnPhong
-    const LightingResult lit = ComputeAllLighting(computeData, dirLights, spotLights, pointLights, DirectionalShadowMap, DirectionalShadowMapSampler, dirLightMatrix);
+    const LightingResult lit = ComputeAllLighting(computeData, dirLights, SpotLights, PointLights, DirectionalShadowMap, DirectionalShadowMapSampler, dirLightMatrix);
     
 #ifdef DEBUG_SHADOWS
     return float4(lit.diffuse, 1);
@@ -139,8 +131,9 @@ float4 LightingPS(VSOutput input) : SV_Target
 #endif
     
     const float3 ambient = albedo * globalAmbient * ssao;
-    const float3 specular = GBuffer.Load(float4(pos, 3, 0)).rgb * lit.specular;
-    const float3 emission = GBuffer.Load(float4(pos, 4, 0)).rgb * albedo;
+    const float3 specular = material.rgb * lit.specular;
+    // Also holds the color of the unlit surfaces
+    const float3 emission = GBufferEmission.Load(int3(pos, 0)).rgb;
     
     float3 finalColor = emission + ambient + diffuse + specular;
     
@@ -83,8 +83,8 @@ static const float THIN_TRANSLUCENCY_FACTOR = 0.4;
 LightingResult ComputeAllLighting(
     LightComputeData computeData,
     DirectionalLight dirLights[MAX_DIR_LIGHTS],
-    SpotLight spotLights[MAX_SPOT_LIGHTS],
-    PointLight pointLights[MAX_POINT_LIGHTS],
+    StructuredBuffer<SpotLight> spotLights,
+    StructuredBuffer<PointLight> pointLights,
     const Texture2DArray shadowMap,
     const SamplerState shadowSampler,
     const CascadeShadows cascadeShadow[MAX_DIR_LIGHTS])
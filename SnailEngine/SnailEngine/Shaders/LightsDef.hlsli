@@ -35,9 +35,8 @@ struct DirectionalLight
 };
 
 static const uint MAX_DIR_LIGHTS = 2;
-static const uint MAX_SPOT_LIGHTS = 10;
-static const uint MAX_POINT_LIGHTS = 40;
 
+// Structured buffer elements, keep in sync with GpuSpotLight and GpuPointLight in LightManager.h
 struct SpotLight
 {
     float3 Position;
@@ -0,0 +1,99 @@
+#include "GBufferPacking.hlsli"
+
+Texture2D Billboard;
+SamplerState BillboardSampler;
+
+// Billboard::BillboardType
+#define WORLD_ALIGNED 0
+#define SCREEN_ALIGNED 1
+#define AXIAL_ALIGNED 2
+
+cbuffer ParticleView
+{
+    matrix matViewProj;
+    float3 cameraPosition;
+    float3 cameraUp;
+    float3 cameraForward;
+    float3 cameraRight;
+};
+
+struct VertexIn
+{
+    // Corner of the unit quad
+    float3 position : POSITION;
+    float2 uv : TEXCOORD;
+    float3 particlePosition : PARTICLE_POSITION;
+    float2 particleSize : PARTICLE_SIZE;
+    float4 particleColor : PARTICLE_COLOR;
+    uint alignment : PARTICLE_ALIGNMENT;
+};
+
+struct PixelIn
+{
+    float4 position : SV_Position;
+    float2 uv : TEXCOORD;
+    float4 color : COLOR;
+};
+
+// Unlit, the color is emitted over a black surface. The normal is left to what is behind.
+struct PixelOut
+{
+    float4 albedo : SV_Target1;
+    float4 material : SV_Target2;
+    float4 emission : SV_Target3;
+};
+
+// Same axes as the inverted look at matrices the billboards were drawn with
+PixelIn ParticleVS(VertexIn input)
+{
+    float3 right;
+    float3 up;
+    if (input.alignment == AXIAL_ALIGNED)
+    {
+        right = -cameraRight;
+        up = float3(0, 1, 0);
+    }
+    else
+    {
+        // Facing the camera position, or parallel to the view plane
+        const float3 back = input.alignment == WORLD_ALIGNED ? normalize(input.particlePosition - cameraPosition) : cameraForward;
+        right = normalize(cross(cameraUp, back));
+        up = cross(back, right);
+    }
+
+    const float2 corner = input.position.xy * input.particleSize;
+    const float3 worldPosition = input.particlePosition + corner.x * right + corner.y * up;
+
+    PixelIn output;
+    output.position = mul(float4(worldPosition, 1), matViewProj);
+    output.uv = input.uv;
+    output.color = input.particleColor;
+    return output;
+}
+
+PixelOut ParticlePS(PixelIn input)
+{
+    const float4 color = Billboard.Sample(BillboardSampler, input.uv) * input.color;
+
+    // Perform alpha test on billboard pixel
+    if (color.w <= 0.05f)
+    {
+        discard;
+    }
+
+    // Blended like the billboards
+    PixelOut pout;
+    pout.albedo = float4(0, 0, 0, color.w);
+    pout.material = float4(0, 0, 0, color.w);
+    pout.emission = color;
+    return pout;
+}
+
+technique11 ParticleTech
+{
+    pass pass0
+    {
+        SetVertexShader(CompileShader(vs_5_0, ParticleVS()));
+        SetPixelShader(CompileShader(ps_5_0, ParticlePS()));
+    }
+}
@@ -1,28 +1,60 @@
-#include "../CommonMath.hlsli"
+// One direction of a separable blur, horizontal unless VERTICAL is defined. Reads Source and writes UAV, which must
+// be different textures. Keep in sync with PostProcessKernels.h.
+#define TILE_SIZE 64
+#define MAX_RADIUS (TILE_SIZE / 2)
 
+Texture2D<float4> Source : register(t0);
 RWTexture2D<float4> UAV : register(u0);
 
 cbuffer BlurParams
 {
-    int kernelSize;
+    // Weights of the offsets 0 to MAX_RADIUS, four per vector
+    float4 weights[MAX_RADIUS / 4 + 1];
+    int radius;
 };
 
-[numthreads(8, 8, 1)]
-void main(uint2 threadID : SV_DispatchThreadID)
+// The pixels of the group and radius more on both sides, each read once from the source
+groupshared float4 tile[TILE_SIZE + 2 * MAX_RADIUS];
+
+float GetWeight(int offset)
+{
+    return weights[offset / 4][offset % 4];
+}
+
+#ifdef VERTICAL
+static const int2 direction = int2(0, 1);
+[numthreads(1, TILE_SIZE, 1)]
+#else
+static const int2 direction = int2(1, 0);
+[numthreads(TILE_SIZE, 1, 1)]
+#endif
+void main(uint3 groupID : SV_GroupID, uint groupIndex : SV_GroupIndex)
 {
-    const int blurSize = kernelSize;
-    const int halfBlur = blurSize / 2;
-    float4 result = 0.0;
-    for (int x = -halfBlur; x < -halfBlur + blurSize; ++x)
+    uint2 size;
+    Source.GetDimensions(size.x, size.y);
+
+    // A group covers TILE_SIZE pixels of a row or a column
+    const int2 tileStart = int2(groupID.xy) * (direction * (TILE_SIZE - 1) + 1);
+    const int blurRadius = clamp(radius, 0, MAX_RADIUS);
+
+    for (int i = int(groupIndex); i < TILE_SIZE + 2 * blurRadius; i += TILE_SIZE)
     {
-        for (int y = -halfBlur; y < -halfBlur + blurSize; ++y)
-        {
-            float2 offset = float2(float(x), float(y));
-            result += UAV[threadID + offset];
-        }
+        const int2 pos = clamp(tileStart + direction * (i - blurRadius), 0, int2(size) - 1);
+        tile[i] = Source.Load(int3(pos, 0));
     }
-    
+
     GroupMemoryBarrierWithGroupSync();
-    
-    UAV[threadID] = result / pow(blurSize, 2);
-}
\ No newline at end of file
+
+    const int2 pixel = tileStart + direction * int(groupIndex);
+    if (any(pixel >= int2(size)))
+        return;
+
+    const int center = int(groupIndex) + blurRadius;
+    float4 result = tile[center] * GetWeight(0);
+    for (int r = 1; r <= blurRadius; ++r)
+    {
+        result += (tile[center - r] + tile[center + r]) * GetWeight(r);
+    }
+
+    UAV[pixel] = result;
+}
@@ -1,4 +1,11 @@
 #include "../CommonMath.hlsli"
+#include "../GBufferPacking.hlsli"
+
+// Keep in sync with PostProcessKernels.h
+#define GROUP_SIZE 8
+// Pixels cached around the group, samples landing further away read the depth buffer
+#define TILE_APRON 8
+#define TILE_SIZE (GROUP_SIZE + 2 * TILE_APRON)
 
 RWTexture2D<float4> UAV : register(u0);
 
@@ -14,7 +21,7 @@ cbuffer SSAOParams{
     float power;
 };
 
-Texture2DArray GBuffer;
+Texture2D GBufferNormal;
 Texture2D Depth;
 Texture2D Noise;
 SamplerState NoiseSampler;
@@ -26,15 +33,37 @@ float3 GetPos(float2 clipPoint)
     return DepthToWorld(Depth, invProjMat, pos, clipPoint);
 }
 
-[numthreads(8, 8, 1)]
-void main(uint2 threadID : SV_DispatchThreadID)
+// View space depths around the group, most samples land there
+groupshared float depthTile[TILE_SIZE * TILE_SIZE];
+
+float GetSampleDepth(float2 clipPoint, int2 tileStart)
+{
+    // Truncated like the load of GetPos
+    const int2 pixel = int2(clipPoint * size);
+    const int2 local = pixel - tileStart;
+    if (all(pixel >= 0 && pixel < size && local >= 0 && local < TILE_SIZE))
+        return depthTile[local.y * TILE_SIZE + local.x];
+    return GetPos(clipPoint).z;
+}
+
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
+void main(uint2 threadID : SV_DispatchThreadID, uint2 groupID : SV_GroupID, uint groupIndex : SV_GroupIndex)
 {
+    const int2 tileStart = int2(groupID) * GROUP_SIZE - TILE_APRON;
+    for (int t = int(groupIndex); t < TILE_SIZE * TILE_SIZE; t += GROUP_SIZE * GROUP_SIZE)
+    {
+        const int2 pixel = clamp(tileStart + int2(t % TILE_SIZE, t / TILE_SIZE), 0, size - 1);
+        float2 clipPoint = float2(pixel) / float2(size);
+        clipPoint.y = 1 - clipPoint.y;
+        depthTile[t] = DepthToWorld(Depth, invProjMat, float2(pixel), clipPoint).z;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
     float2 uv = float2(threadID) / float2(size);
     float3 viewPos = GetPos(uv);
     
-    float unlit = 1 - GBuffer.Load(int4(threadID, 5, 0)).x;
- 
-    float4 normWorldSpace = GBuffer.Load(int4(threadID, 1, 0)) * 2 - 1;
+    float4 normWorldSpace = float4(UnpackNormal(GBufferNormal.Load(int3(threadID, 0)).rg), 1);
     float3 normal = normalize(mul(normWorldSpace, invViewMat).xyz);
     
     float2 noiseScale = size / 4.0f;
@@ -59,12 +88,13 @@ void main(uint2 threadID : SV_DispatchThreadID)
         
         // Get z from surface and sample point
         float sampleDepth = samplePos.z;
-        float pixelDepth = GetPos(offset.xy).z;
+        float pixelDepth = GetSampleDepth(offset.xy, tileStart);
         
         float rangeCheck = smoothstep(0.0, 1.0, radius / abs(pixelDepth - sampleDepth));
         occlusion += (sampleDepth - bias > pixelDepth ? 1.0 : 0.0) * rangeCheck;
     }
     occlusion = pow(1 - (occlusion / kernelSize), power);
     
-    UAV[threadID] = float4(occlusion.xxx, 1) * unlit;
+    // Unlit surfaces have a black albedo, nothing for the occlusion to darken
+    UAV[threadID] = float4(occlusion.xxx, 1);
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
-#include "../CommonMath.hlsli"
-#include "../GaussianKernel.hlsli"
+// One direction of the depth aware gaussian blur, horizontal unless VERTICAL is defined. Reads Source and writes UAV,
+// which must be different textures. Keep in sync with PostProcessKernels.h.
+#define TILE_SIZE 64
 
 Texture2D halfResDepth : register(t0);
+Texture2D<float3> Source : register(t1);
 
 RWTexture2D<float3> UAV : register(u0);
 
@@ -9,21 +11,24 @@ static const int halfSamples = 7;
 static const float gaussFilterWeights[8] = { 0.14446445, 0.13543542, 0.11153505, 0.08055309, 0.05087564, 0.02798160, 0.01332457, 0.00545096 };
 static const float blurDepthFalloff = 1000.0f;
 
+// The pixels of the group and halfSamples more on both sides, each read once
+groupshared float3 colorTile[TILE_SIZE + 2 * halfSamples];
+groupshared float depthTile[TILE_SIZE + 2 * halfSamples];
+
 // Function taken from Benjamin Glatzel's Volumetric Lighting talk : 
 // https://www.slideshare.net/BenjaminGlatzel/volumetric-lighting-for-many-lights-in-lords-of-the-fallen
 // Slide 77
-float3 GatherGauss(int2 blurDirection, int2 pos)
+float3 GatherGauss(int center)
 {
-    float centerDepth = halfResDepth.Load(float3(pos, 0)).r;
+    float centerDepth = depthTile[center];
     
     float3 accumResult = 0;
     float accumWeights = 0;
     
     for (int r = -halfSamples; r <= halfSamples; ++r)
     {
-        int2 offset = r * blurDirection;
-        float3 kernelSample = UAV[pos + offset];
-        float kernelDepth = halfResDepth.Load(float3(pos + offset, 0)).r;
+        float3 kernelSample = colorTile[center + r];
+        float kernelDepth = depthTile[center + r];
 
         float depthDiff = abs(kernelDepth - centerDepth);
         float r2 = blurDepthFalloff * depthDiff;
@@ -37,14 +42,33 @@ float3 GatherGauss(int2 blurDirection, int2 pos)
     return accumResult / accumWeights;
 }
 
-[numthreads(8, 8, 1)]
-void main(uint2 threadID : SV_DispatchThreadID)
+#ifdef VERTICAL
+static const int2 direction = int2(0, 1);
+[numthreads(1, TILE_SIZE, 1)]
+#else
+static const int2 direction = int2(1, 0);
+[numthreads(TILE_SIZE, 1, 1)]
+#endif
+void main(uint3 groupID : SV_GroupID, uint groupIndex : SV_GroupIndex)
 {
-    // Horizontal Pass
-    UAV[threadID] = GatherGauss(int2(1, 0), threadID);
+    uint2 size;
+    Source.GetDimensions(size.x, size.y);
+
+    // A group covers TILE_SIZE pixels of a row or a column
+    const int2 tileStart = int2(groupID.xy) * (direction * (TILE_SIZE - 1) + 1);
+
+    for (int i = int(groupIndex); i < TILE_SIZE + 2 * halfSamples; i += TILE_SIZE)
+    {
+        const int2 pos = clamp(tileStart + direction * (i - halfSamples), 0, int2(size) - 1);
+        colorTile[i] = Source.Load(int3(pos, 0));
+        depthTile[i] = halfResDepth.Load(int3(pos, 0)).r;
+    }
 
     GroupMemoryBarrierWithGroupSync();
-    
-    // Vertical Pass
-    UAV[threadID] = GatherGauss(int2(0, 1), threadID);
-}
\ No newline at end of file
+
+    const int2 pixel = tileStart + direction * int(groupIndex);
+    if (any(pixel >= int2(size)))
+        return;
+
+    UAV[pixel] = GatherGauss(int(groupIndex) + halfSamples);
+}
@@ -26,14 +26,14 @@ std::enable_if_t<std::is_trivially_copyable_v<T>, unsigned int> GetBufferSize(co
 	return sizeof(data);
 }
 
-template<class T>
-const void* GetBuffer(const std::vector<T>& data)
+template<class T, class Allocator>
+const void* GetBuffer(const std::vector<T, Allocator>& data)
 {
 	return data.data();
 }
 
-template<class T>
-unsigned int GetBufferSize(const std::vector<T>& data)
+template<class T, class Allocator>
+unsigned int GetBufferSize(const std::vector<T, Allocator>& data)
 {
 	return static_cast<unsigned int>(sizeof(T) * data.size());
 }
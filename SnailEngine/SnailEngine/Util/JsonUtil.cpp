@@ -28,112 +28,67 @@
 namespace Snail
 {
 template <>
-void from_json(const nlohmann::json& json, Entity::Params& p)
+void from_json(const nlohmann::json& json, Entity::Description& d)
 {
-    static MeshManager& mm = WindowsEngine::GetModule<MeshManager>();
-    static PhysicsModule& pm = WindowsEngine::GetModule<PhysicsModule>();
+    using Body = Entity::PhysicsDescription::Body;
+    using Shape = Entity::PhysicsDescription::Shape;
 
-    get_to_if_exists(json, "name", p.name);
-    get_to_if_exists(json, "transform", p.transform);
+    get_to_if_exists(json, "name", d.name);
+    get_to_if_exists(json, "transform", d.transform);
+    get_to_if_exists(json, "mesh", d.mesh);
 
-    if (std::string meshName; get_to_if_exists(json, "mesh", meshName))
+    if (std::string occluder; get_to_if_exists(json, "occluder", occluder))
     {
-        p.mesh = mm.GetAsset<BaseMesh>(meshName);
+        if (occluder == "mesh")
+            d.occluder = OccluderType::MESH;
+        else if (occluder == "box")
+            d.occluder = OccluderType::BOX;
+        else if (occluder != "none")
+            LOGF(Logger::WARN, "Invalid occluder \"{}\" for entity \"{}\"", occluder, d.name);
     }
 
     if (nlohmann::basic_json jPhysics; get_to_if_exists(json, "physics", jPhysics))
     {
+        Entity::PhysicsDescription& physics = d.physics.emplace();
+
         std::string type = "static";
         get_to_if_exists(jPhysics, "type", type);
+        physics.body = type == "dynamic" ? Body::DYNAMIC : type == "static" ? Body::STATIC : Body::UNKNOWN;
 
-        Transform physicsTransform{};
-        get_to_if_exists(jPhysics, "shape_transform", physicsTransform);
-        physicsTransform.scale *= p.transform.scale;
+        get_to_if_exists(jPhysics, "shape_transform", physics.shapeTransform);
+        get_to_if_exists(jPhysics, "extents", physics.extents);
+        get_to_if_exists(jPhysics, "radius", physics.radius);
+        get_to_if_exists(jPhysics, "half_height", physics.halfHeight);
+        get_to_if_exists(jPhysics, "mesh_name", physics.meshName);
+        get_to_if_exists(jPhysics, "layer", physics.layer);
 
         const std::string shapeType = jPhysics.at("shape").get<std::string>();
-
-        PhysXUniquePtr<physx::PxShape> shape{};
         if (shapeType == "box")
-        {
-            Vector3 extents = Vector3::One / 2.0f;
-            get_to_if_exists(jPhysics, "extents", extents);
-            extents *= physicsTransform.scale;
-            shape.reset(pm.physics->createShape(physx::PxBoxGeometry{extents.x, extents.y, extents.z}, *pm.defaultMaterial));
-        }
+            physics.shape = Shape::BOX;
         else if (shapeType == "sphere")
-        {
-            float radius = 1;
-            get_to_if_exists(jPhysics, "radius", radius);
-            radius *= physicsTransform.scale.x;
-
-            shape.reset(pm.physics->createShape(physx::PxSphereGeometry{radius}, *pm.defaultMaterial));
-        }
+            physics.shape = Shape::SPHERE;
         else if (shapeType == "capsule")
-        {
-            float radius = 1;
-            get_to_if_exists(jPhysics, "radius", radius);
-            radius *= physicsTransform.scale.x;
-
-            float halfHeight = 1;
-            get_to_if_exists(jPhysics, "half_height", halfHeight);
-            halfHeight *= physicsTransform.scale.y;
-            shape.reset(pm.physics->createShape(physx::PxCapsuleGeometry{radius, halfHeight}, *pm.defaultMaterial));
-        }
+            physics.shape = Shape::CAPSULE;
         else if (shapeType == "plane")
-        {
-            shape.reset(pm.physics->createShape(physx::PxPlaneGeometry(), *pm.defaultMaterial));
-        }
+            physics.shape = Shape::PLANE;
         else if (shapeType == "mesh")
         {
-            // Default to mesh of the entity
-            BaseMesh* physicsMesh = p.mesh;
-
-            if (std::string meshName; get_to_if_exists(jPhysics, "mesh_name", meshName))
-            {
-                physicsMesh = mm.GetAsset<BaseMesh>(meshName);
-            }
-
-            if (physicsMesh)
-            {
-                std::string meshType = "convex";
-                get_to_if_exists(jPhysics, "mesh_type", meshType);
-
-                if (meshType == "convex")
-                {
-                    shape.reset(pm.GenerateMeshConvexShape(static_cast<Mesh<uint32_t>*>(physicsMesh), physicsTransform.scale));
-                }
-                else if (meshType == "triangle")
-                {
-                    if (type != "dynamic")
-                    {
-                        if (const auto* physMesh = dynamic_cast<Mesh<uint32_t>*>(physicsMesh))
-                            shape.reset(pm.GenerateMeshTriangleShape(physMesh, physicsTransform.scale));
-                        else if (const auto* physMesh16 = dynamic_cast<Mesh<>*>(physicsMesh))
-                            shape.reset(pm.GenerateMeshTriangleShape(physMesh16, physicsTransform.scale));
-                    }
-                    else
-                    {
-                        LOGF(Logger::FATAL, "Dynamic physics triangle meshes are not supported");
-                    }
-                }
-            }
-        }
-
-        if (shape)
-        {
-            shape->setLocalPose(physicsTransform);
-            if (type == "dynamic")
-                p.physicsObject = new DynamicPhysicsObject{shape.get(), p.transform};
-            else if (type == "static")
-                p.physicsObject = new StaticPhysicsObject{shape.get(), p.transform};
-        }
-        else
-        {
-            LOGF(Logger::WARN, "Physics shape wasn't created when physics description was supplied for entity \"{}\"", p.name);
+            std::string meshType = "convex";
+            get_to_if_exists(jPhysics, "mesh_type", meshType);
+            if (meshType == "convex")
+                physics.shape = Shape::CONVEX_MESH;
+            else if (meshType == "triangle")
+                physics.shape = Shape::TRIANGLE_MESH;
         }
     }
 }
 
+template <>
+void from_json(const nlohmann::json& json, Entity::Params& p)
+{
+    Entity::Resolve(json.get<Entity::Description>(), p);
+}
+
 /*
 TODO: Find a way to do whats here instead of whats above. This would prevent code duplication
 
@@ -157,41 +112,41 @@ void from_json(const nlohmann::json& json, TexturedMaterial& material)
     // But this means that some parsing problems could happen
     // So avoid using weird characters in texture filepath...
 
-    if (get_to_if_exists(json, "diffuse_filepath", material.diffuseTexture))
+    if (std::string filepath; get_to_if_exists(json, "diffuse_filepath", filepath))
     {
-        tm.SaveAsset<Texture2D>(material.diffuseTexture);
+        material.diffuseTexture = tm.GetTexture2DHandle(filepath);
     }
-    if (get_to_if_exists(json, "primary_blend_diffuse_filepath", material.primaryBlendDiffuseTexture))
+    if (std::string filepath; get_to_if_exists(json, "primary_blend_diffuse_filepath", filepath))
     {
         material.isBlending = true;
-        tm.SaveAsset<Texture2D>(material.primaryBlendDiffuseTexture);
+        material.primaryBlendDiffuseTexture = tm.GetTexture2DHandle(filepath);
     }
-    if (get_to_if_exists(json, "primary_blend_filepath", material.primaryBlendTexture))
+    if (std::string filepath; get_to_if_exists(json, "primary_blend_filepath", filepath))
     {
         material.isBlending = true;
-        tm.SaveAsset<Texture2D>(material.primaryBlendTexture);
+        material.primaryBlendTexture = tm.GetTexture2DHandle(filepath);
     }
-    if (get_to_if_exists(json, "secondary_blend_diffuse_filepath", material.secondaryBlendDiffuseTexture))
+    if (std::string filepath; get_to_if_exists(json, "secondary_blend_diffuse_filepath", filepath))
     {
         material.isBlending = true;
-        tm.SaveAsset<Texture2D>(material.secondaryBlendDiffuseTexture);
+        material.secondaryBlendDiffuseTexture = tm.GetTexture2DHandle(filepath);
     }
-    if (get_to_if_exists(json, "secondary_blend_filepath", material.secondaryBlendTexture))
+    if (std::string filepath; get_to_if_exists(json, "secondary_blend_filepath", filepath))
     {
         material.isBlending = true;
-        tm.SaveAsset<Texture2D>(material.secondaryBlendTexture);
+        material.secondaryBlendTexture = tm.GetTexture2DHandle(filepath);
     }
-    if (get_to_if_exists(json, "ambient_filepath", material.ambientTexture))
+    if (std::string filepath; get_to_if_exists(json, "ambient_filepath", filepath))
     {
-        tm.SaveAsset<Texture2D>(material.ambientTexture);
+        material.ambientTexture = tm.GetTexture2DHandle(filepath);
     }
-    if (get_to_if_exists(json, "specular_filepath", material.specularTexture))
+    if (std::string filepath; get_to_if_exists(json, "specular_filepath", filepath))
     {
-        tm.SaveAsset<Texture2D>(material.specularTexture);
+        material.specularTexture = tm.GetTexture2DHandle(filepath);
     }
-    if (get_to_if_exists(json, "normalmap_filepath", material.normalMapTexture))
+    if (std::string filepath; get_to_if_exists(json, "normalmap_filepath", filepath))
     {
-        tm.SaveAsset<Texture2D>(material.normalMapTexture);
+        material.normalMapTexture = tm.GetTexture2DHandle(filepath);
     }
 
     get_to_if_exists(json, "parameters", material.material);
@@ -233,42 +188,36 @@ void from_json(const nlohmann::json& json, Terrain::Params& p)
 
     if (std::string terrainDiffuseFile; get_to_if_exists(json, "diffuse_filepath", terrainDiffuseFile))
     {
-        tm.SaveAsset<Texture2D>(terrainDiffuseFile);
-        terrainMesh->SetAllMaterialMember(terrainDiffuseFile, &TexturedMaterial::diffuseTexture);
+        terrainMesh->SetAllMaterialMember(tm.GetTexture2DHandle(terrainDiffuseFile), &TexturedMaterial::diffuseTexture);
     }
 
     if (std::string blendDiffuseFilepath; get_to_if_exists(json, "primary_blend_diffuse_filepath", blendDiffuseFilepath))
     {
-        tm.SaveAsset<Texture2D>(blendDiffuseFilepath);
         terrainMesh->SetEnableBlending(true);
-        terrainMesh->SetAllMaterialMember(blendDiffuseFilepath, &TexturedMaterial::primaryBlendDiffuseTexture);
+        terrainMesh->SetAllMaterialMember(tm.GetTexture2DHandle(blendDiffuseFilepath), &TexturedMaterial::primaryBlendDiffuseTexture);
     }
 
     if (std::string blendFile; get_to_if_exists(json, "primary_blend_filepath", blendFile))
     {
-        tm.SaveAsset<Texture2D>(blendFile);
         terrainMesh->SetEnableBlending(true);
-        terrainMesh->SetAllMaterialMember(blendFile, &TexturedMaterial::primaryBlendTexture);
+        terrainMesh->SetAllMaterialMember(tm.GetTexture2DHandle(blendFile), &TexturedMaterial::primaryBlendTexture);
     }
 
     if (std::string blendDiffuseFilepath; get_to_if_exists(json, "secondary_blend_diffuse_filepath", blendDiffuseFilepath))
     {
-        tm.SaveAsset<Texture2D>(blendDiffuseFilepath);
         terrainMesh->SetEnableBlending(true);
-        terrainMesh->SetAllMaterialMember(blendDiffuseFilepath, &TexturedMaterial::secondaryBlendDiffuseTexture);
+        terrainMesh->SetAllMaterialMember(tm.GetTexture2DHandle(blendDiffuseFilepath), &TexturedMaterial::secondaryBlendDiffuseTexture);
     }
 
     if (std::string blendFile; get_to_if_exists(json, "secondary_blend_filepath", blendFile))
     {
-        tm.SaveAsset<Texture2D>(blendFile);
         terrainMesh->SetEnableBlending(true);
-        terrainMesh->SetAllMaterialMember(blendFile, &TexturedMaterial::secondaryBlendTexture);
+        terrainMesh->SetAllMaterialMember(tm.GetTexture2DHandle(blendFile), &TexturedMaterial::secondaryBlendTexture);
     }
 
     if (std::string normalMapFilepath; get_to_if_exists(json, "normalmap_filepath", normalMapFilepath))
     {
-        tm.SaveAsset<Texture2D>(normalMapFilepath);
-        terrainMesh->SetAllMaterialMember(normalMapFilepath, &TexturedMaterial::normalMapTexture);
+        terrainMesh->SetAllMaterialMember(tm.GetTexture2DHandle(normalMapFilepath), &TexturedMaterial::normalMapTexture);
     }
 
     if (Vector2 uvScale; get_to_if_exists(json, "uv_scale", uvScale))
@@ -289,7 +238,7 @@ void from_json(const nlohmann::json& json, Terrain::Params& p)
     }
 
     terrainMesh->SortVertices();
-    p.mesh = terrainMesh;
+    p.mesh = mm.GetHandle<TerrainMesh>(terrainMeshFile);
     p.physicsObject = nullptr;
 }
 
@@ -310,7 +259,7 @@ void from_json(const nlohmann::json& json, CubeSkybox::Params& p)
         subMesh.indexBufferCount = mesh->GetIndexCount();
         mesh->submeshes.push_back(std::move(subMesh));
         mesh->cubeMapTexture = tm.GetTextureCube(tex);
-        p.mesh = mesh;
+        p.mesh = mm.GetHandle<CubeMapMesh>("CubeMap");
     }
     else
     {
@@ -362,7 +311,7 @@ void from_json(const nlohmann::json& json, Billboard::Params& p)
 
     if (std::string meshName; get_to_if_exists(json, "mesh", meshName))
     {
-        p.mesh = mm.GetAsset<QuadMesh>(meshName);
+        p.mesh = mm.GetHandle<QuadMesh>(meshName);
     }
 }
 
@@ -403,7 +352,7 @@ void from_json(const nlohmann::json& json, Sphere::Params& p)
 
     if (std::string meshName; get_to_if_exists(json, "mesh", meshName))
     {
-        p.mesh = mm.GetAsset<SphereMesh>(meshName);
+        p.mesh = mm.GetHandle<SphereMesh>(meshName);
     }
 }
 
@@ -416,7 +365,7 @@ void from_json(const nlohmann::json& json, Cube::Params& p)
 
     if (std::string meshName; get_to_if_exists(json, "mesh", meshName))
     {
-        p.mesh = mm.GetAsset<CubeMesh>(meshName);
+        p.mesh = mm.GetHandle<CubeMesh>(meshName);
     }
 }
 
@@ -429,7 +378,7 @@ void from_json(const nlohmann::json& json, Decal::Params& p)
 
     if (std::string meshName; get_to_if_exists(json, "mesh", meshName))
     {
-        p.mesh = mm.GetAsset<DecalMesh>(meshName);
+        p.mesh = mm.GetHandle<DecalMesh>(meshName);
     }
 }
 
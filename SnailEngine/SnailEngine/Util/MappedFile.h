@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace Snail
+{
+
+// Read only view of a whole file mapped in memory, pages are loaded by the OS on first access
+class MappedFile
+{
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+    const std::byte* data = nullptr;
+    size_t size = 0;
+
+public:
+    MappedFile() = default;
+    // Stays closed if the file can't be opened or is empty
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    void Close() noexcept;
+    [[nodiscard]] bool IsOpen() const noexcept { return data != nullptr; }
+    [[nodiscard]] std::span<const std::byte> GetData() const noexcept { return {data, size}; }
+};
+
+}
@@ -28,39 +28,22 @@ TexturedMaterial ConvertRapidObjMatToTexturedMaterial(const rapidobj::Material&
     // Import textures if they exist
     if (!rapidMat.ambient_texname.empty())
     {
-        mat.ambientTexture = pathPrefix + rapidMat.ambient_texname;
-        if (!tm.DoesAssetExist(mat.ambientTexture))
-        {
-            tm.SaveAsset<Texture2D>(mat.ambientTexture, isPersistent);
-        }
+        mat.ambientTexture = tm.GetTexture2DHandle(pathPrefix + rapidMat.ambient_texname, isPersistent);
     }
 
     if (!rapidMat.diffuse_texname.empty())
     {
-        // Avoid duplicate diffuses
-        mat.diffuseTexture = pathPrefix + rapidMat.diffuse_texname;
-        if (!tm.DoesAssetExist(mat.diffuseTexture))
-        {
-            tm.SaveAsset<Texture2D>(mat.diffuseTexture, isPersistent);
-        }
+        mat.diffuseTexture = tm.GetTexture2DHandle(pathPrefix + rapidMat.diffuse_texname, isPersistent);
     }
 
     if (!rapidMat.specular_texname.empty())
     {
-        mat.specularTexture = pathPrefix + rapidMat.specular_texname;
-        if (!tm.DoesAssetExist(mat.specularTexture))
-        {
-            tm.SaveAsset<Texture2D>(mat.specularTexture, isPersistent);
-        }
+        mat.specularTexture = tm.GetTexture2DHandle(pathPrefix + rapidMat.specular_texname, isPersistent);
     }
 
     if (!rapidMat.normal_texname.empty())
     {
-        mat.normalMapTexture = pathPrefix + rapidMat.normal_texname;
-        if (!tm.DoesAssetExist(mat.normalMapTexture))
-        {
-            tm.SaveAsset<Texture2D>(mat.normalMapTexture, isPersistent);
-        }
+        mat.normalMapTexture = tm.GetTexture2DHandle(pathPrefix + rapidMat.normal_texname, isPersistent);
     }
 
     // Add other material parameters if needed -> https://github.com/guybrush77/rapidobj#materials
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <comdef.h>
 #include <string>
 #include <optional>
@@ -176,7 +177,7 @@ inline Vector3 GetTriangleNormal(const Vector3& p1, const Vector3& p2, const Vec
     return v3;
 }
 
-std::vector<Vector3> GetFrustumCornersWorldSpace(const Matrix& viewProj);
+std::array<Vector3, 8> GetFrustumCornersWorldSpace(const Matrix& viewProj);
 
 bool IsInFrustum(const DirectX::BoundingFrustum& frustum, const DirectX::BoundingBox& boundingBox);
 bool IsInFrustum(const DirectX::BoundingFrustum& frustum, const DirectX::BoundingOrientedBox& boundingOrientedBox);
@@ -187,4 +188,7 @@ bool IsGrassPatchInFrustum(const DirectX::BoundingFrustum& frustum, const GrassG
 
 DirectX::BoundingFrustum GetFrustumFromCamera(const Camera* projectionCamera);
 
+// Average bits per texel, block compressed formats included. Returns 0 for unknown formats.
+uint32_t GetFormatBitsPerPixel(DXGI_FORMAT format);
+
 };
@@ -0,0 +1,88 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Core/Assets/AssetHotReload.h"
+
+namespace Snail
+{
+
+// Touches files in a temporary directory and checks that only the assets built from them are reloaded
+void TestAssetHotReload(TestContext& test)
+{
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "SnailEngineHotReloadTest";
+    std::error_code error;
+    std::filesystem::remove_all(root, error);
+    std::filesystem::create_directories(root / "Textures", error);
+    std::filesystem::create_directories(root / "Models", error);
+    std::filesystem::create_directories(root / "Shaders" / "Include", error);
+
+    // Write times can have a coarse resolution, every touch moves the file a second further
+    std::unordered_map<std::string, int> touchCounts;
+    const auto touch = [&root, &touchCounts](const std::string& file)
+    {
+        const std::filesystem::path path = root / file;
+        std::ofstream{path, std::ios::app} << "touched\n";
+        std::error_code touchError;
+        const auto writeTime = std::filesystem::file_time_type::clock::now() + std::chrono::seconds{++touchCounts[file]};
+        std::filesystem::last_write_time(path, writeTime, touchError);
+    };
+
+    for (const char* file : {"Textures/a.png", "Textures/unused.png", "Models/b.obj", "Models/b.mtl", "Models/c.obj", "Shaders/Lit.fx", "Shaders/Include/Common.hlsli"})
+        touch(file);
+
+    const AssetKey textureA{AssetKind::TEXTURE, (root / "Textures/a.png").string()};
+    const AssetKey meshB{AssetKind::MESH, "b"};
+    const AssetKey meshC{AssetKind::MESH, "c"};
+    const AssetKey shaders{AssetKind::SHADERS, {}};
+
+    AssetDependencyGraph dependencyGraph;
+    dependencyGraph.Add(root / "Textures/a.png", textureA);
+    dependencyGraph.Add(root / "Models/b.obj", meshB);
+    dependencyGraph.Add(root / "Models/b.mtl", meshB);
+    dependencyGraph.Add(root / "Models/c.obj", meshC);
+    // c uses b's materials too
+    dependencyGraph.Add(root / "Models/b.mtl", meshC);
+    dependencyGraph.AddDirectory(root / "Shaders", shaders);
+
+    FileWatcher fileWatcher;
+    fileWatcher.Watch(root);
+    test.Check(fileWatcher.Scan().empty(), "the first scan only records the files");
+    test.Check(fileWatcher.GetFileCount() == 7, "every file is watched");
+    test.Check(fileWatcher.Scan().empty(), "nothing changes without a write");
+
+    const auto reloadedBy = [&](std::initializer_list<const char*> files)
+    {
+        for (const char* file : files)
+            touch(file);
+        const std::vector<std::string> changedFiles = fileWatcher.Scan();
+        test.Check(changedFiles.size() == files.size(), "exactly the touched files changed");
+        return dependencyGraph.GetDependents(changedFiles);
+    };
+
+    test.Check(reloadedBy({"Models/c.obj"}) == std::vector{meshC}, "an OBJ reloads its mesh only");
+    test.Check(reloadedBy({"Models/b.obj", "Models/b.mtl"}) == std::vector{meshB, meshC}, "two files of a mesh reload it once");
+    test.Check(reloadedBy({"Textures/a.png"}) == std::vector{textureA}, "a texture reloads itself only");
+    test.Check(reloadedBy({"Textures/unused.png"}).empty(), "files no asset is built from reload nothing");
+    test.Check(reloadedBy({"Shaders/Lit.fx", "Shaders/Include/Common.hlsli"}) == std::vector{shaders}, "shader files reload the shaders once");
+
+    std::ofstream{root / "Models/d.obj"} << "v 0 0 0\n";
+    const std::vector<std::string> createdFiles = fileWatcher.Scan();
+    test.Check(createdFiles.size() == 1 && createdFiles[0].ends_with("models/d.obj"), "created files are reported");
+    test.Check(dependencyGraph.GetDependents(createdFiles).empty(), "a new file reloads nothing until an asset uses it");
+
+    std::filesystem::remove(root / "Models/d.obj", error);
+    test.Check(fileWatcher.Scan().empty(), "removed files are not reported");
+    test.Check(fileWatcher.GetFileCount() == 7, "removed files are forgotten");
+
+    std::filesystem::remove_all(root, error);
+}
+
+}
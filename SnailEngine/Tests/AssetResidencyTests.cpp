@@ -0,0 +1,91 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <string>
+#include <string_view>
+
+#include "TestEngine.h"
+#include "Core/WindowsEngine.h"
+
+namespace Snail
+{
+
+namespace
+{
+
+struct ResidencyDelta
+{
+    AssetResidencyStats meshes;
+    AssetResidencyStats textures;
+    float loadMs = 0;
+};
+
+AssetResidencyStats operator-(const AssetResidencyStats& after, const AssetResidencyStats& before) noexcept
+{
+    return {after.hits - before.hits, after.misses - before.misses, after.evictions - before.evictions};
+}
+
+// Loads a scene and returns what it did to the caches
+ResidencyDelta LoadAndMeasure(TestContext& test, WindowsEngine& engine, const std::string& filename)
+{
+    const MeshManager& meshManager = WindowsEngine::GetModule<MeshManager>();
+    const TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
+
+    const AssetResidencyStats meshesBefore = meshManager.GetResidencyStats();
+    const AssetResidencyStats texturesBefore = textureManager.GetResidencyStats();
+    const auto start = TestClock::now();
+    LoadTestScene(test, engine, filename);
+
+    return {meshManager.GetResidencyStats() - meshesBefore, textureManager.GetResidencyStats() - texturesBefore, ElapsedMs(start)};
+}
+
+void ReportLoad(TestContext& test, const std::string_view step, const ResidencyDelta& delta)
+{
+    test.Report("{}: {:.0f} ms, meshes {} hits {} misses {} evictions, textures {} hits {} misses {} evictions", step, delta.loadMs,
+        delta.meshes.hits, delta.meshes.misses, delta.meshes.evictions,
+        delta.textures.hits, delta.textures.misses, delta.textures.evictions);
+}
+
+}
+
+// Goes from the level to the main menu and back, under the default budget and then under an empty one, and reports the
+// hits, misses and evictions of the mesh and texture caches for every load
+void BenchmarkAssetResidency(TestContext& test)
+{
+    WindowsEngine* engine = GetTestEngine(test);
+    if (!engine)
+        return;
+
+    MeshManager& meshManager = WindowsEngine::GetModule<MeshManager>();
+    TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
+
+    const ResidencyDelta coldLoad = LoadAndMeasure(test, *engine, TEST_LEVEL_PATH);
+    ReportLoad(test, "Level, cold", coldLoad);
+    ReportLoad(test, "Main menu", LoadAndMeasure(test, *engine, TEST_MENU_PATH));
+    const ResidencyDelta warmLoad = LoadAndMeasure(test, *engine, TEST_LEVEL_PATH);
+    ReportLoad(test, "Level, resident", warmLoad);
+
+    test.Check(coldLoad.meshes.misses + coldLoad.textures.misses > 0, "the cold load didn't load anything");
+    test.Check(warmLoad.meshes.misses + warmLoad.textures.misses < coldLoad.meshes.misses + coldLoad.textures.misses,
+        "loading the level again under the default budget loaded as many assets as the first time");
+
+    // Everything unreferenced is evicted when the level is unloaded
+    const AssetMemoryUsage meshBudget = meshManager.GetBudget();
+    const AssetMemoryUsage textureBudget = textureManager.GetBudget();
+    meshManager.SetBudget({});
+    textureManager.SetBudget({});
+
+    const ResidencyDelta evictingUnload = LoadAndMeasure(test, *engine, TEST_MENU_PATH);
+    ReportLoad(test, "Main menu, no budget", evictingUnload);
+    const ResidencyDelta evictedLoad = LoadAndMeasure(test, *engine, TEST_LEVEL_PATH);
+    ReportLoad(test, "Level, no budget", evictedLoad);
+
+    meshManager.SetBudget(meshBudget);
+    textureManager.SetBudget(textureBudget);
+
+    test.Check(evictingUnload.meshes.evictions + evictingUnload.textures.evictions > 0, "unloading the level without a budget didn't evict anything");
+    test.Check(evictedLoad.meshes.misses + evictedLoad.textures.misses > warmLoad.meshes.misses + warmLoad.textures.misses,
+        "the evicted assets didn't have to be loaded again");
+}
+
+}
@@ -0,0 +1,149 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "TestPhysics.h"
+#include "Core/Physics/CollisionLayers.h"
+#include "Core/Physics/PhysXAllocator.h"
+#include "Core/Physics/Callbacks/ContactCallback.h"
+
+using namespace physx;
+
+namespace Snail
+{
+
+namespace
+{
+// Counts the trigger pairs PhysX reports
+struct TriggerCounter : PxSimulationEventCallback
+{
+    size_t pairCount = 0;
+
+    void onTrigger(PxTriggerPair*, const PxU32 count) override { pairCount += count; }
+    void onContact(const PxContactPairHeader&, const PxContactPair*, PxU32) override {}
+    void onConstraintBreak(PxConstraintInfo*, PxU32) override {}
+    void onWake(PxActor**, PxU32) override {}
+    void onSleep(PxActor**, PxU32) override {}
+    void onAdvance(const PxRigidBody* const*, const PxTransform*, const PxU32) override {}
+};
+}
+
+// Drops piles of props and debris into trigger volumes, once with every shape interacting with every other and once
+// with the default layers
+void BenchmarkCollisionLayers(TestContext& test)
+{
+    constexpr int CLUSTER_GRID_SIZE = 10;
+    constexpr float CLUSTER_SPACING = 12.0f;
+    constexpr int PROPS_PER_CLUSTER = 4;
+    constexpr int DEBRIS_PER_CLUSTER = 24;
+    constexpr int VEHICLE_COUNT = 4;
+    constexpr int STEP_COUNT = 120;
+    constexpr float STEP = 1.0f / 60.0f;
+
+    PxPhysics& physics = TestPhysics::Get().GetPhysics();
+    const CollisionLayers layers = CollisionLayers::CreateDefault();
+    const PhysXUniquePtr<PxMaterial> material{physics.createMaterial(0.8f, 0.8f, 0.2f)};
+
+    struct Run
+    {
+        // Summed over the steps
+        size_t broadPhasePairCount = 0;
+        size_t contactPairCount = 0;
+        size_t triggerPairCount = 0;
+        float simulateMs = 0;
+    };
+
+    // The same scene twice, first with every shape colliding with every other like before the layers
+    const auto run = [&](const bool useLayers)
+    {
+        Run result;
+        TriggerCounter triggerCounter;
+        PxSceneDesc sceneDesc(physics.getTolerancesScale());
+        sceneDesc.gravity = PxVec3(0.0f, -9.81f, 0.0f);
+        sceneDesc.cpuDispatcher = &TestPhysics::Get().GetDispatcher();
+        sceneDesc.filterShader = FilterShader;
+        sceneDesc.simulationEventCallback = &triggerCounter;
+        const PhysXUniquePtr<PxScene> scene{physics.createScene(sceneDesc)};
+
+        std::vector<PhysXUniquePtr<PxRigidActor>> actors;
+        const auto addActor = [&](PxRigidActor* actor, const PxGeometry& geometry, const char* layer, const bool isTrigger = false)
+        {
+            PxShape* shape = PxRigidActorExt::createExclusiveShape(*actor, geometry, *material);
+            if (isTrigger)
+            {
+                shape->setFlag(PxShapeFlag::eSIMULATION_SHAPE, false);
+                shape->setFlag(PxShapeFlag::eSCENE_QUERY_SHAPE, false);
+                shape->setFlag(PxShapeFlag::eTRIGGER_SHAPE, true);
+            }
+            if (useLayers)
+                layers.Apply(*shape, layer);
+            scene->addActor(*actor);
+            actors.emplace_back(actor);
+        };
+
+        addActor(physics.createRigidStatic(PxTransformFromPlaneEquation(PxPlane(0, 1, 0, 0))), PxPlaneGeometry{}, "terrain");
+
+        std::mt19937 rng{7};
+        std::uniform_real_distribution<float> offset{-2.0f, 2.0f};
+        for (int x = 0; x < CLUSTER_GRID_SIZE; ++x)
+        {
+            for (int z = 0; z < CLUSTER_GRID_SIZE; ++z)
+            {
+                const PxVec3 center{static_cast<float>(x) * CLUSTER_SPACING, 0, static_cast<float>(z) * CLUSTER_SPACING};
+
+                // A checkpoint around each pile
+                addActor(physics.createRigidStatic(PxTransform{center + PxVec3{0, 3, 0}}), PxBoxGeometry{4, 3, 4}, "trigger", true);
+
+                for (int i = 0; i < PROPS_PER_CLUSTER; ++i)
+                    addActor(physics.createRigidDynamic(PxTransform{center + PxVec3{offset(rng) * 0.5f, 0.5f + 1.1f * static_cast<float>(i), offset(rng) * 0.5f}}), PxBoxGeometry{0.5f, 0.5f, 0.5f}, "prop");
+
+                for (int i = 0; i < DEBRIS_PER_CLUSTER; ++i)
+                    addActor(physics.createRigidDynamic(PxTransform{center + PxVec3{offset(rng), 0.2f + 0.3f * static_cast<float>(i % 6), offset(rng)}}), PxSphereGeometry{0.2f}, "debris");
+            }
+        }
+
+        for (int i = 0; i < VEHICLE_COUNT; ++i)
+            addActor(physics.createRigidDynamic(PxTransform{PxVec3{static_cast<float>(i) * CLUSTER_SPACING * 2, 1, -CLUSTER_SPACING}}), PxBoxGeometry{1, 0.7f, 2.5f}, "vehicle");
+
+        for (int step = 0; step < STEP_COUNT; ++step)
+        {
+            const auto start = TestClock::now();
+            scene->simulate(STEP);
+            scene->fetchResults(true);
+            result.simulateMs += ElapsedMs(start);
+
+            PxSimulationStatistics stats;
+            scene->getSimulationStatistics(stats);
+            result.broadPhasePairCount += stats.nbNewPairs;
+            result.contactPairCount += stats.nbDiscreteContactPairsTotal;
+        }
+        result.triggerPairCount = triggerCounter.pairCount;
+
+        // Before the scene
+        for (PhysXUniquePtr<PxRigidActor>& actor : actors)
+            scene->removeActor(*actor);
+        return result;
+    };
+
+    const Run withoutLayers = run(false);
+    const Run withLayers = run(true);
+    constexpr size_t shapeCount = static_cast<size_t>(CLUSTER_GRID_SIZE * CLUSTER_GRID_SIZE * (1 + PROPS_PER_CLUSTER + DEBRIS_PER_CLUSTER) + VEHICLE_COUNT + 1);
+
+    test.Check(withLayers.broadPhasePairCount < withoutLayers.broadPhasePairCount, "the layers filter out broadphase pairs");
+    for (const auto& [name, result] : {std::pair{"without layers", withoutLayers}, std::pair{"with layers", withLayers}})
+    {
+        test.Report("{}: {} shapes, {} broadphase pairs, {} contact pairs and {} trigger pairs over {} steps, simulate {:.2f} ms",
+            name,
+            shapeCount,
+            result.broadPhasePairCount,
+            result.contactPairCount,
+            result.triggerPairCount,
+            STEP_COUNT,
+            result.simulateMs);
+    }
+}
+
+}
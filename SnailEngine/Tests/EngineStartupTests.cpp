@@ -0,0 +1,85 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "TestEngine.h"
+#include "Core/WindowsEngine.h"
+
+namespace Snail
+{
+
+namespace
+{
+
+struct ExpectedTask
+{
+    const char* name;
+    bool onMainThread;
+    std::vector<const char*> dependencies;
+};
+
+// Keep in sync with the startup graph of Engine::Init
+const std::vector<ExpectedTask> ENGINE_TASKS = {
+    {"Physics", false, {}},
+    {"Audio", true, {}},
+    {"Textures", false, {}},
+    {"Mesh manager", false, {"Textures"}},
+    {"Default font", false, {"Textures"}},
+    {"Asset hot reload", false, {}},
+    {"Loading screen", true, {"Textures"}},
+    {"Camera manager", false, {}},
+    {"Game manager", false, {"Audio", "Textures", "Default font", "Camera manager"}},
+    {"Renderer", true, {"Textures", "Mesh manager", "Camera manager"}},
+    {"Scene", true, {"Physics", "Textures", "Mesh manager", "Camera manager", "Game manager", "Renderer"}},
+};
+
+// Rounding of the timings, a task may appear to start a hair before its dependency ended
+constexpr float TIMING_TOLERANCE_MS = 0.01f;
+
+}
+
+// Reads the timings the engine recorded while the test engine was initialised, checks that every module task ran once,
+// on its thread, after its dependencies, and reports how long each one took
+void BenchmarkEngineStartup(TestContext& test)
+{
+    const WindowsEngine* engine = GetTestEngine(test);
+    if (!engine)
+        return;
+
+    const StartupGraph::Results& results = engine->GetStartupResults();
+    const auto findTiming = [&results](const std::string_view name) -> const StartupGraph::Timing*
+    {
+        const auto timing = std::ranges::find(results.timings, name, &StartupGraph::Timing::name);
+        return timing == results.timings.end() ? nullptr : &*timing;
+    };
+
+    test.Check(results.timings.size() == ENGINE_TASKS.size(), "the engine didn't run the expected number of tasks");
+    for (const ExpectedTask& task : ENGINE_TASKS)
+    {
+        const StartupGraph::Timing* timing = findTiming(task.name);
+        if (!test.Check(timing != nullptr, std::format("{} has no timing", task.name)))
+            continue;
+
+        test.Check(timing->durationMs >= 0 && timing->startMs + timing->durationMs <= results.totalMs + TIMING_TOLERANCE_MS, std::format("{} has a timing outside of the startup", task.name));
+        test.Check(timing->onMainThread == task.onMainThread, std::format("{} ran on the wrong thread", task.name));
+        for (const char* dependency : task.dependencies)
+        {
+            const StartupGraph::Timing* dependencyTiming = findTiming(dependency);
+            test.Check(dependencyTiming && timing->startMs + TIMING_TOLERANCE_MS >= dependencyTiming->startMs + dependencyTiming->durationMs,
+                std::format("{} started before {} finished", task.name, dependency));
+        }
+    }
+
+    // In the order they finished
+    for (const StartupGraph::Timing& timing : results.timings)
+        test.Report("{}: {:.1f} ms, started at {:.1f} ms on {}", timing.name, timing.durationMs, timing.startMs, timing.onMainThread ? "the main thread" : "a worker");
+
+    const auto slowest = std::ranges::max_element(results.timings, {}, &StartupGraph::Timing::durationMs);
+    test.Check(slowest == results.timings.end() || results.totalMs + TIMING_TOLERANCE_MS >= slowest->durationMs, "the startup took less than its slowest task");
+    test.Report("Startup {:.1f} ms, {:.1f} ms run one after the other, x{:.2f}", results.totalMs, results.serialMs, results.totalMs > 0 ? results.serialMs / results.totalMs : 0.0f);
+}
+
+}
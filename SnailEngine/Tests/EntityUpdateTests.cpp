@@ -0,0 +1,184 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Core/EntityUpdate.h"
+#include "Core/ThreadPool.h"
+#include "Entities/Entity.h"
+
+namespace Snail
+{
+
+namespace
+{
+
+// Independent work comparable to a trigger or firefly update, which also issues every kind of deferred command
+class SyntheticEntity : public Entity
+{
+    LightHandle light;
+    int workIterations;
+    int frame = 0;
+
+public:
+    size_t index;
+
+    SyntheticEntity(const size_t entityIndex, const Transform& initialTransform, const LightHandle entityLight, const int iterations)
+        : Entity{Params{.name = "Synthetic", .transform = initialTransform, .castsShadows = false}}
+        , light{entityLight}
+        , workIterations{iterations}
+        , index{entityIndex}
+    {}
+
+    void Update(const float dt) noexcept override
+    {
+        Entity::Update(dt);
+
+        Quaternion rotation = transform.rotation;
+        for (int i = 0; i < workIterations; ++i)
+            rotation = Quaternion::Concatenate(rotation, Quaternion::CreateFromAxisAngle(Vector3::UnitY, dt));
+        rotation.Normalize();
+        SetRotation(rotation);
+        SetPosition(transform.position + transform.GetForwardVector() * dt);
+
+        // Recorded directly, there is neither a renderer nor a scene outside of the engine
+        SceneCommandBuffer* commands = SceneCommandBuffer::GetRecording();
+        commands->DrawLine({transform.position, Color{1, 0, 0}}, {transform.position + transform.GetUpVector(), Color{0, 1, 0}});
+        commands->SetLightPosition(light, transform.position);
+
+        if (++frame % 7 == 0)
+            commands->RemoveEntity(this);
+    }
+};
+
+struct SyntheticScene
+{
+    LightManager lights;
+    std::vector<std::unique_ptr<SyntheticEntity>> entities;
+    std::vector<Entity*> entityPointers;
+    std::vector<SceneCommandBuffer> commandBuffers;
+
+    SyntheticScene(const size_t entityCount, const int workIterations)
+    {
+        for (size_t i = 0; i < entityCount; ++i)
+        {
+            Transform initialTransform;
+            initialTransform.position = Vector3{static_cast<float>(i % 64), 0, static_cast<float>(i / 64)};
+            entities.push_back(std::make_unique<SyntheticEntity>(i, initialTransform, lights.AddPointLight({}), workIterations));
+            entityPointers.push_back(entities.back().get());
+        }
+    }
+};
+
+}
+
+// Compares the parallel update against a single job on synthetic entities over many frames
+void TestEntityUpdate(TestContext& test)
+{
+    constexpr size_t ENTITY_COUNT = 4096;
+    constexpr int FRAME_COUNT = 64;
+    constexpr float DT = 1.0f / 60.0f;
+
+    ThreadPool pool;
+    SyntheticScene serialScene{ENTITY_COUNT, 4};
+    SyntheticScene parallelScene{ENTITY_COUNT, 4};
+
+    const auto indexOf = [](const Entity* entity) { return static_cast<const SyntheticEntity*>(entity)->index; };
+
+    // Commands flattened in execution order
+    const auto flatten = [](const std::vector<SceneCommandBuffer>& buffers)
+    {
+        SceneCommandBuffer merged;
+        for (const SceneCommandBuffer& buffer : buffers)
+        {
+            merged.removedEntities.insert(merged.removedEntities.end(), buffer.removedEntities.begin(), buffer.removedEntities.end());
+            merged.lightPositions.insert(merged.lightPositions.end(), buffer.lightPositions.begin(), buffer.lightPositions.end());
+            merged.debugLines.insert(merged.debugLines.end(), buffer.debugLines.begin(), buffer.debugLines.end());
+            merged.localTransforms.insert(merged.localTransforms.end(), buffer.localTransforms.begin(), buffer.localTransforms.end());
+        }
+        return merged;
+    };
+
+    for (int frame = 0; frame < FRAME_COUNT; ++frame)
+    {
+        UpdateEntitiesInParallel(serialScene.entityPointers, DT, pool, 1, serialScene.commandBuffers);
+        // Odd job counts on purpose so that batches don't line up with the serial run
+        UpdateEntitiesInParallel(parallelScene.entityPointers, DT, pool, std::thread::hardware_concurrency() * 2 + 1, parallelScene.commandBuffers);
+
+        const SceneCommandBuffer expected = flatten(serialScene.commandBuffers);
+        const SceneCommandBuffer actual = flatten(parallelScene.commandBuffers);
+
+        bool matches = expected.removedEntities.size() == actual.removedEntities.size()
+            && expected.lightPositions.size() == actual.lightPositions.size()
+            && expected.debugLines.size() == actual.debugLines.size()
+            && expected.localTransforms.size() == actual.localTransforms.size()
+            && expected.lightPositions.size() == ENTITY_COUNT
+            && expected.debugLines.size() == ENTITY_COUNT;
+
+        for (size_t i = 0; matches && i < expected.removedEntities.size(); ++i)
+            matches = indexOf(expected.removedEntities[i]) == indexOf(actual.removedEntities[i]);
+
+        for (size_t i = 0; matches && i < expected.lightPositions.size(); ++i)
+        {
+            // Both scenes added their lights in the same order, the handles match
+            matches = expected.lightPositions[i].first == actual.lightPositions[i].first
+                && expected.lightPositions[i].second == actual.lightPositions[i].second;
+        }
+
+        for (size_t i = 0; matches && i < expected.debugLines.size(); ++i)
+        {
+            matches = expected.debugLines[i].first.position == actual.debugLines[i].first.position
+                && expected.debugLines[i].second.position == actual.debugLines[i].second.position;
+        }
+
+        // The world matrices only change once the recorded local transforms are written
+        for (const SceneCommandBuffer& buffer : serialScene.commandBuffers)
+            buffer.ApplyTransforms();
+        for (const SceneCommandBuffer& buffer : parallelScene.commandBuffers)
+            buffer.ApplyTransforms();
+
+        for (size_t i = 0; matches && i < ENTITY_COUNT; ++i)
+        {
+            const Transform& expectedTransform = serialScene.entities[i]->GetTransform();
+            const Transform& actualTransform = parallelScene.entities[i]->GetTransform();
+            matches = expectedTransform.position == actualTransform.position && expectedTransform.rotation == actualTransform.rotation
+                && serialScene.entities[i]->GetWorldTransformMatrix() == parallelScene.entities[i]->GetWorldTransformMatrix();
+        }
+
+        if (!test.Check(matches, std::format("the parallel update matches the serial one on frame {}", frame)))
+            return;
+    }
+}
+
+// Times one update of the synthetic entities for 1, 2, 4... jobs
+void BenchmarkEntityUpdate(TestContext& test)
+{
+    constexpr size_t ENTITY_COUNT = 16384;
+    constexpr int FRAME_COUNT = 10;
+
+    ThreadPool pool;
+    SyntheticScene scene{ENTITY_COUNT, 64};
+
+    float serialMs = 0;
+    const size_t maxJobCount = std::max(std::thread::hardware_concurrency(), 1u);
+    for (size_t jobCount = 1; ; jobCount = std::min(jobCount * 2, maxJobCount))
+    {
+        const auto start = TestClock::now();
+        for (int frame = 0; frame < FRAME_COUNT; ++frame)
+            UpdateEntitiesInParallel(scene.entityPointers, 1.0f / 60.0f, pool, jobCount, scene.commandBuffers);
+        const float updateMs = ElapsedMs(start) / FRAME_COUNT;
+
+        if (jobCount == 1)
+            serialMs = updateMs;
+        test.Report("Entity update of {} entities with {} jobs: {:.3f} ms (x{:.2f})", ENTITY_COUNT, jobCount, updateMs, serialMs / updateMs);
+
+        if (jobCount == maxJobCount)
+            break;
+    }
+    test.Check(scene.commandBuffers.front().GetCommandCount() > 0, "the entities recorded their commands");
+}
+
+}
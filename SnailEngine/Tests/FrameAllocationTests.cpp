@@ -0,0 +1,43 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include "TestEngine.h"
+#include "Core/WindowsEngine.h"
+#include "Core/Memory/MemoryTracker.h"
+
+namespace Snail
+{
+
+// Runs the level for the frames of the steady state check, the engine must not allocate on the heap outside of the UI
+// and the asset loading once it has settled
+void TestFrameAllocations(TestContext& test)
+{
+    // Long enough for the streaming, the pools and the frame arena to reach their size
+    constexpr int WARMUP_FRAMES = 300;
+    // Frames without a delta don't move the check forward
+    constexpr size_t MAX_CHECK_FRAMES = 4 * MemoryTracker::STEADY_STATE_CHECK_FRAMES;
+
+    WindowsEngine* engine = GetTestEngine(test);
+    if (!engine || !LoadTestScene(test, *engine, TEST_LEVEL_PATH))
+        return;
+
+    for (int frame = 0; frame < WARMUP_FRAMES; ++frame)
+        engine->RunFrame();
+
+    MemoryTracker::StartSteadyStateCheck();
+    for (size_t frame = 0; frame < MAX_CHECK_FRAMES && !MemoryTracker::IsSteadyStateCheckDone(); ++frame)
+        engine->RunFrame();
+
+    if (!test.Check(MemoryTracker::IsSteadyStateCheckDone(), "the steady state check didn't finish"))
+        return;
+
+    for (size_t i = 0; i < static_cast<size_t>(MemoryTag::COUNT); ++i)
+    {
+        const auto tag = static_cast<MemoryTag>(i);
+        if (const size_t allocations = MemoryTracker::GetSteadyStateAllocations(tag); allocations > 0)
+            test.Report("{}: {} heap allocations over {} frames", GetMemoryTagName(tag), allocations, MemoryTracker::STEADY_STATE_CHECK_FRAMES - 1);
+    }
+    test.Check(MemoryTracker::HasSteadyStateCheckPassed(), "the engine allocated on the heap in steady state");
+}
+
+}
@@ -0,0 +1,119 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "Core/FramePacer.h"
+
+namespace Snail
+{
+
+namespace
+{
+
+// Microsecond counts that only move when the pacer sleeps or spins, or when a frame does its work
+class FakeClock final : public PacingClock
+{
+public:
+    int64_t now = 0;
+    // Added to every sleep
+    int64_t oversleep = 0;
+
+    int64_t GetTimeCount() const override { return now; }
+    double GetSecPerCount() const noexcept override { return 0.000001; }
+    void SleepFor(const double seconds) override { now += static_cast<int64_t>(seconds * 1000000.0) + oversleep; }
+    void SpinWait() noexcept override { ++now; }
+
+    void Work(const double ms) { now += static_cast<int64_t>(ms * 1000.0); }
+};
+
+}
+
+// Paces frames of known lengths against a fake clock that oversleeps, checks the frame times and percentiles
+void TestFramePacer(TestContext& test)
+{
+    const auto isNear = [](const float value, const float expected) { return std::abs(value - expected) < 0.01f; };
+
+    // Runs frameCount frames of workMs each, returns the longest and shortest frame
+    const auto runFrames = [](FramePacer& pacer, FakeClock& fakeClock, const int frameCount, const double workMs, const bool inMenu)
+    {
+        float shortest = std::numeric_limits<float>::max();
+        float longest = 0;
+        for (int i = 0; i < frameCount; ++i)
+        {
+            const int64_t start = fakeClock.now;
+            fakeClock.Work(workMs);
+            pacer.WaitForNextFrame(inMenu);
+            const auto ms = static_cast<float>(fakeClock.now - start) / 1000.0f;
+            shortest = std::min(shortest, ms);
+            longest = std::max(longest, ms);
+        }
+        return std::pair{shortest, longest};
+    };
+
+    {
+        // Sleeps waking up a millisecond late, the margin must absorb it
+        FakeClock fakeClock;
+        fakeClock.oversleep = 1000;
+        FramePacer pacer{fakeClock};
+        pacer.GetSettings().targetFps = 100;
+        pacer.WaitForNextFrame(false);
+        const auto [shortest, longest] = runFrames(pacer, fakeClock, 100, 3.0, false);
+        test.Check(shortest >= 10.0f && longest <= 10.01f, "frames at 100 FPS must last 10 ms");
+        test.Check(pacer.GetSpinMargin() >= 0.001 && pacer.GetSpinMargin() < 0.002, "the spin margin must follow the late wake ups");
+        test.Check(pacer.GetStats().spinMs < 0.5f, "most of the wait must be slept once the margin settled");
+        test.Check(isNear(pacer.GetStats().p50Ms, 10.0f) && pacer.GetStats().hitchCount == 0, "paced frames are not hitches");
+
+        // Menus run at their own rate
+        const auto [menuShortest, menuLongest] = runFrames(pacer, fakeClock, 20, 3.0, true);
+        test.Check(menuShortest >= 1000.0f / 60.0f && menuLongest <= 1000.0f / 60.0f + 0.01f, "menu frames at 60 FPS");
+    }
+
+    {
+        // Sleeps waking up later than the largest margin, frames may run late but never early
+        FakeClock fakeClock;
+        fakeClock.oversleep = 6000;
+        FramePacer pacer{fakeClock};
+        pacer.GetSettings().targetFps = 100;
+        pacer.WaitForNextFrame(false);
+        const auto [shortest, longest] = runFrames(pacer, fakeClock, 20, 1.0, false);
+        test.Check(shortest >= 10.0f, "frames never end early");
+        test.Check(pacer.GetSpinMargin() == FramePacer::MAX_SPIN_SECONDS, "the spin margin is capped");
+
+        // Slower than the target, nothing to wait for
+        runFrames(pacer, fakeClock, 10, 15.0, false);
+        test.Check(pacer.GetStats().sleepMs == 0 && pacer.GetStats().spinMs == 0, "slow frames don't wait");
+    }
+
+    {
+        // Uncapped, the statistics see the frames as they are
+        FakeClock fakeClock;
+        FramePacer pacer{fakeClock};
+        pacer.WaitForNextFrame(false);
+        for (int ms = 1; ms <= 100; ++ms)
+            runFrames(pacer, fakeClock, 1, ms, false);
+        const FramePacer::Stats& frameStats = pacer.GetStats();
+        test.Check(isNear(frameStats.p50Ms, 50) && isNear(frameStats.p95Ms, 95) && isNear(frameStats.p99Ms, 99) && isNear(frameStats.maxMs, 100), "nearest rank percentiles");
+        test.Check(frameStats.totalFrameCount == 100, "every frame is recorded");
+    }
+
+    {
+        FakeClock fakeClock;
+        FramePacer pacer{fakeClock};
+        pacer.WaitForNextFrame(false);
+        runFrames(pacer, fakeClock, 300, 5.0, false);
+        runFrames(pacer, fakeClock, 1, 20.0, false);
+        const FramePacer::Stats& frameStats = pacer.GetStats();
+        test.Check(frameStats.hitchCount == 1 && frameStats.totalHitchCount == 1 && isNear(frameStats.maxMs, 20), "one hitch four times the median");
+        test.Check(isNear(frameStats.p99Ms, 5), "a single hitch stays out of the 99th percentile");
+
+        // Leaves the history
+        runFrames(pacer, fakeClock, static_cast<int>(FramePacer::HISTORY_SIZE), 5.0, false);
+        test.Check(pacer.GetStats().hitchCount == 0 && pacer.GetStats().totalHitchCount == 1, "hitches leave the rolling window");
+    }
+}
+
+}
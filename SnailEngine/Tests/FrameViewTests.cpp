@@ -0,0 +1,52 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <cmath>
+
+#include "Rendering/FrameView.h"
+#include "Rendering/Occlusion/OccluderMesh.h"
+
+namespace Snail
+{
+
+// Checks the extracted matrices against the ones the camera computes
+void TestFrameView(TestContext& test)
+{
+    constexpr float EPSILON = 1e-3f;
+
+    const auto isIdentity = [](const Matrix& m)
+    {
+        const float* values = &m._11;
+        const float* identity = &Matrix::Identity._11;
+        for (size_t i = 0; i < 16; ++i)
+        {
+            if (std::abs(values[i] - identity[i]) > EPSILON)
+                return false;
+        }
+        return true;
+    };
+
+    Transform transform;
+    transform.position = Vector3{12, 3, -40};
+    transform.rotation = Quaternion::CreateFromYawPitchRoll(0.7f, -0.2f, 0.1f);
+    // Reversed depth like the cameras
+    const Matrix projection = Matrix::CreatePerspectiveFieldOfView(DirectX::XM_PIDIV4, 16.0f / 9.0f, 1000.0f, 0.1f);
+    const FrameView::CameraView view = FrameView::CameraView::Create(transform, projection, 0.1f, 1000.0f, true);
+
+    test.Check(isIdentity(view.view * view.invView), "view times its inverse isn't the identity");
+    test.Check(isIdentity(view.projection * view.invProjection), "projection times its inverse isn't the identity");
+    test.Check(isIdentity(view.viewProjection * view.invViewProjection), "view projection times its inverse isn't the identity");
+    test.Check(Vector3::Distance(Vector3::Transform(Vector3::Zero, view.invView), transform.position) < EPSILON, "the inverse view doesn't move the origin to the camera");
+
+    const Vector3 inFront = Vector3::Transform(transform.position + view.forward * 10.0f, view.viewProjection);
+    test.Check(std::abs(inFront.x) < EPSILON && std::abs(inFront.y) < EPSILON, "a point straight ahead isn't projected at the center");
+    test.Check(inFront.z > 0 && inFront.z < 1, "a point straight ahead isn't between the planes");
+
+    FrameArena arena;
+    FrameView frameView{arena};
+    frameView.AddOccluder(OccluderMesh::GetUnitBox(), Matrix::Identity);
+    frameView.AddOccluder(OccluderMesh{}, Matrix::Identity);
+    test.Check(frameView.occluders.size() == 1, "empty occluders are extracted");
+}
+
+}
@@ -0,0 +1,114 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Rendering/GBufferPacking.h"
+
+namespace Snail
+{
+
+// Round trips random normals, colors, exponents and flags through the targets of every precision
+void TestGBufferPacking(TestContext& test)
+{
+    struct Bounds
+    {
+        float normalDegrees;
+        float albedo;
+        // Relative to 1 + exponent
+        float specularExponent;
+        float emission;
+    };
+    // Measured with the rounding of the GPU conversions, with some margin
+    constexpr Bounds BOUNDS[] = {
+        {0.01f, 0.005f, 0.02f, 0.016f},
+        {0.01f, 1e-5f, 1e-4f, 0.001f},
+    };
+
+    constexpr size_t SAMPLE_COUNT = 100000;
+    std::mt19937 rng{17};
+    std::normal_distribution<float> gaussian;
+    std::uniform_real_distribution unitRange{0.0f, 1.0f};
+    std::uniform_real_distribution exponentRange{0.0f, 2048.0f};
+    // Over a few powers of two, away from the denormals
+    std::uniform_real_distribution emissionExponentRange{-6.0f, 4.0f};
+
+    const auto angleDegrees = [](const Vector3& a, const Vector3& b)
+    {
+        // atan2 keeps its precision for tiny angles where acos of the dot doesn't
+        return DirectX::XMConvertToDegrees(std::atan2(a.Cross(b).Length(), a.Dot(b)));
+    };
+
+    std::vector<Vector3> normals(SAMPLE_COUNT);
+    for (Vector3& n : normals)
+    {
+        n = {gaussian(rng), gaussian(rng), gaussian(rng)};
+        n.Normalize();
+    }
+
+    // The unpacked layout, as a reference
+    float legacyNormalError = 0;
+    for (const Vector3& n : normals)
+    {
+        const Vector3 stored = n * 0.5f + Vector3{0.5f, 0.5f, 0.5f};
+        Vector3 decoded = Vector3{
+            GBufferPacking::Quantize(stored.x, DXGI_FORMAT_R11G11B10_FLOAT, 0),
+            GBufferPacking::Quantize(stored.y, DXGI_FORMAT_R11G11B10_FLOAT, 1),
+            GBufferPacking::Quantize(stored.z, DXGI_FORMAT_R11G11B10_FLOAT, 2)} * 2 - Vector3::One;
+        decoded.Normalize();
+        legacyNormalError = std::max(legacyNormalError, angleDegrees(n, decoded));
+    }
+    test.Report("G-buffer legacy, {} bytes per pixel: normal {:.4f} deg", GBufferPacking::LEGACY_BYTES_PER_PIXEL, legacyNormalError);
+
+    test.Check(GBufferPacking::UnpackSpecularExponent(GBufferPacking::PackSpecularExponent(0)) == 0, "a null specular exponent stays null");
+    test.Check(GBufferPacking::GetBytesPerPixel(GBufferPrecision::COMPACT) < GBufferPacking::LEGACY_BYTES_PER_PIXEL, "compact layout is smaller than the legacy one");
+
+    for (const GBufferPrecision precision : {GBufferPrecision::COMPACT, GBufferPrecision::HIGH})
+    {
+        const Bounds& bounds = BOUNDS[static_cast<int>(precision)];
+        const DXGI_FORMAT normalFormat = GBufferPacking::GetFormat(GBufferTarget::NORMAL, precision);
+        const DXGI_FORMAT albedoFormat = GBufferPacking::GetFormat(GBufferTarget::ALBEDO, precision);
+        const DXGI_FORMAT materialFormat = GBufferPacking::GetFormat(GBufferTarget::MATERIAL, precision);
+        const DXGI_FORMAT emissionFormat = GBufferPacking::GetFormat(GBufferTarget::EMISSION, precision);
+
+        float maxNormalError = 0, maxAlbedoError = 0, maxExponentError = 0, maxEmissionError = 0;
+        for (size_t i = 0; i < SAMPLE_COUNT; ++i)
+        {
+            const Vector2 packedNormal = GBufferPacking::PackNormal(normals[i]);
+            const Vector3 normal = GBufferPacking::UnpackNormal({GBufferPacking::Quantize(packedNormal.x, normalFormat, 0), GBufferPacking::Quantize(packedNormal.y, normalFormat, 1)});
+            maxNormalError = std::max(maxNormalError, angleDegrees(normals[i], normal));
+
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                const float albedo = unitRange(rng);
+                maxAlbedoError = std::max(maxAlbedoError, std::abs(GBufferPacking::Quantize(albedo, albedoFormat, channel) - albedo));
+
+                const float emission = std::exp2(emissionExponentRange(rng));
+                maxEmissionError = std::max(maxEmissionError, std::abs(GBufferPacking::Quantize(emission, emissionFormat, channel) - emission) / emission);
+            }
+
+            const float exponent = exponentRange(rng);
+            const float unpackedExponent = GBufferPacking::UnpackSpecularExponent(GBufferPacking::Quantize(GBufferPacking::PackSpecularExponent(exponent), materialFormat, 3));
+            maxExponentError = std::max(maxExponentError, std::abs(unpackedExponent - exponent) / (1 + exponent));
+        }
+
+        bool flagsKept = true;
+        for (uint32_t flags = 0; flags <= GBufferPacking::MAX_FLAGS; ++flags)
+            flagsKept &= GBufferPacking::UnpackFlags(GBufferPacking::Quantize(GBufferPacking::PackFlags(flags), albedoFormat, 3)) == flags;
+
+        test.Check(maxNormalError <= bounds.normalDegrees, "normal angular error");
+        test.Check(maxNormalError < legacyNormalError, "normals are more precise than in the legacy layout");
+        test.Check(maxAlbedoError <= bounds.albedo, "albedo error");
+        test.Check(maxExponentError <= bounds.specularExponent, "specular exponent error");
+        test.Check(maxEmissionError <= bounds.emission, "emission error");
+        test.Check(flagsKept, "flags");
+
+        test.Report("G-buffer {}, {} bytes per pixel: normal {:.4f} deg, albedo {:.2e}, specular exponent {:.2f}%, emission {:.2f}%",
+            GBufferPacking::GetPrecisionName(precision), GBufferPacking::GetBytesPerPixel(precision), maxNormalError, maxAlbedoError, maxExponentError * 100, maxEmissionError * 100);
+    }
+}
+
+}
@@ -0,0 +1,123 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <vector>
+
+#include "Entities/GrassRegionCulling.h"
+
+namespace Snail
+{
+
+// Checks the region culling against a per blade brute force
+void TestGrassRegionCulling(TestContext& test)
+{
+    constexpr std::array<uint32_t, 2> REGION_COUNT = {24, 16};
+    constexpr float DENSITY = 0.7f;
+    const uint32_t bladesPerRow = REGION_COUNT[0] * GrassRegionCulling::REGION_SIZE;
+    const uint32_t bladeCount = bladesPerRow * REGION_COUNT[1] * GrassRegionCulling::REGION_SIZE;
+
+    // Every blade stays inside the bounds of its region
+    {
+        bool isInside = true;
+        for (uint32_t regionIndex = 0; regionIndex < REGION_COUNT[0] * REGION_COUNT[1]; ++regionIndex)
+        {
+            const DirectX::BoundingBox bounds = GrassRegionCulling::GetRegionBounds(regionIndex % REGION_COUNT[0], regionIndex / REGION_COUNT[0], DENSITY);
+            for (uint32_t i = 0; i < GrassRegionCulling::BLADES_PER_REGION; ++i)
+            {
+                const uint32_t bladeIndex = GrassRegionCulling::GetBladeIndex(regionIndex, i, REGION_COUNT);
+                const GrassRegionCulling::Blade blade = GrassRegionCulling::PlaceBlade(bladeIndex % bladesPerRow, bladeIndex / bladesPerRow, DENSITY);
+                const DirectX::BoundingBox bladeBounds = GrassRegionCulling::GetBladeBounds(blade);
+                // Tallest blades reach the top of the bounds, allow for rounding
+                const Vector3 boundsMin = Vector3(bounds.Center) - bounds.Extents - Vector3(1e-4f);
+                const Vector3 boundsMax = Vector3(bounds.Center) + bounds.Extents + Vector3(1e-4f);
+                const Vector3 bladeMin = Vector3(bladeBounds.Center) - bladeBounds.Extents;
+                const Vector3 bladeMax = Vector3(bladeBounds.Center) + bladeBounds.Extents;
+                isInside &= bladeMin.x >= boundsMin.x && bladeMin.y >= boundsMin.y && bladeMin.z >= boundsMin.z;
+                isInside &= bladeMax.x <= boundsMax.x && bladeMax.y <= boundsMax.y && bladeMax.z <= boundsMax.z;
+            }
+        }
+        test.Check(isInside, "blades stay inside their region bounds");
+    }
+
+    // Rotated and scaled patch seen from behind one of its corners, looking across it
+    const Matrix patchWorld = Matrix::CreateScale(1.5f, 1.0f, 1.5f) * Matrix::CreateRotationY(0.6f) * Matrix::CreateTranslation(-40, 3, 25);
+    const Vector3 viewPosition(-50, 12, 20);
+    const DirectX::BoundingFrustum viewFrustum(Matrix::CreatePerspectiveFieldOfView(DirectX::XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f), true);
+    DirectX::BoundingFrustum frustum;
+    viewFrustum.Transform(frustum, 1.0f, Quaternion::CreateFromYawPitchRoll(-1.5f, -0.2f, 0), viewPosition);
+    const auto isCulled = [&frustum](const DirectX::BoundingBox& bounds) { return !frustum.Intersects(bounds); };
+
+    GrassRegionCulling::LodSettings settings;
+    settings.fullDetailDistance = 30;
+    settings.thinningStartDistance = 60;
+    settings.maxDistance = 150;
+
+    std::vector<GrassRegionCulling::RegionDraw> regions;
+    GrassRegionCulling::SelectRegions(REGION_COUNT, DENSITY, patchWorld, viewPosition, settings, isCulled, regions);
+    test.Check(!regions.empty() && regions.size() < REGION_COUNT[0] * REGION_COUNT[1], "some regions are culled, some are kept");
+
+    std::vector<const GrassRegionCulling::RegionDraw*> regionOfBlade(bladeCount, nullptr);
+    for (const GrassRegionCulling::RegionDraw& region : regions)
+    {
+        for (uint32_t i = 0; i < GrassRegionCulling::BLADES_PER_REGION; ++i)
+            regionOfBlade[GrassRegionCulling::GetBladeIndex(region.regionIndex, i, REGION_COUNT)] = &region;
+    }
+
+    // No blade that a per blade test sees is dropped with its region, and lods follow the region distances
+    std::array<size_t, GrassRegionCulling::LOD_COUNT> expectedCounts{};
+    bool hasFalseNegative = false;
+    bool hasWrongLod = false;
+    for (uint32_t bladeIndex = 0; bladeIndex < bladeCount; ++bladeIndex)
+    {
+        const GrassRegionCulling::Blade blade = GrassRegionCulling::PlaceBlade(bladeIndex % bladesPerRow, bladeIndex / bladesPerRow, DENSITY);
+        DirectX::BoundingBox bladeBounds;
+        GrassRegionCulling::GetBladeBounds(blade).Transform(bladeBounds, patchWorld);
+
+        const float distance = GrassRegionCulling::GetClosestDistance(bladeBounds, viewPosition);
+        const GrassRegionCulling::RegionDraw* region = regionOfBlade[bladeIndex];
+        if (distance <= settings.maxDistance && !isCulled(bladeBounds) && !region)
+            hasFalseNegative = true;
+
+        if (!region)
+            continue;
+
+        if (region->lod == 1 && distance < settings.fullDetailDistance)
+            hasWrongLod = true;
+
+        if (GrassRegionCulling::GetThinningValue(bladeIndex) < region->keepFraction)
+            ++expectedCounts[region->lod];
+    }
+    test.Check(!hasFalseNegative, "no visible blade is culled by its region");
+    test.Check(!hasWrongLod, "blades closer than the full detail distance use the full blade");
+
+    // Compaction writes every kept blade once, in the list of its region's lod
+    std::array<std::vector<uint32_t>, GrassRegionCulling::LOD_COUNT> visibleBlades;
+    GrassRegionCulling::CompactBlades(REGION_COUNT, DENSITY, regions, visibleBlades);
+    std::vector<bool> isWritten(bladeCount, false);
+    bool isUnique = true;
+    bool isInRightList = true;
+    for (uint32_t lod = 0; lod < GrassRegionCulling::LOD_COUNT; ++lod)
+    {
+        test.Check(visibleBlades[lod].size() == expectedCounts[lod], "compacted blade counts match the brute force");
+        for (const uint32_t bladeIndex : visibleBlades[lod])
+        {
+            isUnique &= !isWritten[bladeIndex];
+            isWritten[bladeIndex] = true;
+            isInRightList &= regionOfBlade[bladeIndex] && regionOfBlade[bladeIndex]->lod == lod;
+        }
+    }
+    test.Check(isUnique, "compacted blades are unique");
+    test.Check(isInRightList, "compacted blades are in the list of their lod");
+
+    // Thinning keeps the requested fraction of the blades
+    {
+        constexpr uint32_t SAMPLE_COUNT = 1 << 16;
+        constexpr float KEEP_FRACTION = 0.3f;
+        uint32_t keptCount = 0;
+        for (uint32_t i = 0; i < SAMPLE_COUNT; ++i)
+            keptCount += GrassRegionCulling::GetThinningValue(i) < KEEP_FRACTION;
+        test.Check(std::abs(static_cast<float>(keptCount) / SAMPLE_COUNT - KEEP_FRACTION) < 0.01f, "thinning keeps the requested fraction");
+    }
+}
+
+}
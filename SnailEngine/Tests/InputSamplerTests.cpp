@@ -0,0 +1,111 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "Core/Input/Controller.h"
+#include "Core/Input/ControllerSource.h"
+
+namespace Snail
+{
+
+// Drives a manager from a scripted source, checks that no change is lost and that empty slots back off
+void TestInputSampler(TestContext& test)
+{
+    constexpr int TAP_COUNT = 100;
+    // Polls of the late slot before it is plugged in
+    constexpr size_t LATE_SLOT_EMPTY_POLLS = 20;
+    constexpr std::chrono::seconds TIMEOUT{10};
+
+    // Slot 0 taps A once per sample, much faster than the frames. Slot 1 is plugged in late with B held, the others
+    // stay empty.
+    XINPUT_GAMEPAD aDown{};
+    aDown.wButtons = XINPUT_GAMEPAD_A;
+    XINPUT_GAMEPAD bDown{};
+    bDown.wButtons = XINPUT_GAMEPAD_B;
+
+    std::vector<std::optional<XINPUT_GAMEPAD>> taps{XINPUT_GAMEPAD{}};
+    for (int i = 0; i < TAP_COUNT; ++i)
+    {
+        taps.emplace_back(aDown);
+        taps.emplace_back(XINPUT_GAMEPAD{});
+    }
+    std::vector<std::optional<XINPUT_GAMEPAD>> late(LATE_SLOT_EMPTY_POLLS);
+    late.emplace_back(bDown);
+
+    auto source = std::make_unique<ScriptedControllerSource>();
+    ScriptedControllerSource& script = *source;
+    script.SetScript(0, std::move(taps));
+    script.SetScript(1, std::move(late));
+
+    InputSampler::Settings settings;
+    settings.sampleInterval = std::chrono::microseconds{200};
+    settings.minProbeInterval = std::chrono::milliseconds{1};
+    settings.maxProbeInterval = std::chrono::milliseconds{16};
+
+    ControllerManager manager;
+    manager.StartSampling(std::move(source), settings);
+
+    // Frames of a few milliseconds, each one sees several taps
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> frameMs{1, 4};
+    int pressCount = 0;
+    int releaseCount = 0;
+    bool lateSlotHeld = false;
+    const auto start = std::chrono::steady_clock::now();
+    const auto isDone = [&] { return pressCount >= TAP_COUNT && releaseCount >= TAP_COUNT && lateSlotHeld; };
+    while (!isDone() && std::chrono::steady_clock::now() - start < TIMEOUT)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{frameMs(rng)});
+        manager.Update();
+
+        // Slot 0 is connected from the first sample, so the late slot is the second active controller
+        if (const Controller* controller = manager.GetController(0))
+        {
+            pressCount += controller->GetPressCount(Controller::Buttons::A);
+            releaseCount += controller->GetReleaseCount(Controller::Buttons::A);
+        }
+        if (const Controller* controller = manager.GetController(1))
+            lateSlotHeld = controller->IsDown(Controller::Buttons::B);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const InputSampler::Stats stats = manager.GetSampler()->GetStats();
+    const size_t emptySlotProbes = std::max(script.GetPollCount(2), script.GetPollCount(3));
+    // Destroys the script
+    manager.StopSampling();
+
+    test.Check(stats.fullCount == 0, "the ring filled up");
+    test.Check(pressCount == TAP_COUNT, "a press was lost");
+    test.Check(releaseCount == TAP_COUNT, "a release was lost");
+    test.Check(lateSlotHeld, "the late controller wasn't connected");
+    // Doubling from 1 ms, the empty slots reach one probe every 16 ms after 5 probes
+    const auto maxProbes = 6 + static_cast<size_t>(elapsed / settings.maxProbeInterval);
+    test.Check(emptySlotProbes <= maxProbes, "the empty slots didn't back off");
+
+    test.Report("{} presses, {} releases, {} samples, {} probes of empty slots", pressCount, releaseCount, stats.sampleCount, stats.probeCount);
+}
+
+// Main thread cost of polling every slot like before the sampler
+void BenchmarkControllerPolling(TestContext& test)
+{
+    constexpr int REPEAT_COUNT = 20;
+
+    XInputControllerSource source;
+    const auto start = TestClock::now();
+    for (int i = 0; i < REPEAT_COUNT; ++i)
+    {
+        for (int slot = 0; slot < XUSER_MAX_COUNT; ++slot)
+            std::ignore = source.GetState(slot);
+    }
+    const float pollUs = std::chrono::duration<float, std::micro>(TestClock::now() - start).count() / REPEAT_COUNT;
+    test.Report("{:.1f} us per frame", pollUs);
+}
+
+}
@@ -0,0 +1,79 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "Core/LevelArchive.h"
+#include "Core/Scene.h"
+#include "Core/SceneParser.h"
+
+namespace Snail
+{
+
+// Compares reading the default scene description from the JSON and from the archive, without building the scene.
+// Reads the scene of the game, run from the directory of its resources.
+void BenchmarkLevelArchive(TestContext& test)
+{
+    constexpr size_t ITERATION_COUNT = 10;
+
+    const std::filesystem::path sourcePath = Scene::DEFAULT_SCENE_PATH;
+    if (!test.Check(std::filesystem::exists(sourcePath), "the default scene is found from the working directory"))
+        return;
+
+    const auto cookStart = TestClock::now();
+    if (!test.Check(LevelArchive::Cook(sourcePath), "the scene is cooked"))
+        return;
+    const float cookMs = ElapsedMs(cookStart);
+
+    std::error_code error;
+    const size_t sourceBytes = std::filesystem::file_size(sourcePath, error);
+    const size_t archiveBytes = std::filesystem::file_size(LevelArchive::GetArchivePath(sourcePath), error);
+
+    // Both read everything the scene is built from: the settings, the entity types and params, the mesh descriptions
+    size_t entityCount = 0;
+    const auto jsonStart = TestClock::now();
+    for (size_t i = 0; i < ITERATION_COUNT; ++i)
+    {
+        std::ifstream file{sourcePath};
+        const nlohmann::json sceneJson = nlohmann::json::parse(file, nullptr, true, true);
+        [[maybe_unused]] const SceneSettings settings = SceneParser::ReadSettings(sceneJson);
+        for (const nlohmann::json& mesh : sceneJson.at("meshes"))
+            [[maybe_unused]] const size_t hash = SceneParser::HashMeshDescription(mesh);
+
+        entityCount = 0;
+        for (const nlohmann::json& object : sceneJson.at("objects"))
+            entityCount += SceneParser::GetEntityType(object.at("type").get<std::string>()).has_value();
+    }
+    const float jsonLoadMs = ElapsedMs(jsonStart) / static_cast<float>(ITERATION_COUNT);
+
+    size_t archiveEntityCount = 0;
+    const auto archiveStart = TestClock::now();
+    for (size_t i = 0; i < ITERATION_COUNT; ++i)
+    {
+        const LevelArchive archive{LevelArchive::GetArchivePath(sourcePath)};
+        if (!test.Check(archive.IsUpToDate(sourcePath), "the cooked archive is up to date"))
+            return;
+
+        [[maybe_unused]] const LevelArchive::CookedSettings& settings = archive.GetSettings();
+        for (const LevelArchive::CookedMesh& mesh : archive.GetSection<LevelArchive::CookedMesh>(LevelArchive::Section::MESHES))
+            [[maybe_unused]] const nlohmann::json description = archive.GetParams(mesh.description);
+
+        const auto entities = archive.GetSection<LevelArchive::CookedEntity>(LevelArchive::Section::ENTITIES);
+        for (const LevelArchive::CookedEntity& entity : entities)
+        {
+            if (entity.description != LevelArchive::CookedEntity::NO_DESCRIPTION)
+                [[maybe_unused]] const Entity::Description description = archive.GetDescription(entity.description);
+            else
+                [[maybe_unused]] const nlohmann::json params = archive.GetParams(entity.params);
+        }
+        archiveEntityCount = entities.size();
+    }
+    const float archiveLoadMs = ElapsedMs(archiveStart) / static_cast<float>(ITERATION_COUNT);
+
+    test.Check(archiveEntityCount == entityCount, "the archive holds every entity of the JSON");
+    test.Report("Level archive of {}: {} entities, JSON {} bytes read in {:.3f} ms, archive {} bytes read in {:.3f} ms, cooked in {:.3f} ms",
+        sourcePath.string(), entityCount, sourceBytes, jsonLoadMs, archiveBytes, archiveLoadMs, cookMs);
+}
+
+}
@@ -0,0 +1,181 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "Rendering/Lights/LightManager.h"
+
+namespace Snail
+{
+
+// Ranks thousands of lights, checks the budget, the fades, the handles and the uploaded ranges
+void TestLightManager(TestContext& test)
+{
+    {
+        // A grid of 64 by 64 lights around the camera, the ones on its left are out of view and every tenth is off
+        LightManager manager;
+        manager.GetSettings().fadeSeconds = 0;
+        std::vector<LightHandle> handles;
+        for (int i = 0; i < 64 * 64; ++i)
+        {
+            const float brightness = 0.2f + 0.8f * static_cast<float>(i * 37 % 101) / 100.0f;
+            const Vector3 position{static_cast<float>(i % 64 - 32) * 4.0f, 2.0f, static_cast<float>(i / 64 - 32) * 4.0f};
+            handles.push_back(manager.AddPointLight({position, Vector3{brightness, brightness * 0.5f, 0.1f}, {1, 0.045f, 0.0075f}, i % 10 != 0}));
+        }
+        const LightView view{{0, 2, 0}, 2.4f, [](const Vector3& center, const float radius) { return center.x + radius > 0; }};
+        manager.Update(view, 1.0f / 60.0f);
+
+        const LightManager::Stats& managerStats = manager.GetStats();
+        const uint32_t budget = manager.GetSettings().pointBudget;
+        test.Check(managerStats.lightCount == handles.size() && managerStats.selectedCount == budget, "the budget is filled");
+        test.Check(manager.GetSlotCount(LightType::POINT) == budget, "the selected lights are packed at the start of the buffer");
+
+        float lowestSelected = std::numeric_limits<float>::max();
+        float highestUnselected = 0;
+        bool selectsHidden = false;
+        for (size_t i = 0; i < handles.size(); ++i)
+        {
+            const PointLight light = manager.GetPointLight(handles[i]);
+            const bool isSelected = manager.GetFade(handles[i]) > 0;
+            if (isSelected)
+                lowestSelected = std::min(lowestSelected, manager.GetImportance(handles[i]));
+            else
+                highestUnselected = std::max(highestUnselected, manager.GetImportance(handles[i]));
+            selectsHidden |= isSelected && (!light.isActive || manager.GetImportance(handles[i]) == 0);
+        }
+        test.Check(lowestSelected >= highestUnselected, "the most important lights are selected");
+        test.Check(!selectsHidden, "lights off or out of view are never selected");
+
+        LightManager::DirtyRange range = manager.TakeDirtyRange(LightType::POINT);
+        test.Check(range.first == 0 && range.count == budget && managerStats.uploadedBytes == budget * sizeof(GpuPointLight), "the first update uploads the selected lights");
+        test.Check(managerStats.uploadedBytes < managerStats.fullUploadBytes / 50, "far fewer bytes than every light");
+
+        manager.Update(view, 1.0f / 60.0f);
+        range = manager.TakeDirtyRange(LightType::POINT);
+        test.Check(range.count == 0 && manager.GetStats().uploadedBytes == 0, "nothing is uploaded when nothing changed");
+
+        // Moving a selected light a little rewrites its slot only
+        const auto selected = std::ranges::find_if(handles, [&manager](const LightHandle handle) { return manager.GetFade(handle) > 0; });
+        const Vector3 moved = manager.GetPointLight(*selected).Position + Vector3{0, 0.01f, 0};
+        manager.SetPosition(*selected, moved);
+        manager.Update(view, 1.0f / 60.0f);
+        range = manager.TakeDirtyRange(LightType::POINT);
+        test.Check(range.count == 1 && manager.GetGpuPointLights()[range.first].position == moved, "a moved light uploads its slot only");
+
+        // Moving an unselected light uploads nothing
+        const auto unselected = std::ranges::find_if(handles, [&manager](const LightHandle handle) { return manager.GetFade(handle) == 0; });
+        manager.SetPosition(*unselected, manager.GetPointLight(*unselected).Position + Vector3{0, 0.01f, 0});
+        manager.Update(view, 1.0f / 60.0f);
+        test.Check(manager.TakeDirtyRange(LightType::POINT).count == 0, "a moved light out of the budget uploads nothing");
+
+        // The last light fills the hole, handles keep pointing at their light
+        const LightHandle removed = *selected;
+        const Vector3 lastPosition = manager.GetPointLight(handles.back()).Position;
+        manager.Remove(removed);
+        test.Check(!manager.IsAlive(removed) && manager.GetCount(LightType::POINT) == handles.size() - 1, "a removed light is gone");
+        test.Check(manager.GetPointLight(handles.back()).Position == lastPosition, "the moved light keeps its handle");
+        const LightHandle added = manager.AddPointLight({});
+        test.Check(added.index == removed.index && added.generation != removed.generation && !manager.IsAlive(removed), "reused handle indices don't revive old handles");
+        manager.Update(view, 1.0f / 60.0f);
+        test.Check(manager.GetStats().selectedCount == budget, "the budget is refilled after a removal");
+
+        manager.GetSettings().pointBudget = 10000;
+        manager.Update(view, 1.0f / 60.0f);
+        test.Check(manager.GetSlotCount(LightType::POINT) == MAX_GPU_POINT_LIGHTS, "the budget is capped by the buffer");
+
+        manager.Clear();
+        test.Check(manager.GetCount(LightType::POINT) == 0 && !manager.IsAlive(handles.front()) && !manager.IsAlive(added), "clearing invalidates every handle");
+        manager.Update(view, 1.0f / 60.0f);
+        test.Check(manager.GetSlotCount(LightType::POINT) == 0, "cleared lights leave the buffer");
+    }
+
+    {
+        // One slot of budget, a dimmer light taking over fades in while the other fades out
+        LightManager manager;
+        manager.GetSettings().fadeSeconds = 1.0f;
+        manager.GetSettings().spotBudget = 1;
+        SpotLight first;
+        first.Position = {0, 0, -5};
+        SpotLight second = first;
+        second.Color = {0.5f, 0.5f, 0.5f};
+        const LightHandle firstHandle = manager.AddSpotLight(first);
+        const LightHandle secondHandle = manager.AddSpotLight(second);
+        const LightView view{{0, 0, 0}, 2.4f, {}};
+
+        manager.Update(view, 0.25f);
+        test.Check(manager.GetFade(firstHandle) == 0.25f && manager.GetFade(secondHandle) == 0, "the brightest light fades in");
+        test.Check(manager.GetGpuSpotLights()[0].color == first.Color * 0.25f, "the fade scales the uploaded color");
+        manager.Update(view, 0.25f);
+
+        first.Color = {0.2f, 0.2f, 0.2f};
+        manager.SetSpotLight(firstHandle, first);
+        manager.Update(view, 0.25f);
+        test.Check(manager.GetFade(secondHandle) == 0.25f && manager.GetFade(firstHandle) == 0.25f, "the lights cross fade");
+        test.Check(manager.GetSlotCount(LightType::SPOT) == 2 && manager.GetStats().fadingCount == 1, "the faded out light keeps its slot meanwhile");
+
+        manager.Update(view, 0.25f);
+        test.Check(manager.GetFade(firstHandle) == 0 && manager.GetGpuSpotLights()[0].isActive == 0, "the faded out light leaves its slot");
+        manager.Update(view, 0.5f);
+        test.Check(manager.GetFade(secondHandle) == 1.0f, "the faded in light is at full intensity");
+    }
+}
+
+// Updates thousands of lights, a tenth of them moving every frame, in front of a moving camera
+void BenchmarkLightManager(TestContext& test)
+{
+    constexpr size_t LIGHT_COUNT = 10000;
+    constexpr int FRAME_COUNT = 240;
+    constexpr float DT = 1.0f / 60.0f;
+
+    std::mt19937 generator{48};
+    std::uniform_real_distribution position{-200.0f, 200.0f};
+    std::uniform_real_distribution brightness{0.1f, 1.0f};
+
+    LightManager manager;
+    std::vector<LightHandle> handles;
+    for (size_t i = 0; i < LIGHT_COUNT; ++i)
+    {
+        const float value = brightness(generator);
+        handles.push_back(manager.AddPointLight({Vector3{position(generator), 2.0f, position(generator)}, Vector3{value, value, value}, {1, 0.045f, 0.0075f}, true}));
+    }
+    for (size_t i = 0; i < LIGHT_COUNT / 8; ++i)
+        manager.AddSpotLight({Vector3{position(generator), 5.0f, position(generator)}});
+
+    size_t uploadedBytes = 0;
+    float updateMs = 0;
+    for (int frame = 0; frame < FRAME_COUNT; ++frame)
+    {
+        // A tenth of the lights move, fireflies around their particle
+        for (size_t i = static_cast<size_t>(frame) % 10; i < handles.size(); i += 10)
+        {
+            const Vector3 base = manager.GetPointLight(handles[i]).Position;
+            manager.SetPosition(handles[i], base + Vector3{std::sin(static_cast<float>(frame) * DT) * 0.05f, 0, 0});
+        }
+
+        // Facing down +z while moving along it
+        const Vector3 camera{0, 2, static_cast<float>(frame) * 0.5f - 60.0f};
+        const LightView view{camera, 2.4f, [&camera](const Vector3& center, const float radius) { return center.z + radius > camera.z; }};
+
+        const auto start = TestClock::now();
+        manager.Update(view, DT);
+        updateMs += ElapsedMs(start);
+
+        manager.TakeDirtyRange(LightType::POINT);
+        manager.TakeDirtyRange(LightType::SPOT);
+        uploadedBytes += manager.GetStats().uploadedBytes;
+    }
+
+    test.Check(uploadedBytes < manager.GetStats().fullUploadBytes * static_cast<size_t>(FRAME_COUNT), "moving lights upload less than every light");
+    test.Report("{} lights, update {:.3f} ms, {:.0f} bytes uploaded per frame instead of {}",
+        manager.GetCount(LightType::POINT) + manager.GetCount(LightType::SPOT),
+        updateMs / FRAME_COUNT,
+        static_cast<float>(uploadedBytes) / FRAME_COUNT,
+        manager.GetStats().fullUploadBytes);
+}
+
+}
@@ -0,0 +1,93 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <string>
+#include <vector>
+
+#include "TestEngine.h"
+#include "Core/WindowsEngine.h"
+
+namespace Snail
+{
+
+// Resolves what a draw binds, the mesh of every entity and the textures of every submesh, through handles and through
+// the legacy name lookups, in the level
+void BenchmarkMaterialBinding(TestContext& test)
+{
+    constexpr int ITERATIONS = 1000;
+
+    WindowsEngine* engine = GetTestEngine(test);
+    if (!engine || !LoadTestScene(test, *engine, TEST_LEVEL_PATH))
+        return;
+
+    MeshManager& meshManager = WindowsEngine::GetModule<MeshManager>();
+    TextureManager& textureManager = WindowsEngine::GetModule<TextureManager>();
+
+    // Gathered up front so that only the lookups are timed
+    std::vector<MeshHandle> meshHandles;
+    std::vector<std::string> meshNames;
+    for (const Entity* entity : WindowsEngine::GetScene()->GetEntities())
+    {
+        if (const MeshHandle handle = entity->GetMeshHandle(); handle.IsValid())
+        {
+            meshHandles.push_back(handle);
+            meshNames.push_back(meshManager.GetAssetName(handle));
+        }
+    }
+
+    std::vector<const TexturedMaterial*> materials;
+    std::vector<std::string> textureNames;
+    meshManager.ForEachAsset([&](const BaseMesh* mesh)
+    {
+        for (const SubMesh& submesh : mesh->submeshes)
+        {
+            materials.push_back(&submesh.GetMaterial());
+            for (const auto member : MATERIAL_TEXTURE_MEMBERS)
+                textureNames.push_back(textureManager.GetAssetName(submesh.GetMaterial().*member));
+        }
+    });
+
+    if (!test.Check(!meshHandles.empty() && !materials.empty(), "the level has no mesh to draw"))
+        return;
+
+    // Both lookups must find the same assets
+    bool sameMeshes = true;
+    for (size_t i = 0; i < meshHandles.size(); ++i)
+        sameMeshes &= meshManager.GetAsset(meshHandles[i]) == meshManager.GetAsset<BaseMesh>(meshNames[i]);
+    test.Check(sameMeshes, "a mesh handle doesn't resolve to the mesh of its name");
+
+    // Accumulate the pointers so the lookups cannot be optimized away
+    uintptr_t sink = 0;
+
+    auto start = TestClock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+        for (const MeshHandle handle : meshHandles)
+            sink ^= reinterpret_cast<uintptr_t>(meshManager.GetAsset(handle));
+    const float meshHandleMs = ElapsedMs(start);
+
+    start = TestClock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+        for (const std::string& name : meshNames)
+            sink ^= reinterpret_cast<uintptr_t>(meshManager.GetAsset<BaseMesh>(name));
+    const float meshNameMs = ElapsedMs(start);
+
+    start = TestClock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+        for (const TexturedMaterial* material : materials)
+            for (const auto member : MATERIAL_TEXTURE_MEMBERS)
+                sink ^= reinterpret_cast<uintptr_t>(textureManager.GetTexture2D(material->*member, GetDefaultTexture(member)));
+    const float textureHandleMs = ElapsedMs(start);
+
+    start = TestClock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+        for (const std::string& name : textureNames)
+            sink ^= reinterpret_cast<uintptr_t>(textureManager.GetAsset<Texture2D>(name));
+    const float textureNameMs = ElapsedMs(start);
+
+    const auto toNs = [](const float ms, const size_t count) { return ms * 1e6f / static_cast<float>(ITERATIONS * count); };
+    test.Report("Mesh per entity ({} entities): handle {:.1f} ns, name {:.1f} ns", meshHandles.size(), toNs(meshHandleMs, meshHandles.size()), toNs(meshNameMs, meshNames.size()));
+    test.Report("Textures per submesh ({} submeshes): handle {:.1f} ns, name {:.1f} ns ({})", materials.size(), toNs(textureHandleMs, materials.size()), toNs(textureNameMs, materials.size()), sink & 1);
+    test.Check(meshHandleMs < meshNameMs && textureHandleMs < textureNameMs, "resolving handles isn't faster than looking names up");
+}
+
+}
@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "Core/Mesh/MeshOptimizer.h"
+#include "Core/Mesh/SubMesh.h"
+
+namespace Snail
+{
+
+// Checks on generated meshes that the triangle set of every submesh is unchanged and that the cache got better
+void TestMeshOptimizer(TestContext& test)
+{
+    // A shuffled grid as one submesh and a shuffled sphere as another, like an OBJ exported in a poor order
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<SubMesh> submeshes(2);
+    std::mt19937 rng{7};
+
+    constexpr uint32_t GRID_SIZE = 64;
+    for (uint32_t y = 0; y <= GRID_SIZE; ++y)
+        for (uint32_t x = 0; x <= GRID_SIZE; ++x)
+            vertices.emplace_back(Vector3(static_cast<float>(x), 0, static_cast<float>(y)), Vector3::Up);
+
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (uint32_t y = 0; y < GRID_SIZE; ++y)
+    {
+        for (uint32_t x = 0; x < GRID_SIZE; ++x)
+        {
+            const uint32_t topLeft = x + y * (GRID_SIZE + 1);
+            const uint32_t bottomLeft = topLeft + GRID_SIZE + 1;
+            triangles.push_back({topLeft + 1, topLeft, bottomLeft});
+            triangles.push_back({topLeft + 1, bottomLeft, bottomLeft + 1});
+        }
+    }
+    std::ranges::shuffle(triangles, rng);
+    for (const auto& triangle : triangles)
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+    submeshes[0].indexBufferCount = static_cast<uint32_t>(indices.size());
+
+    constexpr uint32_t RINGS = 24;
+    constexpr uint32_t SEGMENTS = 32;
+    const auto sphereBase = static_cast<uint32_t>(vertices.size());
+    for (uint32_t ring = 0; ring <= RINGS; ++ring)
+    {
+        const float phi = DirectX::XM_PI * ring / RINGS;
+        for (uint32_t segment = 0; segment <= SEGMENTS; ++segment)
+        {
+            const float theta = DirectX::XM_2PI * segment / SEGMENTS;
+            const Vector3 position{std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta)};
+            vertices.emplace_back(position * 10.0f + Vector3(100, 0, 0), position);
+        }
+    }
+
+    triangles.clear();
+    for (uint32_t ring = 0; ring < RINGS; ++ring)
+    {
+        for (uint32_t segment = 0; segment < SEGMENTS; ++segment)
+        {
+            const uint32_t a = sphereBase + ring * (SEGMENTS + 1) + segment;
+            const uint32_t b = a + SEGMENTS + 1;
+            triangles.push_back({a, b, a + 1});
+            triangles.push_back({a + 1, b, b + 1});
+        }
+    }
+    std::ranges::shuffle(triangles, rng);
+    submeshes[1].indexBufferStartIndex = static_cast<uint32_t>(indices.size());
+    for (const auto& triangle : triangles)
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+    submeshes[1].indexBufferCount = static_cast<uint32_t>(indices.size()) - submeshes[1].indexBufferStartIndex;
+
+    // Triangles compared by their positions since vertices get renumbered, rotated to a canonical start to keep the winding
+    using TrianglePositions = std::array<float, 9>;
+    const auto collectTriangles = [&](const SubMesh& submesh)
+    {
+        std::vector<TrianglePositions> result;
+        for (uint32_t i = submesh.indexBufferStartIndex; i < submesh.indexBufferStartIndex + submesh.indexBufferCount; i += 3)
+        {
+            std::array<Vector3, 3> corners = {vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position};
+            const auto lowest = std::ranges::min_element(corners, [](const Vector3& a, const Vector3& b)
+            {
+                return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+            });
+            std::ranges::rotate(corners, lowest);
+
+            TrianglePositions& positions = result.emplace_back();
+            for (size_t k = 0; k < 3; ++k)
+            {
+                positions[k * 3] = corners[k].x;
+                positions[k * 3 + 1] = corners[k].y;
+                positions[k * 3 + 2] = corners[k].z;
+            }
+        }
+        std::ranges::sort(result);
+        return result;
+    };
+
+    const std::array trianglesBefore = {collectTriangles(submeshes[0]), collectTriangles(submeshes[1])};
+    const size_t vertexCountBefore = vertices.size();
+
+    const MeshOptimizer::Stats stats = MeshOptimizer::Optimize(vertices, indices, submeshes);
+
+    test.Check(vertices.size() == vertexCountBefore, "every vertex is still used");
+    test.Check(collectTriangles(submeshes[0]) == trianglesBefore[0], "grid triangles are unchanged");
+    test.Check(collectTriangles(submeshes[1]) == trianglesBefore[1], "sphere triangles are unchanged");
+    test.Check(stats.after.acmr < stats.before.acmr, "ACMR is lower");
+    test.Check(stats.after.acmr < 1.0f, "ACMR is below one vertex per triangle");
+    test.Check(stats.indexBytesAfter == stats.indexBytesBefore / 2, "indices fit in 16 bits");
+
+    // The first use order must be increasing after the fetch optimization
+    uint32_t nextNewVertex = 0;
+    for (const uint32_t index : indices)
+    {
+        if (index == nextNewVertex)
+            ++nextNewVertex;
+        else if (index > nextNewVertex)
+        {
+            test.Check(false, "vertices are in first use order");
+            break;
+        }
+    }
+
+    test.Report("Mesh optimizer test: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, {} clusters",
+        stats.before.acmr,
+        stats.after.acmr,
+        stats.before.atvr,
+        stats.after.atvr,
+        stats.clusterCount);
+}
+
+}
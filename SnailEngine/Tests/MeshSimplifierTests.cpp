@@ -0,0 +1,127 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+#include "Core/Mesh/MeshSimplifier.h"
+#include "Core/Mesh/SubMesh.h"
+
+namespace Snail
+{
+
+// Simplifies generated meshes and checks their Hausdorff distance, their locked vertices and the LOD hysteresis
+void TestMeshSimplifier(TestContext& test)
+{
+    // UV sphere of radius one, with a seam where the UVs wrap and a ring of vertices at each pole
+    std::vector<MeshVertex> sphereVertices;
+    std::vector<uint32_t> sphereIndices;
+    constexpr uint32_t RINGS = 32;
+    constexpr uint32_t SEGMENTS = 48;
+    for (uint32_t ring = 0; ring <= RINGS; ++ring)
+    {
+        const float phi = DirectX::XM_PI * ring / RINGS;
+        for (uint32_t segment = 0; segment <= SEGMENTS; ++segment)
+        {
+            const float theta = DirectX::XM_2PI * segment / SEGMENTS;
+            const Vector3 position{std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta)};
+            sphereVertices.emplace_back(position, position, Vector2(static_cast<float>(segment) / SEGMENTS, static_cast<float>(ring) / RINGS));
+        }
+    }
+    for (uint32_t ring = 0; ring < RINGS; ++ring)
+    {
+        for (uint32_t segment = 0; segment < SEGMENTS; ++segment)
+        {
+            const uint32_t a = ring * (SEGMENTS + 1) + segment;
+            const uint32_t b = a + SEGMENTS + 1;
+            sphereIndices.insert(sphereIndices.end(), {a, b, a + 1, a + 1, b, b + 1});
+        }
+    }
+
+    float sphereError;
+    const std::vector<uint32_t> sphereQuarter = MeshSimplifier::Simplify(sphereVertices, sphereIndices, sphereIndices.size() / 4, 0.05f, sphereError);
+    const float sphereDistance = MeshSimplifier::ComputeHausdorffDistance(sphereVertices, sphereIndices, sphereQuarter);
+    test.Check(sphereQuarter.size() <= sphereIndices.size() / 4, "sphere reaches a quarter of its triangles");
+    // Error is relative to the sphere diameter
+    test.Check(sphereError <= 0.05f, "sphere error stays under the limit");
+    test.Check(sphereDistance <= 0.05f, "sphere Hausdorff distance");
+
+    // A flat grid loses its inside without moving, its border is locked
+    std::vector<MeshVertex> gridVertices;
+    std::vector<uint32_t> gridIndices;
+    constexpr uint32_t GRID_SIZE = 32;
+    for (uint32_t y = 0; y <= GRID_SIZE; ++y)
+        for (uint32_t x = 0; x <= GRID_SIZE; ++x)
+            gridVertices.emplace_back(Vector3(static_cast<float>(x), 0, static_cast<float>(y)), Vector3::Up, Vector2(static_cast<float>(x), static_cast<float>(y)) / GRID_SIZE);
+    for (uint32_t y = 0; y < GRID_SIZE; ++y)
+    {
+        for (uint32_t x = 0; x < GRID_SIZE; ++x)
+        {
+            const uint32_t topLeft = x + y * (GRID_SIZE + 1);
+            const uint32_t bottomLeft = topLeft + GRID_SIZE + 1;
+            gridIndices.insert(gridIndices.end(), {topLeft + 1, topLeft, bottomLeft, topLeft + 1, bottomLeft, bottomLeft + 1});
+        }
+    }
+
+    float gridError;
+    const std::vector<uint32_t> gridSimplified = MeshSimplifier::Simplify(gridVertices, gridIndices, 0, 0.01f, gridError);
+    const float gridDistance = MeshSimplifier::ComputeHausdorffDistance(gridVertices, gridIndices, gridSimplified);
+    test.Check(gridSimplified.size() * 4 < gridIndices.size(), "grid loses most of its triangles");
+    test.Check(gridDistance <= 1e-4f, "grid Hausdorff distance");
+
+    std::vector<uint8_t> used(gridVertices.size(), 0);
+    for (const uint32_t index : gridSimplified)
+        used[index] = 1;
+    bool bordersKept = true;
+    for (uint32_t i = 0; i <= GRID_SIZE; ++i)
+    {
+        bordersKept &= used[i] && used[i * (GRID_SIZE + 1)] && used[i * (GRID_SIZE + 1) + GRID_SIZE] && used[GRID_SIZE * (GRID_SIZE + 1) + i];
+    }
+    test.Check(bordersKept, "grid border vertices are kept");
+
+    // Sphere and grid as two submeshes
+    std::vector<MeshVertex> vertices = sphereVertices;
+    std::vector<uint32_t> indices = sphereIndices;
+    const auto gridBase = static_cast<uint32_t>(vertices.size());
+    vertices.insert(vertices.end(), gridVertices.begin(), gridVertices.end());
+    std::ranges::transform(gridIndices, std::back_inserter(indices), [gridBase](const uint32_t index) { return index + gridBase; });
+
+    std::vector<SubMesh> submeshes(2);
+    submeshes[0].indexBufferCount = static_cast<uint32_t>(sphereIndices.size());
+    submeshes[1].indexBufferStartIndex = submeshes[0].indexBufferCount;
+    submeshes[1].indexBufferCount = static_cast<uint32_t>(gridIndices.size());
+    const size_t baseIndexCount = indices.size();
+
+    const MeshSimplifier::LodStats stats = MeshSimplifier::BuildLods(vertices, indices, submeshes);
+    test.Check(stats.lodCount >= 3, "at least two LODs are built");
+    bool trianglesDecrease = true;
+    for (uint8_t lod = 1; lod < stats.lodCount; ++lod)
+        trianglesDecrease &= stats.triangleCounts[lod] < stats.triangleCounts[lod - 1];
+    test.Check(trianglesDecrease, "every LOD has fewer triangles");
+    bool rangesAppended = true;
+    for (const SubMesh& submesh : submeshes)
+        for (uint8_t lod = 1; lod < submesh.lodCount; ++lod)
+            rangesAppended &= submesh.GetLodRange(lod).start >= baseIndexCount;
+    test.Check(rangesAppended, "LOD indices come after LOD 0");
+
+    // Hysteresis around the LOD 1 threshold
+    const float threshold = MeshLodSelector::LOD_SCREEN_COVERAGE[1];
+    const float band = threshold * MeshLodSelector::HYSTERESIS;
+    test.Check(MeshLodSelector::Select(threshold * 2, 0, 4) == 0, "big coverage picks LOD 0");
+    test.Check(MeshLodSelector::Select(threshold - band * 0.5f, 0, 4) == 0, "LOD 0 holds inside the band");
+    test.Check(MeshLodSelector::Select(threshold - band * 2, 0, 4) == 1, "LOD 1 past the band");
+    test.Check(MeshLodSelector::Select(threshold + band * 0.5f, 1, 4) == 1, "LOD 1 holds inside the band");
+    test.Check(MeshLodSelector::Select(threshold + band * 2, 1, 4) == 0, "LOD 0 past the band");
+    test.Check(MeshLodSelector::Select(0, 0, 2) == 1, "selection stays under the LOD count");
+
+    test.Report("Mesh simplifier test: sphere {} -> {} triangles with a Hausdorff distance of {:.4f}, grid {} -> {} triangles",
+        sphereIndices.size() / 3,
+        sphereQuarter.size() / 3,
+        sphereDistance,
+        gridIndices.size() / 3,
+        gridSimplified.size() / 3);
+}
+
+}
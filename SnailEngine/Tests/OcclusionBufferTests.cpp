@@ -0,0 +1,108 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "Rendering/Occlusion/OccluderMesh.h"
+#include "Rendering/Occlusion/OcclusionBuffer.h"
+
+namespace Snail
+{
+
+// Rasterizes random triangles with both rasterizers and checks occlusion queries around a wall
+void TestOcclusionBuffer(TestContext& test)
+{
+    // Rounding differences between the float steps and the double reference, only on pixel centers lying on an edge
+    constexpr float DEPTH_TOLERANCE = 1e-4f;
+    constexpr size_t MAX_DIFFERENT_PIXELS = OcclusionBuffer::WIDTH * OcclusionBuffer::HEIGHT / 1000;
+    constexpr uint32_t BAND_HEIGHT = 16;
+
+    // Same reversed depth as the cameras
+    const Matrix viewProjection = Matrix::CreateLookAt(Vector3::Zero, Vector3::Forward, Vector3::Up)
+        * Matrix::CreatePerspectiveFieldOfView(DirectX::XM_PIDIV4, static_cast<float>(OcclusionBuffer::WIDTH) / static_cast<float>(OcclusionBuffer::HEIGHT), 100.0f, 0.1f);
+
+    // Triangles of all sizes, some behind the camera, crossing the near plane or leaving the screen
+    std::mt19937 rng{37};
+    std::uniform_real_distribution<float> centerX{-30.0f, 30.0f};
+    std::uniform_real_distribution<float> centerY{-15.0f, 15.0f};
+    std::uniform_real_distribution<float> centerZ{-80.0f, 2.0f};
+    std::uniform_real_distribution<float> logSize{-3.0f, 2.5f};
+    std::uniform_real_distribution<float> offset{-1.0f, 1.0f};
+
+    constexpr size_t RANDOM_TRIANGLE_COUNT = 2000;
+    std::vector<Vector3> positions;
+    for (size_t i = 0; i < RANDOM_TRIANGLE_COUNT; ++i)
+    {
+        const Vector3 center{centerX(rng), centerY(rng), centerZ(rng)};
+        const float size = std::exp(logSize(rng));
+        for (int corner = 0; corner < 3; ++corner)
+            positions.push_back(center + Vector3{offset(rng), offset(rng), offset(rng)} * size);
+    }
+    std::vector<uint32_t> indices(positions.size());
+    std::iota(indices.begin(), indices.end(), 0);
+
+    std::vector<OcclusionBuffer::ScreenTriangle> triangles;
+    OcclusionBuffer::ProjectTriangles(positions, indices, viewProjection, triangles);
+
+    OcclusionBuffer simd;
+    OcclusionBuffer reference;
+    simd.Clear();
+    reference.Clear();
+    // By bands like the jobs do
+    for (uint32_t row = 0; row < OcclusionBuffer::HEIGHT; row += BAND_HEIGHT)
+        simd.Rasterize(triangles, row, row + BAND_HEIGHT);
+    reference.RasterizeReference(triangles);
+    simd.UpdateTiles();
+    reference.UpdateTiles();
+
+    size_t differentPixels = 0;
+    size_t coveredPixels = 0;
+    for (uint32_t y = 0; y < OcclusionBuffer::HEIGHT; ++y)
+    {
+        for (uint32_t x = 0; x < OcclusionBuffer::WIDTH; ++x)
+        {
+            differentPixels += std::abs(simd.GetDepth(x, y) - reference.GetDepth(x, y)) > DEPTH_TOLERANCE;
+            coveredPixels += reference.GetDepth(x, y) > 0;
+        }
+    }
+    test.Check(coveredPixels > OcclusionBuffer::WIDTH * OcclusionBuffer::HEIGHT / 2, "random triangles cover less than half of the buffer");
+    test.Check(differentPixels <= MAX_DIFFERENT_PIXELS, "SIMD rasterizer differs from the reference on more than 0.1% of the pixels");
+
+    // Both buffers must agree on random boxes
+    size_t disagreements = 0;
+    size_t occludedBoxes = 0;
+    constexpr size_t RANDOM_BOX_COUNT = 2000;
+    for (size_t i = 0; i < RANDOM_BOX_COUNT; ++i)
+    {
+        const DirectX::BoundingBox box{Vector3{centerX(rng), centerY(rng), centerZ(rng)}, Vector3{std::exp(logSize(rng))}};
+        const bool occluded = simd.IsOccluded(box, viewProjection);
+        occludedBoxes += occluded;
+        disagreements += occluded != reference.IsOccluded(box, viewProjection);
+    }
+    test.Check(occludedBoxes > 0, "no random box is occluded");
+    test.Check(disagreements <= RANDOM_BOX_COUNT / 200, "SIMD and reference buffers disagree on more than 0.5% of the boxes");
+
+    // A 10 x 10 wall 10 units in front of the camera hides +-10 units at 20 units
+    OcclusionBuffer wall;
+    wall.Clear();
+    triangles.clear();
+    const OccluderMesh& box = OccluderMesh::GetUnitBox();
+    OcclusionBuffer::ProjectTriangles(box.positions, box.indices, Matrix::CreateScale(10, 10, 0.5f) * Matrix::CreateTranslation(0, 0, -10) * viewProjection, triangles);
+    wall.Rasterize(triangles);
+    wall.UpdateTiles();
+
+    const auto isOccluded = [&](const Vector3& center) { return wall.IsOccluded(DirectX::BoundingBox{center, Vector3::One}, viewProjection); };
+    test.Check(isOccluded({0, 0, -20}), "box behind the wall is visible");
+    test.Check(isOccluded({8, 0, -20}), "box behind the wall's edge is visible");
+    test.Check(!isOccluded({10.5f, 0, -20}), "box peeking past the wall's edge is occluded");
+    test.Check(!isOccluded({0, 0, -5}), "box in front of the wall is occluded");
+    test.Check(!isOccluded({0, 0, -10}), "box crossing the wall is occluded");
+    test.Check(!isOccluded({0, 0, 0}), "box around the camera is occluded");
+
+    test.Report("{} pixels differ from the reference, {} of {} boxes disagree", differentPixels, disagreements, RANDOM_BOX_COUNT);
+}
+
+}
@@ -0,0 +1,119 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Rendering/FrameView.h"
+#include "Rendering/Occlusion/OccluderMesh.h"
+#include "Rendering/Occlusion/OcclusionCulling.h"
+
+namespace Snail
+{
+
+// Rasterizes a terrain and walls seen from a driver's view with both rasterizers and on the job system, then tests
+// thousands of props against the buffer
+void BenchmarkOcclusionCulling(TestContext& test)
+{
+    constexpr uint32_t FIELD_SIZE = 129;
+    constexpr float FIELD_SPACING = 4.0f;
+    constexpr size_t WALL_COUNT = 40;
+    constexpr size_t PROP_COUNT = 10000;
+    // Props stay within the horizontal field of view, in radians
+    constexpr float MAX_PROP_ANGLE = 0.6f;
+    constexpr float MIN_PROP_DISTANCE = 5.0f;
+    constexpr float MAX_PROP_DISTANCE = 250.0f;
+
+    // Rolling hills, similar to the scene terrains
+    const auto getHeight = [](const float x, const float z)
+    {
+        return 12.0f * std::sin(x * 0.03f) * std::cos(z * 0.025f) + 6.0f * std::sin(x * 0.011f + z * 0.017f);
+    };
+
+    std::vector<MeshVertex> fieldVertices(FIELD_SIZE * FIELD_SIZE);
+    for (uint32_t row = 0; row < FIELD_SIZE; ++row)
+    {
+        for (uint32_t column = 0; column < FIELD_SIZE; ++column)
+        {
+            const float x = static_cast<float>(static_cast<int>(column) - static_cast<int>(FIELD_SIZE / 2)) * FIELD_SPACING;
+            const float z = static_cast<float>(static_cast<int>(row) - static_cast<int>(FIELD_SIZE / 2)) * FIELD_SPACING;
+            fieldVertices[column + row * FIELD_SIZE].position = Vector3{x, getHeight(x, z), z};
+        }
+    }
+    const OccluderMesh terrain = OccluderMesh::FromHeightField(fieldVertices, FIELD_SIZE, FIELD_SIZE);
+
+    // Driver's view, a couple of units above the ground
+    const Vector3 eye{0, getHeight(0, 0) + 2.0f, 0};
+    const Matrix viewProjection = Matrix::CreateLookAt(eye, eye + Vector3::Forward, Vector3::Up)
+        * Matrix::CreatePerspectiveFieldOfView(DirectX::XM_PIDIV4, static_cast<float>(OcclusionBuffer::WIDTH) / static_cast<float>(OcclusionBuffer::HEIGHT), 1000.0f, 0.1f);
+
+    std::mt19937 rng{37};
+    std::uniform_real_distribution<float> angle{-MAX_PROP_ANGLE, MAX_PROP_ANGLE};
+    std::uniform_real_distribution<float> distance{MIN_PROP_DISTANCE, MAX_PROP_DISTANCE};
+    std::uniform_real_distribution<float> yaw{0, DirectX::XM_2PI};
+    const auto getGroundPoint = [&]
+    {
+        const float pointAngle = angle(rng);
+        const float pointDistance = distance(rng);
+        const float x = std::sin(pointAngle) * pointDistance;
+        const float z = -std::cos(pointAngle) * pointDistance;
+        return Vector3{x, getHeight(x, z), z};
+    };
+
+    FrameArena arena;
+    FrameView view{arena};
+    view.cullingCamera.viewProjection = viewProjection;
+    view.AddOccluder(terrain, Matrix::Identity);
+    for (size_t i = 0; i < WALL_COUNT; ++i)
+    {
+        const Matrix wall = Matrix::CreateScale(20, 8, 1) * Matrix::CreateRotationY(yaw(rng)) * Matrix::CreateTranslation(getGroundPoint() + Vector3{0, 4, 0});
+        view.AddOccluder(OccluderMesh::GetUnitBox(), wall);
+    }
+
+    std::vector<DirectX::BoundingBox> props(PROP_COUNT);
+    for (DirectX::BoundingBox& prop : props)
+        prop = DirectX::BoundingBox{getGroundPoint() + Vector3::Up, Vector3::One};
+
+    std::vector<OcclusionBuffer::ScreenTriangle> triangles;
+    for (const OcclusionCulling::Occluder& occluder : view.occluders)
+        OcclusionBuffer::ProjectTriangles(occluder.mesh->positions, occluder.mesh->indices, occluder.world * viewProjection, triangles);
+
+    OcclusionBuffer reference;
+    reference.Clear();
+    const auto referenceStart = TestClock::now();
+    reference.RasterizeReference(triangles);
+    const float referenceRasterizeMs = ElapsedMs(referenceStart);
+
+    OcclusionBuffer simd;
+    simd.Clear();
+    const auto simdStart = TestClock::now();
+    simd.Rasterize(triangles);
+    const float simdRasterizeMs = ElapsedMs(simdStart);
+
+    // What a frame does, projection included
+    OcclusionCulling culling;
+    const auto parallelStart = TestClock::now();
+    culling.Render(view);
+    const float parallelRasterizeMs = ElapsedMs(parallelStart);
+    culling.UseFrame(view.frameIndex);
+
+    size_t culledCount = 0;
+    const auto testStart = TestClock::now();
+    for (const DirectX::BoundingBox& prop : props)
+        culledCount += culling.IsOccluded(prop);
+    const float testMs = ElapsedMs(testStart);
+    test.Check(culledCount > 0, "no prop is culled");
+
+    test.Report("{} occluders, {} triangles, reference {:.3f} ms, SIMD {:.3f} ms, parallel {:.3f} ms, {} of {} boxes culled in {:.3f} ms",
+        view.occluders.size(),
+        triangles.size(),
+        referenceRasterizeMs,
+        simdRasterizeMs,
+        parallelRasterizeMs,
+        culledCount,
+        props.size(),
+        testMs);
+}
+
+}
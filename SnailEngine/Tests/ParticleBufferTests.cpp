@@ -0,0 +1,147 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Rendering/Particles/ParticleBuffer.h"
+
+namespace Snail
+{
+
+// Compares the kernels with the reference update over many random particles
+void TestParticleBuffer(TestContext& test)
+{
+    constexpr size_t PARTICLE_COUNT = 1001;
+    constexpr size_t STEP_COUNT = 120;
+    constexpr float DELTA_TIME = 1.0f / 60.0f;
+    // The polynomial cosine against std::cos, accumulated over the steps
+    constexpr float POSITION_TOLERANCE = 1e-4f;
+
+    std::mt19937 rng{38};
+    std::uniform_real_distribution<float> position{-50.0f, 50.0f};
+    std::uniform_real_distribution<float> velocity{-5.0f, 5.0f};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+    std::uniform_real_distribution<float> phase{0.0f, DirectX::XM_2PI};
+    // Some expire during the test, some never do
+    std::uniform_real_distribution<float> lifetime{0.1f, 4.0f};
+
+    ParticleBuffer simd;
+    ParticleBuffer reference;
+    size_t survivorCount = 0;
+    for (size_t i = 0; i < PARTICLE_COUNT; ++i)
+    {
+        ParticleBuffer::Particle particle;
+        particle.position = {position(rng), position(rng), position(rng)};
+        particle.velocity = {velocity(rng), velocity(rng), velocity(rng)};
+        particle.size = {unit(rng) + 0.1f, unit(rng) + 0.1f};
+        particle.color = {unit(rng), unit(rng), unit(rng), unit(rng)};
+        particle.phase = phase(rng);
+        if (i % 3 != 0)
+            particle.lifetime = lifetime(rng);
+        if (i % 5 == 0)
+            particle.light = static_cast<int32_t>(i);
+
+        // Away from the end of the test, float ages could land on either side
+        if (std::abs(particle.lifetime - static_cast<float>(STEP_COUNT) * DELTA_TIME) < 0.05f)
+            particle.lifetime += 0.1f;
+        survivorCount += particle.lifetime > static_cast<float>(STEP_COUNT) * DELTA_TIME;
+
+        simd.Emit(particle);
+        reference.Emit(particle);
+    }
+
+    const ParticleBuffer::UpdateParams params{.acceleration = {0, -9.8f, 0}, .hoverAmplitude = 0.6f, .hoverFrequency = 3.0f, .endAlpha = 0.0f};
+    for (size_t step = 0; step < STEP_COUNT; ++step)
+    {
+        simd.Update(DELTA_TIME, params);
+        reference.UpdateReference(DELTA_TIME, params);
+    }
+
+    test.Check(simd.GetCount() == survivorCount, "expired particles were not removed");
+    test.Check(simd.GetCount() == reference.GetCount(), "the kernels and the reference kept different particles");
+
+    size_t differentPositions = 0;
+    size_t differentColors = 0;
+    for (size_t i = 0; i < std::min(simd.GetCount(), reference.GetCount()); ++i)
+    {
+        differentPositions += Vector3::Distance(simd.GetPosition(i), reference.GetPosition(i)) > POSITION_TOLERANCE;
+        differentColors += simd.GetPackedColor(i) != reference.GetPackedColor(i);
+    }
+    test.Check(differentPositions == 0, "the kernels moved the particles differently from the reference");
+    test.Check(differentColors == 0, "the kernels faded the colors differently from the reference");
+
+    size_t boundLightCount = 0;
+    simd.ForEachBoundLight([&](const int32_t light, const Vector3& lightPosition)
+    {
+        ++boundLightCount;
+        test.Check(light % 5 == 0, "a particle lost its light");
+        test.Check(std::isfinite(lightPosition.y), "a light got an invalid position");
+    });
+    size_t referenceBoundLightCount = 0;
+    reference.ForEachBoundLight([&](int32_t, const Vector3&) { ++referenceBoundLightCount; });
+    test.Check(boundLightCount == referenceBoundLightCount, "bound lights were lost");
+
+    std::vector<ParticleInstance> instances;
+    simd.WriteInstances(0, instances);
+    test.Check(instances.size() == simd.GetCount(), "not every particle got an instance");
+    test.Check(instances.empty() || (instances.back().position == simd.GetPosition(simd.GetCount() - 1) && instances.back().color == simd.GetPackedColor(simd.GetCount() - 1)), "an instance doesn't match its particle");
+}
+
+// Times the kernels against the reference update and the instance writes over a hundred thousand particles
+void BenchmarkParticleBuffer(TestContext& test)
+{
+    constexpr size_t PARTICLE_COUNT = 100000;
+    constexpr size_t STEP_COUNT = 100;
+    constexpr float DELTA_TIME = 1.0f / 60.0f;
+
+    std::mt19937 rng{38};
+    std::uniform_real_distribution<float> position{-100.0f, 100.0f};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+
+    // Lifetimes longer than the benchmark, both sides update the same particles every step
+    ParticleBuffer buffer;
+    for (size_t i = 0; i < PARTICLE_COUNT; ++i)
+    {
+        ParticleBuffer::Particle particle;
+        particle.position = {position(rng), position(rng), position(rng)};
+        particle.velocity = {unit(rng), unit(rng), unit(rng)};
+        particle.color = {unit(rng), unit(rng), unit(rng), 1.0f};
+        particle.lifetime = 1000.0f;
+        particle.phase = unit(rng) * DirectX::XM_2PI;
+        buffer.Emit(particle);
+    }
+    ParticleBuffer reference = buffer;
+
+    const ParticleBuffer::UpdateParams params{.acceleration = {0, -1.0f, 0}, .hoverAmplitude = 0.6f, .endAlpha = 0.0f};
+    const auto referenceStart = TestClock::now();
+    for (size_t step = 0; step < STEP_COUNT; ++step)
+        reference.UpdateReference(DELTA_TIME, params);
+    const float referenceUpdateMs = ElapsedMs(referenceStart) / static_cast<float>(STEP_COUNT);
+
+    const auto simdStart = TestClock::now();
+    for (size_t step = 0; step < STEP_COUNT; ++step)
+        buffer.Update(DELTA_TIME, params);
+    const float simdUpdateMs = ElapsedMs(simdStart) / static_cast<float>(STEP_COUNT);
+
+    std::vector<ParticleInstance> instances;
+    instances.reserve(PARTICLE_COUNT);
+    const auto writeStart = TestClock::now();
+    for (size_t step = 0; step < STEP_COUNT; ++step)
+    {
+        instances.clear();
+        buffer.WriteInstances(0, instances);
+    }
+    const float writeInstancesMs = ElapsedMs(writeStart) / static_cast<float>(STEP_COUNT);
+
+    LOGF("ParticleBuffer::Particle benchmark: {} particles, reference update {:.3f} ms, SIMD update {:.3f} ms, instances written in {:.3f} ms",
+        results.particleCount,
+        results.referenceUpdateMs,
+        results.simdUpdateMs,
+        results.writeInstancesMs);
+    return results;
+}
+
+}
@@ -0,0 +1,177 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <chrono>
+#include <initializer_list>
+#include <vector>
+
+#include "TestPhysics.h"
+#include "Core/Physics/PhysicsEventQueue.h"
+#include "Core/Physics/PhysXAllocator.h"
+
+using namespace physx;
+
+namespace Snail
+{
+
+namespace
+{
+
+struct CountingHandler : PhysicsEventHandler
+{
+    size_t enterCount = 0;
+    size_t exitCount = 0;
+    size_t shapeEnterCount = 0;
+    size_t shapeExitCount = 0;
+    size_t contactCount = 0;
+    size_t sleepCount = 0;
+    float impulse = 0;
+
+    void OnTriggerEnter(void*) override { ++enterCount; }
+    void OnTriggerExit(void*) override { ++exitCount; }
+    void OnShapeEnterTrigger(void*, void*) override { ++shapeEnterCount; }
+    void OnShapeExitTrigger(void*, void*) override { ++shapeExitCount; }
+    void OnContact(void*, void*, const float contactImpulse) override
+    {
+        ++contactCount;
+        impulse += contactImpulse;
+    }
+    void OnSleepChanged(void*, const bool isAsleep) override
+    {
+        if (isAsleep)
+            ++sleepCount;
+    }
+};
+
+void RecordEvents(PhysicsEventQueue& queue, const std::initializer_list<PhysicsEvent> events)
+{
+    for (const PhysicsEvent& event : events)
+        queue.Record(event);
+}
+
+}
+
+// Feeds recorded events through the pair tracking, checks the enters, the exits and the removed shapes
+void TestPhysicsEventQueue(TestContext& test)
+{
+    // Stand-ins for the shapes, only their addresses are used
+    int trigger = 0, otherTrigger = 0, car = 0, crate = 0;
+    const auto triggerEvent = [](const PhysicsEvent::Type type, int& triggerShape, int& otherShape, const bool isTriggerRemoved = false, const bool isOtherRemoved = false)
+    {
+        return PhysicsEvent{type, isTriggerRemoved, isOtherRemoved, &triggerShape, &otherShape, &triggerShape, &otherShape};
+    };
+    constexpr PhysicsEvent::Type FOUND = PhysicsEvent::Type::TRIGGER_FOUND;
+    constexpr PhysicsEvent::Type LOST = PhysicsEvent::Type::TRIGGER_LOST;
+
+    PhysicsEventQueue queue;
+    CountingHandler handler;
+
+    // Two shapes in the trigger, it is exited once both left
+    RecordEvents(queue, {triggerEvent(FOUND, trigger, car), triggerEvent(FOUND, trigger, crate)});
+    queue.Dispatch(handler);
+    test.Check(handler.enterCount == 1 && handler.shapeEnterCount == 2, "the trigger wasn't entered once by two shapes");
+    test.Check(queue.GetPendingEventCount() == 0, "the events weren't cleared after the dispatch");
+
+    RecordEvents(queue, {triggerEvent(LOST, trigger, car)});
+    queue.Dispatch(handler);
+    test.Check(handler.exitCount == 0 && handler.shapeExitCount == 1, "the trigger was exited with a shape still in it");
+
+    RecordEvents(queue, {triggerEvent(LOST, trigger, crate)});
+    queue.Dispatch(handler);
+    test.Check(handler.exitCount == 1 && handler.shapeExitCount == 2 && queue.GetTouchingPairCount() == 0, "the trigger wasn't exited when empty");
+
+    // Repeated events don't flip the state of the pair
+    handler = {};
+    RecordEvents(queue, {triggerEvent(FOUND, trigger, car), triggerEvent(FOUND, trigger, car), triggerEvent(LOST, otherTrigger, car)});
+    queue.Dispatch(handler);
+    test.Check(handler.enterCount == 1 && handler.exitCount == 0, "a duplicated or unmatched event changed a trigger");
+    test.Check(queue.GetStats().ignoredCount == 2, "the duplicated and unmatched events weren't counted");
+
+    // A shape removed while in the trigger exits it, a removed trigger goes without a callback
+    RecordEvents(queue, {triggerEvent(LOST, trigger, car, false, true), triggerEvent(FOUND, otherTrigger, crate)});
+    queue.Dispatch(handler);
+    test.Check(handler.exitCount == 1 && handler.shapeExitCount == 0, "removing the shape in a trigger didn't exit it");
+
+    RecordEvents(queue, {triggerEvent(LOST, otherTrigger, crate, true, false)});
+    queue.Dispatch(handler);
+    test.Check(handler.exitCount == 1 && handler.shapeExitCount == 0, "a removed trigger got a callback");
+    test.Check(queue.GetTouchingPairCount() == 0 && queue.GetOccupiedTriggerCount() == 0, "the pairs of a removed trigger were kept");
+
+    // Contacts and sleep keep their data
+    handler = {};
+    RecordEvents(queue, {{PhysicsEvent::Type::CONTACT, false, false, &car, &crate, &car, &crate, 12.5f}, {PhysicsEvent::Type::SLEEP, false, false, &crate, nullptr, &crate}});
+    queue.Dispatch(handler);
+    test.Check(handler.contactCount == 1 && handler.impulse == 12.5f && handler.sleepCount == 1, "contact or sleep events were lost");
+}
+
+// Records and dispatches tens of thousands of trigger events per step, every shape of a grid entering every trigger
+// in one step and leaving it in the next
+void BenchmarkPhysicsEventQueue(TestContext& test)
+{
+    constexpr PxU32 TRIGGER_COUNT = 256;
+    constexpr PxU32 SHAPE_COUNT = 128;
+    constexpr int STEP_COUNT = 8;
+
+    PxPhysics& physics = TestPhysics::Get().GetPhysics();
+
+    const PhysXUniquePtr<PxMaterial> material{physics.createMaterial(0.8f, 0.8f, 0.2f)};
+    std::vector<PhysXUniquePtr<PxShape>> triggers;
+    std::vector<PhysXUniquePtr<PxShape>> shapes;
+    for (PxU32 i = 0; i < TRIGGER_COUNT; ++i)
+    {
+        PxShape* trigger = triggers.emplace_back(physics.createShape(PxBoxGeometry{1, 1, 1}, *material)).get();
+        trigger->userData = trigger;
+    }
+    for (PxU32 i = 0; i < SHAPE_COUNT; ++i)
+    {
+        PxShape* shape = shapes.emplace_back(physics.createShape(PxSphereGeometry{0.2f}, *material)).get();
+        shape->userData = shape;
+    }
+
+    // What PhysX hands to onTrigger, every shape entering or leaving every trigger
+    std::vector<PxTriggerPair> pairs(static_cast<size_t>(TRIGGER_COUNT) * SHAPE_COUNT);
+    for (PxU32 trigger = 0; trigger < TRIGGER_COUNT; ++trigger)
+    {
+        for (PxU32 shape = 0; shape < SHAPE_COUNT; ++shape)
+        {
+            PxTriggerPair& pair = pairs[static_cast<size_t>(trigger) * SHAPE_COUNT + shape];
+            pair.triggerShape = triggers[trigger].get();
+            pair.triggerActor = nullptr;
+            pair.otherShape = shapes[shape].get();
+            pair.otherActor = nullptr;
+            pair.flags = PxTriggerPairFlags{};
+        }
+    }
+
+    PhysicsEventQueue queue;
+    CountingHandler handler;
+    // Averaged over the steps
+    float recordMs = 0;
+    float dispatchMs = 0;
+    for (int step = 0; step < STEP_COUNT; ++step)
+    {
+        const PxPairFlag::Enum status = step % 2 == 0 ? PxPairFlag::eNOTIFY_TOUCH_FOUND : PxPairFlag::eNOTIFY_TOUCH_LOST;
+        for (PxTriggerPair& pair : pairs)
+            pair.status = status;
+
+        const auto start = TestClock::now();
+        queue.onTrigger(pairs.data(), static_cast<PxU32>(pairs.size()));
+        const auto recorded = TestClock::now();
+        queue.Dispatch(handler);
+        const auto dispatched = TestClock::now();
+
+        recordMs += std::chrono::duration<float, std::milli>(recorded - start).count() / STEP_COUNT;
+        dispatchMs += std::chrono::duration<float, std::milli>(dispatched - recorded).count() / STEP_COUNT;
+    }
+
+    test.Check(handler.enterCount == TRIGGER_COUNT * STEP_COUNT / 2
+        && handler.exitCount == TRIGGER_COUNT * STEP_COUNT / 2
+        && handler.shapeEnterCount == pairs.size() * STEP_COUNT / 2
+        && handler.shapeExitCount == pairs.size() * STEP_COUNT / 2
+        && queue.GetTouchingPairCount() == 0,
+        "every trigger and shape entered and exited once per pair of steps");
+
+    test.Report("{} events per step, recorded in {:.3f} ms and dispatched in {:.3f} ms", pairs.size(), recordMs, dispatchMs);
+}
+
+}
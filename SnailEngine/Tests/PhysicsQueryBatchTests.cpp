@@ -0,0 +1,103 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "TestPhysics.h"
+#include "Core/ThreadPool.h"
+#include "Core/Physics/PhysicsQueryBatch.h"
+#include "Core/Physics/PhysXAllocator.h"
+
+using namespace physx;
+
+namespace Snail
+{
+
+// Casts 10k rays against a terrain heightfield, one query at a time and then batched on 1, 2, 4... jobs
+void BenchmarkPhysicsQueryBatch(TestContext& test)
+{
+    constexpr size_t RAY_COUNT = 10000;
+    constexpr PxU32 FIELD_SIZE = 256;
+    constexpr float FIELD_SCALE = 2.0f;
+    constexpr float FIELD_HEIGHT = 40.0f;
+
+    // Rolling hills, similar to the scene terrains
+    std::vector<PxHeightFieldSample> samples(FIELD_SIZE * FIELD_SIZE);
+    for (PxU32 row = 0; row < FIELD_SIZE; ++row)
+    {
+        for (PxU32 column = 0; column < FIELD_SIZE; ++column)
+        {
+            const float height = 0.5f + 0.25f * (std::sin(row * 0.05f) + std::cos(column * 0.07f));
+            samples[row * FIELD_SIZE + column].height = static_cast<PxI16>(height * std::numeric_limits<PxI16>::max());
+        }
+    }
+
+    PxPhysics& physics = TestPhysics::Get().GetPhysics();
+    PxHeightFieldDesc fieldDesc;
+    fieldDesc.format = PxHeightFieldFormat::eS16_TM;
+    fieldDesc.nbRows = FIELD_SIZE;
+    fieldDesc.nbColumns = FIELD_SIZE;
+    fieldDesc.samples.data = samples.data();
+    fieldDesc.samples.stride = sizeof(PxHeightFieldSample);
+
+    const PhysXUniquePtr<PxHeightField> field{PxCreateHeightField(fieldDesc, physics.getPhysicsInsertionCallback())};
+    const PhysXUniquePtr<PxMaterial> material{physics.createMaterial(0.8f, 0.8f, 0.2f)};
+
+    PxSceneDesc sceneDesc(physics.getTolerancesScale());
+    sceneDesc.cpuDispatcher = &TestPhysics::Get().GetDispatcher();
+    sceneDesc.filterShader = PxDefaultSimulationFilterShader;
+    const PhysXUniquePtr<PxScene> scene{physics.createScene(sceneDesc)};
+
+    const PhysXUniquePtr<PxRigidStatic> terrain{physics.createRigidStatic(PxTransform(PxIdentity))};
+    const PxHeightFieldGeometry fieldGeometry(field.get(), PxMeshGeometryFlags(), FIELD_HEIGHT / std::numeric_limits<PxI16>::max(), FIELD_SCALE, FIELD_SCALE);
+    PxRigidActorExt::createExclusiveShape(*terrain, fieldGeometry, *material);
+    scene->addActor(*terrain);
+
+    // Rays from above the terrain, going down at an angle, some of them leave the field before hitting it
+    constexpr float MAX_DISTANCE = 1000.0f;
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> position(0, FIELD_SIZE * FIELD_SCALE);
+    std::uniform_real_distribution<float> slope(-1, 1);
+    std::vector<Vector3> origins(RAY_COUNT);
+    std::vector<Vector3> directions(RAY_COUNT);
+    PhysicsQueryBatch batch;
+    for (size_t i = 0; i < RAY_COUNT; ++i)
+    {
+        origins[i] = Vector3(position(rng), FIELD_HEIGHT + 10, position(rng));
+        directions[i] = Vector3(slope(rng), -1, slope(rng));
+        directions[i].Normalize();
+        batch.AddRaycast(origins[i], directions[i], MAX_DISTANCE);
+    }
+
+    // What gameplay code used to do, one blocking raycast at a time
+    std::vector<float> singleDistances(RAY_COUNT, std::numeric_limits<float>::max());
+    const auto singleStart = TestClock::now();
+    for (size_t i = 0; i < RAY_COUNT; ++i)
+    {
+        const PxVec3 origin{origins[i].x, origins[i].y, origins[i].z};
+        const PxVec3 direction{directions[i].x, directions[i].y, directions[i].z};
+        if (PxRaycastBuffer hit; scene->raycast(origin, direction, MAX_DISTANCE, hit))
+            singleDistances[i] = hit.block.distance;
+    }
+    const float singleQueriesMs = ElapsedMs(singleStart);
+    test.Report("{} rays one at a time: {:.3f} ms", RAY_COUNT, singleQueriesMs);
+
+    ThreadPool pool;
+    for (size_t jobCount = 1; jobCount <= std::max(std::thread::hardware_concurrency(), 1u); jobCount *= 2)
+    {
+        const auto start = TestClock::now();
+        batch.Execute(*scene, pool, jobCount);
+        const float batchMs = ElapsedMs(start);
+        test.Report("Batched on {} jobs: {:.3f} ms (x{:.2f})", jobCount, batchMs, singleQueriesMs / batchMs);
+
+        test.Check(std::ranges::equal(batch.GetRaycastHits().distances, singleDistances), "the batched results match the single queries");
+    }
+    test.Report("{} hits", batch.GetRaycastHits().GetHitCount());
+}
+
+}
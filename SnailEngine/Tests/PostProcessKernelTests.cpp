@@ -0,0 +1,228 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "Rendering/Effects/PostProcessing/PostProcessKernels.h"
+
+namespace Snail
+{
+
+namespace
+{
+
+std::vector<float> RandomValues(std::mt19937& generator, const size_t count, const float min, const float max)
+{
+    std::uniform_real_distribution distribution{min, max};
+    std::vector<float> values(count);
+    std::ranges::generate(values, [&] { return distribution(generator); });
+    return values;
+}
+
+float MaxDifference(const std::span<const float> a, const std::span<const float> b)
+{
+    float difference = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+        difference = std::max(difference, std::abs(a[i] - b[i]));
+    return difference;
+}
+
+// A bumpy wall in front of a right handed perspective camera, with the hemisphere samples of the engine
+struct SsaoScene
+{
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> noise;
+    std::vector<float> samples;
+    SsaoInputs inputs;
+
+    SsaoScene(std::mt19937& generator, const int width, const int height)
+        : noise(RandomValues(generator, 16 * 3, -1.0f, 1.0f))
+        , samples(RandomValues(generator, 64 * 3, -1.0f, 1.0f))
+    {
+        const float aspect = static_cast<float>(width) / static_cast<float>(height);
+        const float yScale = 1.0f / std::tan(0.5f * 0.785398f);
+        constexpr float nearZ = 0.1f;
+        constexpr float farZ = 100.0f;
+
+        inputs.width = width;
+        inputs.height = height;
+        inputs.projection = {yScale / aspect, 0, 0, 0, 0, yScale, 0, 0, 0, 0, farZ / (nearZ - farZ), -1, 0, 0, nearZ * farZ / (nearZ - farZ), 0};
+        inputs.offscreenDepth = -nearZ;
+
+        for (size_t i = 0; i < 16; ++i)
+            noise[i * 3 + 2] = 0;
+        for (size_t i = 0; i < 64; ++i)
+        {
+            samples[i * 3 + 2] = std::abs(samples[i * 3 + 2]);
+            const float scale = static_cast<float>(i) / 64.0f;
+            for (size_t c = 0; c < 3; ++c)
+                samples[i * 3 + c] *= 0.1f + 0.9f * scale * scale;
+        }
+
+        positions.resize(static_cast<size_t>(width) * height * 3);
+        normals.resize(positions.size());
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                const size_t pixel = (static_cast<size_t>(y) * width + x) * 3;
+                const float z = -5.0f - std::sin(static_cast<float>(x) * 0.3f) * std::cos(static_cast<float>(y) * 0.2f);
+                positions[pixel] = ((static_cast<float>(x) + 0.5f) / static_cast<float>(width) * 2 - 1) * -z / inputs.projection[0];
+                positions[pixel + 1] = (1 - (static_cast<float>(y) + 0.5f) / static_cast<float>(height) * 2) * -z / inputs.projection[5];
+                positions[pixel + 2] = z;
+                normals[pixel] = std::cos(static_cast<float>(x) * 0.3f) * 0.3f;
+                normals[pixel + 1] = std::sin(static_cast<float>(y) * 0.2f) * 0.2f;
+                normals[pixel + 2] = 1;
+            }
+        }
+
+        inputs.positions = positions;
+        inputs.normals = normals;
+        inputs.noise = noise;
+        inputs.samples = samples;
+    }
+};
+
+}
+
+// Compares the separable passes with the full kernels and the SIMD versions with the scalar ones on random images
+void TestPostProcessKernels(TestContext& test)
+{
+    std::mt19937 generator{47};
+    // Not multiples of the tiles
+    constexpr int width = 75;
+    constexpr int height = 41;
+    constexpr size_t pixelCount = static_cast<size_t>(width) * height;
+    const std::vector<float> image = RandomValues(generator, pixelCount * 4, 0.0f, 1.0f);
+    std::vector<float> intermediate(image.size());
+    std::vector<float> separable(image.size());
+    std::vector<float> simd(image.size());
+    std::vector<float> full(image.size());
+
+    for (const BlurWeights& weights : {BlurWeights::Box(0), BlurWeights::Box(2), BlurWeights::Gaussian(6, 3.0f), BlurWeights::Gaussian(MAX_BLUR_RADIUS, 12.0f)})
+    {
+        float sum = weights.weights[0];
+        for (int i = 1; i <= weights.radius; ++i)
+            sum += 2 * weights.weights[i];
+        test.Check(std::abs(sum - 1.0f) < 1e-5f, "blur weights add up to one");
+
+        BlurPass(image, intermediate, width, height, weights, false);
+        BlurPass(intermediate, separable, width, height, weights, true);
+        BlurFull(image, full, width, height, weights);
+        test.Check(MaxDifference(separable, full) < 1e-5f, "the separable blur matches the full kernel");
+
+        BlurPassSimd(image, intermediate, width, height, weights, false);
+        BlurPassSimd(intermediate, simd, width, height, weights, true);
+        test.Check(MaxDifference(simd, separable) < 1e-6f, "the SIMD blur matches the scalar one");
+    }
+    BlurPass(image, separable, width, height, BlurWeights::Box(0), false);
+    test.Check(separable == image, "a zero radius blur copies the image");
+
+    // Without depth differences the bilateral blur is the plain gaussian
+    BlurWeights gaussian;
+    gaussian.radius = BILATERAL_HALF_SAMPLES;
+    float bilateralSum = BILATERAL_WEIGHTS[0];
+    for (int i = 1; i <= BILATERAL_HALF_SAMPLES; ++i)
+        bilateralSum += 2 * BILATERAL_WEIGHTS[i];
+    for (int i = 0; i <= BILATERAL_HALF_SAMPLES; ++i)
+        gaussian.weights[i] = BILATERAL_WEIGHTS[i] / bilateralSum;
+    const std::vector<float> flatDepths(pixelCount, 0.5f);
+    for (const bool isVertical : {false, true})
+    {
+        BilateralBlurPass(image, flatDepths, separable, width, height, isVertical);
+        BlurPass(image, full, width, height, gaussian, isVertical);
+        test.Check(MaxDifference(separable, full) < 1e-5f, "a flat bilateral blur is gaussian");
+    }
+
+    // Nothing bleeds across a depth edge
+    std::vector<float> edgeDepths(pixelCount);
+    std::vector<float> edgeImage(image.size());
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        const bool isRight = static_cast<int>(i % width) >= width / 2;
+        edgeDepths[i] = isRight ? 1.0f : 0.0f;
+        std::fill_n(edgeImage.begin() + static_cast<ptrdiff_t>(i) * 4, 4, isRight ? 1.0f : 0.0f);
+    }
+    BilateralBlurPass(edgeImage, edgeDepths, separable, width, height, false);
+    test.Check(MaxDifference(separable, edgeImage) < 1e-6f, "the bilateral blur keeps depth edges");
+
+    const std::vector<float> depths = RandomValues(generator, pixelCount, 0.0f, 0.01f);
+    for (const bool isVertical : {false, true})
+    {
+        BilateralBlurPass(image, depths, separable, width, height, isVertical);
+        BilateralBlurPassSimd(image, depths, simd, width, height, isVertical);
+        test.Check(MaxDifference(simd, separable) < 1e-6f, "the SIMD bilateral blur matches the scalar one");
+    }
+
+    SsaoScene scene{generator, width, height};
+    std::vector<float> direct(pixelCount);
+    std::vector<float> tiled(pixelCount);
+    for (const float radius : {0.5f, 2.0f})
+    {
+        scene.inputs.radius = radius;
+        SsaoOcclusion(scene.inputs, direct, false);
+        SsaoOcclusion(scene.inputs, tiled, true);
+        test.Check(direct == tiled, "the SSAO tile cache doesn't change the occlusion");
+        test.Check(std::ranges::all_of(direct, [](const float value) { return value >= 0 && value <= 1; }), "the ambient occlusion is between zero and one");
+    }
+}
+
+// Times the CPU references on a half resolution 1080p image
+void BenchmarkPostProcessKernels(TestContext& test)
+{
+    constexpr int WIDTH = 960;
+    constexpr int HEIGHT = 540;
+    constexpr int BLUR_RADIUS = 8;
+
+    std::mt19937 generator{47};
+    constexpr size_t pixelCount = static_cast<size_t>(WIDTH) * HEIGHT;
+    const std::vector<float> image = RandomValues(generator, pixelCount * 4, 0.0f, 1.0f);
+    const std::vector<float> depths = RandomValues(generator, pixelCount, 0.0f, 0.01f);
+    std::vector<float> intermediate(image.size());
+    std::vector<float> output(image.size());
+    const BlurWeights weights = BlurWeights::Gaussian(BLUR_RADIUS, static_cast<float>(BLUR_RADIUS) / 2);
+
+    const auto time = [](const auto& function)
+    {
+        const auto start = TestClock::now();
+        function();
+        return ElapsedMs(start);
+    };
+
+    const float blurFullMs = time([&] { BlurFull(image, output, WIDTH, HEIGHT, weights); });
+    const float blurSeparableMs = time([&]
+    {
+        BlurPass(image, intermediate, WIDTH, HEIGHT, weights, false);
+        BlurPass(intermediate, output, WIDTH, HEIGHT, weights, true);
+    });
+    const float blurSeparableSimdMs = time([&]
+    {
+        BlurPassSimd(image, intermediate, WIDTH, HEIGHT, weights, false);
+        BlurPassSimd(intermediate, output, WIDTH, HEIGHT, weights, true);
+    });
+    const float bilateralMs = time([&]
+    {
+        BilateralBlurPass(image, depths, intermediate, WIDTH, HEIGHT, false);
+        BilateralBlurPass(intermediate, depths, output, WIDTH, HEIGHT, true);
+    });
+    const float bilateralSimdMs = time([&]
+    {
+        BilateralBlurPassSimd(image, depths, intermediate, WIDTH, HEIGHT, false);
+        BilateralBlurPassSimd(intermediate, depths, output, WIDTH, HEIGHT, true);
+    });
+
+    const SsaoScene scene{generator, WIDTH, HEIGHT};
+    const float ssaoMs = time([&] { SsaoOcclusion(scene.inputs, output, false); });
+    const float ssaoTiledMs = time([&] { SsaoOcclusion(scene.inputs, output, true); });
+
+    test.Check(std::ranges::all_of(output, [](const float value) { return value >= 0 && value <= 1; }), "the ambient occlusion is between zero and one");
+    test.Report("Post process kernels at {}x{}: blur radius {} full {:.1f} ms, separable {:.1f} ms, SIMD {:.1f} ms, bilateral {:.1f} ms, SIMD {:.1f} ms, SSAO {:.1f} ms, tiled {:.1f} ms",
+        WIDTH, HEIGHT, BLUR_RADIUS, blurFullMs, blurSeparableMs, blurSeparableSimdMs, bilateralMs, bilateralSimdMs, ssaoMs, ssaoTiledMs);
+}
+
+}
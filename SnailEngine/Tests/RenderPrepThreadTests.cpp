@@ -0,0 +1,69 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <array>
+#include <atomic>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "Rendering/FrameView.h"
+#include "Rendering/RenderPrepThread.h"
+
+namespace Snail
+{
+
+// Checks the hand off with a preparation that only records the frames, no device needed
+void TestRenderPrepThread(TestContext& test)
+{
+    constexpr uint64_t FRAME_COUNT = 200;
+
+    // Written by the preparation only, read after waiting for it
+    std::vector<uint64_t> preparedFrames;
+    std::atomic<int> concurrentPreparations = 0;
+    bool overlapped = false;
+    FrameArena arena;
+    std::array<FrameView, 2> views{FrameView{arena}, FrameView{arena}};
+
+    {
+        RenderPrepThread prepThread{[&](const FrameView& view)
+        {
+            overlapped |= ++concurrentPreparations > 1;
+            preparedFrames.push_back(view.frameIndex);
+            std::this_thread::yield();
+            --concurrentPreparations;
+        }};
+
+        test.Check(!prepThread.Wait().has_value(), "a frame is prepared before any was submitted");
+
+        // Pipelined like the renderer: the previous frame is waited for while the next one is submitted
+        for (uint64_t frame = 1; frame <= FRAME_COUNT; ++frame)
+        {
+            FrameView& view = views[frame % views.size()];
+            view.frameIndex = frame;
+
+            const std::optional<uint64_t> previous = prepThread.Wait();
+            test.Check(frame == 1 || previous == frame - 1, "the previous frame isn't the one prepared");
+            prepThread.Submit(view);
+        }
+
+        test.Check(prepThread.Wait() == FRAME_COUNT, "the last frame isn't prepared after waiting");
+
+        // Submitted and never waited for, the destructor prepares it before stopping
+        views[0].frameIndex = FRAME_COUNT + 1;
+        prepThread.Submit(views[0]);
+    }
+
+    test.Check(!overlapped, "two frames were prepared at the same time");
+    test.Check(preparedFrames.size() == FRAME_COUNT + 1, "frames were skipped or prepared twice");
+    for (size_t i = 0; i < preparedFrames.size(); ++i)
+    {
+        if (preparedFrames[i] != i + 1)
+        {
+            test.Check(false, "frames were prepared out of order");
+            break;
+        }
+    }
+}
+
+}
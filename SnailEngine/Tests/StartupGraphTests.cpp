@@ -0,0 +1,86 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+#include "Core/StartupGraph.h"
+#include "Core/ThreadPool.h"
+
+namespace Snail
+{
+
+// Runs a graph of sleeping tasks, checks the order, the affinities and that independent tasks overlap
+void TestStartupGraph(TestContext& test)
+{
+    constexpr std::chrono::milliseconds SLOW_TASK{40};
+    constexpr std::chrono::milliseconds FAST_TASK{5};
+
+    ThreadPool pool;
+
+    const std::thread::id mainThread = std::this_thread::get_id();
+    std::mutex mutex;
+    std::unordered_set<std::string> finished;
+    bool orderRespected = true;
+    bool affinityRespected = true;
+
+    StartupGraph graph;
+    size_t taskCount = 0;
+    const auto addTask = [&](const std::string& name, const StartupGraph::Affinity affinity, const std::vector<std::string>& dependencies, const std::chrono::milliseconds duration)
+    {
+        ++taskCount;
+        graph.Add(name, affinity, dependencies, [&, name, affinity, dependencies, duration]
+        {
+            {
+                std::lock_guard lock{mutex};
+                orderRespected &= std::ranges::all_of(dependencies, [&](const std::string& dependency) { return finished.contains(dependency); });
+                affinityRespected &= (std::this_thread::get_id() == mainThread) == (affinity == StartupGraph::Affinity::MAIN_THREAD);
+            }
+            std::this_thread::sleep_for(duration);
+            std::lock_guard lock{mutex};
+            finished.insert(name);
+        });
+    };
+
+    // Shaped like the engine: independent slow modules, main thread work in between, and a join at the end
+    addTask("Physics", StartupGraph::Affinity::ANY_THREAD, {}, SLOW_TASK);
+    addTask("Audio", StartupGraph::Affinity::MAIN_THREAD, {}, SLOW_TASK);
+    addTask("Textures", StartupGraph::Affinity::ANY_THREAD, {}, SLOW_TASK);
+    addTask("Meshes", StartupGraph::Affinity::ANY_THREAD, {"Textures"}, FAST_TASK);
+    addTask("Loading screen", StartupGraph::Affinity::MAIN_THREAD, {"Textures"}, FAST_TASK);
+    addTask("Game", StartupGraph::Affinity::ANY_THREAD, {"Audio", "Textures"}, SLOW_TASK);
+    addTask("Scene", StartupGraph::Affinity::MAIN_THREAD, {"Physics", "Meshes", "Game"}, FAST_TASK);
+
+    size_t idleCount = 0;
+    const StartupGraph::Results results = graph.Run(pool, [&idleCount] { ++idleCount; });
+
+    test.Check(finished.size() == taskCount && results.timings.size() == taskCount, "not every task ran once");
+    test.Check(orderRespected, "a task started before one of its dependencies finished");
+    test.Check(affinityRespected, "a task ran on the wrong thread");
+    test.Check(results.timings.back().name == "Scene", "the last task isn't the one depending on the others");
+    test.Check(results.totalMs < results.serialMs * 0.8f, "independent tasks didn't overlap");
+    test.Check(idleCount > 0, "the main thread wasn't idle while the workers ran");
+
+    // A failing task stops the tasks depending on it and its exception reaches the caller
+    StartupGraph failingGraph;
+    bool dependentRan = false;
+    failingGraph.Add("Failing", StartupGraph::Affinity::ANY_THREAD, {}, [] { throw std::runtime_error{"expected by the test"}; });
+    failingGraph.Add("Dependent", StartupGraph::Affinity::MAIN_THREAD, {"Failing"}, [&dependentRan] { dependentRan = true; });
+    bool threw = false;
+    try
+    {
+        failingGraph.Run(pool);
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    test.Check(threw, "the exception of a task wasn't rethrown");
+    test.Check(!dependentRan, "a task ran after its dependency failed");
+}
+
+}
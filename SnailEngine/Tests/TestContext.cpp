@@ -0,0 +1,29 @@
+#include "stdafx.h"
+#include "TestContext.h"
+
+namespace Snail
+{
+
+TestContext::TestContext(std::string testName)
+    : name{std::move(testName)}
+{}
+
+void TestContext::Print(const std::string_view message) const
+{
+    std::printf("[%s] %.*s\n", name.c_str(), static_cast<int>(message.size()), message.data());
+    LOGF("[{}] {}", name, message);
+}
+
+bool TestContext::Check(const bool condition, const std::string_view description)
+{
+    ++checkCount;
+    if (!condition)
+    {
+        ++failureCount;
+        std::printf("[%s] FAILED: %.*s\n", name.c_str(), static_cast<int>(description.size()), description.data());
+        LOGF(Logger::ERROR, "[{}] Failed: {}", name, description);
+    }
+    return condition;
+}
+
+}
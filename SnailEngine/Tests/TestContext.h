@@ -0,0 +1,50 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <format>
+#include <string>
+#include <string_view>
+
+namespace Snail
+{
+
+using TestClock = std::chrono::high_resolution_clock;
+
+// Milliseconds elapsed since a point of the test clock
+inline float ElapsedMs(const TestClock::time_point start) noexcept
+{
+    return std::chrono::duration<float, std::milli>(TestClock::now() - start).count();
+}
+
+// Handed to every test and benchmark. Failed checks fail the run, reports are the measures of the benchmarks.
+// Both go to the console and to the log.
+class TestContext
+{
+    std::string name;
+    size_t checkCount = 0;
+    size_t failureCount = 0;
+
+    void Print(std::string_view message) const;
+
+public:
+    explicit TestContext(std::string testName);
+
+    // Logs the description when the condition doesn't hold, returns the condition
+    bool Check(bool condition, std::string_view description);
+    // Logs the description without failing
+    template <class... T>
+    void Report(std::format_string<T...> format, T&&... args);
+
+    [[nodiscard]] const std::string& GetName() const noexcept { return name; }
+    [[nodiscard]] size_t GetCheckCount() const noexcept { return checkCount; }
+    [[nodiscard]] size_t GetFailureCount() const noexcept { return failureCount; }
+    [[nodiscard]] bool HasPassed() const noexcept { return failureCount == 0; }
+};
+
+template <class... T>
+void TestContext::Report(std::format_string<T...> format, T&&... args)
+{
+    Print(std::format(format, std::forward<T>(args)...));
+}
+
+}
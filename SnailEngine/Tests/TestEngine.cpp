@@ -0,0 +1,72 @@
+#include "stdafx.h"
+#include "TestEngine.h"
+
+#include <exception>
+
+#include "TestContext.h"
+#include "Core/WindowsEngine.h"
+
+namespace Snail
+{
+
+namespace
+{
+
+bool isTestEngineInitialized = false;
+
+// Runs frames while a scene is loading, returns false if it still is after maxFrames
+bool WaitWhileLoading(WindowsEngine& engine, int& framesLeft)
+{
+    while (engine.GetScene()->IsLoading())
+    {
+        if (framesLeft-- <= 0)
+            return false;
+        engine.RunFrame();
+    }
+    return true;
+}
+
+}
+
+bool InitTestEngine()
+{
+    if (isTestEngineInitialized)
+        return true;
+
+    WindowsEngine& engine = WindowsEngine::GetInstance();
+    try
+    {
+        WindowsEngine::SetWindowsAppInstance(GetModuleHandle(nullptr));
+        engine.SetHeadless(true);
+        engine.Init();
+    }
+    catch (const std::exception& e)
+    {
+        LOGF(Logger::ERROR, "Test engine initialisation failed: {}", e.what());
+        return false;
+    }
+
+    isTestEngineInitialized = true;
+    return true;
+}
+
+WindowsEngine* GetTestEngine(TestContext& test)
+{
+    if (!test.Check(isTestEngineInitialized, "the engine wasn't initialised"))
+        return nullptr;
+    return &WindowsEngine::GetInstance();
+}
+
+bool LoadTestScene(TestContext& test, WindowsEngine& engine, const std::string& filename, int maxFrames)
+{
+    // The main menu starts loading with the engine, a scene can't be loaded over another
+    if (!test.Check(WaitWhileLoading(engine, maxFrames), "the previous scene didn't finish loading"))
+        return false;
+
+    // Picked up by the next frame
+    engine.GetScene()->LoadScene(filename);
+    engine.RunFrame();
+    return test.Check(WaitWhileLoading(engine, maxFrames), std::format("{} didn't finish loading", filename));
+}
+
+}
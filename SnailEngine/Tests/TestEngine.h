@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+
+namespace Snail
+{
+class TestContext;
+class WindowsEngine;
+
+// Level the engine tests and benchmarks run in, the game's
+inline constexpr const char* TEST_LEVEL_PATH = "Resources/Scenes/DefaultScene.json";
+// Scene the engine starts in
+inline constexpr const char* TEST_MENU_PATH = "Resources/Scenes/MainMenu.json";
+
+// The whole engine on a hidden window, for the tests that need the device, the asset managers or a scene. Like the
+// game, it must run from the directory holding the Resources.
+// It is initialised once before any other entry, its physics module then owns the PhysX foundation of the process.
+
+// Returns false when the engine couldn't be initialised, e.g. without a D3D11 device
+bool InitTestEngine();
+// Fails the test and returns null when InitTestEngine failed or wasn't called
+WindowsEngine* GetTestEngine(TestContext& test);
+// Starts loading the scene and runs frames until it is loaded, fails the test after maxFrames
+bool LoadTestScene(TestContext& test, WindowsEngine& engine, const std::string& filename, int maxFrames = 10000);
+
+}
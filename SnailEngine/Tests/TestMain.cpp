@@ -0,0 +1,132 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <string_view>
+#include <vector>
+
+#include "TestEngine.h"
+#include "Core/WindowsEngine.h"
+
+using namespace Snail;
+
+namespace
+{
+
+struct TestEntry
+{
+    const char* name;
+    void (*function)(TestContext&);
+    bool isBenchmark;
+    bool needsEngine = false;
+};
+
+constexpr TestEntry TESTS[] = {
+    {"AssetHotReload", TestAssetHotReload, false},
+    {"EntityUpdate", TestEntityUpdate, false},
+    {"FrameAllocations", TestFrameAllocations, false, true},
+    {"FramePacer", TestFramePacer, false},
+    {"FrameView", TestFrameView, false},
+    {"GBufferPacking", TestGBufferPacking, false},
+    {"GrassRegionCulling", TestGrassRegionCulling, false},
+    {"InputSampler", TestInputSampler, false},
+    {"LightManager", TestLightManager, false},
+    {"MeshOptimizer", TestMeshOptimizer, false},
+    {"MeshSimplifier", TestMeshSimplifier, false},
+    {"OcclusionBuffer", TestOcclusionBuffer, false},
+    {"ParticleBuffer", TestParticleBuffer, false},
+    {"PhysicsEventQueue", TestPhysicsEventQueue, false},
+    {"PostProcessKernels", TestPostProcessKernels, false},
+    {"RenderPrepThread", TestRenderPrepThread, false},
+    {"StartupGraph", TestStartupGraph, false},
+    {"TextureStreamingScheduler", TestTextureStreamingScheduler, false},
+    {"TransformHierarchy", TestTransformHierarchy, false},
+    {"VertexCompression", TestVertexCompression, false},
+
+    {"AssetResidencyBenchmark", BenchmarkAssetResidency, true, true},
+    {"CollisionLayersBenchmark", BenchmarkCollisionLayers, true},
+    {"ControllerPollingBenchmark", BenchmarkControllerPolling, true},
+    {"EngineStartupBenchmark", BenchmarkEngineStartup, true, true},
+    {"EntityUpdateBenchmark", BenchmarkEntityUpdate, true},
+    {"LevelArchiveBenchmark", BenchmarkLevelArchive, true},
+    {"LightManagerBenchmark", BenchmarkLightManager, true},
+    {"MaterialBindingBenchmark", BenchmarkMaterialBinding, true, true},
+    {"OcclusionCullingBenchmark", BenchmarkOcclusionCulling, true},
+    {"ParticleBufferBenchmark", BenchmarkParticleBuffer, true},
+    {"PhysicsEventQueueBenchmark", BenchmarkPhysicsEventQueue, true},
+    {"PhysicsQueryBatchBenchmark", BenchmarkPhysicsQueryBatch, true},
+    {"PostProcessKernelsBenchmark", BenchmarkPostProcessKernels, true},
+    {"TransformHierarchyBenchmark", BenchmarkTransformHierarchy, true},
+    {"VehicleManagerBenchmark", BenchmarkVehicleManager, true},
+};
+
+}
+
+// SnailEngineTests [--benchmarks] [name...]
+// Runs the tests, and the benchmarks with --benchmarks. Names restrict the run to the entries containing one of them.
+// Returns the number of failed entries.
+int main(const int argc, char* argv[])
+{
+    logger.SetLogFile("SnailEngineTests.log");
+
+    bool runBenchmarks = false;
+    std::vector<std::string_view> filters;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view argument = argv[i];
+        if (argument == "--benchmarks")
+            runBenchmarks = true;
+        else
+            filters.push_back(argument);
+    }
+
+    const auto isSelected = [&](const TestEntry& entry)
+    {
+        if (filters.empty())
+            return !entry.isBenchmark || runBenchmarks;
+        for (const std::string_view filter : filters)
+        {
+            if (std::string_view{entry.name}.find(filter) != std::string_view::npos)
+                return true;
+        }
+        return false;
+    };
+
+    // The systems under test reach the frame arena, the job system and the transform hierarchy through the engine
+    WindowsEngine::GetInstance().InitCoreModules();
+
+    // Before any other entry, the engine's physics module must create the PhysX foundation that TestPhysics borrows
+    if (std::ranges::any_of(TESTS, [&](const TestEntry& entry) { return entry.needsEngine && isSelected(entry); }) && !InitTestEngine())
+        std::printf("The engine couldn't be initialised, its entries will fail\n");
+
+    int ranCount = 0;
+    int failedCount = 0;
+    for (const TestEntry& entry : TESTS)
+    {
+        if (!isSelected(entry))
+            continue;
+
+        TestContext test{entry.name};
+        try
+        {
+            const auto start = TestClock::now();
+            entry.function(test);
+            test.Report("{} checks in {:.1f} ms", test.GetCheckCount(), ElapsedMs(start));
+        }
+        catch (const std::exception& e)
+        {
+            test.Check(false, std::format("threw {}", e.what()));
+        }
+
+        ++ranCount;
+        if (!test.HasPassed())
+            ++failedCount;
+        std::printf("[%s] %s\n", entry.name, test.HasPassed() ? "passed" : "FAILED");
+    }
+
+    std::printf("%d run, %d failed\n", ranCount, failedCount);
+    LOGF("Tests: {} run, {} failed", ranCount, failedCount);
+    return failedCount;
+}
@@ -0,0 +1,43 @@
+#include "stdafx.h"
+#include "TestPhysics.h"
+
+#include "Core/WindowsEngine.h"
+
+using namespace physx;
+
+namespace Snail
+{
+
+TestPhysics::TestPhysics()
+{
+    // PhysX allows a single foundation per process, the physics module of the test engine may own it
+    if (PxIsFoundationValid())
+    {
+        const PhysicsModule& physicsModule = WindowsEngine::GetModule<PhysicsModule>();
+        physicsInUse = physicsModule.physics.get();
+        dispatcherInUse = physicsModule.dispatcher.get();
+        return;
+    }
+
+    foundation.reset(PxCreateFoundation(PX_PHYSICS_VERSION, allocator, errorCallback));
+    dispatcher.reset(PxDefaultCpuDispatcherCreate(2));
+    physics.reset(PxCreatePhysics(PX_PHYSICS_VERSION, *foundation, PxTolerancesScale(), true));
+    vehicle2::PxInitVehicleExtension(*foundation);
+
+    physicsInUse = physics.get();
+    dispatcherInUse = dispatcher.get();
+}
+
+TestPhysics::~TestPhysics()
+{
+    if (foundation)
+        vehicle2::PxCloseVehicleExtension();
+}
+
+TestPhysics& TestPhysics::Get()
+{
+    static TestPhysics instance;
+    return instance;
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <PxPhysicsAPI.h>
+
+#include "Core/Physics/PhysXAllocator.h"
+
+namespace Snail
+{
+
+// PhysX for the tests, without the scene of the physics module: the foundation, the physics, a CPU dispatcher and
+// the vehicle extension. The tests create the scenes they need.
+// When the test engine was initialised, its physics module owns them and they are borrowed from it.
+class TestPhysics
+{
+    PhysXAllocatorCallback allocator;
+    physx::PxDefaultErrorCallback errorCallback;
+
+    PhysXUniquePtr<physx::PxFoundation> foundation;
+    PhysXUniquePtr<physx::PxDefaultCpuDispatcher> dispatcher;
+    PhysXUniquePtr<physx::PxPhysics> physics;
+
+    physx::PxPhysics* physicsInUse = nullptr;
+    physx::PxCpuDispatcher* dispatcherInUse = nullptr;
+
+    TestPhysics();
+
+public:
+    TestPhysics(const TestPhysics&) = delete;
+    TestPhysics& operator=(const TestPhysics&) = delete;
+    ~TestPhysics();
+
+    // Created on first use and shared by the tests, PhysX allows a single foundation per process
+    static TestPhysics& Get();
+
+    physx::PxPhysics& GetPhysics() const noexcept { return *physicsInUse; }
+    physx::PxCpuDispatcher& GetDispatcher() const noexcept { return *dispatcherInUse; }
+};
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "TestContext.h"
+
+namespace Snail
+{
+
+// Tests check the behaviour of a system against a reference, without a window nor a device.
+// Benchmarks time it on synthetic data, they only check that what they measured makes sense.
+// The engine entries run in the whole engine initialised on a hidden window, see TestEngine.h.
+
+void TestAssetHotReload(TestContext& test);
+void TestEntityUpdate(TestContext& test);
+void TestFrameAllocations(TestContext& test);
+void TestFramePacer(TestContext& test);
+void TestFrameView(TestContext& test);
+void TestGBufferPacking(TestContext& test);
+void TestGrassRegionCulling(TestContext& test);
+void TestInputSampler(TestContext& test);
+void TestLightManager(TestContext& test);
+void TestMeshOptimizer(TestContext& test);
+void TestMeshSimplifier(TestContext& test);
+void TestOcclusionBuffer(TestContext& test);
+void TestParticleBuffer(TestContext& test);
+void TestPhysicsEventQueue(TestContext& test);
+void TestPostProcessKernels(TestContext& test);
+void TestRenderPrepThread(TestContext& test);
+void TestStartupGraph(TestContext& test);
+void TestTextureStreamingScheduler(TestContext& test);
+void TestTransformHierarchy(TestContext& test);
+void TestVertexCompression(TestContext& test);
+
+void BenchmarkAssetResidency(TestContext& test);
+void BenchmarkCollisionLayers(TestContext& test);
+void BenchmarkControllerPolling(TestContext& test);
+void BenchmarkEngineStartup(TestContext& test);
+void BenchmarkEntityUpdate(TestContext& test);
+void BenchmarkLevelArchive(TestContext& test);
+void BenchmarkLightManager(TestContext& test);
+void BenchmarkMaterialBinding(TestContext& test);
+void BenchmarkOcclusionCulling(TestContext& test);
+void BenchmarkParticleBuffer(TestContext& test);
+void BenchmarkPhysicsEventQueue(TestContext& test);
+void BenchmarkPhysicsQueryBatch(TestContext& test);
+void BenchmarkPostProcessKernels(TestContext& test);
+void BenchmarkTransformHierarchy(TestContext& test);
+void BenchmarkVehicleManager(TestContext& test);
+
+}
@@ -0,0 +1,78 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <limits>
+
+#include "Core/Assets/TextureStreamingScheduler.h"
+
+namespace Snail
+{
+
+// Schedules textures near, far and unseen under upload budgets and memory caps, and checks the resident mips
+void TestTextureStreamingScheduler(TestContext& test)
+{
+    using TextureState = TextureStreamingScheduler::TextureState;
+    using Result = TextureStreamingScheduler::Result;
+
+    constexpr uint32_t SIZE = 1024;
+    const uint32_t mipCount = TextureStreamingScheduler::GetMipCount(SIZE, SIZE);
+    const uint32_t tailMipCount = TextureStreamingScheduler::GetTailMipCount(SIZE, SIZE);
+    const auto makeTexture = [&](const float resolution, const uint32_t residentMipCount, const bool isDecoded = true)
+    {
+        return TextureState{SIZE, SIZE, mipCount, residentMipCount, resolution, isDecoded};
+    };
+
+    TextureStreamingScheduler scheduler;
+    scheduler.uploadBudget = std::numeric_limits<size_t>::max();
+    scheduler.memoryCap = std::numeric_limits<size_t>::max();
+    Result result;
+
+    // Near, far and unseen textures with no limits: near gets every mip, far and unseen only need their tail
+    {
+        const TextureState textures[] = {makeTexture(1024, 0), makeTexture(64, 0), makeTexture(0, 0)};
+        scheduler.Schedule(textures, result);
+        test.Check(mipCount == 11 && tailMipCount == 7, "mip counts of a 1024 texture");
+        test.Check(result.residentMipCounts[0] == mipCount, "near texture is fully streamed in");
+        test.Check(result.residentMipCounts[1] == tailMipCount, "far texture only needs its tail");
+        test.Check(result.residentMipCounts[2] == tailMipCount, "unseen texture only keeps its tail");
+        test.Check(result.isSettled, "nothing left to stream");
+    }
+
+    // Upload budget: only the most undersampled texture gets its next mip
+    {
+        const TextureState textures[] = {makeTexture(64, tailMipCount), makeTexture(1024, tailMipCount), makeTexture(256, tailMipCount)};
+        scheduler.uploadBudget = TextureStreamingScheduler::GetMipBytes(textures[1], mipCount - tailMipCount - 1);
+        scheduler.Schedule(textures, result);
+        test.Check(result.residentMipCounts[1] == tailMipCount + 1, "most undersampled texture goes first");
+        test.Check(result.residentMipCounts[0] == tailMipCount && result.residentMipCounts[2] == tailMipCount, "other textures wait for the next frame");
+        test.Check(result.uploadBytes <= scheduler.uploadBudget, "upload budget is respected");
+        test.Check(!result.isSettled, "more mips are pending");
+        scheduler.uploadBudget = std::numeric_limits<size_t>::max();
+    }
+
+    // Memory cap: the far texture gives its top mips back to the near one, tails are never dropped
+    {
+        const TextureState textures[] = {makeTexture(1024, mipCount), makeTexture(32, mipCount), makeTexture(0, mipCount)};
+        scheduler.memoryCap = TextureStreamingScheduler::GetResidentBytes(textures[0], mipCount) + 2 * TextureStreamingScheduler::GetResidentBytes(textures[1], tailMipCount);
+        scheduler.Schedule(textures, result);
+        test.Check(result.residentMipCounts[0] == mipCount, "near texture keeps all of its mips");
+        test.Check(result.residentMipCounts[1] == tailMipCount && result.residentMipCounts[2] == tailMipCount, "distant textures drop to their tail");
+        test.Check(result.residentBytes <= scheduler.memoryCap, "memory cap is respected");
+
+        scheduler.memoryCap = 1;
+        scheduler.Schedule(textures, result);
+        test.Check(result.residentMipCounts[0] == tailMipCount && result.residentMipCounts[1] == tailMipCount, "tails stay resident above the cap");
+        scheduler.memoryCap = std::numeric_limits<size_t>::max();
+    }
+
+    // Textures that are not decoded yet are queued by on-screen size
+    {
+        const TextureState textures[] = {makeTexture(0, 0, false), makeTexture(512, 0, false), makeTexture(1024, tailMipCount)};
+        scheduler.Schedule(textures, result);
+        test.Check(result.decodeOrder.size() == 2 && result.decodeOrder[0] == 1 && result.decodeOrder[1] == 0, "decode order follows the requested resolution");
+        test.Check(result.residentMipCounts[0] == 0 && result.residentMipCounts[1] == 0, "nothing is uploaded before decoding");
+        test.Check(!result.isSettled, "decodes are pending");
+    }
+}
+
+}
@@ -0,0 +1,173 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "Core/ThreadPool.h"
+#include "Core/Math/TransformHierarchy.h"
+
+namespace Snail
+{
+
+namespace
+{
+
+using NodeHandle = TransformHierarchy::NodeHandle;
+
+Transform RandomTransform(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> unit{-1.0f, 1.0f};
+    Transform t;
+    t.position = Vector3{unit(rng), unit(rng), unit(rng)} * 2.0f;
+    t.rotation = Quaternion::CreateFromYawPitchRoll(unit(rng), unit(rng), unit(rng));
+    t.scale = Vector3{1.0f + unit(rng) * 0.1f};
+    return t;
+}
+
+// Reference implementation, walks the parents for every node
+struct ReferenceNode
+{
+    NodeHandle handle;
+    int parent;
+    Transform local;
+};
+
+Matrix ReferenceWorld(const std::vector<ReferenceNode>& nodes, int index)
+{
+    Matrix world = nodes[index].local.GetTransformationMatrix();
+    for (index = nodes[index].parent; index != -1; index = nodes[index].parent)
+        world *= nodes[index].local.GetTransformationMatrix();
+    return world;
+}
+
+bool Matches(const Matrix& a, const Matrix& b)
+{
+    for (int r = 0; r < 4; ++r)
+        for (int c = 0; c < 4; ++c)
+            if (std::abs(a.m[r][c] - b.m[r][c]) > 1e-3f * std::max(1.0f, std::abs(b.m[r][c])))
+                return false;
+    return true;
+}
+
+void Validate(TestContext& test, const TransformHierarchy& hierarchy, const std::vector<ReferenceNode>& nodes, const char* label)
+{
+    for (int i = 0; i < static_cast<int>(nodes.size()); ++i)
+    {
+        if (!nodes[i].handle.IsValid())
+            continue;
+
+        if (!Matches(hierarchy.GetWorldMatrix(nodes[i].handle), ReferenceWorld(nodes, i)))
+        {
+            test.Check(false, std::format("world matrix of node {} ({})", i, label));
+            return;
+        }
+    }
+}
+
+void Build(TransformHierarchy& hierarchy, std::vector<ReferenceNode>& nodes, std::mt19937& rng, const int count, const std::function<int(int)>& pickParent)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        const int parent = pickParent(i);
+        const Transform local = RandomTransform(rng);
+        nodes.push_back({hierarchy.CreateNode(local, parent == -1 ? NodeHandle{} : nodes[parent].handle), parent, local});
+    }
+}
+
+}
+
+// Deep chain, wide fan and a forest of small trees, with edits in between updates, against the reference
+void TestTransformHierarchy(TestContext& test)
+{
+    struct Shape
+    {
+        const char* label;
+        int count;
+        std::function<int(int)> pickParent;
+    };
+    const Shape shapes[] = {
+        {"deep", 64, [](const int i) { return i - 1; }},
+        {"wide", 2048, [](const int i) { return i == 0 ? -1 : 0; }},
+        {"forest", 2048, [](const int i) { return i % 8 == 0 ? -1 : i - 1; }},
+    };
+
+    std::mt19937 rng{42};
+    for (const auto& [label, count, pickParent] : shapes)
+    {
+        TransformHierarchy hierarchy;
+        std::vector<ReferenceNode> nodes;
+        Build(hierarchy, nodes, rng, count, pickParent);
+
+        // Dirty reads before the first update must already be correct
+        Validate(test, hierarchy, nodes, label);
+        hierarchy.UpdateWorldMatrices();
+        Validate(test, hierarchy, nodes, label);
+
+        // Edit some locals, then move a subtree under another root
+        for (int i = 0; i < static_cast<int>(nodes.size()); i += 7)
+        {
+            nodes[i].local = RandomTransform(rng);
+            hierarchy.SetLocalTransform(nodes[i].handle, nodes[i].local);
+        }
+        const int moved = static_cast<int>(nodes.size()) - 1;
+        if (nodes[moved].parent != 0)
+        {
+            nodes[moved].parent = 0;
+            hierarchy.SetParent(nodes[moved].handle, nodes[0].handle);
+        }
+        hierarchy.UpdateWorldMatrices();
+        Validate(test, hierarchy, nodes, label);
+
+        // Destroying a node turns its children into roots
+        hierarchy.DestroyNode(std::exchange(nodes[1].handle, {}));
+        for (ReferenceNode& node : nodes)
+        {
+            if (node.parent == 1)
+                node.parent = -1;
+        }
+        Validate(test, hierarchy, nodes, label);
+        hierarchy.UpdateWorldMatrices();
+        Validate(test, hierarchy, nodes, label);
+    }
+}
+
+// Full, 1% dirty and parallel updates of a large forest
+void BenchmarkTransformHierarchy(TestContext& test)
+{
+    constexpr int NODE_COUNT = 100000;
+
+    std::mt19937 rng{42};
+    TransformHierarchy hierarchy;
+    std::vector<ReferenceNode> nodes;
+    Build(hierarchy, nodes, rng, NODE_COUNT, [](const int i) { return i % 16 == 0 ? -1 : i - 1; });
+    hierarchy.UpdateWorldMatrices();
+
+    for (const ReferenceNode& node : nodes)
+        hierarchy.SetLocalTransform(node.handle, node.local);
+    const auto fullStart = TestClock::now();
+    hierarchy.UpdateWorldMatrices();
+    const float fullUpdateMs = ElapsedMs(fullStart);
+
+    for (size_t i = 0; i < nodes.size(); i += 100)
+        hierarchy.SetLocalTransform(nodes[i].handle, nodes[i].local);
+    const auto partialStart = TestClock::now();
+    hierarchy.UpdateWorldMatrices();
+    const float partialUpdateMs = ElapsedMs(partialStart);
+
+    ThreadPool pool;
+    for (const ReferenceNode& node : nodes)
+        hierarchy.SetLocalTransform(node.handle, node.local);
+    const auto parallelStart = TestClock::now();
+    hierarchy.UpdateWorldMatrices(&pool);
+    const float parallelUpdateMs = ElapsedMs(parallelStart);
+    Validate(test, hierarchy, nodes, "parallel");
+
+    test.Report("Transform hierarchy of {} nodes: full {:.3f} ms, 1% dirty {:.3f} ms, parallel {:.3f} ms",
+        NODE_COUNT, fullUpdateMs, partialUpdateMs, parallelUpdateMs);
+}
+
+}
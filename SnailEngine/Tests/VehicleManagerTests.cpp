@@ -0,0 +1,130 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "TestPhysics.h"
+#include "Core/ThreadPool.h"
+#include "Core/Math/Transform.h"
+#include "Core/Physics/CollisionLayers.h"
+#include "Core/Physics/PhysicsVehicle.h"
+#include "Core/Physics/PhysXAllocator.h"
+#include "Core/Physics/VehicleManager.h"
+#include "Core/Physics/Callbacks/ContactCallback.h"
+
+using namespace physx;
+
+namespace Snail
+{
+
+// Drives fleets of vehicles over a heightfield, stepped on the calling thread and on the job system
+void BenchmarkVehicleManager(TestContext& test)
+{
+    constexpr PxU32 FIELD_SIZE = 256;
+    constexpr float FIELD_SCALE = 2.0f;
+    constexpr float FIELD_HEIGHT = 40.0f;
+    constexpr int STEP_COUNT = 120;
+    constexpr float STEP_DT = 1.0f / 60.0f;
+    constexpr size_t VEHICLES_PER_ROW = 8;
+    constexpr float VEHICLE_SPACING = 15.0f;
+
+    PxPhysics& physics = TestPhysics::Get().GetPhysics();
+    const CollisionLayers layers = CollisionLayers::CreateDefault();
+    ThreadPool pool;
+
+    // Rolling hills, similar to the scene terrains
+    const auto fieldHeight = [](const float row, const float column) { return 0.5f + 0.25f * (std::sin(row * 0.05f) + std::cos(column * 0.07f)); };
+    std::vector<PxHeightFieldSample> samples(FIELD_SIZE * FIELD_SIZE);
+    for (PxU32 row = 0; row < FIELD_SIZE; ++row)
+    {
+        for (PxU32 column = 0; column < FIELD_SIZE; ++column)
+        {
+            const float height = fieldHeight(static_cast<float>(row), static_cast<float>(column));
+            samples[row * FIELD_SIZE + column].height = static_cast<PxI16>(height * std::numeric_limits<PxI16>::max());
+        }
+    }
+
+    PxHeightFieldDesc fieldDesc;
+    fieldDesc.format = PxHeightFieldFormat::eS16_TM;
+    fieldDesc.nbRows = FIELD_SIZE;
+    fieldDesc.nbColumns = FIELD_SIZE;
+    fieldDesc.samples.data = samples.data();
+    fieldDesc.samples.stride = sizeof(PxHeightFieldSample);
+
+    const PhysXUniquePtr<PxHeightField> field{PxCreateHeightField(fieldDesc, physics.getPhysicsInsertionCallback())};
+    const PhysXUniquePtr<PxMaterial> material{physics.createMaterial(0.8f, 0.8f, 0.2f)};
+
+    const auto run = [&](const size_t vehicleCount, ThreadPool* jobPool, const size_t jobCount)
+    {
+        PxSceneDesc sceneDesc(physics.getTolerancesScale());
+        sceneDesc.gravity = PxVec3(0.0f, -9.81f, 0.0f);
+        sceneDesc.cpuDispatcher = &TestPhysics::Get().GetDispatcher();
+        sceneDesc.filterShader = FilterShader;
+        const PhysXUniquePtr<PxScene> scene{physics.createScene(sceneDesc)};
+
+        const PhysXUniquePtr<PxRigidStatic> terrain{physics.createRigidStatic(PxTransform(PxIdentity))};
+        const PxHeightFieldGeometry fieldGeometry(field.get(), PxMeshGeometryFlags(), FIELD_HEIGHT / std::numeric_limits<PxI16>::max(), FIELD_SCALE, FIELD_SCALE);
+        PxShape* terrainShape = physics.createShape(fieldGeometry, *material, true);
+        layers.Apply(*terrainShape, "terrain");
+        terrain->attachShape(*terrainShape);
+        terrainShape->release();
+        scene->addActor(*terrain);
+
+        PxVehiclePhysXMaterialFriction friction;
+        friction.material = material.get();
+        friction.friction = 1.0f;
+
+        VehicleManager manager;
+        manager.Init({&physics, scene.get(), material.get(), &layers, &friction, 1, 1.0f});
+
+        // A grid of vehicles driving straight ahead, the rows furthest from the first one past the reduced rate distance
+        std::vector<std::unique_ptr<PhysicsVehicle>> vehicles;
+        for (size_t i = 0; i < vehicleCount; ++i)
+        {
+            const float x = 100.0f + static_cast<float>(i % VEHICLES_PER_ROW) * VEHICLE_SPACING;
+            const float z = 100.0f + static_cast<float>(i / VEHICLES_PER_ROW) * VEHICLE_SPACING;
+            const float y = FIELD_HEIGHT * fieldHeight(x / FIELD_SCALE, z / FIELD_SCALE) + 2.0f;
+            Transform transform;
+            transform.position = {x, y, z};
+            vehicles.push_back(std::make_unique<PhysicsVehicle>(transform, manager));
+            vehicles.back()->Accelerate(1.0f);
+        }
+        const Vector3 focus = vehicles.front()->GetPosition();
+
+        // Averaged over the steps
+        size_t reducedRateCount = 0;
+        float stepMs = 0;
+        for (int step = 0; step < STEP_COUNT; ++step)
+        {
+            const auto start = TestClock::now();
+            manager.Step(STEP_DT, focus, jobPool, jobCount);
+            stepMs += ElapsedMs(start);
+            reducedRateCount += manager.GetStats().reducedRateCount;
+
+            scene->simulate(STEP_DT);
+            scene->fetchResults(true);
+        }
+        stepMs /= STEP_COUNT;
+        reducedRateCount /= STEP_COUNT;
+
+        test.Check(vehicles.front()->GetPosition() != focus, "the vehicles drive");
+        test.Report("{} vehicles on {} jobs, {} at a reduced rate, {:.3f} ms per step, {:.4f} ms per vehicle",
+            vehicleCount, jobCount, reducedRateCount, stepMs, stepMs / static_cast<float>(vehicleCount));
+
+        // Before the scene and the manager
+        vehicles.clear();
+    };
+
+    const size_t maxJobCount = std::max(std::thread::hardware_concurrency(), 1u);
+    for (const size_t vehicleCount : {size_t{16}, size_t{64}})
+    {
+        run(vehicleCount, nullptr, 1);
+        run(vehicleCount, &pool, maxJobCount);
+    }
+}
+
+}
@@ -0,0 +1,126 @@
+#include "stdafx.h"
+#include "Tests.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Rendering/VertexCompression.h"
+
+namespace Snail
+{
+
+namespace
+{
+
+// Steps of the UNORM16 channels
+constexpr float UNORM16_MAX = 65535.0f;
+
+}
+
+// Round trips random vertices through every format and checks the worst normal, tangent, UV and position errors
+void TestVertexCompression(TestContext& test)
+{
+    // Measured on 16 bits octahedral encodings, with some margin
+    constexpr float MAX_NORMAL_ERROR_DEGREES = 0.005f;
+    constexpr float MAX_TANGENT_ERROR_DEGREES = 0.02f;
+
+    constexpr size_t VERTEX_COUNT = 100000;
+    std::mt19937 rng{11};
+    std::normal_distribution<float> gaussian;
+    std::uniform_real_distribution unitRange{0.0f, 1.0f};
+    std::uniform_real_distribution tiledRange{-8.0f, 8.0f};
+
+    const auto randomDirection = [&]
+    {
+        Vector3 v{gaussian(rng), gaussian(rng), gaussian(rng)};
+        v.Normalize();
+        return v;
+    };
+
+    const Vector3 minBounds{-40, -2, 0};
+    const Vector3 maxBounds{60, 3, 250};
+
+    std::vector<MeshVertex> unitUvVertices(VERTEX_COUNT);
+    std::vector<MeshVertex> tiledUvVertices(VERTEX_COUNT);
+    for (size_t i = 0; i < VERTEX_COUNT; ++i)
+    {
+        MeshVertex& v = unitUvVertices[i];
+        v.position = minBounds + (maxBounds - minBounds) * Vector3{unitRange(rng), unitRange(rng), unitRange(rng)};
+        v.normal = randomDirection();
+        v.tangent = randomDirection().Cross(v.normal);
+        v.tangent.Normalize();
+        v.bitangent = (i % 3 == 0 ? -1.0f : 1.0f) * v.normal.Cross(v.tangent);
+        v.uv = {unitRange(rng), unitRange(rng)};
+
+        tiledUvVertices[i] = v;
+        tiledUvVertices[i].uv = {tiledRange(rng), tiledRange(rng)};
+    }
+
+    test.Check(VertexCompression::HasUnitRangeUvs(unitUvVertices), "unit UVs are detected");
+    test.Check(!VertexCompression::HasUnitRangeUvs(tiledUvVertices), "tiled UVs are detected");
+
+    const auto angleDegrees = [](const Vector3& a, const Vector3& b)
+    {
+        // atan2 keeps its precision for tiny angles where acos of the dot doesn't
+        return DirectX::XMConvertToDegrees(std::atan2(a.Cross(b).Length(), a.Dot(b)));
+    };
+
+    for (const VertexFormat format : {VertexFormat::COMPACT, VertexFormat::COMPACT_QUANTIZED_POSITION})
+    {
+        for (const bool unitRangeUvs : {true, false})
+        {
+            const std::vector<MeshVertex>& vertices = unitRangeUvs ? unitUvVertices : tiledUvVertices;
+            const std::vector<std::byte> encoded = VertexCompression::Encode(vertices, format, unitRangeUvs, minBounds, maxBounds);
+            test.Check(encoded.size() == vertices.size() * VertexCompression::GetStride(format), "encoded size matches the stride");
+
+            float maxNormalError = 0, maxTangentError = 0, maxUvError = 0, maxPositionError = 0;
+            bool handednessKept = true, uvsInBound = true, positionsInBound = true;
+            const Vector3 positionStep = (maxBounds - minBounds) / UNORM16_MAX;
+            for (size_t i = 0; i < vertices.size(); ++i)
+            {
+                const MeshVertex& original = vertices[i];
+                const MeshVertex decoded = VertexCompression::Decode(encoded.data() + i * VertexCompression::GetStride(format), format, unitRangeUvs, minBounds, maxBounds);
+
+                maxNormalError = std::max(maxNormalError, angleDegrees(original.normal, decoded.normal));
+                maxTangentError = std::max(maxTangentError, angleDegrees(original.tangent, decoded.tangent));
+                handednessKept &= VertexCompression::GetHandedness(original) == VertexCompression::GetHandedness(decoded);
+
+                for (const auto [o, d] : {std::pair{original.uv.x, decoded.uv.x}, std::pair{original.uv.y, decoded.uv.y}})
+                {
+                    const float error = std::abs(o - d);
+                    maxUvError = std::max(maxUvError, error);
+                    // Half a step of rounding, halves have 11 bits of mantissa
+                    const float allowed = unitRangeUvs ? 0.5f / UNORM16_MAX : std::abs(o) * 0x1p-11f;
+                    uvsInBound &= error <= allowed + 1e-6f;
+                }
+
+                const Vector3 positionError = original.position - decoded.position;
+                maxPositionError = std::max(maxPositionError, positionError.Length());
+                if (format == VertexFormat::COMPACT_QUANTIZED_POSITION)
+                {
+                    positionsInBound &= std::abs(positionError.x) <= positionStep.x * 0.5f + 1e-4f
+                        && std::abs(positionError.y) <= positionStep.y * 0.5f + 1e-4f
+                        && std::abs(positionError.z) <= positionStep.z * 0.5f + 1e-4f;
+                }
+                else
+                {
+                    positionsInBound &= positionError == Vector3::Zero;
+                }
+            }
+
+            test.Check(maxNormalError <= MAX_NORMAL_ERROR_DEGREES, "normal angular error");
+            test.Check(maxTangentError <= MAX_TANGENT_ERROR_DEGREES, "tangent angular error");
+            test.Check(handednessKept, "tangent handedness");
+            test.Check(uvsInBound, "UV error");
+            test.Check(positionsInBound, "position error");
+
+            test.Report("Vertex compression, {} bytes with {} UVs: normal {:.4f} deg, tangent {:.4f} deg, UV {:.2e}, position {:.2e}",
+                VertexCompression::GetStride(format), unitRangeUvs ? "UNORM" : "half", maxNormalError, maxTangentError, maxUvError, maxPositionError);
+        }
+    }
+}
+
+}